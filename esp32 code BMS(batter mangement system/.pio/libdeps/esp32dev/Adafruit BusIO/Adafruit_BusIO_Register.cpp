@@ -168,6 +168,11 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
 
   // store a copy
   _cached = value;
+  _cacheValid = true;
+  if (_writeBack) {
+    _dirty = true;
+    return true;
+  }
 
   for (int i = 0; i < numbytes; i++) {
     if (_byteorder == LSBFIRST) {
@@ -182,10 +187,13 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
 
 /*!
  *    @brief  Read data from the register location. This does not do any error
- * checking!
+ * checking! In write-back mode this is the cached value once there is one.
  *    @return Returns 0xFFFFFFFF on failure, value otherwise
  */
 uint32_t Adafruit_BusIO_Register::read(void) {
+  if (_writeBack && _cacheValid) {
+    return _cached;
+  }
   if (!read(_buffer, _width)) {
     return -1;
   }
@@ -201,15 +209,61 @@ uint32_t Adafruit_BusIO_Register::read(void) {
     }
   }
 
+  _cached = value;
+  _cacheValid = true;
   return value;
 }
 
 /*!
- *    @brief  Read cached data from last time we wrote to this register
+ *    @brief  Read cached data from last time we wrote or read this register
  *    @return Returns 0xFFFFFFFF on failure, value otherwise
  */
 uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
 
+/*!
+ *    @brief  Turn write-back caching on or off. In write-back mode write()
+ *    and RegisterBits::write() only update the cached value and mark the
+ *    register dirty, read() answers from the cache once it holds a value,
+ *    and flush() sends the result in one write. Configuring several
+ *    bitfields then costs at most one read and one write instead of a
+ *    read-modify-write round trip per field. Only use it for registers the
+ *    device never changes by itself (configuration, thresholds, enables),
+ *    never for status or data registers. Turning it off flushes.
+ *    @param  enable True for write-back, false for write-through (default)
+ */
+void Adafruit_BusIO_Register::setWriteBack(bool enable) {
+  if (!enable) {
+    flush();
+  }
+  _writeBack = enable;
+}
+
+/*!
+ *    @brief  Write the cached value to the device if write-back left it dirty
+ *    @return True if the device is now up to date; on failure the register
+ *    stays dirty so a later flush() retries
+ */
+bool Adafruit_BusIO_Register::flush(void) {
+  if (!_dirty) {
+    return true;
+  }
+  bool writeBack = _writeBack;
+  _writeBack = false;
+  bool ok = write(_cached, _width);
+  _writeBack = writeBack;
+  _dirty = !ok;
+  return ok;
+}
+
+/*!
+ *    @brief  Forget the cached value (e.g. after the device was reset), so
+ *    the next read() goes to the bus. Unflushed write-back changes are lost.
+ */
+void Adafruit_BusIO_Register::invalidate(void) {
+  _cacheValid = false;
+  _dirty = false;
+}
+
 /*!
    @brief Read a number of bytes from a register into a buffer
    @param buffer Buffer to read data into
@@ -334,7 +388,9 @@ uint32_t Adafruit_BusIO_RegisterBits::read(void) {
 }
 
 /*!
- *    @brief  Write 4 bytes of data to the register
+ *    @brief  Write 4 bytes of data to the register. In write-back mode
+ *    (see Adafruit_BusIO_Register::setWriteBack()) only the cache changes
+ *    until the register is flushed.
  *    @param  data The 4 bytes to write
  *    @return True on successful write (only really useful for I2C as SPI is
  * uncheckable)
@@ -71,6 +71,13 @@ public:
   bool write(uint8_t *buffer, uint8_t len);
   bool write(uint32_t value, uint8_t numbytes = 0);
 
+  void setWriteBack(bool enable);
+  bool flush(void);
+  void invalidate(void);
+  /*!   @brief  Whether a write-back value is waiting for flush()
+   *    @return True if the device is behind the cache */
+  bool dirty(void) { return _dirty; }
+
   uint8_t width(void);
 
   void setWidth(uint8_t width);
@@ -95,6 +102,9 @@ private:
   uint8_t _buffer[4]; // we won't support anything larger than uint32 for
                       // non-buffered read
   uint32_t _cached = 0;
+  bool _cacheValid = false; // _cached matches (or will, once flushed) the chip
+  bool _writeBack = false;
+  bool _dirty = false;
 };
 
 /*!
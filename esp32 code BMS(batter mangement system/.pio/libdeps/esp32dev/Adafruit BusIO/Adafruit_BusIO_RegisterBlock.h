@@ -0,0 +1,121 @@
+#ifndef Adafruit_BusIO_RegisterBlock_h
+#define Adafruit_BusIO_RegisterBlock_h
+
+#include <Adafruit_BusIO_Register.h>
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+/*!
+ * @brief One typed field of an Adafruit_BusIO_RegisterBlock: its byte offset
+ * from the start of the block, width and byte order, all fixed at compile
+ * time, e.g.
+ *   typedef Adafruit_BusIO_BlockField<0, 2, LSBFIRST> AccelX;
+ * @tparam OFFSET Byte offset of the field within the block
+ * @tparam WIDTH Width of the field in bytes (1-4)
+ * @tparam BYTEORDER LSBFIRST or MSBFIRST
+ */
+template <uint8_t OFFSET, uint8_t WIDTH = 1, uint8_t BYTEORDER = LSBFIRST>
+struct Adafruit_BusIO_BlockField {
+  static_assert(WIDTH >= 1 && WIDTH <= 4, "field width must be 1-4 bytes");
+  static const uint8_t offset = OFFSET; ///< byte offset within the block
+  static const uint8_t width = WIDTH;   ///< field width in bytes
+
+  /*!
+   *    @brief  Assemble the field from the raw block bytes
+   *    @param  block The bytes read by the block, starting at its first
+   *    register
+   *    @return The unsigned field value
+   */
+  static uint32_t decode(const uint8_t *block) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < WIDTH; i++) {
+      value <<= 8;
+      value |= block[OFFSET + (BYTEORDER == LSBFIRST ? WIDTH - 1 - i : i)];
+    }
+    return value;
+  }
+};
+
+/*!
+ * @brief LEN bytes of adjacent registers, starting at one register address,
+ * read in a single transaction (one write_then_read() on I2C) and split into
+ * Adafruit_BusIO_BlockField values afterwards. The device must advance its
+ * register pointer on its own during a multi-byte read (some need an
+ * auto-increment bit in the address, e.g. 0x80 on ST sensors); ones that
+ * do not, such as the INA219, still need one Adafruit_BusIO_Register per
+ * register.
+ * @tparam LEN Number of bytes in the block (1-255)
+ */
+template <uint8_t LEN> class Adafruit_BusIO_RegisterBlock {
+  static_assert(LEN > 0, "empty register block");
+
+public:
+  /*!
+   *    @brief  Create a block we access over an I2C Device
+   *    @param  i2cdevice The I2CDevice to use for underlying I2C access
+   *    @param  reg_addr The address of the first register in the block
+   *    @param  address_width The width of the register address itself,
+   *    defaults to 1 byte
+   */
+  Adafruit_BusIO_RegisterBlock(Adafruit_I2CDevice *i2cdevice,
+                               uint16_t reg_addr, uint8_t address_width = 1)
+      : _register(i2cdevice, reg_addr, 1, LSBFIRST, address_width) {}
+
+  /*!
+   *    @brief  Create a block we access over an SPI Device
+   *    @param  spidevice The SPIDevice to use for underlying SPI access
+   *    @param  reg_addr The address of the first register in the block
+   *    @param  type The method we use to read/write data to SPI
+   *    @param  address_width The width of the register address itself,
+   *    defaults to 1 byte
+   */
+  Adafruit_BusIO_RegisterBlock(Adafruit_SPIDevice *spidevice, uint16_t reg_addr,
+                               Adafruit_BusIO_SPIRegType type,
+                               uint8_t address_width = 1)
+      : _register(spidevice, reg_addr, type, 1, LSBFIRST, address_width) {}
+
+  /*!
+   *    @brief  Read the whole block from the device in one transaction
+   *    @return True on success; on failure the previous contents are kept
+   *    but may be partly overwritten
+   */
+  bool read(void) { return _register.read(_buffer, LEN); }
+
+  /*!
+   *    @brief  Decode one field from the last read()
+   *    @tparam FIELD An Adafruit_BusIO_BlockField inside this block
+   *    @return The unsigned field value
+   */
+  template <class FIELD> uint32_t get(void) const {
+    static_assert(FIELD::offset + FIELD::width <= LEN,
+                  "field lies outside the register block");
+    return FIELD::decode(_buffer);
+  }
+
+  /*!
+   *    @brief  Decode one two's complement field from the last read()
+   *    @tparam FIELD An Adafruit_BusIO_BlockField inside this block
+   *    @return The sign-extended field value
+   */
+  template <class FIELD> int32_t getSigned(void) const {
+    uint32_t value = get<FIELD>();
+    uint8_t shift = 32 - 8 * FIELD::width;
+    return (int32_t)(value << shift) >> shift;
+  }
+
+  /*!   @brief  The raw bytes of the last read()
+   *    @return Pointer to LEN bytes */
+  const uint8_t *data(void) const { return _buffer; }
+
+  /*!   @brief  Size of the block
+   *    @return LEN */
+  uint8_t length(void) const { return LEN; }
+
+private:
+  Adafruit_BusIO_Register _register;
+  uint8_t _buffer[LEN] = {};
+};
+
+#endif // SPI exists
+#endif // Adafruit_BusIO_RegisterBlock_h
@@ -2,6 +2,63 @@
 
 // #define DEBUG_SERIAL Serial
 
+#if defined(ESP32)
+// One recursive mutex per TwoWire, shared by every device on that bus.
+// FreeRTOS hands a released mutex to the highest priority waiter and lends
+// the holder that priority meanwhile, so a sampler task gets the bus ahead of
+// a lower priority display task at the next transaction boundary.
+#define BUSIO_I2C_MAX_BUSES 4
+
+static struct {
+  TwoWire *wire;
+  SemaphoreHandle_t lock;
+} busio_i2c_buses[BUSIO_I2C_MAX_BUSES];
+static portMUX_TYPE busio_i2c_buses_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static SemaphoreHandle_t busio_i2c_bus_lock(TwoWire *wire) {
+  SemaphoreHandle_t found = nullptr;
+  portENTER_CRITICAL(&busio_i2c_buses_mux);
+  for (uint8_t i = 0; i < BUSIO_I2C_MAX_BUSES && !found; i++) {
+    if (busio_i2c_buses[i].wire == wire) {
+      found = busio_i2c_buses[i].lock;
+    }
+  }
+  portEXIT_CRITICAL(&busio_i2c_buses_mux);
+  if (found) {
+    return found;
+  }
+
+  // Allocate outside the critical section; if another task registered the
+  // bus meanwhile, keep theirs
+  SemaphoreHandle_t lock = xSemaphoreCreateRecursiveMutex();
+  if (!lock) {
+    return nullptr;
+  }
+  portENTER_CRITICAL(&busio_i2c_buses_mux);
+  for (uint8_t i = 0; i < BUSIO_I2C_MAX_BUSES && !found; i++) {
+    if (busio_i2c_buses[i].wire == wire) {
+      found = busio_i2c_buses[i].lock;
+    }
+  }
+  for (uint8_t i = 0; i < BUSIO_I2C_MAX_BUSES && !found; i++) {
+    if (!busio_i2c_buses[i].wire) {
+      busio_i2c_buses[i].wire = wire;
+      busio_i2c_buses[i].lock = found = lock;
+    }
+  }
+  portEXIT_CRITICAL(&busio_i2c_buses_mux);
+  if (found != lock) {
+    vSemaphoreDelete(lock);
+  }
+  return found;
+}
+#endif
+
+#ifdef BUSIO_I2C_STATS
+// Every live device, newest first, for reporting
+static Adafruit_I2CDevice *busio_i2c_instances = nullptr;
+#endif
+
 /*!
  *    @brief  Create an I2C device at a given address
  *    @param  addr The 7-bit I2C address for the device
@@ -11,15 +68,41 @@ Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire) {
   _addr = addr;
   _wire = theWire;
   _begun = false;
+  resetContention();
+#if defined(ESP32)
+  _busLock = nullptr;
+  _lockDepth = 0;
+#endif
+#ifdef BUSIO_I2C_STATS
+  resetStats();
+  _statsDepth = 0;
+  _statsNext = busio_i2c_instances;
+  busio_i2c_instances = this;
+#endif
 #ifdef ARDUINO_ARCH_SAMD
   _maxBufferSize = 250; // as defined in Wire.h's RingBuffer
 #elif defined(ESP32)
-  _maxBufferSize = I2C_BUFFER_LENGTH;
+  _maxBufferSize = I2C_BUFFER_LENGTH; // can be raised, see setMaxBufferSize()
 #else
   _maxBufferSize = 32;
 #endif
 }
 
+#ifdef BUSIO_I2C_STATS
+/*!
+ *    @brief  Remove the device from the firstInstance() list
+ */
+Adafruit_I2CDevice::~Adafruit_I2CDevice() {
+  for (Adafruit_I2CDevice **p = &busio_i2c_instances; *p;
+       p = &(*p)->_statsNext) {
+    if (*p == this) {
+      *p = _statsNext;
+      break;
+    }
+  }
+}
+#endif
+
 /*!
  *    @brief  Initializes and does basic address detection
  *    @param  addr_detect Whether we should attempt to detect the I2C address
@@ -59,22 +142,37 @@ void Adafruit_I2CDevice::end(void) {
  *    if there's no pullups on I2C
  *    @return True if I2C initialized and a device with the addr found
  */
-bool Adafruit_I2CDevice::detected(void) {
+bool Adafruit_I2CDevice::detected(void) { return detected(_addr); }
+
+/*!
+ *    @brief  Probe any address on this device's bus, e.g. for a bus scan
+ *    that has to share the bus with running drivers: the probe takes the
+ *    bus lock and is counted in this device's stats()
+ *    @param  addr The 7-bit address to probe
+ *    @return True if I2C initialized and a device at addr ACKed
+ */
+bool Adafruit_I2CDevice::detected(uint8_t addr) {
   // Init I2C if not done yet
-  if (!_begun && !begin()) {
+  if (!_begun && !begin(false)) {
     return false;
   }
 
   // A basic scanner, see if it ACK's
-  _wire->beginTransmission(_addr);
+  lockBus();
+  statsBegin();
+  _wire->beginTransmission(addr);
 #ifdef DEBUG_SERIAL
   DEBUG_SERIAL.print(F("Address 0x"));
-  DEBUG_SERIAL.print(_addr, HEX);
+  DEBUG_SERIAL.print(addr, HEX);
 #endif
 #ifdef ARDUINO_ARCH_MBED
   _wire->write(0); // forces a write request instead of a read
 #endif
-  if (_wire->endTransmission() == 0) {
+  uint8_t error = _wire->endTransmission();
+  statsResult(error);
+  statsEnd(error == 0);
+  unlockBus();
+  if (error == 0) {
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println(F(" Detected"));
 #endif
@@ -102,10 +200,20 @@ bool Adafruit_I2CDevice::detected(void) {
 bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
                                const uint8_t *prefix_buffer,
                                size_t prefix_len) {
+  lockBus();
+  statsBegin();
+  bool ok = _write(buffer, len, stop, prefix_buffer, prefix_len);
+  statsEnd(ok);
+  unlockBus();
+  return ok;
+}
+
+bool Adafruit_I2CDevice::_write(const uint8_t *buffer, size_t len, bool stop,
+                                const uint8_t *prefix_buffer,
+                                size_t prefix_len) {
   if ((len + prefix_len) > maxBufferSize()) {
-    // currently not guaranteed to work if more than 32 bytes!
-    // we will need to find out if some platforms have larger
-    // I2C buffer sizes :/
+    // The Wire transmit buffer would overflow; see write_chunked() for
+    // longer transfers
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println(F("\tI2CDevice could not write such a large buffer"));
 #endif
@@ -158,7 +266,12 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
   }
 #endif
 
-  if (_wire->endTransmission(stop) == 0) {
+  uint8_t error = _wire->endTransmission(stop);
+#ifdef BUSIO_I2C_STATS
+  _stats.bytes_written += prefix_len + len;
+#endif
+  statsResult(error);
+  if (error == 0) {
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println();
     // DEBUG_SERIAL.println("Sent!");
@@ -172,6 +285,39 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
   }
 }
 
+/*!
+ *    @brief  Write a buffer of any length, in as few transactions as the Wire
+ *    buffer allows: one if prefix and data fit in maxBufferSize(), otherwise
+ *    consecutive transactions of maxBufferSize() bytes that each start with
+ *    the prefix (e.g. a register address or a display's data control byte).
+ *    The bus lock is released between chunks, so a higher priority task
+ *    sharing the bus waits for at most one chunk.
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write
+ *    @param  prefix_buffer Pointer to optional data repeated before every
+ *            chunk
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return True if every chunk was written, otherwise false.
+ */
+bool Adafruit_I2CDevice::write_chunked(const uint8_t *buffer, size_t len,
+                                       const uint8_t *prefix_buffer,
+                                       size_t prefix_len) {
+  if ((len + prefix_len) <= maxBufferSize()) {
+    return write(buffer, len, true, prefix_buffer, prefix_len);
+  }
+  if (prefix_len >= maxBufferSize()) {
+    return false;
+  }
+  size_t chunk = maxBufferSize() - prefix_len;
+  for (size_t pos = 0; pos < len; pos += chunk) {
+    size_t n = (len - pos) < chunk ? (len - pos) : chunk;
+    if (!write(buffer + pos, n, true, prefix_buffer, prefix_len)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /*!
  *    @brief  Read from I2C into a buffer from the I2C device.
  *    Cannot be more than maxBufferSize() bytes.
@@ -181,16 +327,24 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
  *    @return True if read was successful, otherwise false.
  */
 bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
+  // Held across chunks: they are joined by repeated starts, not STOPs
+  bool ok = true;
+  lockBus();
+  statsBegin();
   size_t pos = 0;
   while (pos < len) {
     size_t read_len =
         ((len - pos) > maxBufferSize()) ? maxBufferSize() : (len - pos);
     bool read_stop = (pos < (len - read_len)) ? false : stop;
-    if (!_read(buffer + pos, read_len, read_stop))
-      return false;
+    if (!_read(buffer + pos, read_len, read_stop)) {
+      ok = false;
+      break;
+    }
     pos += read_len;
   }
-  return true;
+  statsEnd(ok);
+  unlockBus();
+  return ok;
 }
 
 bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
@@ -201,6 +355,9 @@ bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
 #else
   size_t recv = _wire->requestFrom((uint8_t)_addr, (uint8_t)len, (uint8_t)stop);
 #endif
+#ifdef BUSIO_I2C_STATS
+  _stats.bytes_read += recv;
+#endif
 
   if (recv != len) {
     // Not enough data available to fulfill our obligation!
@@ -247,11 +404,74 @@ bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
 bool Adafruit_I2CDevice::write_then_read(const uint8_t *write_buffer,
                                          size_t write_len, uint8_t *read_buffer,
                                          size_t read_len, bool stop) {
-  if (!write(write_buffer, write_len, stop)) {
+  // One lock for both halves so no other device's traffic lands between the
+  // register address and the repeated start
+  lockBus();
+  statsBegin();
+  bool ok = write(write_buffer, write_len, stop) && read(read_buffer, read_len);
+  statsEnd(ok);
+  unlockBus();
+  return ok;
+}
+
+/*!
+ *    @brief  Take the lock shared by every Adafruit_I2CDevice on this TwoWire,
+ *    waiting as long as it takes. Every transaction method does this itself;
+ *    call it directly (with unlockBus()) only to keep several transactions
+ *    together. Recursive, and a no-op returning true without FreeRTOS. Time
+ *    spent waiting is added to contention(); only the outermost take counts
+ *    as an acquisition.
+ *    @return True once the bus is held
+ */
+bool Adafruit_I2CDevice::lockBus(void) {
+#if defined(ESP32)
+  if (!_busLock && !(_busLock = busio_i2c_bus_lock(_wire))) {
     return false;
   }
+  if (xSemaphoreTakeRecursive(_busLock, 0) == pdTRUE) {
+    // Only the holder touches the depth, so it needs no lock of its own
+    if (_lockDepth++ == 0) {
+      _contention.acquisitions++;
+    }
+    return true;
+  }
+  uint32_t t0 = micros();
+  xSemaphoreTakeRecursive(_busLock, portMAX_DELAY);
+  uint32_t waited = micros() - t0;
+  // A nested take never waits: this is the outermost one
+  _lockDepth++;
+  _contention.acquisitions++;
+  _contention.waits++;
+  _contention.wait_us += waited;
+  if (waited > _contention.max_wait_us) {
+    _contention.max_wait_us = waited;
+  }
+#endif
+  return true;
+}
+
+/*!
+ *    @brief  Release the bus taken with lockBus()
+ */
+void Adafruit_I2CDevice::unlockBus(void) {
+#if defined(ESP32)
+  if (_busLock) {
+    if (_lockDepth) {
+      _lockDepth--;
+    }
+    xSemaphoreGiveRecursive(_busLock);
+  }
+#endif
+}
 
-  return read(read_buffer, read_len);
+/*!
+ *    @brief  Zero the contention() counters
+ */
+void Adafruit_I2CDevice::resetContention(void) {
+  _contention.acquisitions = 0;
+  _contention.waits = 0;
+  _contention.wait_us = 0;
+  _contention.max_wait_us = 0;
 }
 
 /*!
@@ -318,3 +538,96 @@ bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk) {
   return false;
 #endif
 }
+
+/*!
+ *    @brief  Grow the Wire transmit/receive buffer so longer transfers fit in
+ *    one transaction. Only ESP32 (arduino-esp32 2.x) can resize it, and only
+ *    before the bus is started, so call this before begin(). The buffer is
+ *    shared by every device on the same TwoWire.
+ *    @param  size Desired buffer size in bytes
+ *    @return True if the buffer now holds at least size bytes
+ */
+bool Adafruit_I2CDevice::setMaxBufferSize(size_t size) {
+#if defined(ESP32)
+  size_t got = _wire->setBufferSize(size);
+  if (got >= size) {
+    _maxBufferSize = got;
+    return true;
+  }
+  return false;
+#else
+  (void)size;
+  return false;
+#endif
+}
+
+/*!
+ *    @brief  Start timing a transaction. Calls nest (write_then_read() uses
+ *    write() and read()); only the outermost one is counted.
+ */
+void Adafruit_I2CDevice::statsBegin(void) {
+#ifdef BUSIO_I2C_STATS
+  if (_statsDepth++ == 0) {
+    _statsStart_us = micros();
+  }
+#endif
+}
+
+/*!
+ *    @brief  Finish the transaction started by statsBegin()
+ *    @param  ok Whether it succeeded
+ */
+void Adafruit_I2CDevice::statsEnd(bool ok) {
+#ifdef BUSIO_I2C_STATS
+  if (--_statsDepth != 0) {
+    return;
+  }
+  uint32_t us = micros() - _statsStart_us;
+  uint8_t bucket = 0;
+  while (bucket < BUSIO_I2C_LATENCY_BUCKETS - 1 && (us >> (bucket + 1))) {
+    bucket++;
+  }
+  _stats.transactions++;
+  _stats.busy_us += us;
+  _stats.latency[bucket]++;
+  if (!ok) {
+    _stats.failures++;
+  }
+#else
+  (void)ok;
+#endif
+}
+
+/*!
+ *    @brief  Count the NACKs in an endTransmission() result
+ *    @param  error The value endTransmission() returned
+ */
+void Adafruit_I2CDevice::statsResult(uint8_t error) {
+#ifdef BUSIO_I2C_STATS
+  if (error == 2) {
+    _stats.nack_address++;
+  } else if (error == 3) {
+    _stats.nack_data++;
+  }
+#else
+  (void)error;
+#endif
+}
+
+#ifdef BUSIO_I2C_STATS
+/*!
+ *    @brief  Zero the stats() counters
+ */
+void Adafruit_I2CDevice::resetStats(void) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/*!
+ *    @brief  First device in the list of every live Adafruit_I2CDevice (most
+ *    recently constructed first), to report stats() for all of them
+ *    @return The first device, or nullptr if there are none
+ */
+Adafruit_I2CDevice *Adafruit_I2CDevice::firstInstance(void) {
+  return busio_i2c_instances;
+}
+#endif
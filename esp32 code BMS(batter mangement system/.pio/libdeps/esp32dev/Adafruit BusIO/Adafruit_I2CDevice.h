@@ -4,14 +4,49 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
+///< How long one Adafruit_I2CDevice has waited for its shared bus
+typedef struct {
+  uint32_t acquisitions; ///< transactions that took the bus lock
+  uint32_t waits;        ///< of those, how many found the bus busy
+  uint32_t wait_us;      ///< total time spent waiting
+  uint32_t max_wait_us;  ///< longest single wait
+} busio_i2c_contention_t;
+
+// Define BUSIO_I2C_STATS (e.g. in build_flags) to count every transaction
+#ifndef BUSIO_I2C_LATENCY_BUCKETS
+#define BUSIO_I2C_LATENCY_BUCKETS 16 ///< log2 latency buckets, 1 us .. 32 ms+
+#endif
+
+///< Traffic of one Adafruit_I2CDevice, kept when BUSIO_I2C_STATS is defined
+typedef struct {
+  uint32_t transactions;  ///< write(), read(), write_then_read(), detected()
+  uint32_t failures;      ///< of those, how many returned false
+  uint32_t nack_address;  ///< endTransmission() 2: nobody ACKed the address
+  uint32_t nack_data;     ///< endTransmission() 3: a data byte was NACKed
+  uint32_t bytes_written; ///< register addresses and payload
+  uint32_t bytes_read;    ///< bytes received
+  uint32_t busy_us;       ///< total time in transactions, without lock waits
+  uint32_t latency[BUSIO_I2C_LATENCY_BUCKETS]; ///< [k]: 2^k <= us < 2^(k+1);
+                                               ///< [0] also 0 us, last open
+} busio_i2c_stats_t;
+
 ///< The class which defines how we will talk to this device over I2C
 class Adafruit_I2CDevice {
 public:
   Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire = &Wire);
+#ifdef BUSIO_I2C_STATS
+  ~Adafruit_I2CDevice();
+#endif
   uint8_t address(void);
   bool begin(bool addr_detect = true);
   void end(void);
   bool detected(void);
+  bool detected(uint8_t addr);
 
   bool read(uint8_t *buffer, size_t len, bool stop = true);
   bool write(const uint8_t *buffer, size_t len, bool stop = true,
@@ -19,18 +54,60 @@ public:
   bool write_then_read(const uint8_t *write_buffer, size_t write_len,
                        uint8_t *read_buffer, size_t read_len,
                        bool stop = false);
+  bool write_chunked(const uint8_t *buffer, size_t len,
+                     const uint8_t *prefix_buffer = nullptr,
+                     size_t prefix_len = 0);
   bool setSpeed(uint32_t desiredclk);
+  bool setMaxBufferSize(size_t size);
 
   /*!   @brief  How many bytes we can read in a transaction
    *    @return The size of the Wire receive/transmit buffer */
   size_t maxBufferSize() { return _maxBufferSize; }
 
+  /*!   @brief  Bus lock statistics for this device, see lockBus()
+   *    @return Counters since construction or resetContention() */
+  const busio_i2c_contention_t &contention() { return _contention; }
+  void resetContention(void);
+
+  bool lockBus(void);
+  void unlockBus(void);
+
+#ifdef BUSIO_I2C_STATS
+  /*!   @brief  Transaction counters for this device
+   *    @return Counters since construction or resetStats() */
+  const busio_i2c_stats_t &stats() { return _stats; }
+  void resetStats(void);
+  /*!   @brief  The I2C bus this device talks on, to label stats()
+   *    @return The TwoWire given to the constructor */
+  TwoWire *wire() { return _wire; }
+  static Adafruit_I2CDevice *firstInstance(void);
+  /*!   @brief  Walk every live device, see firstInstance()
+   *    @return The next device, or nullptr after the last one */
+  Adafruit_I2CDevice *nextInstance(void) { return _statsNext; }
+#endif
+
 private:
   uint8_t _addr;
   TwoWire *_wire;
   bool _begun;
   size_t _maxBufferSize;
+  busio_i2c_contention_t _contention;
+#if defined(ESP32)
+  SemaphoreHandle_t _busLock;
+  uint8_t _lockDepth; // nested lockBus() calls of this device
+#endif
+#ifdef BUSIO_I2C_STATS
+  busio_i2c_stats_t _stats;
+  Adafruit_I2CDevice *_statsNext;
+  uint32_t _statsStart_us;
+  uint8_t _statsDepth;
+#endif
+  void statsBegin(void);
+  void statsEnd(bool ok);
+  void statsResult(uint8_t error);
   bool _read(uint8_t *buffer, size_t len, bool stop);
+  bool _write(const uint8_t *buffer, size_t len, bool stop,
+              const uint8_t *prefix_buffer, size_t prefix_len);
 };
 
 #endif // Adafruit_I2CDevice_h
@@ -0,0 +1,202 @@
+#include "Adafruit_I2CQueue.h"
+
+#if defined(ESP32)
+
+/*!
+ *    @brief  Create a queue; nothing runs until begin()
+ *    @param  depth How many transactions can wait at once
+ */
+Adafruit_I2CQueue::Adafruit_I2CQueue(uint8_t depth) {
+  _depth = depth ? depth : 1;
+}
+
+/*!
+ *    @brief  Stops the worker task and frees the queue
+ */
+Adafruit_I2CQueue::~Adafruit_I2CQueue() { end(); }
+
+/*!
+ *    @brief  Creates the queue and its worker task
+ *    @param  priority FreeRTOS priority of the worker; above the submitting
+ *            tasks so a transfer starts as soon as it is queued
+ *    @param  core Core to pin the worker to, or tskNO_AFFINITY
+ *    @param  stackSize Worker stack in bytes
+ *    @return True if the task is running
+ */
+bool Adafruit_I2CQueue::begin(UBaseType_t priority, BaseType_t core,
+                              uint32_t stackSize) {
+  if (_task) {
+    return true;
+  }
+  _queue = xQueueCreate(_depth, sizeof(Adafruit_I2CTransaction *));
+  if (!_queue) {
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(taskEntry, "i2cq", stackSize, this, priority,
+                              &_task, core) != pdPASS) {
+    vQueueDelete(_queue);
+    _queue = nullptr;
+    _task = nullptr;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Stops the worker. Transactions still queued are dropped and
+ *    stay PENDING; do not call with a transfer in flight.
+ */
+void Adafruit_I2CQueue::end(void) {
+  if (_task) {
+    vTaskDelete(_task);
+    _task = nullptr;
+  }
+  if (_queue) {
+    vQueueDelete(_queue);
+    _queue = nullptr;
+  }
+}
+
+/*!
+ *    @brief  Queues a filled-in descriptor. The callback runs on the bus
+ *    task after status is set, so it must not block, and it receives a
+ *    descriptor the owner may already be reusing.
+ *    @param  transaction Descriptor; must stay valid until it completes
+ *    @param  wait Ticks to wait for a free queue slot
+ *    @return True if queued; false if the queue is full or not running
+ */
+bool Adafruit_I2CQueue::submit(Adafruit_I2CTransaction *transaction,
+                               TickType_t wait) {
+  if (!_queue || !transaction || !transaction->device) {
+    return false;
+  }
+  transaction->status = BUSIO_I2C_PENDING;
+  if (xQueueSend(_queue, &transaction, wait) != pdTRUE) {
+    transaction->status = BUSIO_I2C_IDLE;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Queues a plain write (with STOP); callback, arg and done of
+ *    the descriptor are left as set by the caller
+ *    @param  transaction Descriptor to fill in and queue
+ *    @param  device Target device
+ *    @param  buffer Bytes to send; must stay valid until completion
+ *    @param  len Number of bytes
+ *    @param  wait Ticks to wait for a free queue slot
+ *    @return True if queued
+ */
+bool Adafruit_I2CQueue::write(Adafruit_I2CTransaction *transaction,
+                              Adafruit_I2CDevice *device,
+                              const uint8_t *buffer, size_t len,
+                              TickType_t wait) {
+  return write_then_read(transaction, device, buffer, len, nullptr, 0, wait);
+}
+
+/*!
+ *    @brief  Queues a plain read (with STOP)
+ *    @param  transaction Descriptor to fill in and queue
+ *    @param  device Target device
+ *    @param  buffer Receives the data on completion
+ *    @param  len Number of bytes
+ *    @param  wait Ticks to wait for a free queue slot
+ *    @return True if queued
+ */
+bool Adafruit_I2CQueue::read(Adafruit_I2CTransaction *transaction,
+                             Adafruit_I2CDevice *device, uint8_t *buffer,
+                             size_t len, TickType_t wait) {
+  return write_then_read(transaction, device, nullptr, 0, buffer, len, wait);
+}
+
+/*!
+ *    @brief  Queues a write followed by a repeated-start read, e.g. a
+ *    register read
+ *    @param  transaction Descriptor to fill in and queue
+ *    @param  device Target device
+ *    @param  write_buffer Bytes to send; must stay valid until completion
+ *    @param  write_len Number of bytes to send
+ *    @param  read_buffer Receives the data on completion
+ *    @param  read_len Number of bytes to read
+ *    @param  wait Ticks to wait for a free queue slot
+ *    @return True if queued
+ */
+bool Adafruit_I2CQueue::write_then_read(
+    Adafruit_I2CTransaction *transaction, Adafruit_I2CDevice *device,
+    const uint8_t *write_buffer, size_t write_len, uint8_t *read_buffer,
+    size_t read_len, TickType_t wait) {
+  if (!transaction) {
+    return false;
+  }
+  transaction->device = device;
+  transaction->write_buffer = write_buffer;
+  transaction->write_len = write_len;
+  transaction->read_buffer = read_buffer;
+  transaction->read_len = read_len;
+  transaction->stop = false;
+  return submit(transaction, wait);
+}
+
+/*!
+ *    @brief  Blocks until a transaction completes. Needs the descriptor's
+ *    done semaphore; without one this polls status once per tick.
+ *    @param  transaction A submitted descriptor
+ *    @param  timeout Ticks to wait
+ *    @return True if it completed successfully within the timeout
+ */
+bool Adafruit_I2CQueue::wait(Adafruit_I2CTransaction *transaction,
+                             TickType_t timeout) {
+  if (transaction->done) {
+    xSemaphoreTake(transaction->done, timeout);
+  } else {
+    TickType_t start = xTaskGetTickCount();
+    while (transaction->status == BUSIO_I2C_PENDING &&
+           xTaskGetTickCount() - start < timeout) {
+      vTaskDelay(1);
+    }
+  }
+  return transaction->status == BUSIO_I2C_DONE;
+}
+
+void Adafruit_I2CQueue::taskEntry(void *arg) {
+  static_cast<Adafruit_I2CQueue *>(arg)->run();
+}
+
+void Adafruit_I2CQueue::run(void) {
+  Adafruit_I2CTransaction *t;
+  for (;;) {
+    if (xQueueReceive(_queue, &t, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    bool ok = execute(t);
+    if (!ok) {
+      _failures = _failures + 1;
+    }
+    // Read everything out of the descriptor before publishing the status:
+    // the owner may reuse it the moment it sees completion
+    busio_i2c_callback_t callback = t->callback;
+    void *arg = t->arg;
+    SemaphoreHandle_t done = t->done;
+    t->status = ok ? BUSIO_I2C_DONE : BUSIO_I2C_FAILED;
+    if (callback) {
+      callback(t, arg);
+    }
+    if (done) {
+      xSemaphoreGive(done);
+    }
+  }
+}
+
+bool Adafruit_I2CQueue::execute(Adafruit_I2CTransaction *t) {
+  if (t->write_len && t->read_len) {
+    return t->device->write_then_read(t->write_buffer, t->write_len,
+                                      t->read_buffer, t->read_len, t->stop);
+  }
+  if (t->read_len) {
+    return t->device->read(t->read_buffer, t->read_len);
+  }
+  return t->device->write(t->write_buffer, t->write_len);
+}
+
+#endif // ESP32
@@ -0,0 +1,96 @@
+#ifndef Adafruit_I2CQueue_h
+#define Adafruit_I2CQueue_h
+
+#include <Adafruit_I2CDevice.h>
+
+#if defined(ESP32)
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+struct Adafruit_I2CTransaction;
+
+typedef void (*busio_i2c_callback_t)(Adafruit_I2CTransaction *transaction,
+                                     void *arg);
+
+///< Where a queued transaction is in its life cycle
+typedef enum {
+  BUSIO_I2C_IDLE,    ///< not submitted yet, or reset for reuse
+  BUSIO_I2C_PENDING, ///< queued or on the bus
+  BUSIO_I2C_DONE,    ///< completed successfully
+  BUSIO_I2C_FAILED,  ///< NACK, short read or bus error
+} busio_i2c_status_t;
+
+/*!
+ * @brief One write, read or write-then-read on an Adafruit_I2CDevice. The
+ * caller owns the descriptor and both buffers until it completes; the queue
+ * only stores a pointer, so nothing is copied or allocated per transfer.
+ */
+struct Adafruit_I2CTransaction {
+  Adafruit_I2CDevice *device;    ///< target device
+  const uint8_t *write_buffer;   ///< bytes to send first, or nullptr
+  size_t write_len;              ///< 0 for a plain read
+  uint8_t *read_buffer;          ///< bytes to receive, or nullptr
+  size_t read_len;               ///< 0 for a plain write
+  bool stop;                     ///< STOP between write and read
+  busio_i2c_callback_t callback; ///< run on the bus task when done, optional
+  void *arg;                     ///< passed to callback
+  SemaphoreHandle_t done;        ///< given when done, optional
+  volatile busio_i2c_status_t status; ///< set by the bus task
+};
+
+/*!
+ * @brief Asynchronous I2C transaction queue for one TwoWire bus. A worker
+ * task owns the bus and runs submitted transactions in order through the
+ * blocking Adafruit_I2CDevice calls (and from there the ESP-IDF I2C driver
+ * behind TwoWire), so the submitting task keeps computing while its
+ * transfer is on the wire. Completion is signalled by callback, by a
+ * caller-supplied semaphore (a future: see wait()), or by polling status.
+ * Devices on the same bus used directly from other tasks are serialised
+ * against the worker by the shared bus lock (Adafruit_I2CDevice::lockBus()).
+ */
+class Adafruit_I2CQueue {
+public:
+  Adafruit_I2CQueue(uint8_t depth = 8);
+  ~Adafruit_I2CQueue();
+  bool begin(UBaseType_t priority = 3, BaseType_t core = tskNO_AFFINITY,
+             uint32_t stackSize = 3072);
+  void end(void);
+
+  bool submit(Adafruit_I2CTransaction *transaction, TickType_t wait = 0);
+  bool write(Adafruit_I2CTransaction *transaction, Adafruit_I2CDevice *device,
+             const uint8_t *buffer, size_t len, TickType_t wait = 0);
+  bool read(Adafruit_I2CTransaction *transaction, Adafruit_I2CDevice *device,
+            uint8_t *buffer, size_t len, TickType_t wait = 0);
+  bool write_then_read(Adafruit_I2CTransaction *transaction,
+                       Adafruit_I2CDevice *device,
+                       const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len,
+                       TickType_t wait = 0);
+  static bool wait(Adafruit_I2CTransaction *transaction,
+                   TickType_t timeout = portMAX_DELAY);
+
+  /*!   @brief  Transactions submitted but not yet started
+   *    @return Number of queued descriptors */
+  UBaseType_t pending(void) {
+    return _queue ? uxQueueMessagesWaiting(_queue) : 0;
+  }
+  /*!   @brief  Transactions that completed with an error
+   *    @return Failure count since begin() */
+  uint32_t failures(void) { return _failures; }
+
+private:
+  static void taskEntry(void *arg);
+  void run(void);
+  static bool execute(Adafruit_I2CTransaction *transaction);
+
+  uint8_t _depth;
+  QueueHandle_t _queue = nullptr;
+  TaskHandle_t _task = nullptr;
+  volatile uint32_t _failures = 0;
+};
+
+#endif // ESP32
+#endif // Adafruit_I2CQueue_h
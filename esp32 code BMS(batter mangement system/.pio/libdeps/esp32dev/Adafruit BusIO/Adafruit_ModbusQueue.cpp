@@ -0,0 +1,380 @@
+#include "Adafruit_ModbusQueue.h"
+
+#if defined(ESP32)
+
+/*!
+ *    @brief  Create a queue; nothing runs until begin()
+ *    @param  device Transport to the RS-485 UART; begin() it first
+ *    @param  port The UART behind device, for its baud rate and to wait
+ *            for the transmitter to drain
+ *    @param  uartEvents The event queue uart_driver_install() returned for
+ *            the same UART
+ *    @param  depth How many reads can wait at once
+ */
+Adafruit_ModbusQueue::Adafruit_ModbusQueue(Adafruit_GenericDevice *device,
+                                           uart_port_t port,
+                                           QueueHandle_t uartEvents,
+                                           uint8_t depth) {
+  _device = device;
+  _port = port;
+  _events = uartEvents;
+  _depth = depth ? depth : 1;
+}
+
+/*!
+ *    @brief  Stops the worker task and frees the queue
+ */
+Adafruit_ModbusQueue::~Adafruit_ModbusQueue() { end(); }
+
+/*!
+ *    @brief  Creates the queue and its worker task
+ *    @param  priority FreeRTOS priority of the worker; above the submitting
+ *            tasks so a request goes out as soon as it is queued
+ *    @param  core Core to pin the worker to, or tskNO_AFFINITY
+ *    @param  stackSize Worker stack in bytes
+ *    @return True if the task is running
+ */
+bool Adafruit_ModbusQueue::begin(UBaseType_t priority, BaseType_t core,
+                                 uint32_t stackSize) {
+  if (_task) {
+    return true;
+  }
+  if (!_device || !_events) {
+    return false;
+  }
+  _queue = xQueueCreate(_depth, sizeof(Adafruit_ModbusRead *));
+  if (!_queue) {
+    return false;
+  }
+  _lineBusy_us = micros(); // the line state before begin() is unknown
+  if (xTaskCreatePinnedToCore(taskEntry, "mbq", stackSize, this, priority,
+                              &_task, core) != pdPASS) {
+    vQueueDelete(_queue);
+    _queue = nullptr;
+    _task = nullptr;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Stops the worker. Reads still queued are dropped and stay
+ *    PENDING; do not call with a request on the wire.
+ */
+void Adafruit_ModbusQueue::end(void) {
+  if (_task) {
+    vTaskDelete(_task);
+    _task = nullptr;
+  }
+  if (_queue) {
+    vQueueDelete(_queue);
+    _queue = nullptr;
+  }
+}
+
+/*!
+ *    @brief  Queues a filled-in descriptor. The callback runs on the bus
+ *    task after status is set, so it must not block, and it receives a
+ *    descriptor the owner may already be reusing. A give left on done by
+ *    an earlier read that wait() gave up on is taken first.
+ *    @param  read Descriptor; must stay valid until it completes
+ *    @param  wait Ticks to wait for a free queue slot
+ *    @return True if queued; false if the queue is full or not running, or
+ *            the descriptor is not a valid read
+ */
+bool Adafruit_ModbusQueue::submit(Adafruit_ModbusRead *read,
+                                  TickType_t wait) {
+  if (!_queue || !read || !read->values || read->count == 0 ||
+      read->count > 125 || (uint32_t)read->address + read->count > 0x10000 ||
+      (read->function != BUSIO_MODBUS_HOLDING &&
+       read->function != BUSIO_MODBUS_INPUT)) {
+    return false;
+  }
+  if (read->done) {
+    xSemaphoreTake(read->done, 0);
+  }
+  read->status = BUSIO_MODBUS_PENDING;
+  if (xQueueSend(_queue, &read, wait) != pdTRUE) {
+    read->status = BUSIO_MODBUS_IDLE;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Queues a register read; callback, arg and done of the
+ *    descriptor are left as set by the caller
+ *    @param  read Descriptor to fill in and queue
+ *    @param  slave Slave address
+ *    @param  address First register
+ *    @param  count Number of registers, 1..125
+ *    @param  values Receives count words on completion
+ *    @param  function BUSIO_MODBUS_HOLDING or BUSIO_MODBUS_INPUT
+ *    @param  wait Ticks to wait for a free queue slot
+ *    @return True if queued
+ */
+bool Adafruit_ModbusQueue::read(Adafruit_ModbusRead *read, uint8_t slave,
+                                uint16_t address, uint16_t count,
+                                uint16_t *values, uint8_t function,
+                                TickType_t wait) {
+  if (!read) {
+    return false;
+  }
+  read->slave = slave;
+  read->function = function;
+  read->address = address;
+  read->count = count;
+  read->values = values;
+  read->exception = 0;
+  return submit(read, wait);
+}
+
+/*!
+ *    @brief  Blocks until a read completes. Needs the descriptor's done
+ *    semaphore; without one this polls status once per tick.
+ *    @param  read A submitted descriptor
+ *    @param  timeout Ticks to wait
+ *    @return True if it completed successfully within the timeout
+ */
+bool Adafruit_ModbusQueue::wait(Adafruit_ModbusRead *read,
+                                TickType_t timeout) {
+  if (read->done) {
+    xSemaphoreTake(read->done, timeout);
+  } else {
+    TickType_t start = xTaskGetTickCount();
+    while (read->status == BUSIO_MODBUS_PENDING &&
+           xTaskGetTickCount() - start < timeout) {
+      vTaskDelay(1);
+    }
+  }
+  return read->status == BUSIO_MODBUS_DONE;
+}
+
+/*!
+ *    @brief  Modbus RTU CRC (polynomial 0xA001, reflected, init 0xFFFF)
+ *    @param  data Frame bytes
+ *    @param  len Number of bytes
+ *    @return CRC; sent low byte first
+ */
+uint16_t Adafruit_ModbusQueue::crc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+void Adafruit_ModbusQueue::taskEntry(void *arg) {
+  static_cast<Adafruit_ModbusQueue *>(arg)->run();
+}
+
+static bool before(const Adafruit_ModbusRead *a, const Adafruit_ModbusRead *b) {
+  if (a->slave != b->slave) {
+    return a->slave < b->slave;
+  }
+  if (a->function != b->function) {
+    return a->function < b->function;
+  }
+  return a->address < b->address;
+}
+
+void Adafruit_ModbusQueue::run(void) {
+  Adafruit_ModbusRead *batch[BUSIO_MODBUS_BATCH];
+  for (;;) {
+    if (xQueueReceive(_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    // Everything queued meanwhile joins this pass
+    uint8_t n = 1;
+    while (n < BUSIO_MODBUS_BATCH &&
+           xQueueReceive(_queue, &batch[n], 0) == pdTRUE) {
+      n++;
+    }
+    for (uint8_t i = 1; i < n; i++) {
+      Adafruit_ModbusRead *r = batch[i];
+      uint8_t j = i;
+      for (; j > 0 && before(r, batch[j - 1]); j--) {
+        batch[j] = batch[j - 1];
+      }
+      batch[j] = r;
+    }
+
+    // One request per run of reads a single range request can cover
+    uint8_t i = 0;
+    while (i < n) {
+      const Adafruit_ModbusRead *first = batch[i];
+      uint32_t start = first->address, end = start + first->count;
+      uint8_t k = i + 1;
+      while (k < n && batch[k]->slave == first->slave &&
+             batch[k]->function == first->function &&
+             batch[k]->address <= end + BUSIO_MODBUS_MAX_GAP) {
+        uint32_t e = batch[k]->address + batch[k]->count;
+        if (e < end) {
+          e = end;
+        }
+        if (e - start > 125) {
+          break;
+        }
+        end = e;
+        k++;
+      }
+      exchange(&batch[i], k - i, start, end - start);
+      i = k;
+    }
+  }
+}
+
+// One character on the wire: start bit, 8 data bits and parity or a
+// second stop bit
+uint32_t Adafruit_ModbusQueue::charTime_us(void) {
+  uint32_t baud = 0;
+  if (uart_get_baudrate(_port, &baud) != ESP_OK || baud == 0) {
+    baud = 9600;
+  }
+  return (11000000UL + baud - 1) / baud;
+}
+
+// Wait until nothing has been sent or received for t3.5, dropping what is
+// left of an earlier late or garbled response on the way
+void Adafruit_ModbusQueue::waitForSilence(void) {
+  uart_wait_tx_idle_polling(_port);
+  uint32_t charTime = charTime_us();
+  // Fixed at 1750 us above 19200 baud, per the RTU spec
+  int32_t gap_us = charTime < 573 ? 1750 : (7 * charTime + 1) / 2;
+  for (;;) {
+    uint8_t stale;
+    while (_device->read(&stale, 1)) {
+      _lineBusy_us = micros();
+    }
+    // Negative while the request's estimated end is still ahead
+    int32_t idle = (int32_t)(micros() - _lineBusy_us);
+    if (idle >= gap_us) {
+      break;
+    }
+    uint32_t left = gap_us - idle;
+    if (left > portTICK_PERIOD_MS * 1000) {
+      vTaskDelay(1);
+    } else {
+      delayMicroseconds(left);
+    }
+  }
+  xQueueReset(_events);
+}
+
+void Adafruit_ModbusQueue::exchange(Adafruit_ModbusRead **group, uint8_t n,
+                                    uint16_t start, uint16_t count) {
+  uint8_t slave = group[0]->slave, function = group[0]->function;
+  waitForSilence();
+
+  uint8_t request[8] = {slave,
+                        function,
+                        (uint8_t)(start >> 8),
+                        (uint8_t)start,
+                        (uint8_t)(count >> 8),
+                        (uint8_t)count,
+                        0,
+                        0};
+  uint16_t crc = crc16(request, 6);
+  request[6] = (uint8_t)crc;
+  request[7] = (uint8_t)(crc >> 8);
+  _requests = _requests + 1;
+
+  uint8_t exception = 0;
+  busio_modbus_status_t status = BUSIO_MODBUS_TIMEOUT;
+  if (_device->write(request, sizeof(request))) {
+    // The UART may still be shifting it out; silence starts after that
+    _lineBusy_us = micros() + sizeof(request) * charTime_us();
+    status = receive(slave, function, count, &exception);
+  }
+
+  for (uint8_t i = 0; i < n; i++) {
+    Adafruit_ModbusRead *r = group[i];
+    if (status == BUSIO_MODBUS_DONE) {
+      const uint8_t *p = &_frame[3 + 2 * (r->address - start)];
+      for (uint16_t w = 0; w < r->count; w++, p += 2) {
+        r->values[w] = (uint16_t)(p[0] << 8 | p[1]);
+      }
+    }
+    r->exception = exception;
+    finish(r, status);
+  }
+}
+
+// Collect one response from the UART events; complete once the length the
+// function code implies has arrived
+busio_modbus_status_t Adafruit_ModbusQueue::receive(uint8_t slave,
+                                                    uint8_t function,
+                                                    uint16_t count,
+                                                    uint8_t *exception) {
+  uint16_t needed = 5 + 2 * count;
+  TickType_t start = xTaskGetTickCount();
+  TickType_t limit = pdMS_TO_TICKS(_timeout_ms);
+  if (limit == 0) {
+    limit = 1;
+  }
+  _frameLen = 0;
+  while (_frameLen < needed) {
+    TickType_t waited = xTaskGetTickCount() - start;
+    uart_event_t event;
+    if (waited >= limit ||
+        xQueueReceive(_events, &event, limit - waited) != pdTRUE) {
+      return BUSIO_MODBUS_TIMEOUT;
+    }
+    _lineBusy_us = micros();
+    if (event.type != UART_DATA) {
+      if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL ||
+          event.type == UART_FRAME_ERR || event.type == UART_PARITY_ERR) {
+        return BUSIO_MODBUS_BAD_FRAME; // bytes were lost or corrupted
+      }
+      continue;
+    }
+    size_t len = event.size;
+    if (len > sizeof(_frame) - _frameLen ||
+        !_device->read(&_frame[_frameLen], len)) {
+      return BUSIO_MODBUS_BAD_FRAME;
+    }
+    _frameLen += len;
+    if (_frameLen >= 2 && _frame[1] == (function | 0x80)) {
+      needed = 5;
+    }
+  }
+
+  if (_frameLen != needed || _frame[0] != slave ||
+      crc16(_frame, needed - 2) !=
+          (uint16_t)(_frame[needed - 2] | _frame[needed - 1] << 8)) {
+    return BUSIO_MODBUS_BAD_FRAME;
+  }
+  if (_frame[1] == (function | 0x80)) {
+    *exception = _frame[2];
+    return BUSIO_MODBUS_EXCEPTION;
+  }
+  if (_frame[1] != function || _frame[2] != 2 * count) {
+    return BUSIO_MODBUS_BAD_FRAME;
+  }
+  return BUSIO_MODBUS_DONE;
+}
+
+void Adafruit_ModbusQueue::finish(Adafruit_ModbusRead *r,
+                                  busio_modbus_status_t status) {
+  _reads = _reads + 1;
+  if (status != BUSIO_MODBUS_DONE) {
+    _failures = _failures + 1;
+  }
+  // Read everything out of the descriptor before publishing the status:
+  // the owner may reuse it the moment it sees completion
+  busio_modbus_callback_t callback = r->callback;
+  void *arg = r->arg;
+  SemaphoreHandle_t done = r->done;
+  r->status = status;
+  if (callback) {
+    callback(r, arg);
+  }
+  if (done) {
+    xSemaphoreGive(done);
+  }
+}
+
+#endif // ESP32
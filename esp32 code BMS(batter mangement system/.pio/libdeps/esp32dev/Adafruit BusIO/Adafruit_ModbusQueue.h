@@ -0,0 +1,139 @@
+#ifndef Adafruit_ModbusQueue_h
+#define Adafruit_ModbusQueue_h
+
+#include <Adafruit_GenericDevice.h>
+
+#if defined(ESP32)
+
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#if !defined(BUSIO_MODBUS_BATCH)
+#define BUSIO_MODBUS_BATCH 16 ///< Reads the worker merges in one pass
+#endif
+#if !defined(BUSIO_MODBUS_MAX_GAP)
+#define BUSIO_MODBUS_MAX_GAP 8 ///< Unwanted registers worth reading to merge
+#endif
+
+#define BUSIO_MODBUS_HOLDING 0x03 ///< Read Holding Registers
+#define BUSIO_MODBUS_INPUT 0x04   ///< Read Input Registers
+
+struct Adafruit_ModbusRead;
+
+typedef void (*busio_modbus_callback_t)(Adafruit_ModbusRead *read,
+                                        void *arg);
+
+///< Where a queued read is in its life cycle
+typedef enum {
+  BUSIO_MODBUS_IDLE,      ///< not submitted yet, or reset for reuse
+  BUSIO_MODBUS_PENDING,   ///< queued or on the wire
+  BUSIO_MODBUS_DONE,      ///< values filled in
+  BUSIO_MODBUS_TIMEOUT,   ///< no complete response in time
+  BUSIO_MODBUS_BAD_FRAME, ///< CRC, address or length mismatch
+  BUSIO_MODBUS_EXCEPTION, ///< the slave answered with an exception code
+} busio_modbus_status_t;
+
+/*!
+ * @brief A read of count consecutive registers from one slave. The caller
+ * owns the descriptor and the values buffer until it completes; the queue
+ * only stores a pointer.
+ */
+struct Adafruit_ModbusRead {
+  uint8_t slave;                    ///< slave address, 1..247
+  uint8_t function;                 ///< BUSIO_MODBUS_HOLDING or _INPUT
+  uint16_t address;                 ///< first register
+  uint16_t count;                   ///< registers, 1..125
+  uint16_t *values;                 ///< receives count words
+  busio_modbus_callback_t callback; ///< run on the bus task, optional
+  void *arg;                        ///< passed to callback
+  SemaphoreHandle_t done;           ///< given when done, optional
+  volatile busio_modbus_status_t status; ///< set by the bus task
+  uint8_t exception;                ///< exception code if EXCEPTION
+};
+
+/*!
+ * @brief Pipelined Modbus RTU register reads over an Adafruit_GenericDevice
+ * on an RS-485 UART, for BMS boards that speak Modbus. Callers queue reads
+ * and carry on; a worker task takes everything queued at once, sorts it by
+ * slave and register, and merges reads of the same slave that are
+ * contiguous, overlapping or nearly so into one range request (up to 125
+ * registers) with one round trip. Responses are parsed from the UART
+ * driver's event queue as the bytes arrive, and the frame is complete as
+ * soon as its length is reached. The next request goes out as soon as the
+ * line has been silent for t3.5 (3.5 characters at the UART's baud rate,
+ * 1750 us above 19200 baud), without a task switch to the caller.
+ *
+ * RS-485 is half duplex, so one request is on a bus at a time; a second
+ * UART with its own queue runs in parallel. The GenericDevice read callback
+ * must not block (timeout 0): it is only called for bytes an event says
+ * are there, and to drain stale ones. The queue owns the device while it
+ * runs.
+ */
+class Adafruit_ModbusQueue {
+public:
+  Adafruit_ModbusQueue(Adafruit_GenericDevice *device, uart_port_t port,
+                       QueueHandle_t uartEvents, uint8_t depth = 16);
+  ~Adafruit_ModbusQueue();
+  bool begin(UBaseType_t priority = 3, BaseType_t core = tskNO_AFFINITY,
+             uint32_t stackSize = 3072);
+  void end(void);
+
+  /*!   @brief  Response timeout per request (default 100 ms)
+   *    @param  ms Milliseconds from handing the request to the UART */
+  void setTimeout(uint32_t ms) { _timeout_ms = ms; }
+
+  bool submit(Adafruit_ModbusRead *read, TickType_t wait = 0);
+  bool read(Adafruit_ModbusRead *read, uint8_t slave, uint16_t address,
+            uint16_t count, uint16_t *values,
+            uint8_t function = BUSIO_MODBUS_HOLDING, TickType_t wait = 0);
+  static bool wait(Adafruit_ModbusRead *read,
+                   TickType_t timeout = portMAX_DELAY);
+
+  static uint16_t crc16(const uint8_t *data, size_t len);
+
+  /*!   @brief  Reads submitted but not yet taken by the worker
+   *    @return Number of queued descriptors */
+  UBaseType_t pending(void) {
+    return _queue ? uxQueueMessagesWaiting(_queue) : 0;
+  }
+  /*!   @brief  Requests sent on the wire
+   *    @return Count since begin(); below reads() when reads were merged */
+  uint32_t requests(void) { return _requests; }
+  /*!   @brief  Reads completed, successfully or not
+   *    @return Count since begin() */
+  uint32_t reads(void) { return _reads; }
+  /*!   @brief  Reads that did not complete successfully
+   *    @return Count since begin() */
+  uint32_t failures(void) { return _failures; }
+
+private:
+  static void taskEntry(void *arg);
+  void run(void);
+  void exchange(Adafruit_ModbusRead **group, uint8_t n, uint16_t start,
+                uint16_t count);
+  busio_modbus_status_t receive(uint8_t slave, uint8_t function,
+                                uint16_t count, uint8_t *exception);
+  void finish(Adafruit_ModbusRead *read, busio_modbus_status_t status);
+  uint32_t charTime_us(void);
+  void waitForSilence(void);
+
+  Adafruit_GenericDevice *_device;
+  uart_port_t _port;
+  QueueHandle_t _events;
+  uint8_t _depth;
+  QueueHandle_t _queue = nullptr;
+  TaskHandle_t _task = nullptr;
+  uint32_t _timeout_ms = 100;
+  uint8_t _frame[5 + 2 * 125]; ///< largest response
+  uint16_t _frameLen = 0;
+  uint32_t _lineBusy_us = 0; ///< last byte seen or sent on the line
+  volatile uint32_t _requests = 0;
+  volatile uint32_t _reads = 0;
+  volatile uint32_t _failures = 0;
+};
+
+#endif // ESP32
+#endif // Adafruit_ModbusQueue_h
@@ -286,6 +286,9 @@ uint8_t Adafruit_SPIDevice::transfer(uint8_t send) {
  */
 void Adafruit_SPIDevice::beginTransaction(void) {
   if (_spi) {
+#ifdef BUSIO_SPI_ASYNC
+    dmaWait(); // a queued transfer would share the bus and CS
+#endif
 #ifdef BUSIO_HAS_HW_SPI
     _spi->beginTransaction(*_spiSetting);
 #endif
@@ -352,11 +355,12 @@ bool Adafruit_SPIDevice::write(const uint8_t *buffer, size_t len,
   // do the writing
 #if defined(ARDUINO_ARCH_ESP32)
   if (_spi) {
+    // writeBytes fills the FIFO 64 bytes at a time and skips the RX copy
     if (prefix_len > 0) {
-      _spi->transferBytes((uint8_t *)prefix_buffer, nullptr, prefix_len);
+      _spi->writeBytes(prefix_buffer, prefix_len);
     }
     if (len > 0) {
-      _spi->transferBytes((uint8_t *)buffer, nullptr, len);
+      _spi->writeBytes(buffer, len);
     }
   } else
 #endif
@@ -447,7 +451,7 @@ bool Adafruit_SPIDevice::write_then_read(const uint8_t *write_buffer,
 #if defined(ARDUINO_ARCH_ESP32)
   if (_spi) {
     if (write_len > 0) {
-      _spi->transferBytes((uint8_t *)write_buffer, nullptr, write_len);
+      _spi->writeBytes(write_buffer, write_len);
     }
   } else
 #endif
@@ -470,10 +474,9 @@ bool Adafruit_SPIDevice::write_then_read(const uint8_t *write_buffer,
   DEBUG_SERIAL.println();
 #endif
 
-  // do the reading
-  for (size_t i = 0; i < read_len; i++) {
-    read_buffer[i] = transfer(sendvalue);
-  }
+  // do the reading, as one buffer transfer (bulk on hardware SPI)
+  memset(read_buffer, sendvalue, read_len);
+  transfer(read_buffer, read_len);
 
 #ifdef DEBUG_SERIAL
   DEBUG_SERIAL.print(F("\tSPIDevice Read: "));
@@ -510,3 +513,192 @@ bool Adafruit_SPIDevice::write_and_read(uint8_t *buffer, size_t len) {
 
   return true;
 }
+
+#ifdef BUSIO_SPI_ASYNC
+
+/*!
+ *    @brief  Attach the IDF SPI master driver to the host the SPI object
+ *            drives, for writeAsync() and transferAsync(). Call after begin();
+ *            the Arduino driver keeps the pins and all blocking transfers.
+ *    @param  host The SPI host behind the SPI object (VSPI for the default
+ *            one on the ESP32)
+ *    @return true if DMA is available; false leaves the async calls blocking
+ */
+bool Adafruit_SPIDevice::initDMA(spi_host_device_t host) {
+  if (_dmaDevice)
+    return true;
+  if (!_spi || !_begun)
+    return false;
+
+  // No pins: the Arduino driver has already routed them. Another driver
+  // (e.g. Adafruit_SPITFT's DMA) may have initialized the host already.
+  spi_bus_config_t bus = {};
+  bus.mosi_io_num = -1;
+  bus.miso_io_num = -1;
+  bus.sclk_io_num = -1;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = BUSIO_SPI_DMA_MAX;
+  esp_err_t err = spi_bus_initialize(host, &bus, SPI_DMA_CH_AUTO);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    return false;
+
+  // Same clock and mode as the blocking path, so the two can interleave
+  spi_device_interface_config_t dev = {};
+  dev.mode = _dataMode;
+  dev.clock_speed_hz = (int)_freq;
+  dev.spics_io_num = -1; // CS from pre_cb / post_cb, see dmaStart()
+  dev.queue_size = BUSIO_SPI_DMA_QUEUE;
+  dev.flags = SPI_DEVICE_NO_DUMMY;
+  if (_dataOrder == SPI_BITORDER_LSBFIRST)
+    dev.flags |= SPI_DEVICE_BIT_LSBFIRST;
+  dev.pre_cb = dmaStart;
+  dev.post_cb = dmaDone;
+  if (spi_bus_add_device(host, &dev, &_dmaDevice) != ESP_OK) {
+    _dmaDevice = nullptr;
+    return false;
+  }
+
+  // Let the IDF program the host once with CS released; from then on its
+  // registers match what Arduino transactions leave behind
+  spi_transaction_t t = {};
+  t.flags = SPI_TRANS_USE_TXDATA;
+  t.length = 8;
+  t.tx_data[0] = 0;
+  spi_device_polling_transmit(_dmaDevice, &t);
+  return true;
+}
+
+/*!
+ *    @brief  Queue a buffer to be written by DMA and return at once. Larger
+ *            than BUSIO_SPI_DMA_MAX it goes out in several transfers with CS
+ *            held throughout. Without initDMA() the write is blocking.
+ *    @param  buffer Data to write; must stay valid and unchanged until the
+ *            callback ran or dmaBusy() is false. DMA-capable RAM (not flash,
+ *            not PSRAM) avoids a copy by the driver.
+ *    @param  len Number of bytes to write
+ *    @param  callback Optional, runs in the SPI interrupt once the last byte
+ *            is out
+ *    @param  arg Passed to callback
+ *    @return true if queued (or written)
+ */
+bool Adafruit_SPIDevice::writeAsync(const uint8_t *buffer, size_t len,
+                                    busio_spi_callback_t callback, void *arg) {
+  return transferAsync(buffer, nullptr, len, callback, arg);
+}
+
+/*!
+ *    @brief  Queue a full-duplex transfer by DMA and return at once; see
+ *            writeAsync(). read_buffer holds the received bytes once the
+ *            callback ran or dmaBusy() is false.
+ *    @param  write_buffer Data to write
+ *    @param  read_buffer Buffer to read into, or nullptr to discard; a
+ *            word-aligned one whose len is a multiple of 4 is received in
+ *            place, any other through a bounce buffer of the driver
+ *    @param  len Number of bytes
+ *    @param  callback Optional, runs in the SPI interrupt when done
+ *    @param  arg Passed to callback
+ *    @return true if queued (or transferred)
+ */
+bool Adafruit_SPIDevice::transferAsync(const uint8_t *write_buffer,
+                                       uint8_t *read_buffer, size_t len,
+                                       busio_spi_callback_t callback,
+                                       void *arg) {
+  if (!_dmaDevice) {
+    if (read_buffer) {
+      if (read_buffer != write_buffer)
+        memcpy(read_buffer, write_buffer, len);
+      write_and_read(read_buffer, len);
+    } else {
+      write(write_buffer, len);
+    }
+    if (callback)
+      callback(arg);
+    return true;
+  }
+  if (len == 0) {
+    if (callback)
+      callback(arg);
+    return true;
+  }
+  return queueDMA(write_buffer, read_buffer, len, callback, arg);
+}
+
+bool Adafruit_SPIDevice::queueDMA(const uint8_t *write_buffer,
+                                  uint8_t *read_buffer, size_t len,
+                                  busio_spi_callback_t callback, void *arg) {
+  bool first = true;
+  while (len) {
+    size_t chunk = min(len, (size_t)BUSIO_SPI_DMA_MAX);
+    if (_dmaQueued >= BUSIO_SPI_DMA_QUEUE)
+      dmaReap(); // frees the oldest slot, which is _dmaNext
+    DMASlot *slot = &_dmaSlots[_dmaNext];
+    memset(&slot->trans, 0, sizeof(slot->trans));
+    slot->trans.length = chunk * 8;
+    slot->trans.rxlength = read_buffer ? chunk * 8 : 0;
+    slot->trans.tx_buffer = write_buffer;
+    slot->trans.rx_buffer = read_buffer;
+    slot->trans.user = slot;
+    slot->device = this;
+    slot->first = first;
+    slot->last = chunk == len;
+    slot->callback = slot->last ? callback : nullptr;
+    slot->arg = arg;
+    _dmaIssued++;
+    if (spi_device_queue_trans(_dmaDevice, &slot->trans, portMAX_DELAY) !=
+        ESP_OK) {
+      _dmaIssued--;
+      if (!first)
+        setChipSelect(HIGH); // queued chunks already asserted it
+      dmaWait();
+      return false;
+    }
+    _dmaNext = (_dmaNext + 1) % BUSIO_SPI_DMA_QUEUE;
+    _dmaQueued++;
+    write_buffer += chunk;
+    if (read_buffer)
+      read_buffer += chunk;
+    len -= chunk;
+    first = false;
+  }
+  return true;
+}
+
+// Collect the oldest finished transfer (the driver completes them in order)
+void Adafruit_SPIDevice::dmaReap(void) {
+  spi_transaction_t *t;
+  if (spi_device_get_trans_result(_dmaDevice, &t, portMAX_DELAY) == ESP_OK)
+    _dmaQueued--;
+}
+
+/*!
+ *    @brief  Block until every queued asynchronous transfer has completed.
+ *            Blocking calls (write(), read(), ...) do this themselves.
+ */
+void Adafruit_SPIDevice::dmaWait(void) {
+  while (_dmaQueued)
+    dmaReap();
+}
+
+// Driver callbacks, in the SPI interrupt; the slot tells which device and
+// whether this chunk opens or closes the transfer. The one-byte register
+// restore of initDMA() has no slot and leaves CS alone.
+void IRAM_ATTR Adafruit_SPIDevice::dmaStart(spi_transaction_t *t) {
+  DMASlot *slot = (DMASlot *)t->user;
+  if (slot && slot->first && slot->device->_cs != -1)
+    gpio_set_level((gpio_num_t)slot->device->_cs, 0);
+}
+
+void IRAM_ATTR Adafruit_SPIDevice::dmaDone(spi_transaction_t *t) {
+  DMASlot *slot = (DMASlot *)t->user;
+  if (!slot)
+    return;
+  Adafruit_SPIDevice *dev = slot->device;
+  if (slot->last && dev->_cs != -1)
+    gpio_set_level((gpio_num_t)dev->_cs, 1);
+  dev->_dmaFinished = dev->_dmaFinished + 1;
+  if (slot->callback)
+    slot->callback(slot->arg);
+}
+
+#endif // BUSIO_SPI_ASYNC
@@ -91,6 +91,37 @@ typedef uint32_t BusIO_PortMask;
 #undef BUSIO_USE_FAST_PINIO
 #endif
 
+// On ESP32, defining BUSIO_SPI_DMA adds writeAsync() / transferAsync(): the
+// buffer is queued to the IDF SPI master driver and sent by DMA while the
+// caller carries on, with an optional completion callback. The Arduino
+// driver keeps the pins and every blocking transfer; initDMA() attaches the
+// IDF to the same host.
+#if defined(ESP32) && defined(BUSIO_SPI_DMA) && defined(BUSIO_HAS_HW_SPI)
+#include <driver/gpio.h>
+#include <driver/spi_master.h>
+#define BUSIO_SPI_ASYNC
+#if !defined(BUSIO_SPI_DMA_HOST)
+#if defined(CONFIG_IDF_TARGET_ESP32)
+#define BUSIO_SPI_DMA_HOST SPI3_HOST ///< VSPI, the host behind the SPI object
+#else
+#define BUSIO_SPI_DMA_HOST SPI2_HOST ///< FSPI, the host behind the SPI object
+#endif
+#endif
+#if !defined(BUSIO_SPI_DMA_QUEUE)
+#define BUSIO_SPI_DMA_QUEUE 4 ///< Transfers in flight per device
+#endif
+#if !defined(BUSIO_SPI_DMA_MAX)
+#define BUSIO_SPI_DMA_MAX 4092 ///< Bytes per DMA transfer; longer ones split
+#endif
+
+/*!
+ * @brief Completion callback of an asynchronous transfer. Runs in the SPI
+ * interrupt: it must be IRAM_ATTR, short, and use only ISR-safe calls
+ * (e.g. xSemaphoreGiveFromISR, vTaskNotifyGiveFromISR).
+ */
+typedef void (*busio_spi_callback_t)(void *arg);
+#endif
+
 /**! The class which defines how we will talk to this device over SPI **/
 class Adafruit_SPIDevice {
 public:
@@ -125,6 +156,20 @@ public:
   void beginTransactionWithAssertingCS();
   void endTransactionWithDeassertingCS();
 
+#ifdef BUSIO_SPI_ASYNC
+  bool initDMA(spi_host_device_t host = BUSIO_SPI_DMA_HOST);
+  bool writeAsync(const uint8_t *buffer, size_t len,
+                  busio_spi_callback_t callback = nullptr,
+                  void *arg = nullptr);
+  bool transferAsync(const uint8_t *write_buffer, uint8_t *read_buffer,
+                     size_t len, busio_spi_callback_t callback = nullptr,
+                     void *arg = nullptr);
+  void dmaWait(void);
+  /*!   @brief  Whether an asynchronous transfer is still on the wire
+   *    @return true until the last queued one has completed */
+  bool dmaBusy(void) const { return _dmaIssued != _dmaFinished; }
+#endif
+
 private:
 #ifdef BUSIO_HAS_HW_SPI
   SPIClass *_spi = nullptr;
@@ -144,6 +189,29 @@ private:
   BusIO_PortMask mosiPinMask, misoPinMask, clkPinMask, csPinMask;
 #endif
   bool _begun;
+
+#ifdef BUSIO_SPI_ASYNC
+  /// One queued DMA transfer (or chunk of a longer one)
+  struct DMASlot {
+    spi_transaction_t trans;
+    Adafruit_SPIDevice *device;
+    busio_spi_callback_t callback; ///< Set on the last chunk only
+    void *arg;
+    bool first, last; ///< Chunk asserts / releases CS
+  };
+  bool queueDMA(const uint8_t *write_buffer, uint8_t *read_buffer, size_t len,
+                busio_spi_callback_t callback, void *arg);
+  void dmaReap(void);
+  static void dmaStart(spi_transaction_t *t);
+  static void dmaDone(spi_transaction_t *t);
+
+  spi_device_handle_t _dmaDevice = nullptr; ///< IDF device, null if no DMA
+  DMASlot _dmaSlots[BUSIO_SPI_DMA_QUEUE];
+  uint8_t _dmaNext = 0;               ///< Slot the next chunk goes in
+  uint8_t _dmaQueued = 0;             ///< Chunks with unread results
+  uint8_t _dmaIssued = 0;             ///< Chunks queued, ever (wraps)
+  volatile uint8_t _dmaFinished = 0;  ///< Chunks done, ever (wraps)
+#endif
 };
 
 #endif // Adafruit_SPIDevice_h
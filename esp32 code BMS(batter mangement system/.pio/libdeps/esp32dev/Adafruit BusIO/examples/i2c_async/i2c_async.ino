@@ -0,0 +1,51 @@
+// Overlap an I2C register read with other work (ESP32 only)
+#include <Adafruit_I2CQueue.h>
+
+#define I2C_ADDRESS 0x60
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS);
+Adafruit_I2CQueue bus;
+
+Adafruit_I2CTransaction transaction = {};
+uint8_t reg = 0x0C;
+uint8_t buffer[2];
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C async queue test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+  bus.begin();
+  // A binary semaphore turns the descriptor into a future for wait()
+  transaction.done = xSemaphoreCreateBinary();
+}
+
+void loop() {
+  bus.write_then_read(&transaction, &i2c_dev, &reg, 1, buffer, 2);
+
+  // ... the transfer runs on the bus task while this one keeps going ...
+  uint32_t spins = 0;
+  while (transaction.status == BUSIO_I2C_PENDING) {
+    spins++;
+  }
+
+  if (Adafruit_I2CQueue::wait(&transaction)) {
+    Serial.print("Read 0x");
+    Serial.print(buffer[0], HEX);
+    Serial.print(", 0x");
+    Serial.print(buffer[1], HEX);
+  } else {
+    Serial.print("Failed");
+  }
+  Serial.print(" after ");
+  Serial.print(spins);
+  Serial.println(" iterations of other work");
+  delay(1000);
+}
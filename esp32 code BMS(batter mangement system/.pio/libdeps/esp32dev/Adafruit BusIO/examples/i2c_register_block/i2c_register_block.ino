@@ -0,0 +1,43 @@
+// Reads the three acceleration axes of a LIS3DH (OUT_X_L..OUT_Z_H) in one
+// I2C transaction with Adafruit_BusIO_RegisterBlock
+#include <Adafruit_BusIO_RegisterBlock.h>
+#include <Adafruit_I2CDevice.h>
+
+#define I2C_ADDRESS 0x18
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS);
+
+// 0x28 is OUT_X_L; bit 7 makes the register pointer auto-increment
+Adafruit_BusIO_RegisterBlock<6> accel(&i2c_dev, 0x28 | 0x80);
+typedef Adafruit_BusIO_BlockField<0, 2, LSBFIRST> AccelX;
+typedef Adafruit_BusIO_BlockField<2, 2, LSBFIRST> AccelY;
+typedef Adafruit_BusIO_BlockField<4, 2, LSBFIRST> AccelZ;
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C register block test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+
+  // CTRL_REG1: 100 Hz, all axes enabled
+  Adafruit_BusIO_Register ctrl1 = Adafruit_BusIO_Register(&i2c_dev, 0x20);
+  ctrl1.write(0x57);
+}
+
+void loop() {
+  if (accel.read()) {
+    Serial.print(accel.getSigned<AccelX>());
+    Serial.print(", ");
+    Serial.print(accel.getSigned<AccelY>());
+    Serial.print(", ");
+    Serial.println(accel.getSigned<AccelZ>());
+  }
+  delay(100);
+}
@@ -0,0 +1,49 @@
+// Configures the bitfields of an INA219 config register with one read and
+// one write, using write-back caching on Adafruit_BusIO_Register
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_I2CDevice.h>
+
+#define I2C_ADDRESS 0x40
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS);
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C write-back register test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+
+  Adafruit_BusIO_Register config =
+      Adafruit_BusIO_Register(&i2c_dev, 0x00, 2, MSBFIRST);
+  Adafruit_BusIO_RegisterBits range =
+      Adafruit_BusIO_RegisterBits(&config, 1, 13);
+  Adafruit_BusIO_RegisterBits gain = Adafruit_BusIO_RegisterBits(&config, 2, 11);
+  Adafruit_BusIO_RegisterBits bus_adc =
+      Adafruit_BusIO_RegisterBits(&config, 4, 7);
+  Adafruit_BusIO_RegisterBits shunt_adc =
+      Adafruit_BusIO_RegisterBits(&config, 4, 3);
+
+  config.setWriteBack(true);
+  range.write(0);       // 16 V
+  gain.write(1);        // +-80 mV
+  bus_adc.write(0x3);   // 12 bit
+  shunt_adc.write(0xB); // 8 samples averaged
+  Serial.print("Cached config = 0x");
+  Serial.println(config.readCached(), HEX);
+
+  if (!config.flush()) {
+    Serial.println("Flush failed");
+  }
+  config.invalidate();
+  Serial.print("Config read back = 0x");
+  Serial.println(config.read(), HEX);
+}
+
+void loop() {}
@@ -0,0 +1,87 @@
+// Poll several Modbus RTU BMS boards on one RS-485 bus without blocking
+// (ESP32 only). Reads of the same board are merged into one request.
+#include <Adafruit_ModbusQueue.h>
+
+#define RS485_UART UART_NUM_2
+#define RS485_TX 17
+#define RS485_RX 16
+#define RS485_DE 4 // driver enable; the transceiver's RE tied to it
+#define BOARDS 4
+
+QueueHandle_t uart_events;
+
+// Non-blocking transport over the IDF UART driver
+bool uart_read(void *, uint8_t *buffer, size_t len) {
+  return uart_read_bytes(RS485_UART, buffer, len, 0) == (int)len;
+}
+
+bool uart_write(void *, const uint8_t *buffer, size_t len) {
+  return uart_write_bytes(RS485_UART, (const char *)buffer, len) == (int)len;
+}
+
+Adafruit_GenericDevice rs485(nullptr, uart_read, uart_write);
+Adafruit_ModbusQueue *bus;
+
+// Per board: cell voltages at 0..15 and the pack status at 16..19, which
+// the queue reads as one request of 20 registers
+Adafruit_ModbusRead cells[BOARDS], status[BOARDS];
+uint16_t cell_mV[BOARDS][16], pack[BOARDS][4];
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("Modbus async queue test");
+
+  uart_config_t config = {};
+  config.baud_rate = 9600;
+  config.data_bits = UART_DATA_8_BITS;
+  config.parity = UART_PARITY_DISABLE;
+  config.stop_bits = UART_STOP_BITS_1;
+  config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  config.source_clk = UART_SCLK_APB;
+  uart_driver_install(RS485_UART, 512, 0, 16, &uart_events, 0);
+  uart_param_config(RS485_UART, &config);
+  uart_set_pin(RS485_UART, RS485_TX, RS485_RX, RS485_DE, UART_PIN_NO_CHANGE);
+  uart_set_mode(RS485_UART, UART_MODE_RS485_HALF_DUPLEX);
+  uart_set_rx_timeout(RS485_UART, 3); // data events at the end of a frame
+
+  rs485.begin();
+  bus = new Adafruit_ModbusQueue(&rs485, RS485_UART, uart_events);
+  bus->begin();
+  for (int b = 0; b < BOARDS; b++) {
+    cells[b].done = xSemaphoreCreateBinary();
+    status[b].done = xSemaphoreCreateBinary();
+  }
+}
+
+void loop() {
+  uint32_t start = millis();
+  for (int b = 0; b < BOARDS; b++) {
+    bus->read(&cells[b], b + 1, 0, 16, cell_mV[b]);
+    bus->read(&status[b], b + 1, 16, 4, pack[b]);
+  }
+
+  // ... the requests run on the bus task while this one keeps going ...
+
+  for (int b = 0; b < BOARDS; b++) {
+    bool ok = Adafruit_ModbusQueue::wait(&cells[b]) &
+              Adafruit_ModbusQueue::wait(&status[b]);
+    Serial.print("Board ");
+    Serial.print(b + 1);
+    if (ok) {
+      Serial.print(": cell 1 ");
+      Serial.print(cell_mV[b][0]);
+      Serial.print(" mV, status 0x");
+      Serial.println(pack[b][0], HEX);
+    } else {
+      Serial.print(" failed, status ");
+      Serial.println(cells[b].status);
+    }
+  }
+  Serial.print(bus->reads());
+  Serial.print(" reads in ");
+  Serial.print(bus->requests());
+  Serial.print(" requests; this poll took ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+  delay(1000);
+}
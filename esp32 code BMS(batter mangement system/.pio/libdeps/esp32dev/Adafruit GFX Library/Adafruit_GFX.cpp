@@ -90,6 +90,10 @@ inline uint8_t *pgm_read_bitmap_ptr(const GFXfont *gfxFont) {
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 #endif
 
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
 #ifndef _swap_int16_t
 #define _swap_int16_t(a, b)                                                    \
   {                                                                            \
@@ -117,6 +121,7 @@ Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {
   wrap = true;
   _cp437 = false;
   gfxFont = NULL;
+  resetClipRect();
 }
 
 /**************************************************************************/
@@ -134,6 +139,8 @@ void Adafruit_GFX::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
 #if defined(ESP8266)
   yield();
 #endif
+  if (clipRejects(min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1)))
+    return;
   int16_t steep = abs(y1 - y0) > abs(x1 - x0);
   if (steep) {
     _swap_int16_t(x0, y0);
@@ -160,9 +167,9 @@ void Adafruit_GFX::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
 
   for (; x0 <= x1; x0++) {
     if (steep) {
-      writePixel(y0, x0, color);
+      clipPixel(y0, x0, color);
     } else {
-      writePixel(x0, y0, color);
+      clipPixel(x0, y0, color);
     }
     err -= dy;
     if (err < 0) {
@@ -317,6 +324,151 @@ void Adafruit_GFX::fillScreen(uint16_t color) {
   fillRect(0, 0, _width, _height, color);
 }
 
+/**************************************************************************/
+/*!
+   @brief    Restrict drawing to a rectangle, intersected with the current
+   clip rectangle and the screen. Lines, shapes, bitmaps and text skip or
+   trim whole spans outside it before rasterizing; drawPixel(),
+   drawFastHLine(), drawFastVLine(), fillRect() and fillScreen() are the
+   display's own primitives and stay unclipped.
+    @param    x   Top left corner x coordinate
+    @param    y   Top left corner y coordinate
+    @param    w   Width in pixels
+    @param    h   Height in pixels
+    @returns  false if GFX_CLIP_DEPTH rectangles are already pushed (the clip
+              is then unchanged)
+*/
+/**************************************************************************/
+bool Adafruit_GFX::pushClipRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (_clipDepth >= GFX_CLIP_DEPTH)
+    return false;
+  int16_t *saved = _clipStack[_clipDepth++];
+  saved[0] = _clipX0;
+  saved[1] = _clipY0;
+  saved[2] = _clipX1;
+  saved[3] = _clipY1;
+  int32_t x1 = (int32_t)x + (w > 0 ? w : 0), y1 = (int32_t)y + (h > 0 ? h : 0);
+  _clipX0 = max(_clipX0, max(x, (int16_t)0));
+  _clipY0 = max(_clipY0, max(y, (int16_t)0));
+  _clipX1 = (int16_t)min((int32_t)_clipX1, min(x1, (int32_t)_width));
+  _clipY1 = (int16_t)min((int32_t)_clipY1, min(y1, (int32_t)_height));
+  return true;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Restore the clip rectangle in effect before the last
+   pushClipRect()
+*/
+/**************************************************************************/
+void Adafruit_GFX::popClipRect(void) {
+  if (!_clipDepth)
+    return;
+  const int16_t *saved = _clipStack[--_clipDepth];
+  _clipX0 = saved[0];
+  _clipY0 = saved[1];
+  _clipX1 = saved[2];
+  _clipY1 = saved[3];
+}
+
+/**************************************************************************/
+/*!
+   @brief    Drop every pushed clip rectangle; also done by setRotation()
+*/
+/**************************************************************************/
+void Adafruit_GFX::resetClipRect(void) {
+  _clipDepth = 0;
+  _clipX0 = _clipY0 = -32768;
+  _clipX1 = _clipY1 = 32767;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Get the current clip rectangle
+    @param    x   Returns the left edge
+    @param    y   Returns the top edge
+    @param    w   Returns the width, 0 if nothing can be drawn
+    @param    h   Returns the height, 0 if nothing can be drawn
+*/
+/**************************************************************************/
+void Adafruit_GFX::getClipRect(int16_t *x, int16_t *y, int16_t *w,
+                               int16_t *h) const {
+  int16_t x0 = max(_clipX0, (int16_t)0), y0 = max(_clipY0, (int16_t)0);
+  int16_t x1 = min(_clipX1, _width), y1 = min(_clipY1, _height);
+  *x = x0;
+  *y = y0;
+  *w = (x1 > x0) ? x1 - x0 : 0;
+  *h = (y1 > y0) ? y1 - y0 : 0;
+}
+
+/**************************************************************************/
+/*!
+   @brief    writeFastHLine() trimmed to the clip rectangle
+    @param    x   Left-most x coordinate
+    @param    y   Left-most y coordinate
+    @param    w   Width in pixels, negative extends left of x
+   @param    color 16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_GFX::clipFastHLine(int16_t x, int16_t y, int16_t w,
+                                 uint16_t color) {
+  if ((y < _clipY0) || (y >= _clipY1))
+    return;
+  int32_t x0 = x, x1 = (int32_t)x + w;
+  if (w < 0) {
+    x0 = x1 + 1;
+    x1 = x + 1;
+  }
+  x0 = max(x0, (int32_t)_clipX0);
+  x1 = min(x1, (int32_t)_clipX1);
+  if (x1 > x0)
+    writeFastHLine(x0, y, x1 - x0, color);
+}
+
+/**************************************************************************/
+/*!
+   @brief    writeFastVLine() trimmed to the clip rectangle
+    @param    x   Top-most x coordinate
+    @param    y   Top-most y coordinate
+    @param    h   Height in pixels, negative extends above y
+   @param    color 16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_GFX::clipFastVLine(int16_t x, int16_t y, int16_t h,
+                                 uint16_t color) {
+  if ((x < _clipX0) || (x >= _clipX1))
+    return;
+  int32_t y0 = y, y1 = (int32_t)y + h;
+  if (h < 0) {
+    y0 = y1 + 1;
+    y1 = y + 1;
+  }
+  y0 = max(y0, (int32_t)_clipY0);
+  y1 = min(y1, (int32_t)_clipY1);
+  if (y1 > y0)
+    writeFastVLine(x, y0, y1 - y0, color);
+}
+
+/**************************************************************************/
+/*!
+   @brief    writeFillRect() trimmed to the clip rectangle
+    @param    x   Top left corner x coordinate
+    @param    y   Top left corner y coordinate
+    @param    w   Width in pixels
+    @param    h   Height in pixels
+   @param    color 16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_GFX::clipFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                uint16_t color) {
+  int32_t x0 = max((int32_t)x, (int32_t)_clipX0);
+  int32_t y0 = max((int32_t)y, (int32_t)_clipY0);
+  int32_t x1 = min((int32_t)x + w, (int32_t)_clipX1);
+  int32_t y1 = min((int32_t)y + h, (int32_t)_clipY1);
+  if ((x1 > x0) && (y1 > y0))
+    writeFillRect(x0, y0, x1 - x0, y1 - y0, color);
+}
+
 /**************************************************************************/
 /*!
    @brief    Draw a line
@@ -333,11 +485,15 @@ void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
   if (x0 == x1) {
     if (y0 > y1)
       _swap_int16_t(y0, y1);
-    drawFastVLine(x0, y0, y1 - y0 + 1, color);
+    startWrite();
+    clipFastVLine(x0, y0, y1 - y0 + 1, color);
+    endWrite();
   } else if (y0 == y1) {
     if (x0 > x1)
       _swap_int16_t(x0, x1);
-    drawFastHLine(x0, y0, x1 - x0 + 1, color);
+    startWrite();
+    clipFastHLine(x0, y0, x1 - x0 + 1, color);
+    endWrite();
   } else {
     startWrite();
     writeLine(x0, y0, x1, y1, color);
@@ -360,6 +516,8 @@ void Adafruit_GFX::drawEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
 #if defined(ESP8266)
   yield();
 #endif
+  if (clipRejects(x0 - rw, y0 - rh, x0 + rw, y0 + rh))
+    return;
   // Bresenham's ellipse algorithm
   int16_t x = 0, y = rh;
   int32_t rw2 = rw * rw, rh2 = rh * rh;
@@ -371,10 +529,10 @@ void Adafruit_GFX::drawEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
 
   // region 1
   while ((twoRh2 * x) < (twoRw2 * y)) {
-    writePixel(x0 + x, y0 + y, color);
-    writePixel(x0 - x, y0 + y, color);
-    writePixel(x0 + x, y0 - y, color);
-    writePixel(x0 - x, y0 - y, color);
+    clipPixel(x0 + x, y0 + y, color);
+    clipPixel(x0 - x, y0 + y, color);
+    clipPixel(x0 + x, y0 - y, color);
+    clipPixel(x0 - x, y0 - y, color);
     x++;
     if (decision < 0) {
       decision += rh2 + (twoRh2 * x);
@@ -388,10 +546,10 @@ void Adafruit_GFX::drawEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
   decision = ((rh2 * (2 * x + 1) * (2 * x + 1)) >> 2) +
              (rw2 * (y - 1) * (y - 1)) - (rw2 * rh2);
   while (y >= 0) {
-    writePixel(x0 + x, y0 + y, color);
-    writePixel(x0 - x, y0 + y, color);
-    writePixel(x0 + x, y0 - y, color);
-    writePixel(x0 - x, y0 - y, color);
+    clipPixel(x0 + x, y0 + y, color);
+    clipPixel(x0 - x, y0 + y, color);
+    clipPixel(x0 + x, y0 - y, color);
+    clipPixel(x0 - x, y0 - y, color);
     y--;
     if (decision > 0) {
       decision += rw2 - (twoRw2 * y);
@@ -419,6 +577,8 @@ void Adafruit_GFX::fillEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
 #if defined(ESP8266)
   yield();
 #endif
+  if (clipRejects(x0 - rw, y0 - rh, x0 + rw, y0 + rh))
+    return;
   // Bresenham's ellipse algorithm
   int16_t x = 0, y = rh;
   int32_t rw2 = rw * rw, rh2 = rh * rh;
@@ -435,8 +595,8 @@ void Adafruit_GFX::fillEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
       decision += rh2 + (twoRh2 * x);
     } else {
       decision += rh2 + (twoRh2 * x) - (twoRw2 * y);
-      drawFastHLine(x0 - (x - 1), y0 + y, 2 * (x - 1) + 1, color);
-      drawFastHLine(x0 - (x - 1), y0 - y, 2 * (x - 1) + 1, color);
+      clipFastHLine(x0 - (x - 1), y0 + y, 2 * (x - 1) + 1, color);
+      clipFastHLine(x0 - (x - 1), y0 - y, 2 * (x - 1) + 1, color);
       y--;
     }
   }
@@ -445,8 +605,8 @@ void Adafruit_GFX::fillEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
   decision = ((rh2 * (2 * x + 1) * (2 * x + 1)) >> 2) +
              (rw2 * (y - 1) * (y - 1)) - (rw2 * rh2);
   while (y >= 0) {
-    drawFastHLine(x0 - x, y0 + y, 2 * x + 1, color);
-    drawFastHLine(x0 - x, y0 - y, 2 * x + 1, color);
+    clipFastHLine(x0 - x, y0 + y, 2 * x + 1, color);
+    clipFastHLine(x0 - x, y0 - y, 2 * x + 1, color);
 
     y--;
     if (decision > 0) {
@@ -460,6 +620,202 @@ void Adafruit_GFX::fillEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
   endWrite();
 }
 
+/**************************************************************************/
+/*!
+   @brief    Half-width of a filled circle's row: the last column whose
+             pixel center lies within half a pixel of the radius
+    @param    r    Radius
+    @param    dy   Row offset from the center, 0 to r
+    @returns  Columns each side of the center
+*/
+/**************************************************************************/
+static uint8_t arcHalfWidth(int16_t r, int16_t dy) {
+  int32_t d2 = (int32_t)r * r + r - (int32_t)dy * dy;
+  int16_t x = (int16_t)sqrtf((float)d2);
+  while ((int32_t)x * x > d2) // float rounding near perfect squares
+    x--;
+  while ((int32_t)(x + 1) * (x + 1) <= d2)
+    x++;
+  return (uint8_t)x;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Narrow a row's column range to the pixels on or clockwise of
+             (after) or counterclockwise of (before) a ray from the center.
+             Both sides of one ray use the same bound, so wedges sharing
+             it tile without gaps or overlap.
+    @param    ux     Ray direction x (screen coordinates, y down)
+    @param    uy     Ray direction y
+    @param    dy     Row offset from the center
+    @param    after  true: keep the ray's clockwise side, false: the other
+    @param    lo     Leftmost column offset, raised
+    @param    hi     Rightmost column offset, lowered
+*/
+/**************************************************************************/
+static void arcClipRay(float ux, float uy, int16_t dy, bool after,
+                       int16_t &lo, int16_t &hi) {
+  // On or clockwise of the ray: ux * dy - uy * dx >= 0
+  if (fabsf(uy) < 1e-6f) {
+    if ((ux * dy >= 0.0f) != after)
+      hi = lo - 1;
+    return;
+  }
+  float t = ux * dy / uy;
+  // Pixels on a diagonal ray land a rounding error either side of it;
+  // snap them onto it so they always go to the clockwise side
+  float n = roundf(t);
+  if (fabsf(t - n) < 1e-3f)
+    t = n;
+  if (t > 32000.0f)
+    t = 32000.0f;
+  else if (t < -32000.0f)
+    t = -32000.0f;
+  if (uy > 0.0f) { // On the ray's side: dx <= t
+    int16_t edge = (int16_t)floorf(t);
+    if (after)
+      hi = min(hi, edge);
+    else
+      lo = max(lo, (int16_t)(edge + 1));
+  } else { // dx >= t
+    int16_t edge = (int16_t)ceilf(t);
+    if (after)
+      lo = max(lo, edge);
+    else
+      hi = min(hi, (int16_t)(edge - 1));
+  }
+}
+
+/**************************************************************************/
+/*!
+   @brief    Direction of a ray from the center. The angle is reduced to
+             [0, 360) first, so one ray reached as 135 and as 495 degrees
+             gives the same bound on both sides.
+    @param    deg   Angle in degrees, clockwise from 12 o'clock
+    @param    ux    Direction x (screen coordinates, y down)
+    @param    uy    Direction y
+*/
+/**************************************************************************/
+static void arcDirection(float deg, float &ux, float &uy) {
+  const float RAD = 0.017453293f;
+  deg -= 360.0f * floorf(deg / 360.0f);
+  ux = sinf(deg * RAD);
+  uy = -cosf(deg * RAD);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Draw a filled arc: the part of a ring between two angles
+    @param    x0         Center-point x coordinate
+    @param    y0         Center-point y coordinate
+    @param    r          Outer radius, at most 254
+    @param    thickness  Ring width in pixels; r or more for a pie slice
+    @param    start      First angle in degrees, clockwise from 12 o'clock
+    @param    end        Angle the arc ends before, at most start + 360
+    @param    color      16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_GFX::fillArc(int16_t x0, int16_t y0, uint8_t r,
+                           uint8_t thickness, float start, float end,
+                           uint16_t color) {
+  if ((r == 0) || (r == GFX_ARC_NONE) || (thickness == 0))
+    return;
+  fillArcSpans(x0, y0, r, thickness, NULL, NULL, start, end, color);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Fill the wedge [start, end) of a ring given by its per-row
+             spans. Wider wedges are drawn in pieces below 180 degrees,
+             each the intersection of two half-planes; 360 degrees or more
+             is the whole ring, without rays. Without a hole the center
+             pixel belongs to every wedge.
+    @param    x0     Center-point x coordinate
+    @param    y0     Center-point y coordinate
+    @param    r          Outer radius
+    @param    thickness  Ring width, for rows without a table
+    @param    outer      Outer half-width per row offset 0..r, or NULL to
+                         compute each row
+    @param    inner      Hole half-width per row offset, GFX_ARC_NONE if
+                         none, or NULL
+    @param    start      First angle in degrees, clockwise from 12 o'clock
+    @param    end        Angle the wedge ends before
+    @param    color      16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_GFX::fillArcSpans(int16_t x0, int16_t y0, uint8_t r,
+                                uint8_t thickness, const uint8_t *outer,
+                                const uint8_t *inner, float start, float end,
+                                uint16_t color) {
+  if (!(end > start) || clipRejects(x0 - r, y0 - r, x0 + r, y0 + r))
+    return;
+  bool full = !(end < start + 360.0f);
+  if (full)
+    end = start + 360.0f;
+  int16_t ri = (int16_t)r - thickness; // Hole radius, none if <= 0
+  uint8_t pieces = full ? 1 : (uint8_t)ceilf((end - start) / 120.0f);
+  float step = (end - start) / pieces;
+  float a = start, ax, ay;
+  arcDirection(a, ax, ay);
+
+  startWrite();
+  for (uint8_t k = 0; k < pieces; k++) {
+    float b = (k + 1 == pieces) ? end : start + step * (k + 1);
+    float bx, by;
+    arcDirection(b, bx, by);
+    // Rows the piece can reach: its edge rays, the center, and the top or
+    // bottom of the ring when it passes 12 or 6 o'clock
+    float ylo = min(0.0f, min(ay, by)) * (r + 1);
+    float yhi = max(0.0f, max(ay, by)) * (r + 1);
+    if (floorf(b / 360.0f) > floorf(a / 360.0f))
+      ylo = -r;
+    if (floorf((b - 180.0f) / 360.0f) > floorf((a - 180.0f) / 360.0f))
+      yhi = r;
+    if (full) {
+      ylo = -r;
+      yhi = r;
+    }
+    int16_t dy0 = max((int16_t)floorf(ylo), (int16_t)-r);
+    int16_t dy1 = min((int16_t)ceilf(yhi), (int16_t)r);
+    for (int16_t dy = dy0; dy <= dy1; dy++) {
+      uint8_t row = (uint8_t)abs(dy);
+      int16_t half = outer ? outer[row] : arcHalfWidth(r, row);
+      int16_t hole = GFX_ARC_NONE;
+      if (inner)
+        hole = inner[row];
+      else if ((ri > 0) && (row <= ri))
+        hole = arcHalfWidth(ri, row);
+      int16_t lo = -half, hi = half;
+      if (!full) {
+        arcClipRay(ax, ay, dy, true, lo, hi);
+        arcClipRay(bx, by, dy, false, lo, hi);
+      }
+      if (lo > hi)
+        continue;
+      if (hole == GFX_ARC_NONE) {
+        clipFastHLine(x0 + lo, y0 + dy, hi - lo + 1, color);
+        continue;
+      }
+      if (lo < -hole)
+        clipFastHLine(x0 + lo, y0 + dy, min(hi, (int16_t)(-hole - 1)) - lo + 1,
+                      color);
+      if (hi > hole) {
+        int16_t l = max(lo, (int16_t)(hole + 1));
+        clipFastHLine(x0 + l, y0 + dy, hi - l + 1, color);
+      }
+    }
+    a = b;
+    ax = bx;
+    ay = by;
+  }
+  // Every ray keeps the center on its clockwise side only, so no piece
+  // reaches it: a pie slice adds it here
+  bool hole0 = inner ? (inner[0] != GFX_ARC_NONE) : (ri > 0);
+  if (!full && !hole0)
+    clipPixel(x0, y0, color);
+  endWrite();
+}
+
 /**************************************************************************/
 /*!
    @brief    Draw a circle outline
@@ -474,6 +830,8 @@ void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r,
 #if defined(ESP8266)
   yield();
 #endif
+  if (clipRejects(x0 - r, y0 - r, x0 + r, y0 + r))
+    return;
   int16_t f = 1 - r;
   int16_t ddF_x = 1;
   int16_t ddF_y = -2 * r;
@@ -481,10 +839,10 @@ void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r,
   int16_t y = r;
 
   startWrite();
-  writePixel(x0, y0 + r, color);
-  writePixel(x0, y0 - r, color);
-  writePixel(x0 + r, y0, color);
-  writePixel(x0 - r, y0, color);
+  clipPixel(x0, y0 + r, color);
+  clipPixel(x0, y0 - r, color);
+  clipPixel(x0 + r, y0, color);
+  clipPixel(x0 - r, y0, color);
 
   while (x < y) {
     if (f >= 0) {
@@ -496,14 +854,14 @@ void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r,
     ddF_x += 2;
     f += ddF_x;
 
-    writePixel(x0 + x, y0 + y, color);
-    writePixel(x0 - x, y0 + y, color);
-    writePixel(x0 + x, y0 - y, color);
-    writePixel(x0 - x, y0 - y, color);
-    writePixel(x0 + y, y0 + x, color);
-    writePixel(x0 - y, y0 + x, color);
-    writePixel(x0 + y, y0 - x, color);
-    writePixel(x0 - y, y0 - x, color);
+    clipPixel(x0 + x, y0 + y, color);
+    clipPixel(x0 - x, y0 + y, color);
+    clipPixel(x0 + x, y0 - y, color);
+    clipPixel(x0 - x, y0 - y, color);
+    clipPixel(x0 + y, y0 + x, color);
+    clipPixel(x0 - y, y0 + x, color);
+    clipPixel(x0 + y, y0 - x, color);
+    clipPixel(x0 - y, y0 - x, color);
   }
   endWrite();
 }
@@ -537,20 +895,20 @@ void Adafruit_GFX::drawCircleHelper(int16_t x0, int16_t y0, int16_t r,
     ddF_x += 2;
     f += ddF_x;
     if (cornername & 0x4) {
-      writePixel(x0 + x, y0 + y, color);
-      writePixel(x0 + y, y0 + x, color);
+      clipPixel(x0 + x, y0 + y, color);
+      clipPixel(x0 + y, y0 + x, color);
     }
     if (cornername & 0x2) {
-      writePixel(x0 + x, y0 - y, color);
-      writePixel(x0 + y, y0 - x, color);
+      clipPixel(x0 + x, y0 - y, color);
+      clipPixel(x0 + y, y0 - x, color);
     }
     if (cornername & 0x8) {
-      writePixel(x0 - y, y0 + x, color);
-      writePixel(x0 - x, y0 + y, color);
+      clipPixel(x0 - y, y0 + x, color);
+      clipPixel(x0 - x, y0 + y, color);
     }
     if (cornername & 0x1) {
-      writePixel(x0 - y, y0 - x, color);
-      writePixel(x0 - x, y0 - y, color);
+      clipPixel(x0 - y, y0 - x, color);
+      clipPixel(x0 - x, y0 - y, color);
     }
   }
 }
@@ -566,8 +924,10 @@ void Adafruit_GFX::drawCircleHelper(int16_t x0, int16_t y0, int16_t r,
 /**************************************************************************/
 void Adafruit_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r,
                               uint16_t color) {
+  if (clipRejects(x0 - r, y0 - r, x0 + r, y0 + r))
+    return;
   startWrite();
-  writeFastVLine(x0, y0 - r, 2 * r + 1, color);
+  clipFastVLine(x0, y0 - r, 2 * r + 1, color);
   fillCircleHelper(x0, y0, r, 3, 0, color);
   endWrite();
 }
@@ -611,15 +971,15 @@ void Adafruit_GFX::fillCircleHelper(int16_t x0, int16_t y0, int16_t r,
     // for the SSD1306 library which has an INVERT drawing mode.
     if (x < (y + 1)) {
       if (corners & 1)
-        writeFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+        clipFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
       if (corners & 2)
-        writeFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+        clipFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
     }
     if (y != py) {
       if (corners & 1)
-        writeFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+        clipFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
       if (corners & 2)
-        writeFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+        clipFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
       py = y;
     }
     px = x;
@@ -639,10 +999,10 @@ void Adafruit_GFX::fillCircleHelper(int16_t x0, int16_t y0, int16_t r,
 void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
                             uint16_t color) {
   startWrite();
-  writeFastHLine(x, y, w, color);
-  writeFastHLine(x, y + h - 1, w, color);
-  writeFastVLine(x, y, h, color);
-  writeFastVLine(x + w - 1, y, h, color);
+  clipFastHLine(x, y, w, color);
+  clipFastHLine(x, y + h - 1, w, color);
+  clipFastVLine(x, y, h, color);
+  clipFastVLine(x + w - 1, y, h, color);
   endWrite();
 }
 
@@ -659,15 +1019,17 @@ void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
 /**************************************************************************/
 void Adafruit_GFX::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
                                  int16_t r, uint16_t color) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   int16_t max_radius = ((w < h) ? w : h) / 2; // 1/2 minor axis
   if (r > max_radius)
     r = max_radius;
   // smarter version
   startWrite();
-  writeFastHLine(x + r, y, w - 2 * r, color);         // Top
-  writeFastHLine(x + r, y + h - 1, w - 2 * r, color); // Bottom
-  writeFastVLine(x, y + r, h - 2 * r, color);         // Left
-  writeFastVLine(x + w - 1, y + r, h - 2 * r, color); // Right
+  clipFastHLine(x + r, y, w - 2 * r, color);         // Top
+  clipFastHLine(x + r, y + h - 1, w - 2 * r, color); // Bottom
+  clipFastVLine(x, y + r, h - 2 * r, color);         // Left
+  clipFastVLine(x + w - 1, y + r, h - 2 * r, color); // Right
   // draw four corners
   drawCircleHelper(x + r, y + r, r, 1, color);
   drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
@@ -689,12 +1051,14 @@ void Adafruit_GFX::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
 /**************************************************************************/
 void Adafruit_GFX::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
                                  int16_t r, uint16_t color) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   int16_t max_radius = ((w < h) ? w : h) / 2; // 1/2 minor axis
   if (r > max_radius)
     r = max_radius;
   // smarter version
   startWrite();
-  writeFillRect(x + r, y, w - 2 * r, h, color);
+  clipFillRect(x + r, y, w - 2 * r, h, color);
   // draw four corners
   fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, color);
   fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, color);
@@ -751,6 +1115,9 @@ void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
     _swap_int16_t(x0, x1);
   }
 
+  if (clipRejects(min(x0, min(x1, x2)), y0, max(x0, max(x1, x2)), y2))
+    return;
+
   startWrite();
   if (y0 == y2) { // Handle awkward all-on-same-line case as its own thing
     a = b = x0;
@@ -762,7 +1129,7 @@ void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
       a = x2;
     else if (x2 > b)
       b = x2;
-    writeFastHLine(a, y0, b - a + 1, color);
+    clipFastHLine(a, y0, b - a + 1, color);
     endWrite();
     return;
   }
@@ -793,7 +1160,7 @@ void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
     */
     if (a > b)
       _swap_int16_t(a, b);
-    writeFastHLine(a, y, b - a + 1, color);
+    clipFastHLine(a, y, b - a + 1, color);
   }
 
   // For lower part of triangle, find scanline crossings for segments
@@ -811,13 +1178,63 @@ void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
     */
     if (a > b)
       _swap_int16_t(a, b);
-    writeFastHLine(a, y, b - a + 1, color);
+    clipFastHLine(a, y, b - a + 1, color);
   }
   endWrite();
 }
 
 // BITMAP / XBITMAP / GRAYSCALE / RGB BITMAP FUNCTIONS ---------------------
 
+/**************************************************************************/
+/*!
+   @brief   Fast path for the 1-bit drawBitmap()/drawXBitmap() variants.
+            Subclasses with a 1-bit framebuffer override this to combine
+            whole bytes of the image with their buffer; the default declines
+            and the caller falls back to one writePixel() per pixel.
+    @param    x       Top left corner x coordinate
+    @param    y       Top left corner y coordinate
+    @param    bitmap  Row-major image, each row padded to a whole byte
+    @param    w       Width of bitmap in pixels
+    @param    h       Height of bitmap in pixels
+    @param    color   Color of set bits
+    @param    bg      Color of unset bits, with GFX_BLIT_OPAQUE
+    @param    flags   GFX_BLIT_PROGMEM, GFX_BLIT_XBM, GFX_BLIT_OPAQUE
+    @returns  true if the image was drawn, false to use the generic path
+*/
+/**************************************************************************/
+bool Adafruit_GFX::blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+                              int16_t w, int16_t h, uint16_t color,
+                              uint16_t bg, uint8_t flags) {
+  (void)x;
+  (void)y;
+  (void)bitmap;
+  (void)w;
+  (void)h;
+  (void)color;
+  (void)bg;
+  (void)flags;
+  return false;
+}
+
+/**************************************************************************/
+/*!
+   @brief   Read one byte of a blitBitmap() source image, leftmost pixel in
+            the MSB whatever the source bit order
+    @param    p       Byte to read
+    @param    flags   blitBitmap() flags (GFX_BLIT_PROGMEM, GFX_BLIT_XBM)
+    @returns  The 8 pixels, MSB first
+*/
+/**************************************************************************/
+uint8_t Adafruit_GFX::bitmapByte(const uint8_t *p, uint8_t flags) {
+  uint8_t b = (flags & GFX_BLIT_PROGMEM) ? pgm_read_byte(p) : *p;
+  if (flags & GFX_BLIT_XBM) { // Reverse the bit order
+    b = (uint8_t)((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+    b = (uint8_t)((b & 0xCC) >> 2 | (b & 0x33) << 2);
+    b = (uint8_t)((b & 0xAA) >> 1 | (b & 0x55) << 1);
+  }
+  return b;
+}
+
 /**************************************************************************/
 /*!
    @brief      Draw a PROGMEM-resident 1-bit image at the specified (x,y)
@@ -832,6 +1249,12 @@ void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
 /**************************************************************************/
 void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
                               int16_t w, int16_t h, uint16_t color) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
+
+  if (clipContains(x, y, x + w - 1, y + h - 1) &&
+      blitBitmap(x, y, bitmap, w, h, color, color, GFX_BLIT_PROGMEM))
+    return;
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t b = 0;
@@ -844,7 +1267,7 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
       else
         b = pgm_read_byte(&bitmap[j * byteWidth + i / 8]);
       if (b & 0x80)
-        writePixel(x + i, y, color);
+        clipPixel(x + i, y, color);
     }
   }
   endWrite();
@@ -867,6 +1290,13 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
 void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
                               int16_t w, int16_t h, uint16_t color,
                               uint16_t bg) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
+
+  if (clipContains(x, y, x + w - 1, y + h - 1) &&
+      blitBitmap(x, y, bitmap, w, h, color, bg,
+                 GFX_BLIT_PROGMEM | GFX_BLIT_OPAQUE))
+    return;
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t b = 0;
@@ -878,7 +1308,7 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
         b <<= 1;
       else
         b = pgm_read_byte(&bitmap[j * byteWidth + i / 8]);
-      writePixel(x + i, y, (b & 0x80) ? color : bg);
+      clipPixel(x + i, y, (b & 0x80) ? color : bg);
     }
   }
   endWrite();
@@ -898,6 +1328,12 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
 /**************************************************************************/
 void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
                               int16_t h, uint16_t color) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
+
+  if (clipContains(x, y, x + w - 1, y + h - 1) &&
+      blitBitmap(x, y, bitmap, w, h, color, color, 0))
+    return;
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t b = 0;
@@ -910,7 +1346,7 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
       else
         b = bitmap[j * byteWidth + i / 8];
       if (b & 0x80)
-        writePixel(x + i, y, color);
+        clipPixel(x + i, y, color);
     }
   }
   endWrite();
@@ -932,6 +1368,12 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
 /**************************************************************************/
 void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
                               int16_t h, uint16_t color, uint16_t bg) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
+
+  if (clipContains(x, y, x + w - 1, y + h - 1) &&
+      blitBitmap(x, y, bitmap, w, h, color, bg, GFX_BLIT_OPAQUE))
+    return;
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t b = 0;
@@ -943,7 +1385,7 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
         b <<= 1;
       else
         b = bitmap[j * byteWidth + i / 8];
-      writePixel(x + i, y, (b & 0x80) ? color : bg);
+      clipPixel(x + i, y, (b & 0x80) ? color : bg);
     }
   }
   endWrite();
@@ -966,6 +1408,13 @@ void Adafruit_GFX::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w,
 /**************************************************************************/
 void Adafruit_GFX::drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
                                int16_t w, int16_t h, uint16_t color) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
+
+  if (clipContains(x, y, x + w - 1, y + h - 1) &&
+      blitBitmap(x, y, bitmap, w, h, color, color,
+                 GFX_BLIT_PROGMEM | GFX_BLIT_XBM))
+    return;
 
   int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
   uint8_t b = 0;
@@ -980,7 +1429,7 @@ void Adafruit_GFX::drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
       // Nearly identical to drawBitmap(), only the bit order
       // is reversed here (left-to-right = LSB to MSB):
       if (b & 0x01)
-        writePixel(x + i, y, color);
+        clipPixel(x + i, y, color);
     }
   }
   endWrite();
@@ -1001,10 +1450,12 @@ void Adafruit_GFX::drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
 void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y,
                                        const uint8_t bitmap[], int16_t w,
                                        int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   startWrite();
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
-      writePixel(x + i, y, (uint8_t)pgm_read_byte(&bitmap[j * w + i]));
+      clipPixel(x + i, y, (uint8_t)pgm_read_byte(&bitmap[j * w + i]));
     }
   }
   endWrite();
@@ -1024,10 +1475,12 @@ void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y,
 /**************************************************************************/
 void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap,
                                        int16_t w, int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   startWrite();
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
-      writePixel(x + i, y, bitmap[j * w + i]);
+      clipPixel(x + i, y, bitmap[j * w + i]);
     }
   }
   endWrite();
@@ -1052,6 +1505,8 @@ void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y,
                                        const uint8_t bitmap[],
                                        const uint8_t mask[], int16_t w,
                                        int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t b = 0;
   startWrite();
@@ -1062,7 +1517,7 @@ void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y,
       else
         b = pgm_read_byte(&mask[j * bw + i / 8]);
       if (b & 0x80) {
-        writePixel(x + i, y, (uint8_t)pgm_read_byte(&bitmap[j * w + i]));
+        clipPixel(x + i, y, (uint8_t)pgm_read_byte(&bitmap[j * w + i]));
       }
     }
   }
@@ -1086,6 +1541,8 @@ void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y,
 /**************************************************************************/
 void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap,
                                        uint8_t *mask, int16_t w, int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t b = 0;
   startWrite();
@@ -1096,7 +1553,7 @@ void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap,
       else
         b = mask[j * bw + i / 8];
       if (b & 0x80) {
-        writePixel(x + i, y, bitmap[j * w + i]);
+        clipPixel(x + i, y, bitmap[j * w + i]);
       }
     }
   }
@@ -1116,10 +1573,12 @@ void Adafruit_GFX::drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t *bitmap,
 /**************************************************************************/
 void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[],
                                  int16_t w, int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   startWrite();
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
-      writePixel(x + i, y, pgm_read_word(&bitmap[j * w + i]));
+      clipPixel(x + i, y, pgm_read_word(&bitmap[j * w + i]));
     }
   }
   endWrite();
@@ -1138,10 +1597,12 @@ void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[],
 /**************************************************************************/
 void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap,
                                  int16_t w, int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   startWrite();
   for (int16_t j = 0; j < h; j++, y++) {
     for (int16_t i = 0; i < w; i++) {
-      writePixel(x + i, y, bitmap[j * w + i]);
+      clipPixel(x + i, y, bitmap[j * w + i]);
     }
   }
   endWrite();
@@ -1163,6 +1624,8 @@ void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap,
 /**************************************************************************/
 void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[],
                                  const uint8_t mask[], int16_t w, int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t b = 0;
   startWrite();
@@ -1173,7 +1636,7 @@ void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[],
       else
         b = pgm_read_byte(&mask[j * bw + i / 8]);
       if (b & 0x80) {
-        writePixel(x + i, y, pgm_read_word(&bitmap[j * w + i]));
+        clipPixel(x + i, y, pgm_read_word(&bitmap[j * w + i]));
       }
     }
   }
@@ -1196,6 +1659,8 @@ void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[],
 /**************************************************************************/
 void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap,
                                  uint8_t *mask, int16_t w, int16_t h) {
+  if (clipRejects(x, y, x + w - 1, y + h - 1))
+    return;
   int16_t bw = (w + 7) / 8; // Bitmask scanline pad = whole byte
   uint8_t b = 0;
   startWrite();
@@ -1206,7 +1671,7 @@ void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap,
       else
         b = mask[j * bw + i / 8];
       if (b & 0x80) {
-        writePixel(x + i, y, bitmap[j * w + i]);
+        clipPixel(x + i, y, bitmap[j * w + i]);
       }
     }
   }
@@ -1233,6 +1698,19 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
   drawChar(x, y, c, color, bg, size, size);
 }
 
+/**************************************************************************/
+/*!
+   @brief   One column of a glyph in the 'classic' built-in font, for
+            subclasses that rasterize it themselves (e.g. into a cache)
+    @param    c   Font index, after the CP437 adjustment drawChar() applies
+    @param    col Column 0-5; column 5 is the blank spacing column
+    @returns  Column bits, LSB = top row
+*/
+/**************************************************************************/
+uint8_t Adafruit_GFX::classicGlyphColumn(unsigned char c, uint8_t col) const {
+  return (col < 5) ? pgm_read_byte(&font[c * 5 + col]) : 0;
+}
+
 // Draw a character
 /**************************************************************************/
 /*!
@@ -1258,6 +1736,8 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
         ((x + 6 * size_x - 1) < 0) || // Clip left
         ((y + 8 * size_y - 1) < 0))   // Clip top
       return;
+    if (clipRejects(x, y, x + 6 * size_x - 1, y + 8 * size_y - 1))
+      return;
 
     if (!_cp437 && (c >= 176))
       c++; // Handle 'classic' charset behavior
@@ -1268,23 +1748,23 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
       for (int8_t j = 0; j < 8; j++, line >>= 1) {
         if (line & 1) {
           if (size_x == 1 && size_y == 1)
-            writePixel(x + i, y + j, color);
+            clipPixel(x + i, y + j, color);
           else
-            writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y,
+            clipFillRect(x + i * size_x, y + j * size_y, size_x, size_y,
                           color);
         } else if (bg != color) {
           if (size_x == 1 && size_y == 1)
-            writePixel(x + i, y + j, bg);
+            clipPixel(x + i, y + j, bg);
           else
-            writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, bg);
+            clipFillRect(x + i * size_x, y + j * size_y, size_x, size_y, bg);
         }
       }
     }
     if (bg != color) { // If opaque, draw vertical line for last column
       if (size_x == 1 && size_y == 1)
-        writeFastVLine(x + 5, y, 8, bg);
+        clipFastVLine(x + 5, y, 8, bg);
       else
-        writeFillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
+        clipFillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
     }
     endWrite();
 
@@ -1310,7 +1790,9 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
       yo16 = yo;
     }
 
-    // Todo: Add character clipping here
+    if (clipRejects(x + xo * size_x, y + yo * size_y,
+                    x + (xo + w) * size_x - 1, y + (yo + h) * size_y - 1))
+      return;
 
     // NOTE: THERE IS NO 'BACKGROUND' COLOR OPTION ON CUSTOM FONTS.
     // THIS IS ON PURPOSE AND BY DESIGN.  The background color feature
@@ -1329,20 +1811,59 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
     // implemented this yet.
 
     startWrite();
-    for (yy = 0; yy < h; yy++) {
-      for (xx = 0; xx < w; xx++) {
-        if (!(bit++ & 7)) {
-          bits = pgm_read_byte(&bitmap[bo++]);
+    if (pgm_read_byte(&gfxFont->format) == GFXFONT_RLE) {
+      // Run lengths (see gfxfont.h): each foreground run is drawn as one
+      // span per glyph row it covers, instead of pixel by pixel
+      uint16_t pos = 0, n = (uint16_t)w * h;
+      bool on = false, low = false;
+      while (pos < n) {
+        uint16_t len = 0;
+        uint8_t v;
+        do {
+          if (!low)
+            bits = pgm_read_byte(&bitmap[bo++]);
+          v = low ? (bits & 0x0F) : (bits >> 4);
+          low = !low;
+          len += v;
+        } while (v == 15);
+        if (len > n - pos)
+          len = n - pos;
+        if (on) {
+          yy = pos / w;
+          xx = pos % w;
+          for (uint16_t left = len; left;) {
+            uint8_t span = (left < (uint16_t)(w - xx)) ? left : w - xx;
+            if (size_x == 1 && size_y == 1) {
+              clipFastHLine(x + xo + xx, y + yo + yy, span, color);
+            } else {
+              clipFillRect(x + (xo16 + xx) * size_x,
+                            y + (yo16 + yy) * size_y, span * size_x, size_y,
+                            color);
+            }
+            left -= span;
+            xx = 0;
+            yy++;
+          }
         }
-        if (bits & 0x80) {
-          if (size_x == 1 && size_y == 1) {
-            writePixel(x + xo + xx, y + yo + yy, color);
-          } else {
-            writeFillRect(x + (xo16 + xx) * size_x, y + (yo16 + yy) * size_y,
-                          size_x, size_y, color);
+        pos += len;
+        on = !on;
+      }
+    } else {
+      for (yy = 0; yy < h; yy++) {
+        for (xx = 0; xx < w; xx++) {
+          if (!(bit++ & 7)) {
+            bits = pgm_read_byte(&bitmap[bo++]);
           }
+          if (bits & 0x80) {
+            if (size_x == 1 && size_y == 1) {
+              clipPixel(x + xo + xx, y + yo + yy, color);
+            } else {
+              clipFillRect(x + (xo16 + xx) * size_x, y + (yo16 + yy) * size_y,
+                            size_x, size_y, color);
+            }
+          }
+          bits <<= 1;
         }
-        bits <<= 1;
       }
     }
     endWrite();
@@ -1443,6 +1964,7 @@ void Adafruit_GFX::setRotation(uint8_t x) {
     _height = WIDTH;
     break;
   }
+  resetClipRect();
 }
 
 /**************************************************************************/
@@ -1844,6 +2366,376 @@ bool Adafruit_GFX_Button::justReleased() { return (!currstate && laststate); }
 
 // -------------------------------------------------------------------------
 
+/**************************************************************************/
+/*!
+   @brief    Create a text run anchored at a cursor position. It lays out
+             with whatever font and text size the display has when print()
+             is called.
+   @param    gfx    Display to draw on
+   @param    x      Anchor x: left edge, right edge or center of the run
+   @param    y      Cursor y, as for setCursor() (top of the classic font,
+                    baseline of GFXfonts)
+   @param    align  ALIGN_LEFT, ALIGN_RIGHT or ALIGN_CENTER
+*/
+/**************************************************************************/
+GFXTextRun::GFXTextRun(Adafruit_GFX *gfx, int16_t x, int16_t y, Align align)
+    : _gfx(gfx), _x(x), _y(y), _align(align) {}
+
+/**************************************************************************/
+/*!
+   @brief    Set the text color and the background used to erase replaced
+             glyphs. Changing them repaints the whole run on the next
+             print().
+   @param    color  Text color
+   @param    bg     Background color
+*/
+/**************************************************************************/
+void GFXTextRun::setColors(uint16_t color, uint16_t bg) {
+  if ((color != _color) || (bg != _bg))
+    _redraw = true;
+  _color = color;
+  _bg = bg;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Give every digit the advance of the widest one, centered in it,
+             so numbers keep their width as they change (tabular figures).
+             A no-op for the fixed-pitch classic font.
+   @param    fixed  true for fixed-width digits
+*/
+/**************************************************************************/
+void GFXTextRun::setFixedDigits(bool fixed) {
+  if (fixed != _fixedDigits)
+    _sx = 0; // Force a fresh layout
+  _fixedDigits = fixed;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Forget what is on screen, e.g. after fillScreen(): the next
+             print() draws every glyph without erasing first.
+*/
+/**************************************************************************/
+void GFXTextRun::invalidate(void) { _drawn = false; }
+
+/**************************************************************************/
+/*!
+   @brief    Advance and box of one glyph relative to its cursor position,
+             in the layout's font and size
+   @param    c    Character
+   @param    xa   Advance to the next glyph
+   @param    x1   Left edge
+   @param    y1   Top edge
+   @param    x2   Right edge (x2 < x1: nothing drawn)
+   @param    y2   Bottom edge
+*/
+/**************************************************************************/
+void GFXTextRun::glyphBox(unsigned char c, int16_t *xa, int16_t *x1,
+                          int16_t *y1, int16_t *x2, int16_t *y2) const {
+  *xa = 0;
+  *x1 = *y1 = 0;
+  *x2 = *y2 = -1;
+  if (!_font) {
+    *xa = 6 * _sx;
+    *x2 = 6 * _sx - 1;
+    *y2 = 8 * _sy - 1;
+    return;
+  }
+  uint8_t first = pgm_read_byte(&_font->first),
+          last = pgm_read_byte(&_font->last);
+  if ((c < first) || (c > last))
+    return;
+  GFXglyph *glyph = pgm_read_glyph_ptr(_font, c - first);
+  uint8_t gw = pgm_read_byte(&glyph->width), gh = pgm_read_byte(&glyph->height);
+  int8_t xo = pgm_read_byte(&glyph->xOffset),
+         yo = pgm_read_byte(&glyph->yOffset);
+  *xa = (uint8_t)pgm_read_byte(&glyph->xAdvance) * _sx;
+  if (gw && gh) {
+    *x1 = xo * _sx;
+    *y1 = yo * _sy;
+    *x2 = *x1 + gw * _sx - 1;
+    *y2 = *y1 + gh * _sy - 1;
+  }
+}
+
+/**************************************************************************/
+/*!
+   @brief    Fill the box of glyph i of the current layout with the
+             background color
+   @param    i    Glyph index
+*/
+/**************************************************************************/
+void GFXTextRun::eraseGlyph(uint8_t i) {
+  int16_t xa, x1, y1, x2, y2;
+  glyphBox(_chars[i], &xa, &x1, &y1, &x2, &y2);
+  if (x2 >= x1)
+    _gfx->fillRect(_pos[i] + x1, _y + y1, x2 - x1 + 1, y2 - y1 + 1, _bg);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Lay out a string (one line, at most GFX_TEXTRUN_MAX glyphs) and
+             bring the screen up to date with it: glyphs that keep their
+             character and position are left alone, the others are erased
+             and redrawn, and neighbors overlapping an erased box repainted.
+             A change of font or text size erases the old run and starts
+             over.
+   @param    str  Text to show
+   @returns  true if anything was drawn
+*/
+/**************************************************************************/
+bool GFXTextRun::print(const char *str) {
+  Adafruit_GFX *g = _gfx;
+  if ((_font != g->gfxFont) || (_sx != g->textsize_x) ||
+      (_sy != g->textsize_y)) {
+    if (_drawn && (_maxx >= _minx))
+      g->fillRect(_minx, _miny, _maxx - _minx + 1, _maxy - _miny + 1, _bg);
+    _drawn = false;
+    _font = g->gfxFont;
+    _sx = g->textsize_x;
+    _sy = g->textsize_y;
+    _digitAdvance = 0;
+    for (unsigned char d = '0'; _font && _fixedDigits && d <= '9'; d++) {
+      int16_t xa, x1, y1, x2, y2;
+      glyphBox(d, &xa, &x1, &y1, &x2, &y2);
+      if (xa > _digitAdvance)
+        _digitAdvance = xa;
+    }
+  }
+
+  // Layout: one pass for positions and bounds, then shift by the alignment
+  char chars[GFX_TEXTRUN_MAX];
+  int16_t pos[GFX_TEXTRUN_MAX];
+  uint8_t n = 0;
+  int16_t pen = 0, minx = 0x7FFF, miny = 0x7FFF, maxx = -0x7FFF,
+          maxy = -0x7FFF;
+  for (; str[n] && (n < GFX_TEXTRUN_MAX); n++) {
+    int16_t xa, x1, y1, x2, y2, off = 0;
+    chars[n] = str[n];
+    glyphBox(str[n], &xa, &x1, &y1, &x2, &y2);
+    if (_digitAdvance && (str[n] >= '0') && (str[n] <= '9')) {
+      off = (_digitAdvance - xa) / 2;
+      xa = _digitAdvance;
+    }
+    pos[n] = pen + off;
+    if (x2 >= x1) {
+      if (pos[n] + x1 < minx)
+        minx = pos[n] + x1;
+      if (pos[n] + x2 > maxx)
+        maxx = pos[n] + x2;
+      if (y1 < miny)
+        miny = y1;
+      if (y2 > maxy)
+        maxy = y2;
+    }
+    pen += xa;
+  }
+  int16_t shift = _x - ((_align == ALIGN_RIGHT)    ? pen
+                        : (_align == ALIGN_CENTER) ? pen / 2
+                                                   : 0);
+  for (uint8_t i = 0; i < n; i++)
+    pos[i] += shift;
+
+  // Old glyphs that go away or move get erased...
+  bool changed[GFX_TEXTRUN_MAX];
+  uint8_t most = (n > _count) ? n : _count;
+  bool any = false;
+  for (uint8_t i = 0; i < most; i++) {
+    changed[i] = !_drawn || _redraw || (i >= n) || (i >= _count) ||
+                 (chars[i] != _chars[i]) || (pos[i] != _pos[i]);
+    if (changed[i] && _drawn && (i < _count)) {
+      eraseGlyph(i);
+      any = true;
+    }
+  }
+  // ...and kept glyphs whose box an erase may have clipped are repainted
+  for (uint8_t i = 0; _drawn && any && (i < n); i++) {
+    if (changed[i])
+      continue;
+    int16_t xa, ax1, ay1, ax2, ay2;
+    glyphBox(chars[i], &xa, &ax1, &ay1, &ax2, &ay2);
+    for (uint8_t j = 0; j < _count; j++) {
+      int16_t bx1, by1, bx2, by2;
+      if (!changed[j] || (j == i))
+        continue;
+      glyphBox(_chars[j], &xa, &bx1, &by1, &bx2, &by2);
+      if ((pos[i] + ax1 <= _pos[j] + bx2) && (_pos[j] + bx1 <= pos[i] + ax2) &&
+          (ay1 <= by2) && (by1 <= ay2)) {
+        changed[i] = true;
+        break;
+      }
+    }
+  }
+
+  memcpy(_chars, chars, n);
+  memcpy(_pos, pos, n * sizeof(int16_t));
+  _count = n;
+  bool drew = false;
+  for (uint8_t i = 0; i < n; i++) {
+    int16_t xa, x1, y1, x2, y2;
+    glyphBox(chars[i], &xa, &x1, &y1, &x2, &y2);
+    if (!changed[i] || (x2 < x1))
+      continue; // Unchanged, or a space / not in the font
+    g->drawChar(pos[i], _y, chars[i], _color, _color, _sx, _sy);
+    drew = true;
+  }
+  if (maxx >= minx) {
+    _minx = minx + shift;
+    _maxx = maxx + shift;
+    _miny = _y + miny;
+    _maxy = _y + maxy;
+  } else {
+    _minx = _miny = 0;
+    _maxx = _maxy = -1;
+  }
+  _drawn = true;
+  _redraw = false;
+  return drew || any;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Bounds of the last print(), without walking the string again
+   @param    x1   Left edge
+   @param    y1   Top edge
+   @param    w    Width, 0 if nothing is drawn
+   @param    h    Height, 0 if nothing is drawn
+*/
+/**************************************************************************/
+void GFXTextRun::getBounds(int16_t *x1, int16_t *y1, uint16_t *w,
+                           uint16_t *h) const {
+  if (_maxx < _minx) {
+    *x1 = _x;
+    *y1 = _y;
+    *w = *h = 0;
+    return;
+  }
+  *x1 = _minx;
+  *y1 = _miny;
+  *w = _maxx - _minx + 1;
+  *h = _maxy - _miny + 1;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Set up a ring gauge. Nothing is allocated or drawn until
+             begin() and the first setValue().
+    @param    gfx        Display to draw on
+    @param    x          Center x
+    @param    y          Center y
+    @param    r          Outer radius, at most 254
+    @param    thickness  Ring width in pixels
+    @param    start      Angle of value 0 in degrees, clockwise from 12
+                         o'clock
+    @param    sweep      Degrees from value 0 to value 1, at most 360
+*/
+/**************************************************************************/
+GFXArcGauge::GFXArcGauge(Adafruit_GFX *gfx, int16_t x, int16_t y, uint8_t r,
+                         uint8_t thickness, float start, float sweep)
+    : _gfx(gfx), _x(x), _y(y), _r(min(r, (uint8_t)(GFX_ARC_NONE - 1))),
+      _thickness(thickness), _start(start),
+      _sweep(max(0.0f, min(sweep, 360.0f))) {}
+
+GFXArcGauge::~GFXArcGauge(void) { free(_outer); }
+
+/**************************************************************************/
+/*!
+   @brief    Compute the ring's span tables, 2 * (r + 1) bytes
+   @returns  false if they could not be allocated
+*/
+/**************************************************************************/
+bool GFXArcGauge::begin(void) {
+  if (_outer)
+    return true;
+  _outer = (uint8_t *)malloc(2 * (_r + 1));
+  if (!_outer)
+    return false;
+  _inner = _outer + _r + 1;
+  int16_t ri = (int16_t)_r - _thickness;
+  for (int16_t dy = 0; dy <= _r; dy++) {
+    _outer[dy] = arcHalfWidth(_r, dy);
+    _inner[dy] = ((ri > 0) && (dy <= ri)) ? arcHalfWidth(ri, dy) : GFX_ARC_NONE;
+  }
+  _drawn = false;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Set the fill and track colors. Changing them repaints the whole
+             ring on the next setValue().
+   @param    color  Color of the arc up to the value
+   @param    track  Color of the rest of the ring (the background for none)
+*/
+/**************************************************************************/
+void GFXArcGauge::setColors(uint16_t color, uint16_t track) {
+  if ((color != _color) || (track != _track))
+    _drawn = false;
+  _color = color;
+  _track = track;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Show a value. The first call (and the first after invalidate())
+             draws the whole ring; later ones only the wedge between the
+             shown and the new value. A change under half a pixel at the
+             outer edge is not drawn, and adds up with later ones.
+   @param    value  0 to 1, clamped
+   @returns  true if anything was drawn
+*/
+/**************************************************************************/
+bool GFXArcGauge::setValue(float value) {
+  if (!_outer)
+    return false;
+  value = max(0.0f, min(value, 1.0f));
+  float from = _start + _value * _sweep, to = _start + value * _sweep;
+  if (!_drawn) {
+    _gfx->fillArcSpans(_x, _y, _r, _thickness, _outer, _inner, _start, to,
+                       _color);
+    _gfx->fillArcSpans(_x, _y, _r, _thickness, _outer, _inner, to,
+                       _start + _sweep, _track);
+    _drawn = true;
+  } else if (fabsf(to - from) * 0.017453293f * _r < 0.5f) {
+    return false;
+  } else if (to > from) {
+    _gfx->fillArcSpans(_x, _y, _r, _thickness, _outer, _inner, from, to,
+                       _color);
+  } else {
+    _gfx->fillArcSpans(_x, _y, _r, _thickness, _outer, _inner, to, from,
+                       _track);
+  }
+  _value = value;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Forget what is on screen (after a clear); the next setValue()
+             draws the whole ring
+*/
+/**************************************************************************/
+void GFXArcGauge::invalidate(void) { _drawn = false; }
+
+/**************************************************************************/
+/*!
+   @brief    Box the ring can cover, e.g. to place text inside it
+   @param    x1   Left edge
+   @param    y1   Top edge
+   @param    w    Width
+   @param    h    Height
+*/
+/**************************************************************************/
+void GFXArcGauge::getBounds(int16_t *x1, int16_t *y1, uint16_t *w,
+                            uint16_t *h) const {
+  *x1 = _x - _r;
+  *y1 = _y - _r;
+  *w = *h = 2 * _r + 1;
+}
+
+// -------------------------------------------------------------------------
+
 // GFXcanvas1, GFXcanvas8 and GFXcanvas16 (currently a WIP, don't get too
 // comfy with the implementation) provide 1-, 8- and 16-bit offscreen
 // canvases, the address of which can be passed to drawBitmap() or
@@ -1869,6 +2761,114 @@ const uint8_t PROGMEM GFXcanvas1::GFXclrBit[] = {0x7F, 0xBF, 0xDF, 0xEF,
                                                  0xF7, 0xFB, 0xFD, 0xFE};
 #endif
 
+/**************************************************************************/
+/*!
+   @brief    Set n bytes to one value, 32 bits per store once dst is word
+             aligned. A solid fill is the same byte in every lane, so byte
+             order does not matter; unlike memset() this does not depend on
+             the toolchain having a word-wise implementation.
+   @param    dst    First byte to set
+   @param    value  Byte value
+   @param    n      Number of bytes
+*/
+/**************************************************************************/
+static void canvasFillBytes(uint8_t *dst, uint8_t value, size_t n) {
+  while (n && ((uintptr_t)dst & 3)) {
+    *dst++ = value;
+    n--;
+  }
+  uint32_t word = value * 0x01010101UL;
+  uint32_t *w = (uint32_t *)dst;
+  for (; n >= 16; n -= 16) { // Unrolled: four stores per loop test
+    w[0] = word;
+    w[1] = word;
+    w[2] = word;
+    w[3] = word;
+    w += 4;
+  }
+  for (; n >= 4; n -= 4)
+    *w++ = word;
+  dst = (uint8_t *)w;
+  while (n--)
+    *dst++ = value;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Map a rectangle, already clipped to the rotated canvas, to raw
+             (rotation 0) buffer coordinates, as drawPixel() maps a point
+   @param    rotation  Canvas rotation, 0-3
+   @param    rawW      Raw canvas width (WIDTH)
+   @param    rawH      Raw canvas height (HEIGHT)
+   @param    x         Left edge, replaced by the raw left edge
+   @param    y         Top edge, replaced by the raw top edge
+   @param    w         Width, replaced by the raw width
+   @param    h         Height, replaced by the raw height
+*/
+/**************************************************************************/
+static void canvasRawRect(uint8_t rotation, int16_t rawW, int16_t rawH,
+                          int16_t &x, int16_t &y, int16_t &w, int16_t &h) {
+  int16_t t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = rawW - y - h;
+    y = t;
+    t = w;
+    w = h;
+    h = t;
+    break;
+  case 2:
+    x = rawW - x - w;
+    y = rawH - y - h;
+    break;
+  case 3:
+    t = y;
+    y = rawH - x - w;
+    x = t;
+    t = w;
+    w = h;
+    h = t;
+    break;
+  }
+}
+
+/**************************************************************************/
+/*!
+   @brief    Clip a rectangle to the canvas
+   @param    x      Left edge
+   @param    y      Top edge
+   @param    w      Width; zero or negative draws nothing
+   @param    h      Height; negative grows up from y, like writeFastVLine(),
+                    and zero draws nothing
+   @param    maxW   Canvas width at the current rotation
+   @param    maxH   Canvas height at the current rotation
+   @returns  false if nothing of the rectangle is on the canvas
+*/
+/**************************************************************************/
+static bool canvasClipRect(int16_t &x, int16_t &y, int16_t &w, int16_t &h,
+                           int16_t maxW, int16_t maxH) {
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  if (w <= 0 || h == 0)
+    return false;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > maxW)
+    w = maxW - x;
+  if (y + h > maxH)
+    h = maxH - y;
+  return (w > 0) && (h > 0);
+}
+
 /**************************************************************************/
 /*!
    @brief    Instatiate a GFX 1-bit canvas context for graphics
@@ -2013,10 +3013,52 @@ bool GFXcanvas1::getRawPixel(int16_t x, int16_t y) const {
 void GFXcanvas1::fillScreen(uint16_t color) {
   if (buffer) {
     uint32_t bytes = ((WIDTH + 7) / 8) * HEIGHT;
-    memset(buffer, color ? 0xFF : 0x00, bytes);
+    canvasFillBytes(buffer, color ? 0xFF : 0x00, bytes);
   }
 }
 
+/**************************************************************************/
+/*!
+    @brief  Invert every pixel of the framebuffer, 32 bits at a time
+*/
+/**************************************************************************/
+void GFXcanvas1::invertScreen(void) {
+  if (!buffer)
+    return;
+  uint8_t *ptr = buffer;
+  size_t n = ((WIDTH + 7) / 8) * HEIGHT;
+  while (n && ((uintptr_t)ptr & 3)) {
+    *ptr++ ^= 0xFF;
+    n--;
+  }
+  uint32_t *w = (uint32_t *)ptr;
+  for (; n >= 4; n -= 4)
+    *w++ ^= 0xFFFFFFFFUL;
+  ptr = (uint8_t *)w;
+  while (n--)
+    *ptr++ ^= 0xFF;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Fill a rectangle: edge masks are computed once and every row is
+             one or two masked bytes plus a word-wise run, instead of one
+             vertical line per column
+   @param    x      Top left corner x coordinate
+   @param    y      Top left corner y coordinate
+   @param    w      Width in pixels
+   @param    h      Height in pixels
+   @param    color  Binary (on or off) color to fill with
+*/
+/**************************************************************************/
+void GFXcanvas1::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          uint16_t color) {
+  if (!buffer || !canvasClipRect(x, y, w, h, _width, _height))
+    return;
+  canvasRawRect(rotation, WIDTH, HEIGHT, x, y, w, h);
+  fillRawRect(x, y, w, h, color);
+}
+
 /**************************************************************************/
 /*!
    @brief  Speed optimized vertical line drawing
@@ -2178,57 +3220,100 @@ void GFXcanvas1::drawFastRawVLine(int16_t x, int16_t y, int16_t h,
 void GFXcanvas1::drawFastRawHLine(int16_t x, int16_t y, int16_t w,
                                   uint16_t color) {
   // x & y already in raw (rotation 0) coordinates, no need to transform.
+  if (w > 0)
+    fillRawRect(x, y, w, 1, color);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Fill a rectangle in the raw canvas buffer
+   @param    x   Left edge, raw (rotation 0) coordinates, on the canvas
+   @param    y   Top edge, raw coordinates, on the canvas
+   @param    w   Width in pixels, > 0 and within the canvas
+   @param    h   Height in pixels, > 0 and within the canvas
+   @param    color   Binary (on or off) color to fill with
+*/
+/**************************************************************************/
+void GFXcanvas1::fillRawRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                             uint16_t color) {
   int16_t rowBytes = ((WIDTH + 7) / 8);
-  uint8_t *ptr = &buffer[(x / 8) + y * rowBytes];
-  size_t remainingWidthBits = w;
-
-  // check to see if first byte needs to be partially filled
-  if ((x & 7) > 0) {
-    // create bit mask for first byte
-    uint8_t startByteBitMask = 0x00;
-    for (int8_t i = (x & 7); ((i < 8) && (remainingWidthBits > 0)); i++) {
-#ifdef __AVR__
-      startByteBitMask |= pgm_read_byte(&GFXsetBit[i]);
-#else
-      startByteBitMask |= (0x80 >> i);
-#endif
-      remainingWidthBits--;
+  int16_t first = x / 8, last = (x + w - 1) / 8;
+  uint8_t firstMask = 0xFF >> (x & 7);
+  uint8_t lastMask = 0xFF << (7 - ((x + w - 1) & 7));
+  if (first == last)
+    firstMask &= lastMask;
+  uint8_t value = color ? 0xFF : 0x00;
+  size_t whole = (last > first) ? last - first - 1 : 0;
+  uint8_t *ptr = &buffer[first + y * rowBytes];
+
+  for (int16_t j = 0; j < h; j++, ptr += rowBytes) {
+    ptr[0] = (ptr[0] & ~firstMask) | (value & firstMask);
+    if (last > first) {
+      canvasFillBytes(ptr + 1, value, whole);
+      ptr[last - first] = (ptr[last - first] & ~lastMask) | (value & lastMask);
     }
-    if (color > 0) {
-      *ptr |= startByteBitMask;
-    } else {
-      *ptr &= ~startByteBitMask;
-    }
-
-    ptr++;
   }
+}
 
-  // do the next remainingWidthBits bits
-  if (remainingWidthBits > 0) {
-    size_t remainingWholeBytes = remainingWidthBits / 8;
-    size_t lastByteBits = remainingWidthBits % 8;
-    uint8_t wholeByteColor = color > 0 ? 0xFF : 0x00;
-
-    memset(ptr, wholeByteColor, remainingWholeBytes);
-
-    if (lastByteBits > 0) {
-      uint8_t lastByteBitMask = 0x00;
-      for (size_t i = 0; i < lastByteBits; i++) {
-#ifdef __AVR__
-        lastByteBitMask |= pgm_read_byte(&GFXsetBit[i]);
-#else
-        lastByteBitMask |= (0x80 >> i);
-#endif
-      }
-      ptr += remainingWholeBytes;
-
-      if (color > 0) {
-        *ptr |= lastByteBitMask;
-      } else {
-        *ptr &= ~lastByteBitMask;
+/**************************************************************************/
+/*!
+   @brief    1-bit bitmaps at rotation 0, a byte at a time: each image byte
+             is masked to its visible columns and shifted into the one or
+             two canvas bytes it covers (a single byte when x is a multiple
+             of 8).
+   @param    x       Top left corner x coordinate
+   @param    y       Top left corner y coordinate
+   @param    bitmap  Row-major image, each row padded to a whole byte
+   @param    w       Width of bitmap in pixels
+   @param    h       Height of bitmap in pixels
+   @param    color   Color of set bits
+   @param    bg      Color of unset bits, with GFX_BLIT_OPAQUE
+   @param    flags   GFX_BLIT_PROGMEM, GFX_BLIT_XBM, GFX_BLIT_OPAQUE
+   @returns  true if drawn, false (rotated canvas) for the generic path
+*/
+/**************************************************************************/
+bool GFXcanvas1::blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+                            int16_t w, int16_t h, uint16_t color, uint16_t bg,
+                            uint8_t flags) {
+  if (!buffer || rotation)
+    return false;
+  // Visible columns [i0, i1) and rows [j0, j1) of the image
+  int16_t i0 = (x < 0) ? -x : 0, i1 = (x + w > WIDTH) ? WIDTH - x : w;
+  int16_t j0 = (y < 0) ? -y : 0, j1 = (y + h > HEIGHT) ? HEIGHT - y : h;
+  if ((i0 >= i1) || (j0 >= j1))
+    return true;
+  int16_t byteWidth = (w + 7) / 8, rowBytes = (WIDTH + 7) / 8;
+  bool opaque = flags & GFX_BLIT_OPAQUE;
+  uint8_t fg = color ? 0xFF : 0x00, back = bg ? 0xFF : 0x00;
+
+  for (int16_t j = j0; j < j1; j++) {
+    uint8_t *row = &buffer[(y + j) * rowBytes];
+    const uint8_t *src = &bitmap[j * byteWidth];
+    for (int16_t bi = i0 / 8; bi <= (i1 - 1) / 8; bi++) {
+      uint8_t vis = 0xFF;
+      if (bi * 8 < i0)
+        vis &= 0xFF >> (i0 - bi * 8);
+      if (bi * 8 + 8 > i1)
+        vis &= 0xFF << (bi * 8 + 8 - i1);
+      uint8_t set = bitmapByte(&src[bi], flags);
+      uint8_t mask = opaque ? vis : (set & vis); // Bits to write
+      uint8_t value = (set & fg) | (~set & back);
+      // First canvas column of this byte is > -8, so offset by 8 to keep
+      // the arithmetic non-negative
+      int16_t dx = x + bi * 8 + 8;
+      int16_t db = dx / 8 - 1;
+      uint8_t shift = dx & 7;
+      uint8_t m = mask >> shift;
+      if (m)
+        row[db] = (row[db] & ~m) | ((value >> shift) & m);
+      if (shift) {
+        m = mask << (8 - shift);
+        if (m)
+          row[db + 1] = (row[db + 1] & ~m) | ((value << (8 - shift)) & m);
       }
     }
   }
+  return true;
 }
 
 /**************************************************************************/
@@ -2354,10 +3439,32 @@ uint8_t GFXcanvas8::getRawPixel(int16_t x, int16_t y) const {
 /**************************************************************************/
 void GFXcanvas8::fillScreen(uint16_t color) {
   if (buffer) {
-    memset(buffer, color, WIDTH * HEIGHT);
+    canvasFillBytes(buffer, color, WIDTH * HEIGHT);
   }
 }
 
+/**************************************************************************/
+/*!
+   @brief    Fill a rectangle row by row with word-wise runs, instead of one
+             vertical line per column
+   @param    x      Top left corner x coordinate
+   @param    y      Top left corner y coordinate
+   @param    w      Width in pixels
+   @param    h      Height in pixels
+   @param    color  8-bit Color to fill with. Only lower byte of uint16_t is
+                    used.
+*/
+/**************************************************************************/
+void GFXcanvas8::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          uint16_t color) {
+  if (!buffer || !canvasClipRect(x, y, w, h, _width, _height))
+    return;
+  canvasRawRect(rotation, WIDTH, HEIGHT, x, y, w, h);
+  uint8_t *ptr = buffer + y * WIDTH + x;
+  for (int16_t j = 0; j < h; j++, ptr += WIDTH)
+    canvasFillBytes(ptr, color, w);
+}
+
 /**************************************************************************/
 /*!
    @brief  Speed optimized vertical line drawing
@@ -2484,10 +3591,20 @@ void GFXcanvas8::drawFastHLine(int16_t x, int16_t y, int16_t w,
 void GFXcanvas8::drawFastRawVLine(int16_t x, int16_t y, int16_t h,
                                   uint16_t color) {
   // x & y already in raw (rotation 0) coordinates, no need to transform.
+  // One pixel per row, so the stores cannot be merged into words; four
+  // rows per loop test instead.
   uint8_t *buffer_ptr = buffer + y * WIDTH + x;
-  for (int16_t i = 0; i < h; i++) {
-    (*buffer_ptr) = color;
-    buffer_ptr += WIDTH;
+  int16_t stride = WIDTH;
+  for (; h >= 4; h -= 4) {
+    buffer_ptr[0] = color;
+    buffer_ptr[stride] = color;
+    buffer_ptr[2 * stride] = color;
+    buffer_ptr[3 * stride] = color;
+    buffer_ptr += 4 * stride;
+  }
+  while (h-- > 0) {
+    *buffer_ptr = color;
+    buffer_ptr += stride;
   }
 }
 
@@ -2504,7 +3621,7 @@ void GFXcanvas8::drawFastRawVLine(int16_t x, int16_t y, int16_t h,
 void GFXcanvas8::drawFastRawHLine(int16_t x, int16_t y, int16_t w,
                                   uint16_t color) {
   // x & y already in raw (rotation 0) coordinates, no need to transform.
-  memset(buffer + y * WIDTH + x, color, w);
+  canvasFillBytes(buffer + y * WIDTH + x, color, w);
 }
 
 /**************************************************************************/
@@ -2656,11 +3773,51 @@ void GFXcanvas16::fillScreen(uint16_t color) {
 */
 /**************************************************************************/
 void GFXcanvas16::byteSwap(void) {
-  if (buffer) {
-    uint32_t i, pixels = WIDTH * HEIGHT;
-    for (i = 0; i < pixels; i++)
-      buffer[i] = __builtin_bswap16(buffer[i]);
+  if (buffer)
+    byteSwap(buffer, buffer, WIDTH * HEIGHT);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Byte-swap 16-bit pixels while copying them, e.g. straight into a
+            DMA buffer so the source is only walked once. Two pixels are
+            swapped per 32-bit word, four words per loop, whenever source
+            and destination share their 4-byte alignment (always true for
+            malloc'd canvases and in-place swaps).
+    @param  dest  Destination, may be the same as src
+    @param  src   Source pixels
+    @param  len   Number of pixels
+*/
+/**************************************************************************/
+void GFXcanvas16::byteSwap(uint16_t *dest, const uint16_t *src,
+                           uint32_t len) {
+  if (((uintptr_t)src ^ (uintptr_t)dest) & 2) { // Can't pair up pixels
+    while (len--)
+      *dest++ = __builtin_bswap16(*src++);
+    return;
+  }
+  if (len && ((uintptr_t)src & 2)) { // Odd pixel up to a word boundary
+    *dest++ = __builtin_bswap16(*src++);
+    len--;
+  }
+  // may_alias: the same pixels are also accessed as uint16_t elsewhere
+  typedef uint32_t __attribute__((__may_alias__)) pair_t;
+  const pair_t *s = (const pair_t *)src;
+  pair_t *d = (pair_t *)dest;
+  uint32_t words = len / 2;
+  for (; words >= 4; words -= 4, s += 4, d += 4) {
+    uint32_t w0 = s[0], w1 = s[1], w2 = s[2], w3 = s[3];
+    d[0] = ((w0 & 0x00FF00FF) << 8) | ((w0 >> 8) & 0x00FF00FF);
+    d[1] = ((w1 & 0x00FF00FF) << 8) | ((w1 >> 8) & 0x00FF00FF);
+    d[2] = ((w2 & 0x00FF00FF) << 8) | ((w2 >> 8) & 0x00FF00FF);
+    d[3] = ((w3 & 0x00FF00FF) << 8) | ((w3 >> 8) & 0x00FF00FF);
   }
+  while (words--) {
+    uint32_t w = *s++;
+    *d++ = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+  }
+  if (len & 1)
+    *(uint16_t *)d = __builtin_bswap16(*(const uint16_t *)s);
 }
 
 /**************************************************************************/
@@ -2809,3 +3966,126 @@ void GFXcanvas16::drawFastRawHLine(int16_t x, int16_t y, int16_t w,
     buffer[i] = color;
   }
 }
+
+/**************************************************************************/
+/*!
+   @brief    Instantiate a strip canvas: a w x h scene of which only 'lines'
+             rows at a time are held in RAM. width() and height() report the
+             whole scene and drawing uses scene coordinates; anything outside
+             the current strip is dropped. Rendering a scene is one pass per
+             strip: setStrip(), draw everything, send getBuffer() off.
+   @param    w      Scene width, in pixels
+   @param    h      Scene height, in pixels
+   @param    lines  Rows in the buffer (w * lines * 2 bytes are allocated)
+*/
+/**************************************************************************/
+GFXstripCanvas16::GFXstripCanvas16(uint16_t w, uint16_t h, uint16_t lines)
+    : GFXcanvas16(w, lines) {
+  _height = h;
+  setStrip(0, lines);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Select the rows held by the buffer, e.g. before drawing the next
+             strip of a scene. The clip rectangle is reset to the strip, so
+             lines, shapes and text wholly outside it are rejected up front.
+   @param    y      First scene row of the strip
+   @param    lines  Rows in the strip, at most maxLines()
+*/
+/**************************************************************************/
+void GFXstripCanvas16::setStrip(int16_t y, uint16_t lines) {
+  _stripY = y;
+  _stripLines = (lines < (uint16_t)HEIGHT) ? lines : HEIGHT;
+  resetClipRect();
+  pushClipRect(0, y, _width, _stripLines);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a pixel, if it lies in the current strip
+    @param  x   x coordinate in the scene
+    @param  y   y coordinate in the scene
+    @param  color 16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void GFXstripCanvas16::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  int32_t row = (int32_t)y - _stripY;
+  if (buffer && (x >= 0) && (x < _width) && (row >= 0) && (row < _stripLines))
+    buffer[x + row * WIDTH] = color;
+}
+
+/**************************************************************************/
+/*!
+   @brief    Fill the part of a rectangle that lies in the current strip
+   @param    x      Top left corner x coordinate
+   @param    y      Top left corner y coordinate
+   @param    w      Width in pixels
+   @param    h      Height in pixels
+   @param    color  16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void GFXstripCanvas16::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                uint16_t color) {
+  int32_t x0 = x, y0 = y, x1 = (int32_t)x + w, y1 = (int32_t)y + h;
+  if (w < 0) {
+    x0 = x1 + 1;
+    x1 = x + 1;
+  }
+  if (h < 0) {
+    y0 = y1 + 1;
+    y1 = y + 1;
+  }
+  // Clip to the canvas width and the strip, then to buffer rows
+  x0 = max(x0, (int32_t)0);
+  x1 = min(x1, (int32_t)_width);
+  y0 = max(y0, (int32_t)_stripY) - _stripY;
+  y1 = min(y1, (int32_t)_stripY + _stripLines) - _stripY;
+  if (!buffer || (x0 >= x1) || (y0 >= y1))
+    return;
+  for (int32_t row = y0; row < y1; row++)
+    drawFastRawHLine(x0, row, x1 - x0, color);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Draw the part of a vertical line that lies in the current strip
+   @param    x   Line horizontal start point
+   @param    y   Line vertical start point
+   @param    h   length of vertical line to be drawn, including first point
+   @param    color   color 16-bit 5-6-5 Color to draw line with
+*/
+/**************************************************************************/
+void GFXstripCanvas16::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                     uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+/**************************************************************************/
+/*!
+   @brief    Draw the part of a horizontal line that lies in the current strip
+   @param    x   Line horizontal start point
+   @param    y   Line vertical start point
+   @param    w   Length of horizontal line to be drawn, including 1st point
+   @param    color   color 16-bit 5-6-5 Color to draw line with
+*/
+/**************************************************************************/
+void GFXstripCanvas16::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                     uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+/**********************************************************************/
+/*!
+        @brief    Get a pixel of the current strip
+        @param    x   x coordinate in the scene
+        @param    y   y coordinate in the scene
+        @returns  The pixel's 16-bit 5-6-5 color value, 0 outside the strip
+*/
+/**********************************************************************/
+uint16_t GFXstripCanvas16::getPixel(int16_t x, int16_t y) const {
+  int32_t row = (int32_t)y - _stripY;
+  if ((row < 0) || (row >= _stripLines))
+    return 0;
+  return getRawPixel(x, row);
+}
@@ -12,6 +12,15 @@
 #include <Adafruit_I2CDevice.h>
 #include <Adafruit_SPIDevice.h>
 
+// blitBitmap() flags describing the source image
+#define GFX_BLIT_PROGMEM 0x01 ///< Bitmap is in PROGMEM, not RAM
+#define GFX_BLIT_XBM 0x02     ///< XBM bit order: leftmost pixel in the LSB
+#define GFX_BLIT_OPAQUE 0x04  ///< Unset bits are drawn in bg
+
+#ifndef GFX_CLIP_DEPTH
+#define GFX_CLIP_DEPTH 4 ///< Nesting depth of pushClipRect()
+#endif
+
 /// A generic graphics superclass that can handle all sorts of drawing. At a
 /// minimum you can subclass and provide drawPixel(). At a maximum you can do a
 /// ton of overriding to optimize. Used for any/all Adafruit displays!
@@ -77,6 +86,8 @@ public:
                    uint16_t color);
   void fillEllipse(int16_t x0, int16_t y0, int16_t rw, int16_t rh,
                    uint16_t color);
+  void fillArc(int16_t x0, int16_t y0, uint8_t r, uint8_t thickness,
+               float start, float end, uint16_t color);
   void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2,
                     int16_t y2, uint16_t color);
   void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2,
@@ -113,8 +124,8 @@ public:
                      int16_t w, int16_t h);
   void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
                 uint16_t bg, uint8_t size);
-  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
-                uint16_t bg, uint8_t size_x, uint8_t size_y);
+  virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+                        uint16_t bg, uint8_t size_x, uint8_t size_y);
   void getTextBounds(const char *string, int16_t x, int16_t y, int16_t *x1,
                      int16_t *y1, uint16_t *w, uint16_t *h);
   void getTextBounds(const __FlashStringHelper *s, int16_t x, int16_t y,
@@ -184,6 +195,11 @@ public:
   /**********************************************************************/
   void cp437(bool x = true) { _cp437 = x; }
 
+  bool pushClipRect(int16_t x, int16_t y, int16_t w, int16_t h);
+  void popClipRect(void);
+  void resetClipRect(void);
+  void getClipRect(int16_t *x, int16_t *y, int16_t *w, int16_t *h) const;
+
   using Print::write;
 #if ARDUINO >= 100
   virtual size_t write(uint8_t);
@@ -236,6 +252,63 @@ public:
 protected:
   void charBounds(unsigned char c, int16_t *x, int16_t *y, int16_t *minx,
                   int16_t *miny, int16_t *maxx, int16_t *maxy);
+  uint8_t classicGlyphColumn(unsigned char c, uint8_t col) const;
+  virtual bool blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+                          int16_t w, int16_t h, uint16_t color, uint16_t bg,
+                          uint8_t flags);
+  static uint8_t bitmapByte(const uint8_t *p, uint8_t flags);
+
+  /**********************************************************************/
+  /*!
+    @brief  writePixel() if the point lies inside the clip rectangle
+    @param  x      X coordinate in pixels
+    @param  y      Y coordinate in pixels
+    @param  color  16-bit pixel color
+  */
+  /**********************************************************************/
+  void clipPixel(int16_t x, int16_t y, uint16_t color) {
+    if ((x >= _clipX0) && (x < _clipX1) && (y >= _clipY0) && (y < _clipY1))
+      writePixel(x, y, color);
+  }
+
+  /**********************************************************************/
+  /*!
+    @brief  Test a bounding box against the clip rectangle
+    @param  x0  Left edge
+    @param  y0  Top edge
+    @param  x1  Right edge, inclusive
+    @param  y1  Bottom edge, inclusive
+    @returns  true if no pixel of the box can be drawn
+  */
+  /**********************************************************************/
+  bool clipRejects(int16_t x0, int16_t y0, int16_t x1, int16_t y1) const {
+    return (x1 < _clipX0) || (x0 >= _clipX1) || (y1 < _clipY0) ||
+           (y0 >= _clipY1);
+  }
+
+  /**********************************************************************/
+  /*!
+    @brief  Test whether a bounding box lies wholly inside the clip
+            rectangle, e.g. before a fast path that only clips to the screen
+    @param  x0  Left edge
+    @param  y0  Top edge
+    @param  x1  Right edge, inclusive
+    @param  y1  Bottom edge, inclusive
+    @returns  true if every pixel of the box may be drawn
+  */
+  /**********************************************************************/
+  bool clipContains(int16_t x0, int16_t y0, int16_t x1, int16_t y1) const {
+    return (x0 >= _clipX0) && (x1 < _clipX1) && (y0 >= _clipY0) &&
+           (y1 < _clipY1);
+  }
+
+  void clipFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void clipFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void clipFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                    uint16_t color);
+  void fillArcSpans(int16_t x0, int16_t y0, uint8_t r, uint8_t thickness,
+                    const uint8_t *outer, const uint8_t *inner, float start,
+                    float end, uint16_t color);
   int16_t WIDTH;        ///< This is the 'raw' display width - never changes
   int16_t HEIGHT;       ///< This is the 'raw' display height - never changes
   int16_t _width;       ///< Display width as modified by current rotation
@@ -250,6 +323,15 @@ protected:
   bool wrap;            ///< If set, 'wrap' text at right edge of display
   bool _cp437;          ///< If set, use correct CP437 charset (default is off)
   GFXfont *gfxFont;     ///< Pointer to special font
+  int16_t _clipX0;      ///< Clip rectangle left edge
+  int16_t _clipY0;      ///< Clip rectangle top edge
+  int16_t _clipX1;      ///< Clip rectangle right edge, exclusive
+  int16_t _clipY1;      ///< Clip rectangle bottom edge, exclusive
+  int16_t _clipStack[GFX_CLIP_DEPTH][4]; ///< Rectangles saved by push
+  uint8_t _clipDepth;                    ///< Pushed rectangles
+
+  friend class GFXTextRun;  // Lays out with the current font and size
+  friend class GFXArcGauge; // Fills from its own span tables
 };
 
 /// A simple drawn button UI element
@@ -310,6 +392,93 @@ private:
   bool currstate, laststate;
 };
 
+#define GFX_TEXTRUN_MAX 24 ///< Most glyphs one GFXTextRun lays out
+
+/// One line of text laid out once and redrawn in place. print() computes
+/// every glyph position and the run's bounds in a single pass over the
+/// string, aligns the run at its anchor, and then touches only glyphs whose
+/// character or position changed, erasing what they replace. Useful for
+/// right-aligned numeric fields updated every frame.
+class GFXTextRun {
+public:
+  /// Where the anchor sits on the run
+  enum Align : uint8_t { ALIGN_LEFT, ALIGN_RIGHT, ALIGN_CENTER };
+
+  GFXTextRun(Adafruit_GFX *gfx, int16_t x, int16_t y,
+             Align align = ALIGN_LEFT);
+  void setColors(uint16_t color, uint16_t bg);
+  void setFixedDigits(bool fixed);
+  bool print(const char *str);
+  void invalidate(void);
+  void getBounds(int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) const;
+
+  /**********************************************************************/
+  /*!
+    @brief    Number of glyphs in the current layout
+    @returns  0 to GFX_TEXTRUN_MAX
+  */
+  /**********************************************************************/
+  uint8_t length(void) const { return _count; }
+
+private:
+  void glyphBox(unsigned char c, int16_t *xa, int16_t *x1, int16_t *y1,
+                int16_t *x2, int16_t *y2) const;
+  void eraseGlyph(uint8_t i);
+
+  Adafruit_GFX *_gfx;
+  int16_t _x, _y; // Anchor: cursor position, aligned per _align
+  Align _align;
+  uint16_t _color = 0xFFFF, _bg = 0x0000;
+  bool _fixedDigits = false;
+  bool _drawn = false;          // Glyphs below are on screen
+  bool _redraw = false;         // Colors changed: repaint every glyph
+  const GFXfont *_font = NULL;  // Font and sizes the layout was made with
+  uint8_t _sx = 1, _sy = 1;
+  int16_t _digitAdvance = 0;    // Widest digit, with setFixedDigits()
+  uint8_t _count = 0;
+  char _chars[GFX_TEXTRUN_MAX];
+  int16_t _pos[GFX_TEXTRUN_MAX]; // Cursor x of each glyph
+  int16_t _minx = 0, _miny = 0, _maxx = -1, _maxy = -1; // Run bounds
+};
+
+#define GFX_ARC_NONE 0xFF ///< Span table entry: the row has no inner hole
+
+/// A ring gauge (dial) showing a value from 0 to 1 as a filled arc over a
+/// track. The per-row spans of the ring are computed once in begin(); an
+/// update fills only the wedge between the old and the new value, in the
+/// fill color when the value rose and the track color when it fell, so on
+/// a display with a dirty window only that segment is sent.
+class GFXArcGauge {
+public:
+  GFXArcGauge(Adafruit_GFX *gfx, int16_t x, int16_t y, uint8_t r,
+              uint8_t thickness, float start = -135.0f, float sweep = 270.0f);
+  ~GFXArcGauge(void);
+  bool begin(void);
+  void setColors(uint16_t color, uint16_t track);
+  bool setValue(float value);
+  void invalidate(void);
+  void getBounds(int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) const;
+
+  /**********************************************************************/
+  /*!
+    @brief    Value the gauge currently shows
+    @returns  0 to 1
+  */
+  /**********************************************************************/
+  float value(void) const { return _value; }
+
+private:
+  Adafruit_GFX *_gfx;
+  int16_t _x, _y; // Center
+  uint8_t _r, _thickness;
+  float _start, _sweep; // Degrees clockwise from 12 o'clock
+  uint8_t *_outer = NULL; // Half-width of the ring's outer edge per row
+  uint8_t *_inner = NULL; // Of its hole, GFX_ARC_NONE below the hole
+  uint16_t _color = 0xFFFF, _track = 0x0000;
+  bool _drawn = false; // The arc below is on screen
+  float _value = 0.0f; // Drawn value
+};
+
 /// A GFX 1-bit canvas context for graphics
 class GFXcanvas1 : public Adafruit_GFX {
 public:
@@ -317,6 +486,8 @@ public:
   ~GFXcanvas1(void);
   void drawPixel(int16_t x, int16_t y, uint16_t color);
   void fillScreen(uint16_t color);
+  void invertScreen(void);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
   void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
   bool getPixel(int16_t x, int16_t y) const;
@@ -332,6 +503,9 @@ protected:
   bool getRawPixel(int16_t x, int16_t y) const;
   void drawFastRawVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   void drawFastRawHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void fillRawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  bool blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w,
+                  int16_t h, uint16_t color, uint16_t bg, uint8_t flags);
   uint8_t *buffer;   ///< Raster data: no longer private, allow subclass access
   bool buffer_owned; ///< If true, destructor will free buffer, else it will do
                      ///< nothing
@@ -350,6 +524,7 @@ public:
   ~GFXcanvas8(void);
   void drawPixel(int16_t x, int16_t y, uint16_t color);
   void fillScreen(uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
   void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
   uint8_t getPixel(int16_t x, int16_t y) const;
@@ -378,6 +553,7 @@ public:
   void drawPixel(int16_t x, int16_t y, uint16_t color);
   void fillScreen(uint16_t color);
   void byteSwap(void);
+  static void byteSwap(uint16_t *dest, const uint16_t *src, uint32_t len);
   void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
   uint16_t getPixel(int16_t x, int16_t y) const;
@@ -398,4 +574,50 @@ protected:
                      ///< nothing
 };
 
+/// A band of rows from a larger 16-bit scene: drawn to in screen
+/// coordinates, but only the current strip is stored
+class GFXstripCanvas16 : public GFXcanvas16 {
+public:
+  GFXstripCanvas16(uint16_t w, uint16_t h, uint16_t lines);
+  void setStrip(int16_t y, uint16_t lines);
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  uint16_t getPixel(int16_t x, int16_t y) const;
+  /**********************************************************************/
+  /*!
+    @brief  Strips always use the canvas' own orientation; rotate the
+            display instead
+    @param  r  Ignored
+  */
+  /**********************************************************************/
+  void setRotation(uint8_t r) { (void)r; }
+  /**********************************************************************/
+  /*!
+    @brief    Get the first scene row held by the buffer
+    @returns  Row set by the last setStrip()
+  */
+  /**********************************************************************/
+  int16_t stripY(void) const { return _stripY; }
+  /**********************************************************************/
+  /*!
+    @brief    Get the number of rows in the current strip
+    @returns  Rows set by the last setStrip()
+  */
+  /**********************************************************************/
+  uint16_t stripLines(void) const { return _stripLines; }
+  /**********************************************************************/
+  /*!
+    @brief    Get the number of rows the buffer was allocated for
+    @returns  The lines passed to the constructor
+  */
+  /**********************************************************************/
+  uint16_t maxLines(void) const { return HEIGHT; }
+
+protected:
+  int16_t _stripY;      ///< First scene row in the buffer
+  uint16_t _stripLines; ///< Rows of the buffer in use
+};
+
 #endif // _ADAFRUIT_GFX_H
@@ -254,13 +254,19 @@ bool Adafruit_GrayOLED::_init(uint8_t addr, bool reset) {
     pinMode(dcPin, OUTPUT); // Set data/command pin as output
   }
 
-  clearDisplay();
+  // Pick the pixel paths for this depth once, not per pixel
+  if (_bpp == 4) {
+    pixelWriter = &Adafruit_GrayOLED::drawPixelBpp<4>;
+    pixelReader = &Adafruit_GrayOLED::getPixelBpp<4>;
+  } else if (_bpp == 1) {
+    pixelWriter = &Adafruit_GrayOLED::drawPixelBpp<1>;
+    pixelReader = &Adafruit_GrayOLED::getPixelBpp<1>;
+  } else { // Unsupported depth: draws and reads nothing, as before
+    pixelWriter = &Adafruit_GrayOLED::drawPixelBpp<0>;
+    pixelReader = &Adafruit_GrayOLED::getPixelBpp<0>;
+  }
 
-  // set max dirty window
-  window_x1 = 0;
-  window_y1 = 0;
-  window_x2 = WIDTH - 1;
-  window_y2 = HEIGHT - 1;
+  clearDisplay(); // Also sets the max dirty window
 
   return true; // Success
 }
@@ -283,58 +289,91 @@ bool Adafruit_GrayOLED::_init(uint8_t addr, bool reset) {
             commands as needed by one's own application.
 */
 void Adafruit_GrayOLED::drawPixel(int16_t x, int16_t y, uint16_t color) {
-  if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
-    // Pixel is in-bounds. Rotate coordinates if needed.
-    switch (getRotation()) {
-    case 1:
-      grayoled_swap(x, y);
-      x = WIDTH - x - 1;
+  (this->*pixelWriter)(x, y, color);
+}
+
+/*!
+    @brief  Map rotated coordinates to the physical buffer.
+    @param  x  Column, rotated on return.
+    @param  y  Row, rotated on return.
+    @param  r  Rotation, 0 thru 3.
+    @param  w  Physical width (WIDTH).
+    @param  h  Physical height (HEIGHT).
+*/
+static inline void grayoled_rotate(int16_t &x, int16_t &y, uint8_t r,
+                                   int16_t w, int16_t h) {
+  switch (r) {
+  case 1:
+    grayoled_swap(x, y);
+    x = w - x - 1;
+    break;
+  case 2:
+    x = w - x - 1;
+    y = h - y - 1;
+    break;
+  case 3:
+    grayoled_swap(x, y);
+    y = h - y - 1;
+    break;
+  }
+}
+
+/*!
+    @brief  drawPixel() for one buffer depth: BPP is a compile-time
+            constant, so only that depth's packing is compiled in.
+    @param  x      Column in rotated coordinates.
+    @param  y      Row in rotated coordinates.
+    @param  color  MONOOLED_BLACK, MONOOLED_WHITE or MONOOLED_INVERSE for
+                   1 bpp, a gray level 0-15 for 4 bpp.
+*/
+template <uint8_t BPP>
+void Adafruit_GrayOLED::drawPixelBpp(int16_t x, int16_t y, uint16_t color) {
+  grayoled_rotate(x, y, rotation, WIDTH, HEIGHT);
+  if (((uint16_t)x >= (uint16_t)WIDTH) || ((uint16_t)y >= (uint16_t)HEIGHT))
+    return;
+  markDirty(x, x, y, y);
+
+  if (BPP == 1) { // Column-major pages of 8 rows
+    uint8_t *b = &buffer[x + (y / 8) * WIDTH], bit = 1 << (y & 7);
+    switch (color) {
+    case MONOOLED_WHITE:
+      *b |= bit;
       break;
-    case 2:
-      x = WIDTH - x - 1;
-      y = HEIGHT - y - 1;
+    case MONOOLED_BLACK:
+      *b &= ~bit;
       break;
-    case 3:
-      grayoled_swap(x, y);
-      y = HEIGHT - y - 1;
+    case MONOOLED_INVERSE:
+      *b ^= bit;
       break;
     }
-
-    // adjust dirty window
-    window_x1 = min(window_x1, x);
-    window_y1 = min(window_y1, y);
-    window_x2 = max(window_x2, x);
-    window_y2 = max(window_y2, y);
-
-    if (_bpp == 1) {
-      switch (color) {
-      case MONOOLED_WHITE:
-        buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7));
-        break;
-      case MONOOLED_BLACK:
-        buffer[x + (y / 8) * WIDTH] &= ~(1 << (y & 7));
-        break;
-      case MONOOLED_INVERSE:
-        buffer[x + (y / 8) * WIDTH] ^= (1 << (y & 7));
-        break;
-      }
-    }
-    if (_bpp == 4) {
-      uint8_t *pixelptr = &buffer[x / 2 + (y * WIDTH / 2)];
-      // Serial.printf("(%d, %d) -> offset %d\n", x, y, x/2 + (y * WIDTH / 2));
-      if (x % 2 == 0) { // even, left nibble
-        uint8_t t = pixelptr[0] & 0x0F;
-        t |= (color & 0xF) << 4;
-        pixelptr[0] = t;
-      } else { // odd, right lower nibble
-        uint8_t t = pixelptr[0] & 0xF0;
-        t |= color & 0xF;
-        pixelptr[0] = t;
-      }
-    }
+  } else if (BPP == 4) { // Row-major, two pixels per byte, even x high
+    uint8_t *b = &buffer[x / 2 + (y * WIDTH / 2)];
+    if (x & 1)
+      *b = (*b & 0xF0) | (color & 0x0F);
+    else
+      *b = (*b & 0x0F) | ((color & 0x0F) << 4);
   }
 }
 
+/*!
+    @brief  getPixel() for one buffer depth.
+    @param  x  Column in rotated coordinates.
+    @param  y  Row in rotated coordinates.
+    @return true if the pixel is set (any nonzero gray level for 4 bpp),
+            false if clear or out of bounds.
+*/
+template <uint8_t BPP>
+bool Adafruit_GrayOLED::getPixelBpp(int16_t x, int16_t y) {
+  grayoled_rotate(x, y, rotation, WIDTH, HEIGHT);
+  if (((uint16_t)x >= (uint16_t)WIDTH) || ((uint16_t)y >= (uint16_t)HEIGHT))
+    return false; // Pixel out of bounds
+  if (BPP == 1)
+    return (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
+  if (BPP == 4)
+    return (buffer[x / 2 + (y * WIDTH / 2)] & ((x & 1) ? 0x0F : 0xF0));
+  return false;
+}
+
 /*!
     @brief  Clear contents of display buffer (set all pixels to off).
     @note   Changes buffer contents only, no immediate effect on display.
@@ -343,11 +382,7 @@ void Adafruit_GrayOLED::drawPixel(int16_t x, int16_t y, uint16_t color) {
 */
 void Adafruit_GrayOLED::clearDisplay(void) {
   memset(buffer, 0, _bpp * WIDTH * ((HEIGHT + 7) / 8));
-  // set max dirty window
-  window_x1 = 0;
-  window_y1 = 0;
-  window_x2 = WIDTH - 1;
-  window_y2 = HEIGHT - 1;
+  markDirty(); // set max dirty window
 }
 
 /*!
@@ -362,25 +397,7 @@ void Adafruit_GrayOLED::clearDisplay(void) {
             screen if display() has not been called.
 */
 bool Adafruit_GrayOLED::getPixel(int16_t x, int16_t y) {
-  if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
-    // Pixel is in-bounds. Rotate coordinates if needed.
-    switch (getRotation()) {
-    case 1:
-      grayoled_swap(x, y);
-      x = WIDTH - x - 1;
-      break;
-    case 2:
-      x = WIDTH - x - 1;
-      y = HEIGHT - y - 1;
-      break;
-    case 3:
-      grayoled_swap(x, y);
-      y = HEIGHT - y - 1;
-      break;
-    }
-    return (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
-  }
-  return false; // Pixel out of bounds
+  return (this->*pixelReader)(x, y);
 }
 
 /*!
@@ -390,6 +407,54 @@ bool Adafruit_GrayOLED::getPixel(int16_t x, int16_t y) {
 */
 uint8_t *Adafruit_GrayOLED::getBuffer(void) { return buffer; }
 
+/*!
+    @brief  Flag the whole buffer as changed, so the next display() sends
+            all of it (after writing the buffer directly via getBuffer()).
+*/
+void Adafruit_GrayOLED::markDirty(void) {
+  markDirty(0, WIDTH - 1, 0, HEIGHT - 1);
+}
+
+/*!
+    @brief  Forget the dirty window (after it was sent).
+*/
+void Adafruit_GrayOLED::clearDirty(void) {
+  window_x1 = window_y1 = 0x7FFF;
+  window_x2 = window_y2 = -1;
+}
+
+/*!
+    @brief  For a subclass' display(): fetch the window drawn to since the
+            last refresh and reset it. The window is widened to whole bytes
+            of the buffer -- 8-row pages at 1 bpp, even/odd column pairs at
+            4 bpp -- so it can be streamed straight out of the buffer with
+            the controller's column/row address commands.
+    @param  x1  Returns the leftmost column to send.
+    @param  y1  Returns the topmost row to send.
+    @param  x2  Returns the rightmost column to send.
+    @param  y2  Returns the bottom row to send.
+    @return false if nothing was drawn (nothing needs sending).
+*/
+bool Adafruit_GrayOLED::takeDirtyWindow(int16_t *x1, int16_t *y1, int16_t *x2,
+                                        int16_t *y2) {
+  int16_t l = window_x1, t = window_y1, r = window_x2, b = window_y2;
+  clearDirty();
+  if ((l > r) || (t > b))
+    return false;
+  if (_bpp == 1) {
+    t &= ~7;
+    b |= 7;
+  } else if (_bpp == 4) {
+    l &= ~1;
+    r |= 1;
+  }
+  *x1 = l;
+  *y1 = t;
+  *x2 = min(r, (int16_t)(WIDTH - 1));
+  *y2 = min(b, (int16_t)(HEIGHT - 1));
+  return true;
+}
+
 // OTHER HARDWARE SETTINGS -------------------------------------------------
 
 /*!
@@ -70,12 +70,36 @@ public:
   void drawPixel(int16_t x, int16_t y, uint16_t color);
   bool getPixel(int16_t x, int16_t y);
   uint8_t *getBuffer(void);
+  void markDirty(void);
 
   void oled_command(uint8_t c);
   bool oled_commandList(const uint8_t *c, uint8_t n);
 
 protected:
   bool _init(uint8_t i2caddr = 0x3C, bool reset = true);
+  /*!
+      @brief  Grow the dirty window by a region of the buffer (physical,
+              unrotated coordinates, already clipped, inclusive).
+      @param  x1  Leftmost changed column.
+      @param  x2  Rightmost changed column.
+      @param  y1  Topmost changed row.
+      @param  y2  Bottom changed row.
+  */
+  inline void markDirty(int16_t x1, int16_t x2, int16_t y1, int16_t y2) {
+    if (x1 < window_x1)
+      window_x1 = x1;
+    if (x2 > window_x2)
+      window_x2 = x2;
+    if (y1 < window_y1)
+      window_y1 = y1;
+    if (y2 > window_y2)
+      window_y2 = y2;
+  }
+  void clearDirty(void);
+  bool takeDirtyWindow(int16_t *x1, int16_t *y1, int16_t *x2, int16_t *y2);
+  template <uint8_t BPP>
+  void drawPixelBpp(int16_t x, int16_t y, uint16_t color);
+  template <uint8_t BPP> bool getPixelBpp(int16_t x, int16_t y);
 
   Adafruit_SPIDevice *spi_dev = NULL; ///< The SPI interface BusIO device
   Adafruit_I2CDevice *i2c_dev = NULL; ///< The I2C interface BusIO device
@@ -93,6 +117,13 @@ protected:
       rstPin; ///< The Arduino pin connected to reset (-1 if unused)
 
   uint8_t _bpp = 1; ///< Bits per pixel color for this display
+  /// drawPixel() for this depth, picked by _init()
+  void (Adafruit_GrayOLED::*pixelWriter)(int16_t, int16_t, uint16_t) =
+      &Adafruit_GrayOLED::drawPixelBpp<1>;
+  /// getPixel() for this depth, picked by _init()
+  bool (Adafruit_GrayOLED::*pixelReader)(int16_t, int16_t) =
+      &Adafruit_GrayOLED::getPixelBpp<1>;
+
 private:
   TwoWire *_theWire = NULL; ///< The underlying hardware I2C
 };
@@ -60,6 +60,10 @@
 #define digitalPinToPort(P) (&(PORT_IOBUS->Group[g_APinDescription[P].ulPort]))
 #endif // end PORT_IOBUS
 
+#if defined(USE_SPI_DMA) && defined(ESP32)
+#include <esp_heap_caps.h> // heap_caps_malloc() for DMA-capable buffers
+#endif
+
 #if defined(USE_SPI_DMA) && (defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO))
 // #pragma message ("GFX DMA IS ENABLED. HIGHLY EXPERIMENTAL.")
 #include "wiring_private.h" // pinPeripheral() function
@@ -592,6 +596,11 @@ void Adafruit_SPITFT::initSPI(uint32_t freq, uint8_t spiMode) {
     ) {
       hwspi._spi->begin();
     }
+#if defined(USE_SPI_DMA) && defined(ESP32)
+    dmaFreq = freq;
+    if (hwspi._spi == &SPI)
+      initDMA(); // Falls back on CPU writes if this fails
+#endif
   } else if (connection == TFT_SOFT_SPI) {
 
     pinMode(swspi._mosi, OUTPUT);
@@ -910,6 +919,15 @@ void Adafruit_SPITFT::setSPISpeed(uint32_t freq) {
 #else
   hwspi._freq = freq; // Save freq value for later
 #endif
+#if defined(USE_SPI_DMA) && defined(ESP32)
+  dmaFreq = freq;
+  if (dmaDevice) { // The IDF fixes a device's clock when it is added
+    dmaWait();
+    spi_bus_remove_device(dmaDevice);
+    dmaDevice = NULL;
+    addDMADevice();
+  }
+#endif
 }
 
 /*!
@@ -931,6 +949,9 @@ void Adafruit_SPITFT::startWrite(void) {
             for all display types; not an SPI-specific function.
 */
 void Adafruit_SPITFT::endWrite(void) {
+#if defined(USE_SPI_DMA) && defined(ESP32)
+  dmaWait(); // Don't deselect with a non-blocking writePixels() in flight
+#endif
   if (_cs >= 0)
     SPI_CS_HIGH();
   SPI_END_TRANSACTION();
@@ -966,14 +987,13 @@ void Adafruit_SPITFT::writePixel(int16_t x, int16_t y, uint16_t color) {
     @param  len   Number of pixels to byte-swap.
     @param  dest  Optional destination address if different than src --
                   otherwise, if NULL (default) or same address is passed,
-                  pixel buffer is overwritten in-place.
+                  pixel buffer is overwritten in-place. Copying this way
+                  is a single pass over src (see GFXcanvas16::byteSwap()).
 */
 void Adafruit_SPITFT::swapBytes(uint16_t *src, uint32_t len, uint16_t *dest) {
   if (!dest)
     dest = src; // NULL -> overwrite src buffer
-  for (uint32_t i = 0; i < len; i++) {
-    dest[i] = __builtin_bswap16(src[i]);
-  }
+  GFXcanvas16::byteSwap(dest, src, len);
 }
 
 /*!
@@ -1013,6 +1033,43 @@ void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
 
 #if defined(ESP32)
   if (connection == TFT_HARD_SPI) {
+#if defined(USE_SPI_DMA)
+    if (dmaDevice) {
+      dmaFillLen = 0; // Overwrites what writeColor() left in dmaBuf[0]
+      // Each chunk is copied (and byte-swapped if needed) into whichever
+      // ping-pong buffer is free while the other one is being sent, so
+      // the copy overlaps the transfer and 'colors' may be reused as soon
+      // as this returns, even when not blocking.
+      while (len) {
+        uint32_t count = (len < SPITFT_DMA_PIXELS) ? len : SPITFT_DMA_PIXELS;
+        if (dmaQueued > 1)
+          dmaReap(); // Oldest transfer, which used dmaBuf[dmaNext]
+        uint16_t *buf = dmaBuf[dmaNext];
+        if (bigEndian)
+          memcpy(buf, colors, count * 2);
+        else
+          swapBytes(colors, count, buf);
+        spi_transaction_t *t = &dmaTrans[dmaNext];
+        memset(t, 0, sizeof(spi_transaction_t));
+        t->length = count * 16; // In bits
+        t->tx_buffer = buf;
+        t->user = this;
+        if (spi_device_queue_trans(dmaDevice, t, portMAX_DELAY) != ESP_OK) {
+          dmaWait(); // Shouldn't happen; finish with CPU writes
+          break;
+        }
+        dmaIssued++;
+        dmaQueued++;
+        dmaNext ^= 1;
+        colors += count;
+        len -= count;
+      }
+      if (block)
+        dmaWait();
+      if (!len)
+        return;
+    }
+#endif // end USE_SPI_DMA
     if (!bigEndian) {
       hwspi._spi->writePixels(colors, len * 2); // Inbuilt endian-swap
     } else {
@@ -1172,10 +1229,15 @@ void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
     @brief  Wait for the last DMA transfer in a prior non-blocking
             writePixels() call to complete. This does nothing if DMA
             is not enabled, and is not needed if blocking writePixels()
-            was used (as is the default case).
+            was used (as is the default case). On ESP32, endWrite() calls
+            this itself.
 */
 void Adafruit_SPITFT::dmaWait(void) {
-#if defined(USE_SPI_DMA) && (defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO))
+#if defined(USE_SPI_DMA) && defined(ESP32)
+  while (dmaQueued)
+    dmaReap();
+#elif defined(USE_SPI_DMA) &&                                                  \
+    (defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO))
   while (dma_busy)
     ;
 #if defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO)
@@ -1195,13 +1257,120 @@ void Adafruit_SPITFT::dmaWait(void) {
     @return true if DMA is enabled and transmitting data, false otherwise.
 */
 bool Adafruit_SPITFT::dmaBusy(void) const {
-#if defined(USE_SPI_DMA) && (defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO))
+#if defined(USE_SPI_DMA) && defined(ESP32)
+  return dmaIssued != dmaFinished;
+#elif defined(USE_SPI_DMA) &&                                                  \
+    (defined(__SAMD51__) || defined(ARDUINO_SAMD_ZERO))
   return dma_busy;
 #else
   return false;
 #endif
 }
 
+#if defined(USE_SPI_DMA) && defined(ESP32)
+
+/*!
+    @brief  Attach the ESP-IDF SPI master driver, with DMA, to the SPI
+            host behind hwspi._spi, so writePixels() and writeColor() can
+            queue transfers instead of feeding the SPI FIFO from the CPU.
+            Called by initSPI() for the default SPI object; a subclass or
+            sketch using another SPIClass calls it after begin(). The
+            Arduino SPI driver keeps owning the pins, chip-select and all
+            command traffic; the IDF only ever sees pixel data.
+    @param  host  IDF host matching hwspi._spi, e.g. SPI2_HOST for an
+                  SPIClass(HSPI) on ESP32.
+    @return true if DMA is in use, false if not (hardware SPI is not in
+            use, or buffers or the DMA channel couldn't be allocated) --
+            pixels are then written by the CPU as before.
+*/
+bool Adafruit_SPITFT::initDMA(spi_host_device_t host) {
+  if (connection != TFT_HARD_SPI)
+    return false;
+  if (dmaDevice)
+    return true;
+
+  for (uint8_t i = 0; i < 2; i++) {
+    if (!dmaBuf[i])
+      dmaBuf[i] = (uint16_t *)heap_caps_malloc(SPITFT_DMA_PIXELS * 2,
+                                               MALLOC_CAP_DMA);
+  }
+  if (dmaBuf[0] && dmaBuf[1]) {
+    // No pins: the GPIO matrix keeps the routing SPI.begin() set up
+    spi_bus_config_t bus;
+    memset(&bus, 0, sizeof(bus));
+    bus.mosi_io_num = bus.miso_io_num = bus.sclk_io_num = -1;
+    bus.quadwp_io_num = bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = SPITFT_DMA_PIXELS * 2;
+    esp_err_t err = spi_bus_initialize(host, &bus, SPI_DMA_CH_AUTO);
+    // INVALID_STATE: another library already initialized this host
+    if ((err == ESP_OK) || (err == ESP_ERR_INVALID_STATE)) {
+      dmaHost = host;
+      if (addDMADevice()) {
+        // spi_bus_initialize() reset the host's registers. One byte
+        // through the IDF, with the display still deselected, puts back
+        // MOSI, MISO and full-duplex mode for the Arduino driver.
+        spi_transaction_t t;
+        memset(&t, 0, sizeof(t));
+        t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+        t.length = 8;
+        t.user = this;
+        spi_device_polling_transmit(dmaDevice, &t);
+        dmaIssued = dmaFinished; // Not one of ours, don't count it as busy
+        return true;
+      }
+    }
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    heap_caps_free(dmaBuf[i]);
+    dmaBuf[i] = NULL;
+  }
+  return false;
+}
+
+/*!
+    @brief  Add the display to the IDF host at the current clock and SPI
+            mode.
+    @return true on success, false if the IDF refused the device.
+*/
+bool Adafruit_SPITFT::addDMADevice(void) {
+  spi_device_interface_config_t dev;
+  memset(&dev, 0, sizeof(dev));
+  dev.mode = hwspi._mode; // SPI_MODEn is n on ESP32
+  dev.clock_speed_hz = dmaFreq;
+  dev.spics_io_num = -1; // CS is ours, held low from startWrite()
+  dev.flags = SPI_DEVICE_NO_DUMMY;
+  dev.queue_size = 2; // One per ping-pong buffer
+  dev.post_cb = dmaDone;
+  if (spi_bus_add_device(dmaHost, &dev, &dmaDevice) != ESP_OK) {
+    dmaDevice = NULL;
+    return false;
+  }
+  return true;
+}
+
+/*!
+    @brief  Wait for the oldest queued DMA transfer to finish and take its
+            result off the IDF queue, which frees its buffer.
+*/
+void Adafruit_SPITFT::dmaReap(void) {
+  spi_transaction_t *done;
+  if (spi_device_get_trans_result(dmaDevice, &done, portMAX_DELAY) == ESP_OK)
+    dmaQueued--;
+  else
+    dmaQueued = 0; // Nothing the driver knows of left to wait for
+}
+
+/*!
+    @brief  IDF post-transfer callback, runs in the SPI interrupt. Only
+            bumps a counter so dmaBusy() can poll without the queue.
+    @param  t  The finished transfer; t->user is the display.
+*/
+void IRAM_ATTR Adafruit_SPITFT::dmaDone(spi_transaction_t *t) {
+  ((Adafruit_SPITFT *)t->user)->dmaFinished++;
+}
+
+#endif // end USE_SPI_DMA && ESP32
+
 /*!
     @brief  Issue a series of pixels, all the same color. Not self-
             contained; should follow startWrite() and setAddrWindow() calls.
@@ -1217,6 +1386,41 @@ void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
 
 #if defined(ESP32) // ESP32 has a special SPI pixel-writing function...
   if (connection == TFT_HARD_SPI) {
+#if defined(USE_SPI_DMA)
+    if (dmaDevice && (len >= SPITFT_DMA_MIN_FILL)) {
+      // One buffer of the color, already byte-swapped, is queued over and
+      // over; both transfers in flight read the same memory. It is only
+      // refilled when the color changes or something else used it.
+      dmaWait();
+      uint32_t bufLen = (len < SPITFT_DMA_PIXELS) ? len : SPITFT_DMA_PIXELS;
+      if ((dmaFillLen < bufLen) || (dmaFillColor != color)) {
+        uint16_t swapped = __builtin_bswap16(color);
+        for (uint32_t i = 0; i < bufLen; i++)
+          dmaBuf[0][i] = swapped;
+        dmaFillColor = color;
+        dmaFillLen = bufLen;
+      }
+      while (len) {
+        uint32_t count = (len < bufLen) ? len : bufLen;
+        if (dmaQueued > 1)
+          dmaReap();
+        spi_transaction_t *t = &dmaTrans[dmaNext];
+        memset(t, 0, sizeof(spi_transaction_t));
+        t->length = count * 16; // In bits
+        t->tx_buffer = dmaBuf[0];
+        t->user = this;
+        if (spi_device_queue_trans(dmaDevice, t, portMAX_DELAY) != ESP_OK)
+          break; // Shouldn't happen; finish with CPU writes
+        dmaIssued++;
+        dmaQueued++;
+        dmaNext ^= 1;
+        len -= count;
+      }
+      dmaWait(); // Sleeps this task (not a spin) until the fill is out
+      if (!len)
+        return;
+    }
+#endif // end USE_SPI_DMA
 #define SPI_MAX_PIXELS_AT_ONCE 32
 #define TMPBUF_LONGWORDS (SPI_MAX_PIXELS_AT_ONCE + 1) / 2
 #define TMPBUF_PIXELS (TMPBUF_LONGWORDS * 2)
@@ -1232,7 +1436,7 @@ void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
     // Issue pixels in blocks from temp buffer
     while (len) {                              // While pixels remain
       xferLen = (bufLen < len) ? bufLen : len; // How many this pass?
-      writePixels((uint16_t *)temp, xferLen);
+      hwspi._spi->writePixels(temp, xferLen * 2); // Inbuilt endian-swap
       len -= xferLen;
     }
     return;
@@ -1918,6 +2122,68 @@ void Adafruit_SPITFT::drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors,
   endWrite();
 }
 
+/*!
+    @brief  Render the whole screen through a strip canvas instead of a
+            framebuffer: for each band of rows the scene callback draws
+            everything, in screen coordinates, and the band is sent with
+            setAddrWindow() and writePixels(). With DMA the band goes out
+            non-blocking, so drawing the next one overlaps the transfer.
+            A 320x240 scene in 6-line strips takes under 4 KB instead of
+            150 KB; the cost is one pass of the draw calls per strip (the
+            strip's clip rectangle rejects calls outside it cheaply).
+            Self-contained; don't call inside startWrite()/endWrite().
+    @param  draw   Scene callback. The strip still holds the previous
+                   band's pixels, so it normally starts with fillScreen().
+                   It must not use the SPI bus itself.
+    @param  arg    Passed through to draw.
+    @param  lines  Rows per strip. 0 (default) picks as many as fit the
+                   ESP32 DMA ping-pong buffers so a whole strip is queued
+                   at once, or SPITFT_STRIP_LINES on other targets.
+    @return true on success, false if the strip couldn't be allocated.
+*/
+bool Adafruit_SPITFT::drawStrips(GFXstripDraw draw, void *arg,
+                                 uint16_t lines) {
+  if (!lines) {
+#if defined(USE_SPI_DMA) && defined(ESP32)
+    lines = dmaDevice ? (2 * SPITFT_DMA_PIXELS) / _width : SPITFT_STRIP_LINES;
+#else
+    lines = SPITFT_STRIP_LINES;
+#endif
+  }
+  if (lines > _height)
+    lines = _height;
+  if (!lines)
+    lines = 1; // Screen wider than the DMA buffers
+
+  // Kept between frames; rebuilt after a rotation or another strip height
+  if (strip && ((strip->width() != _width) || (strip->height() != _height) ||
+                (strip->maxLines() != lines))) {
+    delete strip;
+    strip = NULL;
+  }
+  if (!strip) {
+    strip = new GFXstripCanvas16(_width, _height, lines);
+    if (!strip->getBuffer()) {
+      delete strip;
+      strip = NULL;
+      return false;
+    }
+  }
+
+  startWrite();
+  for (int16_t y = 0; y < _height; y += lines) {
+    uint16_t n = min((int16_t)lines, (int16_t)(_height - y));
+    strip->setStrip(y, n);
+    draw(*strip, arg);
+    dmaWait(); // Previous strip must be out before the window moves
+    setAddrWindow(0, y, _width, n);
+    writePixels(strip->getBuffer(), (uint32_t)_width * n, false);
+  }
+  dmaWait();
+  endWrite();
+  return true;
+}
+
 // -------------------------------------------------------------------------
 // Miscellaneous class member functions that don't draw anything.
 
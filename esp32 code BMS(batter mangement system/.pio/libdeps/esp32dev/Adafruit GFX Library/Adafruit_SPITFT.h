@@ -92,6 +92,27 @@ typedef volatile ADAGFX_PORT_t *PORTreg_t; ///< PORT register type
 #include <Adafruit_ZeroDMA.h>
 #endif
 
+// On ESP32 the same USE_SPI_DMA switch hands hardware SPI pixel data to the
+// IDF SPI master driver, through two DMA-capable buffers of
+// SPITFT_DMA_PIXELS each (2 x 2 KB by default): one is filled while the
+// other is on the wire.
+#if defined(USE_SPI_DMA) && defined(ESP32)
+#include <driver/spi_master.h>
+#if !defined(SPITFT_DMA_PIXELS)
+#define SPITFT_DMA_PIXELS 1024 ///< Pixels per ESP32 DMA ping-pong buffer
+#endif
+#if !defined(SPITFT_DMA_MIN_FILL)
+#define SPITFT_DMA_MIN_FILL 128 ///< Shorter writeColor() runs skip DMA setup
+#endif
+#if !defined(SPITFT_DMA_HOST)
+#if defined(CONFIG_IDF_TARGET_ESP32)
+#define SPITFT_DMA_HOST SPI3_HOST ///< VSPI, the host behind the SPI object
+#else
+#define SPITFT_DMA_HOST SPI2_HOST ///< FSPI, the host behind the SPI object
+#endif
+#endif
+#endif
+
 // This is kind of a kludge. Needed a way to disambiguate the software SPI
 // and parallel constructors via their argument lists. Originally tried a
 // bool as the first argument to the parallel constructor (specifying 8-bit
@@ -103,6 +124,20 @@ typedef volatile ADAGFX_PORT_t *PORTreg_t; ///< PORT register type
 /*! For first arg to parallel constructor */
 enum tftBusWidth { tft8bitbus, tft16bitbus };
 
+/*!
+  @brief  Scene callback for Adafruit_SPITFT::drawStrips(): draws the whole
+          screen, in screen coordinates, on whatever it is handed. Called
+          once per strip; only the current strip's rows are kept.
+  @param  gfx  Strip canvas to draw on (the same code can draw straight
+               onto the display, or onto any other Adafruit_GFX)
+  @param  arg  Pointer passed to drawStrips()
+*/
+typedef void (*GFXstripDraw)(Adafruit_GFX &gfx, void *arg);
+
+#if !defined(SPITFT_STRIP_LINES)
+#define SPITFT_STRIP_LINES 16 ///< drawStrips() rows per strip without DMA
+#endif
+
 // SPI defaults for RP2040
 #if defined(ARDUINO_ARCH_RP2040)
 #ifndef __SPI0_DEVICE
@@ -168,7 +203,7 @@ public:
 
   // DESTRUCTOR ----------------------------------------------------------
 
-  ~Adafruit_SPITFT(){};
+  ~Adafruit_SPITFT() { delete strip; };
 
   // CLASS MEMBER FUNCTIONS ----------------------------------------------
 
@@ -246,6 +281,11 @@ public:
   // Used by writePixels() in some situations, but might have rare need in
   // user code, so it's public...
   bool dmaBusy(void) const; // true if DMA is used and busy, false otherwise
+#if defined(USE_SPI_DMA) && defined(ESP32)
+  // Attach the IDF DMA driver to the host behind hwspi._spi. initSPI()
+  // does this for the default SPI object; call it after begin() for others.
+  bool initDMA(spi_host_device_t host = SPITFT_DMA_HOST);
+#endif
   void swapBytes(uint16_t *src, uint32_t len, uint16_t *dest = NULL);
 
   // These functions are similar to the 'write' functions above, but with
@@ -264,6 +304,10 @@ public:
   using Adafruit_GFX::drawRGBBitmap; // Check base class first
   void drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors, int16_t w,
                      int16_t h);
+  // Full-screen rendering without a full-screen framebuffer: the scene is
+  // drawn into one band of rows at a time, each sent while the next is
+  // drawn (with DMA). lines = 0 picks a size that fits the DMA buffers.
+  bool drawStrips(GFXstripDraw draw, void *arg = NULL, uint16_t lines = 0);
 
   void invertDisplay(bool i);
   uint16_t color565(uint8_t r, uint8_t g, uint8_t b);
@@ -511,6 +555,22 @@ protected:
   uint32_t lastFillLen = 0;          ///< # of pixels w/last fill
   uint8_t onePixelBuf;               ///< For hi==lo fill
 #endif
+#if defined(USE_SPI_DMA) && defined(ESP32) // Used by hardware SPI only
+  bool addDMADevice(void);
+  void dmaReap(void);
+  static void dmaDone(spi_transaction_t *t);
+  spi_device_handle_t dmaDevice = NULL; ///< IDF device, NULL if no DMA
+  spi_host_device_t dmaHost = SPITFT_DMA_HOST; ///< Host shared with _spi
+  spi_transaction_t dmaTrans[2];        ///< One per ping-pong buffer
+  uint16_t *dmaBuf[2] = {NULL, NULL};   ///< DMA-capable ping-pong buffers
+  uint32_t dmaFreq = DEFAULT_SPI_FREQ;  ///< SPI clock of the IDF device
+  uint16_t dmaFillColor = 0;            ///< Color held by dmaBuf[0]
+  uint16_t dmaFillLen = 0;              ///< Pixels of dmaBuf[0] holding it
+  uint8_t dmaNext = 0;                  ///< Buffer the next chunk goes in
+  uint8_t dmaQueued = 0;                ///< Transfers with unread results
+  uint8_t dmaIssued = 0;                ///< Transfers queued, ever (wraps)
+  volatile uint8_t dmaFinished = 0;     ///< Transfers done, ever (wraps)
+#endif
 #if defined(USE_FAST_PINIO)
 #if defined(HAS_PORT_SET_CLR)
 #if !defined(KINETISK)
@@ -535,6 +595,8 @@ protected:
   uint8_t invertOffCommand = 0; ///< Command to disable invert mode
 
   uint32_t _freq = 0; ///< Dummy var to keep subclasses happy
+
+  GFXstripCanvas16 *strip = NULL; ///< drawStrips() canvas, kept for reuse
 };
 
 #endif // end __AVR_ATtiny85__ __AVR_ATtiny84__
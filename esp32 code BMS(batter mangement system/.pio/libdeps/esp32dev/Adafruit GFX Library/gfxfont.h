@@ -7,6 +7,16 @@
 #ifndef _GFXFONT_H_
 #define _GFXFONT_H_
 
+#define GFXFONT_RAW 0 ///< GFXfont::format: glyph bitmaps are packed bits
+#define GFXFONT_RLE 1 ///< GFXfont::format: glyph bitmaps are run lengths
+
+// RLE glyphs (fontconvert -r) store the glyph's w*h pixels, row after row,
+// as alternating background / foreground runs starting with background
+// (the first run may be 0). Each run is one or more nibbles, high nibble
+// first: a nibble of 15 adds 15 pixels and the run continues with the next
+// nibble, any other value ends the run. A glyph's data is padded to a whole
+// byte; bitmapOffset points at its first byte as for raw glyphs.
+
 /// Font data stored PER GLYPH
 typedef struct {
   uint16_t bitmapOffset; ///< Pointer into GFXfont->bitmap
@@ -24,6 +34,7 @@ typedef struct {
   uint16_t first;   ///< ASCII extents (first char)
   uint16_t last;    ///< ASCII extents (last char)
   uint8_t yAdvance; ///< Newline distance (y axis)
+  uint8_t format;   ///< GFXFONT_RAW (0, also when omitted) or GFXFONT_RLE
 } GFXfont;
 
 #endif // _GFXFONT_H_
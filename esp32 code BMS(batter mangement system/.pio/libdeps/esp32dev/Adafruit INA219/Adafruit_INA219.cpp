@@ -43,7 +43,12 @@ Adafruit_INA219::Adafruit_INA219(uint8_t addr) {
 /*!
  *  @brief INA219 class destructor
  */
-Adafruit_INA219::~Adafruit_INA219() { delete i2c_dev; }
+Adafruit_INA219::~Adafruit_INA219() {
+  for (uint8_t reg = 0; reg < INA219_REG_COUNT; reg++) {
+    delete ina219_reg[reg];
+  }
+  delete i2c_dev;
+}
 
 /*!
  *  @brief  Sets up the HW (defaults to 32V and 2A for calibration values)
@@ -53,6 +58,10 @@ Adafruit_INA219::~Adafruit_INA219() { delete i2c_dev; }
 bool Adafruit_INA219::begin(TwoWire *theWire) {
   if (!i2c_dev) {
     i2c_dev = new Adafruit_I2CDevice(ina219_i2caddr, theWire);
+    // Built once so a register access is just address, width and order
+    for (uint8_t reg = 0; reg < INA219_REG_COUNT; reg++) {
+      ina219_reg[reg] = new Adafruit_BusIO_Register(i2c_dev, reg, 2, MSBFIRST);
+    }
   }
 
   if (!i2c_dev->begin()) {
@@ -77,9 +86,7 @@ void Adafruit_INA219::init() {
 int16_t Adafruit_INA219::getBusVoltage_raw() {
   uint16_t value;
 
-  Adafruit_BusIO_Register bus_voltage_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_BUSVOLTAGE, 2, MSBFIRST);
-  _success = bus_voltage_reg.read(&value);
+  _success = readRegister(INA219_REG_BUSVOLTAGE, &value);
 
   // Shift to the right 3 to drop CNVR and OVF and multiply by LSB
   return (int16_t)((value >> 3) * 4);
@@ -91,9 +98,7 @@ int16_t Adafruit_INA219::getBusVoltage_raw() {
  */
 int16_t Adafruit_INA219::getShuntVoltage_raw() {
   uint16_t value;
-  Adafruit_BusIO_Register shunt_voltage_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_SHUNTVOLTAGE, 2, MSBFIRST);
-  _success = shunt_voltage_reg.read(&value);
+  _success = readRegister(INA219_REG_SHUNTVOLTAGE, &value);
   return value;
 }
 
@@ -107,15 +112,17 @@ int16_t Adafruit_INA219::getCurrent_raw() {
   // Sometimes a sharp load will reset the INA219, which will
   // reset the cal register, meaning CURRENT and POWER will
   // not be available ... avoid this by always setting a cal
-  // value even if it's an unfortunate extra step
-  Adafruit_BusIO_Register calibration_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CALIBRATION, 2, MSBFIRST);
-  calibration_reg.write(ina219_calValue, 2);
+  // value even if it's an unfortunate extra step, unless the caller
+  // opted into checking for a reset instead (setTrustedCalibration)
+  if (!ina219_trustedCal) {
+    writeCalibration();
+  }
 
   // Now we can safely read the CURRENT register!
-  Adafruit_BusIO_Register current_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CURRENT, 2, MSBFIRST);
-  _success = current_reg.read(&value);
+  _success = readRegister(INA219_REG_CURRENT, &value);
+  if (ina219_trustedCal) {
+    checkCalibration(false);
+  }
   return value;
 }
 
@@ -129,15 +136,17 @@ int16_t Adafruit_INA219::getPower_raw() {
   // Sometimes a sharp load will reset the INA219, which will
   // reset the cal register, meaning CURRENT and POWER will
   // not be available ... avoid this by always setting a cal
-  // value even if it's an unfortunate extra step
-  Adafruit_BusIO_Register calibration_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CALIBRATION, 2, MSBFIRST);
-  calibration_reg.write(ina219_calValue, 2);
+  // value even if it's an unfortunate extra step, unless the caller
+  // opted into checking for a reset instead (setTrustedCalibration)
+  if (!ina219_trustedCal) {
+    writeCalibration();
+  }
 
   // Now we can safely read the POWER register!
-  Adafruit_BusIO_Register power_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_POWER, 2, MSBFIRST);
-  _success = power_reg.read(&value);
+  _success = readRegister(INA219_REG_POWER, &value);
+  if (ina219_trustedCal) {
+    checkCalibration(false);
+  }
   return value;
 }
 
@@ -148,7 +157,7 @@ int16_t Adafruit_INA219::getPower_raw() {
 float Adafruit_INA219::getShuntVoltage_mV() {
   int16_t value;
   value = getShuntVoltage_raw();
-  return value * 0.01;
+  return value * 0.01f;
 }
 
 /*!
@@ -157,7 +166,7 @@ float Adafruit_INA219::getShuntVoltage_mV() {
  */
 float Adafruit_INA219::getBusVoltage_V() {
   int16_t value = getBusVoltage_raw();
-  return value * 0.001;
+  return value * 0.001f;
 }
 
 /*!
@@ -256,20 +265,175 @@ void Adafruit_INA219::setCalibration_32V_2A() {
   // Set multipliers to convert raw current/power values
   ina219_currentDivider_mA = 10; // Current LSB = 100uA per bit (1000/100 = 10)
   ina219_powerMultiplier_mW = 2; // Power LSB = 1mW per bit (2/1)
+  ina219_currentLSB_uA_q16 = 100UL << 16;
 
   // Set Calibration register to 'Cal' calculated above
-  Adafruit_BusIO_Register calibration_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CALIBRATION, 2, MSBFIRST);
-  calibration_reg.write(ina219_calValue, 2);
+  writeRegister(INA219_REG_CALIBRATION, ina219_calValue);
 
   // Set Config register to take into account the settings above
   uint16_t config = INA219_CONFIG_BVOLTAGERANGE_32V |
                     INA219_CONFIG_GAIN_8_320MV | INA219_CONFIG_BADCRES_12BIT |
                     INA219_CONFIG_SADCRES_12BIT_1S_532US |
                     INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS;
-  Adafruit_BusIO_Register config_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CONFIG, 2, MSBFIRST);
-  _success = config_reg.write(config, 2);
+  ina219_configValue = config;
+  _success = writeRegister(INA219_REG_CONFIG, config);
+}
+
+/*!
+ *  @brief  Reads shunt voltage, bus voltage, current and power in one pass.
+ *          The power register is read first because reading it clears the
+ *          conversion-ready (CNVR) flag; the bus voltage register is read
+ *          last, and CNVR set there means a conversion completed mid-burst,
+ *          so the burst is repeated. With no extra calibration write this is
+ *          four register reads instead of the six the getters need.
+ *          readAll() cannot tell whether the conversion was already
+ *          returned by a previous call and always sets ready = false; use
+ *          readFresh() for that.
+ *  @param  sample
+ *          filled with raw and scaled values
+ *  @return true if every register read succeeded and the calibration
+ *          held (with setTrustedCalibration, false after a lost calibration
+ *          was restored: that burst's current and power are not valid)
+ */
+bool Adafruit_INA219::readAll(Ina219Sample &sample) {
+  if (!ina219_trustedCal) {
+    writeCalibration();
+  }
+
+  uint16_t shunt, bus, current, power;
+  bool ok = false;
+  sample.coherent = false;
+  for (uint8_t attempt = 0; attempt < INA219_READALL_ATTEMPTS; attempt++) {
+    ok = readRegister(INA219_REG_POWER, &power) &&
+         readRegister(INA219_REG_SHUNTVOLTAGE, &shunt) &&
+         readRegister(INA219_REG_CURRENT, &current) &&
+         readRegister(INA219_REG_BUSVOLTAGE, &bus);
+    if (!ok) {
+      break;
+    }
+    if (!(bus & INA219_BUS_CNVR)) {
+      sample.coherent = true;
+      break;
+    }
+  }
+  _success = ok;
+  if (ok && ina219_trustedCal &&
+      checkCalibration(current == 0 && shuntImpliesCurrent((int16_t)shunt))) {
+    // Current and power came from the reset calibration: not a reading
+    sample.coherent = false;
+    ok = false;
+  }
+
+  sample.ready = false;
+  sample.overflow = ok && (bus & INA219_BUS_OVF);
+  sample.shunt_raw = (int16_t)shunt;
+  sample.bus_raw = (int16_t)((bus >> 3) * 4);
+  sample.current_raw = (int16_t)current;
+  sample.power_raw = (int16_t)power;
+  // Single-precision constants: a double literal would promote to
+  // software double math on the ESP32
+  sample.shunt_mV = sample.shunt_raw * 0.01f;
+  sample.bus_V = sample.bus_raw * 0.001f;
+  sample.current_mA = (float)sample.current_raw / ina219_currentDivider_mA;
+  sample.power_mW = sample.power_raw * ina219_powerMultiplier_mW;
+  // Integer path: shunt LSB 10 uV, bus in mV, power LSB 20x current LSB
+  sample.shunt_uV = (int32_t)sample.shunt_raw * 10;
+  sample.bus_uV = (int32_t)sample.bus_raw * 1000;
+  sample.current_uA = (int32_t)(
+      ((int64_t)sample.current_raw * ina219_currentLSB_uA_q16) >> 16);
+  sample.power_uW = (int32_t)(
+      ((int64_t)sample.power_raw * 20 * ina219_currentLSB_uA_q16) >> 16);
+  return ok;
+}
+
+/*!
+ *  @brief  Waits for a conversion that no previous read has returned, then
+ *          reads it with readAll(). The conversion-ready (CNVR) flag is
+ *          polled in the bus voltage register; it is set when a conversion
+ *          completes and cleared by the power register read inside
+ *          readAll(), so the same conversion is never returned twice.
+ *  @param  sample
+ *          filled as by readAll() when a new conversion arrives; otherwise
+ *          only ready (false) and overflow are updated
+ *  @param  timeout_us
+ *          how long to poll; 0 checks once and returns immediately
+ *  @return true if no I2C error occurred and the calibration held (see
+ *          readAll()); check sample.ready for new data
+ */
+bool Adafruit_INA219::readFresh(Ina219Sample &sample, uint32_t timeout_us) {
+  uint32_t start = micros();
+  uint16_t bus;
+  for (;;) {
+    if (!readRegister(INA219_REG_BUSVOLTAGE, &bus)) {
+      _success = false;
+      sample.ready = false;
+      return false;
+    }
+    if (bus & INA219_BUS_CNVR) {
+      break;
+    }
+    if (micros() - start >= timeout_us) {
+      _success = true;
+      sample.ready = false;
+      sample.overflow = bus & INA219_BUS_OVF;
+      return true;
+    }
+    delayMicroseconds(INA219_CNVR_POLL_US);
+  }
+
+  bool ok = readAll(sample);
+  sample.ready = ok;
+  return ok;
+}
+
+/*!
+ *  @brief  Starts a single shunt and bus conversion (triggered mode). The
+ *          chip stays idle between triggers; pair with readFresh() and a
+ *          timeout of at least the configured conversion time.
+ */
+void Adafruit_INA219::triggerConversion() {
+  ina219_configValue = (ina219_configValue & ~INA219_CONFIG_MODE_MASK) |
+                       INA219_CONFIG_MODE_SANDBVOLT_TRIGGERED;
+  _success = writeRegister(INA219_REG_CONFIG, ina219_configValue);
+}
+
+/*!
+ *  @brief  Reads one 16-bit register
+ *  @param  reg
+ *          register address
+ *  @param  value
+ *          receives the register contents
+ *  @return true on success
+ */
+bool Adafruit_INA219::readRegister(uint8_t reg, uint16_t *value) {
+  Adafruit_BusIO_Register *r = ina219_reg[reg];
+  return r && r->read(value);
+}
+
+/*!
+ *  @brief  Writes one 16-bit register; the cached register object keeps a
+ *          copy, see cachedRegister()
+ *  @param  reg
+ *          register address
+ *  @param  value
+ *          new register contents
+ *  @return true on success
+ */
+bool Adafruit_INA219::writeRegister(uint8_t reg, uint16_t value) {
+  Adafruit_BusIO_Register *r = ina219_reg[reg];
+  return r && r->write(value, 2);
+}
+
+/*!
+ *  @brief  Last value written to a register (config or calibration), from
+ *          the cached register object; no I2C traffic
+ *  @param  reg
+ *          register address
+ *  @return the value, or 0 if nothing was written yet
+ */
+uint16_t Adafruit_INA219::cachedRegister(uint8_t reg) {
+  Adafruit_BusIO_Register *r = reg < INA219_REG_COUNT ? ina219_reg[reg] : NULL;
+  return r ? (uint16_t)r->readCached() : 0;
 }
 
 /*!
@@ -278,16 +442,11 @@ void Adafruit_INA219::setCalibration_32V_2A() {
  *          boolean value
  */
 void Adafruit_INA219::powerSave(bool on) {
-  Adafruit_BusIO_Register config_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CONFIG, 2, MSBFIRST);
-
-  Adafruit_BusIO_RegisterBits mode_bits =
-      Adafruit_BusIO_RegisterBits(&config_reg, 3, 0);
-  if (on) {
-    _success = mode_bits.write(INA219_CONFIG_MODE_POWERDOWN);
-  } else {
-    _success = mode_bits.write(INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS);
-  }
+  // The config register is tracked, so no read-modify-write is needed
+  uint16_t mode = on ? INA219_CONFIG_MODE_POWERDOWN
+                     : INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS;
+  ina219_configValue = (ina219_configValue & ~INA219_CONFIG_MODE_MASK) | mode;
+  _success = writeRegister(INA219_REG_CONFIG, ina219_configValue);
 }
 
 /*!
@@ -367,20 +526,18 @@ void Adafruit_INA219::setCalibration_32V_1A() {
   // Set multipliers to convert raw current/power values
   ina219_currentDivider_mA = 25;    // Current LSB = 40uA per bit (1000/40 = 25)
   ina219_powerMultiplier_mW = 0.8f; // Power LSB = 800uW per bit
+  ina219_currentLSB_uA_q16 = 40UL << 16;
 
   // Set Calibration register to 'Cal' calculated above
-  Adafruit_BusIO_Register calibration_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CALIBRATION, 2, MSBFIRST);
-  calibration_reg.write(ina219_calValue, 2);
+  writeRegister(INA219_REG_CALIBRATION, ina219_calValue);
 
   // Set Config register to take into account the settings above
   uint16_t config = INA219_CONFIG_BVOLTAGERANGE_32V |
                     INA219_CONFIG_GAIN_8_320MV | INA219_CONFIG_BADCRES_12BIT |
                     INA219_CONFIG_SADCRES_12BIT_1S_532US |
                     INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS;
-  Adafruit_BusIO_Register config_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CONFIG, 2, MSBFIRST);
-  _success = config_reg.write(config, 2);
+  ina219_configValue = config;
+  _success = writeRegister(INA219_REG_CONFIG, config);
 }
 
 /*!
@@ -459,20 +616,163 @@ void Adafruit_INA219::setCalibration_16V_400mA() {
   // Set multipliers to convert raw current/power values
   ina219_currentDivider_mA = 20;    // Current LSB = 50uA per bit (1000/50 = 20)
   ina219_powerMultiplier_mW = 1.0f; // Power LSB = 1mW per bit
+  ina219_currentLSB_uA_q16 = 50UL << 16;
 
   // Set Calibration register to 'Cal' calculated above
-  Adafruit_BusIO_Register calibration_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CALIBRATION, 2, MSBFIRST);
-  calibration_reg.write(ina219_calValue, 2);
+  writeRegister(INA219_REG_CALIBRATION, ina219_calValue);
   // Set Config register to take into account the settings above
   uint16_t config = INA219_CONFIG_BVOLTAGERANGE_16V |
                     INA219_CONFIG_GAIN_1_40MV | INA219_CONFIG_BADCRES_12BIT |
                     INA219_CONFIG_SADCRES_12BIT_1S_532US |
                     INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS;
 
-  Adafruit_BusIO_Register config_reg =
-      Adafruit_BusIO_Register(i2c_dev, INA219_REG_CONFIG, 2, MSBFIRST);
-  _success = config_reg.write(config, 2);
+  ina219_configValue = config;
+  _success = writeRegister(INA219_REG_CONFIG, config);
+}
+
+/*!
+ *  @brief  Configures range, gain, ADC resolution/averaging and mode, with
+ *          the calibration computed for any shunt and maximum current
+ *          instead of one of the fixed setCalibration_* presets
+ *  @param  range
+ *          INA219_CONFIG_BVOLTAGERANGE_* value
+ *  @param  gain
+ *          INA219_CONFIG_GAIN_* value
+ *  @param  busAdc
+ *          INA219_CONFIG_BADCRES_* value
+ *  @param  shuntAdc
+ *          INA219_CONFIG_SADCRES_* value
+ *  @param  mode
+ *          INA219_CONFIG_MODE_* value
+ *  @param  shunt_ohm
+ *          shunt resistance in ohms
+ *  @param  maxCurrent_A
+ *          largest expected current in amps
+ */
+void Adafruit_INA219::configure(uint16_t range, uint16_t gain, uint16_t busAdc,
+                                uint16_t shuntAdc, uint16_t mode,
+                                float shunt_ohm, float maxCurrent_A) {
+  configure(INA219_profile(range, gain, busAdc, shuntAdc, mode, shunt_ohm,
+                           maxCurrent_A));
+}
+
+/*!
+ *  @brief  Applies a precomputed profile (see INA219_profile())
+ *  @param  profile
+ *          register values and current LSB
+ */
+void Adafruit_INA219::configure(const Ina219Profile &profile) {
+  ina219_calValue = profile.cal;
+  ina219_currentDivider_mA = 1.0f / profile.currentLSB_mA;
+  ina219_powerMultiplier_mW = 20.0f * profile.currentLSB_mA;
+  ina219_currentLSB_uA_q16 = profile.currentLSB_uA_q16;
+  writeCalibration();
+
+  ina219_configValue = profile.config;
+  _success = writeRegister(INA219_REG_CONFIG, ina219_configValue);
+}
+
+/*!
+ *  @brief  Conversion time of one ADC field of the config register
+ *  @param  code
+ *          4-bit BADC or SADC value
+ *  @return time in microseconds
+ */
+static uint32_t adcTime_us(uint8_t code) {
+  static const uint16_t single_us[4] = {84, 148, 276, 532};
+  if (!(code & 0x08)) {
+    return single_us[code & 0x03];
+  }
+  // 0x8 = 12 bit; 0x9..0xF average 2..128 12-bit samples
+  return code == 0x08 ? 532 : 532UL << (code & 0x07);
+}
+
+/*!
+ *  @brief  Time one conversion takes with the current configuration, e.g.
+ *          to size readFresh() timeouts or a sampling period
+ *  @return microseconds until CNVR is set after a trigger
+ */
+uint32_t Adafruit_INA219::conversionTime_us() {
+  uint8_t mode = ina219_configValue & INA219_CONFIG_MODE_MASK;
+  uint32_t t = 0;
+  if (mode & INA219_CONFIG_MODE_SVOLT_TRIGGERED) {
+    t += adcTime_us((ina219_configValue >> 3) & 0x0F);
+  }
+  if (mode & INA219_CONFIG_MODE_BVOLT_TRIGGERED) {
+    t += adcTime_us((ina219_configValue >> 7) & 0x0F);
+  }
+  return t;
+}
+
+/*!
+ *  @brief  Stops rewriting the calibration register before every current
+ *          and power read. The calibration is written once; afterwards the
+ *          calibration register is read back every checkInterval current
+ *          or power reads, and whenever readAll() finds the current at zero
+ *          while the shunt voltage says it should not be (what a chip reset
+ *          by a sharp load looks like; an idle pack reads zero of both), and
+ *          both
+ *          calibration and config are restored only if it was lost. This
+ *          saves one I2C write per current or power read.
+ *  @param  trusted
+ *          true to enable, false for the default rewrite-every-read
+ *  @param  checkInterval
+ *          number of current/power reads between calibration checks
+ */
+void Adafruit_INA219::setTrustedCalibration(bool trusted,
+                                            uint16_t checkInterval) {
+  ina219_trustedCal = trusted;
+  ina219_calCheckInterval = checkInterval ? checkInterval : 1;
+  ina219_calCheckCount = 0;
+  if (trusted) {
+    writeCalibration();
+  }
+}
+
+/*!
+ *  @brief  Writes the cached calibration value to the chip
+ */
+void Adafruit_INA219::writeCalibration() {
+  writeRegister(INA219_REG_CALIBRATION, ina219_calValue);
+}
+
+/*!
+ *  @brief  Whether a shunt reading should give a nonzero current register
+ *          under the cached calibration (current = shunt * cal / 4096),
+ *          with a count of margin for rounding
+ *  @param  shunt_raw
+ *          the raw shunt voltage register
+ *  @return true if the current register cannot legitimately read zero
+ */
+bool Adafruit_INA219::shuntImpliesCurrent(int16_t shunt_raw) const {
+  int32_t expected = (int32_t)shunt_raw * (int32_t)ina219_calValue / 4096;
+  return expected > 1 || expected < -1;
+}
+
+/*!
+ *  @brief  Trusted-calibration reset check, run after a current/power read
+ *  @param  suspect
+ *          the reading looks like a reset chip: check now instead of
+ *          waiting for the interval
+ *  @return true if the calibration had been lost and was rewritten; the
+ *          value just read is then not meaningful
+ */
+bool Adafruit_INA219::checkCalibration(bool suspect) {
+  if (!suspect && ++ina219_calCheckCount < ina219_calCheckInterval) {
+    return false;
+  }
+  ina219_calCheckCount = 0;
+
+  uint16_t cal;
+  if (!readRegister(INA219_REG_CALIBRATION, &cal) || cal == ina219_calValue) {
+    return false;
+  }
+
+  // Power-on reset: restore the configuration along with the calibration
+  writeRegister(INA219_REG_CALIBRATION, ina219_calValue);
+  writeRegister(INA219_REG_CONFIG, ina219_configValue);
+  _success = false;
+  return true;
 }
 
 /*!
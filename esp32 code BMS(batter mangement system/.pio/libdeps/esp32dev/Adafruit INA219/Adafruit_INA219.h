@@ -142,6 +142,11 @@ enum {
       0x07, /**< shunt and bus voltage continuous */
 };
 
+/** bus voltage register: conversion ready flag **/
+#define INA219_BUS_CNVR (0x0002)
+/** bus voltage register: math overflow flag **/
+#define INA219_BUS_OVF (0x0001)
+
 /** shunt voltage register **/
 #define INA219_REG_SHUNTVOLTAGE (0x01)
 
@@ -157,6 +162,134 @@ enum {
 /** calibration register **/
 #define INA219_REG_CALIBRATION (0x05)
 
+/** number of registers (0x00..0x05) **/
+#define INA219_REG_COUNT (6)
+
+/** datasheet calibration constant: Cal = 0.04096 / (Current_LSB * RSHUNT) **/
+#define INA219_CAL_SCALE (0.04096f)
+
+/*!
+ *   @brief  Register settings for Adafruit_INA219::configure, usually built
+ *           with INA219_profile()
+ */
+typedef struct {
+  uint16_t config;     ///< config register value
+  uint16_t cal;        ///< calibration register value
+  float currentLSB_mA; ///< mA per current register bit
+  uint32_t currentLSB_uA_q16; ///< uA per current register bit, Q16.16
+} Ina219Profile;
+
+/*!
+ *   @brief  Clamps a computed calibration to the register range; bit 0 of
+ *           the calibration register is not used and always reads 0
+ *   @param  cal
+ *           unclamped calibration value
+ *   @return register value
+ */
+constexpr uint16_t INA219_clampCal(float cal) {
+  return cal >= 65534.0f ? 0xFFFE
+                         : (cal < 2.0f ? 2 : (uint16_t)((uint32_t)cal & 0xFFFE));
+}
+
+/*!
+ *   @brief  Calibration for a shunt resistance and the largest current to
+ *           measure, using the finest current LSB (maxCurrent / 32768)
+ *   @param  shunt_ohm
+ *           shunt resistance in ohms
+ *   @param  maxCurrent_A
+ *           largest expected current in amps
+ *   @return calibration register value
+ */
+constexpr uint16_t INA219_calibration(float shunt_ohm, float maxCurrent_A) {
+  return INA219_clampCal(INA219_CAL_SCALE * 32768.0f /
+                         (maxCurrent_A * shunt_ohm));
+}
+
+/*!
+ *   @brief  Current LSB that a calibration value actually produces
+ *   @param  cal
+ *           calibration register value
+ *   @param  shunt_ohm
+ *           shunt resistance in ohms
+ *   @return mA per current register bit
+ */
+constexpr float INA219_currentLSB_mA(uint16_t cal, float shunt_ohm) {
+  return INA219_CAL_SCALE * 1000.0f / (cal * shunt_ohm);
+}
+
+/*!
+ *   @brief  Q16.16 fixed-point form of a current LSB, for the integer
+ *           readings in Ina219Sample (current_uA = raw * q16 >> 16)
+ *   @param  currentLSB_mA
+ *           mA per current register bit; at most 65 mA
+ *   @return uA per bit * 65536, rounded
+ */
+constexpr uint32_t INA219_lsbQ16(float currentLSB_mA) {
+  return currentLSB_mA >= 65.535f
+             ? 0xFFFFFFFF
+             : (uint32_t)(currentLSB_mA * 1000.0f * 65536.0f + 0.5f);
+}
+
+/*!
+ *   @brief  Builds a complete profile. constexpr: with constant arguments
+ *           the whole calibration is computed at compile time
+ *   @param  range
+ *           INA219_CONFIG_BVOLTAGERANGE_* value
+ *   @param  gain
+ *           INA219_CONFIG_GAIN_* value; gain range must cover
+ *           maxCurrent_A * shunt_ohm
+ *   @param  busAdc
+ *           INA219_CONFIG_BADCRES_* value
+ *   @param  shuntAdc
+ *           INA219_CONFIG_SADCRES_* value
+ *   @param  mode
+ *           INA219_CONFIG_MODE_* value
+ *   @param  shunt_ohm
+ *           shunt resistance in ohms
+ *   @param  maxCurrent_A
+ *           largest expected current in amps
+ *   @return the profile
+ */
+constexpr Ina219Profile INA219_profile(uint16_t range, uint16_t gain,
+                                       uint16_t busAdc, uint16_t shuntAdc,
+                                       uint16_t mode, float shunt_ohm,
+                                       float maxCurrent_A) {
+  return Ina219Profile{
+      (uint16_t)(range | gain | busAdc | shuntAdc | mode),
+      INA219_calibration(shunt_ohm, maxCurrent_A),
+      INA219_currentLSB_mA(INA219_calibration(shunt_ohm, maxCurrent_A),
+                           shunt_ohm),
+      INA219_lsbQ16(INA219_currentLSB_mA(
+          INA219_calibration(shunt_ohm, maxCurrent_A), shunt_ohm))};
+}
+
+/*!
+ *   @brief  One coherent set of INA219 readings, see Adafruit_INA219::readAll
+ */
+typedef struct {
+  int16_t shunt_raw;   ///< shunt voltage register, 10 uV per bit
+  int16_t bus_raw;     ///< bus voltage in mV (register with flags removed)
+  int16_t current_raw; ///< current register, in units of the current LSB
+  int16_t power_raw;   ///< power register, in units of 20 * current LSB
+  float shunt_mV;      ///< shunt voltage in mV
+  float bus_V;         ///< bus voltage in V
+  float current_mA;    ///< current in mA
+  float power_mW;      ///< power in mW
+  int32_t shunt_uV;    ///< shunt voltage in uV (integer path, no float)
+  int32_t bus_uV;      ///< bus voltage in uV
+  int32_t current_uA;  ///< current in uA, from the Q16 current LSB
+  int32_t power_uW;    ///< power in uW
+  bool coherent; ///< true if all four registers are from the same conversion
+  bool ready;    ///< readFresh(): conversion not returned by an earlier read
+  bool overflow; ///< OVF: current/power out of range, values are invalid
+} Ina219Sample;
+
+/** readFresh() CNVR polling interval in microseconds **/
+#define INA219_CNVR_POLL_US (100)
+
+/** readAll() attempts before returning a possibly mixed sample **/
+#define INA219_READALL_ATTEMPTS (2)
+
 /*!
  *   @brief  Class that stores state and functions for interacting with INA219
  *  current/power monitor IC
@@ -169,26 +302,50 @@ public:
   void setCalibration_32V_2A();
   void setCalibration_32V_1A();
   void setCalibration_16V_400mA();
+  void configure(uint16_t range, uint16_t gain, uint16_t busAdc,
+                 uint16_t shuntAdc, uint16_t mode, float shunt_ohm = 0.1f,
+                 float maxCurrent_A = 2.0f);
+  void configure(const Ina219Profile &profile);
+  uint32_t conversionTime_us();
   float getBusVoltage_V();
   float getShuntVoltage_mV();
   float getCurrent_mA();
   float getPower_mW();
+  bool readAll(Ina219Sample &sample);
+  bool readFresh(Ina219Sample &sample, uint32_t timeout_us = 0);
+  void triggerConversion();
   void powerSave(bool on);
+  void setTrustedCalibration(bool trusted, uint16_t checkInterval = 64);
+  uint16_t cachedRegister(uint8_t reg);
   bool success();
 
 private:
   Adafruit_I2CDevice *i2c_dev = NULL;
+  // One register object per INA219 register, created in begin()
+  Adafruit_BusIO_Register *ina219_reg[INA219_REG_COUNT] = {};
 
   bool _success;
 
   uint8_t ina219_i2caddr = -1;
   uint32_t ina219_calValue;
+  uint16_t ina219_configValue = 0;
+  // Trusted calibration: verify instead of rewriting before every read
+  bool ina219_trustedCal = false;
+  uint16_t ina219_calCheckInterval = 64;
+  uint16_t ina219_calCheckCount = 0;
   // The following multipliers are used to convert raw current and power
   // values to mA and mW, taking into account the current config settings
-  uint32_t ina219_currentDivider_mA;
+  float ina219_currentDivider_mA;
   float ina219_powerMultiplier_mW;
+  // Current LSB in uA, Q16.16, for the integer readings
+  uint32_t ina219_currentLSB_uA_q16 = 0;
 
   void init();
+  void writeCalibration();
+  bool readRegister(uint8_t reg, uint16_t *value);
+  bool writeRegister(uint8_t reg, uint16_t value);
+  bool checkCalibration(bool suspect);
+  bool shuntImpliesCurrent(int16_t shunt_raw) const;
   int16_t getBusVoltage_raw();
   int16_t getShuntVoltage_raw();
   int16_t getCurrent_raw();
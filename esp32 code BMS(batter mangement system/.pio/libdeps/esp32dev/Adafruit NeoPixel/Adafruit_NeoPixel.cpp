@@ -87,12 +87,6 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
   updateType(t);
   updateLength(n);
   setPin(p);
-
-#if defined(ESP32)
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
-  espInit();
-#endif
-#endif
 }
 
 /*!
@@ -118,12 +112,9 @@ Adafruit_NeoPixel::Adafruit_NeoPixel()
   @brief   Deallocate Adafruit_NeoPixel object, set data pin back to INPUT.
 */
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
-#ifdef ARDUINO_ARCH_ESP32
-  // Release RMT resources (RMT channels and led_data)
-  // by indirectly calling into espShow()
-  memset(pixels, 0, numBytes);
-  numLEDs = numBytes = 0;
-  show();
+#if defined(ESP32)
+  // Release this instance's RMT channel and frame buffer
+  espRmtDetach(rmt);
 #endif
 
 
@@ -395,10 +386,6 @@ static void ch32Show(GPIO_TypeDef* ch_port, uint32_t ch_pin, uint8_t* pixels, ui
 // ESP8266 show() is external to enforce ICACHE_RAM_ATTR execution
 extern "C" IRAM_ATTR void espShow(uint16_t pin, uint8_t *pixels,
                                   uint32_t numBytes, uint8_t type);
-#elif defined(ESP32)
-extern "C" void espShow(uint16_t pin, uint8_t *pixels, uint32_t numBytes,
-                        uint8_t type);
-
 #endif // ESP8266
 
 #if defined(K210)
@@ -3214,13 +3201,20 @@ if(is800KHz) {
 
   // END ARM ----------------------------------------------------------------
 
-#elif defined(ESP8266) || defined(ESP32)
+#elif defined(ESP8266)
 
   // ESP8266 ----------------------------------------------------------------
 
   // ESP8266 show() is external to enforce ICACHE_RAM_ATTR execution
   espShow(pin, pixels, numBytes, is800KHz);
 
+#elif defined(ESP32)
+
+  // ESP32 ------------------------------------------------------------------
+
+  // RMT does the timing; the channel stays bound to this instance
+  rmtShow(true);
+
 #elif defined(KENDRYTE_K210)
 
   k210Show(pin, pixels, numBytes, is800KHz);
@@ -3339,6 +3333,44 @@ if(is800KHz) {
   endTime = micros(); // Save EOD time for latch on next call
 }
 
+/*!
+  @brief   Start transmitting pixel data in RAM to NeoPixels and return
+           without waiting for it to go out. The data is copied first, so
+           the pixel buffer may be changed straight away; canShow() reports
+           whether the frame and its latch are done, and the next show() or
+           showAsync() waits for them. Instances on different pins transmit
+           in parallel. Same as show() on anything but ESP32.
+*/
+void Adafruit_NeoPixel::showAsync(void) {
+#if defined(ESP32)
+  if (!pixels)
+    return;
+  while (!canShow())
+    ;
+  rmtBusy = rmtShow(false);
+  if (!rmtBusy)
+    endTime = micros();
+#else
+  show();
+#endif
+}
+
+#if defined(ESP32)
+/*!
+  @brief   Send the pixel buffer over this instance's RMT channel, binding
+           the channel (or rebinding it after setPin()) and growing its
+           frame buffer as needed.
+  @param   wait  true to return once the frame has gone out.
+  @return  true if a frame was started.
+*/
+bool Adafruit_NeoPixel::rmtShow(bool wait) {
+  if (pin < 0 || !numBytes)
+    return false;
+  rmt = espRmtAttach(rmt, pin, numBytes, is800KHz);
+  return rmt && espRmtWrite(rmt, pixels, numBytes, is800KHz, wait);
+}
+#endif
+
 /*!
   @brief   Set/change the NeoPixel output pin number. Previous pin,
            if any, is set to INPUT and the new pin is set to OUTPUT.
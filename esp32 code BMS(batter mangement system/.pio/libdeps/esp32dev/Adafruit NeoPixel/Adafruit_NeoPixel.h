@@ -207,9 +207,14 @@ static const uint8_t PROGMEM _NeoPixelGammaTable[256] = {
     for specific hardware/library versions
 */
 #if defined(ESP32)
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
-extern "C" void espInit();
-#endif
+struct espRmtStrip; ///< RMT channel and frame buffer owned by one instance
+extern "C" espRmtStrip *espRmtAttach(espRmtStrip *strip, uint8_t pin,
+                                     uint32_t numBytes, boolean is800KHz);
+extern "C" boolean espRmtWrite(espRmtStrip *strip, uint8_t *pixels,
+                               uint32_t numBytes, boolean is800KHz,
+                               boolean wait);
+extern "C" boolean espRmtDone(espRmtStrip *strip);
+extern "C" void espRmtDetach(espRmtStrip *strip);
 #endif
 
 /*!
@@ -227,6 +232,7 @@ public:
 
   bool begin(void);
   void show(void);
+  void showAsync(void);
   void setPin(int16_t p);
   void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
   void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
@@ -250,6 +256,16 @@ public:
              if show() would block (meaning some idle time is available).
   */
   bool canShow(void) {
+#if defined(ESP32)
+    // A frame from showAsync() still going out: the latch starts when it
+    // is seen to finish, which errs on the long side.
+    if (rmtBusy) {
+      if (!espRmtDone(rmt))
+        return false;
+      rmtBusy = false;
+      endTime = micros();
+    }
+#endif
     // It's normal and possible for endTime to exceed micros() if the
     // 32-bit clock counter has rolled over (about every 70 minutes).
     // Since both are uint32_t, a negative delta correctly maps back to
@@ -404,6 +420,12 @@ protected:
   uint8_t wOffset;    ///< Index of white (==rOffset if no white)
   uint32_t endTime;   ///< Latch timing reference
 
+#if defined(ESP32)
+  bool rmtShow(bool wait);
+  espRmtStrip *rmt = NULL; ///< Persistent RMT channel, NULL until shown
+  bool rmtBusy = false;    ///< showAsync() frame not yet seen to finish
+#endif
+
 #ifdef __AVR__
   volatile uint8_t *port; ///< Output PORT register
   uint8_t pinMask;        ///< Output PORT bitmask
@@ -17,9 +17,15 @@
  * limitations under the License.
  */
 
+// Every Adafruit_NeoPixel instance owns one espRmtStrip: an RMT channel
+// that stays bound to its pin and a buffer that only ever grows, so strips
+// on different pins keep their channels and can transmit at the same time.
+// Nothing is allocated or torn down per show() unless the pin changes.
+
 #if defined(ESP32)
 
 #include <Arduino.h>
+#include "esp_heap_caps.h"
 
 #if defined(ESP_IDF_VERSION)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -30,94 +36,105 @@
 #endif
 #endif
 
+// The RMT ISR reads the buffers while flash may be busy, keep them internal
+#define RMT_BUFFER_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
 
-#ifdef HAS_ESP_IDF_5
+struct espRmtStrip;
+void espRmtDetach(struct espRmtStrip *strip);
 
-static SemaphoreHandle_t show_mutex = NULL;
-
-void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
-  // Note: Because rmtPin is shared between all instances, we will
-  //  end up releasing/initializing the RMT channels each time we
-  //  invoke on different pins. This is probably ok, just not
-  //  efficient. led_data is shared between all instances but will
-  //  be allocated with enough space for the largest instance; data
-  //  is not used beyond the mutex lock so this should be fine.
-
-#define SEMAPHORE_TIMEOUT_MS 50
-
-  static rmt_data_t *led_data = NULL;
-  static uint32_t led_data_size = 0;
-  static int rmtPin = -1;
-
-  if (show_mutex && xSemaphoreTake(show_mutex, SEMAPHORE_TIMEOUT_MS / portTICK_PERIOD_MS) == pdTRUE) {
-    uint32_t requiredSize = numBytes * 8;
-    if (requiredSize > led_data_size) {
-      free(led_data);
-      led_data = (rmt_data_t *)malloc(requiredSize * sizeof(rmt_data_t));
-      if (led_data != NULL) {
-        led_data_size = requiredSize;
-      } else {
-        led_data_size = 0;
-      }
-    } else if (requiredSize == 0) {
-      // To release RMT resources (RMT channels and led_data), call
-      //  .updateLength(0) to set number of pixels/bytes to zero,
-      //  then call .show() to invoke this code and free resources.
-      free(led_data);
-      led_data = NULL;
-      if (rmtPin >= 0) {
-        rmtDeinit(rmtPin);
-        rmtPin = -1;
-      }
-      led_data_size = 0;
-    }
 
-    if (led_data_size > 0 && requiredSize <= led_data_size) {
-      if (pin != rmtPin) {
-        if (rmtPin >= 0) {
-          rmtDeinit(rmtPin);
-          rmtPin = -1;
-        }
-        if (!rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, 10000000)) {
-          log_e("Failed to init RMT TX mode on pin %d", pin);
-          return;
-        }
-        rmtPin = pin;
-      }
-
-      if (rmtPin >= 0) {
-        int i=0;
-        for (int b=0; b < numBytes; b++) {
-          for (int bit=0; bit<8; bit++){
-            if ( pixels[b] & (1<<(7-bit)) ) {
-              led_data[i].level0 = 1;
-              led_data[i].duration0 = 8;
-              led_data[i].level1 = 0;
-              led_data[i].duration1 = 4;
-            } else {
-              led_data[i].level0 = 1;
-              led_data[i].duration0 = 4;
-              led_data[i].level1 = 0;
-              led_data[i].duration1 = 8;
-            }
-            i++;
-          }
-        }
+#ifdef HAS_ESP_IDF_5
+
+struct espRmtStrip {
+  uint8_t pin;
+  rmt_data_t *symbols;  // one RMT symbol per bit of the last frame
+  uint32_t capacity;    // allocated symbols
+  boolean busy;         // frame handed to rmtWriteAsync(), not yet done
+};
+
+static void espRmtWait(struct espRmtStrip *strip) {
+  while (strip->busy && !rmtTransmitCompleted(strip->pin))
+    yield();
+  strip->busy = false;
+}
 
-        rmtWrite(pin, led_data, numBytes * 8, RMT_WAIT_FOR_EVER);
-      }
+struct espRmtStrip *espRmtAttach(struct espRmtStrip *strip, uint8_t pin,
+                                 uint32_t numBytes, boolean is800KHz) {
+  (void)is800KHz; // timing is chosen per frame in espRmtWrite()
+  if (strip && strip->pin != pin) {
+    espRmtDetach(strip);
+    strip = NULL;
+  }
+  if (!strip) {
+    strip = (struct espRmtStrip *)heap_caps_calloc(1, sizeof(*strip),
+                                                   RMT_BUFFER_CAPS);
+    if (!strip)
+      return NULL;
+    if (!rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, 10000000)) {
+      log_e("Failed to init RMT TX mode on pin %d", pin);
+      free(strip);
+      return NULL;
     }
+    strip->pin = pin;
+  }
 
-    xSemaphoreGive(show_mutex);
+  uint32_t required = numBytes * 8;
+  if (required > strip->capacity) {
+    espRmtWait(strip);
+    free(strip->symbols);
+    strip->symbols =
+        (rmt_data_t *)heap_caps_malloc(required * sizeof(rmt_data_t),
+                                       RMT_BUFFER_CAPS);
+    strip->capacity = strip->symbols ? required : 0;
+    if (!strip->symbols) {
+      espRmtDetach(strip);
+      return NULL;
+    }
   }
+  return strip;
 }
 
-// To avoid race condition initializing the mutex, all instances of
-//  Adafruit_NeoPixel must be constructed before launching and child threads
-void espInit() {
-  if (!show_mutex) {
-    show_mutex = xSemaphoreCreateMutex();
+boolean espRmtWrite(struct espRmtStrip *strip, uint8_t *pixels,
+                    uint32_t numBytes, boolean is800KHz, boolean wait) {
+  // 10 MHz ticks: WS2812 is 0.4/0.8 us high, WS2811 0.5/1.2 us
+  const uint16_t t0h = is800KHz ? 4 : 5, t0l = is800KHz ? 8 : 20;
+  const uint16_t t1h = is800KHz ? 8 : 12, t1l = is800KHz ? 4 : 13;
+  uint32_t count = numBytes * 8;
+
+  if (count == 0 || count > strip->capacity)
+    return false;
+  espRmtWait(strip);
+
+  rmt_data_t *sym = strip->symbols;
+  for (uint32_t b = 0; b < numBytes; b++) {
+    for (int bit = 0; bit < 8; bit++, sym++) {
+      boolean one = pixels[b] & (1 << (7 - bit));
+      sym->level0 = 1;
+      sym->duration0 = one ? t1h : t0h;
+      sym->level1 = 0;
+      sym->duration1 = one ? t1l : t0l;
+    }
   }
+
+  if (wait)
+    return rmtWrite(strip->pin, strip->symbols, count, RMT_WAIT_FOR_EVER);
+  strip->busy = rmtWriteAsync(strip->pin, strip->symbols, count);
+  return strip->busy;
+}
+
+boolean espRmtDone(struct espRmtStrip *strip) {
+  if (strip->busy && rmtTransmitCompleted(strip->pin))
+    strip->busy = false;
+  return !strip->busy;
+}
+
+void espRmtDetach(struct espRmtStrip *strip) {
+  if (!strip)
+    return;
+  espRmtWait(strip);
+  rmtDeinit(strip->pin);
+  free(strip->symbols);
+  free(strip);
 }
 
 #else
@@ -138,10 +155,11 @@ void espInit() {
 #define WS2811_T1H_NS (1200)
 #define WS2811_T1L_NS (1300)
 
-static uint32_t t0h_ticks = 0;
-static uint32_t t1h_ticks = 0;
-static uint32_t t0l_ticks = 0;
-static uint32_t t1l_ticks = 0;
+// Logical 0 and 1 at each speed. Every channel uses the same clock
+// divider, so these are worked out once, on the first attach.
+static rmt_item32_t ws2812_bit0, ws2812_bit1;
+static rmt_item32_t ws2811_bit0, ws2811_bit1;
+static boolean bit_ticks_ready = false;
 
 // Limit the number of RMT channels available for the Neopixels. Defaults to all
 // channels (8 on ESP32, 4 on ESP32-S2 and S3). Redefining this value will free
@@ -153,16 +171,25 @@ static uint32_t t1l_ticks = 0;
 
 bool rmt_reserved_channels[ADAFRUIT_RMT_CHANNEL_MAX];
 
-static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
-        size_t wanted_num, size_t *translated_size, size_t *item_num)
+struct espRmtStrip {
+  rmt_channel_t channel; // reserved for as long as the strip is attached
+  uint8_t pin;
+  boolean is800KHz;      // speed the channel's translator is set up for
+  uint8_t *frame;        // copy being sent, so pixels[] may change meanwhile
+  uint32_t capacity;     // allocated frame bytes
+  boolean busy;          // frame queued without waiting, not yet done
+};
+
+static inline __attribute__((always_inline)) void
+rmt_translate(const void *src, rmt_item32_t *dest, size_t src_size,
+              size_t wanted_num, size_t *translated_size, size_t *item_num,
+              uint32_t bit0, uint32_t bit1)
 {
     if (src == NULL || dest == NULL) {
         *translated_size = 0;
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ t0h_ticks, 1, t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ t1h_ticks, 1, t1l_ticks, 0 }}}; //Logical 1
     size_t size = 0;
     size_t num = 0;
     uint8_t *psrc = (uint8_t *)src;
@@ -171,9 +198,9 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
         for (int i = 0; i < 8; i++) {
             // MSB first
             if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
+                pdest->val =  bit1;
             } else {
-                pdest->val =  bit0.val;
+                pdest->val =  bit0;
             }
             num++;
             pdest++;
@@ -185,46 +212,21 @@ static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, si
     *item_num = num;
 }
 
-void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
-    // Reserve channel
-    rmt_channel_t channel = ADAFRUIT_RMT_CHANNEL_MAX;
-    for (size_t i = 0; i < ADAFRUIT_RMT_CHANNEL_MAX; i++) {
-        if (!rmt_reserved_channels[i]) {
-            rmt_reserved_channels[i] = true;
-            channel = i;
-            break;
-        }
-    }
-    if (channel == ADAFRUIT_RMT_CHANNEL_MAX) {
-        // Ran out of channels!
-        return;
-    }
+static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
+        size_t wanted_num, size_t *translated_size, size_t *item_num)
+{
+    rmt_translate(src, dest, src_size, wanted_num, translated_size, item_num,
+                  ws2812_bit0.val, ws2812_bit1.val);
+}
 
-#if defined(HAS_ESP_IDF_4)
-    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(pin, channel);
-    config.clk_div = 2;
-#else
-    // Match default TX config from ESP-IDF version 3.4
-    rmt_config_t config = {
-        .rmt_mode = RMT_MODE_TX,
-        .channel = channel,
-        .gpio_num = pin,
-        .clk_div = 2,
-        .mem_block_num = 1,
-        .tx_config = {
-            .carrier_freq_hz = 38000,
-            .carrier_level = RMT_CARRIER_LEVEL_HIGH,
-            .idle_level = RMT_IDLE_LEVEL_LOW,
-            .carrier_duty_percent = 33,
-            .carrier_en = false,
-            .loop_en = false,
-            .idle_output_en = true,
-        }
-    };
-#endif
-    rmt_config(&config);
-    rmt_driver_install(config.channel, 0, 0);
+static void IRAM_ATTR ws2811_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
+        size_t wanted_num, size_t *translated_size, size_t *item_num)
+{
+    rmt_translate(src, dest, src_size, wanted_num, translated_size, item_num,
+                  ws2811_bit0.val, ws2811_bit1.val);
+}
 
+static void set_bit_ticks(rmt_channel_t channel) {
     // Convert NS timings to ticks
     uint32_t counter_clk_hz = 0;
 
@@ -232,12 +234,12 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
     rmt_get_counter_clock(channel, &counter_clk_hz);
 #else
     // this emulates the rmt_get_counter_clock() function from ESP-IDF 3.4
-    if (RMT_LL_HW_BASE->conf_ch[config.channel].conf1.ref_always_on == RMT_BASECLK_REF) {
-        uint32_t div_cnt = RMT_LL_HW_BASE->conf_ch[config.channel].conf0.div_cnt;
+    if (RMT_LL_HW_BASE->conf_ch[channel].conf1.ref_always_on == RMT_BASECLK_REF) {
+        uint32_t div_cnt = RMT_LL_HW_BASE->conf_ch[channel].conf0.div_cnt;
         uint32_t div = div_cnt == 0 ? 256 : div_cnt;
         counter_clk_hz = REF_CLK_FREQ / (div);
     } else {
-        uint32_t div_cnt = RMT_LL_HW_BASE->conf_ch[config.channel].conf0.div_cnt;
+        uint32_t div_cnt = RMT_LL_HW_BASE->conf_ch[channel].conf0.div_cnt;
         uint32_t div = div_cnt == 0 ? 256 : div_cnt;
         counter_clk_hz = APB_CLK_FREQ / (div);
     }
@@ -246,30 +248,149 @@ void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz)
     // NS to tick converter
     float ratio = (float)counter_clk_hz / 1e9;
 
-    if (is800KHz) {
-        t0h_ticks = (uint32_t)(ratio * WS2812_T0H_NS);
-        t0l_ticks = (uint32_t)(ratio * WS2812_T0L_NS);
-        t1h_ticks = (uint32_t)(ratio * WS2812_T1H_NS);
-        t1l_ticks = (uint32_t)(ratio * WS2812_T1L_NS);
-    } else {
-        t0h_ticks = (uint32_t)(ratio * WS2811_T0H_NS);
-        t0l_ticks = (uint32_t)(ratio * WS2811_T0L_NS);
-        t1h_ticks = (uint32_t)(ratio * WS2811_T1H_NS);
-        t1l_ticks = (uint32_t)(ratio * WS2811_T1L_NS);
+    const rmt_item32_t b0_800 = {{{ (uint32_t)(ratio * WS2812_T0H_NS), 1,
+                                    (uint32_t)(ratio * WS2812_T0L_NS), 0 }}};
+    const rmt_item32_t b1_800 = {{{ (uint32_t)(ratio * WS2812_T1H_NS), 1,
+                                    (uint32_t)(ratio * WS2812_T1L_NS), 0 }}};
+    const rmt_item32_t b0_400 = {{{ (uint32_t)(ratio * WS2811_T0H_NS), 1,
+                                    (uint32_t)(ratio * WS2811_T0L_NS), 0 }}};
+    const rmt_item32_t b1_400 = {{{ (uint32_t)(ratio * WS2811_T1H_NS), 1,
+                                    (uint32_t)(ratio * WS2811_T1L_NS), 0 }}};
+    ws2812_bit0 = b0_800;
+    ws2812_bit1 = b1_800;
+    ws2811_bit0 = b0_400;
+    ws2811_bit1 = b1_400;
+    bit_ticks_ready = true;
+}
+
+static void espRmtWait(struct espRmtStrip *strip) {
+    if (strip->busy) {
+        rmt_wait_tx_done(strip->channel, pdMS_TO_TICKS(100));
+        strip->busy = false;
+    }
+}
+
+struct espRmtStrip *espRmtAttach(struct espRmtStrip *strip, uint8_t pin,
+                                 uint32_t numBytes, boolean is800KHz) {
+    if (strip && strip->pin != pin) {
+        espRmtDetach(strip);
+        strip = NULL;
+    }
+
+    if (!strip) {
+        // Reserve channel
+        rmt_channel_t channel = ADAFRUIT_RMT_CHANNEL_MAX;
+        for (size_t i = 0; i < ADAFRUIT_RMT_CHANNEL_MAX; i++) {
+            if (!rmt_reserved_channels[i]) {
+                channel = i;
+                break;
+            }
+        }
+        if (channel == ADAFRUIT_RMT_CHANNEL_MAX) {
+            // Ran out of channels!
+            return NULL;
+        }
+        strip = (struct espRmtStrip *)heap_caps_calloc(1, sizeof(*strip),
+                                                       RMT_BUFFER_CAPS);
+        if (!strip)
+            return NULL;
+
+#if defined(HAS_ESP_IDF_4)
+        rmt_config_t config = RMT_DEFAULT_CONFIG_TX(pin, channel);
+        config.clk_div = 2;
+#else
+        // Match default TX config from ESP-IDF version 3.4
+        rmt_config_t config = {
+            .rmt_mode = RMT_MODE_TX,
+            .channel = channel,
+            .gpio_num = pin,
+            .clk_div = 2,
+            .mem_block_num = 1,
+            .tx_config = {
+                .carrier_freq_hz = 38000,
+                .carrier_level = RMT_CARRIER_LEVEL_HIGH,
+                .idle_level = RMT_IDLE_LEVEL_LOW,
+                .carrier_duty_percent = 33,
+                .carrier_en = false,
+                .loop_en = false,
+                .idle_output_en = true,
+            }
+        };
+#endif
+        if (rmt_config(&config) != ESP_OK ||
+            rmt_driver_install(config.channel, 0, 0) != ESP_OK) {
+            free(strip);
+            return NULL;
+        }
+        if (!bit_ticks_ready)
+            set_bit_ticks(channel);
+
+        rmt_reserved_channels[channel] = true;
+        strip->channel = channel;
+        strip->pin = pin;
+        // Initialize automatic timing translator
+        strip->is800KHz = is800KHz;
+        rmt_translator_init(channel, is800KHz ? ws2812_rmt_adapter
+                                              : ws2811_rmt_adapter);
+    }
+
+    if (strip->is800KHz != is800KHz) {
+        espRmtWait(strip);
+        strip->is800KHz = is800KHz;
+        rmt_translator_init(strip->channel, is800KHz ? ws2812_rmt_adapter
+                                                     : ws2811_rmt_adapter);
     }
 
-    // Initialize automatic timing translator
-    rmt_translator_init(config.channel, ws2812_rmt_adapter);
+    if (numBytes > strip->capacity) {
+        espRmtWait(strip);
+        free(strip->frame);
+        strip->frame = (uint8_t *)heap_caps_malloc(numBytes, RMT_BUFFER_CAPS);
+        strip->capacity = strip->frame ? numBytes : 0;
+        if (!strip->frame) {
+            espRmtDetach(strip);
+            return NULL;
+        }
+    }
+    return strip;
+}
+
+boolean espRmtWrite(struct espRmtStrip *strip, uint8_t *pixels,
+                    uint32_t numBytes, boolean is800KHz, boolean wait) {
+    (void)is800KHz; // fixed by the translator picked in espRmtAttach()
+    if (numBytes == 0 || numBytes > strip->capacity)
+        return false;
+
+    // The driver keeps translating from the source in its ISR after
+    // rmt_write_sample() returns, so send a copy the caller can't touch
+    espRmtWait(strip);
+    memcpy(strip->frame, pixels, numBytes);
+    if (rmt_write_sample(strip->channel, strip->frame, (size_t)numBytes,
+                         false) != ESP_OK)
+        return false;
+    strip->busy = true;
+    if (wait)
+        espRmtWait(strip);
+    return true;
+}
+
+boolean espRmtDone(struct espRmtStrip *strip) {
+    if (strip->busy && rmt_wait_tx_done(strip->channel, 0) == ESP_OK)
+        strip->busy = false;
+    return !strip->busy;
+}
 
-    // Write and wait to finish
-    rmt_write_sample(config.channel, pixels, (size_t)numBytes, true);
-    rmt_wait_tx_done(config.channel, pdMS_TO_TICKS(100));
+void espRmtDetach(struct espRmtStrip *strip) {
+    if (!strip)
+        return;
+    espRmtWait(strip);
 
     // Free channel again
-    rmt_driver_uninstall(config.channel);
-    rmt_reserved_channels[channel] = false;
+    rmt_driver_uninstall(strip->channel);
+    rmt_reserved_channels[strip->channel] = false;
 
-    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+    gpio_set_direction(strip->pin, GPIO_MODE_OUTPUT);
+    free(strip->frame);
+    free(strip);
 }
 
 #endif // ifndef IDF5
@@ -117,10 +117,33 @@
 // so other I2C device types still work).  All of these are encapsulated
 // in the TRANSACTION_* macros.
 
+#if defined(ESP32)
+// With background refresh running, application commands and the refresh
+// task take turns on the panel
+#define PANEL_LOCK                                                             \
+  if (busLock) {                                                               \
+    xSemaphoreTakeRecursive(busLock, portMAX_DELAY);                           \
+  } ///< Wait for the background refresh
+#define PANEL_UNLOCK                                                           \
+  if (busLock) {                                                               \
+    xSemaphoreGiveRecursive(busLock);                                          \
+  } ///< Let the background refresh continue
+// The Wire clock is switched per chunk, inside the BusIO bus lock, when
+// the I2C transfers share the bus with BusIO devices (see wireBegin())
+#define WIRE_CLOCK_PER_CHUNK (i2cDev != NULL)
+#else
+#define PANEL_LOCK   ///< Dummy stand-in define
+#define PANEL_UNLOCK ///< keeps compiler happy
+#define WIRE_CLOCK_PER_CHUNK false ///< One clock switch per transaction
+#endif
+
 // Check first if Wire, then hardware SPI, then soft SPI:
 #define TRANSACTION_START                                                      \
+  PANEL_LOCK                                                                   \
   if (wire) {                                                                  \
-    SETWIRECLOCK;                                                              \
+    if (!WIRE_CLOCK_PER_CHUNK) {                                               \
+      SETWIRECLOCK;                                                            \
+    }                                                                          \
   } else {                                                                     \
     if (spi) {                                                                 \
       SPI_TRANSACTION_START;                                                   \
@@ -129,13 +152,16 @@
   } ///< Wire, SPI or bitbang transfer setup
 #define TRANSACTION_END                                                        \
   if (wire) {                                                                  \
-    RESWIRECLOCK;                                                              \
+    if (!WIRE_CLOCK_PER_CHUNK) {                                               \
+      RESWIRECLOCK;                                                            \
+    }                                                                          \
   } else {                                                                     \
     SSD1306_DESELECT;                                                          \
     if (spi) {                                                                 \
       SPI_TRANSACTION_END;                                                     \
     }                                                                          \
-  } ///< Wire, SPI or bitbang transfer end
+  }                                                                            \
+  PANEL_UNLOCK ///< Wire, SPI or bitbang transfer end
 
 // CONSTRUCTORS, DESTRUCTOR ------------------------------------------------
 
@@ -340,10 +366,20 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t rst_pin)
     @brief  Destructor for Adafruit_SSD1306 object.
 */
 Adafruit_SSD1306::~Adafruit_SSD1306(void) {
+#if defined(ESP32)
+  stopBackgroundRefresh();
+  delete i2cDev;
+  i2cDev = NULL;
+#endif
   if (buffer) {
     free(buffer);
     buffer = NULL;
   }
+  if (shadow) {
+    free(shadow);
+    shadow = NULL;
+  }
+  setGlyphCache(0);
 }
 
 // LOW-LEVEL UTILS ---------------------------------------------------------
@@ -381,6 +417,61 @@ inline void Adafruit_SSD1306::SPIwrite(uint8_t d) {
   }
 }
 
+/*!
+    @brief  Write a buffer to the SPI port: one bulk FIFO transfer on ESP32
+            hardware SPI, byte by byte elsewhere.
+
+    @param  d
+                        Data to be written.
+    @param  n
+                        Number of bytes.
+
+    @return void
+*/
+void Adafruit_SSD1306::SPIwrite(const uint8_t *d, size_t n) {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (spi) {
+    spi->writeBytes(d, n);
+    return;
+  }
+#endif
+  while (n--)
+    SPIwrite(*d++);
+}
+
+/*!
+    @brief Start one I2C transmission to the panel. On ESP32 each one takes
+   the BusIO lock of its TwoWire (the one every Adafruit_I2CDevice on the
+   bus shares), so a sensor on the same bus waits for at most one chunk of
+   a refresh, and the panel's Wire clock is only in effect while it is held.
+   This is a protected function, not exposed.
+    @return None (void).
+*/
+void Adafruit_SSD1306::wireBegin(void) {
+#if defined(ESP32)
+  if (i2cDev) {
+    i2cDev->lockBus();
+    SETWIRECLOCK;
+  }
+#endif
+  wire->beginTransmission(i2caddr);
+}
+
+/*!
+    @brief End the I2C transmission started with wireBegin() and release
+   the bus. This is a protected function, not exposed.
+    @return None (void).
+*/
+void Adafruit_SSD1306::wireEnd(void) {
+  wire->endTransmission();
+#if defined(ESP32)
+  if (i2cDev) {
+    RESWIRECLOCK;
+    i2cDev->unlockBus();
+  }
+#endif
+}
+
 /*!
     @brief Issue single command to SSD1306, using I2C or hard/soft SPI as
    needed. Because command calls are often grouped, SPI transaction and
@@ -395,10 +486,10 @@ inline void Adafruit_SSD1306::SPIwrite(uint8_t d) {
 */
 void Adafruit_SSD1306::ssd1306_command1(uint8_t c) {
   if (wire) { // I2C
-    wire->beginTransmission(i2caddr);
+    wireBegin();
     WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
     WIRE_WRITE(c);
-    wire->endTransmission();
+    wireEnd();
   } else { // SPI (hw or soft) -- transaction started in calling function
     SSD1306_MODE_COMMAND
     SPIwrite(c);
@@ -419,20 +510,20 @@ void Adafruit_SSD1306::ssd1306_command1(uint8_t c) {
 */
 void Adafruit_SSD1306::ssd1306_commandList(const uint8_t *c, uint8_t n) {
   if (wire) { // I2C
-    wire->beginTransmission(i2caddr);
+    wireBegin();
     WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
     uint16_t bytesOut = 1;
     while (n--) {
       if (bytesOut >= WIRE_MAX) {
-        wire->endTransmission();
-        wire->beginTransmission(i2caddr);
+        wireEnd();
+        wireBegin();
         WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
         bytesOut = 1;
       }
       WIRE_WRITE(pgm_read_byte(c++));
       bytesOut++;
     }
-    wire->endTransmission();
+    wireEnd();
   } else { // SPI -- transaction started in calling function
     SSD1306_MODE_COMMAND
     while (n--)
@@ -440,6 +531,38 @@ void Adafruit_SSD1306::ssd1306_commandList(const uint8_t *c, uint8_t n) {
   }
 }
 
+/*!
+    @brief Issue list of commands from RAM (ssd1306_commandList() reads
+   PROGMEM), e.g. addresses computed at run time. Same rules as above re:
+   transactions. This is a protected function, not exposed.
+        @param c
+                   pointer to list of commands
+        @param n
+                   number of commands in the list
+    @return None (void).
+*/
+void Adafruit_SSD1306::ssd1306_commandBuffer(const uint8_t *c, uint8_t n) {
+  if (wire) { // I2C
+    wireBegin();
+    WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
+    uint16_t bytesOut = 1;
+    while (n--) {
+      if (bytesOut >= WIRE_MAX) {
+        wireEnd();
+        wireBegin();
+        WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
+        bytesOut = 1;
+      }
+      WIRE_WRITE(*c++);
+      bytesOut++;
+    }
+    wireEnd();
+  } else { // SPI -- transaction started in calling function
+    SSD1306_MODE_COMMAND
+    SPIwrite(c, n);
+  }
+}
+
 // A public version of ssd1306_command1(), for existing user code that
 // might rely on that function. This encapsulates the command transfer
 // in a transaction start/end, similar to old library's handling of it.
@@ -499,6 +622,9 @@ bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
   if ((!buffer) && !(buffer = (uint8_t *)malloc(WIDTH * ((HEIGHT + 7) / 8))))
     return false;
 
+#if defined(SSD1306_FIXED_ROTATION)
+  Adafruit_GFX::setRotation(SSD1306_FIXED_ROTATION);
+#endif
   clearDisplay();
 
 #ifndef SSD1306_NO_SPLASH
@@ -524,6 +650,11 @@ bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
     // with different addresses -- only a single begin() is needed).
     if (periphBegin)
       wire->begin();
+#if defined(ESP32)
+    // Never begin()-ed: it only lends the panel its bus lock
+    delete i2cDev;
+    i2cDev = new Adafruit_I2CDevice(i2caddr, wire);
+#endif
   } else { // Using one of the SPI modes, either soft or hardware
     pinMode(dcPin, OUTPUT); // Set data/command pin as output
     pinMode(csPin, OUTPUT); // Same for chip select
@@ -646,34 +777,117 @@ bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
             commands as needed by one's own application.
 */
 void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
-  if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
-    // Pixel is in-bounds. Rotate coordinates if needed.
-    switch (getRotation()) {
-    case 1:
-      ssd1306_swap(x, y);
-      x = WIDTH - x - 1;
-      break;
-    case 2:
-      x = WIDTH - x - 1;
-      y = HEIGHT - y - 1;
-      break;
-    case 3:
-      ssd1306_swap(x, y);
-      y = HEIGHT - y - 1;
-      break;
-    }
-    switch (color) {
-    case SSD1306_WHITE:
-      buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7));
-      break;
-    case SSD1306_BLACK:
-      buffer[x + (y / 8) * WIDTH] &= ~(1 << (y & 7));
-      break;
-    case SSD1306_INVERSE:
-      buffer[x + (y / 8) * WIDTH] ^= (1 << (y & 7));
-      break;
-    }
+#if defined(SSD1306_FIXED_ROTATION)
+  drawPixelRotated<SSD1306_FIXED_ROTATION>(x, y, color);
+#else
+  (this->*pixelWriter)(x, y, color);
+#endif
+}
+
+// Buffer bits to clear and to flip for each color: b = (b & ~clr) ^ flip.
+// Any other value (clamped to index 3) leaves the pixel alone, as before.
+static const uint8_t ssd1306_colorOps[4][2] = {
+    {0xFF, 0x00}, // SSD1306_BLACK
+    {0xFF, 0xFF}, // SSD1306_WHITE
+    {0x00, 0xFF}, // SSD1306_INVERSE
+    {0x00, 0x00}};
+
+/*!
+    @brief  Map rotated coordinates to the physical buffer. ROT is a
+            compile-time constant, so the switch folds away.
+    @param  x  Column, rotated on return.
+    @param  y  Row, rotated on return.
+    @param  w  Physical width (WIDTH).
+    @param  h  Physical height (HEIGHT).
+    @return None (void).
+*/
+template <uint8_t ROT>
+static inline void ssd1306_rotate(int16_t &x, int16_t &y, int16_t w,
+                                  int16_t h) {
+  switch (ROT) {
+  case 1:
+    ssd1306_swap(x, y);
+    x = w - x - 1;
+    break;
+  case 2:
+    x = w - x - 1;
+    y = h - y - 1;
+    break;
+  case 3:
+    ssd1306_swap(x, y);
+    y = h - y - 1;
+    break;
+  }
+}
+
+/*!
+    @brief  drawPixel() for one fixed rotation: a coordinate map, one bounds
+            check on the physical position and a table-driven bit update,
+            with no rotation or color branches.
+    @param  x      Column in rotated coordinates.
+    @param  y      Row in rotated coordinates.
+    @param  color  SSD1306_BLACK, SSD1306_WHITE or SSD1306_INVERSE.
+    @return None (void).
+*/
+template <uint8_t ROT>
+void Adafruit_SSD1306::drawPixelRotated(int16_t x, int16_t y, uint16_t color) {
+  ssd1306_rotate<ROT>(x, y, WIDTH, HEIGHT);
+  if (((uint16_t)x < (uint16_t)WIDTH) && ((uint16_t)y < (uint16_t)HEIGHT)) {
+    markDirty(x, x, y, y);
+    const uint8_t *op = ssd1306_colorOps[(color < 3) ? color : 3];
+    uint8_t bit = 1 << (y & 7);
+    uint8_t *b = &buffer[x + (y / 8) * WIDTH];
+    *b = (*b & ~(bit & op[0])) ^ (bit & op[1]);
+  }
+}
+
+/*!
+    @brief  getPixel() for one fixed rotation.
+    @param  x  Column in rotated coordinates.
+    @param  y  Row in rotated coordinates.
+    @return true if the pixel is set, false if clear or out of bounds.
+*/
+template <uint8_t ROT>
+bool Adafruit_SSD1306::getPixelRotated(int16_t x, int16_t y) {
+  ssd1306_rotate<ROT>(x, y, WIDTH, HEIGHT);
+  if (((uint16_t)x < (uint16_t)WIDTH) && ((uint16_t)y < (uint16_t)HEIGHT))
+    return (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
+  return false; // Pixel out of bounds
+}
+
+/*!
+    @brief  Set the rotation and pick the matching drawPixel()/getPixel()
+            paths once, instead of switching on the rotation per pixel.
+            With SSD1306_FIXED_ROTATION defined at build time the pixel
+            paths are fixed to that rotation and r is ignored.
+    @param  r  0 thru 3 corresponding to 4 cardinal rotations.
+    @return None (void).
+*/
+void Adafruit_SSD1306::setRotation(uint8_t r) {
+#if defined(SSD1306_FIXED_ROTATION)
+  (void)r;
+  Adafruit_GFX::setRotation(SSD1306_FIXED_ROTATION);
+#else
+  Adafruit_GFX::setRotation(r);
+  switch (getRotation()) {
+  case 0:
+    pixelWriter = &Adafruit_SSD1306::drawPixelRotated<0>;
+    pixelReader = &Adafruit_SSD1306::getPixelRotated<0>;
+    break;
+  case 1:
+    pixelWriter = &Adafruit_SSD1306::drawPixelRotated<1>;
+    pixelReader = &Adafruit_SSD1306::getPixelRotated<1>;
+    break;
+  case 2:
+    pixelWriter = &Adafruit_SSD1306::drawPixelRotated<2>;
+    pixelReader = &Adafruit_SSD1306::getPixelRotated<2>;
+    break;
+  case 3:
+    pixelWriter = &Adafruit_SSD1306::drawPixelRotated<3>;
+    pixelReader = &Adafruit_SSD1306::getPixelRotated<3>;
+    break;
   }
+#endif
 }
 
 /*!
@@ -685,6 +899,7 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
 */
 void Adafruit_SSD1306::clearDisplay(void) {
   memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+  markDirty();
 }
 
 /*!
@@ -764,6 +979,7 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w,
       w = (WIDTH - x);
     }
     if (w > 0) { // Proceed only if width is positive
+      markDirty(x, x + w - 1, y, y);
       uint8_t *pBuf = &buffer[(y / 8) * WIDTH + x], mask = 1 << (y & 7);
       switch (color) {
       case SSD1306_WHITE:
@@ -863,6 +1079,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
       __h = (HEIGHT - __y);
     }
     if (__h > 0) { // Proceed only if height is now positive
+      markDirty(x, x, __y, __y + __h - 1);
       // this display doesn't need ints for coordinates,
       // use local byte registers for faster juggling
       uint8_t y = __y, h = __h;
@@ -959,59 +1176,359 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
             screen if display() has not been called.
 */
 bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) {
-  if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
-    // Pixel is in-bounds. Rotate coordinates if needed.
-    switch (getRotation()) {
-    case 1:
-      ssd1306_swap(x, y);
-      x = WIDTH - x - 1;
-      break;
-    case 2:
-      x = WIDTH - x - 1;
-      y = HEIGHT - y - 1;
-      break;
-    case 3:
-      ssd1306_swap(x, y);
-      y = HEIGHT - y - 1;
-      break;
-    }
-    return (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
-  }
-  return false; // Pixel out of bounds
+#if defined(SSD1306_FIXED_ROTATION)
+  return getPixelRotated<SSD1306_FIXED_ROTATION>(x, y);
+#else
+  return (this->*pixelReader)(x, y);
+#endif
 }
 
 /*!
     @brief  Get base address of display buffer for direct reading or writing.
     @return Pointer to an unsigned 8-bit array, column-major, columns padded
             to full byte boundary if needed.
+    @note   Marks the whole buffer dirty. Code that keeps the pointer and
+            writes through it later must call markDirty() before display().
+*/
+uint8_t *Adafruit_SSD1306::getBuffer(void) {
+  markDirty();
+  return buffer;
+}
+
+/*!
+    @brief  Flag the whole buffer as changed, so the next display() looks
+            at all of it (after writing the buffer directly).
+    @return None (void).
+*/
+void Adafruit_SSD1306::markDirty(void) {
+  markDirty(0, WIDTH - 1, 0, HEIGHT - 1);
+}
+
+/*!
+    @brief  Forget the dirty window (after it was sent).
+    @return None (void).
 */
-uint8_t *Adafruit_SSD1306::getBuffer(void) { return buffer; }
+void Adafruit_SSD1306::clearDirty(void) {
+  dirtyX1 = 0x7FFF;
+  dirtyX2 = -1;
+  dirtyPage1 = 0x7F;
+  dirtyPage2 = -1;
+}
+
+/*!
+    @brief  Keep a copy of what the panel shows (one more buffer of
+            WIDTH * ((HEIGHT + 7) / 8) bytes). display() then trims the
+            dirty window to the bytes that really differ, so redrawing an
+            unchanged screen after clearDisplay() sends nothing and
+            updating a few digits sends only those columns.
+    @param  enable
+            true to allocate the copy, false to free it.
+    @return true on success, false if the copy could not be allocated.
+*/
+bool Adafruit_SSD1306::setPanelShadow(bool enable) {
+  if (!enable) {
+    free(shadow);
+    shadow = NULL;
+    return true;
+  }
+  if (!shadow && !(shadow = (uint8_t *)malloc(WIDTH * ((HEIGHT + 7) / 8))))
+    return false;
+  shadowValid = false; // panel unknown until the next full refresh
+  markDirty();
+  return true;
+}
+
+/*!
+    @brief  1-bit bitmaps (drawBitmap(), drawXBitmap(), the splash screen)
+            at rotation 0: for each page the image covers, 8 image rows are
+            turned into column bytes and combined with the buffer a whole
+            byte at a time, masked to the rows inside the image, instead of
+            one drawPixel() per image pixel.
+    @param  x       Top left corner x coordinate.
+    @param  y       Top left corner y coordinate.
+    @param  bitmap  Row-major image, each row padded to a whole byte.
+    @param  w       Width of bitmap in pixels.
+    @param  h       Height of bitmap in pixels.
+    @param  color   Color of set bits.
+    @param  bg      Color of unset bits, with GFX_BLIT_OPAQUE.
+    @param  flags   GFX_BLIT_PROGMEM, GFX_BLIT_XBM, GFX_BLIT_OPAQUE.
+    @return true if drawn, false (rotated, or not an SSD1306 color) for the
+            generic path.
+*/
+bool Adafruit_SSD1306::blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
+                                  int16_t w, int16_t h, uint16_t color,
+                                  uint16_t bg, uint8_t flags) {
+  bool opaque = flags & GFX_BLIT_OPAQUE;
+  if (!buffer || getRotation() || (color > SSD1306_INVERSE) ||
+      (opaque && (bg > SSD1306_INVERSE)))
+    return false;
+  // Visible columns [i0, i1) and rows [j0, j1) of the image
+  int16_t i0 = (x < 0) ? -x : 0, i1 = (x + w > WIDTH) ? WIDTH - x : w;
+  int16_t j0 = (y < 0) ? -y : 0, j1 = (y + h > HEIGHT) ? HEIGHT - y : h;
+  if ((i0 >= i1) || (j0 >= j1))
+    return true;
+  const uint8_t *fg = ssd1306_colorOps[color];
+  const uint8_t *back = ssd1306_colorOps[opaque ? bg : 3]; // 3: leave alone
+  int16_t byteWidth = (w + 7) / 8;
+  int16_t top = y + j0, bottom = y + j1 - 1;
+
+  for (int16_t page = top >> 3; page <= (bottom >> 3); page++) {
+    int16_t r0 = (page * 8 > top) ? page * 8 : top;
+    int16_t r1 = (page * 8 + 7 < bottom) ? page * 8 + 7 : bottom;
+    uint8_t pm = (0xFF << (r0 & 7)) & (0xFF >> (7 - (r1 & 7)));
+    uint8_t *dst = &buffer[page * WIDTH];
+    for (int16_t bi = i0 / 8; bi <= (i1 - 1) / 8; bi++) {
+      uint8_t rows[8] = {0}; // One image byte per row of this page
+      for (int16_t r = r0; r <= r1; r++)
+        rows[r & 7] = bitmapByte(&bitmap[(r - y) * byteWidth + bi], flags);
+      int16_t c0 = (bi * 8 > i0) ? bi * 8 : i0;
+      int16_t c1 = (bi * 8 + 8 < i1) ? bi * 8 + 8 : i1;
+      for (int16_t i = c0; i < c1; i++) {
+        uint8_t shift = 7 - (i & 7), col = 0;
+        for (uint8_t k = 0; k < 8; k++)
+          col |= ((rows[k] >> shift) & 1) << k;
+        uint8_t m = col & pm, cm = ~col & pm;
+        uint8_t *d = &dst[x + i];
+        *d = (*d & ~(cm & back[0])) ^ (cm & back[1]);
+        *d = (*d & ~(m & fg[0])) ^ (m & fg[1]);
+      }
+    }
+  }
+  markDirty(x + i0, x + i1 - 1, top, bottom);
+  return true;
+}
+
+// TEXT --------------------------------------------------------------------
+
+/*!
+    @brief  Keep pre-rendered tiles of the classic built-in font. A cached
+            glyph is stored at its text size as column-major bytes in the
+            panel's page layout (6 * size columns by size pages), so
+            drawChar() blits it with byte-wide OR/AND operations instead of
+            one writePixel()/writeFillRect() per font pixel. Only used for
+            the built-in font at rotation 0 with square text sizes up to
+            maxSize, for glyphs entirely on screen; anything else takes the
+            Adafruit_GFX path. Slots are reused round-robin.
+    @param  slots    Number of glyphs to keep, 0 to free the cache.
+    @param  maxSize  Largest text size cached (1-8); each slot takes
+                     6 * maxSize * maxSize bytes.
+    @return true on success, false if out of memory (cache disabled).
+*/
+bool Adafruit_SSD1306::setGlyphCache(uint8_t slots, uint8_t maxSize) {
+  free(glyphTiles);
+  free(glyphKeys);
+  glyphTiles = NULL;
+  glyphKeys = NULL;
+  glyphSlots = glyphNext = 0;
+  if (maxSize > 8)
+    maxSize = 8;
+  if (!slots || !maxSize)
+    return true;
+  glyphTiles = (uint8_t *)malloc(slots * 6 * maxSize * maxSize);
+  glyphKeys = (uint16_t *)calloc(slots, sizeof(uint16_t));
+  if (!glyphTiles || !glyphKeys) {
+    setGlyphCache(0);
+    return false;
+  }
+  glyphSlots = slots;
+  glyphMaxSize = maxSize;
+  return true;
+}
+
+/*!
+    @brief  Draw a single character, from the glyph cache when it applies
+            (see setGlyphCache()).
+    @param  x       Left edge.
+    @param  y       Top edge.
+    @param  c       The 8-bit font-indexed character (likely ascii).
+    @param  color   SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE.
+    @param  bg      Background color, or the same as color for none.
+    @param  size_x  Font magnification level in X-axis.
+    @param  size_y  Font magnification level in Y-axis.
+    @return None (void).
+*/
+void Adafruit_SSD1306::drawChar(int16_t x, int16_t y, unsigned char c,
+                                uint16_t color, uint16_t bg, uint8_t size_x,
+                                uint8_t size_y) {
+  uint8_t size = size_x;
+  if (!glyphSlots || gfxFont || (size_x != size_y) || (size > glyphMaxSize) ||
+      getRotation() || (color > SSD1306_INVERSE) || (bg > SSD1306_INVERSE) ||
+      (x < 0) || (y < 0) || (x + 6 * size > WIDTH) ||
+      (y + 8 * size > HEIGHT) ||
+      !clipContains(x, y, x + 6 * size - 1, y + 8 * size - 1)) {
+    Adafruit_GFX::drawChar(x, y, c, color, bg, size_x, size_y);
+    return;
+  }
+  if (!_cp437 && (c >= 176))
+    c++; // Handle 'classic' charset behavior, as Adafruit_GFX does
+
+  uint16_t w = 6 * size, tileBytes = 6 * glyphMaxSize * glyphMaxSize;
+  uint16_t key = ((uint16_t)size << 8) | c; // size >= 1, so never 0
+  uint8_t slot = 0;
+  while ((slot < glyphSlots) && (glyphKeys[slot] != key))
+    slot++;
+  uint8_t *tile;
+  if (slot < glyphSlots) {
+    tile = &glyphTiles[slot * tileBytes];
+  } else {
+    // Miss: rasterize into the next slot, each font row scaled to size rows
+    slot = glyphNext;
+    glyphNext = (glyphNext + 1) % glyphSlots;
+    glyphKeys[slot] = key;
+    tile = &glyphTiles[slot * tileBytes];
+    memset(tile, 0, w * size);
+    for (uint8_t i = 0; i < 6; i++) {
+      uint8_t line = classicGlyphColumn(c, i);
+      for (uint8_t r = 0; r < 8 * size; r++) {
+        if (line & (1 << (r / size))) {
+          uint8_t *t = &tile[(r >> 3) * w + i * size];
+          for (uint8_t k = 0; k < size; k++)
+            t[k] |= 1 << (r & 7);
+        }
+      }
+    }
+  }
+  blitGlyph(tile, x, y, size, color, bg);
+}
+
+/*!
+    @brief  Combine a cached glyph tile with the buffer at any row offset:
+            each tile byte is shifted into the one or two pages it covers.
+            Set bits take color; with an opaque bg the clear bits of the
+            cell take bg.
+    @param  tile   Tile from the glyph cache, 6 * size by size pages.
+    @param  x      Left edge, on screen.
+    @param  y      Top edge, on screen.
+    @param  size   Text size of the tile.
+    @param  color  Foreground color, SSD1306_BLACK to SSD1306_INVERSE.
+    @param  bg     Background color, or the same as color for none.
+    @return None (void).
+*/
+void Adafruit_SSD1306::blitGlyph(const uint8_t *tile, int16_t x, int16_t y,
+                                 uint8_t size, uint16_t color, uint16_t bg) {
+  const uint8_t *fg = ssd1306_colorOps[color];
+  const uint8_t *back = ssd1306_colorOps[(bg == color) ? 3 : bg];
+  uint16_t w = 6 * size;
+  uint8_t shift = y & 7;
+  markDirty(x, x + w - 1, y, y + 8 * size - 1);
+  for (uint8_t tp = 0; tp < size; tp++) {
+    int16_t page = (y >> 3) + tp;
+    uint8_t *lo = &buffer[page * WIDTH + x];
+    // The lower part spills into the next page unless page-aligned
+    uint8_t *hi = (shift && (page + 1) * 8 < HEIGHT) ? lo + WIDTH : NULL;
+    const uint8_t *t = &tile[tp * w];
+    for (uint16_t i = 0; i < w; i++) {
+      uint8_t set = t[i], clear = ~t[i];
+      uint8_t m = set << shift, cm = clear << shift;
+      lo[i] = (lo[i] & ~(cm & back[0])) ^ (cm & back[1]);
+      lo[i] = (lo[i] & ~(m & fg[0])) ^ (m & fg[1]);
+      if (hi) {
+        m = set >> (8 - shift);
+        cm = (uint8_t)clear >> (8 - shift);
+        hi[i] = (hi[i] & ~(cm & back[0])) ^ (cm & back[1]);
+        hi[i] = (hi[i] & ~(m & fg[0])) ^ (m & fg[1]);
+      }
+    }
+  }
+}
 
 // REFRESH DISPLAY ---------------------------------------------------------
 
 /*!
-    @brief  Push data currently in RAM to SSD1306 display.
+    @brief  Push data currently in RAM to SSD1306 display. Only the window
+            of pages and columns touched by drawing since the last call is
+            sent (trimmed further to what actually differs from the panel
+            if setPanelShadow() is on); nothing at all if nothing changed.
+            With startBackgroundRefresh() this only hands the frame to the
+            refresh task and returns without touching the bus.
     @return None (void).
     @note   Drawing operations are not visible until this function is
             called. Call after each graphics command, or after a whole set
             of graphics commands, as best needed by one's own application.
 */
 void Adafruit_SSD1306::display(void) {
-  TRANSACTION_START
-  static const uint8_t PROGMEM dlist1[] = {
-      SSD1306_PAGEADDR,
-      0,                   // Page start address
-      0xFF,                // Page end (not really, but works here)
-      SSD1306_COLUMNADDR}; // Column start address
-  ssd1306_commandList(dlist1, sizeof(dlist1));
-
-  if (WIDTH == 64) {
-    ssd1306_command1(0x20);             // Column start
-    ssd1306_command1(0x20 + WIDTH - 1); // Column end address
-  } else {
-    ssd1306_command1(0);           // Column start
-    ssd1306_command1((WIDTH - 1)); // Column end address
+  int16_t x1 = dirtyX1, x2 = dirtyX2, p1 = dirtyPage1, p2 = dirtyPage2;
+  clearDirty();
+  if (x1 > x2) {
+    lastRefresh = 0;
+    return; // Nothing drawn since the last refresh
+  }
+#if defined(ESP32)
+  if (refreshHandle) {
+    // The frame boundary: copy what changed into the hand-over buffer,
+    // which otherwise still equals the back buffer as of the last call
+    uint16_t span = x2 - x1 + 1;
+    xSemaphoreTake(frameLock, portMAX_DELAY);
+    for (int16_t p = p1; p <= p2; p++)
+      memcpy(&ready[p * WIDTH + x1], &buffer[p * WIDTH + x1], span);
+    if (pendX1 <= pendX2)
+      coalesced++;
+    if (x1 < pendX1)
+      pendX1 = x1;
+    if (x2 > pendX2)
+      pendX2 = x2;
+    if (p1 < pendPage1)
+      pendPage1 = p1;
+    if (p2 > pendPage2)
+      pendPage2 = p2;
+    xSemaphoreGive(frameLock);
+    xTaskNotifyGive(refreshHandle);
+    return;
   }
+#endif
+  refresh(buffer, x1, x2, p1, p2);
+}
+
+/*!
+    @brief  Send one window of a frame buffer to the panel, trimmed to what
+            differs if the panel shadow is on.
+    @param  buf  Frame buffer to send from.
+    @param  x1   Leftmost column.
+    @param  x2   Rightmost column.
+    @param  p1   Topmost page.
+    @param  p2   Bottom page.
+    @return None (void).
+*/
+void Adafruit_SSD1306::refresh(const uint8_t *buf, int16_t x1, int16_t x2,
+                               int16_t p1, int16_t p2) {
+  lastRefresh = 0;
+  if (shadow && shadowValid) {
+    // Shrink the window to the bytes that differ from the panel
+    int16_t nx1 = 0x7FFF, nx2 = -1, np1 = 0x7F, np2 = -1;
+    for (int16_t p = p1; p <= p2; p++) {
+      const uint8_t *b = &buf[p * WIDTH], *o = &shadow[p * WIDTH];
+      int16_t l = x1, r = x2;
+      while ((l <= r) && (b[l] == o[l]))
+        l++;
+      if (l > r)
+        continue;
+      while (b[r] == o[r])
+        r--;
+      if (l < nx1)
+        nx1 = l;
+      if (r > nx2)
+        nx2 = r;
+      if (np1 > p)
+        np1 = p;
+      np2 = p;
+    }
+    if (nx1 > nx2)
+      return; // Redrawn, but identical to what is shown
+    x1 = nx1;
+    x2 = nx2;
+    p1 = np1;
+    p2 = np2;
+  }
+
+  TRANSACTION_START
+  uint8_t offset = (WIDTH == 64) ? 0x20 : 0; // 64-wide panels start at 32
+  uint8_t window[] = {SSD1306_PAGEADDR,
+                      (uint8_t)p1, // Page start address
+                      (uint8_t)p2, // Page end address
+                      SSD1306_COLUMNADDR,
+                      (uint8_t)(offset + x1),  // Column start address
+                      (uint8_t)(offset + x2)}; // Column end address
+  ssd1306_commandBuffer(window, sizeof(window));
 
 #if defined(ESP8266)
   // ESP8266 needs a periodic yield() call to avoid watchdog reset.
@@ -1022,34 +1539,159 @@ void Adafruit_SSD1306::display(void) {
   // 32-byte transfer condition below.
   yield();
 #endif
-  uint16_t count = WIDTH * ((HEIGHT + 7) / 8);
-  uint8_t *ptr = buffer;
+  // The controller wraps to the next page at column x2, so the window
+  // goes out as one stream of (x2 - x1 + 1) bytes per page
+  uint16_t span = x2 - x1 + 1;
   if (wire) { // I2C
-    wire->beginTransmission(i2caddr);
+    wireBegin();
     WIRE_WRITE((uint8_t)0x40);
     uint16_t bytesOut = 1;
-    while (count--) {
-      if (bytesOut >= WIRE_MAX) {
-        wire->endTransmission();
-        wire->beginTransmission(i2caddr);
-        WIRE_WRITE((uint8_t)0x40);
-        bytesOut = 1;
+    for (int16_t p = p1; p <= p2; p++) {
+      const uint8_t *ptr = &buf[p * WIDTH + x1];
+      uint16_t count = span;
+      while (count--) {
+        if (bytesOut >= WIRE_MAX) {
+          wireEnd();
+          wireBegin();
+          WIRE_WRITE((uint8_t)0x40);
+          bytesOut = 1;
+        }
+        WIRE_WRITE(*ptr++);
+        bytesOut++;
       }
-      WIRE_WRITE(*ptr++);
-      bytesOut++;
     }
-    wire->endTransmission();
+    wireEnd();
   } else { // SPI
     SSD1306_MODE_DATA
-    while (count--)
-      SPIwrite(*ptr++);
+    if (span == WIDTH) { // Full-width pages are contiguous in the buffer
+      SPIwrite(&buf[p1 * WIDTH], (size_t)WIDTH * (p2 - p1 + 1));
+    } else {
+      for (int16_t p = p1; p <= p2; p++)
+        SPIwrite(&buf[p * WIDTH + x1], span);
+    }
   }
   TRANSACTION_END
 #if defined(ESP8266)
   yield();
 #endif
+  lastRefresh = span * (p2 - p1 + 1);
+
+  if (shadow) {
+    for (int16_t p = p1; p <= p2; p++)
+      memcpy(&shadow[p * WIDTH + x1], &buf[p * WIDTH + x1], span);
+    // A window covering the whole panel makes the copy complete
+    if ((x1 == 0) && (x2 == WIDTH - 1) && (p1 == 0) &&
+        (p2 == (HEIGHT + 7) / 8 - 1))
+      shadowValid = true;
+  }
 }
 
+#if defined(ESP32)
+/*!
+    @brief  Double-buffered refresh: from now on display() copies the
+            changed part of the buffer into a hand-over frame in a few
+            microseconds and returns, and a FreeRTOS task streams that
+            frame to the panel. Frames are only taken whole, so the panel
+            never shows half of one; if display() is called again before
+            the task got to a frame, the task sends the newer one instead.
+            Needs two more buffers of WIDTH * ((HEIGHT + 7) / 8) bytes.
+            Call after begin().
+    @param  priority
+            FreeRTOS priority of the refresh task; keep it below anything
+            time-critical.
+    @param  core
+            Core to pin the task to, or tskNO_AFFINITY.
+    @return true if the task is running, false if out of memory or
+            begin() was not called.
+*/
+bool Adafruit_SSD1306::startBackgroundRefresh(UBaseType_t priority,
+                                              BaseType_t core) {
+  if (refreshHandle)
+    return true;
+  if (!buffer)
+    return false;
+  size_t bytes = WIDTH * ((HEIGHT + 7) / 8);
+  ready = (uint8_t *)malloc(bytes);
+  front = (uint8_t *)malloc(bytes);
+  frameLock = xSemaphoreCreateMutex();
+  busLock = xSemaphoreCreateRecursiveMutex();
+  if (!ready || !front || !frameLock || !busLock) {
+    stopBackgroundRefresh();
+    return false;
+  }
+  memcpy(ready, buffer, bytes);
+  memcpy(front, buffer, bytes);
+  coalesced = 0;
+  if (xTaskCreatePinnedToCore(refreshTask, "ssd1306", 2048, this, priority,
+                              &refreshHandle, core) != pdPASS) {
+    refreshHandle = NULL;
+    stopBackgroundRefresh();
+    return false;
+  }
+  return true;
+}
+
+/*!
+    @brief  Back to synchronous display(). Waits for a refresh in progress
+            to finish; a frame not yet sent is dropped (call display()
+            again to send it).
+    @return None (void).
+*/
+void Adafruit_SSD1306::stopBackgroundRefresh(void) {
+  if (refreshHandle) {
+    // Holding both locks, the task is idle or blocked on one of them
+    xSemaphoreTakeRecursive(busLock, portMAX_DELAY);
+    xSemaphoreTake(frameLock, portMAX_DELAY);
+    vTaskDelete(refreshHandle);
+    refreshHandle = NULL;
+    xSemaphoreGive(frameLock);
+    xSemaphoreGiveRecursive(busLock);
+  }
+  if (busLock) {
+    vSemaphoreDelete(busLock);
+    busLock = NULL;
+  }
+  if (frameLock) {
+    vSemaphoreDelete(frameLock);
+    frameLock = NULL;
+  }
+  free(ready);
+  free(front);
+  ready = front = NULL;
+  pendX1 = 0x7FFF;
+  pendX2 = -1;
+  pendPage1 = 0x7F;
+  pendPage2 = -1;
+}
+
+/*!
+    @brief  Background refresh loop: waits for display(), takes the newest
+            frame under the lock and sends it outside of it.
+    @param  arg  The Adafruit_SSD1306 instance.
+    @return None (void).
+*/
+void Adafruit_SSD1306::refreshTask(void *arg) {
+  Adafruit_SSD1306 *self = (Adafruit_SSD1306 *)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    xSemaphoreTake(self->frameLock, portMAX_DELAY);
+    int16_t x1 = self->pendX1, x2 = self->pendX2;
+    int16_t p1 = self->pendPage1, p2 = self->pendPage2;
+    uint16_t span = x2 - x1 + 1;
+    for (int16_t p = p1; p <= p2 && x1 <= x2; p++)
+      memcpy(&self->front[p * self->WIDTH + x1],
+             &self->ready[p * self->WIDTH + x1], span);
+    self->pendX1 = 0x7FFF;
+    self->pendX2 = -1;
+    self->pendPage1 = 0x7F;
+    self->pendPage2 = -1;
+    xSemaphoreGive(self->frameLock);
+    if (x1 <= x2)
+      self->refresh(self->front, x1, x2, p1, p2);
+  }
+}
+#endif
+
 // SCROLLING FUNCTIONS -----------------------------------------------------
 
 /*!
@@ -1158,6 +1800,8 @@ void Adafruit_SSD1306::stopscroll(void) {
   TRANSACTION_START
   ssd1306_command1(SSD1306_DEACTIVATE_SCROLL);
   TRANSACTION_END
+  shadowValid = false; // scrolling moved the panel contents
+  markDirty();
 }
 
 // OTHER HARDWARE SETTINGS -------------------------------------------------
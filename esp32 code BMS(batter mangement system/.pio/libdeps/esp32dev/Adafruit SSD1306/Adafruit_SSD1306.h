@@ -43,6 +43,12 @@ typedef class HardwareSPI SPIClass;
 #include <SPI.h>
 #include <Wire.h>
 
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
 #if defined(__AVR__)
 typedef volatile uint8_t PortReg;
 typedef uint8_t PortMask;
@@ -154,6 +160,7 @@ public:
   void invertDisplay(bool i);
   void dim(bool dim);
   void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void setRotation(uint8_t r);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   void startscrollright(uint8_t start, uint8_t stop);
@@ -163,14 +170,71 @@ public:
   void stopscroll(void);
   void ssd1306_command(uint8_t c);
   bool getPixel(int16_t x, int16_t y);
+  using Adafruit_GFX::drawChar;
+  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+                uint16_t bg, uint8_t size_x, uint8_t size_y);
+  bool setGlyphCache(uint8_t slots, uint8_t maxSize = 2);
   uint8_t *getBuffer(void);
+  void markDirty(void);
+  bool setPanelShadow(bool enable);
+  /*!
+      @brief  Number of data bytes the last display() sent to the panel.
+      @return 0 if nothing had changed, WIDTH * pages for a full refresh.
+  */
+  uint16_t lastRefreshBytes(void) { return lastRefresh; }
+#if defined(ESP32)
+  bool startBackgroundRefresh(UBaseType_t priority = 1,
+                              BaseType_t core = tskNO_AFFINITY);
+  void stopBackgroundRefresh(void);
+  /*!
+      @brief  Frames that display() replaced before the background task
+              got to them (the panel skipped straight to the newer one).
+      @return Count since startBackgroundRefresh().
+  */
+  uint32_t framesCoalesced(void) { return coalesced; }
+#endif
 
 protected:
   inline void SPIwrite(uint8_t d) __attribute__((always_inline));
+  void SPIwrite(const uint8_t *d, size_t n);
   void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color);
   void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color);
   void ssd1306_command1(uint8_t c);
   void ssd1306_commandList(const uint8_t *c, uint8_t n);
+  void ssd1306_commandBuffer(const uint8_t *c, uint8_t n);
+  /*!
+      @brief  Grow the dirty window by a region of the buffer (physical,
+              unrotated coordinates, already clipped, inclusive).
+      @param  x1  Leftmost changed column.
+      @param  x2  Rightmost changed column.
+      @param  y1  Topmost changed row.
+      @param  y2  Bottom changed row.
+  */
+  inline void markDirty(int16_t x1, int16_t x2, int16_t y1, int16_t y2) {
+    if (x1 < dirtyX1)
+      dirtyX1 = x1;
+    if (x2 > dirtyX2)
+      dirtyX2 = x2;
+    if ((y1 >> 3) < dirtyPage1)
+      dirtyPage1 = y1 >> 3;
+    if ((y2 >> 3) > dirtyPage2)
+      dirtyPage2 = y2 >> 3;
+  }
+  void clearDirty(void);
+  template <uint8_t ROT>
+  void drawPixelRotated(int16_t x, int16_t y, uint16_t color);
+  template <uint8_t ROT> bool getPixelRotated(int16_t x, int16_t y);
+  bool blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w,
+                  int16_t h, uint16_t color, uint16_t bg, uint8_t flags);
+  void blitGlyph(const uint8_t *tile, int16_t x, int16_t y, uint8_t size,
+                 uint16_t color, uint16_t bg);
+  void refresh(const uint8_t *buf, int16_t x1, int16_t x2, int16_t p1,
+               int16_t p2);
+  void wireBegin(void);
+  void wireEnd(void);
+#if defined(ESP32)
+  static void refreshTask(void *arg);
+#endif
 
   SPIClass *spi;   ///< Initialized during construction when using SPI. See
                    ///< SPI.cpp, SPI.h
@@ -198,6 +262,35 @@ protected:
   uint32_t restoreClk; ///< Wire speed following SSD1306 transfers
 #endif
   uint8_t contrast; ///< normal contrast setting for this device
+  uint8_t *shadow = NULL;    ///< Copy of panel RAM, see setPanelShadow()
+  bool shadowValid = false;  ///< shadow matches the panel
+  int16_t dirtyX1 = 0x7FFF;  ///< Leftmost column changed since display()
+  int16_t dirtyX2 = -1;      ///< Rightmost changed column, < dirtyX1 if none
+  int16_t dirtyPage1 = 0x7F; ///< Topmost changed page (8 rows)
+  int16_t dirtyPage2 = -1;   ///< Bottom changed page
+  uint16_t lastRefresh = 0;  ///< Data bytes sent by the last display()
+  uint8_t *glyphTiles = NULL; ///< Glyph cache tiles, see setGlyphCache()
+  uint16_t *glyphKeys = NULL; ///< Per slot: size << 8 | char, 0 = empty
+  uint8_t glyphSlots = 0;     ///< Glyph cache slots, 0 = cache off
+  uint8_t glyphMaxSize = 0;   ///< Largest cached text size
+  uint8_t glyphNext = 0;      ///< Slot the next miss replaces
+  /// drawPixel() for the current rotation, picked by setRotation()
+  void (Adafruit_SSD1306::*pixelWriter)(int16_t, int16_t, uint16_t) =
+      &Adafruit_SSD1306::drawPixelRotated<0>;
+  /// getPixel() for the current rotation, picked by setRotation()
+  bool (Adafruit_SSD1306::*pixelReader)(int16_t, int16_t) =
+      &Adafruit_SSD1306::getPixelRotated<0>;
+#if defined(ESP32)
+  uint8_t *ready = NULL; ///< Last frame handed over by display(), background
+  uint8_t *front = NULL; ///< Frame the background task is sending
+  SemaphoreHandle_t frameLock = NULL; ///< Guards ready and pending window
+  SemaphoreHandle_t busLock = NULL;   ///< One panel transfer at a time
+  Adafruit_I2CDevice *i2cDev = NULL;  ///< Lends its BusIO bus lock, I2C
+  TaskHandle_t refreshHandle = NULL;  ///< Background refresh task
+  int16_t pendX1 = 0x7FFF, pendX2 = -1; ///< Window of ready not yet sent
+  int16_t pendPage1 = 0x7F, pendPage2 = -1;
+  uint32_t coalesced = 0; ///< See framesCoalesced()
+#endif
 #if defined(SPI_HAS_TRANSACTION)
 protected:
   // Allow sub-class to change
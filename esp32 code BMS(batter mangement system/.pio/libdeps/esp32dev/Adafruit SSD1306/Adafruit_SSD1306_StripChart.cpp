@@ -0,0 +1,95 @@
+/*!
+ * @file Adafruit_SSD1306_StripChart.cpp
+ *
+ * Sweep-style strip chart for Adafruit_SSD1306 displays.
+ *
+ * BSD license, all text above must be included in any redistribution.
+ */
+
+#include "Adafruit_SSD1306_StripChart.h"
+
+/*!
+    @brief  Strip chart in a rectangle of the display. Nothing is drawn
+            until clear() or the first add().
+    @param  display  Display to draw into (after its begin()).
+    @param  x        Left edge of the chart.
+    @param  y        Top edge of the chart. Page-aligned (a multiple of 8)
+                     with a multiple-of-8 height keeps each column update
+                     to whole pages the chart owns.
+    @param  width    Chart width in pixels: samples shown at once.
+    @param  height   Chart height in pixels.
+*/
+Adafruit_SSD1306_StripChart::Adafruit_SSD1306_StripChart(
+    Adafruit_SSD1306 &display, int16_t x, int16_t y, int16_t width,
+    int16_t height)
+    : disp(display), x0(x), y0(y), w(width > 0 ? width : 1),
+      h(height > 0 ? height : 1) {}
+
+/*!
+    @brief  Set the values shown at the bottom and top edge; samples
+            outside are clamped to the edge. Takes effect from the next
+            sample on (columns already drawn are not rescaled).
+    @param  bottom  Value at the bottom row.
+    @param  top     Value at the top row.
+    @return None (void).
+*/
+void Adafruit_SSD1306_StripChart::setRange(float bottom, float top) {
+  lo = bottom;
+  hi = (top != bottom) ? top : bottom + 1.0f;
+}
+
+/*!
+    @brief  Blank the chart rectangle and restart at its left edge.
+    @return None (void).
+    @note   Changes buffer contents only; follow up with display().
+*/
+void Adafruit_SSD1306_StripChart::clear(void) {
+  disp.fillRect(x0, y0, w, h, SSD1306_BLACK);
+  col = 0;
+  lastRow = -1;
+}
+
+/*!
+    @brief  Map a value to a chart row, clamped to the rectangle.
+    @param  value  Sample value.
+    @return Row in display coordinates.
+*/
+int16_t Adafruit_SSD1306_StripChart::rowFor(float value) const {
+  float f = (value - lo) / (hi - lo);
+  if (f < 0.0f)
+    f = 0.0f;
+  else if (f > 1.0f)
+    f = 1.0f;
+  return y0 + (h - 1) - (int16_t)(f * (h - 1) + 0.5f);
+}
+
+/*!
+    @brief  Plot one sample in the cursor column, joined to the previous
+            sample by a vertical segment, blank the next column as the
+            sweep gap, and advance the cursor (wrapping at the right edge).
+    @param  value  Sample value, in the units of setRange().
+    @return None (void).
+    @note   Changes buffer contents only; follow up with display().
+*/
+void Adafruit_SSD1306_StripChart::add(float value) {
+  int16_t x = x0 + col;
+  int16_t row = rowFor(value);
+  int16_t top = row, bottom = row;
+  if (lastRow >= 0) {
+    if (lastRow < top)
+      top = lastRow;
+    if (lastRow > bottom)
+      bottom = lastRow;
+  }
+  disp.drawFastVLine(x, y0, h, SSD1306_BLACK);
+  disp.drawFastVLine(x, top, bottom - top + 1, SSD1306_WHITE);
+  // The gap is skipped at the right edge: column 0 is redrawn next anyway,
+  // and blanking it now would stretch the dirty window across the chart
+  if (col + 1 < w)
+    disp.drawFastVLine(x + 1, y0, h, SSD1306_BLACK);
+  lastRow = row;
+  if (++col >= w) {
+    col = 0;
+    lastRow = -1; // No segment across the wrap
+  }
+}
@@ -0,0 +1,55 @@
+/*!
+ * @file Adafruit_SSD1306_StripChart.h
+ *
+ * Rolling strip chart (sparkline) for Adafruit_SSD1306 displays that costs
+ * one display column per sample instead of a full-screen redraw.
+ *
+ * BSD license, all text above must be included in any redistribution.
+ */
+
+#ifndef _Adafruit_SSD1306_StripChart_H_
+#define _Adafruit_SSD1306_StripChart_H_
+
+#include <Adafruit_SSD1306.h>
+
+/*!
+    @brief  Sweep-style strip chart in a rectangle of an Adafruit_SSD1306
+            buffer. Each add() draws one new column at a moving cursor and
+            blanks the column ahead of it, like an oscilloscope sweep, so the
+            display's dirty window (and the next display()) covers just those
+            two columns of the chart's pages: 8 bytes per sample for a 32-row
+            chart, not 1 KB.
+
+            The SSD1306 hardware scroll commands move the whole area
+            continuously on a frame timer and cannot step one column per
+            sample, and scrolling the buffer in RAM would resend the whole
+            chart, so the chart wraps around instead. The one-column cost
+            holds for rotations 0 and 2; in 1 and 3 a chart column is a panel
+            row.
+*/
+class Adafruit_SSD1306_StripChart {
+public:
+  Adafruit_SSD1306_StripChart(Adafruit_SSD1306 &display, int16_t x, int16_t y,
+                              int16_t width, int16_t height);
+
+  void setRange(float bottom, float top);
+  void clear(void);
+  void add(float value);
+
+  /*!
+      @brief  Column the next add() draws into.
+      @return 0 (left edge of the chart) to width - 1.
+  */
+  int16_t cursor(void) const { return col; }
+
+private:
+  int16_t rowFor(float value) const;
+
+  Adafruit_SSD1306 &disp; ///< Display whose buffer the chart draws into
+  int16_t x0, y0, w, h;   ///< Chart rectangle
+  float lo = 0.0f, hi = 1.0f; ///< Values mapped to the bottom and top row
+  int16_t col = 0;            ///< Next column, 0 .. w - 1
+  int16_t lastRow = -1;       ///< Row of the previous sample, -1 if none
+};
+
+#endif // _Adafruit_SSD1306_StripChart_H_
@@ -0,0 +1,43 @@
+/**************************************************************************
+ Rolling strip chart on a 128x64 SSD1306 over I2C.
+
+ A header line is drawn once; after that every sample adds one column to
+ the chart and display() only sends the few bytes that changed, so the
+ plot can run at 50 samples per second without redrawing the screen.
+ **************************************************************************/
+
+#include <Adafruit_SSD1306.h>
+#include <Adafruit_SSD1306_StripChart.h>
+#include <Wire.h>
+
+#define SCREEN_WIDTH 128 // OLED display width, in pixels
+#define SCREEN_HEIGHT 64 // OLED display height, in pixels
+#define SCREEN_ADDRESS 0x3C
+
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+// Chart on the lower 48 rows (pages 2-7), full width: 128 samples shown
+Adafruit_SSD1306_StripChart chart(display, 0, 16, SCREEN_WIDTH, 48);
+
+void setup() {
+  Serial.begin(115200);
+  if (!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
+    Serial.println(F("SSD1306 allocation failed"));
+    for (;;)
+      ; // Don't proceed, loop forever
+  }
+  display.setPanelShadow(true);
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(0, 0);
+  display.println(F("A0 (0-4095)"));
+  chart.setRange(0, 4095);
+  chart.clear();
+  display.display();
+}
+
+void loop() {
+  chart.add(analogRead(A0));
+  display.display();
+  Serial.printf("%u bytes\n", display.lastRefreshBytes());
+  delay(20);
+}
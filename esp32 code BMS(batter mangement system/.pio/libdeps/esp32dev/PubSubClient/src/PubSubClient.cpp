@@ -159,7 +159,24 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
 }
 
 PubSubClient::~PubSubClient() {
-  free(this->buffer);
+  if (this->ownsBuffer) {
+    free(this->buffer);
+  }
+  if (this->ownsCombine) {
+    free(this->combineBuf);
+  }
+  for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+    if (this->inflight[i].data) {
+      this->freeFn(this->inflight[i].data);
+    }
+  }
+#if MQTT_VERSION == MQTT_VERSION_5
+  for (uint8_t i = 0; i < MQTT_MAX_TOPIC_ALIASES; i++) {
+    if (this->aliases[i].topic) {
+      this->freeFn(this->aliases[i].topic);
+    }
+  }
+#endif
 }
 
 boolean PubSubClient::connect(const char *id) {
@@ -180,6 +197,10 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
 
 boolean PubSubClient::connect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
     if (!connected()) {
+        if (this->asyncPhase != MQTT_ASYNC_IDLE) {
+            // A connectAsync() is in progress
+            return false;
+        }
         int result = 0;
 
 
@@ -194,96 +215,392 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
         }
 
         if (result == 1) {
-            nextMsgId = 1;
-            // Leave room in the buffer for header and variable length field
-            uint16_t length = MQTT_MAX_HEADER_SIZE;
-            unsigned int j;
+            if (!sendConnect(id,user,pass,willTopic,willQos,willRetain,willMessage,cleanSession)) {
+                return false;
+            }
+
+            while (!_client->available()) {
+                unsigned long t = millis();
+                if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
+                    _state = MQTT_CONNECTION_TIMEOUT;
+                    _client->stop();
+                    return false;
+                }
+            }
+            return readConnack();
+        } else {
+            _state = MQTT_CONNECT_FAILED;
+        }
+        return false;
+    }
+    return true;
+}
+
+boolean PubSubClient::sendConnect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
+    if (inflightCount == 0) {
+        // Ids still awaiting a PUBACK must not be reused
+        nextMsgId = 1;
+    }
+    // Leave room in the buffer for header and variable length field
+    uint16_t length = MQTT_MAX_HEADER_SIZE;
+    unsigned int j;
 
 #if MQTT_VERSION == MQTT_VERSION_3_1
-            uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
+    uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 9
-#elif MQTT_VERSION == MQTT_VERSION_3_1_1
-            uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
+#elif MQTT_VERSION == MQTT_VERSION_3_1_1 || MQTT_VERSION == MQTT_VERSION_5
+    uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 7
 #endif
-            for (j = 0;j<MQTT_HEADER_VERSION_LENGTH;j++) {
-                this->buffer[length++] = d[j];
-            }
+    for (j = 0;j<MQTT_HEADER_VERSION_LENGTH;j++) {
+        this->buffer[length++] = d[j];
+    }
 
-            uint8_t v;
-            if (willTopic) {
-                v = 0x04|(willQos<<3)|(willRetain<<5);
-            } else {
-                v = 0x00;
-            }
-            if (cleanSession) {
-                v = v|0x02;
-            }
+    uint8_t v;
+    if (willTopic) {
+        v = 0x04|(willQos<<3)|(willRetain<<5);
+    } else {
+        v = 0x00;
+    }
+    if (cleanSession) {
+        v = v|0x02;
+    }
 
-            if(user != NULL) {
-                v = v|0x80;
+    if(user != NULL) {
+        v = v|0x80;
 
-                if(pass != NULL) {
-                    v = v|(0x80>>1);
-                }
-            }
-            this->buffer[length++] = v;
-
-            this->buffer[length++] = ((this->keepAlive) >> 8);
-            this->buffer[length++] = ((this->keepAlive) & 0xFF);
-
-            CHECK_STRING_LENGTH(length,id)
-            length = writeString(id,this->buffer,length);
-            if (willTopic) {
-                CHECK_STRING_LENGTH(length,willTopic)
-                length = writeString(willTopic,this->buffer,length);
-                CHECK_STRING_LENGTH(length,willMessage)
-                length = writeString(willMessage,this->buffer,length);
-            }
+        if(pass != NULL) {
+            v = v|(0x80>>1);
+        }
+    }
+    this->buffer[length++] = v;
+
+    this->buffer[length++] = ((this->keepAlive) >> 8);
+    this->buffer[length++] = ((this->keepAlive) & 0xFF);
+
+#if MQTT_VERSION == MQTT_VERSION_5
+    // Properties. Clean Start=0 alone keeps nothing once the connection
+    // closes; the session lasts for the Session Expiry Interval
+    if (!cleanSession && this->sessionExpiry != 0) {
+        this->buffer[length++] = 5;
+        this->buffer[length++] = MQTT_PROP_SESSION_EXPIRY;
+        this->buffer[length++] = (this->sessionExpiry >> 24);
+        this->buffer[length++] = (this->sessionExpiry >> 16);
+        this->buffer[length++] = (this->sessionExpiry >> 8);
+        this->buffer[length++] = (this->sessionExpiry & 0xFF);
+    } else {
+        this->buffer[length++] = 0;
+    }
+#endif
 
-            if(user != NULL) {
-                CHECK_STRING_LENGTH(length,user)
-                length = writeString(user,this->buffer,length);
-                if(pass != NULL) {
-                    CHECK_STRING_LENGTH(length,pass)
-                    length = writeString(pass,this->buffer,length);
-                }
-            }
+    CHECK_STRING_LENGTH(length,id)
+    length = writeString(id,this->buffer,length);
+    if (willTopic) {
+#if MQTT_VERSION == MQTT_VERSION_5
+        this->buffer[length++] = 0; // no will properties
+#endif
+        CHECK_STRING_LENGTH(length,willTopic)
+        length = writeString(willTopic,this->buffer,length);
+        CHECK_STRING_LENGTH(length,willMessage)
+        length = writeString(willMessage,this->buffer,length);
+    }
 
-            write(MQTTCONNECT,this->buffer,length-MQTT_MAX_HEADER_SIZE);
+    if(user != NULL) {
+        CHECK_STRING_LENGTH(length,user)
+        length = writeString(user,this->buffer,length);
+        if(pass != NULL) {
+            CHECK_STRING_LENGTH(length,pass)
+            length = writeString(pass,this->buffer,length);
+        }
+    }
 
-            lastInActivity = lastOutActivity = millis();
+    write(MQTTCONNECT,this->buffer,length-MQTT_MAX_HEADER_SIZE);
 
-            while (!_client->available()) {
-                unsigned long t = millis();
-                if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
-                    _state = MQTT_CONNECTION_TIMEOUT;
-                    _client->stop();
-                    return false;
-                }
-            }
-            uint8_t llen;
-            uint32_t len = readPacket(&llen);
+    lastInActivity = lastOutActivity = millis();
+    return true;
+}
 
-            if (len == 4) {
-                if (buffer[3] == 0) {
-                    lastInActivity = millis();
-                    pingOutstanding = false;
-                    _state = MQTT_CONNECTED;
-                    return true;
-                } else {
-                    _state = buffer[3];
+boolean PubSubClient::readConnack() {
+    uint8_t llen;
+    uint32_t len = readPacket(&llen);
+
+    // Fixed header, then the acknowledge flags and the return (v5: reason) code
+    if (len >= (uint32_t)llen + 3) {
+        if (buffer[llen+2] == 0) {
+            this->_sessionPresent = buffer[llen+1] & 0x01;
+#if MQTT_VERSION == MQTT_VERSION_5
+            readConnackProperties(llen + 3, len);
+            // Aliases only live as long as one network connection
+            for (uint8_t i = 0; i < MQTT_MAX_TOPIC_ALIASES; i++) {
+                this->aliases[i].established = false;
+            }
+#endif
+            lastInActivity = millis();
+            pingOutstanding = false;
+            _state = MQTT_CONNECTED;
+            // Publishes left unacknowledged by the last connection
+            for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+                if (this->inflight[i].data) {
+                    sendInflight(i, true);
                 }
             }
-            _client->stop();
+            return true;
         } else {
-            _state = MQTT_CONNECT_FAILED;
+            _state = buffer[llen+2];
+        }
+    }
+    _client->stop();
+    return false;
+}
+
+#if MQTT_VERSION == MQTT_VERSION_5
+// Decodes a variable byte integer from at most avail bytes of buf; returns
+// its size, or 0 if it is malformed or cut off
+static uint8_t readVarInt(const uint8_t* buf, uint32_t avail, uint32_t* value) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < 4 && i < avail; i++) {
+        v |= (uint32_t)(buf[i] & 127) << (7 * i);
+        if ((buf[i] & 128) == 0) {
+            *value = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Size of the value of property id at buf, or 0 if unknown or cut off
+static uint32_t propertySize(uint8_t id, const uint8_t* buf, uint32_t avail) {
+    uint32_t size;
+    switch (id) {
+    case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+        size = 1;
+        break;
+    case 0x13: case 0x21: case 0x22: case 0x23:
+        size = 2;
+        break;
+    case 0x02: case 0x11: case 0x18: case 0x27:
+        size = 4;
+        break;
+    case 0x0B: {
+        uint32_t v;
+        size = readVarInt(buf, avail, &v);
+        break;
+    }
+    case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+        size = (avail >= 2) ? 2 + ((buf[0] << 8) | buf[1]) : 0;
+        break;
+    case 0x26: // user property: two strings
+        size = (avail >= 2) ? 2 + ((buf[0] << 8) | buf[1]) : 0;
+        size = (size + 2 <= avail) ? size + 2 + ((buf[size] << 8) | buf[size+1]) : 0;
+        break;
+    default:
+        size = 0;
+        break;
+    }
+    return (size <= avail) ? size : 0;
+}
+
+// Picks up the limits the broker announced in its CONNACK
+void PubSubClient::readConnackProperties(uint32_t pos, uint32_t len) {
+    this->serverAliasMax = 0;
+    this->serverReceiveMax = 0xFFFF;
+    uint32_t plen;
+    uint8_t n = readVarInt(this->buffer + pos, len - pos, &plen);
+    if (n == 0 || pos + n + plen > len) {
+        return;
+    }
+    pos += n;
+    uint32_t end = pos + plen;
+    while (pos < end) {
+        uint8_t id = this->buffer[pos++];
+        uint32_t size = propertySize(id, this->buffer + pos, end - pos);
+        if (size == 0) {
+            return;
+        }
+        if (id == MQTT_PROP_TOPIC_ALIAS_MAX) {
+            this->serverAliasMax = (this->buffer[pos] << 8) | this->buffer[pos+1];
+        } else if (id == MQTT_PROP_RECEIVE_MAX) {
+            this->serverReceiveMax = (this->buffer[pos] << 8) | this->buffer[pos+1];
+        }
+        pos += size;
+    }
+}
+
+// Alias slot for topic, or -1 if it gets none (short topic, table full or
+// aliases not allowed by the broker). A topic keeps its slot, and so its
+// alias number, for the lifetime of the client
+int8_t PubSubClient::topicAlias(const char* topic, size_t tlen) {
+    if (tlen <= 3) {
+        return -1; // the alias property would be as long as the topic
+    }
+    int8_t empty = -1;
+    for (uint8_t i = 0; i < MQTT_MAX_TOPIC_ALIASES && i < this->serverAliasMax; i++) {
+        if (this->aliases[i].topic == NULL) {
+            if (empty < 0) {
+                empty = i;
+            }
+        } else if (strcmp(this->aliases[i].topic, topic) == 0) {
+            return i;
         }
+    }
+    if (empty >= 0) {
+        char* copy = (char*)this->allocFn(tlen + 1);
+        if (copy == NULL) {
+            return -1;
+        }
+        memcpy(copy, topic, tlen + 1);
+        this->aliases[empty].topic = copy;
+        this->aliases[empty].established = false;
+    }
+    return empty;
+}
+
+PubSubClient& PubSubClient::setUserProperty(const char* name, const char* value) {
+    this->userPropName = name;
+    this->userPropValue = value;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setSessionExpiry(uint32_t seconds) {
+    this->sessionExpiry = seconds;
+    return *this;
+}
+#endif
+
+boolean PubSubClient::connectAsync(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
+    if (this->asyncPhase != MQTT_ASYNC_IDLE || connected()) {
+        return true;
+    }
+    if (this->backoffCurrent != 0 && (long)(millis() - this->backoffUntil) < 0) {
         return false;
     }
+    this->asyncId = id;
+    this->asyncUser = user;
+    this->asyncPass = pass;
+    this->asyncWillTopic = willTopic;
+    this->asyncWillQos = willQos;
+    this->asyncWillRetain = willRetain;
+    this->asyncWillMessage = willMessage;
+    this->asyncCleanSession = cleanSession;
+    this->asyncAbort = false;
+    _state = MQTT_CONNECT_PENDING;
+
+    if (_client->connected()) {
+        this->transportResult = 1;
+        this->asyncPhase = MQTT_ASYNC_TRANSPORT;
+        return true;
+    }
+#if defined(ESP32)
+    // The transport connect (DNS, TCP and the whole TLS handshake) blocks,
+    // so it runs in a task of its own; nothing else touches _client until
+    // it finishes. It stays on the caller's core, so the handshake never
+    // competes with the tasks pinned to the other one
+    this->transportResult = MQTT_TRANSPORT_PENDING;
+    this->asyncPhase = MQTT_ASYNC_TRANSPORT;
+    if (xTaskCreatePinnedToCore(transportTask, "mqttconn", MQTT_CONNECT_TASK_STACK, this, uxTaskPriorityGet(NULL), NULL,
+                                xPortGetCoreID()) != pdPASS) {
+        this->asyncPhase = MQTT_ASYNC_IDLE;
+        _state = MQTT_CONNECT_FAILED;
+        connectFailed();
+        return false;
+    }
+#else
+    this->transportResult = (domain != NULL) ? _client->connect(this->domain, this->port)
+                                             : _client->connect(this->ip, this->port);
+    this->asyncPhase = MQTT_ASYNC_TRANSPORT;
+#endif
     return true;
 }
 
+#if defined(ESP32)
+void PubSubClient::transportTask(void* arg) {
+    PubSubClient* self = (PubSubClient*)arg;
+    int result = (self->domain != NULL) ? self->_client->connect(self->domain, self->port)
+                                        : self->_client->connect(self->ip, self->port);
+    self->transportResult = result;
+    vTaskDelete(NULL);
+}
+#endif
+
+void PubSubClient::pollConnect() {
+    if (this->asyncPhase == MQTT_ASYNC_TRANSPORT) {
+        int result = this->transportResult;
+        if (result == MQTT_TRANSPORT_PENDING) {
+            return;
+        }
+        if (this->asyncAbort) {
+            _client->stop();
+            this->asyncPhase = MQTT_ASYNC_IDLE;
+            _state = MQTT_DISCONNECTED;
+            return;
+        }
+        if (result != 1) {
+            this->asyncPhase = MQTT_ASYNC_IDLE;
+            _state = MQTT_CONNECT_FAILED;
+            connectFailed();
+            return;
+        }
+        if (!sendConnect(this->asyncId,this->asyncUser,this->asyncPass,this->asyncWillTopic,this->asyncWillQos,
+                         this->asyncWillRetain,this->asyncWillMessage,this->asyncCleanSession)) {
+            this->asyncPhase = MQTT_ASYNC_IDLE;
+            _state = MQTT_CONNECT_FAILED;
+            connectFailed();
+            return;
+        }
+        this->asyncPhase = MQTT_ASYNC_CONNACK;
+    }
+    if (this->asyncPhase == MQTT_ASYNC_CONNACK) {
+        if (!_client->available()) {
+            if (millis()-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
+                this->asyncPhase = MQTT_ASYNC_IDLE;
+                _state = MQTT_CONNECTION_TIMEOUT;
+                _client->stop();
+                connectFailed();
+            }
+            return;
+        }
+        this->asyncPhase = MQTT_ASYNC_IDLE;
+        if (readConnack()) {
+            this->backoffCurrent = 0;
+        } else {
+            connectFailed();
+        }
+    }
+}
+
+// Schedules the next connectAsync(): the delay doubles per failed attempt
+// up to backoffMax, and a random half of it is taken off so that many
+// devices that lost the broker together do not retry in lockstep
+void PubSubClient::connectFailed() {
+    if (this->backoffCurrent == 0) {
+        this->backoffCurrent = this->backoffMin;
+    } else if (this->backoffCurrent < this->backoffMax / 2) {
+        this->backoffCurrent *= 2;
+    } else {
+        this->backoffCurrent = this->backoffMax;
+    }
+    uint32_t delayMs = this->backoffCurrent / 2 + random(this->backoffCurrent / 2 + 1);
+    this->backoffUntil = millis() + delayMs;
+}
+
+boolean PubSubClient::connecting() {
+    return this->asyncPhase != MQTT_ASYNC_IDLE;
+}
+
+unsigned long PubSubClient::connectRetryIn() {
+    if (this->asyncPhase != MQTT_ASYNC_IDLE || this->backoffCurrent == 0) {
+        return 0;
+    }
+    long left = (long)(this->backoffUntil - millis());
+    return left > 0 ? left : 0;
+}
+
+PubSubClient& PubSubClient::setBackoff(uint32_t minMs, uint32_t maxMs) {
+    this->backoffMin = minMs ? minMs : 1;
+    this->backoffMax = (maxMs > this->backoffMin) ? maxMs : this->backoffMin;
+    return *this;
+}
+
 // reads a byte into result
 boolean PubSubClient::readByte(uint8_t * result) {
    uint32_t previousMillis = millis();
@@ -309,6 +626,30 @@ boolean PubSubClient::readByte(uint8_t * result, uint16_t * index){
   return false;
 }
 
+// reads count bytes into result, as many per client read as are available
+boolean PubSubClient::readBytes(uint8_t * result, uint32_t count) {
+   uint32_t previousMillis = millis();
+   while (count > 0) {
+     int avail = _client->available();
+     if (avail <= 0) {
+       yield();
+       uint32_t currentMillis = millis();
+       if(currentMillis - previousMillis >= ((int32_t) this->socketTimeout * 1000)){
+         return false;
+       }
+       continue;
+     }
+     int n = _client->read(result, (uint32_t)avail < count ? (size_t)avail : (size_t)count);
+     if (n <= 0) {
+       return false;
+     }
+     result += n;
+     count -= n;
+     previousMillis = millis();
+   }
+   return true;
+}
+
 uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
     uint16_t len = 0;
     if(!readByte(this->buffer, &len)) return 0;
@@ -333,6 +674,21 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
     } while ((digit & 128) != 0);
     *lengthLength = len-1;
 
+    if (!this->stream) {
+        if (isPublish && this->publishChunk && length > (uint32_t)(this->bufferSize - len)) {
+            return readChunkedPublish(this->buffer[0], length);
+        }
+        // Bulk-read whatever fits in the buffer; an oversized packet is
+        // drained and ignored
+        uint32_t fit = this->bufferSize - len;
+        if (fit > length) {
+            fit = length;
+        }
+        if (!readBytes(this->buffer + len, fit)) return 0;
+        if (!skipBytes(length - fit)) return 0;
+        return (fit == length) ? len + length : 0;
+    }
+
     if (isPublish) {
         // Read in topic length to calculate bytes to skip over for Stream writing
         if(!readByte(this->buffer, &len)) return 0;
@@ -361,13 +717,107 @@ uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
         idx++;
     }
 
-    if (!this->stream && idx > this->bufferSize) {
-        len = 0; // This will cause the packet to be ignored.
-    }
     return len;
 }
 
+// reads and discards count bytes
+boolean PubSubClient::skipBytes(uint32_t count) {
+    while (count > 0) {
+        uint8_t scratch[32];
+        uint32_t n = count < sizeof(scratch) ? count : sizeof(scratch);
+        if (!readBytes(scratch, n)) return false;
+        count -= n;
+    }
+    return true;
+}
+
+// Hands a PUBLISH too large for the buffer to the chunk callbacks; length
+// is what follows the fixed header, and only the topic has to fit. The
+// payload is read in buffer-sized pieces. A QoS 1 delivery is acknowledged
+// here, so nothing is left for loop(): returns 0
+uint32_t PubSubClient::readChunkedPublish(uint8_t header, uint32_t length) {
+    uint32_t left = length;
+    uint16_t tl = 0;
+    if (left >= 2) {
+        if (!readBytes(this->buffer, 2)) return 0;
+        tl = (this->buffer[0]<<8)+this->buffer[1];
+        left -= 2;
+    }
+    uint8_t idLen = (header & 0x06) ? 2 : 0;
+    if (length < 2 || (uint32_t)tl + idLen > left || tl >= this->bufferSize) {
+        skipBytes(left);
+        return 0;
+    }
+    if (!readBytes(this->buffer, tl)) return 0;
+    this->buffer[tl] = 0;
+    left -= tl;
+    uint16_t msgId = 0;
+    if (idLen) {
+        uint8_t id[2];
+        if (!readBytes(id, 2)) return 0;
+        msgId = (id[0]<<8)+id[1];
+        left -= 2;
+    }
+#if MQTT_VERSION == MQTT_VERSION_5
+    // Properties are skipped, as for messages that fit
+    uint32_t plen = 0;
+    uint8_t shift = 0;
+    uint8_t digit = 0;
+    do {
+        if (left == 0 || shift > 21 || !readByte(&digit)) {
+            _state = MQTT_DISCONNECTED;
+            _client->stop();
+            return 0;
+        }
+        left--;
+        plen |= (uint32_t)(digit & 127) << shift;
+        shift += 7;
+    } while ((digit & 128) != 0);
+    if (plen > left) {
+        skipBytes(left);
+        return 0;
+    }
+    if (!skipBytes(plen)) return 0;
+    left -= plen;
+#endif
+
+    boolean wanted = this->publishBegin ? this->publishBegin((const char*)this->buffer, left) : true;
+    while (left > 0) {
+        uint32_t n = left < this->bufferSize ? left : this->bufferSize;
+        if (!readBytes(this->buffer, n)) {
+            // The rest of the packet is still on its way: resync by reconnecting
+            if (wanted && this->publishEnd) {
+                this->publishEnd(false);
+            }
+            _state = MQTT_CONNECTION_LOST;
+            _client->stop();
+            return 0;
+        }
+        if (wanted) {
+            this->publishChunk(this->buffer, n);
+        }
+        left -= n;
+    }
+    if (wanted && this->publishEnd) {
+        this->publishEnd(true);
+    }
+    unsigned long t = millis();
+    lastInActivity = t;
+    if (msgId && (header & 0x06) == MQTTQOS1) {
+        this->buffer[0] = MQTTPUBACK;
+        this->buffer[1] = 2;
+        this->buffer[2] = (msgId >> 8);
+        this->buffer[3] = (msgId & 0xFF);
+        _client->write(this->buffer,4);
+        lastOutActivity = t;
+    }
+    return 0;
+}
+
 boolean PubSubClient::loop() {
+    if (this->asyncPhase != MQTT_ASYNC_IDLE) {
+        pollConnect();
+    }
     if (connected()) {
         unsigned long t = millis();
         if ((t - lastInActivity > this->keepAlive*1000UL) || (t - lastOutActivity > this->keepAlive*1000UL)) {
@@ -384,6 +834,11 @@ boolean PubSubClient::loop() {
                 pingOutstanding = true;
             }
         }
+        for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+            if (this->inflight[i].data && t - this->inflight[i].sentAt >= this->retryTimeout) {
+                sendInflight(i, true);
+            }
+        }
         if (_client->available()) {
             uint8_t llen;
             uint16_t len = readPacket(&llen);
@@ -398,11 +853,25 @@ boolean PubSubClient::loop() {
                         memmove(this->buffer+llen+2,this->buffer+llen+3,tl); /* move topic inside buffer 1 byte to front */
                         this->buffer[llen+2+tl] = 0; /* end the topic as a 'C' string with \x00 */
                         char *topic = (char*) this->buffer+llen+2;
+                        uint32_t pos = llen+3+tl;
                         // msgId only present for QOS>0
                         if ((this->buffer[0]&0x06) == MQTTQOS1) {
-                            msgId = (this->buffer[llen+3+tl]<<8)+this->buffer[llen+3+tl+1];
-                            payload = this->buffer+llen+3+tl+2;
-                            callback(topic,payload,len-llen-3-tl-2);
+                            msgId = (this->buffer[pos]<<8)+this->buffer[pos+1];
+                            pos += 2;
+                        }
+#if MQTT_VERSION == MQTT_VERSION_5
+                        // Properties are skipped; without a Topic Alias
+                        // Maximum in CONNECT the broker sends full topics
+                        uint32_t plen;
+                        uint8_t n = readVarInt(this->buffer+pos, len-pos, &plen);
+                        if (n == 0 || pos+n+plen > len) {
+                            return true;
+                        }
+                        pos += n+plen;
+#endif
+                        payload = this->buffer+pos;
+                        callback(topic,payload,len-pos);
+                        if (msgId) {
 
                             this->buffer[0] = MQTTPUBACK;
                             this->buffer[1] = 2;
@@ -410,10 +879,6 @@ boolean PubSubClient::loop() {
                             this->buffer[3] = (msgId & 0xFF);
                             _client->write(this->buffer,4);
                             lastOutActivity = t;
-
-                        } else {
-                            payload = this->buffer+llen+3+tl;
-                            callback(topic,payload,len-llen-3-tl);
                         }
                     }
                 } else if (type == MQTTPINGREQ) {
@@ -422,6 +887,8 @@ boolean PubSubClient::loop() {
                     _client->write(this->buffer,2);
                 } else if (type == MQTTPINGRESP) {
                     pingOutstanding = false;
+                } else if (type == MQTTPUBACK && len >= llen+3) {
+                    handlePuback((this->buffer[llen+1]<<8)+this->buffer[llen+2]);
                 }
             } else if (!connected()) {
                 // readPacket has closed the connection
@@ -434,11 +901,11 @@ boolean PubSubClient::loop() {
 }
 
 boolean PubSubClient::publish(const char* topic, const char* payload) {
-    return publish(topic,(const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0,false);
+    return publish(topic,(const uint8_t*)payload, payload ? strlen(payload) : 0,false);
 }
 
 boolean PubSubClient::publish(const char* topic, const char* payload, boolean retained) {
-    return publish(topic,(const uint8_t*)payload, payload ? strnlen(payload, this->bufferSize) : 0,retained);
+    return publish(topic,(const uint8_t*)payload, payload ? strlen(payload) : 0,retained);
 }
 
 boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength) {
@@ -447,28 +914,86 @@ boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigne
 
 boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
     if (connected()) {
-        if (this->bufferSize < MQTT_MAX_HEADER_SIZE + 2+strnlen(topic, this->bufferSize) + plength) {
-            // Too long
-            return false;
-        }
-        // Leave room in the buffer for header and variable length field
-        uint16_t length = MQTT_MAX_HEADER_SIZE;
-        length = writeString(topic,this->buffer,length);
+        return sendPublish(MQTTPUBLISH | (retained ? 1 : 0), topic, 0, payload, plength);
+    }
+    return false;
+}
 
-        // Add payload
-        uint16_t i;
-        for (i=0;i<plength;i++) {
-            this->buffer[length++] = payload[i];
-        }
+boolean PubSubClient::sendPublish(uint8_t header, const char* topic, uint16_t msgId, const uint8_t* payload, uint32_t plength) {
+    // Leave room in the buffer for header and variable length field
+    uint16_t length = writeTopic(topic, msgId, this->buffer, MQTT_MAX_HEADER_SIZE);
+    if (length == 0) {
+        // Topic too long
+        return false;
+    }
+    if (plength < MQTT_GATHER_MIN && length + plength <= this->bufferSize) {
+        // Small payload: one packet, one client write
+        memcpy(this->buffer+length, payload, plength);
+        return write(header,this->buffer,length+plength-MQTT_MAX_HEADER_SIZE);
+    }
+    // Header and topic from the buffer, payload straight from the caller
+    return write(header,this->buffer,length-MQTT_MAX_HEADER_SIZE,payload,plength);
+}
 
-        // Write the header
-        uint8_t header = MQTTPUBLISH;
-        if (retained) {
-            header |= 1;
-        }
-        return write(header,this->buffer,length-MQTT_MAX_HEADER_SIZE);
+// Writes the PUBLISH variable header (topic, packet id if msgId is not 0,
+// and with MQTT 5 the properties) at buf+pos. Returns the end position, or 0
+// if it does not fit in the buffer. With buf NULL nothing is written or
+// recorded and the size is that of the longest form
+uint16_t PubSubClient::writeTopic(const char* topic, uint16_t msgId, uint8_t* buf, uint16_t pos) {
+    size_t tlen = strnlen(topic, this->bufferSize);
+    size_t fieldLen = tlen;
+    uint32_t end = pos + 2 + tlen + (msgId ? 2 : 0);
+#if MQTT_VERSION == MQTT_VERSION_5
+    int8_t alias = (buf != NULL) ? topicAlias(topic, tlen) : -1;
+    if (alias >= 0 && this->aliases[alias].established) {
+        // The broker maps the alias to the topic: send an empty one
+        fieldLen = 0;
+        end -= tlen;
     }
-    return false;
+    uint32_t plen = 0;
+    if (alias >= 0 || buf == NULL) {
+        plen += 3;
+    }
+    if (this->userPropName && this->userPropValue) {
+        plen += 5 + strlen(this->userPropName) + strlen(this->userPropValue);
+    }
+    end += (plen < 128) ? 1 : 2;
+    end += plen;
+#endif
+    if (end > this->bufferSize) {
+        return 0;
+    }
+    if (buf == NULL) {
+        return end;
+    }
+    buf[pos++] = (fieldLen >> 8);
+    buf[pos++] = (fieldLen & 0xFF);
+    memcpy(buf+pos, topic, fieldLen);
+    pos += fieldLen;
+    if (msgId) {
+        buf[pos++] = (msgId >> 8);
+        buf[pos++] = (msgId & 0xFF);
+    }
+#if MQTT_VERSION == MQTT_VERSION_5
+    if (plen < 128) {
+        buf[pos++] = plen;
+    } else {
+        buf[pos++] = (plen & 127) | 128;
+        buf[pos++] = (plen >> 7);
+    }
+    if (alias >= 0) {
+        buf[pos++] = MQTT_PROP_TOPIC_ALIAS;
+        buf[pos++] = 0;
+        buf[pos++] = alias + 1;
+        this->aliases[alias].established = true;
+    }
+    if (this->userPropName && this->userPropValue) {
+        buf[pos++] = MQTT_PROP_USER_PROPERTY;
+        pos = writeString(this->userPropName, buf, pos);
+        pos = writeString(this->userPropValue, buf, pos);
+    }
+#endif
+    return pos;
 }
 
 boolean PubSubClient::publish_P(const char* topic, const char* payload, boolean retained) {
@@ -476,41 +1001,27 @@ boolean PubSubClient::publish_P(const char* topic, const char* payload, boolean
 }
 
 boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
-    uint8_t llen = 0;
-    uint8_t digit;
     unsigned int rc = 0;
-    uint16_t tlen;
-    unsigned int pos = 0;
     unsigned int i;
     uint8_t header;
-    unsigned int len;
-    int expectedLength;
 
     if (!connected()) {
         return false;
     }
 
-    tlen = strnlen(topic, this->bufferSize);
+    uint16_t length = writeTopic(topic, 0, this->buffer, MQTT_MAX_HEADER_SIZE);
+    if (length == 0) {
+        return false;
+    }
 
     header = MQTTPUBLISH;
     if (retained) {
         header |= 1;
     }
-    this->buffer[pos++] = header;
-    len = plength + 2 + tlen;
-    do {
-        digit = len  & 127; //digit = len %128
-        len >>= 7; //len = len / 128
-        if (len > 0) {
-            digit |= 0x80;
-        }
-        this->buffer[pos++] = digit;
-        llen++;
-    } while(len>0);
+    size_t hlen = buildHeader(header, this->buffer, length-MQTT_MAX_HEADER_SIZE+plength);
+    unsigned int pos = length-(MQTT_MAX_HEADER_SIZE-hlen);
 
-    pos = writeString(topic,this->buffer,pos);
-
-    rc += _client->write(this->buffer,pos);
+    rc += _client->write(this->buffer+(MQTT_MAX_HEADER_SIZE-hlen),pos);
 
     for (i=0;i<plength;i++) {
         rc += _client->write((char)pgm_read_byte_near(payload + i));
@@ -518,21 +1029,28 @@ boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsig
 
     lastOutActivity = millis();
 
-    expectedLength = 1 + llen + 2 + tlen + plength;
-
-    return (rc == expectedLength);
+    return (rc == pos + plength);
 }
 
 boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, boolean retained) {
     if (connected()) {
         // Send the header and variable length field
-        uint16_t length = MQTT_MAX_HEADER_SIZE;
-        length = writeString(topic,this->buffer,length);
+        uint16_t length = writeTopic(topic, 0, this->buffer, MQTT_MAX_HEADER_SIZE);
+        if (length == 0) {
+            return false;
+        }
         uint8_t header = MQTTPUBLISH;
         if (retained) {
             header |= 1;
         }
         size_t hlen = buildHeader(header, this->buffer, plength+length-MQTT_MAX_HEADER_SIZE);
+        if (this->combineBuf) {
+            // Header and payload are collected and go out in full buffers
+            this->streaming = true;
+            this->streamOk = true;
+            this->combineLen = 0;
+            return combine(this->buffer+(MQTT_MAX_HEADER_SIZE-hlen),length-(MQTT_MAX_HEADER_SIZE-hlen)) != 0;
+        }
         uint16_t rc = _client->write(this->buffer+(MQTT_MAX_HEADER_SIZE-hlen),length-(MQTT_MAX_HEADER_SIZE-hlen));
         lastOutActivity = millis();
         return (rc == (length-(MQTT_MAX_HEADER_SIZE-hlen)));
@@ -540,26 +1058,195 @@ boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, bool
     return false;
 }
 
+uint16_t PubSubClient::publishQos1(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
+    uint8_t window = this->inflightWindow;
+#if MQTT_VERSION == MQTT_VERSION_5
+    if (this->serverReceiveMax < window) {
+        window = this->serverReceiveMax;
+    }
+#endif
+    if (!connected() || this->inflightCount >= window) {
+        return 0;
+    }
+    if (writeTopic(topic, 1, NULL, MQTT_MAX_HEADER_SIZE) == 0) {
+        // Topic too long
+        return 0;
+    }
+    uint8_t slot = 0;
+    while (this->inflight[slot].data) {
+        slot++;
+    }
+
+    // The topic and payload are kept rather than the encoded packet: after a
+    // reconnect the topic must go out in full again (MQTT 5 aliases reset)
+    size_t tlen = strlen(topic);
+    uint8_t* data = (uint8_t*)this->allocFn(tlen + 1 + plength);
+    if (data == NULL) {
+        return 0;
+    }
+    memcpy(data, topic, tlen + 1);
+    memcpy(data + tlen + 1, payload, plength);
+
+    Inflight& m = this->inflight[slot];
+    m.data = data;
+    m.plength = plength;
+    m.msgId = allocMsgId();
+    m.retained = retained;
+    this->inflightCount++;
+    // A failed write is retried like a lost PUBACK
+    sendInflight(slot, false);
+    return m.msgId;
+}
+
+boolean PubSubClient::sendInflight(uint8_t slot, boolean dup) {
+    Inflight& m = this->inflight[slot];
+    m.sentAt = millis();
+    const char* topic = (const char*)m.data;
+    uint8_t header = MQTTPUBLISH | MQTTQOS1 | (m.retained ? 1 : 0) | (dup ? MQTTDUP : 0);
+    return sendPublish(header, topic, m.msgId, m.data + strlen(topic) + 1, m.plength);
+}
+
+void PubSubClient::handlePuback(uint16_t msgId) {
+    for (uint8_t i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+        if (this->inflight[i].data && this->inflight[i].msgId == msgId) {
+            this->freeFn(this->inflight[i].data);
+            this->inflight[i].data = NULL;
+            this->inflightCount--;
+            if (pubackCallback) {
+                pubackCallback(msgId);
+            }
+            return;
+        }
+    }
+}
+
+// Next packet id, skipping 0 and any id still awaiting a PUBACK
+uint16_t PubSubClient::allocMsgId() {
+    for (;;) {
+        nextMsgId++;
+        if (nextMsgId == 0) {
+            nextMsgId = 1;
+        }
+        uint8_t i = 0;
+        while (i < MQTT_MAX_INFLIGHT && !(this->inflight[i].data && this->inflight[i].msgId == nextMsgId)) {
+            i++;
+        }
+        if (i == MQTT_MAX_INFLIGHT) {
+            return nextMsgId;
+        }
+    }
+}
+
 int PubSubClient::endPublish() {
- return 1;
+    if (this->streaming) {
+        this->streaming = false;
+        boolean ok = flushCombined();
+        return (ok && this->streamOk) ? 1 : 0;
+    }
+    return 1;
 }
 
 size_t PubSubClient::write(uint8_t data) {
+    if (this->streaming) {
+        return combine(&data, 1);
+    }
     lastOutActivity = millis();
     return _client->write(data);
 }
 
 size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
+    if (this->streaming) {
+        return combine(buffer, size);
+    }
     lastOutActivity = millis();
     return _client->write(buffer,size);
 }
 
-size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint16_t length) {
+boolean PubSubClient::setWriteBufferSize(uint16_t size) {
+    if (!this->ownsCombine) {
+        this->combineBuf = NULL;
+        this->ownsCombine = true;
+    }
+    if (size == 0) {
+        free(this->combineBuf);
+        this->combineBuf = NULL;
+        this->combineSize = 0;
+        return true;
+    }
+    uint8_t* newBuffer = (uint8_t*)realloc(this->combineBuf, size);
+    if (newBuffer == NULL) {
+        return false;
+    }
+    this->combineBuf = newBuffer;
+    this->combineSize = size;
+    this->combineLen = 0;
+    return true;
+}
+
+// Appends to the write-combining buffer, sending it each time it fills. A
+// block at least as large as the buffer that has nothing to join goes out
+// as is. Returns size, or 0 once a client write failed
+size_t PubSubClient::combine(const uint8_t* data, size_t size) {
+    size_t total = size;
+    while (size > 0) {
+        if (this->combineLen == 0 && size >= this->combineSize) {
+            if (!writeClient(data, size)) {
+                this->streamOk = false;
+                return 0;
+            }
+            return total;
+        }
+        size_t n = this->combineSize - this->combineLen;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(this->combineBuf + this->combineLen, data, n);
+        this->combineLen += n;
+        data += n;
+        size -= n;
+        if (this->combineLen == this->combineSize && !flushCombined()) {
+            return 0;
+        }
+    }
+    return total;
+}
+
+boolean PubSubClient::flushCombined() {
+    if (this->combineLen == 0) {
+        return true;
+    }
+    boolean ok = writeClient(this->combineBuf, this->combineLen);
+    this->combineLen = 0;
+    if (!ok) {
+        this->streamOk = false;
+    }
+    return ok;
+}
+
+boolean PubSubClient::writeClient(const uint8_t* data, size_t size) {
+    lastOutActivity = millis();
+    while (size > 0) {
+#ifdef MQTT_MAX_TRANSFER_SIZE
+        size_t bytesToWrite = (size > MQTT_MAX_TRANSFER_SIZE)?MQTT_MAX_TRANSFER_SIZE:size;
+#else
+        size_t bytesToWrite = size;
+#endif
+        size_t n = _client->write(data,bytesToWrite);
+        if (n != bytesToWrite) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint32_t length) {
     uint8_t lenBuf[4];
     uint8_t llen = 0;
     uint8_t digit;
     uint8_t pos = 0;
-    uint16_t len = length;
+    uint32_t len = length;
     do {
 
         digit = len  & 127; //digit = len %128
@@ -602,33 +1289,74 @@ boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
 #endif
 }
 
+boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length, const uint8_t* payload, uint32_t plength) {
+    uint8_t hlen = buildHeader(header, buf, length+plength);
+    if (this->combineBuf && !this->streaming) {
+        // Header and the start of the payload share the first write
+        this->streamOk = true;
+        this->combineLen = 0;
+        combine(buf+(MQTT_MAX_HEADER_SIZE-hlen),length+hlen);
+        combine(payload,plength);
+        return flushCombined() && this->streamOk;
+    }
+    uint16_t rc = _client->write(buf+(MQTT_MAX_HEADER_SIZE-hlen),length+hlen);
+    boolean result = (rc == hlen+length);
+    while (result && plength > 0) {
+#ifdef MQTT_MAX_TRANSFER_SIZE
+        uint32_t bytesToWrite = (plength > MQTT_MAX_TRANSFER_SIZE)?MQTT_MAX_TRANSFER_SIZE:plength;
+#else
+        uint32_t bytesToWrite = plength;
+#endif
+        size_t n = _client->write(payload,bytesToWrite);
+        result = (n == bytesToWrite);
+        payload += n;
+        plength -= n;
+    }
+    lastOutActivity = millis();
+    return result;
+}
+
 boolean PubSubClient::subscribe(const char* topic) {
     return subscribe(topic, 0);
 }
 
 boolean PubSubClient::subscribe(const char* topic, uint8_t qos) {
-    size_t topicLength = strnlen(topic, this->bufferSize);
     if (topic == 0) {
         return false;
     }
-    if (qos > 1) {
-        return false;
+    return subscribe(&topic, &qos, 1);
+}
+
+boolean PubSubClient::subscribe(const char* const topics[], const uint8_t qos[], uint8_t count) {
+    // Header, packet id (and v5 properties), then per filter the string and
+    // its options byte
+    uint32_t need = MQTT_MAX_HEADER_SIZE + 2;
+#if MQTT_VERSION == MQTT_VERSION_5
+    need++;
+#endif
+    for (uint8_t i = 0; i < count; i++) {
+        if (topics[i] == 0 || (qos && qos[i] > 1)) {
+            return false;
+        }
+        need += 2 + strnlen(topics[i], this->bufferSize) + 1;
     }
-    if (this->bufferSize < 9 + topicLength) {
+    if (count == 0 || need > this->bufferSize) {
         // Too long
         return false;
     }
     if (connected()) {
         // Leave room in the buffer for header and variable length field
         uint16_t length = MQTT_MAX_HEADER_SIZE;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
+        uint16_t msgId = allocMsgId();
+        this->buffer[length++] = (msgId >> 8);
+        this->buffer[length++] = (msgId & 0xFF);
+#if MQTT_VERSION == MQTT_VERSION_5
+        this->buffer[length++] = 0; // no properties
+#endif
+        for (uint8_t i = 0; i < count; i++) {
+            length = writeString(topics[i], this->buffer,length);
+            this->buffer[length++] = qos ? qos[i] : 0;
         }
-        this->buffer[length++] = (nextMsgId >> 8);
-        this->buffer[length++] = (nextMsgId & 0xFF);
-        length = writeString((char*)topic, this->buffer,length);
-        this->buffer[length++] = qos;
         return write(MQTTSUBSCRIBE|MQTTQOS1,this->buffer,length-MQTT_MAX_HEADER_SIZE);
     }
     return false;
@@ -639,18 +1367,18 @@ boolean PubSubClient::unsubscribe(const char* topic) {
     if (topic == 0) {
         return false;
     }
-    if (this->bufferSize < 9 + topicLength) {
+    if (this->bufferSize < 10 + topicLength) {
         // Too long
         return false;
     }
     if (connected()) {
         uint16_t length = MQTT_MAX_HEADER_SIZE;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
-        this->buffer[length++] = (nextMsgId >> 8);
-        this->buffer[length++] = (nextMsgId & 0xFF);
+        uint16_t msgId = allocMsgId();
+        this->buffer[length++] = (msgId >> 8);
+        this->buffer[length++] = (msgId & 0xFF);
+#if MQTT_VERSION == MQTT_VERSION_5
+        this->buffer[length++] = 0; // no properties
+#endif
         length = writeString(topic, this->buffer,length);
         return write(MQTTUNSUBSCRIBE|MQTTQOS1,this->buffer,length-MQTT_MAX_HEADER_SIZE);
     }
@@ -658,6 +1386,12 @@ boolean PubSubClient::unsubscribe(const char* topic) {
 }
 
 void PubSubClient::disconnect() {
+    if (this->asyncPhase == MQTT_ASYNC_TRANSPORT) {
+        // The transport task still owns the client: drop it when done
+        this->asyncAbort = true;
+        return;
+    }
+    this->asyncPhase = MQTT_ASYNC_IDLE;
     this->buffer[0] = MQTTDISCONNECT;
     this->buffer[1] = 0;
     _client->write(this->buffer,2);
@@ -683,6 +1417,10 @@ uint16_t PubSubClient::writeString(const char* string, uint8_t* buf, uint16_t po
 
 boolean PubSubClient::connected() {
     boolean rc;
+    if (this->asyncPhase != MQTT_ASYNC_IDLE) {
+        // connectAsync() still running; the client may belong to its task
+        return false;
+    }
     if (_client == NULL ) {
         rc = false;
     } else {
@@ -723,6 +1461,28 @@ PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
     return *this;
 }
 
+PubSubClient& PubSubClient::setChunkCallbacks(MQTT_PUBLISH_BEGIN_SIGNATURE, MQTT_PUBLISH_CHUNK_SIGNATURE, MQTT_PUBLISH_END_SIGNATURE) {
+    this->publishBegin = publishBegin;
+    this->publishChunk = publishChunk;
+    this->publishEnd = publishEnd;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setPubackCallback(MQTT_PUBACK_SIGNATURE) {
+    this->pubackCallback = pubackCallback;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setInflightWindow(uint8_t window, uint16_t retryTimeout) {
+    this->inflightWindow = (window > MQTT_MAX_INFLIGHT) ? MQTT_MAX_INFLIGHT : window;
+    this->retryTimeout = retryTimeout;
+    return *this;
+}
+
+uint8_t PubSubClient::inflightMessages() {
+    return this->inflightCount;
+}
+
 PubSubClient& PubSubClient::setClient(Client& client){
     this->_client = &client;
     return *this;
@@ -742,6 +1502,11 @@ boolean PubSubClient::setBufferSize(uint16_t size) {
         // Cannot set it back to 0
         return false;
     }
+    if (!this->ownsBuffer) {
+        this->buffer = NULL;
+        this->bufferSize = 0;
+        this->ownsBuffer = true;
+    }
     if (this->bufferSize == 0) {
         this->buffer = (uint8_t*)malloc(size);
     } else {
@@ -756,6 +1521,39 @@ boolean PubSubClient::setBufferSize(uint16_t size) {
     return (this->buffer != NULL);
 }
 
+boolean PubSubClient::setBuffer(uint8_t* buf, uint16_t size) {
+    if (buf == NULL || size == 0) {
+        return false;
+    }
+    if (this->ownsBuffer) {
+        free(this->buffer);
+    }
+    this->buffer = buf;
+    this->bufferSize = size;
+    this->ownsBuffer = false;
+    return true;
+}
+
+boolean PubSubClient::setWriteBuffer(uint8_t* buf, uint16_t size) {
+    if (buf == NULL || size == 0) {
+        return false;
+    }
+    if (this->ownsCombine) {
+        free(this->combineBuf);
+    }
+    this->combineBuf = buf;
+    this->combineSize = size;
+    this->combineLen = 0;
+    this->ownsCombine = false;
+    return true;
+}
+
+PubSubClient& PubSubClient::setAllocator(MqttAllocFn alloc, MqttFreeFn release) {
+    this->allocFn = alloc ? alloc : malloc;
+    this->freeFn = release ? release : free;
+    return *this;
+}
+
 uint16_t PubSubClient::getBufferSize() {
     return this->bufferSize;
 }
@@ -14,9 +14,12 @@
 
 #define MQTT_VERSION_3_1      3
 #define MQTT_VERSION_3_1_1    4
+#define MQTT_VERSION_5        5
 
 // MQTT_VERSION : Pick the version
 //#define MQTT_VERSION MQTT_VERSION_3_1
+// MQTT_VERSION_5 adds topic aliases, user properties and the session expiry
+// interval; setStream() is not supported with it
 #ifndef MQTT_VERSION
 #define MQTT_VERSION MQTT_VERSION_3_1_1
 #endif
@@ -36,12 +39,62 @@
 #define MQTT_SOCKET_TIMEOUT 15
 #endif
 
+// MQTT_GATHER_MIN : publish() payloads of at least this many bytes, or too
+//  large for the buffer, are written to the client straight from the caller's
+//  memory after the header and topic instead of being copied in. Smaller ones
+//  are copied so the packet goes out in a single write (one TLS record).
+//  setBufferSize() then only has to hold the topic, and inbound packets.
+#ifndef MQTT_GATHER_MIN
+#define MQTT_GATHER_MIN 128
+#endif
+
+// MQTT_MAX_INFLIGHT : most QoS 1 publishes that can await their PUBACK at
+//  once. Lower the window with setInflightWindow().
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 16
+#endif
+
+// MQTT_RETRY_TIMEOUT : milliseconds before an unacknowledged QoS 1 publish is
+//  sent again with DUP set. Override with setInflightWindow()
+#ifndef MQTT_RETRY_TIMEOUT
+#define MQTT_RETRY_TIMEOUT 10000
+#endif
+
+// MQTT_BACKOFF_MIN / MQTT_BACKOFF_MAX : milliseconds between connectAsync()
+//  attempts; doubles per failure, with jitter. Override with setBackoff()
+#ifndef MQTT_BACKOFF_MIN
+#define MQTT_BACKOFF_MIN 1000
+#endif
+#ifndef MQTT_BACKOFF_MAX
+#define MQTT_BACKOFF_MAX 60000
+#endif
+
+// MQTT_CONNECT_TASK_STACK : stack of the task that runs the transport connect
+//  (TLS handshake) for connectAsync() on ESP32
+#ifndef MQTT_CONNECT_TASK_STACK
+#define MQTT_CONNECT_TASK_STACK 8192
+#endif
+
+// MQTT_MAX_TOPIC_ALIASES : (MQTT 5) topics that get an alias, up to the
+//  broker's Topic Alias Maximum. After the first publish on a topic its
+//  packets carry a 2-byte alias instead of the topic string
+#ifndef MQTT_MAX_TOPIC_ALIASES
+#define MQTT_MAX_TOPIC_ALIASES 8
+#endif
+
+// MQTT_SESSION_EXPIRY : (MQTT 5) seconds the broker keeps the session of a
+//  cleanSession=false connect after it closes. Override with setSessionExpiry()
+#ifndef MQTT_SESSION_EXPIRY
+#define MQTT_SESSION_EXPIRY 86400
+#endif
+
 // MQTT_MAX_TRANSFER_SIZE : limit how much data is passed to the network client
 //  in each write call. Needed for the Arduino Wifi Shield. Leave undefined to
 //  pass the entire MQTT packet in each write call.
 //#define MQTT_MAX_TRANSFER_SIZE 80
 
 // Possible values for client.state()
+#define MQTT_CONNECT_PENDING        -5
 #define MQTT_CONNECTION_TIMEOUT     -4
 #define MQTT_CONNECTION_LOST        -3
 #define MQTT_CONNECT_FAILED         -2
@@ -52,6 +105,7 @@
 #define MQTT_CONNECT_UNAVAILABLE     3
 #define MQTT_CONNECT_BAD_CREDENTIALS 4
 #define MQTT_CONNECT_UNAUTHORIZED    5
+// (MQTT 5 reports its CONNACK reason code, 0x80 and up, instead)
 
 #define MQTTCONNECT     1 << 4  // Client request to connect to Server
 #define MQTTCONNACK     2 << 4  // Connect Acknowledgment
@@ -72,6 +126,14 @@
 #define MQTTQOS0        (0 << 1)
 #define MQTTQOS1        (1 << 1)
 #define MQTTQOS2        (2 << 1)
+#define MQTTDUP         (1 << 3)
+
+// MQTT 5 property identifiers
+#define MQTT_PROP_SESSION_EXPIRY  0x11
+#define MQTT_PROP_RECEIVE_MAX     0x21
+#define MQTT_PROP_TOPIC_ALIAS_MAX 0x22
+#define MQTT_PROP_TOPIC_ALIAS     0x23
+#define MQTT_PROP_USER_PROPERTY   0x26
 
 // Maximum size of fixed header and variable length size header
 #define MQTT_MAX_HEADER_SIZE 5
@@ -79,10 +141,23 @@
 #if defined(ESP8266) || defined(ESP32)
 #include <functional>
 #define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+#define MQTT_PUBACK_SIGNATURE std::function<void(uint16_t)> pubackCallback
+#define MQTT_PUBLISH_BEGIN_SIGNATURE std::function<boolean(const char*, uint32_t)> publishBegin
+#define MQTT_PUBLISH_CHUNK_SIGNATURE std::function<void(const uint8_t*, unsigned int)> publishChunk
+#define MQTT_PUBLISH_END_SIGNATURE std::function<void(boolean)> publishEnd
 #else
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+#define MQTT_PUBACK_SIGNATURE void (*pubackCallback)(uint16_t)
+#define MQTT_PUBLISH_BEGIN_SIGNATURE boolean (*publishBegin)(const char*, uint32_t)
+#define MQTT_PUBLISH_CHUNK_SIGNATURE void (*publishChunk)(const uint8_t*, unsigned int)
+#define MQTT_PUBLISH_END_SIGNATURE void (*publishEnd)(boolean)
 #endif
 
+// Where QoS 1 copies and MQTT 5 alias topics are allocated; malloc/free
+// unless setAllocator() installs e.g. a fixed-block pool
+typedef void* (*MqttAllocFn)(size_t size);
+typedef void (*MqttFreeFn)(void* ptr);
+
 #define CHECK_STRING_LENGTH(l,s) if (l+2+strnlen(s, this->bufferSize) > this->bufferSize) {_client->stop();return false;}
 
 class PubSubClient : public Print {
@@ -90,6 +165,9 @@ private:
    Client* _client;
    uint8_t* buffer;
    uint16_t bufferSize;
+   boolean ownsBuffer = true;   // false after setBuffer()
+   MqttAllocFn allocFn = malloc;
+   MqttFreeFn freeFn = free;
    uint16_t keepAlive;
    uint16_t socketTimeout;
    uint16_t nextMsgId;
@@ -97,16 +175,95 @@ private:
    unsigned long lastInActivity;
    bool pingOutstanding;
    MQTT_CALLBACK_SIGNATURE;
+   MQTT_PUBACK_SIGNATURE = NULL;
+   MQTT_PUBLISH_BEGIN_SIGNATURE = NULL;
+   MQTT_PUBLISH_CHUNK_SIGNATURE = NULL;
+   MQTT_PUBLISH_END_SIGNATURE = NULL;
+   // One QoS 1 publish awaiting its PUBACK, kept for retransmission:
+   // data holds the topic, its NUL, then the payload
+   struct Inflight {
+      uint8_t* data;
+      uint32_t plength;
+      uint16_t msgId;
+      boolean retained;
+      unsigned long sentAt;
+   };
+   Inflight inflight[MQTT_MAX_INFLIGHT] = {};
+   uint8_t inflightCount = 0;
+   uint8_t inflightWindow = MQTT_MAX_INFLIGHT;
+   uint16_t retryTimeout = MQTT_RETRY_TIMEOUT;
+   // connectAsync() progress
+   enum { MQTT_ASYNC_IDLE, MQTT_ASYNC_TRANSPORT, MQTT_ASYNC_CONNACK };
+   static const int MQTT_TRANSPORT_PENDING = -128;
+   uint8_t asyncPhase = MQTT_ASYNC_IDLE;
+   volatile int transportResult = 0;
+   volatile bool asyncAbort = false;
+   const char* asyncId;
+   const char* asyncUser;
+   const char* asyncPass;
+   const char* asyncWillTopic;
+   const char* asyncWillMessage;
+   uint8_t asyncWillQos;
+   boolean asyncWillRetain;
+   boolean asyncCleanSession;
+   boolean _sessionPresent = false;
+   uint32_t backoffMin = MQTT_BACKOFF_MIN;
+   uint32_t backoffMax = MQTT_BACKOFF_MAX;
+   uint32_t backoffCurrent = 0;
+   unsigned long backoffUntil = 0;
+   boolean sendConnect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   boolean readConnack();
+   void pollConnect();
+   void connectFailed();
+#if defined(ESP32)
+   static void transportTask(void* arg);
+#endif
+#if MQTT_VERSION == MQTT_VERSION_5
+   struct TopicAlias {
+      char* topic;          // alias number is the slot index + 1
+      boolean established;  // sent with its topic on this connection
+   };
+   TopicAlias aliases[MQTT_MAX_TOPIC_ALIASES] = {};
+   uint16_t serverAliasMax = 0;
+   uint16_t serverReceiveMax = 0xFFFF;
+   uint32_t sessionExpiry = MQTT_SESSION_EXPIRY;
+   const char* userPropName = NULL;
+   const char* userPropValue = NULL;
+   void readConnackProperties(uint32_t pos, uint32_t len);
+   int8_t topicAlias(const char* topic, size_t tlen);
+#endif
+   // Write combining for beginPublish()/write()/endPublish() and large
+   // publishes; NULL until setWriteBufferSize()
+   uint8_t* combineBuf = NULL;
+   boolean ownsCombine = true;  // false after setWriteBuffer()
+   uint16_t combineSize = 0;
+   uint16_t combineLen = 0;
+   boolean streaming = false;
+   boolean streamOk = true;
+   size_t combine(const uint8_t* data, size_t size);
+   boolean flushCombined();
+   boolean writeClient(const uint8_t* data, size_t size);
+   boolean sendPublish(uint8_t header, const char* topic, uint16_t msgId, const uint8_t* payload, uint32_t plength);
+   uint16_t writeTopic(const char* topic, uint16_t msgId, uint8_t* buf, uint16_t pos);
+   uint16_t allocMsgId();
+   boolean sendInflight(uint8_t slot, boolean dup);
+   void handlePuback(uint16_t msgId);
    uint32_t readPacket(uint8_t*);
+   uint32_t readChunkedPublish(uint8_t header, uint32_t length);
+   boolean skipBytes(uint32_t count);
    boolean readByte(uint8_t * result);
    boolean readByte(uint8_t * result, uint16_t * index);
+   boolean readBytes(uint8_t * result, uint32_t count);
    boolean write(uint8_t header, uint8_t* buf, uint16_t length);
+   // Sends the header and the first length bytes of buf, then the payload
+   // as is, without copying it into the buffer
+   boolean write(uint8_t header, uint8_t* buf, uint16_t length, const uint8_t* payload, uint32_t plength);
    uint16_t writeString(const char* string, uint8_t* buf, uint16_t pos);
    // Build up the header ready to send
    // Returns the size of the header
    // Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
    //       (MQTT_MAX_HEADER_SIZE - <returned size>) bytes into the buffer
-   size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+   size_t buildHeader(uint8_t header, uint8_t* buf, uint32_t length);
    IPAddress ip;
    const char* domain;
    uint16_t port;
@@ -134,6 +291,13 @@ public:
    PubSubClient& setServer(uint8_t * ip, uint16_t port);
    PubSubClient& setServer(const char * domain, uint16_t port);
    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+   // Inbound PUBLISH messages too large for the buffer are handed over in
+   // pieces instead of being dropped: onPublishBegin(topic, payload length)
+   // (false skips the message), onPublishChunk(data, len) per piece of at
+   // most the buffer size, then onPublishEnd(complete), where complete is
+   // false if the connection failed midway. The topic is valid during
+   // onPublishBegin only. Messages that fit still go to the callback
+   PubSubClient& setChunkCallbacks(MQTT_PUBLISH_BEGIN_SIGNATURE, MQTT_PUBLISH_CHUNK_SIGNATURE, MQTT_PUBLISH_END_SIGNATURE);
    PubSubClient& setClient(Client& client);
    PubSubClient& setStream(Stream& stream);
    PubSubClient& setKeepAlive(uint16_t keepAlive);
@@ -141,12 +305,43 @@ public:
 
    boolean setBufferSize(uint16_t size);
    uint16_t getBufferSize();
+   // Payload written between beginPublish() and endPublish(), and publish()
+   // payloads sent from the caller's memory, are collected into writes of
+   // this size (e.g. the TLS record size) instead of reaching the client as
+   // they come. 0 (default) passes every write straight through
+   boolean setWriteBufferSize(uint16_t size);
+   // The same two buffers in caller-owned memory (e.g. static arrays) that
+   // must outlive the client; nothing is allocated for them
+   boolean setBuffer(uint8_t* buf, uint16_t size);
+   boolean setWriteBuffer(uint8_t* buf, uint16_t size);
+   // Allocator for QoS 1 copies and alias topics. Set before the first
+   // publish: blocks already out are released with the allocator in place
+   PubSubClient& setAllocator(MqttAllocFn alloc, MqttFreeFn release);
 
    boolean connect(const char* id);
    boolean connect(const char* id, const char* user, const char* pass);
    boolean connect(const char* id, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   // Start connecting without blocking; loop() drives the attempt and
+   // connected() turns true once the CONNACK arrives. All strings must stay
+   // valid until then. After a failed attempt the next one is refused
+   // (false) until the jittered exponential backoff has passed. Returns true
+   // if an attempt is running or the client is already connected
+   boolean connectAsync(const char* id, const char* user = 0, const char* pass = 0, const char* willTopic = 0, uint8_t willQos = 0, boolean willRetain = 0, const char* willMessage = 0, boolean cleanSession = 1);
+   boolean connecting();
+   // Milliseconds until connectAsync() may try again (0 = now)
+   unsigned long connectRetryIn();
+   PubSubClient& setBackoff(uint32_t minMs, uint32_t maxMs);
+   // CONNACK of the last connect: the broker kept the session of a
+   // cleanSession=false client (its subscriptions are still in place)
+   boolean sessionPresent() { return this->_sessionPresent; }
+#if MQTT_VERSION == MQTT_VERSION_5
+   // Name/value pair sent as a user property with every PUBLISH (NULL to
+   // stop); both strings must stay valid
+   PubSubClient& setUserProperty(const char* name, const char* value);
+   PubSubClient& setSessionExpiry(uint32_t seconds);
+#endif
    void disconnect();
    boolean publish(const char* topic, const char* payload);
    boolean publish(const char* topic, const char* payload, boolean retained);
@@ -163,8 +358,21 @@ public:
    // a new buffer and held in memory at one time
    // Returns 1 if the message was started successfully, 0 if there was an error
    boolean beginPublish(const char* topic, unsigned int plength, boolean retained);
+   // Publish at QoS 1. The packet is kept until its PUBACK arrives and is
+   // sent again, with DUP set, after the retry timeout or a reconnect, so
+   // up to the in-flight window of messages can be outstanding at once.
+   // Returns the packet id (reported again by the PUBACK callback), or 0 if
+   // the message was not taken: not connected, window full or no memory
+   uint16_t publishQos1(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained = false);
+   // Called with the packet id of each QoS 1 publish the broker acknowledged
+   PubSubClient& setPubackCallback(MQTT_PUBACK_SIGNATURE);
+   // At most window (up to MQTT_MAX_INFLIGHT) unacknowledged QoS 1 publishes;
+   // each is resent after retryTimeout ms without a PUBACK
+   PubSubClient& setInflightWindow(uint8_t window, uint16_t retryTimeout = MQTT_RETRY_TIMEOUT);
+   uint8_t inflightMessages();
    // Finish off this publish message (started with beginPublish)
    // Returns 1 if the packet was sent successfully, 0 if there was an error
+   // (with a write buffer, the last part is only sent here)
    int endPublish();
    // Write a single byte of payload (only to be used with beginPublish/endPublish)
    virtual size_t write(uint8_t);
@@ -173,6 +381,8 @@ public:
    virtual size_t write(const uint8_t *buffer, size_t size);
    boolean subscribe(const char* topic);
    boolean subscribe(const char* topic, uint8_t qos);
+   // Several filters in one SUBSCRIBE packet; qos may be NULL for all 0
+   boolean subscribe(const char* const topics[], const uint8_t qos[], uint8_t count);
    boolean unsubscribe(const char* topic);
    boolean loop();
    boolean connected();
@@ -0,0 +1,203 @@
+// On-target micro-benchmarks for the firmware hot paths ([env:esp32dev_bench]).
+//
+// Each case runs BENCH_ITERATIONS times after a warm-up pass and is timed
+// with the CPU cycle counter. Results go to the serial port as one JSON
+// object per line, e.g.
+//   {"bench":"ina219_readAll","iters":200,"min":..,"median":..,"max":..,"median_us":..}
+// and a last {"bench":"done", ...} line, so a capture can be diffed or fed to
+// a script between builds. Cases whose hardware is missing are reported with
+// "skipped":true instead of numbers.
+#include <Arduino.h>
+#include <Wire.h>
+#include <PubSubClient.h>
+#include <Adafruit_INA219.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+#include "json_writer.h"
+#include "soc_ekf.h"
+
+// Same wiring as src/main.cpp
+static const int OLED_SDA_PIN = 21;
+static const int OLED_SCL_PIN = 22;
+static const int INA_SDA_PIN = 5;
+static const int INA_SCL_PIN = 4;
+static const uint8_t OLED_ADDRESS = 0x3C;
+static const uint8_t OLED_WIDTH = 128;
+static const uint8_t OLED_HEIGHT = 64;
+
+static const uint16_t BENCH_ITERATIONS = 200;
+
+TwoWire I2C_OLED = TwoWire(0);
+TwoWire I2C_INA = TwoWire(1);
+Adafruit_INA219 ina219;
+Adafruit_SSD1306 display(OLED_WIDTH, OLED_HEIGHT, &I2C_OLED, -1);
+
+// Accepts and drops everything: publish() is timed without the network.
+class NullClient : public Client {
+public:
+  int connect(IPAddress, uint16_t) override { return 1; }
+  int connect(const char*, uint16_t) override { return 1; }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t size) override { return size; }
+  int available() override { return _rx < sizeof(CONNACK) ? sizeof(CONNACK) - _rx : 0; }
+  int read() override { return _rx < sizeof(CONNACK) ? CONNACK[_rx++] : -1; }
+  int read(uint8_t* buf, size_t size) override {
+    size_t n = 0;
+    while (n < size && _rx < sizeof(CONNACK)) buf[n++] = CONNACK[_rx++];
+    return n ? (int)n : -1;
+  }
+  int peek() override { return _rx < sizeof(CONNACK) ? CONNACK[_rx] : -1; }
+  void flush() override {}
+  void stop() override {}
+  uint8_t connected() override { return 1; }
+  operator bool() override { return true; }
+
+private:
+  // The only thing the "broker" ever says: CONNACK, accepted (3.1.1 or 5)
+#if MQTT_VERSION == MQTT_VERSION_5
+  static constexpr uint8_t CONNACK[] = { 0x20, 3, 0, 0, 0 };
+#else
+  static constexpr uint8_t CONNACK[] = { 0x20, 2, 0, 0 };
+#endif
+  size_t _rx = 0;
+};
+constexpr uint8_t NullClient::CONNACK[];
+
+NullClient nullClient;
+PubSubClient mqtt(nullClient);
+
+static uint32_t samples[BENCH_ITERATIONS];
+
+static int compareU32(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+static void report(const char* name, bool ran) {
+  char line[160];
+  JsonWriter out(line, sizeof(line));
+  out.beginObject().field("bench", name);
+  if (!ran) {
+    out.field("skipped", true);
+  } else {
+    qsort(samples, BENCH_ITERATIONS, sizeof(samples[0]), compareU32);
+    uint32_t median = samples[BENCH_ITERATIONS / 2];
+    out.field("iters", (uint32_t)BENCH_ITERATIONS)
+        .field("min", samples[0])
+        .field("median", median)
+        .field("max", samples[BENCH_ITERATIONS - 1])
+        .field("median_us", (float)median / getCpuFrequencyMhz(), 2);
+  }
+  out.endObject();
+  Serial.println(line);
+}
+
+// Times body() BENCH_ITERATIONS times (plus one untimed warm-up call).
+template <typename F> static void bench(const char* name, F body) {
+  body();
+  for (uint16_t i = 0; i < BENCH_ITERATIONS; ++i) {
+    uint32_t start = ESP.getCycleCount();
+    body();
+    samples[i] = ESP.getCycleCount() - start;
+  }
+  report(name, true);
+}
+
+static uint8_t payload2k[2048];
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  I2C_OLED.begin(OLED_SDA_PIN, OLED_SCL_PIN, 400000);
+  I2C_INA.begin(INA_SDA_PIN, INA_SCL_PIN, 400000);
+  for (size_t i = 0; i < sizeof(payload2k); ++i) payload2k[i] = (uint8_t)i;
+
+  Serial.printf("{\"bench\":\"start\",\"cpu_mhz\":%u,\"sdk\":\"%s\"}\n", (unsigned)getCpuFrequencyMhz(),
+                ESP.getSdkVersion());
+
+  // INA219: one full sample (shunt, bus, current, power)
+  if (ina219.begin(&I2C_INA)) {
+    Ina219Sample s;
+    bench("ina219_readAll", [&] { ina219.readAll(s); });
+  } else {
+    report("ina219_readAll", false);
+  }
+
+  // SSD1306: full frame, then a refresh with one 8x8 area changed
+  if (display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
+    uint8_t frame = 0;
+    bench("ssd1306_display_full", [&] {
+      display.fillScreen((frame++ & 1) ? SSD1306_WHITE : SSD1306_BLACK);
+      display.display();
+    });
+    bench("ssd1306_display_partial", [&] {
+      display.fillRect(60, 24, 8, 8, (frame++ & 1) ? SSD1306_WHITE : SSD1306_BLACK);
+      display.display();
+    });
+  } else {
+    report("ssd1306_display_full", false);
+    report("ssd1306_display_partial", false);
+  }
+
+  // GFX glyph rendering into the frame buffer (no panel traffic)
+  uint8_t ch = 0;
+  bench("gfx_drawChar_size1", [&] {
+    display.drawChar(0, 0, 'A' + (ch++ % 26), SSD1306_WHITE, SSD1306_BLACK, 1);
+  });
+  bench("gfx_drawChar_size2", [&] {
+    display.drawChar(0, 0, 'A' + (ch++ % 26), SSD1306_WHITE, SSD1306_BLACK, 2);
+  });
+
+  // PubSubClient::publish into the null client
+  mqtt.setServer("bench", 1883);
+  mqtt.setBufferSize(256);
+  if (mqtt.connect("bench")) {
+    bench("mqtt_publish_150B", [&] { mqtt.publish("battery/data", payload2k, 150); });
+    bench("mqtt_publish_2KB", [&] { mqtt.publish("battery/data", payload2k, sizeof(payload2k)); });
+  } else {
+    report("mqtt_publish_150B", false);
+    report("mqtt_publish_2KB", false);
+  }
+
+  // Telemetry payload: the old String concatenation against JsonWriter
+  float bus_V = 3.912f, current_mA = -412.5f, power_mW = 1613.7f, soc = 87.25f, soh = 98.5f;
+  uint32_t uptime = 123456789;
+  bench("payload_string", [&] {
+    String p = "{";
+    p += "\"uptime_ms\":" + String(uptime) + ",";
+    p += "\"bus_V\":" + String(bus_V, 3) + ",";
+    p += "\"current_mA\":" + String(current_mA, 3) + ",";
+    p += "\"power_mW\":" + String(power_mW, 3) + ",";
+    p += "\"soc_percent\":" + String(soc, 2) + ",";
+    p += "\"soh_percent\":" + String(soh, 2);
+    p += "}";
+  });
+  static char jsonBuf[192];
+  bench("payload_jsonwriter", [&] {
+    JsonWriter p(jsonBuf, sizeof(jsonBuf));
+    p.beginObject()
+        .field("uptime_ms", uptime)
+        .field("bus_V", bus_V, 3)
+        .field("current_mA", current_mA, 3)
+        .field("power_mW", power_mW, 3)
+        .field("soc_percent", soc, 2)
+        .field("soh_percent", soh, 2)
+        .endObject();
+  });
+
+  // EKF SoC: one predict + voltage update, as handleSample() runs it per reading
+  SocEkf ekf;
+  ekf.begin(4200.0f, 80.0f, 5.0f);
+  uint32_t t_us = 0;
+  bench("soc_ekf_update", [&] {
+    t_us += 10000;
+    ekf.update(t_us, 500000 + (int32_t)(t_us & 1023), 3850000 + (int32_t)(t_us & 2047));
+  });
+
+  Serial.printf("{\"bench\":\"done\",\"free_heap\":%u}\n", (unsigned)ESP.getFreeHeap());
+}
+
+void loop() {
+  delay(1000);
+}
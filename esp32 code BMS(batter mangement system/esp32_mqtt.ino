@@ -10,11 +10,14 @@ const int MQTT_PORT = 8883; // TLS port
 const char* MQTT_USER = "YOUR_MQTT_USER"; // HiveMQ Cloud user (if any)
 const char* MQTT_PASSWORD = "YOUR_MQTT_PASSWORD"; // HiveMQ Cloud password (if any)
 
-// Topics
-// Publishing structured telemetry to: smartpower/{device_id}/data
-const char* DEVICE_ID = "device01";
-const char* PUB_TOPIC = "smartpower/device01/data"; // change device01 if needed
-const char* SUB_TOPIC = "smartpower/device01/commands";
+// Topics: {site}/{device_id}/{stream}, the same layout as src/topic_layout.h
+// Publishing structured telemetry to: smartpower/{device_id}/raw, commands on smartpower/{device_id}/cmd
+// device_id is "bms-" and the eFuse MAC unless DEVICE_ID is set
+const char* TOPIC_SITE = "smartpower";
+const char* DEVICE_ID = "";
+char deviceId[17];
+char PUB_TOPIC[48];
+char SUB_TOPIC[48];
 
 WiFiClientSecure secureClient;
 PubSubClient mqttClient(secureClient);
@@ -68,10 +71,24 @@ bool mqttConnect() {
   }
 }
 
+void buildTopics() {
+  if (DEVICE_ID[0]) {
+    snprintf(deviceId, sizeof(deviceId), "%s", DEVICE_ID);
+  } else {
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(deviceId, sizeof(deviceId), "bms-");
+    for (uint8_t b = 0; b < 6; ++b) snprintf(deviceId + 4 + 2 * b, 3, "%02x", (unsigned)((mac >> (8 * b)) & 0xFF));
+  }
+  snprintf(PUB_TOPIC, sizeof(PUB_TOPIC), "%s/%s/raw", TOPIC_SITE, deviceId);
+  snprintf(SUB_TOPIC, sizeof(SUB_TOPIC), "%s/%s/cmd", TOPIC_SITE, deviceId);
+}
+
 void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
   Serial.begin(115200);
   delay(1000);
+  buildTopics();
+  Serial.printf("Publishing on %s\n", PUB_TOPIC);
   connectWiFi();
 }
 
@@ -94,7 +111,7 @@ void loop() {
     // Use millis() for timestamp (relative); for real UTC use NTP + time(nullptr)
     unsigned long ts = millis();
     String payload = "{";
-    payload += "\"device_id\":\"" + String(DEVICE_ID) + "\",";
+    payload += "\"device_id\":\"" + String(deviceId) + "\",";
     payload += "\"voltage\":" + String(voltage, 2) + ",";
     payload += "\"current\":" + String(current, 2) + ",";
     payload += "\"power\":" + String(power, 2) + ",";
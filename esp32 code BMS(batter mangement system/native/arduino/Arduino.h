@@ -0,0 +1,45 @@
+#pragma once
+
+// Host stand-in for the Arduino core, just enough for PubSubClient, the
+// replay tool ([env:native]) and Adafruit GFX's canvases ([env:native_gfx])
+// to build. Time comes from the host's
+// monotonic clock (arduino_host.cpp), or from a simulated one.
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+typedef uint8_t BitOrder;
+
+template <typename T> inline T min(T a, T b) { return b < a ? b : a; }
+template <typename T> inline T max(T a, T b) { return a < b ? b : a; }
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// Host only: after simulateClock(), millis() and micros() read a clock that
+// moves only with advanceClock_us() and delay(), so hours of device time
+// run in seconds and every run is reproducible.
+void simulateClock();
+void advanceClock_us(uint64_t us);
+uint64_t clock_us();
+
+#include "Print.h"
+#include "Stream.h"
+#include "WString.h"
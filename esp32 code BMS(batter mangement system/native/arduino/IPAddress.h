@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+class IPAddress {
+public:
+  IPAddress() : IPAddress(0, 0, 0, 0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+
+  uint8_t operator[](int index) const { return _bytes[index]; }
+
+private:
+  uint8_t _bytes[4];
+};
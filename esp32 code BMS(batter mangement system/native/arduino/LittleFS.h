@@ -0,0 +1,61 @@
+#pragma once
+
+// Host stand-in for the arduino-esp32 LittleFS, in memory: just the calls
+// FlashQueue makes. Files keep their bytes for the life of the program;
+// totalBytes() is the partition size the queue sees (setCapacity()).
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+class HostFs;
+
+class File {
+public:
+  File() {}
+  File(HostFs* fs, const std::string& path, bool dir, bool write) : _fs(fs), _path(path), _dir(dir), _write(write) {}
+
+  explicit operator bool() const { return _fs != nullptr; }
+  bool isDirectory() const { return _dir; }
+  const char* name() const;
+  File openNextFile();
+  size_t write(const uint8_t* data, size_t len);
+  size_t read(uint8_t* buf, size_t len);
+  size_t size() const;
+  void close() { _fs = nullptr; }
+
+private:
+  HostFs* _fs = nullptr;
+  std::string _path;
+  bool _dir = false;
+  bool _write = false;
+  size_t _pos = 0;
+  std::string _next;   // directory listing: last name handed out
+};
+
+class HostFs {
+public:
+  bool begin(bool formatOnFail = false);
+  bool exists(const char* path) const;
+  bool mkdir(const char* path);
+  File open(const char* path, const char* mode = FILE_READ);
+  bool remove(const char* path);
+  size_t totalBytes() const { return _capacity; }
+  size_t usedBytes() const;
+
+  void setCapacity(size_t bytes) { _capacity = bytes; }
+  size_t files() const { return _files.size(); }
+
+private:
+  friend class File;
+  std::map<std::string, std::vector<uint8_t>> _files;
+  std::map<std::string, bool> _dirs;
+  size_t _capacity = 1441792;   // default 1.375 MB spiffs partition
+};
+
+extern HostFs LittleFS;
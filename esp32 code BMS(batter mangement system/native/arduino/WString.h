@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+// Host stand-in for the core's String, as far as Adafruit GFX uses it.
+class String {
+public:
+  String(const char* s = "") : _s(s) {}
+  unsigned int length() const { return _s.size(); }
+  const char* c_str() const { return _s.c_str(); }
+
+private:
+  std::string _s;
+};
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper*)(s))
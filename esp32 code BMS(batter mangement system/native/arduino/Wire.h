@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Stream.h"
+
+// Declarations only, so the BusIO headers parse in host builds that never
+// touch a bus (the [env:native_gfx] canvas test).
+class TwoWire : public Stream {};
+extern TwoWire Wire;
@@ -0,0 +1,38 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+static std::minstd_rand rng;
+static bool simulated = false;
+static uint64_t simulated_us = 0;
+
+uint64_t clock_us() {
+  if (simulated) return simulated_us;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START)
+      .count();
+}
+
+unsigned long millis() { return (unsigned long)(clock_us() / 1000); }
+
+unsigned long micros() { return (unsigned long)clock_us(); }
+
+void delay(unsigned long ms) {
+  if (simulated) simulated_us += (uint64_t)ms * 1000;
+  else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void simulateClock() {
+  simulated = true;
+  simulated_us = 0;
+}
+
+void advanceClock_us(uint64_t us) { simulated_us += us; }
+
+long random(long max) { return max > 0 ? (long)(rng() % (unsigned long)max) : 0; }
+
+long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+
+void randomSeed(unsigned long seed) { rng.seed(seed); }
@@ -0,0 +1,76 @@
+#include "LittleFS.h"
+
+#include <string.h>
+
+HostFs LittleFS;
+
+// Whole 4 KB blocks, as LittleFS allocates them
+static size_t blocks(size_t bytes) { return (bytes + 4095) / 4096 * 4096; }
+
+const char* File::name() const {
+  size_t slash = _path.rfind('/');
+  return _path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+File File::openNextFile() {
+  if (!_fs || !_dir) return File();
+  std::string prefix = _path + "/";
+  auto it = _next.empty() ? _fs->_files.lower_bound(prefix) : _fs->_files.upper_bound(_next);
+  if (it == _fs->_files.end() || it->first.compare(0, prefix.size(), prefix) != 0) return File();
+  _next = it->first;
+  return File(_fs, it->first, false, false);
+}
+
+size_t File::write(const uint8_t* data, size_t len) {
+  if (!_fs || !_write) return 0;
+  std::vector<uint8_t>& bytes = _fs->_files[_path];
+  size_t room = _fs->_capacity - _fs->usedBytes();
+  if (blocks(bytes.size() + len) - blocks(bytes.size()) > room) return 0;
+  bytes.insert(bytes.end(), data, data + len);
+  return len;
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+  if (!_fs || _dir) return 0;
+  auto it = _fs->_files.find(_path);
+  if (it == _fs->_files.end() || _pos >= it->second.size()) return 0;
+  size_t n = it->second.size() - _pos;
+  if (n > len) n = len;
+  memcpy(buf, it->second.data() + _pos, n);
+  _pos += n;
+  return n;
+}
+
+size_t File::size() const {
+  if (!_fs) return 0;
+  auto it = _fs->_files.find(_path);
+  return it == _fs->_files.end() ? 0 : it->second.size();
+}
+
+bool HostFs::begin(bool) { return true; }
+
+bool HostFs::exists(const char* path) const { return _dirs.count(path) || _files.count(path); }
+
+bool HostFs::mkdir(const char* path) {
+  _dirs[path] = true;
+  return true;
+}
+
+File HostFs::open(const char* path, const char* mode) {
+  if (_dirs.count(path)) return File(this, path, true, false);
+  bool write = mode[0] == 'w';
+  if (write) {
+    _files[path].clear();
+  } else if (!_files.count(path)) {
+    return File();
+  }
+  return File(this, path, false, write);
+}
+
+bool HostFs::remove(const char* path) { return _files.erase(path) > 0; }
+
+size_t HostFs::usedBytes() const {
+  size_t used = 0;
+  for (const auto& f : _files) used += blocks(f.second.size());
+  return used;
+}
@@ -0,0 +1,259 @@
+#include "fault_client.h"
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+static const uint64_t NEVER = UINT64_MAX;
+
+// Digits after key in data[0, len), e.g. "\"n\":"; false if absent
+static bool findNumber(const uint8_t* data, size_t len, const char* key, uint64_t& value) {
+  size_t klen = strlen(key);
+  const uint8_t* end = data + len;
+  const uint8_t* p = std::search(data, end, key, key + klen);
+  if (p == end) return false;
+  p += klen;
+  if (p == end || *p < '0' || *p > '9') return false;
+  value = 0;
+  while (p < end && *p >= '0' && *p <= '9') value = value * 10 + (uint64_t)(*p++ - '0');
+  return true;
+}
+
+void FaultClient::begin(const FaultPlan& plan, uint32_t seed) {
+  _plan = plan;
+  _rng = seed ? seed : 1;
+  uint64_t now = clock_us();
+  _nextOutage_us = now + nextGap_us(_plan.outageEvery_s);
+  _nextStall_us = now + nextGap_us(_plan.stallEvery_s);
+}
+
+uint32_t FaultClient::uniform(uint32_t lo, uint32_t hi) {
+  // xorshift32, as the replay fuzzer: reproducible from the seed
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return hi > lo ? lo + _rng % (hi - lo + 1) : lo;
+}
+
+uint64_t FaultClient::nextGap_us(uint32_t mean_s) {
+  if (!mean_s) return NEVER / 2;
+  double u = (uniform(0, 0xFFFFFFFEu) + 1.0) / 4294967296.0;
+  return (uint64_t)(-log(u) * mean_s * 1e6);
+}
+
+void FaultClient::step() {
+  uint64_t now = clock_us();
+  _idlePolls = 0;
+  if (!_linkUp && now >= _outageEnd_us) {
+    _linkUp = true;
+    // A silent drop left a session the broker gave up on: the first segment gets a reset
+    if (_silent) _connected = false;
+    _nextOutage_us = now + nextGap_us(_plan.outageEvery_s);
+  }
+  if (_faults && _linkUp && now >= _nextOutage_us) {
+    uint32_t dur = uniform(_plan.outageMin_ms, _plan.outageMax_ms);
+    _linkUp = false;
+    _silent = uniform(0, 9999) < _plan.silentShare * 10000;
+    _outageEnd_us = now + dur * 1000ull;
+    _stats.outages++;
+    _stats.outage_us += dur * 1000ull;
+    _replies.clear();
+    if (!_silent) _connected = false;
+  }
+  if (_faults && now >= _stallEnd_us && now >= _nextStall_us) {
+    _stallEnd_us = now + uniform(_plan.stallMin_ms, _plan.stallMax_ms) * 1000ull;
+    _nextStall_us = _stallEnd_us + nextGap_us(_plan.stallEvery_s);
+    _stats.stalls++;
+  }
+  brokerRead();
+  deliver();
+}
+
+int FaultClient::open() {
+  stop();
+  if (!_linkUp) {
+    advanceClock_us(_plan.connectMin_ms * 1000ull);
+    _stats.refused++;
+    return 0;
+  }
+  advanceClock_us(uniform(_plan.connectMin_ms, _plan.connectMax_ms) * 1000ull);
+  _connected = true;
+  return 1;
+}
+
+size_t FaultClient::write(const uint8_t* buf, size_t size) {
+  if (!_connected) return 0;
+  // Into the void during a silent outage, or after a malformed packet
+  if (!_linkUp || _closing) return size;
+  if (_faults && size > 1 && uniform(0, 999999) < _plan.partialWrite * 1000000) {
+    _stats.partialWrites++;
+    brokerRead();
+    _in.clear();
+    _closing = true;
+    closeSoon();
+    return 1 + uniform(0, (uint32_t)size - 2);
+  }
+  _in.insert(_in.end(), buf, buf + size);
+  _stats.bytesIn += size;
+  return size;
+}
+
+void FaultClient::brokerRead() {
+  if (!_connected || !_linkUp || clock_us() < _stallEnd_us) return;
+  size_t pos = 0;
+  while (_connected && _in.size() - pos >= 2) {
+    // Fixed header: type byte, then the remaining length in 1..4 bytes
+    uint32_t rem = 0;
+    size_t k = 1;
+    bool complete = false;
+    for (uint32_t shift = 0; k < 5 && pos + k < _in.size() && !complete; shift += 7) {
+      uint8_t b = _in[pos + k++];
+      rem |= (uint32_t)(b & 0x7F) << shift;
+      complete = !(b & 0x80);
+    }
+    if (!complete || pos + k + rem > _in.size()) break;
+    brokerHandle(&_in[pos], k + rem);
+    pos += k + rem;
+  }
+  _in.erase(_in.begin(), _in.begin() + std::min(pos, _in.size()));
+}
+
+void FaultClient::brokerHandle(const uint8_t* p, size_t len) {
+  size_t hl = 1;
+  while (p[hl++] & 0x80) {
+  }
+  const uint8_t* body = p + hl;
+  size_t blen = len - hl;
+  switch (p[0] & 0xF0) {
+    case MQTTCONNECT: {
+      // Protocol name "MQTT" (2 + 4 bytes), level, then the flags
+      bool clean = blen > 7 && (body[7] & 0x02);
+      uint8_t present = !clean && _sessionKept;
+      _sessionKept = !clean;
+      _stats.connects++;
+#if MQTT_VERSION == MQTT_VERSION_5
+      const uint8_t connack[] = { MQTTCONNACK, 3, present, 0, 0 };
+#else
+      const uint8_t connack[] = { MQTTCONNACK, 2, present, 0 };
+#endif
+      reply(connack, sizeof(connack));
+      break;
+    }
+    case MQTTPUBLISH: {
+      uint8_t qos = (p[0] >> 1) & 3;
+      if (blen < 2) break;
+      size_t pos = 2 + ((size_t)body[0] << 8 | body[1]);
+      uint16_t id = 0;
+      if (qos && pos + 2 <= blen) {
+        id = (uint16_t)(body[pos] << 8 | body[pos + 1]);
+        pos += 2;
+      }
+#if MQTT_VERSION == MQTT_VERSION_5
+      uint32_t plen = 0;
+      for (uint32_t shift = 0; pos < blen; shift += 7) {
+        uint8_t b = body[pos++];
+        plen |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+      }
+      pos += plen;
+#endif
+      if (pos > blen) break;
+      _stats.publishes++;
+      uint64_t key, n = 0;
+      if (findNumber(body + pos, blen - pos, "\"uptime_ms\":", key)) {
+        findNumber(body + pos, blen - pos, "\"n\":", n);
+        if (_seen.insert(key).second) {
+          _stats.messages++;
+          _stats.samples += n;
+        } else {
+          _stats.duplicates++;
+        }
+      }
+      if (qos == 1) {
+        const uint8_t puback[] = { MQTTPUBACK, 2, (uint8_t)(id >> 8), (uint8_t)id };
+        reply(puback, sizeof(puback));
+      }
+      break;
+    }
+    case MQTTSUBSCRIBE: {
+      if (blen < 2) break;
+      const uint8_t suback[] = { MQTTSUBACK, 3, body[0], body[1], 0 };
+      reply(suback, sizeof(suback));
+      break;
+    }
+    case MQTTPINGREQ: {
+      const uint8_t pingresp[] = { MQTTPINGRESP, 0 };
+      reply(pingresp, sizeof(pingresp));
+      break;
+    }
+    case MQTTDISCONNECT:
+      _connected = false;
+      break;
+    default:
+      break;
+  }
+}
+
+void FaultClient::reply(const uint8_t* bytes, size_t len) {
+  Reply r;
+  r.due_us = clock_us() + uniform(_plan.latencyMin_ms, _plan.latencyMax_ms) * 1000ull;
+  // One TCP stream: nothing overtakes what was sent before it
+  if (!_replies.empty() && r.due_us < _replies.back().due_us) r.due_us = _replies.back().due_us;
+  r.bytes.assign(bytes, bytes + len);
+  _replies.push_back(r);
+}
+
+void FaultClient::closeSoon() { reply(nullptr, 0); }
+
+void FaultClient::deliver() {
+  uint64_t now = clock_us();
+  while (!_replies.empty() && _replies.front().due_us <= now) {
+    Reply& r = _replies.front();
+    if (r.bytes.empty()) {
+      _connected = false;
+      _replies.clear();
+      return;
+    }
+    _rx.insert(_rx.end(), r.bytes.begin(), r.bytes.end());
+    _replies.pop_front();
+  }
+}
+
+int FaultClient::available() {
+  deliver();
+  int n = (int)(_rx.size() - _rxPos);
+  // A caller polling again within one pass is blocked in a read: let time pass
+  if (!n && _idlePolls++) advanceClock_us(1000);
+  return n;
+}
+
+int FaultClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int FaultClient::read(uint8_t* buf, size_t size) {
+  size_t n = std::min(size, _rx.size() - _rxPos);
+  if (!n) return -1;
+  memcpy(buf, _rx.data() + _rxPos, n);
+  _rxPos += n;
+  if (_rxPos == _rx.size()) {
+    _rx.clear();
+    _rxPos = 0;
+  }
+  return (int)n;
+}
+
+int FaultClient::peek() { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+
+void FaultClient::stop() {
+  _connected = false;
+  _closing = false;
+  _in.clear();
+  _replies.clear();
+  _rx.clear();
+  _rxPos = 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Client.h>
+
+#include <deque>
+#include <set>
+#include <vector>
+
+// What a soak run does to the link. Times between faults are exponential
+// around their mean; durations are uniform in [min, max]. 0 disables.
+struct FaultPlan {
+  uint32_t outageEvery_s = 1800;      // WiFi drops
+  uint32_t outageMin_ms = 2000;
+  uint32_t outageMax_ms = 180000;
+  float silentShare = 0.5f;           // drops the stack does not report: only the keepalive notices
+  uint32_t stallEvery_s = 7200;       // broker stops answering, the connection stays up
+  uint32_t stallMin_ms = 5000;
+  uint32_t stallMax_ms = 90000;
+  uint32_t latencyMin_ms = 20;        // each broker reply
+  uint32_t latencyMax_ms = 400;
+  uint32_t connectMin_ms = 200;       // TCP + TLS handshake
+  uint32_t connectMax_ms = 2500;
+  float partialWrite = 0.0005f;       // per write: only a prefix goes out
+};
+
+// Client with a broker behind it for the soak harness (soak_main.cpp), on
+// the simulated clock (simulateClock()). Bytes written are parsed as MQTT
+// packets: CONNECT, PUBLISH at QoS 0/1, PINGREQ and DISCONNECT are answered
+// after the plan's latency, and every delivered PUBLISH payload is counted
+// once by its "uptime_ms" (duplicates apart) together with its "n".
+//
+// Faults: an outage refuses connects and either closes the connection at
+// once or, when silent, swallows traffic both ways until the keepalive
+// gives up (the session is reset when the link returns). A stall leaves the
+// connection up but the broker reads nothing until it ends. A partial write
+// sends a prefix only; the broker sees the malformed packet and closes.
+class FaultClient : public Client {
+public:
+  struct Stats {
+    uint32_t connects = 0;          // CONNACKs sent
+    uint32_t refused = 0;           // connects during an outage
+    uint32_t outages = 0;
+    uint32_t stalls = 0;
+    uint32_t partialWrites = 0;
+    uint32_t publishes = 0;         // PUBLISH packets, duplicates included
+    uint32_t duplicates = 0;        // ... of a message already delivered
+    uint32_t messages = 0;          // distinct messages
+    uint64_t samples = 0;           // their "n"
+    uint64_t bytesIn = 0;
+    uint64_t outage_us = 0;         // time the link was down
+  };
+
+  void begin(const FaultPlan& plan, uint32_t seed);
+  // Faults on (false: a clean link, e.g. to drain at the end of a run)
+  void setFaults(bool on) { _faults = on; }
+  // Once per harness pass: starts and ends faults, lets the broker read and
+  // hands over replies that are due.
+  void step();
+  bool linkUp() const { return _linkUp; }
+  const Stats& stats() const { return _stats; }
+
+  int connect(IPAddress, uint16_t) override { return open(); }
+  int connect(const char*, uint16_t) override { return open(); }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override { return _connected; }
+  operator bool() override { return _connected; }
+
+private:
+  struct Reply {
+    uint64_t due_us;
+    std::vector<uint8_t> bytes;   // empty: the broker closes the connection
+  };
+
+  int open();
+  uint32_t uniform(uint32_t lo, uint32_t hi);
+  uint64_t nextGap_us(uint32_t mean_s);
+  void brokerRead();
+  void brokerHandle(const uint8_t* p, size_t len);
+  void reply(const uint8_t* bytes, size_t len);
+  void closeSoon();
+  void deliver();
+
+  FaultPlan _plan;
+  uint32_t _rng = 1;
+  bool _faults = true;
+  Stats _stats;
+
+  bool _linkUp = true;
+  uint64_t _outageEnd_us = 0;
+  uint64_t _nextOutage_us = 0;
+  bool _silent = false;
+  uint64_t _stallEnd_us = 0;
+  uint64_t _nextStall_us = 0;
+
+  bool _connected = false;
+  bool _closing = false;          // the broker saw a malformed packet
+  bool _sessionKept = false;      // a cleanSession=false client connected before
+  std::vector<uint8_t> _in;       // written, not yet read by the broker
+  std::deque<Reply> _replies;     // in flight to the client
+  std::vector<uint8_t> _rx;       // arrived, not yet read by the client
+  size_t _rxPos = 0;
+  uint32_t _idlePolls = 0;
+  std::set<uint64_t> _seen;       // "uptime_ms" of every delivered message
+};
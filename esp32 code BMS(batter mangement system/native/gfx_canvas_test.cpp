@@ -0,0 +1,78 @@
+// fillRect() edge cases on the three GFX canvases ([env:native_gfx]).
+//
+// GFXcanvas1 and GFXcanvas8 clip the rectangle once and fill rows;
+// GFXcanvas16 keeps Adafruit_GFX::fillRect(), one writeFastVLine() per
+// column. Every case is drawn on each canvas at each rotation and compared
+// pixel by pixel against the same reference: a negative height grows up
+// from y, as writeFastVLine() does, a zero height or a zero or negative
+// width draws nothing, and whatever is left is clipped to the canvas.
+// One JSON line per canvas; exits 1 if any pixel differs.
+//
+//   program
+#include <stdio.h>
+
+#include "Adafruit_GFX.h"
+
+static const int16_t CANVAS_W = 20;
+static const int16_t CANVAS_H = 12;
+
+struct Rect {
+  int16_t x, y, w, h;
+};
+
+static const Rect CASES[] = {
+    {10, 5, 3, 2},    // plain
+    {10, 5, 3, -2},   // negative height: rows 4 and 5
+    {2, 1, 4, -4},    // negative height, clipped at the top
+    {10, 5, 0, 3},    // zero width
+    {10, 5, -3, 2},   // negative width
+    {10, 5, 3, 0},    // zero height
+    {-3, -2, 6, 5},   // clipped top left
+    {17, 9, 8, 8},    // clipped bottom right
+    {-5, 3, 40, 1},   // wider than the canvas
+    {4, 30, 3, -25},  // starts below the canvas, grows into it
+    {25, 3, 2, 2},    // right of the canvas
+    {0, 0, 20, 12},   // whole canvas
+};
+
+static bool expected(const Rect& r, int16_t px, int16_t py) {
+  int16_t y = r.y, h = r.h;
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  return r.w > 0 && px >= r.x && px < r.x + r.w && py >= y && py < y + h;
+}
+
+// Counts the pixels that differ from the reference over every case and
+// rotation.
+template <typename Canvas> static unsigned check(const char* name) {
+  Canvas canvas(CANVAS_W, CANVAS_H);
+  unsigned cases = 0, wrong = 0;
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    canvas.setRotation(rotation);
+    for (const Rect& r : CASES) {
+      canvas.fillScreen(0);
+      canvas.fillRect(r.x, r.y, r.w, r.h, 1);
+      unsigned bad = 0;
+      for (int16_t py = 0; py < canvas.height(); py++)
+        for (int16_t px = 0; px < canvas.width(); px++)
+          if ((canvas.getPixel(px, py) != 0) != expected(r, px, py))
+            bad++;
+      if (bad)
+        fprintf(stderr, "%s rotation %u fillRect(%d, %d, %d, %d): %u pixels wrong\n", name, rotation, r.x, r.y,
+                r.w, r.h, bad);
+      wrong += bad;
+      cases++;
+    }
+  }
+  printf("{\"canvas\":\"%s\",\"cases\":%u,\"wrong_pixels\":%u}\n", name, cases, wrong);
+  return wrong;
+}
+
+int main() {
+  unsigned wrong = check<GFXcanvas1>("GFXcanvas1");
+  wrong += check<GFXcanvas8>("GFXcanvas8");
+  wrong += check<GFXcanvas16>("GFXcanvas16");
+  return wrong ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Client.h>
+
+#include <vector>
+
+// In-memory transport for PubSubClient on the host. Everything written is
+// counted (and kept, when capture is on); reads are served from bytes
+// queued with reply(), which is how the "broker" answers.
+class MockClient : public Client {
+public:
+  void reply(const uint8_t* data, size_t len) { _rx.insert(_rx.end(), data, data + len); }
+  void setCapture(bool capture) { _capture = capture; }
+  const std::vector<uint8_t>& captured() const { return _tx; }
+  void clearCaptured() { _tx.clear(); }
+  uint64_t bytesWritten() const { return _bytes; }
+  uint64_t writes() const { return _writes; }
+
+  int connect(IPAddress, uint16_t) override { return _connected = true; }
+  int connect(const char*, uint16_t) override { return _connected = true; }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override {
+    if (!_connected) return 0;
+    if (_capture) _tx.insert(_tx.end(), buf, buf + size);
+    _bytes += size;
+    _writes++;
+    return size;
+  }
+  int available() override { return (int)(_rx.size() - _rxPos); }
+  int read() override { return _rxPos < _rx.size() ? _rx[_rxPos++] : -1; }
+  int read(uint8_t* buf, size_t size) override {
+    size_t n = 0;
+    while (n < size && _rxPos < _rx.size()) buf[n++] = _rx[_rxPos++];
+    return n ? (int)n : -1;
+  }
+  int peek() override { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+  void flush() override {}
+  void stop() override { _connected = false; }
+  uint8_t connected() override { return _connected; }
+  operator bool() override { return _connected; }
+
+private:
+  std::vector<uint8_t> _rx;
+  size_t _rxPos = 0;
+  std::vector<uint8_t> _tx;
+  bool _capture = false;
+  bool _connected = false;
+  uint64_t _bytes = 0;
+  uint64_t _writes = 0;
+};
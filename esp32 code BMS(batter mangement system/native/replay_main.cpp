@@ -0,0 +1,446 @@
+// Host-side replay of the BMS processing core ([env:native]).
+//
+// Feeds a trace through the same objects loop() uses (CoulombCounter,
+// TelemetryWindow, EventCapture, JsonWriter, the binary codec) and publishes
+// the results through PubSubClient into a MockClient, as fast as the host
+// allows. Prints one JSON line with throughput and totals, like the on-target
+// benchmarks.
+//
+//   program [trace.csv] [--rate HZ] [--loops N] [--raw] [--rbe]
+//   program --fuzz N [--seed S]
+//
+// The trace is a server CSV log (see trace_csv.h); rows are linearly
+// interpolated to --rate samples per second. Without a file a pulsed discharge is
+// synthesized. --rbe filters windows as REPORT_BY_EXCEPTION does
+// (report_filter.h). --fuzz runs N random windows with extreme values and random
+// output sizes through the core and exits non-zero if a buffer is overrun.
+#include <PubSubClient.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "aggregator.h"
+#include "binary_codec.h"
+#include "coulomb_counter.h"
+#include "event_capture.h"
+#include "json_writer.h"
+#include "mock_client.h"
+#include "report_filter.h"
+#include "soc_ekf.h"
+#include "soh_estimator.h"
+#include "trace_csv.h"
+
+// Same settings as src/main.cpp
+static const uint32_t PUBLISH_INTERVAL_MS = 5000;
+static const uint32_t SAMPLE_RATE_HZ = 100;
+static const uint16_t TELEMETRY_BUFFER_SIZE = 1536;
+static const float BATTERY_CAPACITY_mAh = 4200.0f;
+static const uint32_t EVENT_PRE_ms = 1000;
+static const uint32_t EVENT_POST_ms = 2000;
+static const float EVENT_CURRENT_mA = 1800.0f;
+static const float EVENT_SLEW_mA_PER_S = 20000.0f;
+static const uint32_t EVENT_HOLDOFF_ms = 10000;
+static const float RBE_DEADBAND[ReportFilter::CHANNELS] = { 0.02f, 0.005f, 0.05f, 0.5f };
+static const uint32_t RBE_HEARTBEAT_MS = 60000;
+
+static const char* PUB_TOPIC = "battery/replay/aggregate";
+static const char* PUB_TOPIC_BIN = "battery/replay/raw/bin";
+static const char* PUB_TOPIC_EVENT = "battery/replay/event";
+
+static const size_t BIN_BUFFER_SIZE = TELEMETRY_HEADER_SIZE + SAMPLE_RECORD_SIZE +
+                                      TelemetryWindow::RAW_CAPACITY * DELTA_RECORD_MAX;
+static const size_t EVENT_BUFFER_SIZE = EVENT_HEADER_SIZE + SAMPLE_RECORD_SIZE +
+                                        EventCapture::CAPACITY * DELTA_RECORD_MAX;
+
+static PowerSample toSample(const TracePoint& p, uint32_t t_us, uint16_t rate_Hz) {
+  PowerSample s;
+  s.t_us = t_us;
+  s.shunt_uV = (int32_t)lroundf(p.shunt_mV * 1000.0f);
+  s.bus_uV = (int32_t)lroundf(p.bus_V * 1e6f);
+  s.current_uA = (int32_t)lroundf(p.current_mA * 1000.0f);
+  s.power_uW = (int32_t)lroundf(p.power_mW * 1000.0f);
+  s.overflow = false;
+  s.rate_Hz = rate_Hz;
+  return s;
+}
+
+static void printResult(JsonWriter& out) {
+  out.endObject();
+  puts(out.c_str());
+}
+
+struct Pipeline {
+  MockClient net;
+  PubSubClient mqtt{net};
+  CoulombCounter coulomb;
+  SocEkf ekf;
+  SohEstimator soh;
+  TelemetryWindow window;
+  EventCapture events;
+  PowerSample eventRing[EventCapture::CAPACITY];
+  ReportFilter filter;
+  bool raw = false;
+  uint64_t samples = 0;
+  uint32_t publishes = 0;
+  uint32_t publishFailures = 0;
+  uint32_t lastPublish_ms = 0;
+  uint32_t suppressed = 0;   // windows report by exception left out
+  uint64_t packedBytes = 0;   // raw windows as PackedBatch (what is published)
+  uint64_t deltaBytes = 0;    // ... and as DeltaBatch, for comparison
+
+  bool begin(uint32_t rate_Hz) {
+    coulomb.begin(BATTERY_CAPACITY_mAh, 100.0f);
+    ekf.begin(BATTERY_CAPACITY_mAh, 100.0f, 25.0f);
+    soh.begin(ekf, BATTERY_CAPACITY_mAh, 0.0f, 0.05f);
+    events.begin(EVENT_PRE_ms, EVENT_POST_ms, eventRing, EventCapture::CAPACITY);
+    events.setTriggers(EVENT_CURRENT_mA, EVENT_SLEW_mA_PER_S, 0.0f, EVENT_HOLDOFF_ms);
+    filter.begin(RBE_DEADBAND, RBE_HEARTBEAT_MS);
+    uint32_t perWindow = rate_Hz * PUBLISH_INTERVAL_MS / 1000;
+    window.setRawStride((perWindow + TelemetryWindow::RAW_CAPACITY - 1) / TelemetryWindow::RAW_CAPACITY);
+#if MQTT_VERSION == MQTT_VERSION_5
+    static const uint8_t CONNACK[] = { 0x20, 3, 0, 0, 0 };
+#else
+    static const uint8_t CONNACK[] = { 0x20, 2, 0, 0 };
+#endif
+    net.reply(CONNACK, sizeof(CONNACK));
+    mqtt.setServer("replay", 1883);
+    mqtt.setBufferSize(TELEMETRY_BUFFER_SIZE + 64);
+    return mqtt.connect("esp32_bms_replay");
+  }
+
+  void publish(const char* topic, const uint8_t* data, size_t len) {
+    if (mqtt.publish(topic, data, len)) {
+      publishes++;
+    } else {
+      publishFailures++;
+    }
+  }
+
+  // The consumer half of loop() for one sample, t_ms being trace uptime.
+  void add(const PowerSample& s, uint32_t t_ms) {
+    samples++;
+    coulomb.addSample_uA(s.t_us, s.current_uA);
+    ekf.update(s.t_us, s.current_uA, s.bus_uV + s.shunt_uV);
+    soh.add(s.t_us, s.current_uA, s.bus_uV + s.shunt_uV, coulomb.consumed_uAs());
+    window.add(s);
+    events.add(s);
+    if (events.ready()) {
+      static uint8_t eventBuf[EVENT_BUFFER_SIZE];
+      size_t len = encodeEvent(eventBuf, sizeof(eventBuf), events.samples(), events.count(), events.triggerIndex(),
+                               events.cause(), t_ms, 0, coulomb.soc_percent(), 100.0f);
+      if (len) publish(PUB_TOPIC_EVENT, eventBuf, len);
+      events.release();
+    }
+    if (t_ms - lastPublish_ms < PUBLISH_INTERVAL_MS) return;
+    lastPublish_ms = t_ms;
+    float soc = coulomb.soc_percent();
+    filter.observe(CHANNEL_V, window.voltage().min(), window.voltage().max(), window.voltage().mean());
+    filter.observe(CHANNEL_I, window.current().min(), window.current().max(), window.current().mean());
+    filter.observe(CHANNEL_P, window.power().min(), window.power().max(), window.power().mean());
+    filter.observe(CHANNEL_SOC, soc, soc, soc);
+    uint8_t channels = filter.decide(t_ms);
+    if (!channels) {
+      suppressed++;
+      window.reset();
+      return;
+    }
+    static char payloadBuf[TELEMETRY_BUFFER_SIZE];
+    JsonWriter payload(payloadBuf, sizeof(payloadBuf));
+    payload.beginObject().field("uptime_ms", t_ms);
+    if (filter.enabled()) payload.field("rbe", true);
+    if (raw) {
+      window.writeRaw(payload, channels);
+    } else {
+      window.writeAggregate(payload, channels);
+    }
+    if (channels & CHANNEL_SOC) payload.field("soc_percent", soc, 2).field("soh_percent", 100.0f, 2);
+    payload.endObject();
+    if (payload.ok()) publish(PUB_TOPIC, (const uint8_t*)payload.c_str(), payload.length());
+    static uint8_t binBuf[BIN_BUFFER_SIZE];
+    size_t binLen;
+    if (raw && window.rawCount()) {
+      binLen = encodePackedBatch(binBuf, sizeof(binBuf), window.raw(), window.rawCount(), t_ms, 0, soc, 100.0f);
+      packedBytes += binLen;
+      static uint8_t deltaBuf[BIN_BUFFER_SIZE];
+      deltaBytes += encodeDeltaBatch(deltaBuf, sizeof(deltaBuf), window.raw(), window.rawCount(), t_ms, 0, soc, 100.0f);
+    } else {
+      binLen = encodeSingle(binBuf, sizeof(binBuf), window.last(), t_ms, 0, soc, 100.0f);
+    }
+    if (binLen) publish(PUB_TOPIC_BIN, binBuf, binLen);
+    window.reset();
+  }
+};
+
+static int replay(const char* path, uint32_t rate_Hz, uint32_t loops, bool raw, bool rbe) {
+  std::vector<TracePoint> trace;
+  if (!path) {
+    synthesizeTrace(trace);
+  } else if (!loadTrace(path, trace)) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+  if (trace.size() < 2) {
+    fprintf(stderr, "trace needs at least two rows\n");
+    return 1;
+  }
+  // Expand to samples up front so the timed part is the pipeline only.
+  std::vector<PowerSample> samples;
+  uint32_t period_us = 1000000 / rate_Hz;
+  uint32_t t_us = 0;
+  for (size_t k = 0; k + 1 < trace.size(); ++k) {
+    const TracePoint& a = trace[k];
+    const TracePoint& b = trace[k + 1];
+    uint32_t steps = (uint32_t)((uint64_t)(b.t_ms - a.t_ms) * rate_Hz / 1000);
+    for (uint32_t i = 0; i < steps; ++i) {
+      float f = (float)i / steps;
+      TracePoint p = { 0, a.bus_V + (b.bus_V - a.bus_V) * f, a.shunt_mV + (b.shunt_mV - a.shunt_mV) * f,
+                       a.current_mA + (b.current_mA - a.current_mA) * f, a.power_mW + (b.power_mW - a.power_mW) * f, NAN };
+      samples.push_back(toSample(p, t_us, (uint16_t)rate_Hz));
+      t_us += period_us;
+    }
+  }
+
+  Pipeline pipe;
+  pipe.raw = raw;
+  pipe.filter.setEnabled(rbe);
+  if (!pipe.begin(rate_Hz)) {
+    fprintf(stderr, "MQTT connect to the mock client failed: %d\n", pipe.mqtt.state());
+    return 1;
+  }
+  uint64_t startBytes = pipe.net.bytesWritten();
+  uint64_t span_us = t_us;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t loop = 0; loop < loops; ++loop) {
+    // Later passes continue the clock, so the trace repeats back to back
+    // and the 32-bit microsecond stamps wrap as micros() would.
+    uint64_t offset_us = loop * span_us;
+    for (size_t i = 0; i < samples.size(); ++i) {
+      PowerSample s = samples[i];
+      uint64_t t = s.t_us + offset_us;
+      s.t_us = (uint32_t)t;
+      pipe.add(s, (uint32_t)(t / 1000));
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  char line[448];
+  JsonWriter out(line, sizeof(line));
+  out.beginObject()
+      .field("replay", path ? path : "synthetic")
+      .field("rate_Hz", rate_Hz)
+      .field("samples", pipe.samples)
+      .field("seconds", (float)seconds, 3)
+      .field("samples_per_s", (float)(pipe.samples / seconds), 0)
+      .field("ns_per_sample", (float)(seconds * 1e9 / pipe.samples), 1)
+      .field("publishes", pipe.publishes)
+      .field("publish_failures", pipe.publishFailures)
+      .field("suppressed_windows", pipe.suppressed)
+      .field("mqtt_bytes", pipe.net.bytesWritten() - startBytes)
+      .field("packed_bytes", pipe.packedBytes)
+      .field("delta_bytes", pipe.deltaBytes)
+      .field("events", pipe.events.events())
+      .field("consumed_mAh", pipe.coulomb.consumed_mAh(), 3)
+      .field("soc_percent", pipe.coulomb.soc_percent(), 2)
+      .field("ekf_soc_percent", pipe.ekf.soc_percent(), 2)
+      .field("ekf_rejected", pipe.ekf.rejected())
+      .field("soh_percent", pipe.soh.soh_percent(), 2)
+      .field("r0_mOhm", pipe.soh.r0_ohm() * 1000.0f, 1);
+  printResult(out);
+  return 0;
+}
+
+// ---- fuzzing ----
+
+static uint32_t rng = 1;
+static uint32_t fuzzSeed = 1;
+
+static uint32_t next() {
+  // xorshift32: reproducible from --seed, independent of the host libc
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// Anywhere in [-limit, limit], with the ends and zero drawn often. Limits
+// are what the INA219 registers can report, which the core's integer
+// arithmetic is sized for.
+static int32_t fuzzValue(int32_t limit, bool signedValue = true) {
+  int32_t low = signedValue ? -limit : 0;
+  switch (next() % 8) {
+    case 0: return limit;
+    case 1: return low;
+    case 2: return 0;
+    default: return low + (int32_t)(next() % ((uint32_t)(limit - low) + 1));
+  }
+}
+
+static const uint8_t GUARD = 0xA5;
+static const size_t GUARD_SIZE = 16;
+
+static bool guardIntact(const uint8_t* p) {
+  for (size_t i = 0; i < GUARD_SIZE; ++i) {
+    if (p[i] != GUARD) return false;
+  }
+  return true;
+}
+
+// Output buffer of a random size followed by guard bytes.
+struct FuzzBuffer {
+  std::vector<uint8_t> bytes;
+  size_t cap;
+
+  explicit FuzzBuffer(size_t maxCap) : cap(next() % (maxCap + 1)) { bytes.assign(cap + GUARD_SIZE, GUARD); }
+  uint8_t* data() { return bytes.data(); }
+  bool intact() const { return guardIntact(bytes.data() + cap); }
+};
+
+static bool fail(uint32_t iteration, const char* what) {
+  fprintf(stderr, "fuzz: %s (iteration %u, seed %u)\n", what, iteration, fuzzSeed);
+  return false;
+}
+
+static bool fuzzOnce(uint32_t iteration) {
+  static CoulombCounter coulomb;
+  static SocEkf ekf;
+  static SohEstimator soh;
+  static TelemetryWindow window;
+  static EventCapture events;
+  static PowerSample eventRing[EventCapture::CAPACITY];
+  if (iteration == 0) {
+    coulomb.begin(BATTERY_CAPACITY_mAh, 100.0f);
+    ekf.begin(BATTERY_CAPACITY_mAh, 100.0f, 25.0f);
+    soh.begin(ekf, BATTERY_CAPACITY_mAh, 0.0f, 0.05f);
+    events.begin(EVENT_PRE_ms, EVENT_POST_ms, eventRing, EventCapture::CAPACITY);
+    events.setTriggers(EVENT_CURRENT_mA, EVENT_SLEW_mA_PER_S, 3000.0f, 0);
+  }
+  window.reset();
+  window.setRawStride(1 + next() % 4);
+  // Start close to a micros() wrap half of the time.
+  static uint32_t t_us = 0;
+  if (next() & 1) t_us = 0xFFFFFFFFu - next() % 2000000;
+  uint32_t n = 1 + next() % 200;
+  for (uint32_t i = 0; i < n; ++i) {
+    // Mostly sampler-like steps, sometimes a gap of up to 10 s (low power).
+    t_us += next() % 16 == 0 ? next() % 10000000 : next() % 20000;
+    PowerSample s;
+    s.t_us = t_us;
+    s.shunt_uV = fuzzValue(327670);
+    s.bus_uV = fuzzValue(32764000, false);
+    s.current_uA = fuzzValue(40000000);
+    s.power_uW = fuzzValue(1000000000, false);
+    s.overflow = next() % 16 == 0;
+    s.rate_Hz = (uint16_t)next();
+    coulomb.addSample_uA(s.t_us, s.current_uA);
+    ekf.update(s.t_us, s.current_uA, s.bus_uV + s.shunt_uV);
+    soh.add(s.t_us, s.current_uA, s.bus_uV + s.shunt_uV, coulomb.consumed_uAs());
+    window.add(s);
+    events.add(s);
+  }
+  float soc = coulomb.soc_percent();
+  if (!(soc >= 0.0f && soc <= 100.0f)) return fail(iteration, "soc out of range");
+  float ekfSoc = ekf.soc_percent();
+  if (!(ekfSoc >= 0.0f && ekfSoc <= 100.0f)) return fail(iteration, "ekf soc out of range");
+  if (!(ekf.sigma_percent() >= 0.0f && ekf.sigma_percent() < 1e6f)) return fail(iteration, "ekf covariance diverged");
+  if (!(soh.soh_percent() >= 10.0f && soh.soh_percent() <= 200.0f)) return fail(iteration, "soh out of range");
+  if (!(soh.r0_ohm() >= 0.0f && soh.r0_ohm() < 1e3f)) return fail(iteration, "r0 diverged");
+
+  FuzzBuffer json(TELEMETRY_BUFFER_SIZE);
+  JsonWriter w((char*)json.data(), json.cap);
+  w.beginObject().field("uptime_ms", next());
+  if (next() & 1) {
+    window.writeAggregate(w);
+  } else {
+    window.writeRaw(w);
+  }
+  w.field("soc_percent", soc, 2).endObject();
+  if (!json.intact()) return fail(iteration, "JsonWriter overran its buffer");
+  if (json.cap && (w.length() >= json.cap || strlen(w.c_str()) != w.length())) {
+    return fail(iteration, "JsonWriter length/terminator mismatch");
+  }
+
+  FuzzBuffer bin(BIN_BUFFER_SIZE);
+  size_t len = encodeDeltaBatch(bin.data(), bin.cap, window.raw(), window.rawCount(), next(), next(), soc, 100.0f);
+  if (!bin.intact() || len > bin.cap) return fail(iteration, "encodeDeltaBatch overran its buffer");
+  FuzzBuffer packed(BIN_BUFFER_SIZE);
+  len = encodePackedBatch(packed.data(), packed.cap, window.raw(), window.rawCount(), next(), next(), soc, 100.0f);
+  if (!packed.intact() || len > packed.cap) return fail(iteration, "encodePackedBatch overran its buffer");
+  if (len) {
+    static SampleRecord records[TelemetryWindow::RAW_CAPACITY];
+    static uint32_t offsets[TelemetryWindow::RAW_CAPACITY];
+    size_t n = decodePackedBatch(packed.data(), len, records, offsets, TelemetryWindow::RAW_CAPACITY);
+    if (n != window.rawCount()) return fail(iteration, "decodePackedBatch lost samples");
+    const PowerSample* raw = window.raw();
+    for (size_t k = 0; k < n; ++k) {
+      SampleRecord r = toRecord(raw[k]);
+      if (memcmp(&r, &records[k], sizeof(r)) != 0 || offsets[k] != (raw[k].t_us - raw[0].t_us) / 1000) {
+        return fail(iteration, "PackedBatch round trip mismatch");
+      }
+    }
+  }
+  FuzzBuffer single(TELEMETRY_HEADER_SIZE + SAMPLE_RECORD_SIZE);
+  len = encodeSingle(single.data(), single.cap, window.last(), next(), next(), soc, 100.0f);
+  if (!single.intact() || len > single.cap) return fail(iteration, "encodeSingle overran its buffer");
+  if (events.ready()) {
+    FuzzBuffer ev(EVENT_BUFFER_SIZE);
+    len = encodeEvent(ev.data(), ev.cap, events.samples(), events.count(), events.triggerIndex(), events.cause(),
+                      next(), next(), soc, 100.0f);
+    if (!ev.intact() || len > ev.cap) return fail(iteration, "encodeEvent overran its buffer");
+    events.release();
+  }
+  return true;
+}
+
+static int fuzz(uint32_t iterations, uint32_t seed) {
+  fuzzSeed = seed;
+  rng = seed ? seed : 1;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    if (!fuzzOnce(i)) return 1;
+  }
+  char line[96];
+  JsonWriter out(line, sizeof(line));
+  out.beginObject().field("fuzz", iterations).field("seed", seed).field("ok", true);
+  printResult(out);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  uint32_t rate_Hz = SAMPLE_RATE_HZ;
+  uint32_t loops = 100;
+  uint32_t fuzzIterations = 0;
+  uint32_t seed = 1;
+  bool raw = false;
+  bool rbe = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--rate" && hasValue) {
+      rate_Hz = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--loops" && hasValue) {
+      loops = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--fuzz" && hasValue) {
+      fuzzIterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--seed" && hasValue) {
+      seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--raw") {
+      raw = true;
+    } else if (arg == "--rbe") {
+      rbe = true;
+    } else if (arg[0] != '-' && !path) {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [trace.csv] [--rate HZ] [--loops N] [--raw] [--rbe] | --fuzz N [--seed S]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (fuzzIterations) return fuzz(fuzzIterations, seed);
+  if (rate_Hz == 0 || rate_Hz > 1000000 || loops == 0) {
+    fprintf(stderr, "--rate must be 1..1000000 and --loops at least 1\n");
+    return 2;
+  }
+  return replay(path, rate_Hz, loops, raw, rbe);
+}
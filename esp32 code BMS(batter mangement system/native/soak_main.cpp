@@ -0,0 +1,387 @@
+// Soak run of the uplink under network faults ([env:native_soak]).
+//
+// Drives the firmware's telemetry path for simulated hours over a link that
+// fails the way WiFi and brokers do (fault_client.h): samples into a
+// TelemetryWindow, each window encoded as main.cpp does and published at
+// QoS 1 through PubSubClient with the firmware's settings, spilled to the
+// real FlashQueue (on the in-memory LittleFS) when that fails, and replayed
+// from it, each page kept until its PUBACKs are in. Time is simulated, so
+// 72 h take seconds and a seed reproduces a run exactly.
+//
+//   program [--hours H] [--seed S] [--outage-every S] [--outage-max S] [--silent F]
+//           [--stall-every S] [--stall-max S] [--latency-max MS] [--partial P]
+//           [--drain S] [--min-delivery F]
+//
+// After --hours with faults the link is clean for up to --drain seconds so
+// the backlog can go out. Prints one JSON line per simulated hour and a
+// summary: delivered against generated windows and samples, duplicates,
+// queue high-water marks, reconnect times and the MQTT heap trend. Exits 1
+// if less than --min-delivery of the windows reached the broker.
+#include <LittleFS.h>
+#include <PubSubClient.h>
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "aggregator.h"
+#include "coulomb_counter.h"
+#include "fault_client.h"
+#include "flash_queue.h"
+#include "json_writer.h"
+#include "mem_placement.h"
+
+// Same settings as src/main.cpp
+static const uint32_t PUBLISH_INTERVAL_MS = 5000;
+static const uint32_t SAMPLE_RATE_HZ = 100;
+static const float BATTERY_CAPACITY_mAh = 4200.0f;
+static const uint16_t TELEMETRY_BUFFER_SIZE = 1536;
+static const uint16_t MQTT_BUFFER_SIZE = 1024 + 256;
+static const uint16_t MQTT_WRITE_BUFFER_SIZE = 4096;
+static const uint8_t MQTT_INFLIGHT_WINDOW = 8;
+static const uint16_t MQTT_RETRY_MS = 10000;
+static const uint32_t MQTT_BACKOFF_MIN_MS = 1000;
+static const uint32_t MQTT_BACKOFF_MAX_MS = 60000;
+static const bool MQTT_PERSISTENT_SESSION = true;
+static const size_t QUEUE_DRAIN_BATCH = 8;
+static const unsigned long QUEUE_DRAIN_INTERVAL = 250;
+static const char* PUB_TOPIC = "battery/soak/aggregate";
+
+// One pass of the network task
+static const uint64_t PASS_us = 10000;
+
+// mem_placement.cpp needs the ESP heap; the queue's pages come from malloc here
+void* placeAlloc(size_t bytes, MemRegion) { return malloc(bytes); }
+
+// QoS 1 copies and alias topics, counted: the heap the MQTT client holds
+static size_t heapLive = 0;
+static size_t heapPeak = 0;
+
+static void* countedAlloc(size_t size) {
+  size_t* p = (size_t*)malloc(size + sizeof(size_t));
+  if (!p) return nullptr;
+  *p = size;
+  heapLive += size;
+  heapPeak = std::max(heapPeak, heapLive);
+  return p + 1;
+}
+
+static void countedFree(void* ptr) {
+  if (!ptr) return;
+  size_t* p = (size_t*)ptr - 1;
+  heapLive -= *p;
+  free(p);
+}
+
+static FaultClient net;
+static PubSubClient mqttClient(net);
+static FlashQueue flashQueue;
+static uint16_t queueInflight[MQTT_INFLIGHT_WINDOW] = {};
+static uint8_t mqttBuffer[MQTT_BUFFER_SIZE];
+static uint8_t mqttWriteBuffer[MQTT_WRITE_BUFFER_SIZE];
+
+// As in main.cpp: replayed messages at QoS 1, each confirmed by onPuback()
+static bool sendQueued(uint8_t, const uint8_t* data, size_t len) {
+  uint16_t* slot = nullptr;
+  for (uint16_t& id : queueInflight) {
+    if (!id) slot = &id;
+  }
+  if (!slot) return false;
+  *slot = mqttClient.publishQos1(PUB_TOPIC, data, len);
+  return *slot != 0;
+}
+
+static void onPuback(uint16_t msgId) {
+  for (uint16_t& id : queueInflight) {
+    if (id == msgId) {
+      id = 0;
+      flashQueue.acknowledge();
+    }
+  }
+}
+
+static bool publishOrQueue(const uint8_t* data, size_t len) {
+  if (mqttClient.publishQos1(PUB_TOPIC, data, len)) return true;
+  flashQueue.push(0, data, len);
+  return false;
+}
+
+struct Percentiles {
+  std::vector<uint32_t> values;
+
+  uint32_t at(float q) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)ceil(q * values.size());   // nearest rank
+    return values[rank ? rank - 1 : 0];
+  }
+  uint32_t mean() const {
+    uint64_t sum = 0;
+    for (uint32_t v : values) sum += v;
+    return values.empty() ? 0 : (uint32_t)(sum / values.size());
+  }
+};
+
+struct Soak {
+  TelemetryWindow window;
+  CoulombCounter coulomb;
+  uint32_t generated = 0;
+  uint64_t generatedSamples = 0;
+  uint32_t published = 0;   // taken by the client at once
+  uint32_t queued = 0;      // ... or spilled to the flash queue
+  uint32_t lastPublish_ms = 0;
+  uint64_t lastDrain_ms = 0;
+
+  bool wasConnected = false;
+  uint64_t lostAt_us = 0;
+  uint32_t disconnects = 0;
+  Percentiles reconnect_ms;
+  uint64_t offline_us = 0;
+
+  uint16_t pagesHw = 0;
+  size_t flashHw = 0;
+  uint8_t inflightHw = 0;
+  uint16_t unackedHw = 0;
+  std::vector<size_t> hourlyHeap;
+
+  // Synthetic pack: 30 s at 1.2 A (with a 2.5 A inrush) then 30 s at rest
+  static PowerSample sample(uint64_t t_us) {
+    uint32_t phase_ms = (uint32_t)(t_us / 1000 % 60000);
+    int32_t current_uA = phase_ms < 30000 ? (phase_ms < 500 ? 2500000 : 1200000) : 50000;
+    PowerSample s;
+    s.t_us = (uint32_t)t_us;
+    s.current_uA = current_uA;
+    s.shunt_uV = current_uA / 10;   // 0.1 ohm
+    s.bus_uV = 3700000 - current_uA / 10 - (int32_t)(t_us / 1000000 % 36000);
+    s.power_uW = (int32_t)((int64_t)s.bus_uV * current_uA / 1000000);
+    s.overflow = false;
+    s.rate_Hz = SAMPLE_RATE_HZ;
+    return s;
+  }
+
+  void add(uint64_t t_us) {
+    PowerSample s = sample(t_us);
+    coulomb.addSample_uA(s.t_us, s.current_uA);
+    window.add(s);
+    uint32_t t_ms = (uint32_t)(t_us / 1000);
+    if (t_ms - lastPublish_ms < PUBLISH_INTERVAL_MS) return;
+    lastPublish_ms = t_ms;
+    static char payloadBuf[TELEMETRY_BUFFER_SIZE];
+    JsonWriter payload(payloadBuf, sizeof(payloadBuf));
+    payload.beginObject().field("uptime_ms", t_ms);
+    window.writeAggregate(payload);
+    payload.field("soc_percent", coulomb.soc_percent(), 2).endObject();
+    generated++;
+    generatedSamples += window.count();
+    window.reset();
+    if (!payload.ok()) return;
+    if (publishOrQueue((const uint8_t*)payload.c_str(), payload.length())) published++;
+    else queued++;
+  }
+
+  // mqttPoll() and the queue part of networkPass()
+  void networkPass(uint64_t now_us) {
+    static const char* CLIENT_ID = "ESP32-soak";
+    if (!mqttClient.connected() && !mqttClient.connecting()) {
+      mqttClient.connectAsync(CLIENT_ID, nullptr, nullptr, nullptr, 0, false, nullptr, !MQTT_PERSISTENT_SESSION);
+    }
+    mqttClient.loop();
+    uint64_t now_ms = now_us / 1000;
+    if (mqttClient.connected() && !flashQueue.empty() && now_ms - lastDrain_ms >= QUEUE_DRAIN_INTERVAL) {
+      lastDrain_ms = now_ms;
+      flashQueue.drain(sendQueued, QUEUE_DRAIN_BATCH);
+    }
+    flashQueue.poll((uint32_t)now_ms);
+  }
+
+  void track(uint64_t now_us) {
+    bool up = mqttClient.connected();
+    if (wasConnected && !up) {
+      disconnects++;
+      lostAt_us = now_us;
+    } else if (!wasConnected && up && lostAt_us) {
+      reconnect_ms.values.push_back((uint32_t)((now_us - lostAt_us) / 1000));
+    }
+    if (!up) offline_us += PASS_us;
+    wasConnected = up;
+    pagesHw = std::max(pagesHw, flashQueue.storedPages());
+    flashHw = std::max(flashHw, LittleFS.usedBytes());
+    inflightHw = std::max(inflightHw, mqttClient.inflightMessages());
+    unackedHw = std::max(unackedHw, flashQueue.unacked());
+  }
+
+  void hourly(uint32_t hour) {
+    hourlyHeap.push_back(heapLive);
+    const FaultClient::Stats& n = net.stats();
+    char line[256];
+    JsonWriter out(line, sizeof(line));
+    out.beginObject()
+        .field("hour", hour)
+        .field("generated", generated)
+        .field("delivered", n.messages)
+        .field("duplicates", n.duplicates)
+        .field("stored_pages", flashQueue.storedPages())
+        .field("inflight", mqttClient.inflightMessages())
+        .field("heap_B", (uint32_t)heapLive)
+        .field("outages", n.outages)
+        .field("stalls", n.stalls)
+        .endObject();
+    puts(out.c_str());
+  }
+
+  // Least-squares slope of the hourly heap samples, bytes per hour
+  float heapSlope() const {
+    size_t n = hourlyHeap.size();
+    if (n < 2) return 0.0f;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t k = 0; k < n; ++k) {
+      sx += k;
+      sy += hourlyHeap[k];
+      sxx += (double)k * k;
+      sxy += (double)k * hourlyHeap[k];
+    }
+    return (float)((n * sxy - sx * sy) / (n * sxx - sx * sx));
+  }
+};
+
+static int soak(uint32_t hours, uint32_t seed, const FaultPlan& plan, uint32_t drain_s, float minDelivery) {
+  simulateClock();
+  randomSeed(seed);   // connect backoff jitter
+  net.begin(plan, seed);
+  flashQueue.setAwaitAcks(true);
+  if (!flashQueue.begin()) {
+    fprintf(stderr, "flash queue did not start\n");
+    return 1;
+  }
+  mqttClient.setBuffer(mqttBuffer, sizeof(mqttBuffer));
+  mqttClient.setWriteBuffer(mqttWriteBuffer, sizeof(mqttWriteBuffer));
+  mqttClient.setAllocator(countedAlloc, countedFree);
+  mqttClient.setPubackCallback(onPuback);
+  mqttClient.setInflightWindow(MQTT_INFLIGHT_WINDOW, MQTT_RETRY_MS);
+  mqttClient.setBackoff(MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS);
+  mqttClient.setServer("soak", 8883);
+
+  Soak run;
+  run.coulomb.begin(BATTERY_CAPACITY_mAh, 100.0f);
+  const uint64_t period_us = 1000000 / SAMPLE_RATE_HZ;
+  const uint64_t end_us = hours * 3600000000ull;
+  const uint64_t drainEnd_us = end_us + drain_s * 1000000ull;
+  uint64_t nextSample_us = 0;
+  uint32_t hour = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (;;) {
+    uint64_t now_us = clock_us();
+    while (now_us >= (hour + 1) * 3600000000ull && hour < hours) run.hourly(++hour);
+    if (now_us >= end_us) {
+      net.setFaults(false);
+      bool settled = flashQueue.empty() && !mqttClient.inflightMessages() && mqttClient.connected();
+      if (settled || now_us >= drainEnd_us) break;
+    }
+    // The sampler task keeps converting while the network blocks: catch up
+    while (nextSample_us <= now_us && nextSample_us < end_us) {
+      run.add(nextSample_us);
+      nextSample_us += period_us;
+    }
+    net.step();
+    run.networkPass(now_us);
+    run.track(now_us);
+    advanceClock_us(PASS_us);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const FaultClient::Stats& n = net.stats();
+  float delivery = run.generated ? (float)n.messages / run.generated : 1.0f;
+  char line[1024];
+  JsonWriter out(line, sizeof(line));
+  out.beginObject()
+      .field("soak_h", hours)
+      .field("seed", seed)
+      .field("host_s", (float)seconds, 2)
+      .field("generated", run.generated)
+      .field("delivered", n.messages)
+      .field("delivery", delivery, 6)
+      .field("lost", run.generated - std::min(run.generated, n.messages))
+      .field("duplicates", n.duplicates)
+      .field("samples_generated", run.generatedSamples)
+      .field("samples_delivered", n.samples)
+      .field("published_live", run.published)
+      .field("queued", run.queued)
+      .field("publish_packets", n.publishes)
+      .field("mqtt_kB", (uint32_t)(n.bytesIn / 1024));
+  out.beginObject("faults")
+      .field("outages", n.outages)
+      .field("outage_s", (uint32_t)(n.outage_us / 1000000))
+      .field("stalls", n.stalls)
+      .field("partial_writes", n.partialWrites)
+      .field("refused_connects", n.refused)
+      .endObject();
+  out.beginObject("queue")
+      .field("pages_hw", run.pagesHw)
+      .field("flash_kB_hw", (uint32_t)(run.flashHw / 1024))
+      .field("dropped_pages", flashQueue.droppedPages())
+      .field("inflight_hw", run.inflightHw)
+      .field("unacked_hw", run.unackedHw)
+      .field("left_pages", flashQueue.storedPages())
+      .endObject();
+  out.beginObject("reconnect")
+      .field("disconnects", run.disconnects)
+      .field("connects", n.connects)
+      .field("p50_ms", run.reconnect_ms.at(0.5f))
+      .field("p90_ms", run.reconnect_ms.at(0.9f))
+      .field("max_ms", run.reconnect_ms.at(1.0f))
+      .field("mean_ms", run.reconnect_ms.mean())
+      .field("offline_s", (uint32_t)(run.offline_us / 1000000))
+      .endObject();
+  out.beginObject("heap")
+      .field("start_B", (uint32_t)(run.hourlyHeap.empty() ? 0 : run.hourlyHeap.front()))
+      .field("end_B", (uint32_t)heapLive)
+      .field("peak_B", (uint32_t)heapPeak)
+      .field("slope_B_per_h", run.heapSlope(), 1)
+      .endObject();
+  out.endObject();
+  puts(out.c_str());
+  return delivery >= minDelivery ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  uint32_t hours = 72;
+  uint32_t seed = 1;
+  uint32_t drain_s = 3600;
+  float minDelivery = 1.0f;
+  FaultPlan plan;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) arg = "";
+    const char* value = i + 1 < argc ? argv[i + 1] : "";
+    uint32_t u = (uint32_t)strtoul(value, nullptr, 10);
+    float f = strtof(value, nullptr);
+    if (arg == "--hours") hours = u;
+    else if (arg == "--seed") seed = u;
+    else if (arg == "--outage-every") plan.outageEvery_s = u;
+    else if (arg == "--outage-max") plan.outageMax_ms = u * 1000;
+    else if (arg == "--silent") plan.silentShare = f;
+    else if (arg == "--stall-every") plan.stallEvery_s = u;
+    else if (arg == "--stall-max") plan.stallMax_ms = u * 1000;
+    else if (arg == "--latency-max") plan.latencyMax_ms = u;
+    else if (arg == "--partial") plan.partialWrite = f;
+    else if (arg == "--drain") drain_s = u;
+    else if (arg == "--min-delivery") minDelivery = f;
+    else {
+      fprintf(stderr,
+              "usage: %s [--hours H] [--seed S] [--outage-every S] [--outage-max S] [--silent F] [--stall-every S]\n"
+              "          [--stall-max S] [--latency-max MS] [--partial P] [--drain S] [--min-delivery F]\n",
+              argv[0]);
+      return 2;
+    }
+    ++i;
+  }
+  if (!hours || plan.outageMax_ms < plan.outageMin_ms || plan.stallMax_ms < plan.stallMin_ms ||
+      plan.latencyMax_ms < plan.latencyMin_ms) {
+    fprintf(stderr, "--hours must be at least 1, and each maximum at least its minimum\n");
+    return 2;
+  }
+  return soak(hours, seed, plan, drain_s, minDelivery);
+}
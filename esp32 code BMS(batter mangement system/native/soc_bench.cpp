@@ -0,0 +1,347 @@
+// SoC accuracy against CPU cost, replayed from server logs ([env:native_soc]).
+//
+// The trace's current is taken as the truth between rows (linear), and its
+// exact integral is the reference charge. For every sampling rate the
+// trace is sampled the way the INA219 would see it (Gaussian noise, then
+// quantized to the current LSB) and each integrator/filter configuration
+// runs over the same samples. One JSON line per configuration:
+//   {"config":"trapezoid_fixed","filter":"none","rate_Hz":100,"samples":..,
+//    "drift_percent":..,"max_error_percent":..,"ns_per_sample":..,"frontier":true}
+// Errors are charge differences in percent of capacity (so clamping at 0
+// and 100 % does not hide them); "frontier" marks the configurations no
+// other one beats on both max error and time per sample. Costs are host
+// timings: use them to rank, and bench/ for absolute ESP32 cycles.
+//
+//   program [trace.csv ...] [--rates 1,10,100,1000] [--noise-uA 100] [--lsb-uA 61]
+//           [--capacity-mAh 4200] [--loops N] [--seed S]
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "coulomb_counter.h"
+#include "json_writer.h"
+#include "trace_csv.h"
+
+static const float DEFAULT_CAPACITY_mAh = 4200.0f;   // BATTERY_CAPACITY_mAh in src/main.cpp
+static const float DEFAULT_NOISE_uA = 100.0f;
+static const float DEFAULT_LSB_uA = 61.0f;           // 2 A full scale / 32767 (INA_PROFILE)
+static const double MIN_TIMED_S = 0.05;              // repeat short runs until timing is stable
+
+struct Measurement {
+  uint32_t t_us;
+  int32_t current_uA;
+};
+
+// Exact charge of the piecewise-linear trace, in µAs since its first row.
+class ReferenceCharge {
+public:
+  explicit ReferenceCharge(const std::vector<TracePoint>& trace) : _trace(trace) {
+    _cumulative.push_back(0.0);
+    for (size_t k = 1; k < trace.size(); ++k) {
+      double dt_s = (trace[k].t_ms - trace[k - 1].t_ms) * 1e-3;
+      _cumulative.push_back(_cumulative.back() + (trace[k].current_mA + trace[k - 1].current_mA) * 500.0 * dt_s);
+    }
+  }
+
+  double span_ms() const { return _trace.back().t_ms - _trace.front().t_ms; }
+  double total_uAs() const { return _cumulative.back(); }
+  // t_ms from the first row, at most span_ms().
+  double at(double t_ms) const {
+    t_ms += _trace.front().t_ms;
+    while (_row + 1 < _trace.size() && _trace[_row + 1].t_ms <= t_ms) _row++;
+    while (_row > 0 && _trace[_row].t_ms > t_ms) _row--;
+    const TracePoint& a = _trace[_row];
+    if (_row + 1 >= _trace.size()) return _cumulative[_row];
+    const TracePoint& b = _trace[_row + 1];
+    double dt_ms = t_ms - a.t_ms;
+    double slope = (b.current_mA - a.current_mA) / (double)(b.t_ms - a.t_ms);
+    double i_mA = a.current_mA + slope * dt_ms;
+    return _cumulative[_row] + (a.current_mA + i_mA) * 0.5 * dt_ms;   // mA * ms = µAs
+  }
+  double current_mA(double t_ms) const {
+    at(t_ms);   // positions _row
+    t_ms += _trace.front().t_ms;
+    const TracePoint& a = _trace[_row];
+    if (_row + 1 >= _trace.size()) return a.current_mA;
+    const TracePoint& b = _trace[_row + 1];
+    return a.current_mA + (b.current_mA - a.current_mA) * (t_ms - a.t_ms) / (double)(b.t_ms - a.t_ms);
+  }
+
+private:
+  const std::vector<TracePoint>& _trace;
+  std::vector<double> _cumulative;
+  mutable size_t _row = 0;   // walk position; lookups are mostly in time order
+};
+
+static uint32_t rng = 1;
+
+static float uniform() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return (rng >> 8) * (1.0f / 16777216.0f);
+}
+
+// Irwin-Hall approximation, unit variance.
+static float gaussian() { return (uniform() + uniform() + uniform() + uniform() - 2.0f) * 1.7320508f; }
+
+// ---- configurations ----
+// Each takes samples through add() and reports the charge it integrated in
+// µAs from consumed_uAs().
+
+// The firmware's CoulombCounter: trapezoid, 64-bit fixed point.
+struct TrapezoidFixed {
+  CoulombCounter counter;
+  explicit TrapezoidFixed(float capacity_mAh) { counter.begin(capacity_mAh, 100.0f); }
+  void add(uint32_t t_us, int32_t current_uA) { counter.addSample_uA(t_us, current_uA); }
+  double consumed_uAs() const { return (double)counter.consumed_uAs(); }
+};
+
+// The original loop(): SoC in float percent, current times the time since
+// the previous sample.
+struct RectangleFloat {
+  float capacity_mAh;
+  float soc = 100.0f;
+  uint32_t lastT_us = 0;
+  bool primed = false;
+  explicit RectangleFloat(float capacity) : capacity_mAh(capacity) {}
+  void add(uint32_t t_us, int32_t current_uA) {
+    if (primed) {
+      float dt_h = (t_us - lastT_us) * (1.0f / 3.6e9f);
+      soc -= current_uA * 1e-3f * dt_h / capacity_mAh * 100.0f;
+    }
+    primed = true;
+    lastT_us = t_us;
+  }
+  double consumed_uAs() const { return (100.0 - soc) / 100.0 * capacity_mAh * 3.6e6; }
+};
+
+// Trapezoid with a float mAh accumulator.
+struct TrapezoidFloat {
+  float consumed_mAh = 0.0f;
+  uint32_t lastT_us = 0;
+  int32_t last_uA = 0;
+  bool primed = false;
+  explicit TrapezoidFloat(float) {}
+  void add(uint32_t t_us, int32_t current_uA) {
+    if (primed) consumed_mAh += (last_uA + current_uA) * 0.5e-3f * ((t_us - lastT_us) * (1.0f / 3.6e9f));
+    primed = true;
+    lastT_us = t_us;
+    last_uA = current_uA;
+  }
+  double consumed_uAs() const { return consumed_mAh * 3.6e6; }
+};
+
+// Integer EMA (alpha = 1/8) on the current before the fixed-point trapezoid.
+struct Ema8Fixed {
+  TrapezoidFixed inner;
+  int32_t state = 0;
+  bool primed = false;
+  explicit Ema8Fixed(float capacity_mAh) : inner(capacity_mAh) {}
+  void add(uint32_t t_us, int32_t current_uA) {
+    state = primed ? state + ((current_uA - state) >> 3) : current_uA;
+    primed = true;
+    inner.add(t_us, state);
+  }
+  double consumed_uAs() const { return inner.consumed_uAs(); }
+};
+
+struct Result {
+  const char* config;
+  const char* filter;
+  uint32_t rate_Hz;
+  size_t samples;
+  double drift_percent;
+  double maxError_percent;
+  double ns_per_sample;
+  double cycles_per_sample;   // < 0: not measured
+  bool frontier;
+};
+
+template <typename Config>
+static Result run(const char* name, const char* filter, uint32_t rate_Hz, const std::vector<Measurement>& samples,
+                  const ReferenceCharge& ref, float capacity_mAh) {
+  Result r = { name, filter, rate_Hz, samples.size(), 0.0, 0.0, 0.0, -1.0, false };
+  double capacity_uAs = capacity_mAh * 3.6e6;
+  double span_ms = ref.span_ms();
+
+  // Accuracy pass: error against the reference once per second of trace.
+  Config acc(capacity_mAh);
+  uint32_t every = rate_Hz;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    acc.add(samples[i].t_us, samples[i].current_uA);
+    if (i % every == 0 || i + 1 == samples.size()) {
+      double t_ms = (double)i * 1000.0 / rate_Hz;
+      double refQ = floor(t_ms / span_ms) * ref.total_uAs() + ref.at(fmod(t_ms, span_ms));
+      double err = fabs(acc.consumed_uAs() - refQ) / capacity_uAs * 100.0;
+      if (err > r.maxError_percent) r.maxError_percent = err;
+      if (i + 1 == samples.size()) r.drift_percent = (acc.consumed_uAs() - refQ) / capacity_uAs * 100.0;
+    }
+  }
+
+  // Cost pass: the add() loop alone, repeated until long enough to time.
+  double best_ns = 1e30;
+  double best_cycles = 1e30;
+  double elapsed = 0.0;
+  volatile double sink = 0.0;
+  do {
+    Config c(capacity_mAh);
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    auto start = std::chrono::steady_clock::now();
+    for (const Measurement& m : samples) c.add(m.t_us, m.current_uA);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#ifdef HAVE_TSC
+    double cycles = (double)(__rdtsc() - c0) / samples.size();
+    if (cycles < best_cycles) best_cycles = cycles;
+#endif
+    sink = sink + c.consumed_uAs();
+    elapsed += s;
+    if (s * 1e9 / samples.size() < best_ns) best_ns = s * 1e9 / samples.size();
+  } while (elapsed < MIN_TIMED_S);
+  r.ns_per_sample = best_ns;
+#ifdef HAVE_TSC
+  r.cycles_per_sample = best_cycles;
+#endif
+  return r;
+}
+
+// What the INA219 would report at rate_Hz over loops passes of the trace.
+static std::vector<Measurement> measure(const ReferenceCharge& ref, uint32_t rate_Hz, uint32_t loops, float noise_uA,
+                                        float lsb_uA) {
+  std::vector<Measurement> out;
+  double span_ms = ref.span_ms();
+  uint64_t count = (uint64_t)(span_ms * loops * rate_Hz / 1000.0) + 1;
+  out.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    double t_ms = (double)i * 1000.0 / rate_Hz;
+    float true_uA = (float)(ref.current_mA(fmod(t_ms, span_ms)) * 1000.0);
+    float reading = true_uA + noise_uA * gaussian();
+    int32_t quantized = (int32_t)lroundf(reading / lsb_uA) * (int32_t)lroundf(lsb_uA);
+    out.push_back({ (uint32_t)(uint64_t)(t_ms * 1000.0), quantized });
+  }
+  return out;
+}
+
+static void markFrontier(std::vector<Result>& results) {
+  for (Result& a : results) {
+    a.frontier = true;
+    for (const Result& b : results) {
+      bool noWorse = b.maxError_percent <= a.maxError_percent && b.ns_per_sample <= a.ns_per_sample;
+      bool better = b.maxError_percent < a.maxError_percent || b.ns_per_sample < a.ns_per_sample;
+      if (&a != &b && noWorse && better) {
+        a.frontier = false;
+        break;
+      }
+    }
+  }
+}
+
+static void print(const Result& r) {
+  char line[320];
+  JsonWriter out(line, sizeof(line));
+  out.beginObject()
+      .field("config", r.config)
+      .field("filter", r.filter)
+      .field("rate_Hz", r.rate_Hz)
+      .field("samples", (uint64_t)r.samples)
+      .field("drift_percent", (float)r.drift_percent, 6)
+      .field("max_error_percent", (float)r.maxError_percent, 6)
+      .field("ns_per_sample", (float)r.ns_per_sample, 2);
+  if (r.cycles_per_sample >= 0.0) out.field("cycles_per_sample", (float)r.cycles_per_sample, 1);
+  out.field("frontier", r.frontier).endObject();
+  puts(line);
+}
+
+static int usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [trace.csv ...] [--rates 1,10,100,1000] [--noise-uA F] [--lsb-uA F] [--capacity-mAh F] "
+          "[--loops N] [--seed S]\n",
+          argv0);
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  std::vector<uint32_t> rates = { 1, 10, 100, 1000 };
+  std::vector<const char*> paths;
+  float noise_uA = DEFAULT_NOISE_uA;
+  float lsb_uA = DEFAULT_LSB_uA;
+  float capacity_mAh = DEFAULT_CAPACITY_mAh;
+  uint32_t loops = 1;
+  uint32_t seed = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--rates" && hasValue) {
+      rates.clear();
+      for (char* p = argv[++i]; *p;) {
+        uint32_t hz = (uint32_t)strtoul(p, &p, 10);
+        if (hz) rates.push_back(hz);
+        if (*p) ++p;
+      }
+    } else if (arg == "--noise-uA" && hasValue) {
+      noise_uA = strtof(argv[++i], nullptr);
+    } else if (arg == "--lsb-uA" && hasValue) {
+      lsb_uA = strtof(argv[++i], nullptr);
+    } else if (arg == "--capacity-mAh" && hasValue) {
+      capacity_mAh = strtof(argv[++i], nullptr);
+    } else if (arg == "--loops" && hasValue) {
+      loops = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--seed" && hasValue) {
+      seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg[0] != '-') {
+      paths.push_back(argv[i]);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (rates.empty() || loops == 0 || lsb_uA < 1.0f || capacity_mAh <= 0.0f) return usage(argv[0]);
+
+  // Several logs are joined end to end on a common clock.
+  std::vector<TracePoint> trace;
+  for (const char* path : paths) {
+    std::vector<TracePoint> part;
+    if (!loadTrace(path, part)) {
+      fprintf(stderr, "cannot read %s\n", path);
+      return 1;
+    }
+    uint32_t offset = trace.empty() ? 0 : trace.back().t_ms + 1000;
+    for (TracePoint p : part) {
+      p.t_ms = p.t_ms - part.front().t_ms + offset;
+      trace.push_back(p);
+    }
+  }
+  if (paths.empty()) synthesizeTrace(trace);
+  if (trace.size() < 2) {
+    fprintf(stderr, "trace needs at least two rows\n");
+    return 1;
+  }
+
+  ReferenceCharge ref(trace);
+  printf("{\"trace_rows\":%u,\"span_s\":%.1f,\"loops\":%u,\"reference_mAh\":%.4f,\"noise_uA\":%.1f,\"lsb_uA\":%.1f}\n",
+         (unsigned)trace.size(), ref.span_ms() / 1000.0, (unsigned)loops, ref.total_uAs() * loops / 3.6e6, noise_uA,
+         lsb_uA);
+
+  std::vector<Result> results;
+  for (uint32_t hz : rates) {
+    rng = seed ? seed : 1;
+    std::vector<Measurement> samples = measure(ref, hz, loops, noise_uA, lsb_uA);
+    results.push_back(run<TrapezoidFixed>("trapezoid_fixed", "none", hz, samples, ref, capacity_mAh));
+    results.push_back(run<TrapezoidFloat>("trapezoid_float", "none", hz, samples, ref, capacity_mAh));
+    results.push_back(run<RectangleFloat>("rectangle_float", "none", hz, samples, ref, capacity_mAh));
+    results.push_back(run<Ema8Fixed>("trapezoid_fixed", "ema8", hz, samples, ref, capacity_mAh));
+  }
+  markFrontier(results);
+  for (const Result& r : results) print(r);
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "trace_csv.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+// The raw_payload column: the last field, CSV-quoted, with "" for ".
+static bool rawPayload(const char* line, std::string& json) {
+  const char* start = strstr(line, "\"{");
+  if (!start) return false;
+  json.clear();
+  for (const char* p = start + 1; *p; ++p) {
+    if (*p == '"') {
+      if (p[1] != '"') break;
+      ++p;
+    }
+    json += *p;
+  }
+  return true;
+}
+
+// Number after "key": in a flat JSON object.
+static bool jsonNumber(const std::string& json, const char* key, float& out) {
+  std::string pattern = std::string("\"") + key + "\":";
+  size_t at = json.find(pattern);
+  if (at == std::string::npos) return false;
+  const char* begin = json.c_str() + at + pattern.size();
+  char* end;
+  out = strtof(begin, &end);
+  return end != begin;
+}
+
+bool loadTrace(const char* path, std::vector<TracePoint>& trace) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[2048];
+  std::string json;
+  while (fgets(line, sizeof(line), f)) {
+    TracePoint p;
+    float uptime, current_A, power_W;
+    // The header and rows from other topics (binary, diag) have no bus_V.
+    if (!rawPayload(line, json) || !jsonNumber(json, "uptime_ms", uptime) || !jsonNumber(json, "bus_V", p.bus_V)) {
+      continue;
+    }
+    if (!jsonNumber(json, "shunt_mV", p.shunt_mV)) p.shunt_mV = 0.0f;
+    p.t_ms = (uint32_t)uptime;
+    p.current_mA = jsonNumber(json, "current_A", current_A) ? current_A * 1000.0f : p.shunt_mV / TRACE_SHUNT_OHMS;
+    p.power_mW = jsonNumber(json, "power_W", power_W) ? power_W * 1000.0f : fabsf(p.bus_V * p.current_mA);
+    if (!jsonNumber(json, "soc_percent", p.soc_percent)) p.soc_percent = NAN;
+    if (!trace.empty() && p.t_ms <= trace.back().t_ms) continue;
+    trace.push_back(p);
+  }
+  fclose(f);
+  return true;
+}
+
+void synthesizeTrace(std::vector<TracePoint>& trace) {
+  for (uint32_t t_ms = 0; t_ms <= 600000; t_ms += 500) {
+    uint32_t phase = t_ms % 60000;
+    float current_mA = phase < 30000 ? (phase < 500 ? 2500.0f : 1200.0f) : 50.0f;
+    float bus_V = 3.7f - current_mA * 0.0001f - t_ms * 2e-7f;
+    trace.push_back({ t_ms, bus_V, current_mA * TRACE_SHUNT_OHMS, current_mA, bus_V * current_mA, NAN });
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+// Telemetry traces as the server logs them (server/mqtt_to_csv.py,
+// bms_data.csv, battery_data.csv). Rows are read from their raw_payload
+// column, the JSON the device published, so every CSV layout works as long
+// as it keeps that column; rows from other topics are skipped.
+struct TracePoint {
+  uint32_t t_ms;        // device uptime
+  float bus_V;
+  float shunt_mV;
+  float current_mA;     // positive = discharge
+  float power_mW;
+  float soc_percent;    // what the device reported; NAN if missing
+};
+
+static const float TRACE_SHUNT_OHMS = 0.1f;   // INA219 breakout; stands in when current_A is missing
+
+// Appends the rows of path in uptime order (restarts and repeats are dropped).
+bool loadTrace(const char* path, std::vector<TracePoint>& trace);
+// 10 minutes of a 3.7 V cell: 30 s at 1.2 A, 30 s at 50 mA, with 2.5 A
+// inrush spikes at the start of each burst.
+void synthesizeTrace(std::vector<TracePoint>& trace);
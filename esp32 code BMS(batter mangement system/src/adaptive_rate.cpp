@@ -0,0 +1,44 @@
+#include "adaptive_rate.h"
+
+#include <stdlib.h>
+
+void AdaptiveRate::begin(uint32_t minHz, uint32_t maxHz) {
+  _minHz = minHz ? minHz : 1;
+  _maxHz = maxHz > _minHz ? maxHz : _minHz;
+  _rateHz = _maxHz;
+  _primed = false;
+}
+
+void AdaptiveRate::setMaxHz(uint32_t maxHz) {
+  _maxHz = maxHz ? maxHz : 1;
+  if (_minHz > _maxHz) _minHz = _maxHz;
+  if (_rateHz > _maxHz) _rateHz = _maxHz;
+}
+
+void AdaptiveRate::setThresholds(float current_mA, float slew_mA_per_s, uint32_t hold_ms) {
+  _current_uA = (int32_t)(current_mA * 1000.0f);
+  _slew_uA_per_s = (int64_t)(slew_mA_per_s * 1000.0f);
+  _hold_us = hold_ms * 1000UL;
+}
+
+uint32_t AdaptiveRate::update(const PowerSample& s) {
+  if (!_primed) {
+    _primed = true;
+    _quietSince_us = s.t_us;
+  } else {
+    uint32_t dt_us = s.t_us - _lastT_us;
+    // |dI| / dt >= slew, cross-multiplied to stay in integers
+    int64_t dI_uA = llabs((int64_t)s.current_uA - _lastCurrent_uA);
+    bool slewing = dt_us && dI_uA * 1000000 >= _slew_uA_per_s * dt_us;
+    if (labs(s.current_uA) >= _current_uA || slewing) {
+      _rateHz = _maxHz;
+      _quietSince_us = s.t_us;
+    } else if (s.t_us - _quietSince_us >= _hold_us && _rateHz > _minHz) {
+      _rateHz = _rateHz / 2 > _minHz ? _rateHz / 2 : _minHz;
+      _quietSince_us = s.t_us;
+    }
+  }
+  _lastT_us = s.t_us;
+  _lastCurrent_uA = s.current_uA;
+  return _rateHz;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "power_sample.h"
+
+// Sample-rate policy for the Sampler: full rate while the battery is busy,
+// decaying towards a floor while it idles.
+//
+// A sample is "active" when |I| or |dI/dt| (against the previous sample)
+// reaches its threshold; that jumps straight to maxHz so a load step is
+// caught at the next tick. After hold_ms without activity the rate halves,
+// and keeps halving every further hold_ms down to minHz.
+class AdaptiveRate {
+public:
+  void begin(uint32_t minHz, uint32_t maxHz);
+  // New ceiling (the floor follows if above it); the current rate is clamped.
+  void setMaxHz(uint32_t maxHz);
+  // Defaults: 500 mA, 2000 mA/s, 2 s.
+  void setThresholds(float current_mA, float slew_mA_per_s, uint32_t hold_ms);
+
+  // Feeds one sample; returns the rate to run at from now on.
+  uint32_t update(const PowerSample& s);
+  uint32_t rateHz() const { return _rateHz; }
+
+private:
+  uint32_t _minHz = 1;
+  uint32_t _maxHz = 1;
+  uint32_t _rateHz = 1;
+  int32_t _current_uA = 500000;
+  int64_t _slew_uA_per_s = 2000000;
+  uint32_t _hold_us = 2000000;
+
+  uint32_t _quietSince_us = 0;   // last activity or rate step down
+  uint32_t _lastT_us = 0;
+  int32_t _lastCurrent_uA = 0;
+  bool _primed = false;
+};
@@ -0,0 +1,89 @@
+#include "aggregator.h"
+
+void TelemetryWindow::reset() {
+  _v.reset();
+  _i.reset();
+  _p.reset();
+  // The next window starts at this one's last sample, so the interval
+  // between the two is booked to the next window's energy and duration.
+  _energy.restart();
+  _startT = _lastT;
+  _count = 0;
+  _minRate = 0;
+  _maxRate = 0;
+  _rawCount = 0;
+}
+
+void TelemetryWindow::add(const PowerSample& s) {
+  // Trapezoidal energy between consecutive samples, in integer uW * us.
+  _energy.add(s.t_us, s.power_uW);
+  if (!_count) _firstT = s.t_us;
+  if (!_seen) _startT = s.t_us;
+  _seen = true;
+  _lastT = s.t_us;
+
+  // Same units as the payload: V, A, W; one-off reads (rate 0) weigh 1 s
+  float w = s.rate_Hz ? 1.0f / s.rate_Hz : 1.0f;
+  _v.add(s.bus_uV * 1e-6f, w);
+  _i.add(s.current_uA * 1e-6f, w);
+  _p.add(s.power_uW * 1e-6f, w);
+  if (!_count || s.rate_Hz < _minRate) _minRate = s.rate_Hz;
+  if (s.rate_Hz > _maxRate) _maxRate = s.rate_Hz;
+
+  if (_count % _rawStride == 0 && _rawCount < RAW_CAPACITY) _raw[_rawCount++] = s;
+  _count++;
+  _last = s;
+}
+
+static void writeStats(JsonWriter& w, const char* key, const ChannelStats& c) {
+  w.beginObject(key)
+      .field("min", c.min(), 3)
+      .field("max", c.max(), 3)
+      .field("mean", c.mean(), 3)
+      .field("std", c.stddev(), 3)
+      .field("rms", c.rms(), 3)
+      .endObject();
+}
+
+// Means under the legacy keys so existing consumers keep working.
+void TelemetryWindow::writeMeans(JsonWriter& w, uint8_t channels) const {
+  if (channels & CHANNEL_V) w.field("bus_V", _v.mean(), 3);
+  if (channels & CHANNEL_I) w.field("current_A", _i.mean(), 3);
+  if (channels & CHANNEL_P) w.field("power_W", _p.mean(), 3);
+  w.field("n", _count)
+      .field("window_ms", duration_us() / 1000)
+      .field("energy_mWh", energy_mWh(), 4);
+  // Rates the window was sampled at (adaptive sampling)
+  if (_maxRate) w.field("rate_min_Hz", (uint32_t)_minRate).field("rate_max_Hz", (uint32_t)_maxRate);
+}
+
+void TelemetryWindow::writeAggregate(JsonWriter& w, uint8_t channels) const {
+  writeMeans(w, channels);
+  if (!_count) return;
+  if (channels & CHANNEL_V) writeStats(w, "v_stats", _v);
+  if (channels & CHANNEL_I) writeStats(w, "i_stats", _i);
+  if (channels & CHANNEL_P) writeStats(w, "p_stats", _p);
+}
+
+void TelemetryWindow::writeRaw(JsonWriter& w, uint8_t channels) const {
+  writeMeans(w, channels);
+  w.field("raw_n", (uint32_t)_rawCount).field("raw_stride", _rawStride);
+  w.beginArray("t_ms");
+  for (size_t k = 0; k < _rawCount; ++k) w.value((int32_t)((_raw[k].t_us - _firstT) / 1000));
+  w.endArray();
+  if (channels & CHANNEL_V) {
+    w.beginArray("v");
+    for (size_t k = 0; k < _rawCount; ++k) w.value(_raw[k].bus_uV * 1e-6f, 3);
+    w.endArray();
+  }
+  if (channels & CHANNEL_I) {
+    w.beginArray("i");
+    for (size_t k = 0; k < _rawCount; ++k) w.value(_raw[k].current_uA * 1e-6f, 3);
+    w.endArray();
+  }
+  if (channels & CHANNEL_P) {
+    w.beginArray("p");
+    for (size_t k = 0; k < _rawCount; ++k) w.value(_raw[k].power_uW * 1e-6f, 3);
+    w.endArray();
+  }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json_writer.h"
+#include "power_sample.h"
+#include "stream_stats.h"
+
+// How loop() turns sampler output into MQTT messages on PUB_TOPIC.
+enum class PublishMode : uint8_t {
+  Latest,      // one message per PUBLISH_INTERVAL with the most recent sample (legacy)
+  Aggregate,   // min/max/mean/RMS per channel over the window
+  RawBatch,    // window means plus decimated raw samples as columnar arrays
+};
+
+// Channels a report carries (report_filter.h); the writers below leave the
+// others out. CHANNEL_SOC is the caller's soc_percent / soh_percent.
+enum ReportChannel : uint8_t {
+  CHANNEL_V = 1,
+  CHANNEL_I = 2,   // current_A (and shunt_mV where it is sent)
+  CHANNEL_P = 4,
+  CHANNEL_SOC = 8,
+  CHANNEL_ALL = 0x0F,
+};
+
+// Running min/max/mean/variance for one channel (stream_stats.h). Samples
+// are weighted by the time they stand for, so means stay fair when the rate
+// changes.
+struct ChannelStats {
+  PeakHold<float> peak;
+  Welford<float> moments;
+
+  void reset() {
+    peak.reset();
+    moments.reset();
+  }
+  void add(float x, float w = 1.0f) {
+    peak.add(x);
+    moments.add(x, w);
+  }
+  float min() const { return peak.min; }
+  float max() const { return peak.max; }
+  float mean() const { return moments.mean(); }
+  float stddev() const { return moments.stddev(); }
+  float rms() const { return moments.rms(); }
+};
+
+// Accumulates every sample of one publish window.
+//
+// Each sample is weighted by its period (1 / rate_Hz), so adaptive-rate
+// bursts do not dominate the window statistics. Each add() is O(1); raw samples for RawBatch mode are decimated into a
+// fixed array so the window costs the same RAM at any sample rate.
+class TelemetryWindow {
+public:
+  static const size_t RAW_CAPACITY = 32;
+
+  void reset();
+  void add(const PowerSample& s);
+  // Keep every stride-th sample for RawBatch (1 = all, until full).
+  void setRawStride(uint32_t stride) { _rawStride = stride ? stride : 1; }
+
+  uint32_t count() const { return _count; }
+  // From the previous window's last sample (or this one's first, for the
+  // very first window) to this window's last sample.
+  uint32_t duration_us() const { return _count ? _lastT - _startT : 0; }
+  // t_us of the first sample; valid when count() > 0.
+  uint32_t start_us() const { return _firstT; }
+  float energy_mWh() const { return (float)_energy.area2_us() * MWH_PER_2UWUS; }
+  const PowerSample& last() const { return _last; }
+  const PowerSample* raw() const { return _raw; }
+  size_t rawCount() const { return _rawCount; }
+
+  const ChannelStats& voltage() const { return _v; }
+  const ChannelStats& current() const { return _i; }
+  const ChannelStats& power() const { return _p; }
+
+  // Writes the window's fields into an open JSON object: the chosen
+  // channels' means, stats or raw columns, and always the window's own
+  // fields (n, window_ms, energy, rates).
+  void writeAggregate(JsonWriter& w, uint8_t channels = CHANNEL_ALL) const;
+  void writeRaw(JsonWriter& w, uint8_t channels = CHANNEL_ALL) const;
+
+private:
+  void writeMeans(JsonWriter& w, uint8_t channels) const;
+
+  // 1 mWh = 3.6e12 uW*us; the accumulator holds twice the trapezoid area
+  static constexpr float MWH_PER_2UWUS = 1.0f / 7.2e12f;
+
+  ChannelStats _v, _i, _p;
+  TimeIntegral<int32_t> _energy;   // power_uW, exact
+  uint32_t _count = 0;
+  uint16_t _minRate = 0;
+  uint16_t _maxRate = 0;
+  uint32_t _firstT = 0;
+  uint32_t _startT = 0;
+  uint32_t _lastT = 0;
+  bool _seen = false; // any sample since boot; _lastT is valid
+  PowerSample _last = {};
+
+  PowerSample _raw[RAW_CAPACITY];
+  size_t _rawCount = 0;
+  uint32_t _rawStride = 1;
+};
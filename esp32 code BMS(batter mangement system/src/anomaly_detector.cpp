@@ -0,0 +1,96 @@
+#include "anomaly_detector.h"
+
+#include <math.h>
+
+void AnomalyDetector::begin(const AnomalyLimits& limits) {
+  _limits = limits;
+  _alpha = 1.0f / (limits.baselineSamples ? limits.baselineSamples : 1);
+  _current = Baseline();
+  _voltage = Baseline();
+  _current.floor = limits.currentFloor_uA * 1e-6f;
+  _voltage.floor = limits.voltageFloor_uV * 1e-6f;
+  _samples = 0;
+  _socPrimed = false;
+}
+
+void AnomalyDetector::add(uint32_t t_us, int32_t battery_uV, int32_t current_uA) {
+  float i = current_uA * 1e-6f;
+  float v = battery_uV * 1e-6f;
+  if (!_samples) {
+    _current.mean = i;
+    _voltage.mean = v;
+  }
+  if (_samples >= _limits.baselineSamples) {
+    score(_current, AnomalyKind::Current, t_us, i);
+    score(_voltage, AnomalyKind::Voltage, t_us, v);
+  } else {
+    _samples++;
+  }
+  // West's exponentially weighted update: variance of the deviation from the old mean
+  Baseline* channels[2] = { &_current, &_voltage };
+  float x[2] = { i, v };
+  for (uint8_t k = 0; k < 2; ++k) {
+    Baseline& b = *channels[k];
+    float d = x[k] - b.mean;
+    b.mean += _alpha * d;
+    b.var = (1.0f - _alpha) * (b.var + _alpha * d * d);
+  }
+}
+
+void AnomalyDetector::score(Baseline& b, AnomalyKind kind, uint32_t t_us, float x) {
+  float sigma = sqrtf(b.var);
+  if (sigma < b.floor) sigma = b.floor;
+  float z = sigma > 0.0f ? (x - b.mean) / sigma : 0.0f;
+  float mag = fabsf(z);
+  if (!b.active) {
+    b.beyond = mag > _limits.z ? b.beyond + 1 : 0;
+    if (b.beyond < _limits.holdSamples) return;
+    b.active = true;
+    b.within = 0;
+  } else {
+    b.within = mag < _limits.z * 0.5f ? b.within + 1 : 0;
+    if (b.within < _limits.holdSamples) return;
+    b.active = false;
+    b.beyond = 0;
+  }
+  Alert a = { t_us, kind, b.active, x, b.mean, z };
+  raise(a);
+}
+
+void AnomalyDetector::checkSoc(uint32_t t_us, float soc_percent, float coulomb_percent) {
+  float step = soc_percent - _lastSoc;
+  float counted = coulomb_percent - _lastCoulomb;
+  bool primed = _socPrimed;
+  _socPrimed = true;
+  _lastSoc = soc_percent;
+  _lastCoulomb = coulomb_percent;
+  if (!primed || _limits.socJump_percent <= 0.0f || fabsf(step - counted) <= _limits.socJump_percent) return;
+  Alert a = { t_us, AnomalyKind::SocJump, true, step, counted, 0.0f };
+  raise(a);
+}
+
+void AnomalyDetector::raise(const Alert& a) {
+  if (a.raised) _raised++;
+  if (!_alerts.push(a)) _dropped++;
+}
+
+const char* AnomalyDetector::kindName(AnomalyKind kind) {
+  switch (kind) {
+    case AnomalyKind::Current: return "current";
+    case AnomalyKind::Voltage: return "voltage";
+    case AnomalyKind::SocJump: return "soc_jump";
+  }
+  return "unknown";
+}
+
+void AnomalyDetector::writeJson(JsonWriter& w) const {
+  w.beginObject("anomaly")
+      .field("current_A", _current.mean, 3)
+      .field("current_sigma_A", sqrtf(_current.var), 4)
+      .field("voltage_V", _voltage.mean, 3)
+      .field("voltage_sigma_V", sqrtf(_voltage.var), 4)
+      .beginArray("active");
+  if (_current.active) w.value(kindName(AnomalyKind::Current));
+  if (_voltage.active) w.value(kindName(AnomalyKind::Voltage));
+  w.endArray().field("raised", _raised).field("alerts_dropped", _dropped).endObject();
+}
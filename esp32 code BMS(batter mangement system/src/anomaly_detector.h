@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "json_writer.h"
+#include "ring_buffer.h"
+
+// What an alert is about.
+enum class AnomalyKind : uint8_t {
+  Current,   // draw far from its recent baseline
+  Voltage,   // terminal voltage far from its recent baseline
+  SocJump,   // the SoC estimate stepped more than the counted charge explains
+};
+
+struct AnomalyLimits {
+  float z;                    // |x - baseline| / sigma that counts as abnormal
+  uint16_t holdSamples;       // in a row past z to raise, and back within z / 2 to clear
+  uint16_t baselineSamples;   // EWMA time constant (and warm-up), in samples
+  int32_t currentFloor_uA;    // sigma never below this: a steady load's noise is no baseline
+  int32_t voltageFloor_uV;
+  float socJump_percent;      // per window, 0 = off
+};
+
+// Streaming anomaly flags, so abnormal draw is raised on the device instead
+// of being searched for in exported history.
+//
+// Current and terminal voltage each keep an exponentially weighted mean
+// and variance (one multiply-add each per sample, no buffer). A sample is
+// scored against the baseline before it is folded in; holdSamples in a row
+// beyond z raise an alert, as many back within z / 2 clear it. The baseline
+// keeps learning while raised, so a lasting change of load is flagged once
+// and then becomes the new normal. Nothing is scored during the warm-up.
+//
+// checkSoc() runs once per window: the estimate's step is compared with
+// the coulomb count's, so an EKF correction, a restored checkpoint or a
+// capacity change that moves the published SoC by more than socJump_percent
+// without the charge to show for it is raised (there is nothing to clear).
+//
+// Alerts are queued (estimation task in, network task out) for immediate
+// publication; a full queue drops the newest and counts it.
+class AnomalyDetector {
+public:
+  struct Alert {
+    uint32_t t_us;      // acquisition time of the deciding sample (window close for SoC)
+    AnomalyKind kind;
+    bool raised;        // false: back to normal
+    float value;        // A or V; the SoC step in %
+    float baseline;     // A or V; the coulomb count's step in %
+    float z;            // 0 for SocJump
+  };
+
+  void begin(const AnomalyLimits& limits);
+  // Estimation task, every sample: battery terminal voltage, signed current.
+  void add(uint32_t t_us, int32_t battery_uV, int32_t current_uA);
+  // Estimation task, once per window: the published SoC and the coulomb count.
+  void checkSoc(uint32_t t_us, float soc_percent, float coulomb_percent);
+  // The next checkSoc() only primes (after a deliberate jump, e.g. new config).
+  void resetSoc() { _socPrimed = false; }
+
+  // Network task
+  bool takeAlert(Alert& out) { return _alerts.pop(out); }
+  static const char* kindName(AnomalyKind kind);
+
+  // "anomaly": {"current_A", "current_sigma_A", "voltage_V", "voltage_sigma_V",
+  // "active": [..], "raised", "alerts_dropped"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  // EWMA mean and variance of one channel, in its payload unit
+  struct Baseline {
+    float mean = 0.0f;
+    float var = 0.0f;
+    float floor = 0.0f;
+    uint16_t beyond = 0;   // samples in a row past z
+    uint16_t within = 0;   // ... back within z / 2 while active
+    bool active = false;
+  };
+
+  void score(Baseline& b, AnomalyKind kind, uint32_t t_us, float x);
+  void raise(const Alert& a);
+
+  AnomalyLimits _limits = {};
+  float _alpha = 0.0f;
+  uint32_t _samples = 0;
+  Baseline _current;
+  Baseline _voltage;
+  bool _socPrimed = false;
+  float _lastSoc = 0.0f;
+  float _lastCoulomb = 0.0f;
+
+  SpscRing<Alert, 8> _alerts;
+  uint32_t _raised = 0;
+  uint32_t _dropped = 0;
+};
@@ -0,0 +1,309 @@
+#include "binary_codec.h"
+
+#include <math.h>
+
+namespace {
+
+uint32_t zigzag32(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+int32_t unzigzag32(uint32_t z) { return (int32_t)(z >> 1) ^ -(int32_t)(z & 1); }
+
+// Bounds-checked little-endian byte sink.
+struct Sink {
+  uint8_t* out;
+  size_t cap;
+  size_t len;
+  bool overflow;
+
+  void u8(uint8_t v) {
+    if (len >= cap) {
+      overflow = true;
+      return;
+    }
+    out[len++] = v;
+  }
+  void u16(uint16_t v) {
+    u8(v & 0xFF);
+    u8(v >> 8);
+  }
+  void u32(uint32_t v) {
+    u16(v & 0xFFFF);
+    u16(v >> 16);
+  }
+  void u64(uint64_t v) {
+    u32((uint32_t)v);
+    u32((uint32_t)(v >> 32));
+  }
+  void varint(uint32_t v) {
+    while (v >= 0x80) {
+      u8((uint8_t)(v | 0x80));
+      v >>= 7;
+    }
+    u8((uint8_t)v);
+  }
+  void zigzag(int32_t v) { varint(zigzag32(v)); }
+  void record(const SampleRecord& r) {
+    u16(r.bus_mV);
+    u16((uint16_t)r.shunt_10uV);
+    u32((uint32_t)r.current_uA);
+    u32(r.power_uW);
+  }
+  size_t result() const { return overflow ? 0 : len; }
+};
+
+// MSB-first bit packer on top of a Sink; flush() pads the last byte.
+struct BitSink {
+  Sink& s;
+  uint64_t acc;
+  uint8_t pending;
+
+  void put(uint32_t v, uint8_t width) {
+    acc = (acc << width) | (v & ((1ULL << width) - 1));
+    pending += width;
+    while (pending >= 8) {
+      pending -= 8;
+      s.u8((uint8_t)(acc >> pending));
+    }
+    acc &= (1U << pending) - 1;
+  }
+  void flush() {
+    if (pending) s.u8((uint8_t)(acc << (8 - pending)));
+    pending = 0;
+  }
+};
+
+struct BitSource {
+  const uint8_t* data;
+  size_t len;
+  size_t bit;
+
+  bool get(uint8_t width, uint32_t& v) {
+    if (bit + width > len * 8) return false;
+    v = 0;
+    for (uint8_t k = 0; k < width; ++k, ++bit) v = (v << 1) | ((data[bit >> 3] >> (7 - (bit & 7))) & 1);
+    return true;
+  }
+};
+
+void putSpacing(BitSink& b, int32_t dod) {
+  uint32_t z = zigzag32(dod);
+  if (z == 0) {
+    b.put(0, 1);
+  } else if (z < (1U << 7)) {
+    b.put(0x2, 2);
+    b.put(z, 7);
+  } else if (z < (1U << 9)) {
+    b.put(0x6, 3);
+    b.put(z, 9);
+  } else if (z < (1U << 12)) {
+    b.put(0xE, 4);
+    b.put(z, 12);
+  } else {
+    b.put(0xF, 4);
+    b.put(z, 32);
+  }
+}
+
+// Reuses the field's previous width while that is no dearer than declaring
+// a new one (7 bits of prefix), so a lone spike does not inflate the run
+// of small deltas that follows it.
+void putDelta(BitSink& b, int32_t delta, uint8_t& width) {
+  uint32_t z = zigzag32(delta);
+  if (z == 0) {
+    b.put(0, 1);
+    return;
+  }
+  uint8_t need = 32 - __builtin_clz(z);
+  if (need <= width && width <= need + 5) {
+    b.put(0x2, 2);
+    b.put(z, width);
+    return;
+  }
+  b.put(0x3, 2);
+  b.put(need - 1, 5);
+  b.put(z, need);
+  width = need;
+}
+
+bool getSpacing(BitSource& b, int32_t& dod) {
+  static const uint8_t WIDTHS[] = {7, 9, 12, 32};
+  uint32_t bit, z;
+  uint8_t ones = 0;
+  while (ones < 4) {
+    if (!b.get(1, bit)) return false;
+    if (!bit) break;
+    ones++;
+  }
+  if (ones == 0) {
+    dod = 0;
+    return true;
+  }
+  if (!b.get(WIDTHS[ones - 1], z)) return false;
+  dod = unzigzag32(z);
+  return true;
+}
+
+bool getDelta(BitSource& b, int32_t& delta, uint8_t& width) {
+  uint32_t bit, z;
+  if (!b.get(1, bit)) return false;
+  if (!bit) {
+    delta = 0;
+    return true;
+  }
+  if (!b.get(1, bit)) return false;
+  if (bit) {
+    uint32_t w;
+    if (!b.get(5, w)) return false;
+    width = (uint8_t)(w + 1);
+  } else if (!width) {
+    return false;
+  }
+  if (!b.get(width, z)) return false;
+  delta = unzigzag32(z);
+  return true;
+}
+
+uint16_t percent100(float pct) {
+  if (!(pct > 0.0f)) return 0;
+  if (pct > 100.0f) pct = 100.0f;
+  return (uint16_t)lroundf(pct * 100.0f);
+}
+
+void header(Sink& s, TelemetryKind kind, uint16_t count, uint32_t t0_ms, uint64_t utc0_ms, float soc, float soh) {
+  s.u8(TELEMETRY_SCHEMA_VERSION);
+  s.u8((uint8_t)kind);
+  s.u16(count);
+  s.u32(t0_ms);
+  s.u16(percent100(soc));
+  s.u16(percent100(soh));
+  s.u64(utc0_ms);
+}
+
+// Zigzag-varint field deltas of one sample against the previous one.
+void deltas(Sink& s, const SampleRecord& cur, const SampleRecord& prev) {
+  s.zigzag((int32_t)cur.bus_mV - (int32_t)prev.bus_mV);
+  s.zigzag((int32_t)cur.shunt_10uV - (int32_t)prev.shunt_10uV);
+  s.zigzag((int32_t)((uint32_t)cur.current_uA - (uint32_t)prev.current_uA));
+  s.zigzag((int32_t)(cur.power_uW - prev.power_uW));
+}
+
+}  // namespace
+
+SampleRecord toRecord(const PowerSample& s) {
+  SampleRecord r;
+  int32_t bus_mV = (s.bus_uV + 500) / 1000;
+  r.bus_mV = bus_mV <= 0 ? 0 : (bus_mV >= 65535 ? 65535 : (uint16_t)bus_mV);
+  r.shunt_10uV = (int16_t)(s.shunt_uV / 10);   // exact: the register LSB is 10 uV
+  r.current_uA = s.current_uA;
+  r.power_uW = s.power_uW <= 0 ? 0 : (uint32_t)s.power_uW;
+  return r;
+}
+
+size_t encodeSingle(uint8_t* out, size_t cap, const PowerSample& sample, uint32_t t_ms, uint64_t utc_ms,
+                    float soc_percent, float soh_percent) {
+  Sink s = {out, cap, 0, false};
+  header(s, TelemetryKind::Single, 1, t_ms, utc_ms, soc_percent, soh_percent);
+  s.record(toRecord(sample));
+  return s.result();
+}
+
+size_t encodeDeltaBatch(uint8_t* out, size_t cap, const PowerSample* samples, size_t count, uint32_t t0_ms,
+                        uint64_t utc0_ms, float soc_percent, float soh_percent) {
+  if (count == 0 || count > 0xFFFF) return 0;
+  Sink s = {out, cap, 0, false};
+  header(s, TelemetryKind::DeltaBatch, (uint16_t)count, t0_ms, utc0_ms, soc_percent, soh_percent);
+
+  SampleRecord prev = toRecord(samples[0]);
+  uint32_t prevMs = 0;
+  s.record(prev);
+  for (size_t k = 1; k < count && !s.overflow; ++k) {
+    SampleRecord cur = toRecord(samples[k]);
+    // Offsets are quantized against t0 so ms rounding never accumulates.
+    uint32_t ms = (samples[k].t_us - samples[0].t_us) / 1000;
+    s.varint(ms - prevMs);
+    prevMs = ms;
+    deltas(s, cur, prev);
+    prev = cur;
+  }
+  return s.result();
+}
+
+size_t encodePackedBatch(uint8_t* out, size_t cap, const PowerSample* samples, size_t count, uint32_t t0_ms,
+                         uint64_t utc0_ms, float soc_percent, float soh_percent) {
+  if (count == 0 || count > 0xFFFF) return 0;
+  Sink s = {out, cap, 0, false};
+  header(s, TelemetryKind::PackedBatch, (uint16_t)count, t0_ms, utc0_ms, soc_percent, soh_percent);
+
+  SampleRecord prev = toRecord(samples[0]);
+  s.record(prev);
+  BitSink b = {s, 0, 0};
+  uint32_t prevMs = 0;
+  uint32_t prevDt = 0;
+  uint8_t widths[4] = {0, 0, 0, 0};
+  for (size_t k = 1; k < count && !s.overflow; ++k) {
+    SampleRecord cur = toRecord(samples[k]);
+    uint32_t ms = (samples[k].t_us - samples[0].t_us) / 1000;
+    uint32_t dt = ms - prevMs;
+    putSpacing(b, (int32_t)(dt - prevDt));
+    prevMs = ms;
+    prevDt = dt;
+    putDelta(b, (int32_t)cur.bus_mV - (int32_t)prev.bus_mV, widths[0]);
+    putDelta(b, (int32_t)cur.shunt_10uV - (int32_t)prev.shunt_10uV, widths[1]);
+    putDelta(b, (int32_t)((uint32_t)cur.current_uA - (uint32_t)prev.current_uA), widths[2]);
+    putDelta(b, (int32_t)(cur.power_uW - prev.power_uW), widths[3]);
+    prev = cur;
+  }
+  b.flush();
+  return s.result();
+}
+
+size_t encodeEvent(uint8_t* out, size_t cap, const PowerSample* samples, size_t count, size_t triggerIndex,
+                   uint8_t cause, uint32_t t0_ms, uint64_t utc0_ms, float soc_percent, float soh_percent) {
+  if (count == 0 || count > 0xFFFF || triggerIndex >= count) return 0;
+  Sink s = {out, cap, 0, false};
+  header(s, TelemetryKind::Event, (uint16_t)count, t0_ms, utc0_ms, soc_percent, soh_percent);
+  s.u8(cause);
+  s.u16((uint16_t)triggerIndex);
+
+  SampleRecord prev = toRecord(samples[0]);
+  s.record(prev);
+  for (size_t k = 1; k < count && !s.overflow; ++k) {
+    SampleRecord cur = toRecord(samples[k]);
+    s.varint(samples[k].t_us - samples[k - 1].t_us);
+    deltas(s, cur, prev);
+    prev = cur;
+  }
+  return s.result();
+}
+
+size_t decodePackedBatch(const uint8_t* data, size_t len, SampleRecord* records, uint32_t* offsets_ms, size_t cap) {
+  if (len < TELEMETRY_HEADER_SIZE + SAMPLE_RECORD_SIZE || data[1] != (uint8_t)TelemetryKind::PackedBatch) return 0;
+  size_t count = data[2] | (size_t)data[3] << 8;
+  if (count == 0 || count > cap) return 0;
+  const uint8_t* r = data + TELEMETRY_HEADER_SIZE;
+  SampleRecord prev;
+  prev.bus_mV = (uint16_t)(r[0] | r[1] << 8);
+  prev.shunt_10uV = (int16_t)(r[2] | r[3] << 8);
+  prev.current_uA = (int32_t)((uint32_t)r[4] | (uint32_t)r[5] << 8 | (uint32_t)r[6] << 16 | (uint32_t)r[7] << 24);
+  prev.power_uW = (uint32_t)r[8] | (uint32_t)r[9] << 8 | (uint32_t)r[10] << 16 | (uint32_t)r[11] << 24;
+  records[0] = prev;
+  offsets_ms[0] = 0;
+
+  BitSource b = {r + SAMPLE_RECORD_SIZE, len - TELEMETRY_HEADER_SIZE - SAMPLE_RECORD_SIZE, 0};
+  uint32_t dt = 0;
+  uint8_t widths[4] = {0, 0, 0, 0};
+  for (size_t k = 1; k < count; ++k) {
+    int32_t dod, d[4];
+    if (!getSpacing(b, dod)) return 0;
+    for (uint8_t f = 0; f < 4; ++f) {
+      if (!getDelta(b, d[f], widths[f])) return 0;
+    }
+    dt += (uint32_t)dod;
+    offsets_ms[k] = offsets_ms[k - 1] + dt;
+    prev.bus_mV = (uint16_t)(prev.bus_mV + d[0]);
+    prev.shunt_10uV = (int16_t)(prev.shunt_10uV + d[1]);
+    prev.current_uA = (int32_t)((uint32_t)prev.current_uA + (uint32_t)d[2]);
+    prev.power_uW += (uint32_t)d[3];
+    records[k] = prev;
+  }
+  return count;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "power_sample.h"
+
+// Compact binary telemetry, published next to the JSON stream on
+// the raw/bin stream (PUB_TOPIC_BIN). All multi-byte fields are little-endian.
+//
+//   Header (8 bytes)
+//     u8  version     TELEMETRY_SCHEMA_VERSION
+//     u8  kind        TelemetryKind
+//     u16 count       number of samples that follow
+//     u32 t0_ms       uptime (ms) of the first sample
+//   u16 soc           state of charge, 0.01 %
+//   u16 soh           state of health, 0.01 %
+//   u64 utc0_ms       UTC (ms since 1970) of the first sample's acquisition,
+//                     0 if the clock was not synced yet (clock_sync.h); new
+//                     in version 2, the fields before it are unchanged
+//   Kind Single: one SampleRecord (12 bytes)
+//     u16 bus_mV, i16 shunt_10uV, i32 current_uA, u32 power_uW
+//   Kind DeltaBatch: first SampleRecord absolute, then per sample
+//     varint dt_ms, then zigzag-varint deltas of bus_mV, shunt_10uV,
+//     current_uA, power_uW against the previous sample
+//   Kind Event (on "<PUB_TOPIC>/event", see event_capture.h):
+//     u8 cause (EventCause bits), u16 trigger index, then as DeltaBatch
+//     but with varint dt_us, since transients are sampled faster than 1 kHz
+//     resolution would show; t0_ms is the uptime of the first sample
+//   Kind PackedBatch (new in version 3): first SampleRecord absolute, then
+//     one MSB-first bit stream, zero-padded to a byte, per sample:
+//       time: delta-of-delta of the ms offsets, zigzagged:
+//         '0' same spacing | '10' 7 bits | '110' 9 bits | '1110' 12 bits
+//         | '1111' 32 bits
+//       each of bus_mV, shunt_10uV, current_uA, power_uW: the zigzagged
+//       delta as in DeltaBatch, with a bit width that carries over:
+//         '0' unchanged | '10' <width> bits | '11' u5 width-1, then the new
+//         width's bits (width starts at 0 for every field)
+//
+// A single sample is 32 bytes (vs ~150 bytes of JSON); idle batches shrink
+// to ~5 bytes per additional sample, or under 1 byte packed.
+static const uint8_t TELEMETRY_SCHEMA_VERSION = 3;
+
+// Which streams loop() publishes.
+enum class TelemetryEncoding : uint8_t {
+  Json,     // PUB_TOPIC only (legacy)
+  Binary,   // PUB_TOPIC_BIN only
+  Both,
+};
+
+enum class TelemetryKind : uint8_t {
+  Single = 1,
+  DeltaBatch = 2,
+  Event = 3,
+  PackedBatch = 4,
+};
+
+// Fixed-point form of a PowerSample used on the wire.
+struct SampleRecord {
+  uint16_t bus_mV;
+  int16_t shunt_10uV;
+  int32_t current_uA;
+  uint32_t power_uW;
+};
+
+SampleRecord toRecord(const PowerSample& s);
+
+static const size_t TELEMETRY_HEADER_SIZE = 20;   // header + soc + soh + utc0
+static const size_t SAMPLE_RECORD_SIZE = 12;
+// Worst case per delta-encoded sample: 5 varints of at most 5 bytes. A
+// packed sample is at most 36 + 4 * 39 bits, so it fits the same bound.
+static const size_t DELTA_RECORD_MAX = 25;
+static const size_t EVENT_HEADER_SIZE = TELEMETRY_HEADER_SIZE + 3;
+
+// Both return the encoded length, or 0 if cap is too small.
+size_t encodeSingle(uint8_t* out, size_t cap, const PowerSample& s, uint32_t t_ms, uint64_t utc_ms,
+                    float soc_percent, float soh_percent);
+size_t encodeDeltaBatch(uint8_t* out, size_t cap, const PowerSample* samples, size_t count, uint32_t t0_ms,
+                        uint64_t utc0_ms, float soc_percent, float soh_percent);
+size_t encodePackedBatch(uint8_t* out, size_t cap, const PowerSample* samples, size_t count, uint32_t t0_ms,
+                         uint64_t utc0_ms, float soc_percent, float soh_percent);
+size_t encodeEvent(uint8_t* out, size_t cap, const PowerSample* samples, size_t count, size_t triggerIndex,
+                   uint8_t cause, uint32_t t0_ms, uint64_t utc0_ms, float soc_percent, float soh_percent);
+
+// Reverses encodePackedBatch() for the host tools: up to cap records and
+// their ms offsets from t0_ms. Returns the sample count, or 0 if data is
+// not a well-formed PackedBatch.
+size_t decodePackedBatch(const uint8_t* data, size_t len, SampleRecord* records, uint32_t* offsets_ms, size_t cap);
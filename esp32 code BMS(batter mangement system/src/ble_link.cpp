@@ -0,0 +1,169 @@
+#ifdef BLE_PERIPHERAL
+
+#include "ble_link.h"
+
+#include <Arduino.h>
+#include <BLE2902.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <string.h>
+
+#include "binary_codec.h"
+
+namespace {
+
+const char* BMS_SERVICE_UUID = "b5a10001-5c4e-4f7a-9a3e-2d1c0e6f7a01";
+const char* SAMPLES_UUID = "b5a10002-5c4e-4f7a-9a3e-2d1c0e6f7a01";
+const char* STATUS_UUID = "b5a10003-5c4e-4f7a-9a3e-2d1c0e6f7a01";
+const uint16_t BATTERY_SERVICE = 0x180F;
+const uint16_t BATTERY_LEVEL = 0x2A19;
+// Requested connection parameters: 7.5-15 ms interval (1.25 ms units), no
+// peripheral latency, 4 s supervision timeout (10 ms units)
+const uint16_t CONN_INTERVAL_MIN = 6;
+const uint16_t CONN_INTERVAL_MAX = 12;
+const uint16_t CONN_TIMEOUT = 400;
+const uint8_t LAST_FRAGMENT = 0x80;
+const uint16_t ATT_HEADER = 3;
+
+}  // namespace
+
+class BleLink::Callbacks : public BLEServerCallbacks {
+public:
+  explicit Callbacks(BleLink& link) : _link(link) {}
+
+  void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) override {
+    _link._connId.store(param->connect.conn_id);
+    _link._connected.store(true);
+    server->updateConnParams(param->connect.remote_bda, CONN_INTERVAL_MIN, CONN_INTERVAL_MAX, 0, CONN_TIMEOUT);
+  }
+  void onDisconnect(BLEServer*) override {
+    _link._connected.store(false);
+    BLEDevice::startAdvertising();   // one client at a time
+  }
+
+private:
+  BleLink& _link;
+};
+
+bool BleLink::begin(const char* name) {
+  BLEDevice::init(name);
+  BLEDevice::setMTU(MAX_MTU);
+  _server = BLEDevice::createServer();
+  if (!_server) return false;
+  _server->setCallbacks(new Callbacks(*this));   // lives as long as the server
+
+  BLEService* battery = _server->createService(BLEUUID(BATTERY_SERVICE));
+  _level = battery->createCharacteristic(BLEUUID(BATTERY_LEVEL),
+                                         BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  _level->addDescriptor(new BLE2902());
+  battery->start();
+
+  BLEService* bms = _server->createService(BMS_SERVICE_UUID);
+  _samples = bms->createCharacteristic(SAMPLES_UUID, BLECharacteristic::PROPERTY_NOTIFY);
+  _samples->addDescriptor(new BLE2902());
+  _status = bms->createCharacteristic(STATUS_UUID, BLECharacteristic::PROPERTY_READ);
+  bms->start();
+
+  BLEAdvertising* adv = BLEDevice::getAdvertising();
+  adv->addServiceUUID(BMS_SERVICE_UUID);
+  adv->addServiceUUID(BLEUUID(BATTERY_SERVICE));
+  adv->setScanResponse(true);
+  BLEDevice::startAdvertising();
+  return true;
+}
+
+void BleLink::add(const PowerSample& s) {
+  if (!_connected.load(std::memory_order_relaxed)) return;
+  if (!_ring.push(s)) _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BleLink::poll(uint32_t now_ms, uint32_t batch_ms, float soc_percent, float soh_percent, const ClockSync& clock) {
+  if (!_server) return;
+  if (!connected()) {
+    // Whatever was left from the last client is stale
+    _pendingCount = 0;
+    while (_ring.popBulk(_pending, BATCH_MAX)) {
+    }
+    _lastLevel = 0xFF;
+    return;
+  }
+  uint16_t mtu = _server->getPeerMTU(_connId.load());
+  _mtu = mtu > ATT_HEADER + 1 ? (mtu < MAX_MTU ? mtu : MAX_MTU) : 23;
+
+  uint8_t level = (uint8_t)constrain(lroundf(soc_percent), 0, 100);
+  if (level != _lastLevel) {
+    _level->setValue(&level, 1);
+    _level->notify();
+    _lastLevel = level;
+  }
+
+  // A full notification is roughly a first sample plus ~3 packed bytes per further one
+  size_t room = _mtu - ATT_HEADER - 1;
+  size_t fullAt = room > TELEMETRY_HEADER_SIZE + SAMPLE_RECORD_SIZE
+                      ? (room - TELEMETRY_HEADER_SIZE - SAMPLE_RECORD_SIZE) / 3 + 1
+                      : 1;
+  if (_pendingCount + _ring.size() < fullAt && now_ms - _lastBatch_ms < batch_ms) return;
+  _lastBatch_ms = now_ms;
+
+  uint8_t msg[MESSAGE_MAX];
+  size_t cap = room >= MESSAGE_MIN ? (room < sizeof(msg) ? room : sizeof(msg)) : MESSAGE_MIN;
+  for (uint8_t k = 0; k < NOTIFY_BURST; ++k) {
+    _pendingCount += _ring.popBulk(_pending + _pendingCount, BATCH_MAX - _pendingCount);
+    if (!_pendingCount) break;
+    size_t len = encode(msg, cap, soc_percent, soh_percent, clock);
+    if (!len) break;
+    notify(msg, len);
+  }
+
+  char json[128];
+  JsonWriter status(json, sizeof(json));
+  status.beginObject();
+  writeJson(status);
+  status.endObject();
+  if (status.ok()) _status->setValue((uint8_t*)json, status.length());
+}
+
+// As many pending samples as fit cap in one PackedBatch; consumes them.
+size_t BleLink::encode(uint8_t* out, size_t cap, float soc_percent, float soh_percent, const ClockSync& clock) {
+  size_t n = _pendingCount;
+  size_t len = 0;
+  while (n) {
+    uint64_t t0_us = ClockSync::extend(_pending[0].t_us);
+    len = encodePackedBatch(out, cap, _pending, n, (uint32_t)(t0_us / 1000), clock.utc_ms(t0_us), soc_percent,
+                            soh_percent);
+    if (len) break;
+    n = n > 8 ? n * 3 / 4 : n - 1;
+  }
+  if (!n) return 0;
+  memmove(_pending, _pending + n, (_pendingCount - n) * sizeof(PowerSample));
+  _pendingCount -= n;
+  _sent += n;
+  return len;
+}
+
+void BleLink::notify(const uint8_t* msg, size_t len) {
+  size_t chunk = _mtu - ATT_HEADER - 1;
+  uint8_t frame[MAX_MTU];
+  for (uint8_t index = 0; len; ++index) {
+    size_t n = len < chunk ? len : chunk;
+    frame[0] = (uint8_t)(index & 0x7F) | (n == len ? LAST_FRAGMENT : 0);
+    memcpy(frame + 1, msg, n);
+    _samples->setValue(frame, n + 1);
+    _samples->notify();
+    _notifications++;
+    msg += n;
+    len -= n;
+  }
+}
+
+void BleLink::writeJson(JsonWriter& w) const {
+  w.beginObject("ble")
+      .field("connected", connected())
+      .field("mtu", (uint32_t)_mtu)
+      .field("notifications", _notifications)
+      .field("samples", _sent)
+      .field("dropped", _dropped.load(std::memory_order_relaxed))
+      .endObject();
+}
+
+#endif  // BLE_PERIPHERAL
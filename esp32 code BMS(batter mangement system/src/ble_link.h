@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "clock_sync.h"
+#include "json_writer.h"
+#include "power_sample.h"
+#include "ring_buffer.h"
+
+class BLEServer;
+class BLECharacteristic;
+
+// BLE peripheral for a phone next to the pack, with or without WiFi.
+// Only built with -DBLE_PERIPHERAL (Bluedroid adds ~500 KB of flash).
+//
+// Two services:
+//   Battery Service (0x180F): Battery Level (0x2A19), SoC in %, notify
+//   BMS service (BLE_BMS_SERVICE_UUID):
+//     samples (notify): binary_codec.h messages, a PackedBatch of as many
+//       samples as fit one notification at the negotiated MTU, behind a
+//       1-byte fragment header (bit 7: last fragment, bits 0-6: index).
+//       A message only needs more than one fragment below MTU 100.
+//     status (read): the JSON from writeJson()
+//
+// The estimation task add()s samples to a private ring and never waits;
+// poll() (network task) drains it while a client is subscribed. On
+// connect the peripheral asks for a 7.5-15 ms connection interval and the
+// largest MTU, so one connection event carries several full notifications.
+class BleLink {
+public:
+  static const size_t RING_SIZE = 256;   // 2.5 s at 100 Hz
+  static const uint16_t MAX_MTU = 247;   // one LL packet with data length extension
+  static const uint8_t NOTIFY_BURST = 4; // notifications per poll()
+
+  bool begin(const char* name);
+  bool connected() const { return _connected.load(std::memory_order_relaxed); }
+
+  // Estimation task.
+  void add(const PowerSample& s);
+  // Network task: sends what is buffered every batch_ms (and sooner once a
+  // notification's worth is waiting); the battery level when it changes.
+  void poll(uint32_t now_ms, uint32_t batch_ms, float soc_percent, float soh_percent, const ClockSync& clock);
+
+  // "ble": {"connected", "mtu", "notifications", "samples", "dropped"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  class Callbacks;
+  friend class Callbacks;
+
+  static const size_t BATCH_MAX = 64;       // samples per message
+  static const size_t MESSAGE_MAX = 512;    // fragmented below an MTU of MESSAGE_MIN + 4
+  static const size_t MESSAGE_MIN = 96;
+
+  size_t encode(uint8_t* out, size_t cap, float soc_percent, float soh_percent, const ClockSync& clock);
+  void notify(const uint8_t* msg, size_t len);
+
+  BLEServer* _server = nullptr;
+  BLECharacteristic* _samples = nullptr;
+  BLECharacteristic* _level = nullptr;
+  BLECharacteristic* _status = nullptr;
+
+  SpscRing<PowerSample, RING_SIZE> _ring;
+  PowerSample _pending[BATCH_MAX];   // taken off the ring, not sent yet
+  size_t _pendingCount = 0;
+  std::atomic<bool> _connected{false};
+  std::atomic<uint16_t> _connId{0};
+  uint16_t _mtu = 23;
+  uint32_t _lastBatch_ms = 0;
+  uint8_t _lastLevel = 0xFF;
+
+  uint32_t _notifications = 0;
+  uint32_t _sent = 0;                    // samples
+  std::atomic<uint32_t> _dropped{0};     // ring full
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "json_writer.h"
+
+// Fixed-block allocator over an arena reserved in static storage, for the
+// buffers that would otherwise come and go on the shared heap next to
+// mbedTLS (QoS 1 copies, MQTT 5 alias topics, diagnostic payloads).
+//
+// Every block has the same size, so the arena cannot fragment: after weeks
+// of uptime an allocation succeeds exactly when fewer than COUNT blocks are
+// out. Ownership is one bit per block, claimed with a compare-and-swap, so
+// alloc() and release() are lock-free and bounded (one pass over
+// COUNT / 32 words) from any task or ISR.
+template <size_t BLOCK, size_t COUNT>
+class BlockPool {
+  static_assert(BLOCK >= 4 && COUNT >= 1, "BlockPool needs blocks");
+  static const size_t WORDS = (COUNT + 31) / 32;
+  static const size_t STRIDE = (BLOCK + 3) & ~(size_t)3;   // keep blocks 4-byte aligned
+
+public:
+  // A free block of blockSize() bytes, or nullptr when all are out.
+  void* alloc() {
+    for (size_t w = 0; w < WORDS; ++w) {
+      uint32_t bits = _bits[w].load(std::memory_order_relaxed);
+      uint32_t full = w == WORDS - 1 && COUNT % 32 ? (1UL << (COUNT % 32)) - 1 : 0xFFFFFFFFUL;
+      while (bits != full) {
+        uint32_t bit = (~bits) & (bits + 1);   // lowest clear bit
+        if (_bits[w].compare_exchange_weak(bits, bits | bit, std::memory_order_acquire)) {
+          noteUsed(_used.fetch_add(1, std::memory_order_relaxed) + 1);
+          return _arena + (w * 32 + __builtin_ctz(bit)) * STRIDE;
+        }
+      }
+    }
+    _failures.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  // p must be nullptr or a block of this pool.
+  void release(void* p) {
+    if (!p) return;
+    size_t k = ((uint8_t*)p - _arena) / STRIDE;
+    _bits[k / 32].fetch_and(~(1UL << (k % 32)), std::memory_order_release);
+    _used.fetch_sub(1, std::memory_order_relaxed);
+  }
+  bool owns(const void* p) const {
+    return (const uint8_t*)p >= _arena && (const uint8_t*)p < _arena + sizeof(_arena);
+  }
+
+  static constexpr size_t blockSize() { return BLOCK; }
+  static constexpr size_t capacity() { return COUNT; }
+  size_t used() const { return _used.load(std::memory_order_relaxed); }
+  size_t peak() const { return _peak.load(std::memory_order_relaxed); }
+  // alloc() calls that found the pool empty
+  uint32_t failures() const { return _failures.load(std::memory_order_relaxed); }
+
+  // "<key>": {"block", "count", "used", "peak", "failed"}
+  void writeJson(JsonWriter& w, const char* key) const {
+    w.beginObject(key)
+        .field("block", (uint32_t)BLOCK)
+        .field("count", (uint32_t)COUNT)
+        .field("used", (uint32_t)used())
+        .field("peak", (uint32_t)peak())
+        .field("failed", failures())
+        .endObject();
+  }
+
+private:
+  void noteUsed(uint32_t n) {
+    uint32_t p = _peak.load(std::memory_order_relaxed);
+    while (n > p && !_peak.compare_exchange_weak(p, n, std::memory_order_relaxed)) {
+    }
+  }
+
+  alignas(4) uint8_t _arena[STRIDE * COUNT];
+  std::atomic<uint32_t> _bits[WORDS] = {};
+  std::atomic<uint32_t> _used{0};
+  std::atomic<uint32_t> _peak{0};
+  std::atomic<uint32_t> _failures{0};
+};
+
+// One block borrowed for the length of a scope, e.g. to format a payload
+// that is published before the scope ends. Test with ok() before use.
+template <class Pool>
+class PooledBuffer {
+public:
+  explicit PooledBuffer(Pool& pool) : _pool(pool), _data((uint8_t*)pool.alloc()) {}
+  ~PooledBuffer() { _pool.release(_data); }
+  PooledBuffer(const PooledBuffer&) = delete;
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+  bool ok() const { return _data != nullptr; }
+  uint8_t* data() { return _data; }
+  char* chars() { return (char*)_data; }
+  static constexpr size_t size() { return Pool::blockSize(); }
+
+private:
+  Pool& _pool;
+  uint8_t* _data;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "binary_codec.h"
+
+// Uplink role (espnow_link.h), so a fleet shares one broker connection.
+//   Mqtt           this device holds its own broker connection
+//   EspNowNode     binary windows go to ESPNOW_GATEWAY_MAC over ESP-NOW: no WiFi association, TLS,
+//                  SNTP (ts stays 0), flash queue, remote config or OTA; always in task mode
+//   EspNowGateway  as Mqtt, and republishes every node's messages verbatim on the node's own
+//                  raw/bin topic (its device id from its MAC) over the same connection
+//   BleOnly        WiFi off entirely; data only over BLE (needs -DBLE_PERIPHERAL) and the OLED
+//   SerialStream   bench characterization: WiFi off, every sample as a binary frame on USB serial
+//                  (serial_stream.h) at SERIAL_STREAM_BAUD, fixed SERIAL_STREAM_RATE_HZ, no text log
+enum class LinkRole : uint8_t { Mqtt, EspNowNode, EspNowGateway, BleOnly, SerialStream };
+
+// What one board carries and how it reports, fixed at compile time and
+// selected per PlatformIO env with -DBMS_PROFILE=<name>. main.cpp reads it
+// only through constants, so a part the profile leaves out folds away with
+// every branch around it instead of being probed and checked at run time.
+struct BoardProfile {
+  bool ina219;                  // sensor: the INA219 at INA_ADDRESS on I2C_INA
+  bool demoFallback;            // publish a random "value" while no INA219 answers (bring-up)
+  bool oled;                    // SSD1306 pages, button and trend chart on I2C_OLED
+  TelemetryEncoding encoding;   // default; remote config may still switch it
+  LinkRole link;
+};
+
+// Development board: everything fitted, a demo value without a sensor
+static constexpr BoardProfile PROFILE_DEVKIT = { true, true, true, TelemetryEncoding::Json, LinkRole::Mqtt };
+// Installed pack monitor with a display
+static constexpr BoardProfile PROFILE_PACK = { true, false, true, TelemetryEncoding::Json, LinkRole::Mqtt };
+// Headless pack monitor: no OLED, binary telemetry
+static constexpr BoardProfile PROFILE_HEADLESS = { true, false, false, TelemetryEncoding::Binary, LinkRole::Mqtt };
+// ESP-NOW node behind a gateway
+static constexpr BoardProfile PROFILE_NODE = { true, false, false, TelemetryEncoding::Binary,
+                                               LinkRole::EspNowNode };
+// USB-serial bench stream
+static constexpr BoardProfile PROFILE_BENCH = { true, false, false, TelemetryEncoding::Binary,
+                                                LinkRole::SerialStream };
+
+#ifndef BMS_PROFILE
+#define BMS_PROFILE PROFILE_DEVKIT
+#endif
+
+// Detection flag of an optional part. Fitted, it is a plain bool set once
+// the part answers; not fitted, it is a constant false that ignores writes,
+// so `if (present)` compiles out the code it guards.
+template <bool Fitted>
+class Presence {
+public:
+  operator bool() const { return _present; }
+  Presence& operator=(bool present) {
+    _present = present;
+    return *this;
+  }
+
+private:
+  bool _present = false;
+};
+
+template <>
+class Presence<false> {
+public:
+  constexpr operator bool() const { return false; }
+  Presence& operator=(bool) { return *this; }
+};
@@ -0,0 +1,90 @@
+#include "broker_pool.h"
+
+#include <WiFi.h>
+
+void BrokerPool::begin(const BrokerConfig* brokers, size_t count, uint32_t probeInterval_ms, uint32_t probeTimeout_ms,
+                       BaseType_t core, UBaseType_t priority) {
+  _brokers = brokers;
+  _count = count < MAX_BROKERS ? count : MAX_BROKERS;
+  _current = 0;
+  _probeInterval_ms = probeInterval_ms;
+  _probeTimeout_ms = probeTimeout_ms;
+  // With a single broker there is nothing to choose between.
+  if (_count > 1) xTaskCreatePinnedToCore(taskEntry, "brokers", 4096, this, priority, nullptr, core);
+}
+
+void BrokerPool::setFailover(uint8_t failoverAfter, uint32_t switchMargin_ms, uint8_t switchRounds) {
+  _failoverAfter = failoverAfter ? failoverAfter : 1;
+  _switchMargin_ms = switchMargin_ms;
+  _switchRounds = switchRounds ? switchRounds : 1;
+}
+
+void BrokerPool::taskEntry(void* arg) { static_cast<BrokerPool*>(arg)->run(); }
+
+// Probe task: TCP connect time to each broker, no TLS, no MQTT.
+void BrokerPool::run() {
+  for (;;) {
+    if (WiFi.isConnected()) {
+      for (uint8_t k = 0; k < _count; ++k) {
+        WiFiClient probe;
+        uint32_t start = millis();
+        bool ok = probe.connect(_brokers[k].host, _brokers[k].port, _probeTimeout_ms);
+        uint32_t rtt = millis() - start;
+        probe.stop();
+        Probe& p = _probe[k];
+        if (ok) {
+          p.rtt_ms = p.reachable ? (3 * p.rtt_ms + rtt) / 4 : rtt;
+        }
+        p.reachable = ok;
+      }
+      _rounds = _rounds + 1;
+    }
+    vTaskDelay(pdMS_TO_TICKS(_probeInterval_ms));
+  }
+}
+
+void BrokerPool::connected() {
+  _failures = 0;
+}
+
+void BrokerPool::connectFailed() {
+  if (++_failures >= _failoverAfter && _count > 1) _failoverPending = true;
+}
+
+// Fastest reachable broker other than exclude, -1 if none.
+int8_t BrokerPool::fastest(int8_t exclude) const {
+  int8_t best = -1;
+  for (uint8_t k = 0; k < _count; ++k) {
+    if (k == exclude || !_probe[k].reachable) continue;
+    if (best < 0 || _probe[k].rtt_ms < _probe[best].rtt_ms) best = k;
+  }
+  return best;
+}
+
+void BrokerPool::select(uint8_t k) {
+  _current = k;
+  _failures = 0;
+  _fasterRounds = 0;
+}
+
+bool BrokerPool::poll() {
+  if (_failoverPending) {
+    _failoverPending = false;
+    int8_t next = fastest(_current);
+    select(next >= 0 ? next : (_current + 1) % _count);
+    return true;
+  }
+  uint32_t rounds = _rounds;
+  if (rounds == _seenRounds) return false;
+  _seenRounds = rounds;
+  // Latency switch: only after a clear, sustained win over a working broker.
+  int8_t best = fastest(_current);
+  bool faster = best >= 0 && _probe[_current].reachable &&
+                _probe[best].rtt_ms + _switchMargin_ms < _probe[_current].rtt_ms;
+  _fasterRounds = faster ? _fasterRounds + 1 : 0;
+  if (_fasterRounds >= _switchRounds) {
+    select(best);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+
+// One entry of the broker list in main.cpp, highest priority first.
+struct BrokerConfig {
+  const char* host;
+  uint16_t port;
+  bool tls;
+  const char* user;       // nullptr: no credentials
+  const char* password;
+};
+
+// Chooses which of several MQTT brokers to use (e.g. HiveMQ Cloud plus a
+// LAN broker next to the dashboard).
+//
+// A low-priority task on core 0 times a plain TCP connect to every broker
+// each probe interval while WiFi is up and keeps a smoothed RTT per broker.
+// The choice is sticky: the MQTT layer stays on its broker until that one
+// fails failoverAfter connects in a row, or another reachable broker has
+// been at least switchMargin_ms faster for switchRounds probe rounds in a
+// row. It then moves to the fastest reachable broker (list order breaks
+// ties, and an unprobed list falls back to the next entry).
+//
+// Nothing is queued here: QoS 1 messages still waiting for a PUBACK stay in
+// PubSubClient and are resent to the new broker after its CONNACK, and
+// anything published while no broker is up goes to the flash queue.
+class BrokerPool {
+public:
+  static const uint8_t MAX_BROKERS = 4;
+
+  void begin(const BrokerConfig* brokers, size_t count, uint32_t probeInterval_ms, uint32_t probeTimeout_ms,
+             BaseType_t core = 0, UBaseType_t priority = 1);
+  void setFailover(uint8_t failoverAfter, uint32_t switchMargin_ms, uint8_t switchRounds);
+
+  // Broker to connect to.
+  uint8_t current() const { return _current; }
+  const BrokerConfig& config(uint8_t k) const { return _brokers[k]; }
+  uint8_t size() const { return _count; }
+
+  // Connect results from the MQTT layer.
+  void connected();
+  void connectFailed();
+  // Call from loop(); returns true when current() changed (the caller then
+  // reconnects, dropping the open connection if there is one).
+  bool poll();
+
+  bool reachable(uint8_t k) const { return _probe[k].reachable; }
+  uint32_t rtt_ms(uint8_t k) const { return _probe[k].rtt_ms; }
+
+private:
+  struct Probe {
+    volatile bool reachable;
+    volatile uint32_t rtt_ms;   // smoothed, 1/4 weight per sample
+  };
+
+  static void taskEntry(void* arg);
+  void run();
+  int8_t fastest(int8_t exclude) const;
+  void select(uint8_t k);
+
+  const BrokerConfig* _brokers = nullptr;
+  uint8_t _count = 0;
+  uint8_t _current = 0;
+  Probe _probe[MAX_BROKERS] = {};
+  volatile uint32_t _rounds = 0;     // finished probe rounds
+  uint32_t _seenRounds = 0;
+  uint32_t _probeInterval_ms = 30000;
+  uint32_t _probeTimeout_ms = 2000;
+  uint8_t _failoverAfter = 2;
+  uint32_t _switchMargin_ms = 20;
+  uint8_t _switchRounds = 3;
+  uint8_t _failures = 0;
+  uint8_t _fasterRounds = 0;
+  bool _failoverPending = false;
+};
@@ -0,0 +1,68 @@
+#include "bus_clock.h"
+
+#include <Preferences.h>
+
+static const char* NVS_NAMESPACE = "busclk";
+// Alternating bits, all ones / zeros, walking nibbles
+static const uint16_t PATTERNS[] = {0xAAAA, 0x5555, 0xFFFF, 0x0000, 0x1234, 0xEDCB, 0x0F0F, 0xF0F0};
+static const uint8_t PATTERN_COUNT = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+
+static bool readReg(Adafruit_I2CDevice& dev, uint8_t reg, uint16_t& value) {
+  uint8_t buf[2];
+  if (!dev.write_then_read(&reg, 1, buf, 2)) return false;
+  value = ((uint16_t)buf[0] << 8) | buf[1];
+  return true;
+}
+
+static bool writeReg(Adafruit_I2CDevice& dev, uint8_t reg, uint16_t value) {
+  uint8_t buf[2] = {(uint8_t)(value >> 8), (uint8_t)value};
+  return dev.write(buf, 2, true, &reg, 1);
+}
+
+bool verifyBusClock(Adafruit_I2CDevice& dev, const BusClockTest& test, uint8_t rounds) {
+  for (uint8_t k = 0; k < rounds; ++k) {
+    uint16_t pattern = PATTERNS[k % PATTERN_COUNT] & test.mask;
+    uint16_t back;
+    if (!writeReg(dev, test.reg, pattern) || !readReg(dev, test.reg, back)) return false;
+    if ((back & test.mask) != pattern) return false;
+  }
+  return true;
+}
+
+uint32_t negotiateBusClock(Adafruit_I2CDevice& dev, const BusClockTest& test, const uint32_t* clocks, size_t count,
+                           uint8_t rounds) {
+  if (!count) return 0;
+  dev.setSpeed(clocks[0]);
+  uint16_t original;
+  if (!readReg(dev, test.reg, original)) return 0;
+
+  uint32_t best = 0;
+  for (size_t k = 0; k < count; ++k) {
+    dev.setSpeed(clocks[k]);
+    bool ok = verifyBusClock(dev, test, rounds);
+    Serial.printf("  %lu Hz: %s\n", (unsigned long)clocks[k], ok ? "ok" : "failed");
+    if (!ok) break;
+    best = clocks[k];
+  }
+
+  dev.setSpeed(best ? best : clocks[0]);
+  writeReg(dev, test.reg, original);
+  return best;
+}
+
+bool loadBusClock(const char* key, uint32_t& hz) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+  hz = prefs.getUInt(key, 0);
+  prefs.end();
+  return hz != 0;
+}
+
+void storeBusClock(const char* key, uint32_t hz) {
+  uint32_t cur;
+  if (loadBusClock(key, cur) && cur == hz) return;
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return;
+  prefs.putUInt(key, hz);
+  prefs.end();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Adafruit_I2CDevice.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A 16-bit MSB-first register that reads back what was written (within
+// mask), used as the known-pattern check, e.g. INA219 calibration (0x05,
+// bit 0 always reads 0).
+struct BusClockTest {
+  uint8_t reg;
+  uint16_t mask;
+};
+
+// Bus clock negotiation. Steps dev's bus through clocks (ascending), and at
+// each one writes and reads back `rounds` test patterns; stops at the first
+// mismatch or NACK. Leaves the bus at, and returns, the fastest clock at
+// which every round passed (0 if even clocks[0] failed; the bus is then at
+// clocks[0]). The register's original value is restored afterwards.
+uint32_t negotiateBusClock(Adafruit_I2CDevice& dev, const BusClockTest& test, const uint32_t* clocks, size_t count,
+                           uint8_t rounds = 16);
+// Runs the pattern check at the bus's current clock; true if all passed.
+bool verifyBusClock(Adafruit_I2CDevice& dev, const BusClockTest& test, uint8_t rounds);
+
+// Negotiated clock per bus in NVS, so a normal boot goes straight to it.
+bool loadBusClock(const char* key, uint32_t& hz);
+void storeBusClock(const char* key, uint32_t hz);
@@ -0,0 +1,75 @@
+#include "button.h"
+
+bool Button::begin(int pin, uint32_t debounce_ms, uint32_t longPress_ms) {
+  if (pin < 0 || _timer) return false;
+  esp_timer_create_args_t args = {};
+  args.callback = onSettled;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "button";
+  if (esp_timer_create(&args, &_timer) != ESP_OK) {
+    _timer = nullptr;
+    return false;
+  }
+  _pin = pin;
+  _debounce_us = (uint64_t)debounce_ms * 1000;
+  _longPress_ms = longPress_ms;
+  pinMode(pin, INPUT_PULLUP);
+  _pressed = digitalRead(pin) == LOW;
+  attachInterruptArg(pin, onEdge, this, CHANGE);
+  return true;
+}
+
+void Button::stop() {
+  if (_pin >= 0) {
+    detachInterrupt(_pin);
+    _pin = -1;
+  }
+  if (_timer) {
+    esp_timer_stop(_timer);
+    esp_timer_delete(_timer);
+    _timer = nullptr;
+  }
+}
+
+bool Button::wait(ButtonEvent& event, TickType_t timeout) {
+  if (_events.pop(event)) return true;
+  if (!_timer) {
+    vTaskDelay(timeout);
+    return false;
+  }
+  _waiter = xTaskGetCurrentTaskHandle();
+  // Re-check after publishing the handle so an event pushed in between is not missed
+  bool got = _events.pop(event) || (ulTaskNotifyTake(pdTRUE, timeout) && _events.pop(event));
+  _waiter = nullptr;
+  return got;
+}
+
+// GPIO ISR: push the debounce deadline out, nothing else. Both esp_timer
+// calls are in IRAM and safe here; stop() fails harmlessly when idle.
+void IRAM_ATTR Button::onEdge(void* arg) {
+  Button* self = static_cast<Button*>(arg);
+  self->_edges++;
+  esp_timer_stop(self->_timer);
+  esp_timer_start_once(self->_timer, self->_debounce_us);
+}
+
+// esp_timer task context: the level has been stable for the debounce time.
+void Button::onSettled(void* arg) {
+  Button* self = static_cast<Button*>(arg);
+  bool pressed = digitalRead(self->_pin) == LOW;
+  if (pressed == self->_pressed) return;   // bounced back
+  self->_pressed = pressed;
+  uint32_t now = millis();
+  if (pressed) {
+    self->_pressedAt_ms = now;
+    return;
+  }
+  ButtonEvent event = now - self->_pressedAt_ms >= self->_longPress_ms ? ButtonEvent::LongPress : ButtonEvent::Press;
+  if (!self->_events.push(event)) {
+    self->_dropped++;
+    return;
+  }
+  TaskHandle_t waiter = self->_waiter;
+  if (waiter) xTaskNotifyGive(waiter);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+
+#include "ring_buffer.h"
+
+// What a debounced press turned into, reported on release.
+enum class ButtonEvent : uint8_t {
+  Press,       // shorter than the long-press time
+  LongPress,
+};
+
+// Push button to GND (internal pull-up) without polling.
+//
+// Every edge on the pin (re)starts a one-shot esp_timer from the GPIO ISR,
+// so a bouncing contact only pushes the deadline out; when the level has
+// held for the debounce time the timer callback reads it once and, on a
+// release, queues a ButtonEvent (SpscRing: the timer task produces, one
+// consumer task takes). Between presses nothing runs at all: the consumer
+// blocks in wait() on a task notification until an event arrives or its
+// timeout expires.
+class Button {
+public:
+  static const uint8_t QUEUE_DEPTH = 4;
+
+  bool begin(int pin, uint32_t debounce_ms = 30, uint32_t longPress_ms = 800);
+  void stop();
+
+  // Consumer side (one task): the next event, waiting up to timeout.
+  bool wait(ButtonEvent& event, TickType_t timeout);
+
+  // Edges seen by the ISR, and events lost to a full queue.
+  uint32_t edges() const { return _edges; }
+  uint32_t dropped() const { return _dropped; }
+
+private:
+  static void IRAM_ATTR onEdge(void* arg);
+  static void onSettled(void* arg);
+
+  int _pin = -1;
+  uint64_t _debounce_us = 0;
+  uint32_t _longPress_ms = 0;
+  esp_timer_handle_t _timer = nullptr;
+  SpscRing<ButtonEvent, QUEUE_DEPTH> _events;
+  TaskHandle_t volatile _waiter = nullptr;
+  bool _pressed = false;       // settled state, timer callback only
+  uint32_t _pressedAt_ms = 0;
+  volatile uint32_t _edges = 0;
+  uint32_t _dropped = 0;
+};
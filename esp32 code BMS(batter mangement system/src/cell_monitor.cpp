@@ -0,0 +1,250 @@
+#include "cell_monitor.h"
+
+#include <esp_timer.h>
+#include <string.h>
+
+static const uint32_t DEFAULT_VREF_mV = 1100;   // esp_adc_cal's fallback without eFuse data
+static const uint32_t CODE_MAX = 4095;
+
+// The cell task's DMA frame; there is only one task
+static uint8_t dmaFrame[CellMonitor::MAX_FRAME_BYTES];
+
+uint8_t CellMonitor::begin(const CellTap* taps, size_t count, uint32_t sampleRate_Hz, uint16_t oversample,
+                           BaseType_t core, UBaseType_t priority) {
+  if (_task || !taps) return 0;
+  // A second begin() after stop() starts from scratch
+  memset(_tapOf, 0, sizeof(_tapOf));
+  memset(_sum, 0, sizeof(_sum));
+  memset(_n, 0, sizeof(_n));
+  _conversions = 0;
+  _held = 0;
+  CellSample flushed;
+  while (_ring.pop(flushed)) continue;
+  adc_digi_pattern_config_t pattern[CellSample::MAX_CELLS] = {};
+  uint32_t mask = 0;
+  uint8_t built = 0;   // attenuations with a LUT
+  _count = 0;
+  for (size_t k = 0; k < count && _count < CellSample::MAX_CELLS; ++k) {
+    const CellTap& t = taps[k];
+    if (t.divider <= 0.0f || t.channel >= CellSample::MAX_CELLS || _tapOf[t.channel] || t.atten >= ADC_ATTEN_MAX) {
+      continue;
+    }
+    _tapOf[t.channel] = _count + 1;
+    _gain_q16[_count] = (int32_t)(t.divider * 65536.0f + 0.5f);
+    _lutOf[_count] = (uint8_t)t.atten;
+    pattern[_count].atten = (uint8_t)t.atten;
+    pattern[_count].channel = t.channel;
+    pattern[_count].unit = 0;   // ADC1
+    pattern[_count].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    mask |= 1u << t.channel;
+    if (!(built & (1u << t.atten))) {
+      // Code -> mV once per attenuation, so a block costs a lookup instead of the curve fit
+      esp_adc_cal_characteristics_t chars;
+      esp_adc_cal_characterize(ADC_UNIT_1, t.atten, ADC_WIDTH_BIT_12, DEFAULT_VREF_mV, &chars);
+      for (uint16_t p = 0; p < LUT_POINTS; ++p) {
+        uint32_t code = (uint32_t)p << LUT_SHIFT;
+        _lut_mV[t.atten][p] = (uint16_t)esp_adc_cal_raw_to_voltage(code > CODE_MAX ? CODE_MAX : code, &chars);
+      }
+      built |= 1u << t.atten;
+    }
+    _count++;
+  }
+  if (!_count) return 0;
+
+  _rateHz = sampleRate_Hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW    ? SOC_ADC_SAMPLE_FREQ_THRES_LOW
+            : sampleRate_Hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH ? SOC_ADC_SAMPLE_FREQ_THRES_HIGH
+                                                             : sampleRate_Hz;
+  _oversample = oversample ? oversample : 1;
+  _block_us = (uint32_t)((uint64_t)_oversample * _count * 1000000 / _rateHz);
+  // One interrupt per block, in whole DMA conversion units; longer blocks span several frames
+  uint32_t blockBytes = (uint32_t)_oversample * _count * SOC_ADC_DIGI_RESULT_BYTES;
+  blockBytes = (blockBytes + SOC_ADC_DIGI_DATA_BYTES_PER_CONV - 1) / SOC_ADC_DIGI_DATA_BYTES_PER_CONV *
+               SOC_ADC_DIGI_DATA_BYTES_PER_CONV;
+  _frameBytes = blockBytes < MAX_FRAME_BYTES ? blockBytes : MAX_FRAME_BYTES;
+
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = 4 * MAX_FRAME_BYTES;
+  init.conv_num_each_intr = _frameBytes;
+  init.adc1_chan_mask = mask;
+  init.adc2_chan_mask = 0;
+  adc_digi_configuration_t cfg = {};
+  cfg.conv_limit_en = true;   // required on the ESP32
+  cfg.conv_limit_num = 250;
+  cfg.pattern_num = _count;
+  cfg.adc_pattern = pattern;
+  cfg.sample_freq_hz = _rateHz;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_initialize(&init) != ESP_OK) {
+    _count = 0;
+    return 0;
+  }
+  if (adc_digi_controller_configure(&cfg) != ESP_OK ||
+      xTaskCreatePinnedToCore(taskEntry, "cells", 3072, this, priority, &_task, core) != pdPASS) {
+    _task = nullptr;
+    adc_digi_deinitialize();
+    _count = 0;
+    return 0;
+  }
+  adc_digi_start();
+  return _count;
+}
+
+void CellMonitor::stop() {
+  if (!_task) return;
+  adc_digi_stop();
+  vTaskDelete(_task);
+  _task = nullptr;
+  adc_digi_deinitialize();
+}
+
+void CellMonitor::taskEntry(void* arg) { static_cast<CellMonitor*>(arg)->run(); }
+
+void CellMonitor::run() {
+  const uint32_t total = _oversample * _count;
+  for (;;) {
+    uint32_t got = 0;
+    esp_err_t err = adc_digi_read_bytes(dmaFrame, _frameBytes, &got, ADC_MAX_DELAY);
+    if (err == ESP_ERR_INVALID_STATE) _overruns = _overruns + 1;   // data is still returned
+    else if (err != ESP_OK) continue;
+    uint32_t arrived_us = (uint32_t)esp_timer_get_time();
+    _frames = _frames + 1;
+    uint32_t conversions = got / SOC_ADC_DIGI_RESULT_BYTES;
+    for (uint32_t k = 0; k < conversions; ++k) {
+      const adc_digi_output_data_t* d = (const adc_digi_output_data_t*)&dmaFrame[k * SOC_ADC_DIGI_RESULT_BYTES];
+      uint8_t ch = d->type1.channel;
+      uint8_t tap = ch < CellSample::MAX_CELLS ? _tapOf[ch] : 0;
+      if (!tap) continue;
+      _sum[tap - 1] += d->type1.data;
+      _n[tap - 1]++;
+      if (++_conversions < total) continue;
+      // The frame ended at arrived_us; this conversion was (conversions - 1 - k) before that
+      decimate(arrived_us - (uint32_t)((uint64_t)(conversions - 1 - k) * 1000000 / _rateHz));
+    }
+    _busy_us = _busy_us + ((uint32_t)esp_timer_get_time() - arrived_us);
+  }
+}
+
+int32_t CellMonitor::toMicrovolts(const uint16_t* lut, uint32_t sum, uint32_t n) const {
+  // Mean code with 8 fractional bits, between two LUT entries
+  static const uint8_t FRAC = 8 + LUT_SHIFT;
+  uint32_t mean = (uint32_t)(((uint64_t)sum << 8) / n);
+  uint32_t p = mean >> FRAC;
+  if (p >= LUT_POINTS - 1) return lut[LUT_POINTS - 1] * 1000;
+  int32_t lo = lut[p] * 1000;
+  int32_t hi = lut[p + 1] * 1000;
+  return lo + (int32_t)(((int64_t)(hi - lo) * (mean & ((1u << FRAC) - 1))) >> FRAC);
+}
+
+void CellMonitor::decimate(uint32_t end_us) {
+  CellSample s;
+  s.t_us = end_us - _block_us / 2;
+  s.count = _count;
+  int32_t below_uV = 0;
+  for (uint8_t k = 0; k < _count; ++k) {
+    int32_t pin_uV = _n[k] ? toMicrovolts(_lut_mV[_lutOf[k]], _sum[k], _n[k]) : 0;
+    int32_t tap_uV = (int32_t)(((int64_t)pin_uV * _gain_q16[k]) >> 16);
+    s.cell_uV[k] = tap_uV - below_uV;
+    below_uV = tap_uV;
+    _sum[k] = 0;
+    _n[k] = 0;
+  }
+  _conversions = 0;
+  _blocks = _blocks + 1;
+  if (!_ring.push(s)) _dropped = _dropped + 1;
+}
+
+void CellMonitor::receive() {
+  CellSample s;
+  while (_ring.pop(s)) {
+    if (_held == HISTORY) {
+      for (uint8_t k = 1; k < HISTORY; ++k) _history[k - 1] = _history[k];
+      _held--;
+    }
+    _history[_held++] = s;
+  }
+}
+
+bool CellMonitor::align(const PowerSample& power, PackSample& out) {
+  receive();
+  if (!_held) return false;
+  const CellSample* before = nullptr;
+  const CellSample* after = nullptr;
+  for (uint8_t k = 0; k < _held; ++k) {
+    if ((int32_t)(_history[k].t_us - power.t_us) <= 0) before = &_history[k];
+    else if (!after) after = &_history[k];
+  }
+  out.power = power;
+  if (before && after) {
+    uint32_t span = after->t_us - before->t_us;
+    uint32_t w_q16 = span ? (uint32_t)(((uint64_t)(power.t_us - before->t_us) << 16) / span) : 0;
+    out.cells.t_us = power.t_us;
+    out.cells.count = before->count;
+    for (uint8_t k = 0; k < before->count; ++k) {
+      int64_t d = (int64_t)after->cell_uV[k] - before->cell_uV[k];
+      out.cells.cell_uV[k] = before->cell_uV[k] + (int32_t)((d * w_q16) >> 16);
+    }
+    out.skew_us = 0;
+  } else {
+    const CellSample* nearest = before ? before : after;
+    out.cells = *nearest;
+    int32_t d = (int32_t)(power.t_us - nearest->t_us);
+    out.skew_us = (uint32_t)(d < 0 ? -d : d);
+  }
+  if (out.skew_us > _maxSkew_us) _maxSkew_us = out.skew_us;
+  return true;
+}
+
+void CellMonitor::writeJson(JsonWriter& w) const {
+  // Time spent per frame against the time a frame takes to convert
+  float frame_us = (float)_frameBytes / SOC_ADC_DIGI_RESULT_BYTES * 1e6f / (_rateHz ? _rateHz : 1);
+  uint32_t frames = _frames;
+  w.beginObject("cell_adc")
+      .field("taps", (uint32_t)_count)
+      .field("rate_Hz", _rateHz)
+      .field("oversample", (uint32_t)_oversample)
+      .field("blocks", _blocks)
+      .field("dropped", _dropped)
+      .field("frames", _frames)
+      .field("overruns", _overruns)
+      .field("skew_max_us", _maxSkew_us)
+      .field("busy_permille", frames ? (float)_busy_us / frames / frame_us * 1000.0f : 0.0f, 2)
+      .endObject();
+}
+
+void CellWindow::reset() {
+  for (uint8_t k = 0; k < CellSample::MAX_CELLS; ++k) {
+    _peak[k].reset();
+    _moments[k].reset();
+  }
+  _cells = 0;
+  _spreadMax_uV = 0;
+  _skewMax_us = 0;
+  _n = 0;
+}
+
+void CellWindow::add(const PackSample& s) {
+  _cells = s.cells.count;
+  PeakHold<int32_t> instant;
+  for (uint8_t k = 0; k < _cells; ++k) {
+    _peak[k].add(s.cells.cell_uV[k]);
+    _moments[k].add(s.cells.cell_uV[k]);
+    instant.add(s.cells.cell_uV[k]);
+  }
+  if (_cells && instant.max - instant.min > _spreadMax_uV) _spreadMax_uV = instant.max - instant.min;
+  if (s.skew_us > _skewMax_us) _skewMax_us = s.skew_us;
+  _n++;
+}
+
+void CellWindow::writeJson(JsonWriter& w) const {
+  w.beginObject("cells").beginArray("min_V");
+  for (uint8_t k = 0; k < _cells; ++k) w.value(_peak[k].min * 1e-6f, 3);
+  w.endArray().beginArray("max_V");
+  for (uint8_t k = 0; k < _cells; ++k) w.value(_peak[k].max * 1e-6f, 3);
+  w.endArray().beginArray("mean_V");
+  for (uint8_t k = 0; k < _cells; ++k) w.value(_moments[k].mean() * 1e-6f, 4);
+  w.endArray()
+      .field("spread_max_mV", _spreadMax_uV * 1e-3f, 1)
+      .field("skew_max_us", _skewMax_us)
+      .endObject();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_adc_cal.h>
+
+#include "json_writer.h"
+#include "power_sample.h"
+#include "ring_buffer.h"
+#include "stream_stats.h"
+
+// One series-cell tap: ADC1 channel (0..7 = GPIO 36, 37, 38, 39, 32, 33,
+// 34, 35), its attenuation, and the divider ratio (tap voltage / pin
+// voltage, e.g. (R1 + R2) / R2; trim it against a meter). Taps are listed
+// from the bottom cell up; each measures from pack negative to the top of
+// its cell. divider 0 = unused entry.
+struct CellTap {
+  uint8_t channel;
+  adc_atten_t atten;
+  float divider;
+};
+
+// One decimated block: every cell's voltage, averaged over the block.
+struct CellSample {
+  static const uint8_t MAX_CELLS = 8;   // ADC1 channels
+
+  uint32_t t_us;                  // middle of the block, on the PowerSample clock
+  uint8_t count;
+  int32_t cell_uV[MAX_CELLS];     // tap k minus tap k - 1
+};
+
+// The combined record: an INA219 sample and the cells at its acquisition time.
+struct PackSample {
+  PowerSample power;
+  CellSample cells;
+  uint32_t skew_us;   // 0 when interpolated between two blocks, else the distance to the nearest
+};
+
+// Per-cell voltages from the ESP32's ADC1 in continuous (DMA) mode.
+//
+// The digital controller scans the taps round-robin at sampleRate_Hz and
+// DMA writes the conversions into the driver's buffer; the cell task only
+// wakes once per DMA frame, adds each conversion to its tap's sum and,
+// every oversample conversions per tap, decimates the block: mean code,
+// then µV through a per-attenuation lookup table built once from
+// esp_adc_cal (its eFuse Vref / two-point characterization), interpolated
+// between entries, times the divider. Per conversion that is one add, so
+// the CPU cost is a few µs per frame (reported as "busy_permille").
+//
+// A frame is one block (at most MAX_FRAME_BYTES), so each block reaches
+// the SPSC ring to the estimation task as soon as it is complete. There
+// align() pairs each INA219 sample with the cells at its t_us: linear
+// between the two blocks around it, or the nearest one while the next is
+// still in flight. Samples reach align() up to an estimation pass after
+// acquisition, so with blocks shorter than that the later block is
+// normally there. Both clocks are esp_timer; a block's stamp is its
+// middle, counted back from when its DMA frame arrived at the conversion
+// rate, so it is late only by the frame's hand-over to the task.
+//
+// ADC1 only: ADC2 is unusable while WiFi is on. The ESP32 runs continuous
+// mode through I2S0, which is then not available for audio.
+class CellMonitor {
+public:
+  static const size_t RING_SIZE = 16;
+  static const uint32_t MAX_FRAME_BYTES = 1024;   // DMA frame: up to 512 conversions
+
+  // Starts the scan over the used entries of taps; returns how many there
+  // are (0 if none, or the ADC driver did not start).
+  uint8_t begin(const CellTap* taps, size_t count, uint32_t sampleRate_Hz, uint16_t oversample, BaseType_t core = 1,
+                UBaseType_t priority = 3);
+  void stop();
+  uint8_t size() const { return _count; }
+
+  // Consumer side (one task only): the cells at power.t_us, from the
+  // blocks received so far. False until the first block.
+  bool align(const PowerSample& power, PackSample& out);
+
+  // "cell_adc": {"taps", "rate_Hz", "oversample", "blocks", "dropped",
+  // "frames", "overruns", "skew_max_us", "busy_permille"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  static const uint8_t HISTORY = 4;
+  static const uint8_t LUT_SHIFT = 5;   // an entry every 32 codes
+  static const uint16_t LUT_POINTS = (4096 >> LUT_SHIFT) + 1;
+
+  static void taskEntry(void* arg);
+  void run();
+  void decimate(uint32_t end_us);
+  int32_t toMicrovolts(const uint16_t* lut, uint32_t sum, uint32_t n) const;
+  void receive();
+
+  uint8_t _count = 0;
+  uint8_t _tapOf[CellSample::MAX_CELLS] = {};      // ADC1 channel -> tap index + 1 (0: not a tap)
+  int32_t _gain_q16[CellSample::MAX_CELLS] = {};   // divider in Q16
+  uint8_t _lutOf[CellSample::MAX_CELLS] = {};
+  uint16_t _lut_mV[ADC_ATTEN_MAX][LUT_POINTS] = {};
+  uint32_t _rateHz = 0;
+  uint16_t _oversample = 1;
+  uint32_t _block_us = 0;
+  uint32_t _frameBytes = 0;
+  TaskHandle_t _task = nullptr;
+
+  // Cell task
+  uint32_t _sum[CellSample::MAX_CELLS] = {};
+  uint32_t _n[CellSample::MAX_CELLS] = {};
+  uint32_t _conversions = 0;
+  SpscRing<CellSample, RING_SIZE> _ring;
+  volatile uint32_t _blocks = 0;
+  volatile uint32_t _dropped = 0;
+  volatile uint32_t _frames = 0;
+  volatile uint32_t _overruns = 0;      // driver buffer full: conversions lost
+  volatile uint32_t _busy_us = 0;
+
+  // Consumer
+  CellSample _history[HISTORY] = {};
+  uint8_t _held = 0;                    // blocks in _history, newest last
+  uint32_t _maxSkew_us = 0;
+};
+
+// Per-cell statistics of one publish window, from the combined records.
+class CellWindow {
+public:
+  void reset();
+  void add(const PackSample& s);
+  uint32_t count() const { return _n; }
+
+  // "cells": {"min_V": [..], "max_V": [..], "mean_V": [..],
+  // "spread_max_mV", "skew_max_us"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  uint8_t _cells = 0;
+  PeakHold<int32_t> _peak[CellSample::MAX_CELLS];
+  Welford<int32_t> _moments[CellSample::MAX_CELLS];
+  int32_t _spreadMax_uV = 0;   // widest top-to-bottom cell spread at one instant
+  uint32_t _skewMax_us = 0;
+  uint32_t _n = 0;
+};
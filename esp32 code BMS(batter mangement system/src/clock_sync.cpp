@@ -0,0 +1,89 @@
+#include "clock_sync.h"
+
+#include <Arduino.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+namespace {
+
+// Written by the SNTP callback (LWIP task), read by the estimation and
+// network tasks; 64-bit fields, hence the lock.
+portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+bool haveSync = false;
+int64_t fromOffset_us = 0;   // UTC - monotonic before slewStart_us
+int64_t toOffset_us = 0;     // ... once the slew has caught up
+uint64_t slewStart_us = 0;
+uint64_t lastSync_us = 0;
+int32_t lastCorrection_us = 0;
+uint32_t syncCount = 0;
+uint32_t stepCount = 0;
+
+// Call with the lock held.
+int64_t offsetAt(uint64_t mono_us) {
+  if (mono_us <= slewStart_us || fromOffset_us == toOffset_us) return fromOffset_us;
+  int64_t span = toOffset_us - fromOffset_us;
+  int64_t done = (int64_t)((mono_us - slewStart_us) * ClockSync::SLEW_PPM / 1000000);
+  if (span > 0) return done >= span ? toOffset_us : fromOffset_us + done;
+  return done >= -span ? toOffset_us : fromOffset_us - done;
+}
+
+}  // namespace
+
+void ClockSync::begin(const char* server1, const char* server2, uint32_t resync_ms) {
+  sntp_set_time_sync_notification_cb(onSync);
+  sntp_set_sync_interval(resync_ms);
+  configTime(0, 0, server1, server2);
+}
+
+uint64_t ClockSync::monotonic_us() { return (uint64_t)esp_timer_get_time(); }
+
+void ClockSync::onSync(struct timeval* tv) {
+  uint64_t mono = monotonic_us();
+  int64_t measured = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec - (int64_t)mono;
+  portENTER_CRITICAL(&lock);
+  int64_t current = offsetAt(mono);
+  int64_t correction = measured - current;
+  bool step = !haveSync || correction >= (int64_t)STEP_US || correction <= -(int64_t)STEP_US;
+  if (step) {
+    fromOffset_us = measured;
+    if (haveSync) stepCount++;
+  } else {
+    fromOffset_us = current;
+  }
+  toOffset_us = measured;
+  slewStart_us = mono;
+  lastSync_us = mono;
+  if (correction > INT32_MAX) correction = INT32_MAX;
+  if (correction < INT32_MIN) correction = INT32_MIN;
+  lastCorrection_us = haveSync ? (int32_t)correction : 0;
+  haveSync = true;
+  syncCount++;
+  portEXIT_CRITICAL(&lock);
+}
+
+bool ClockSync::synced() const { return haveSync; }
+
+uint64_t ClockSync::utc_us(uint64_t mono_us) const {
+  portENTER_CRITICAL(&lock);
+  uint64_t utc = haveSync ? (uint64_t)((int64_t)mono_us + offsetAt(mono_us)) : 0;
+  portEXIT_CRITICAL(&lock);
+  return utc;
+}
+
+void ClockSync::writeJson(JsonWriter& w) const {
+  portENTER_CRITICAL(&lock);
+  bool isSynced = haveSync;
+  uint32_t syncs = syncCount;
+  uint32_t steps = stepCount;
+  int32_t correction = lastCorrection_us;
+  uint64_t since_s = isSynced ? (monotonic_us() - lastSync_us) / 1000000 : 0;
+  portEXIT_CRITICAL(&lock);
+  w.beginObject("clock")
+      .field("synced", isSynced)
+      .field("syncs", syncs)
+      .field("steps", steps)
+      .field("last_correction_us", correction)
+      .field("since_sync_s", (uint32_t)since_s)
+      .endObject();
+}
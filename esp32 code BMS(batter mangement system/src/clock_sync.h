@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "json_writer.h"
+
+// Wall-clock time for telemetry: SNTP in the background, mapped onto the
+// 64-bit microsecond monotonic clock (esp_timer_get_time(), never wraps,
+// keeps counting through light sleep).
+//
+// Samples keep their 32-bit micros() stamp from acquisition; extend() turns
+// one into the 64-bit clock (exact while the sample is younger than the
+// 71-minute wrap) and utc_us() into UTC. A sync stores the offset between
+// the two clocks. Corrections below STEP_US are slewed in at SLEW_PPM, so
+// consecutive timestamps never run backwards and the spacing between them
+// stays true to within 0.05 %; the first sync and larger errors step.
+// The SNTP callback carries no context, so there is one clock per device:
+// every instance reads the same state.
+class ClockSync {
+public:
+  static const uint32_t STEP_US = 1000000;
+  static const uint32_t SLEW_PPM = 500;
+
+  // Starts SNTP (UTC, no DST); servers must stay valid. The LWIP interval
+  // floor is 15 s.
+  void begin(const char* server1, const char* server2, uint32_t resync_ms);
+
+  static uint64_t monotonic_us();
+  // 64-bit monotonic time of a micros() stamp taken at most ~71 min ago.
+  static uint64_t extend(uint32_t t_us) { return extend(t_us, monotonic_us()); }
+  static uint64_t extend(uint32_t t_us, uint64_t now_us) { return now_us - (uint32_t)((uint32_t)now_us - t_us); }
+
+  bool synced() const;
+  // UTC in us / ms since the epoch of a monotonic time, 0 until the first sync.
+  uint64_t utc_us(uint64_t mono_us) const;
+  uint64_t utc_ms(uint64_t mono_us) const { return utc_us(mono_us) / 1000; }
+  uint64_t utcNow_ms() const { return utc_ms(monotonic_us()); }
+
+  // "clock": {"synced", "syncs", "steps", "last_correction_us", "since_sync_s"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  static void onSync(struct timeval* tv);
+};
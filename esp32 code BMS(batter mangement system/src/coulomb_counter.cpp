@@ -0,0 +1,73 @@
+#include "coulomb_counter.h"
+
+#include <math.h>
+
+void CoulombCounter::begin(float capacity_mAh, float initialSoc_percent) {
+  setCapacity_mAh(capacity_mAh);
+  reset(initialSoc_percent);
+}
+
+void CoulombCounter::setCapacity_mAh(float capacity_mAh) {
+  _capacity_uAs = (int64_t)llroundf(capacity_mAh * 1000.0f) * 3600;
+  if (_remaining_uAs > _capacity_uAs) _remaining_uAs = _capacity_uAs;
+}
+
+void CoulombCounter::reset(float soc_percent) {
+  if (soc_percent < 0.0f) soc_percent = 0.0f;
+  if (soc_percent > 100.0f) soc_percent = 100.0f;
+  _remaining_uAs = (int64_t)((double)_capacity_uAs * soc_percent / 100.0);
+  _consumed_uAs = 0;
+  _remainder2_uAus = 0;
+  _samples = 0;
+  _primed = false;
+}
+
+void CoulombCounter::restore(int64_t consumed_uAs, int64_t remaining_uAs) {
+  _consumed_uAs = consumed_uAs;
+  _remaining_uAs = remaining_uAs < 0 ? 0 : (remaining_uAs > _capacity_uAs ? _capacity_uAs : remaining_uAs);
+  _remainder2_uAus = 0;
+  _samples = 0;
+  _primed = false;
+}
+
+void CoulombCounter::addSample(uint32_t t_us, float current_mA) {
+  addSample_uA(t_us, (int32_t)lroundf(current_mA * 1000.0f));
+}
+
+void CoulombCounter::addSample_uA(uint32_t t_us, int32_t current_uA) {
+  _samples++;
+  if (!_primed) {
+    // Nothing to integrate until there are two points.
+    _primed = true;
+    _lastT_us = t_us;
+    _lastCurrent_uA = current_uA;
+    return;
+  }
+
+  uint32_t dt_us = t_us - _lastT_us;   // wrap-safe
+  // Twice the trapezoid area in µA·µs. For anything the INA219 can report
+  // (|I| < 40 A) and any dt < 2^32 µs this stays well inside int64.
+  int64_t area2 = ((int64_t)_lastCurrent_uA + current_uA) * (int64_t)dt_us;
+  _lastT_us = t_us;
+  _lastCurrent_uA = current_uA;
+  accumulate(area2);
+}
+
+// The trapezoid's /2 is folded into the carry divisor.
+void CoulombCounter::accumulate(int64_t area2_uAus) {
+  _remainder2_uAus += area2_uAus;
+  int64_t carry = _remainder2_uAus / (2 * US_PER_S);
+  if (carry == 0) return;
+  _remainder2_uAus -= carry * 2 * US_PER_S;
+
+  _consumed_uAs += carry;
+  _remaining_uAs -= carry;
+  if (_remaining_uAs < 0) _remaining_uAs = 0;
+  if (_remaining_uAs > _capacity_uAs) _remaining_uAs = _capacity_uAs;
+}
+
+float CoulombCounter::soc_percent() const {
+  if (_capacity_uAs <= 0) return 0.0f;
+  // Ratio first: remaining <= capacity then can't round to more than 100 %.
+  return (float)_remaining_uAs / (float)_capacity_uAs * 100.0f;
+}
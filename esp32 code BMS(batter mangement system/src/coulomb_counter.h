@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// Coulomb counter with trapezoidal integration into a 64-bit fixed-point
+// accumulator.
+//
+// Charge is kept in whole microampere-seconds (µAs) plus an exact
+// sub-µAs remainder in µA·µs, so no precision is lost however long the
+// device runs (2 A for a year is ~6e13 µAs, far from int64 limits).
+// Timestamps are 32-bit free-running microsecond counters; deltas are taken
+// with unsigned arithmetic so counter wraparound is harmless.
+//
+// Sign convention follows the INA219 wiring: positive current = discharge.
+class CoulombCounter {
+public:
+  void begin(float capacity_mAh, float initialSoc_percent);
+  // Restart integration at a known state of charge (keeps capacity).
+  void reset(float soc_percent);
+  // Resume from a checkpoint (see soc_checkpoint.h); remaining is clamped
+  // to the configured capacity.
+  void restore(int64_t consumed_uAs, int64_t remaining_uAs);
+  void setCapacity_mAh(float capacity_mAh);
+
+  void addSample(uint32_t t_us, float current_mA);
+  void addSample_uA(uint32_t t_us, int32_t current_uA);
+
+  // O(1) views of the integrator state.
+  int64_t consumed_uAs() const { return _consumed_uAs; }
+  int64_t remaining_uAs() const { return _remaining_uAs; }
+  int64_t capacity_uAs() const { return _capacity_uAs; }
+  float consumed_mAh() const { return (float)_consumed_uAs / UAS_PER_MAH; }
+  float remaining_mAh() const { return (float)_remaining_uAs / UAS_PER_MAH; }
+  float soc_percent() const;
+  uint32_t sampleCount() const { return _samples; }
+
+  static constexpr int64_t UAS_PER_MAH = 3600000;   // 1 mAh = 3.6 As = 3.6e6 µAs
+
+private:
+  static constexpr int64_t US_PER_S = 1000000;
+
+  void accumulate(int64_t area2_uAus);
+
+  int64_t _capacity_uAs = 0;
+  int64_t _remaining_uAs = 0;
+  int64_t _consumed_uAs = 0;
+  int64_t _remainder2_uAus = 0;   // 2x the sub-µAs remainder, |value| < 2 * US_PER_S
+  int32_t _lastCurrent_uA = 0;
+  uint32_t _lastT_us = 0;
+  uint32_t _samples = 0;
+  bool _primed = false;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE, reflected), bitwise: NVS records are a few dozen bytes and
+// a firmware image costs ~0.2 s spread over its chunks, not worth a 1 KB
+// table. Running form for data that arrives in pieces: start from CRC32_INIT, feed
+// every piece through crc32Update() and invert the result at the end.
+static const uint32_t CRC32_INIT = 0xFFFFFFFF;
+
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t b = 0; b < 8; ++b) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+inline uint32_t crc32(const uint8_t* data, size_t len) { return ~crc32Update(CRC32_INIT, data, len); }
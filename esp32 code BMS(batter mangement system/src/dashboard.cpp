@@ -0,0 +1,86 @@
+#include "dashboard.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "json_writer.h"
+
+void Dashboard::begin(Adafruit_GFX* gfx, uint16_t color, uint16_t bg) {
+  _gfx = gfx;
+  _color = color;
+  _bg = bg;
+  _labelsDrawn = false;
+}
+
+bool Dashboard::addLabel(int16_t x, int16_t y, uint8_t size, const char* text) {
+  if (_labelCount >= MAX_LABELS) return false;
+  _labels[_labelCount++] = { x, y, size, text };
+  _labelsDrawn = false;
+  return true;
+}
+
+bool Dashboard::addField(int16_t x, int16_t y, uint8_t size, GFXTextRun::Align align, uint8_t decimals,
+                         const char* suffix) {
+  if (_fieldCount >= MAX_FIELDS || !_gfx) return false;
+  Field& f = _fields[_fieldCount++];
+  f.run = new GFXTextRun(_gfx, x, y, align);
+  f.run->setColors(_color, _bg);
+  f.size = size;
+  f.decimals = decimals;
+  f.suffix = suffix ? suffix : "";
+  f.text[0] = '\0';
+  f.hysteresis = 0.0f;
+  f.dirty = true;
+  return true;
+}
+
+void Dashboard::setHysteresis(uint8_t field, float delta) {
+  if (field < _fieldCount) _fields[field].hysteresis = delta;
+}
+
+void Dashboard::set(uint8_t field, float value) {
+  if (field >= _fieldCount) return;
+  Field& f = _fields[field];
+  if (f.text[0] && f.hysteresis > 0.0f && fabsf(value - f.shown) < f.hysteresis) return;
+  char text[TEXT_LEN];
+  size_t suffixLen = strlen(f.suffix);
+  if (suffixLen >= TEXT_LEN) return;
+  size_t n = formatFixed(text, TEXT_LEN - suffixLen, value, f.decimals);
+  memcpy(text + n, f.suffix, suffixLen + 1);
+  if (strcmp(text, f.text) == 0) return;   // same digits: nothing to draw
+  memcpy(f.text, text, sizeof(text));
+  f.shown = value;
+  f.dirty = true;
+}
+
+bool Dashboard::render() {
+  if (!_gfx) return false;
+  bool drew = false;
+  if (!_labelsDrawn) {
+    _gfx->setTextColor(_color);
+    for (uint8_t k = 0; k < _labelCount; ++k) {
+      const Label& l = _labels[k];
+      _gfx->setTextSize(l.size);
+      _gfx->setCursor(l.x, l.y);
+      _gfx->print(l.text);
+    }
+    _labelsDrawn = true;
+    drew = _labelCount > 0;
+  }
+  for (uint8_t k = 0; k < _fieldCount; ++k) {
+    Field& f = _fields[k];
+    if (!f.dirty) continue;
+    _gfx->setTextSize(f.size);
+    drew |= f.run->print(f.text);
+    f.dirty = false;
+  }
+  return drew;
+}
+
+void Dashboard::invalidate() {
+  _labelsDrawn = false;
+  for (uint8_t k = 0; k < _fieldCount; ++k) {
+    _fields[k].run->invalidate();
+    _fields[k].dirty = true;
+  }
+}
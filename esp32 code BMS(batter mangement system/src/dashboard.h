@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+// Retained-mode screen: static labels and numeric value fields are declared
+// once, values are pushed with set(), and render() draws only what changed.
+// Labels are painted on the first render() after invalidate(); a field is
+// redrawn only when its formatted text differs from what is on screen, and
+// then only the glyphs that changed (GFXTextRun). Drawing goes through the
+// display's normal primitives, so on the SSD1306 the changed glyphs are
+// exactly what the next partial display() sends. A field can also be given
+// a hysteresis, so a value dithering across a last-digit boundary does not
+// redraw on every set().
+class Dashboard {
+public:
+  static const uint8_t MAX_LABELS = 12;
+  static const uint8_t MAX_FIELDS = 8;
+  static const uint8_t TEXT_LEN = 16;   // formatted value incl. suffix
+
+  void begin(Adafruit_GFX* gfx, uint16_t color, uint16_t bg);
+
+  // Both return false once full. Text and suffix must outlive the dashboard.
+  bool addLabel(int16_t x, int16_t y, uint8_t size, const char* text);
+  // Field ids are assigned in order from 0. x is the left edge, right edge
+  // or center of the value per align.
+  bool addField(int16_t x, int16_t y, uint8_t size, GFXTextRun::Align align, uint8_t decimals,
+                const char* suffix = "");
+
+  // set() ignores values within delta of the one on screen (0: any change of
+  // the formatted text redraws).
+  void setHysteresis(uint8_t field, float delta);
+  void set(uint8_t field, float value);
+  // Returns true if anything was drawn (a display() is due).
+  bool render();
+  // Call after the screen was cleared or used for something else: the next
+  // render() paints every label and field.
+  void invalidate();
+
+private:
+  struct Label {
+    int16_t x, y;
+    uint8_t size;
+    const char* text;
+  };
+  struct Field {
+    GFXTextRun* run;
+    uint8_t size;
+    uint8_t decimals;
+    const char* suffix;
+    char text[TEXT_LEN];
+    float shown;        // value behind text
+    float hysteresis;
+    bool dirty;
+  };
+
+  Adafruit_GFX* _gfx = nullptr;
+  uint16_t _color = 1, _bg = 0;
+  Label _labels[MAX_LABELS] = {};
+  Field _fields[MAX_FIELDS] = {};
+  uint8_t _labelCount = 0;
+  uint8_t _fieldCount = 0;
+  bool _labelsDrawn = false;
+};
@@ -0,0 +1,212 @@
+#include "energy_meter.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "crc32.h"
+
+static const char* NVS_NAMESPACE = "energy";
+static const char* SLOT_KEYS[2] = {"a", "b"};
+static const uint32_t STATE_MAGIC = 0x31474E45;   // "ENG1", bump on layout change
+static const int64_t US_PER_S = 1000000;
+static const uint32_t HOUR_S = 3600;
+static const uint32_t DAY_S = 86400;
+
+namespace {
+
+uint32_t stateCrc(const EnergyMeter::State& s) { return crc32((const uint8_t*)&s, offsetof(EnergyMeter::State, crc)); }
+
+bool valid(const EnergyMeter::State& s) { return s.magic == STATE_MAGIC && s.crc == stateCrc(s); }
+
+// Wrap-safe "a is newer than b".
+bool newer(const EnergyMeter::State& a, const EnergyMeter::State& b) { return (int32_t)(a.seq - b.seq) > 0; }
+
+// Rounded, saturating
+uint32_t scaled(int64_t value, int64_t per) {
+  int64_t v = (value + per / 2) / per;
+  return v > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+// Moves whole units out of rest (2x the value in unit·µs) into the counters
+int64_t carry(int64_t& rest, int64_t area2) {
+  rest += area2;
+  int64_t whole = rest / (2 * US_PER_S);
+  rest -= whole * 2 * US_PER_S;
+  return whole;
+}
+
+// Survives every reset except power loss; garbage after power-on fails the CRC.
+RTC_NOINIT_ATTR EnergyMeter::State rtcState;
+
+}  // namespace
+
+bool EnergyMeter::restore() {
+  // State is ~1.5 KB: find the newer NVS slot reading both into _s, then load it again
+  int8_t slot = -1;
+  uint32_t slotSeq = 0;
+  bool fromNvs = false;
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, true)) {
+    for (uint8_t k = 0; k < 2; ++k) {
+      if (prefs.getBytes(SLOT_KEYS[k], &_s, sizeof(State)) != sizeof(State) || !valid(_s)) continue;
+      if (slot < 0 || (int32_t)(_s.seq - slotSeq) > 0) {
+        slot = k;
+        slotSeq = _s.seq;
+      }
+    }
+    fromNvs = slot >= 0 && prefs.getBytes(SLOT_KEYS[slot], &_s, sizeof(State)) == sizeof(State) &&
+              (!valid(rtcState) || newer(_s, rtcState));
+    prefs.end();
+  }
+  _nextSlot = slot == 0 ? 1 : 0;
+  if (fromNvs) return true;
+  if (valid(rtcState)) {
+    memcpy(&_s, &rtcState, sizeof(State));
+    return true;
+  }
+  memset(&_s, 0, sizeof(State));
+  return false;
+}
+
+void EnergyMeter::add(uint32_t t_us, int32_t battery_uV, int32_t current_uA) {
+  int64_t power_uW = (int64_t)battery_uV * current_uA / US_PER_S;
+  if (_primed) {
+    uint32_t dt_us = t_us - _lastT_us;
+    book(((int64_t)_lastCurrent_uA + current_uA) * dt_us, (_lastPower_uW + power_uW) * dt_us, dt_us);
+  }
+  _lastCurrent_uA = current_uA;
+  _lastPower_uW = power_uW;
+  _lastT_us = t_us;
+  _primed = true;
+}
+
+void EnergyMeter::book(int64_t area2_uAus, int64_t area2_uWus, uint32_t dt_us) {
+  int64_t dq = 0, dqIn = 0, de = 0, deIn = 0;
+  if (area2_uAus >= 0) dq = carry(_restDischarge, area2_uAus);
+  else dqIn = carry(_restCharge, -area2_uAus);
+  if (area2_uWus >= 0) de = carry(_restDischargeW, area2_uWus);
+  else deIn = carry(_restChargeW, -area2_uWus);
+
+  EnergyTotals* sums[3] = {&_s.total, &_s.hour, &_s.day};
+  for (EnergyTotals* t : sums) {
+    t->discharge_uAs += dq;
+    t->charge_uAs += dqIn;
+    t->discharge_uWs += de;
+    t->charge_uWs += deIn;
+  }
+  _s.hourCovered_us += dt_us;
+  _s.dayCovered_us += dt_us;
+}
+
+void EnergyMeter::poll(uint64_t utc_ms) {
+  if (!utc_ms) return;
+  uint32_t now_s = (uint32_t)(utc_ms / 1000);
+  uint32_t hour_s = now_s - now_s % HOUR_S;
+  uint32_t day_s = now_s - now_s % DAY_S;
+  if (!_s.hourStart_s) {
+    // First synced time: what came before belongs to this hour and day
+    _s.hourStart_s = hour_s;
+    _s.dayStart_s = day_s;
+    return;
+  }
+  if (hour_s == _s.hourStart_s) return;
+  finishHour(hour_s);
+  if (day_s != _s.dayStart_s) finishDay(day_s);
+  writeNvs();
+}
+
+EnergyBucket EnergyMeter::close(uint32_t start_s, const EnergyTotals& t, uint64_t covered_us) {
+  EnergyBucket b;
+  b.start_s = start_s;
+  b.covered_s = scaled((int64_t)covered_us, US_PER_S);
+  b.charge_uAh = scaled(t.charge_uAs, 3600);
+  b.discharge_uAh = scaled(t.discharge_uAs, 3600);
+  b.charge_mWh = scaled(t.charge_uWs, 3600000);
+  b.discharge_mWh = scaled(t.discharge_uWs, 3600000);
+  return b;
+}
+
+void EnergyMeter::finishHour(uint32_t nextStart_s) {
+  _s.hours[_s.hourHead] = close(_s.hourStart_s, _s.hour, _s.hourCovered_us);
+  _s.hourHead = (_s.hourHead + 1) % HOURS;
+  if (_s.hoursUnsent < HOURS) _s.hoursUnsent++;
+  memset(&_s.hour, 0, sizeof(_s.hour));
+  _s.hourCovered_us = 0;
+  _s.hourStart_s = nextStart_s;
+}
+
+void EnergyMeter::finishDay(uint32_t nextStart_s) {
+  _s.days[_s.dayHead] = close(_s.dayStart_s, _s.day, _s.dayCovered_us);
+  _s.dayHead = (_s.dayHead + 1) % DAYS;
+  if (_s.daysUnsent < DAYS) _s.daysUnsent++;
+  memset(&_s.day, 0, sizeof(_s.day));
+  _s.dayCovered_us = 0;
+  _s.dayStart_s = nextStart_s;
+}
+
+void EnergyMeter::checkpoint() {
+  _s.magic = STATE_MAGIC;
+  _s.seq++;
+  _s.crc = stateCrc(_s);
+  memcpy(&rtcState, &_s, sizeof(State));
+}
+
+void EnergyMeter::save() { writeNvs(); }
+
+void EnergyMeter::writeNvs() {
+  checkpoint();
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return;
+  size_t written = prefs.putBytes(SLOT_KEYS[_nextSlot], &_s, sizeof(State));
+  prefs.end();
+  if (written != sizeof(State)) return;
+  _nextSlot ^= 1;
+  _nvsWrites++;
+}
+
+// The unsent bucket that ended first; an hour before the day it closes
+static const EnergyBucket* oldestUnsent(const EnergyMeter::State& s, bool& day) {
+  const EnergyBucket* h = nullptr;
+  const EnergyBucket* d = nullptr;
+  if (s.hoursUnsent) h = &s.hours[(s.hourHead + EnergyMeter::HOURS - s.hoursUnsent) % EnergyMeter::HOURS];
+  if (s.daysUnsent) d = &s.days[(s.dayHead + EnergyMeter::DAYS - s.daysUnsent) % EnergyMeter::DAYS];
+  day = d && (!h || d->start_s + DAY_S < h->start_s + HOUR_S);
+  return day ? d : h;
+}
+
+bool EnergyMeter::writeSummary(JsonWriter& w) const {
+  bool day;
+  const EnergyBucket* b = oldestUnsent(_s, day);
+  if (!b) return false;
+  w.beginObject()
+      .field("period", day ? "day" : "hour")
+      .field("ts", (uint64_t)b->start_s * 1000)
+      .field("covered_s", b->covered_s)
+      .field("charge_Ah", b->charge_uAh * 1e-6f, 4)
+      .field("discharge_Ah", b->discharge_uAh * 1e-6f, 4)
+      .field("charge_Wh", b->charge_mWh * 1e-3f, 3)
+      .field("discharge_Wh", b->discharge_mWh * 1e-3f, 3)
+      .endObject();
+  return w.ok();
+}
+
+void EnergyMeter::markSent() {
+  bool day;
+  if (!oldestUnsent(_s, day)) return;
+  if (day) _s.daysUnsent--;
+  else _s.hoursUnsent--;
+}
+
+void EnergyMeter::writeJson(JsonWriter& w) const {
+  w.beginObject("energy")
+      .field("charge_Ah", (float)(_s.total.charge_uAs / 3.6e9), 3)
+      .field("discharge_Ah", (float)(_s.total.discharge_uAs / 3.6e9), 3)
+      .field("charge_Wh", (float)(_s.total.charge_uWs / 3.6e9), 2)
+      .field("discharge_Wh", (float)(_s.total.discharge_uWs / 3.6e9), 2)
+      .field("unsent", (uint32_t)unsent())
+      .field("nvs_writes", _nvsWrites)
+      .endObject();
+}
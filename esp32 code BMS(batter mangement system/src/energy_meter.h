@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "json_writer.h"
+
+// Charge and energy in both directions, split at the pack, kept exact.
+// Whole µAs / µWs; the sub-unit rest of each integral is carried, so
+// nothing is lost however many samples go in.
+struct EnergyTotals {
+  int64_t charge_uAs;
+  int64_t discharge_uAs;
+  int64_t charge_uWs;
+  int64_t discharge_uWs;
+};
+
+// One closed hour or (UTC) day.
+struct EnergyBucket {
+  uint32_t start_s;         // UTC seconds at the start, 0 = empty slot
+  uint32_t covered_s;       // time the samples spanned (less than the period after a gap or reboot)
+  uint32_t charge_uAh;
+  uint32_t discharge_uAh;
+  uint32_t charge_mWh;
+  uint32_t discharge_mWh;
+};
+
+// On-device energy accounting: charge / discharge Ah and Wh counters, the
+// last HOURS hourly and DAYS daily buckets, so dashboards read summaries
+// instead of integrating every raw reading.
+//
+// add() integrates each sample (trapezoid on current and on V * I, each
+// interval booked to the direction of its average) into the lifetime
+// totals and the open hour and day. poll() closes them on UTC hour and day
+// boundaries once the clock is synced; until then everything goes into the
+// open buckets, which the first synced hour and day then carry. Each closed
+// bucket is queued for publication (takeSummary()) until handed over, so a
+// broker outage is bridged by the rings.
+//
+// Persistence follows SocCheckpoint: checkpoint() refreshes a CRC-checked
+// copy in RTC memory (survives every reset but power loss), and closing a
+// bucket or save() also writes one of two alternating NVS slots. A power
+// cut loses at most the hour in progress.
+class EnergyMeter {
+public:
+  static const uint8_t HOURS = 24;
+  static const uint8_t DAYS = 31;
+
+  // Newest valid copy from RTC or NVS; false if there is none (fresh start).
+  bool restore();
+  // Estimation task: battery terminal voltage and signed current (positive = discharge).
+  void add(uint32_t t_us, int32_t battery_uV, int32_t current_uA);
+  // Estimation task, every pass; utc_ms 0 while the clock is not synced.
+  void poll(uint64_t utc_ms);
+  void checkpoint();   // RTC copy
+  void save();         // RTC and NVS, e.g. before a planned restart
+
+  const EnergyTotals& totals() const { return _s.total; }
+  uint8_t unsent() const { return _s.hoursUnsent + _s.daysUnsent; }
+  // The oldest closed bucket not handed over yet, days before hours:
+  // {"period": "hour" | "day", "start", "covered_s", "charge_Ah",
+  // "discharge_Ah", "charge_Wh", "discharge_Wh"}. markSent() once it is
+  // queued for the broker. False if there is none or w overflowed.
+  bool writeSummary(JsonWriter& w) const;
+  void markSent();
+
+  // "energy": {"charge_Ah", "discharge_Ah", "charge_Wh", "discharge_Wh",
+  // "unsent", "nvs_writes"}
+  void writeJson(JsonWriter& w) const;
+
+  // Everything that survives a reset (see restore()).
+  struct State {
+    uint32_t magic;
+    uint32_t seq;
+    EnergyTotals total;
+    EnergyTotals hour;        // open buckets
+    EnergyTotals day;
+    uint64_t hourCovered_us;
+    uint64_t dayCovered_us;
+    uint32_t hourStart_s;     // 0 until the clock is synced
+    uint32_t dayStart_s;
+    EnergyBucket hours[HOURS];
+    EnergyBucket days[DAYS];
+    uint8_t hourHead;         // next slot to write
+    uint8_t dayHead;
+    uint8_t hoursUnsent;      // newest closed buckets not published yet
+    uint8_t daysUnsent;
+    uint32_t crc;             // CRC-32 of every byte before this field
+  };
+
+private:
+  void book(int64_t area2_uAus, int64_t area2_uWus, uint32_t dt_us);
+  static EnergyBucket close(uint32_t start_s, const EnergyTotals& t, uint64_t covered_us);
+  void finishHour(uint32_t nextStart_s);
+  void finishDay(uint32_t nextStart_s);
+  void writeNvs();
+
+  State _s = {};
+  // Sub-unit rests, 2x the value in µA·µs / µW·µs per direction
+  int64_t _restCharge = 0;
+  int64_t _restDischarge = 0;
+  int64_t _restChargeW = 0;
+  int64_t _restDischargeW = 0;
+  int32_t _lastCurrent_uA = 0;
+  int64_t _lastPower_uW = 0;
+  uint32_t _lastT_us = 0;
+  bool _primed = false;
+  uint8_t _nextSlot = 0;
+  uint32_t _nvsWrites = 0;
+};
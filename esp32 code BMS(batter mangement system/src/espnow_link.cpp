@@ -0,0 +1,196 @@
+#include "espnow_link.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <string.h>
+
+#include "mem_placement.h"
+
+namespace {
+
+const uint8_t FRAME_MAGIC = 'B';
+const uint8_t MAX_CHANNEL = 13;
+EspNowLink* activeLink = nullptr;   // the callbacks carry no context
+
+}  // namespace
+
+bool EspNowLink::beginNode(const uint8_t gateway[6], uint8_t channel) {
+  WiFi.mode(WIFI_STA);
+  WiFi.disconnect();
+  _channel = channel >= 1 && channel <= MAX_CHANNEL ? channel : 1;
+  esp_wifi_set_channel(_channel, WIFI_SECOND_CHAN_NONE);
+  if (esp_now_init() != ESP_OK) return false;
+  activeLink = this;
+  esp_now_register_send_cb(onSent);
+  memcpy(_peer, gateway, sizeof(_peer));
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, gateway, sizeof(peer.peer_addr));
+  peer.channel = 0;   // whatever channel the radio is on, so hop() needs no peer change
+  peer.ifidx = WIFI_IF_STA;
+  if (esp_now_add_peer(&peer) != ESP_OK) return false;
+  _gateway = false;
+  _ready = true;
+  return true;
+}
+
+bool EspNowLink::beginGateway() {
+  _nodes = (Assembly*)placeAlloc(MAX_NODES * sizeof(Assembly), MemRegion::Bulk);
+  if (!_nodes) return false;
+  for (uint8_t k = 0; k < MAX_NODES; ++k) {
+    _nodes[k].used = false;
+    _nodes[k].complete.store(false, std::memory_order_relaxed);
+  }
+  // Modem sleep would miss frames between beacons
+  esp_wifi_set_ps(WIFI_PS_NONE);
+  if (esp_now_init() != ESP_OK) return false;
+  activeLink = this;
+  _gateway = true;
+  esp_now_register_recv_cb(onReceive);
+  _ready = true;
+  return true;
+}
+
+bool EspNowLink::send(const uint8_t* data, size_t len) {
+  if (!_ready || _gateway || len == 0 || len > MAX_MESSAGE) return false;
+  if (_frames && _acked.load() + _nacked.load() < _frames) return false;
+  uint8_t count = (uint8_t)((len + FRAME_PAYLOAD - 1) / FRAME_PAYLOAD);
+  _seq++;
+  _acked.store(0);
+  _nacked.store(0);
+  _frames = count;
+  _sent++;
+  uint8_t frame[FRAME_HEADER + FRAME_PAYLOAD];
+  for (uint8_t k = 0; k < count; ++k) {
+    size_t off = (size_t)k * FRAME_PAYLOAD;
+    size_t n = len - off < FRAME_PAYLOAD ? len - off : FRAME_PAYLOAD;
+    frame[0] = FRAME_MAGIC;
+    frame[1] = _seq;
+    frame[2] = (uint8_t)(k << 4 | count);
+    memcpy(frame + FRAME_HEADER, data + off, n);
+    if (esp_now_send(_peer, frame, FRAME_HEADER + n) != ESP_OK) {
+      // Never queued, so no callback: account for the rest here
+      _nacked.fetch_add(count - k);
+      break;
+    }
+  }
+  return true;
+}
+
+EspNowLink::SendResult EspNowLink::sendResult() {
+  if (!_frames) return SendResult::Idle;
+  uint8_t acked = _acked.load(), nacked = _nacked.load();
+  if (acked + nacked < _frames) return SendResult::Pending;
+  _frames = 0;
+  if (!nacked) {
+    _delivered++;
+    _failStreak = 0;
+    return SendResult::Delivered;
+  }
+  _failed++;
+  if (++_failStreak >= HOP_AFTER_FAILURES) hop();
+  return SendResult::Failed;
+}
+
+void EspNowLink::hop() {
+  _failStreak = 0;
+  _channel = _channel >= MAX_CHANNEL ? 1 : _channel + 1;
+  esp_wifi_set_channel(_channel, WIFI_SECOND_CHAN_NONE);
+  _hops++;
+}
+
+void EspNowLink::onSent(const uint8_t*, esp_now_send_status_t status) {
+  if (!activeLink) return;
+  if (status == ESP_NOW_SEND_SUCCESS) activeLink->_acked.fetch_add(1);
+  else activeLink->_nacked.fetch_add(1);
+}
+
+void EspNowLink::onReceive(const uint8_t* mac, const uint8_t* data, int len) {
+  if (activeLink && len > 0) activeLink->received(mac, data, (size_t)len);
+}
+
+EspNowLink::Assembly* EspNowLink::slotFor(const uint8_t* mac) {
+  Assembly* fresh = nullptr;
+  for (uint8_t k = 0; k < MAX_NODES; ++k) {
+    Assembly& a = _nodes[k];
+    if (a.used && memcmp(a.mac, mac, 6) == 0) return &a;
+    if (!a.used && !fresh) fresh = &a;
+  }
+  if (fresh) {
+    memcpy(fresh->mac, mac, 6);
+    fresh->used = true;
+    fresh->have = 0;
+  }
+  return fresh;
+}
+
+// WiFi task
+void EspNowLink::received(const uint8_t* mac, const uint8_t* data, size_t len) {
+  if (len <= FRAME_HEADER || data[0] != FRAME_MAGIC) {
+    _bad.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uint8_t seq = data[1];
+  uint8_t index = data[2] >> 4, count = data[2] & 0x0F;
+  size_t n = len - FRAME_HEADER;
+  if (!count || count > MAX_FRAGMENTS || index >= count || (index < count - 1 && n != FRAME_PAYLOAD)) {
+    _bad.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Assembly* a = slotFor(mac);
+  if (!a || a->complete.load(std::memory_order_acquire)) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);   // no slot, or the last one is not out yet
+    return;
+  }
+  if (!a->have || a->seq != seq || a->count != count) {
+    a->seq = seq;   // a new message; a half-received older one is abandoned
+    a->count = count;
+    a->have = 0;
+  }
+  memcpy(a->data + (size_t)index * FRAME_PAYLOAD, data + FRAME_HEADER, n);
+  if (index == count - 1) a->lastLen = (uint16_t)n;
+  a->have |= (uint8_t)(1 << index);
+  if (a->have != (uint8_t)((1 << count) - 1)) return;
+  a->have = 0;
+  a->complete.store(true, std::memory_order_release);
+  _completed.push((uint8_t)(a - _nodes));
+  _received.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool EspNowLink::receive(Message& out) {
+  uint8_t* k = _completed.peek();
+  if (!k) return false;
+  const Assembly& a = _nodes[*k];
+  memcpy(out.mac, a.mac, 6);
+  out.len = (uint16_t)((a.count - 1) * FRAME_PAYLOAD + a.lastLen);
+  out.data = a.data;
+  return true;
+}
+
+void EspNowLink::release() {
+  uint8_t* k = _completed.peek();
+  if (!k) return;
+  _nodes[*k].complete.store(false, std::memory_order_release);
+  _completed.release();
+}
+
+void EspNowLink::writeJson(JsonWriter& w) const {
+  w.beginObject("espnow");
+  if (_gateway) {
+    uint32_t nodes = 0;
+    for (uint8_t k = 0; k < MAX_NODES; ++k) nodes += _nodes[k].used ? 1 : 0;
+    w.field("role", "gateway")
+        .field("nodes", nodes)
+        .field("received", _received.load(std::memory_order_relaxed))
+        .field("dropped", _dropped.load(std::memory_order_relaxed))
+        .field("bad", _bad.load(std::memory_order_relaxed));
+  } else {
+    w.field("role", "node")
+        .field("channel", (uint32_t)_channel)
+        .field("sent", _sent)
+        .field("delivered", _delivered)
+        .field("failed", _failed)
+        .field("hops", _hops);
+  }
+  w.endObject();
+}
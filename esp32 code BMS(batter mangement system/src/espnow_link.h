@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_now.h>
+#include <atomic>
+
+#include "json_writer.h"
+#include "ring_buffer.h"
+
+// ESP-NOW transport between sensor nodes and one gateway, so a fleet
+// shares a single broker connection instead of one TLS session per node.
+//
+// A node sends each binary telemetry message (binary_codec.h) to the
+// gateway's MAC, split into at most MAX_FRAGMENTS frames of
+// [u8 'B'][u8 message seq][u8 index << 4 | count][payload]. Unicast frames
+// are acknowledged by the gateway's radio; a node that keeps failing hops
+// to the next channel, so it finds the gateway on whatever channel the
+// gateway's access point uses. Nodes need no association, DHCP or TLS.
+//
+// The gateway reassembles per sender MAC in the WiFi task's receive
+// callback; complete messages wait in their node's slot until the network
+// task has published them (receive() / release()). A node whose previous
+// message is still waiting loses the new one, counted as dropped.
+// One link per device: the ESP-NOW callbacks carry no context.
+class EspNowLink {
+public:
+  static const size_t FRAME_HEADER = 3;
+  static const size_t FRAME_PAYLOAD = 250 - FRAME_HEADER;   // ESP_NOW_MAX_DATA_LEN
+  static const uint8_t MAX_FRAGMENTS = 4;
+  static const size_t MAX_MESSAGE = FRAME_PAYLOAD * MAX_FRAGMENTS;
+  static const uint8_t MAX_NODES = 8;
+  static const uint8_t HOP_AFTER_FAILURES = 3;   // consecutive failed sends
+
+  struct Message {
+    uint8_t mac[6];
+    uint16_t len;
+    const uint8_t* data;
+  };
+
+  // Node: WiFi in station mode without an association, starting on channel
+  // (1..13). Gateway: call once WiFi is started; it follows the AP's
+  // channel. The gateway's reassembly slots are placed as MemRegion::Bulk.
+  bool beginNode(const uint8_t gateway[6], uint8_t channel);
+  bool beginGateway();
+  bool ready() const { return _ready; }
+
+  // Node, network task: starts sending one message (false if one is still
+  // in flight or it is longer than MAX_MESSAGE). data is copied. Poll
+  // sendResult() until it is not Pending.
+  enum class SendResult : uint8_t { Idle, Pending, Delivered, Failed };
+  bool send(const uint8_t* data, size_t len);
+  SendResult sendResult();
+  uint8_t channel() const { return _channel; }
+
+  // Gateway, network task: the oldest complete message, then release() it.
+  bool receive(Message& out);
+  void release();
+
+  // "espnow": {"role", "channel", "sent", "delivered", "failed", "hops"} on a
+  // node; {"role", "nodes", "received", "dropped", "bad"} on a gateway
+  void writeJson(JsonWriter& w) const;
+
+private:
+  struct Assembly {
+    uint8_t mac[6];
+    bool used;
+    std::atomic<bool> complete;   // handed to the network task
+    uint8_t seq;
+    uint8_t count;
+    uint8_t have;                 // fragment bit mask
+    uint16_t lastLen;             // payload of the last fragment
+    uint8_t data[MAX_MESSAGE];
+  };
+
+  static void onSent(const uint8_t* mac, esp_now_send_status_t status);
+  static void onReceive(const uint8_t* mac, const uint8_t* data, int len);
+  void received(const uint8_t* mac, const uint8_t* data, size_t len);
+  Assembly* slotFor(const uint8_t* mac);
+  void hop();
+
+  bool _ready = false;
+  bool _gateway = false;
+  uint8_t _channel = 1;
+  uint8_t _peer[6] = {};
+
+  // Node
+  uint8_t _seq = 0;
+  uint8_t _frames = 0;
+  std::atomic<uint8_t> _acked{0};
+  std::atomic<uint8_t> _nacked{0};
+  uint8_t _failStreak = 0;
+  uint32_t _sent = 0;
+  uint32_t _delivered = 0;
+  uint32_t _failed = 0;
+  uint32_t _hops = 0;
+
+  // Gateway
+  Assembly* _nodes = nullptr;
+  SpscRing<uint8_t, MAX_NODES> _completed;   // indices of complete slots, in order
+  std::atomic<uint32_t> _received{0};
+  std::atomic<uint32_t> _dropped{0};
+  std::atomic<uint32_t> _bad{0};
+};
@@ -0,0 +1,100 @@
+#include "event_capture.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+void EventCapture::begin(uint32_t pre_ms, uint32_t post_ms, PowerSample* ring, size_t capacity) {
+  _ring = ring;
+  _capacity = ring ? capacity : 0;
+  _pre_us = pre_ms * 1000UL;
+  _post_us = post_ms * 1000UL;
+  _state = State::Armed;
+  _head = 0;
+  _size = 0;
+  _holding = false;
+  _primed = false;
+}
+
+void EventCapture::setTriggers(float current_mA, float slew_mA_per_s, float undervoltage_V, uint32_t holdoff_ms) {
+  _current_uA = (int32_t)(current_mA * 1000.0f);
+  _slew_uA_per_s = (int64_t)(slew_mA_per_s * 1000.0f);
+  _undervoltage_uV = (int32_t)(undervoltage_V * 1000000.0f);
+  _holdoff_us = holdoff_ms * 1000UL;
+}
+
+uint8_t EventCapture::triggers(const PowerSample& s) const {
+  uint8_t cause = 0;
+  if (_current_uA > 0 && labs(s.current_uA) >= _current_uA) cause |= EVENT_OVERCURRENT;
+  if (_undervoltage_uV > 0 && s.bus_uV <= _undervoltage_uV) cause |= EVENT_UNDERVOLTAGE;
+  if (_slew_uA_per_s > 0 && _primed) {
+    // |dI| / dt >= slew, cross-multiplied to stay in integers
+    uint32_t dt_us = s.t_us - _last.t_us;
+    int64_t dI_uA = llabs((int64_t)s.current_uA - _last.current_uA);
+    if (dt_us && dI_uA * 1000000 >= _slew_uA_per_s * dt_us) cause |= EVENT_SLEW;
+  }
+  return cause;
+}
+
+void EventCapture::push(const PowerSample& s) {
+  _ring[_head] = s;
+  _head = (_head + 1) % _capacity;
+  if (_size < _capacity) _size++;
+}
+
+void EventCapture::add(const PowerSample& s) {
+  if (!_capacity) return;
+  uint8_t cause = triggers(s);
+  bool rising = cause && !_firing;
+  _firing = cause != 0;
+  _last = s;
+  _primed = true;
+
+  switch (_state) {
+    case State::Ready:
+      if (rising) _missed++;
+      return;
+
+    case State::Armed:
+      push(s);
+      if (_holding && (int32_t)(s.t_us - _holdUntil_us) < 0) return;
+      _holding = false;
+      if (!cause) return;
+      _state = State::Capturing;
+      _cause = cause;
+      _trigT_us = s.t_us;
+      // Keep the samples no older than pre_ms (the trigger sample included)
+      _pre = 1;
+      while (_pre < _size) {
+        const PowerSample& p = _ring[(_head + _capacity - 1 - _pre) % _capacity];
+        if (s.t_us - p.t_us > _pre_us) break;
+        _pre++;
+      }
+      _post = 0;
+      return;
+
+    case State::Capturing:
+      push(s);
+      _cause |= cause;
+      _post++;
+      if (s.t_us - _trigT_us >= _post_us || _pre + _post >= _capacity) freeze();
+      return;
+  }
+}
+
+// Rotate the ring so the event window starts at index 0, in time order.
+void EventCapture::freeze() {
+  size_t n = _pre + _post;
+  size_t start = (_head + _capacity - n) % _capacity;
+  std::rotate(_ring, _ring + start, _ring + _capacity);
+  _state = State::Ready;
+  _events++;
+}
+
+void EventCapture::release() {
+  if (_state != State::Ready) return;
+  _state = State::Armed;
+  _head = 0;
+  _size = 0;
+  _holding = true;
+  _holdUntil_us = _last.t_us + _holdoff_us;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "power_sample.h"
+
+// Why an event was captured (bit mask, several can fire on one sample).
+enum EventCause : uint8_t {
+  EVENT_OVERCURRENT = 0x01,    // |I| >= current threshold
+  EVENT_SLEW = 0x02,           // |dI/dt| >= slew threshold
+  EVENT_UNDERVOLTAGE = 0x04,   // bus voltage <= undervoltage threshold
+};
+
+// Transient recorder with pre-trigger history.
+//
+// Every sample goes into a fixed ring, so the last pre_ms are always on
+// hand. When a trigger fires the recorder keeps the pre_ms before it,
+// collects post_ms after it and then freezes the window in time order for
+// the caller to ship (see encodeEvent() in binary_codec.h). Recording
+// pauses only while a frozen event waits for release(); after release()
+// triggers are ignored for holdoff_ms so one inrush yields one event.
+//
+// add() is O(1) except for the one in-place rotation when an event
+// completes; it runs on the consumer side, so the sampler is never held up.
+// The ring is the caller's, so it can live wherever there is room (PSRAM
+// on boards that have it, see mem_placement.h); a longer ring keeps the
+// full pre/post window at higher sample rates.
+class EventCapture {
+public:
+  static const size_t CAPACITY = 320;   // default ring: pre + post samples (~3 s at 100 Hz)
+
+  // ring holds capacity samples and must outlive the recorder; without one
+  // (nullptr) nothing is recorded.
+  void begin(uint32_t pre_ms, uint32_t post_ms, PowerSample* ring, size_t capacity);
+  size_t capacity() const { return _capacity; }
+  // A threshold of 0 disables that trigger.
+  void setTriggers(float current_mA, float slew_mA_per_s, float undervoltage_V, uint32_t holdoff_ms);
+
+  void add(const PowerSample& s);
+
+  // A completed event is waiting to be shipped.
+  bool ready() const { return _state == State::Ready; }
+  const PowerSample* samples() const { return _ring; }
+  size_t count() const { return _pre + _post; }
+  size_t triggerIndex() const { return _pre - 1; }   // the trigger sample
+  uint8_t cause() const { return _cause; }
+  // Discards the event and re-arms after the holdoff.
+  void release();
+
+  uint32_t events() const { return _events; }
+  // Triggers that fired while an event was waiting for release().
+  uint32_t missed() const { return _missed; }
+
+private:
+  enum class State : uint8_t { Armed, Capturing, Ready };
+
+  uint8_t triggers(const PowerSample& s) const;
+  void push(const PowerSample& s);
+  void freeze();
+
+  PowerSample* _ring = nullptr;
+  size_t _capacity = 0;
+  size_t _head = 0;    // next slot to write
+  size_t _size = 0;
+
+  uint32_t _pre_us = 1000000;
+  uint32_t _post_us = 2000000;
+  uint32_t _holdoff_us = 10000000;
+  int32_t _current_uA = 0;
+  int64_t _slew_uA_per_s = 0;
+  int32_t _undervoltage_uV = 0;
+
+  State _state = State::Armed;
+  uint32_t _trigT_us = 0;
+  uint32_t _holdUntil_us = 0;
+  bool _holding = false;
+  bool _firing = false;   // trigger condition held on the previous sample
+  uint8_t _cause = 0;
+  size_t _pre = 0;
+  size_t _post = 0;
+  uint32_t _events = 0;
+  uint32_t _missed = 0;
+
+  PowerSample _last = {};
+  bool _primed = false;
+};
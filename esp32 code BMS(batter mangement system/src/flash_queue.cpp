@@ -0,0 +1,204 @@
+#include "flash_queue.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_placement.h"
+
+static const char* QUEUE_DIR = "/tq";
+
+bool FlashQueue::begin() {
+  // Both pages are only memcpy'd and handed to LittleFS, which bounces
+  // writes through its own cache: PSRAM where there is some
+  if (!_ram) _ram = (uint8_t*)placeAlloc(PAGE_SIZE, MemRegion::Bulk);
+  if (!_drain) _drain = (uint8_t*)placeAlloc(PAGE_SIZE, MemRegion::Bulk);
+  if (!_ram || !_drain) return false;
+  if (!LittleFS.begin(true)) return false;
+  if (!LittleFS.exists(QUEUE_DIR) && !LittleFS.mkdir(QUEUE_DIR)) return false;
+
+  uint32_t lo = 0, hi = 0, files = 0;
+  uint32_t stale[STALE_BATCH];
+  if (scanPages(lo, hi, files, 0, stale) < 0) return false;
+  _headSeq = files ? lo : 0;
+  _tailSeq = files ? hi + 1 : 0;
+  // Gaps (a reset between write and remove) are skipped by loadOldest()
+  uint32_t span = _tailSeq - _headSeq;
+  _storedPages = span > MAX_PAGES ? MAX_PAGES : (uint16_t)span;
+  _headSeq = _tailSeq - _storedPages;
+  // Pages below the kept span would hold their flash forever. Removing
+  // entries while the directory is open is not safe, hence the batches.
+  int found;
+  bool removed = true;
+  while (removed && (found = scanPages(lo, hi, files, _headSeq, stale)) > 0) {
+    removed = false;
+    char path[24];
+    for (int k = 0; k < found; ++k) {
+      pagePath(path, sizeof(path), stale[k]);
+      if (!LittleFS.remove(path)) continue;
+      removed = true;
+      _droppedPages++;
+    }
+  }
+  _ready = true;
+  return true;
+}
+
+// One pass over the page files: how many there are, their lowest and
+// highest sequence number, and up to STALE_BATCH of those below keepFrom.
+// Returns how many of those, -1 if the directory cannot be read.
+int FlashQueue::scanPages(uint32_t& lo, uint32_t& hi, uint32_t& files, uint32_t keepFrom, uint32_t* stale) const {
+  // Page files are named by their hex sequence number
+  File dir = LittleFS.open(QUEUE_DIR);
+  if (!dir || !dir.isDirectory()) return -1;
+  int found = 0;
+  files = 0;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    const char* name = f.name();
+    const char* slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+    char* end;
+    uint32_t seq = strtoul(name, &end, 16);
+    f.close();
+    if (end == name || *end != '\0') continue;
+    if (!files || seq < lo) lo = seq;
+    if (!files || seq > hi) hi = seq;
+    files++;
+    if (seq < keepFrom && found < STALE_BATCH) stale[found++] = seq;
+  }
+  dir.close();
+  return found;
+}
+
+void FlashQueue::pagePath(char* out, size_t cap, uint32_t seq) const {
+  snprintf(out, cap, "%s/%08lx", QUEUE_DIR, (unsigned long)seq);
+}
+
+bool FlashQueue::push(uint8_t topic, const uint8_t* data, size_t len) {
+  if (!_ram || len > MAX_PAYLOAD) return false;
+  if (_ramUsed + RECORD_OVERHEAD + len > PAGE_SIZE && !flush()) {
+    // No flash to spill to: the RAM page acts as a one-page ring
+    _ramUsed = _ramSent = 0;
+    _droppedPages++;
+  }
+  if (_ramUsed == _ramSent) _ramSince_ms = millis();
+  uint8_t* p = _ram + _ramUsed;
+  p[0] = topic;
+  p[1] = (uint8_t)(len & 0xFF);
+  p[2] = (uint8_t)(len >> 8);
+  memcpy(p + RECORD_OVERHEAD, data, len);
+  _ramUsed += RECORD_OVERHEAD + len;
+  return true;
+}
+
+void FlashQueue::poll(uint32_t now_ms) {
+  if (_ramUsed > _ramSent && now_ms - _ramSince_ms >= _flushInterval_ms) flush();
+}
+
+bool FlashQueue::flush() {
+  if (_ramUsed == _ramSent) return true;
+  if (!writePage(_ram + _ramSent, _ramUsed - _ramSent)) return false;
+  _ramUsed = _ramSent = 0;
+  return true;
+}
+
+bool FlashQueue::writePage(const uint8_t* data, size_t len) {
+  if (!_ready) return false;
+  if (_storedPages >= MAX_PAGES) dropOldest();
+  while (_storedPages > 0 && LittleFS.totalBytes() - LittleFS.usedBytes() < 2 * PAGE_SIZE) dropOldest();
+
+  char path[24];
+  pagePath(path, sizeof(path), _tailSeq);
+  File f = LittleFS.open(path, FILE_WRITE);
+  if (!f) return false;
+  size_t written = f.write(data, len);
+  f.close();
+  if (written != len) {
+    LittleFS.remove(path);
+    return false;
+  }
+  _tailSeq++;
+  _storedPages++;
+  return true;
+}
+
+void FlashQueue::dropOldest() {
+  if (_storedPages == 0) return;
+  if (_drainLoaded) {
+    // Acks come in order and this page's messages were the last sent: theirs will never matter
+    _unacked = _drainSent < _unacked ? _unacked - _drainSent : 0;
+  }
+  char path[24];
+  pagePath(path, sizeof(path), _headSeq);
+  LittleFS.remove(path);
+  _headSeq++;
+  _storedPages--;
+  _droppedPages++;
+  _drainLoaded = false;
+}
+
+bool FlashQueue::loadOldest() {
+  while (_storedPages > 0) {
+    char path[24];
+    pagePath(path, sizeof(path), _headSeq);
+    File f = LittleFS.open(path, FILE_READ);
+    if (f) {
+      _drainUsed = f.read(_drain, PAGE_SIZE);
+      f.close();
+      _drainPos = 0;
+      _drainSent = 0;
+      _drainLoaded = true;
+      return true;
+    }
+    _headSeq++;
+    _storedPages--;
+  }
+  return false;
+}
+
+size_t FlashQueue::sendFrom(const uint8_t* page, size_t used, size_t& pos, SendFn send, size_t budget) {
+  size_t sent = 0;
+  while (budget > 0 && pos < used) {
+    size_t len = pos + RECORD_OVERHEAD <= used ? page[pos + 1] | ((size_t)page[pos + 2] << 8) : used;
+    if (pos + RECORD_OVERHEAD + len > used) {
+      pos = used;   // truncated tail (reset mid-write): skip it
+      break;
+    }
+    if (!send(page[pos], page + pos + RECORD_OVERHEAD, len)) break;
+    if (_awaitAcks) _unacked++;
+    pos += RECORD_OVERHEAD + len;
+    sent++;
+    budget--;
+  }
+  return sent;
+}
+
+size_t FlashQueue::drain(SendFn send, size_t maxMessages) {
+  size_t sent = 0;
+  while (sent < maxMessages) {
+    if (_storedPages > 0) {
+      if (!_drainLoaded && !loadOldest()) continue;
+      size_t n = sendFrom(_drain, _drainUsed, _drainPos, send, maxMessages - sent);
+      _drainSent += n;
+      sent += n;
+      if (_drainPos < _drainUsed) break;
+      // Keep the page until the broker confirmed everything sent from it
+      if (_unacked) break;
+      // A reset before this point replays the page: delivery is at-least-once
+      char path[24];
+      pagePath(path, sizeof(path), _headSeq);
+      LittleFS.remove(path);
+      _headSeq++;
+      _storedPages--;
+      _drainLoaded = false;
+    } else if (_ramUsed > _ramSent) {
+      sent += sendFrom(_ram, _ramUsed, _ramSent, send, maxMessages - sent);
+      if (_ramSent == _ramUsed) _ramUsed = _ramSent = 0;
+      break;
+    } else {
+      break;
+    }
+  }
+  return sent;
+}
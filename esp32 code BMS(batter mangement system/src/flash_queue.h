@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Store-and-forward queue for MQTT messages that could not be published.
+//
+// Messages are framed as [u8 topic][u16 len][payload] and collected in a
+// RAM page; only full pages (or a page older than the flush interval) are
+// written to LittleFS, one file per page, so flash sees one sequential
+// write per PAGE_SIZE bytes instead of one per sample. Page files form a
+// ring: when MAX_PAGES are stored the oldest page is dropped. LittleFS
+// handles wear levelling across the partition.
+//
+// Payloads are stored verbatim, so each message keeps the uptime /
+// timestamp fields it was encoded with. drain() replays the oldest
+// messages first, a bounded number per call, and deletes a page file once
+// every message in it was accepted. With setAwaitAcks(true) accepted is not
+// enough: each replayed message must also be confirmed with acknowledge()
+// (its QoS 1 PUBACK) before the page holding it is deleted.
+class FlashQueue {
+public:
+  static const size_t PAGE_SIZE = 4096;          // one flash sector
+  static const uint16_t MAX_PAGES = 256;         // 1 MiB of backlog
+  static const size_t RECORD_OVERHEAD = 3;       // topic + length
+  static const size_t MAX_PAYLOAD = PAGE_SIZE - RECORD_OVERHEAD;
+
+  // Returns true if the message was handed to the broker.
+  typedef bool (*SendFn)(uint8_t topic, const uint8_t* data, size_t len);
+
+  // Places the two RAM pages (MemRegion::Bulk), mounts LittleFS
+  // (formatting it on first use) and picks up pages left by a previous
+  // boot. Without the pages nothing can be queued.
+  bool begin();
+  bool ready() const { return _ready; }
+
+  // Queues one message. Returns false only if it can never be stored.
+  bool push(uint8_t topic, const uint8_t* data, size_t len);
+  // Writes a partially filled RAM page once it is flushInterval_ms old,
+  // bounding what a reset can lose.
+  void poll(uint32_t now_ms);
+  bool flush();
+
+  // Replays up to maxMessages, oldest first; stops at the first send()
+  // failure. Returns the number of messages sent.
+  size_t drain(SendFn send, size_t maxMessages);
+
+  // Counts replayed messages that still need acknowledge().
+  void setAwaitAcks(bool on) { _awaitAcks = on; }
+  void acknowledge() { if (_unacked) _unacked--; }
+  uint16_t unacked() const { return _unacked; }
+
+  bool empty() const { return _storedPages == 0 && _ramUsed == _ramSent && _unacked == 0; }
+  uint16_t storedPages() const { return _storedPages; }
+  uint32_t droppedPages() const { return _droppedPages; }
+  void setFlushInterval(uint32_t ms) { _flushInterval_ms = ms; }
+
+private:
+  static const int STALE_BATCH = 16;
+
+  void pagePath(char* out, size_t cap, uint32_t seq) const;
+  int scanPages(uint32_t& lo, uint32_t& hi, uint32_t& files, uint32_t keepFrom, uint32_t* stale) const;
+  bool writePage(const uint8_t* data, size_t len);
+  bool loadOldest();
+  void dropOldest();
+  size_t sendFrom(const uint8_t* page, size_t used, size_t& pos, SendFn send, size_t budget);
+
+  bool _ready = false;
+  bool _awaitAcks = false;
+  uint16_t _unacked = 0;
+
+  // Pages on flash occupy sequence numbers [_headSeq, _tailSeq).
+  uint32_t _headSeq = 0;
+  uint32_t _tailSeq = 0;
+  uint16_t _storedPages = 0;
+  uint32_t _droppedPages = 0;
+
+  // Page being filled; [_ramSent, _ramUsed) is still owed to the broker.
+  uint8_t* _ram = nullptr;
+  size_t _ramUsed = 0;
+  size_t _ramSent = 0;
+  uint32_t _ramSince_ms = 0;
+  uint32_t _flushInterval_ms = 60000;
+
+  // Oldest flash page, loaded while draining.
+  uint8_t* _drain = nullptr;
+  size_t _drainUsed = 0;
+  size_t _drainPos = 0;
+  uint16_t _drainSent = 0;    // messages sent from it, for dropOldest()
+  bool _drainLoaded = false;
+};
@@ -0,0 +1,56 @@
+#include "health_monitor.h"
+
+#include <esp_heap_caps.h>
+
+void HealthMonitor::begin(const char* const* taskNames, size_t count) {
+  _names = taskNames;
+  _count = count < MAX_TASKS ? count : MAX_TASKS;
+  sample();
+}
+
+void HealthMonitor::sample() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+  _free = info.total_free_bytes;
+  _largest = info.largest_free_block;
+  _freeBlocks = info.free_blocks;
+  _usedBlocks = info.allocated_blocks;
+  _minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  if (_largest < _minLargest) _minLargest = _largest;
+
+  for (uint8_t k = 0; k < _count; ++k) {
+    TaskHandle_t task = xTaskGetHandle(_names[k]);
+    // StackType_t is one byte on ESP32, so the mark is in bytes.
+    _stackFree[k] = task ? (int32_t)uxTaskGetStackHighWaterMark(task) : -1;
+  }
+}
+
+float HealthMonitor::fragmentation_percent() const {
+  if (!_free) return 0.0f;
+  return 100.0f - (float)_largest * 100.0f / (float)_free;
+}
+
+void HealthMonitor::writeJson(JsonWriter& w) const {
+  w.beginObject("heap")
+      .field("free", _free)
+      .field("largest", _largest)
+      .field("min_free", _minFree)
+      .field("min_largest", _minLargest)
+      .field("frag_percent", fragmentation_percent(), 1)
+      .field("free_blocks", _freeBlocks)
+      .field("used_blocks", _usedBlocks)
+      .endObject();
+  w.beginObject("stack_free");
+  for (uint8_t k = 0; k < _count; ++k) {
+    if (_stackFree[k] >= 0) w.field(_names[k], _stackFree[k]);
+  }
+  w.endObject();
+}
+
+void HealthMonitor::print(Print& out) const {
+  out.printf("Heap: %u free, largest block %u (%.1f%% fragmented), min free %u, min largest %u\n",
+             (unsigned)_free, (unsigned)_largest, fragmentation_percent(), (unsigned)_minFree, (unsigned)_minLargest);
+  for (uint8_t k = 0; k < _count; ++k) {
+    if (_stackFree[k] >= 0) out.printf("  stack %-10s %d B never used\n", _names[k], (int)_stackFree[k]);
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "json_writer.h"
+
+// Heap and stack health for long-running nodes, sampled at a low rate.
+//
+// Each sample() reads the 8-bit-capable heap: free bytes, the largest free
+// block, free and allocated block counts and the lowest free heap since
+// boot. Fragmentation is the share of free memory outside the largest block;
+// the lowest largest-block ever seen is kept as well, because a block that
+// keeps shrinking while the free total holds steady is fragmentation, and a
+// falling minimum free heap is a leak. Stack high-water marks (bytes never
+// touched) are read for the watched tasks, looked up by name each time so
+// tasks that start late or not at all are simply skipped.
+class HealthMonitor {
+public:
+  static const uint8_t MAX_TASKS = 10;
+
+  // names must stay valid. Only list tasks that are never deleted: a
+  // handle looked up here is used right away.
+  void begin(const char* const* taskNames, size_t count);
+  void sample();
+
+  uint32_t freeHeap() const { return _free; }
+  uint32_t largestBlock() const { return _largest; }
+  uint32_t minFreeHeap() const { return _minFree; }
+  uint32_t minLargestBlock() const { return _minLargest; }
+  // 0 = all free memory in one block.
+  float fragmentation_percent() const;
+
+  // "heap": {"free", "largest", "min_free", "min_largest", "frag_percent",
+  // "free_blocks", "used_blocks"}, "stack_free": {"<task>": bytes, ..}
+  void writeJson(JsonWriter& w) const;
+  void print(Print& out) const;
+
+private:
+  const char* const* _names = nullptr;
+  uint8_t _count = 0;
+  uint32_t _free = 0;
+  uint32_t _largest = 0;
+  uint32_t _minFree = 0;
+  uint32_t _minLargest = UINT32_MAX;
+  uint32_t _freeBlocks = 0;
+  uint32_t _usedBlocks = 0;
+  int32_t _stackFree[MAX_TASKS] = {};   // -1: task not running
+};
@@ -0,0 +1,66 @@
+#include "i2c_stats.h"
+
+#include <Adafruit_I2CDevice.h>
+
+#ifdef BUSIO_I2C_STATS
+
+static const char* busName(TwoWire* bus, const I2cBusName* buses, size_t count) {
+  for (size_t k = 0; k < count; ++k) {
+    if (buses[k].bus == bus) return buses[k].name;
+  }
+  return "?";
+}
+
+// Index past the highest non-empty latency bucket.
+static uint8_t usedBuckets(const busio_i2c_stats_t& s) {
+  uint8_t n = BUSIO_I2C_LATENCY_BUCKETS;
+  while (n && !s.latency[n - 1]) n--;
+  return n;
+}
+
+void printI2cStats(Print& out, const I2cBusName* buses, size_t count) {
+  for (Adafruit_I2CDevice* d = Adafruit_I2CDevice::firstInstance(); d; d = d->nextInstance()) {
+    const busio_i2c_stats_t& s = d->stats();
+    out.printf("%s 0x%02X: %u tx, %u failed, NACK addr %u data %u, %u B out %u B in, %u us busy\n",
+               busName(d->wire(), buses, count), d->address(), s.transactions, s.failures, s.nack_address,
+               s.nack_data, s.bytes_written, s.bytes_read, s.busy_us);
+    uint8_t n = usedBuckets(s);
+    for (uint8_t k = 0; k < n; ++k) {
+      if (s.latency[k]) out.printf("  >=%lu us: %u\n", 1UL << k, s.latency[k]);
+    }
+  }
+}
+
+void writeI2cStats(JsonWriter& w, const I2cBusName* buses, size_t count) {
+  w.beginArray("i2c");
+  for (Adafruit_I2CDevice* d = Adafruit_I2CDevice::firstInstance(); d; d = d->nextInstance()) {
+    const busio_i2c_stats_t& s = d->stats();
+    w.beginObject()
+        .field("bus", busName(d->wire(), buses, count))
+        .field("addr", (uint32_t)d->address())
+        .field("tx", s.transactions)
+        .field("fail", s.failures)
+        .field("nack_addr", s.nack_address)
+        .field("nack_data", s.nack_data)
+        .field("wr", s.bytes_written)
+        .field("rd", s.bytes_read)
+        .field("busy_us", s.busy_us);
+    w.beginArray("lat_log2_us");
+    uint8_t n = usedBuckets(s);
+    for (uint8_t k = 0; k < n; ++k) w.value((int32_t)s.latency[k]);
+    w.endArray().endObject();
+  }
+  w.endArray();
+}
+
+void resetI2cStats() {
+  for (Adafruit_I2CDevice* d = Adafruit_I2CDevice::firstInstance(); d; d = d->nextInstance()) d->resetStats();
+}
+
+#else
+
+void printI2cStats(Print& out, const I2cBusName*, size_t) { out.println("I2C stats: build with -DBUSIO_I2C_STATS"); }
+void writeI2cStats(JsonWriter&, const I2cBusName*, size_t) {}
+void resetI2cStats() {}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Print.h>
+#include <Wire.h>
+#include <stddef.h>
+
+#include "json_writer.h"
+
+// Per-device I2C traffic counters kept by BusIO's Adafruit_I2CDevice when
+// built with -DBUSIO_I2C_STATS (platformio.ini build_flags). Covers every
+// BusIO client (INA219 drivers, string bank); the SSD1306 talks to TwoWire
+// directly. Without the flag these report nothing and cost nothing.
+struct I2cBusName {
+  TwoWire* bus;
+  const char* name;
+};
+
+// One line per device: transactions, failures, NACKs, bytes, bus time and
+// the non-empty log2 latency buckets.
+void printI2cStats(Print& out, const I2cBusName* buses, size_t count);
+// "i2c": [{"bus", "addr", "tx", "fail", "nack_addr", "nack_data", "wr",
+// "rd", "busy_us", "lat_log2_us": [..]}, ..]
+void writeI2cStats(JsonWriter& w, const I2cBusName* buses, size_t count);
+// Zeroes every device's counters, e.g. after each diagnostics publish.
+void resetI2cStats();
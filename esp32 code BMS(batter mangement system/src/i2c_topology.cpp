@@ -0,0 +1,68 @@
+#include "i2c_topology.h"
+
+#include <Adafruit_I2CDevice.h>
+#include <Preferences.h>
+
+#include "logger.h"
+
+static const char* NVS_NAMESPACE = "i2c";
+static const uint8_t MAX_BUSES = 2;
+
+// One BusIO device per bus carries the probes, so they take the bus lock the
+// drivers take and show up in their stats (as address 0x00). Created on first
+// use; only setup() and then the network task probe.
+static Adafruit_I2CDevice* scanner(TwoWire& bus) {
+  static Adafruit_I2CDevice* devices[MAX_BUSES] = {};
+  static TwoWire* buses[MAX_BUSES] = {};
+  for (uint8_t k = 0; k < MAX_BUSES; ++k) {
+    if (buses[k] == &bus) return devices[k];
+    if (!buses[k]) {
+      buses[k] = &bus;
+      return devices[k] = new Adafruit_I2CDevice(0x00, &bus);
+    }
+  }
+  return nullptr;
+}
+
+bool i2cProbe(TwoWire& bus, uint8_t addr) {
+  Adafruit_I2CDevice* dev = scanner(bus);
+  return dev && dev->detected(addr);
+}
+
+uint8_t i2cFind(TwoWire& bus, uint8_t preferred, const uint8_t* candidates, size_t count) {
+  if (preferred && i2cProbe(bus, preferred)) return preferred;
+  for (size_t k = 0; k < count; ++k) {
+    if (candidates[k] != preferred && i2cProbe(bus, candidates[k])) return candidates[k];
+  }
+  return 0;
+}
+
+void i2cScan(TwoWire& bus, const char* name) {
+  LOG_INFO("Scanning %s ...", name);
+  uint8_t found = 0;
+  for (uint8_t addr = 1; addr < 127; ++addr) {
+    // One lock per probe: the sampler's bursts go in between
+    if (i2cProbe(bus, addr)) {
+      LOG_INFO("  Found device at 0x%02X on %s", addr, name);
+      found++;
+    }
+  }
+  LOG_INFO("  %u device(s)", found);
+}
+
+bool loadTopology(I2cTopology& out) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+  bool ok = prefs.getBytesLength("topo") == sizeof(out) && prefs.getBytes("topo", &out, sizeof(out)) == sizeof(out);
+  prefs.end();
+  return ok;
+}
+
+void storeTopology(const I2cTopology& t) {
+  I2cTopology cur;
+  if (loadTopology(cur) && cur == t) return;
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return;
+  prefs.putBytes("topo", &t, sizeof(t));
+  prefs.end();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Wire.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Which addresses answered on the last boot (0 = device not found).
+struct I2cTopology {
+  uint8_t oledAddr;
+  uint8_t inaAddr;
+
+  bool operator==(const I2cTopology& o) const { return oledAddr == o.oledAddr && inaAddr == o.inaAddr; }
+};
+
+// One address-only transaction under the bus's BusIO lock; true if the
+// device ACKed. Safe while drivers on the same bus run in other tasks.
+bool i2cProbe(TwoWire& bus, uint8_t addr);
+// Probes preferred first (if non-zero), then each candidate; returns the
+// first address that answers, or 0.
+uint8_t i2cFind(TwoWire& bus, uint8_t preferred, const uint8_t* candidates, size_t count);
+// Diagnostic sweep of 0x01..0x7E, reported through the logger. Slow; not
+// part of the boot path.
+void i2cScan(TwoWire& bus, const char* name);
+
+// Topology cache in NVS, so a normal boot probes exactly the addresses
+// that answered last time. storeTopology() only writes when it changed.
+bool loadTopology(I2cTopology& out);
+void storeTopology(const I2cTopology& t);
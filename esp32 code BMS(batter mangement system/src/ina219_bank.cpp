@@ -0,0 +1,60 @@
+#include "ina219_bank.h"
+
+uint8_t Ina219Bank::begin(const Channel* channels, size_t count, const Ina219Profile& profile) {
+  for (size_t k = 0; k < count && _count < MAX_DEVICES; ++k) {
+    const Channel& c = channels[k];
+    if (!c.bus || c.addr == 0) continue;
+    Adafruit_INA219* dev = new Adafruit_INA219(c.addr);
+    if (!dev->begin(c.bus)) {
+      Serial.printf("INA219 bank: no device at 0x%02X\n", c.addr);
+      delete dev;
+      continue;
+    }
+    dev->configure(profile);
+    dev->setTrustedCalibration(true);
+
+    _dev[_count] = dev;
+    _channels[_count] = c;
+    _conversion_us[_count] = dev->conversionTime_us();
+    _due_us[_count] = micros() + _conversion_us[_count];
+    _count++;
+  }
+  _last.count = _count;
+  return _count;
+}
+
+uint8_t Ina219Bank::tick(BankSample& out) {
+  _last.t_us = micros();
+  _last.fresh = 0;
+  uint8_t reads = 0;
+  uint8_t refreshed = 0;
+
+  for (uint8_t n = 0; n < _count; ++n) {
+    uint8_t k = (_next + n) % _count;
+    uint32_t now = micros();
+    if ((int32_t)(now - _due_us[k]) < 0) continue;   // still converting
+    if (reads >= _readsPerTick) {
+      _next = k;   // budget spent: start here next tick
+      break;
+    }
+    reads++;
+
+    Ina219Sample raw;
+    if (!_dev[k]->readFresh(raw, 0) || !raw.ready) {
+      // Due but not ready (clock skew): look again in 1/8 conversion
+      _due_us[k] = now + _conversion_us[k] / 8;
+      continue;
+    }
+    _due_us[k] = now + _conversion_us[k];
+    _last.bus_uV[k] = raw.bus_uV;
+    _last.current_uA[k] = raw.current_uA;
+    _last.power_uW[k] = raw.power_uW;
+    _last.fresh |= (uint16_t)(1u << k);
+    if (raw.overflow) _last.overflow |= (uint16_t)(1u << k);
+    else _last.overflow &= (uint16_t)~(1u << k);
+    refreshed++;
+  }
+
+  out = _last;
+  return refreshed;
+}
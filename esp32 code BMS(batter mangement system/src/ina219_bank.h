@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_INA219.h>
+#include <Wire.h>
+
+// One reading of every device in an Ina219Bank.
+struct BankSample {
+  static const uint8_t MAX_CHANNELS = 16;
+
+  uint32_t t_us;        // micros() when the tick started
+  uint8_t count;        // channels in use
+  uint16_t fresh;       // bit k: channel k has a new conversion this tick
+  uint16_t overflow;    // bit k: channel k reported OVF
+  int32_t bus_uV[MAX_CHANNELS];
+  int32_t current_uA[MAX_CHANNELS];
+  int32_t power_uW[MAX_CHANNELS];
+};
+
+// Up to 16 INA219s (0x40..0x4F) across one or both TwoWire buses, e.g. one
+// per pack string.
+//
+// All devices convert continuously and in parallel; tick() only touches a
+// device once its next conversion is due (last fresh read + conversion
+// time), so while one chip is still converting the others are being read
+// and a not-ready device costs no I2C traffic. Reads are served
+// round-robin under a per-tick budget, and channels that were not read keep
+// their previous value (fresh bit clear), so every tick yields a complete,
+// single-timestamp vector.
+class Ina219Bank {
+public:
+  static const uint8_t MAX_DEVICES = BankSample::MAX_CHANNELS;
+
+  struct Channel {
+    TwoWire* bus;
+    uint8_t addr;   // 0 = unused entry
+  };
+
+  // Creates and configures one driver per answering channel; returns how
+  // many were found. Call once from setup().
+  uint8_t begin(const Channel* channels, size_t count, const Ina219Profile& profile);
+  // Caps the register bursts per tick (default: all devices).
+  void setReadsPerTick(uint8_t n) { _readsPerTick = n ? n : 1; }
+
+  // Reads every due device and fills out. Returns the number refreshed.
+  uint8_t tick(BankSample& out);
+
+  uint8_t size() const { return _count; }
+  const Channel& channel(uint8_t k) const { return _channels[k]; }
+
+private:
+  Adafruit_INA219* _dev[MAX_DEVICES] = {};
+  Channel _channels[MAX_DEVICES] = {};
+  uint32_t _conversion_us[MAX_DEVICES] = {};
+  uint32_t _due_us[MAX_DEVICES] = {};
+  uint8_t _count = 0;
+  uint8_t _next = 0;            // round-robin start for the next tick
+  uint8_t _readsPerTick = MAX_DEVICES;
+  BankSample _last = {};
+};
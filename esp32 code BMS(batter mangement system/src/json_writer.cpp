@@ -0,0 +1,222 @@
+#include "json_writer.h"
+
+#include <math.h>
+#include <string.h>
+
+static const float POW10[] = {1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f};
+static const uint8_t MAX_DECIMALS = sizeof(POW10) / sizeof(POW10[0]) - 1;
+
+size_t formatUInt(char* out, size_t cap, uint64_t value) {
+  char tmp[20];
+  size_t n = 0;
+  do {
+    tmp[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  if (n >= cap) return 0;
+  for (size_t i = 0; i < n; ++i) out[i] = tmp[n - 1 - i];
+  out[n] = '\0';
+  return n;
+}
+
+size_t formatInt(char* out, size_t cap, int64_t value) {
+  if (value >= 0) return formatUInt(out, cap, (uint64_t)value);
+  if (cap < 2) return 0;
+  out[0] = '-';
+  size_t n = formatUInt(out + 1, cap - 1, (uint64_t)(-(value + 1)) + 1);
+  return n ? n + 1 : 0;
+}
+
+size_t formatFixed(char* out, size_t cap, float value, uint8_t decimals) {
+  if (isnan(value) || isinf(value)) {
+    const char* s = isnan(value) ? "nan" : (value < 0 ? "-inf" : "inf");
+    size_t n = strlen(s);
+    if (n >= cap) return 0;
+    memcpy(out, s, n + 1);
+    return n;
+  }
+  if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+
+  bool neg = value < 0.0f;
+  // Single-precision scale and round; no double or printf on the hot path.
+  float mag = fabsf(value) * POW10[decimals] + 0.5f;
+  if (mag >= 1.8e19f) return 0;   // beyond uint64
+  uint64_t scaled = (uint64_t)mag;
+  uint64_t div = (uint64_t)POW10[decimals];
+  uint64_t whole = scaled / div;
+  uint64_t frac = scaled % div;
+  if (scaled == 0) neg = false;   // no "-0.00"
+
+  size_t n = 0;
+  if (neg) {
+    if (cap < 2) return 0;
+    out[n++] = '-';
+  }
+  size_t w = formatUInt(out + n, cap - n, whole);
+  if (!w) return 0;
+  n += w;
+  if (decimals) {
+    if (n + 1 + decimals >= cap) return 0;
+    out[n++] = '.';
+    for (int i = decimals - 1; i >= 0; --i) {
+      out[n + i] = (char)('0' + frac % 10);
+      frac /= 10;
+    }
+    n += decimals;
+    out[n] = '\0';
+  }
+  return n;
+}
+
+JsonWriter::JsonWriter(char* buf, size_t cap) : _buf(buf), _cap(cap) { reset(); }
+
+void JsonWriter::reset() {
+  _len = 0;
+  _overflow = _cap == 0;
+  _first = true;
+  if (_cap) _buf[0] = '\0';
+}
+
+void JsonWriter::raw(const char* s, size_t n) {
+  if (_overflow) return;
+  if (_len + n >= _cap) {
+    _overflow = true;
+    return;
+  }
+  memcpy(_buf + _len, s, n);
+  _len += n;
+  _buf[_len] = '\0';
+}
+
+void JsonWriter::raw(const char* s) { raw(s, strlen(s)); }
+
+void JsonWriter::rawChar(char c) { raw(&c, 1); }
+
+void JsonWriter::separator() {
+  if (!_first) rawChar(',');
+  _first = false;
+}
+
+// Keys are compile-time identifiers in this firmware and are not escaped.
+void JsonWriter::key(const char* k) {
+  separator();
+  rawChar('"');
+  raw(k);
+  raw("\":", 2);
+}
+
+void JsonWriter::number(float value, uint8_t decimals) {
+  if (isnan(value) || isinf(value)) {
+    raw("null", 4);
+    return;
+  }
+  char tmp[32];
+  size_t n = formatFixed(tmp, sizeof(tmp), value, decimals);
+  if (n) raw(tmp, n);
+  else raw("null", 4);
+}
+
+JsonWriter& JsonWriter::members(const char* object, size_t len) {
+  if (len <= 2) return *this;   // "{}"
+  separator();
+  raw(object + 1, len - 2);
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginObject() {
+  separator();   // no-op at the root; a comma between array elements
+  rawChar('{');
+  _first = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginObject(const char* k) {
+  key(k);
+  rawChar('{');
+  _first = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+  rawChar('}');
+  _first = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* k) {
+  key(k);
+  rawChar('[');
+  _first = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+  rawChar(']');
+  _first = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* k, float v, uint8_t decimals) {
+  key(k);
+  number(v, decimals);
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* k, uint64_t v) {
+  key(k);
+  char tmp[24];
+  raw(tmp, formatUInt(tmp, sizeof(tmp), v));
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* k, int64_t v) {
+  key(k);
+  char tmp[24];
+  raw(tmp, formatInt(tmp, sizeof(tmp), v));
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* k, uint32_t v) { return field(k, (uint64_t)v); }
+
+JsonWriter& JsonWriter::field(const char* k, int32_t v) { return field(k, (int64_t)v); }
+
+JsonWriter& JsonWriter::field(const char* k, bool v) {
+  key(k);
+  if (v) raw("true", 4);
+  else raw("false", 5);
+  return *this;
+}
+
+void JsonWriter::quoted(const char* v) {
+  rawChar('"');
+  for (const char* p = v; *p; ++p) {
+    if (*p == '"' || *p == '\\') rawChar('\\');
+    rawChar(*p);
+  }
+  rawChar('"');
+}
+
+JsonWriter& JsonWriter::field(const char* k, const char* v) {
+  key(k);
+  quoted(v);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(float v, uint8_t decimals) {
+  separator();
+  number(v, decimals);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(int32_t v) {
+  separator();
+  char tmp[16];
+  raw(tmp, formatInt(tmp, sizeof(tmp), v));
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* v) {
+  separator();
+  quoted(v);
+  return *this;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocation-free number formatting. All functions write into a caller
+// buffer, NUL-terminate it when there is room, and return the number of
+// characters written (0 if it did not fit).
+size_t formatUInt(char* out, size_t cap, uint64_t value);
+size_t formatInt(char* out, size_t cap, int64_t value);
+// Fixed-point decimal with round-half-up, e.g. formatFixed(buf, n, 3.14159f, 2) -> "3.14".
+// NaN/Inf are written as "nan"/"inf" (JsonWriter emits null instead).
+size_t formatFixed(char* out, size_t cap, float value, uint8_t decimals);
+
+// Minimal streaming JSON object writer over a fixed buffer.
+//
+// Replaces the String concatenation used to build telemetry payloads: no
+// heap allocations, one pass, and overflow is sticky (ok() turns false and
+// the buffer keeps a valid NUL-terminated prefix) instead of truncating
+// silently into the broker.
+class JsonWriter {
+public:
+  JsonWriter(char* buf, size_t cap);
+
+  void reset();
+  JsonWriter& beginObject();   // root object, or an array element
+  JsonWriter& beginObject(const char* key);   // nested object field
+  JsonWriter& endObject();
+  JsonWriter& beginArray(const char* key);
+  JsonWriter& endArray();
+
+  JsonWriter& field(const char* key, float value, uint8_t decimals);
+  JsonWriter& field(const char* key, uint32_t value);
+  JsonWriter& field(const char* key, int32_t value);
+  JsonWriter& field(const char* key, uint64_t value);
+  JsonWriter& field(const char* key, int64_t value);
+  JsonWriter& field(const char* key, bool value);
+  JsonWriter& field(const char* key, const char* value);
+  // Array elements (inside beginArray/endArray).
+  JsonWriter& value(float value, uint8_t decimals);
+  JsonWriter& value(int32_t value);
+  JsonWriter& value(const char* value);
+  // The fields of a complete object rendered by another writer, spliced
+  // into the current object (its braces dropped).
+  JsonWriter& members(const char* object, size_t len);
+
+  const char* c_str() const { return _buf; }
+  size_t length() const { return _len; }
+  bool ok() const { return !_overflow; }
+
+private:
+  void separator();
+  void key(const char* k);
+  void raw(const char* s, size_t n);
+  void raw(const char* s);
+  void rawChar(char c);
+  void quoted(const char* s);
+  void number(float value, uint8_t decimals);
+
+  char* _buf;
+  size_t _cap;
+  size_t _len;
+  bool _overflow;
+  bool _first;   // no element written yet at current nesting level
+};
+
+// JsonWriter with inline storage, meant to live on the stack.
+template <size_t N>
+class StaticJsonWriter : public JsonWriter {
+public:
+  StaticJsonWriter() : JsonWriter(_storage, N) {}
+
+private:
+  char _storage[N];
+};
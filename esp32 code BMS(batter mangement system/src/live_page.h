@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Generated by web/embed_page.py from web/live.html (3730 bytes); do not edit.
+static const uint8_t LIVE_PAGE_GZ[] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x57, 0xeb, 0x6e, 0xe3, 0x36,
+  0x1a, 0xfd, 0xef, 0xa7, 0xe0, 0x7a, 0xb2, 0xb5, 0xd4, 0xf1, 0x45, 0x72, 0xd2, 0xd9, 0xd4, 0xb7,
+  0x22, 0x53, 0xb4, 0x98, 0x59, 0x60, 0xda, 0xc1, 0x64, 0x30, 0x59, 0x20, 0x08, 0x26, 0xb4, 0x44,
+  0x59, 0x6c, 0x28, 0x4a, 0x4b, 0x52, 0xbe, 0x8c, 0x61, 0xa0, 0x0f, 0xb1, 0xcf, 0xb0, 0x0f, 0xd6,
+  0x27, 0xd9, 0x43, 0x4a, 0xb6, 0x35, 0x89, 0x37, 0x28, 0x0a, 0x24, 0x96, 0xf8, 0xf1, 0x7c, 0xf7,
+  0x0b, 0xa9, 0xc9, 0xdf, 0xe2, 0x3c, 0x32, 0x9b, 0x82, 0x91, 0xd4, 0x64, 0x62, 0xd6, 0x9a, 0xd8,
+  0x07, 0x11, 0x54, 0x2e, 0xa6, 0x6d, 0x26, 0xdb, 0x96, 0xc0, 0x68, 0x8c, 0x47, 0xc6, 0x0c, 0x25,
+  0x51, 0x4a, 0x95, 0x66, 0x66, 0xda, 0x2e, 0x4d, 0xd2, 0xbb, 0x6c, 0xef, 0xc9, 0x92, 0x66, 0x6c,
+  0xda, 0x5e, 0x72, 0xb6, 0x2a, 0x72, 0x65, 0xda, 0x24, 0xca, 0xa5, 0x61, 0x12, 0xb0, 0x15, 0x8f,
+  0x4d, 0x3a, 0x8d, 0xd9, 0x92, 0x47, 0xac, 0xe7, 0x16, 0x5d, 0x2e, 0xb9, 0xe1, 0x54, 0xf4, 0x74,
+  0x44, 0x05, 0x9b, 0x86, 0x56, 0x86, 0xe1, 0x46, 0xb0, 0xd9, 0xeb, 0x77, 0xd7, 0x44, 0xf0, 0x25,
+  0x9b, 0x0c, 0xaa, 0x75, 0x6b, 0xa2, 0xcd, 0xc6, 0x3e, 0xe7, 0x79, 0xbc, 0xd9, 0x66, 0x54, 0x2d,
+  0xb8, 0x1c, 0x05, 0xe3, 0x04, 0xb2, 0x7b, 0x09, 0xcd, 0xb8, 0xd8, 0x8c, 0xf4, 0x46, 0x1b, 0x96,
+  0xf5, 0x4a, 0xde, 0xd5, 0x54, 0xea, 0x9e, 0x66, 0x8a, 0x27, 0xe3, 0x39, 0x8d, 0x1e, 0x16, 0x2a,
+  0x2f, 0x65, 0x3c, 0x7a, 0x11, 0x24, 0xe1, 0x3f, 0x86, 0x74, 0x1c, 0xe5, 0x22, 0x57, 0xa3, 0x17,
+  0x6c, 0xc8, 0x2e, 0x93, 0x60, 0xd7, 0xb2, 0x1e, 0x31, 0xb5, 0x8d, 0xb9, 0x2e, 0x04, 0xdd, 0x8c,
+  0x12, 0xc1, 0xd6, 0xe3, 0xdf, 0x4a, 0x6d, 0x78, 0xb2, 0xe9, 0xd5, 0xa6, 0x8f, 0x74, 0x41, 0x61,
+  0xf2, 0x9c, 0x99, 0x15, 0x63, 0x72, 0x4c, 0x05, 0x5f, 0xc8, 0x1e, 0x87, 0x32, 0x3d, 0x8a, 0xb0,
+  0xcd, 0xd4, 0xb8, 0xa0, 0x71, 0xcc, 0xe5, 0x62, 0x14, 0x0e, 0x8b, 0x35, 0x09, 0x5f, 0x15, 0xeb,
+  0xaf, 0x14, 0x87, 0x6c, 0xf8, 0xfd, 0xf9, 0x1c, 0xaa, 0xc2, 0xad, 0x33, 0x58, 0xf3, 0x2f, 0x6c,
+  0x14, 0x5e, 0x02, 0xb5, 0x77, 0x64, 0xd7, 0x7a, 0xa1, 0x0d, 0x35, 0xa5, 0x6e, 0x02, 0xce, 0x01,
+  0xa8, 0x8d, 0xfd, 0xfe, 0x82, 0x9e, 0xcf, 0x2f, 0x77, 0xad, 0x7e, 0x44, 0x55, 0xac, 0x0f, 0xc6,
+  0x2e, 0x14, 0x8f, 0xc7, 0xf6, 0xa7, 0x07, 0x63, 0x40, 0x31, 0x0c, 0x26, 0x8b, 0x32, 0x93, 0x7a,
+  0xa4, 0x58, 0xc1, 0xa8, 0xf1, 0x68, 0x69, 0xf2, 0x5e, 0xc2, 0x4d, 0x37, 0xe3, 0x32, 0xa3, 0x6b,
+  0x2f, 0xbc, 0x08, 0x8a, 0x75, 0x37, 0x4c, 0x94, 0xef, 0x8f, 0x17, 0xb4, 0x70, 0x06, 0x1f, 0xad,
+  0x87, 0xe1, 0xb5, 0x8e, 0xed, 0x53, 0xfb, 0xc7, 0xf3, 0x5c, 0x21, 0x52, 0x3d, 0x45, 0x63, 0x5e,
+  0xea, 0xd1, 0x65, 0x93, 0x71, 0xe8, 0x18, 0x05, 0x9d, 0x33, 0xd1, 0xf4, 0x60, 0x78, 0xc2, 0x83,
+  0x25, 0x15, 0x25, 0x6b, 0x80, 0x86, 0x56, 0x90, 0x5b, 0x2e, 0xa9, 0xe2, 0x14, 0x4f, 0x59, 0x66,
+  0xc8, 0x5d, 0x34, 0x32, 0x74, 0x5e, 0x0a, 0xaa, 0xec, 0x5a, 0x5b, 0xb3, 0x80, 0x51, 0xb9, 0xd0,
+  0xdb, 0xbd, 0xd6, 0xa0, 0x8a, 0x74, 0x43, 0xdf, 0x85, 0x35, 0x23, 0xa2, 0x72, 0x49, 0x8f, 0x31,
+  0x9a, 0x8b, 0x3c, 0x7a, 0x18, 0xbb, 0x72, 0x1b, 0xa1, 0xca, 0x22, 0x2f, 0x0c, 0x82, 0xbf, 0x93,
+  0x1e, 0x39, 0x87, 0x71, 0xfe, 0x38, 0x65, 0x7c, 0x91, 0x9a, 0xd1, 0xf0, 0x55, 0x70, 0xcc, 0xc6,
+  0xff, 0xc9, 0xdf, 0x53, 0xff, 0x77, 0xad, 0xc9, 0xa0, 0x2e, 0xcb, 0xc9, 0xa0, 0xee, 0x0c, 0x5b,
+  0x9f, 0x75, 0x9f, 0x30, 0x35, 0x9b, 0xa4, 0xe1, 0xec, 0x35, 0x35, 0x28, 0x91, 0x8d, 0x2b, 0x67,
+  0x62, 0xdb, 0x02, 0xd8, 0x70, 0x36, 0x41, 0x4d, 0x49, 0xc2, 0xe3, 0x69, 0xbb, 0x4a, 0x7c, 0x7b,
+  0x06, 0xff, 0x24, 0x8b, 0x0c, 0x3c, 0xfb, 0xe3, 0xf7, 0xff, 0x42, 0x30, 0xf6, 0x67, 0x95, 0x58,
+  0x08, 0x6a, 0x4d, 0x62, 0xbe, 0x24, 0x91, 0xa0, 0x5a, 0x4f, 0xdb, 0xae, 0x08, 0xd0, 0x2b, 0x84,
+  0x3c, 0xa6, 0xb6, 0x67, 0x4d, 0x8a, 0xcb, 0x47, 0x7b, 0xf6, 0x29, 0x17, 0x86, 0x2e, 0x18, 0xf1,
+  0x3e, 0xf9, 0x93, 0x01, 0xb6, 0xbf, 0xc2, 0xb8, 0x74, 0xb4, 0x9d, 0x21, 0xcb, 0xf6, 0xec, 0x8f,
+  0xdf, 0xff, 0x53, 0x43, 0xdc, 0xef, 0x9f, 0xd5, 0xf0, 0x63, 0xa9, 0x14, 0x1a, 0x81, 0x78, 0xd9,
+  0xd5, 0xf3, 0x2a, 0xf8, 0x5f, 0x56, 0xf1, 0x3e, 0x5f, 0x31, 0x05, 0x05, 0x37, 0xcf, 0x2b, 0x28,
+  0xfe, 0xb2, 0x82, 0x0f, 0xe8, 0x1e, 0xe2, 0xbd, 0xf9, 0xf2, 0xbc, 0x7c, 0xf5, 0x54, 0xfe, 0xfe,
+  0xd1, 0x54, 0x52, 0x97, 0xaa, 0xcb, 0xd1, 0x75, 0x9a, 0xaf, 0x48, 0x2e, 0x19, 0xd1, 0x14, 0x3d,
+  0xca, 0x08, 0x97, 0xd6, 0x24, 0xcd, 0x04, 0x92, 0xed, 0x64, 0xb2, 0x25, 0xca, 0xc3, 0x41, 0x41,
+  0xcf, 0x0b, 0xc3, 0x73, 0x39, 0x0b, 0x27, 0x83, 0xfa, 0x6d, 0x4f, 0x19, 0x3e, 0xa1, 0x7c, 0xf7,
+  0x98, 0x42, 0x2a, 0xa1, 0x2c, 0x9e, 0x85, 0xc1, 0x53, 0xf4, 0x53, 0x12, 0x3a, 0xe1, 0x40, 0xb3,
+  0x36, 0x0d, 0x2a, 0x7e, 0xf7, 0x7e, 0x28, 0x4f, 0x2e, 0x93, 0x1c, 0x01, 0xab, 0xea, 0xf1, 0xe0,
+  0x6c, 0xd5, 0x64, 0x0e, 0x60, 0x8f, 0x01, 0x63, 0x11, 0x15, 0xcd, 0x8e, 0xea, 0x48, 0xf1, 0x02,
+  0x62, 0x10, 0x06, 0x6d, 0xc8, 0x19, 0x99, 0x02, 0x47, 0xa6, 0x33, 0x82, 0xc3, 0x05, 0xad, 0x2d,
+  0x4d, 0x7f, 0xc1, 0xcc, 0x4f, 0x82, 0xd9, 0xd7, 0xd7, 0x9b, 0xb7, 0xb1, 0xc7, 0x63, 0x7f, 0x5c,
+  0x83, 0xdf, 0x5d, 0xfd, 0xeb, 0xf3, 0xfb, 0x5f, 0xdf, 0xfe, 0xf2, 0xf1, 0x1a, 0x5c, 0xaf, 0x82,
+  0x60, 0x4f, 0x2f, 0x72, 0x2e, 0x8d, 0x06, 0xed, 0xf6, 0x6e, 0x8c, 0x30, 0x0d, 0x06, 0xe4, 0xd6,
+  0x7c, 0xce, 0x74, 0x97, 0x64, 0x57, 0x77, 0x2d, 0xc1, 0x0c, 0x59, 0xe1, 0x5d, 0x63, 0x3a, 0x03,
+  0x02, 0xa6, 0x56, 0x52, 0xca, 0xc8, 0x85, 0xa4, 0xee, 0x2a, 0xcf, 0x27, 0x5b, 0xb8, 0xb5, 0xb2,
+  0x22, 0x24, 0x5b, 0x91, 0x1b, 0x36, 0xbf, 0xc6, 0x5c, 0x60, 0xc6, 0xbb, 0x5f, 0xe9, 0xd1, 0x60,
+  0x70, 0xb6, 0xc5, 0x98, 0xa0, 0x96, 0xa3, 0x9f, 0xe6, 0xda, 0xec, 0x06, 0x2b, 0xfd, 0x83, 0xcb,
+  0xcb, 0xf4, 0x6c, 0x7b, 0xe6, 0x75, 0xdc, 0x6b, 0xc7, 0xaf, 0x86, 0xd7, 0xee, 0x1e, 0xe6, 0x5a,
+  0x59, 0xfd, 0x5c, 0xe6, 0x85, 0x53, 0x09, 0xf1, 0xf0, 0x6f, 0x4b, 0x00, 0xad, 0xda, 0x19, 0x58,
+  0xc3, 0xd6, 0xe6, 0xc7, 0xea, 0x00, 0x01, 0xa2, 0x63, 0xdb, 0xbf, 0x33, 0x26, 0xbb, 0x03, 0x6b,
+  0x24, 0x72, 0xcd, 0xfe, 0x1c, 0x2f, 0x66, 0x59, 0xed, 0x07, 0x8b, 0xbb, 0x44, 0x31, 0xa3, 0x36,
+  0xd5, 0x98, 0x80, 0x40, 0x9c, 0xc0, 0x1f, 0x79, 0xc6, 0xf2, 0xd2, 0x78, 0x35, 0xa6, 0x4b, 0x86,
+  0x41, 0x10, 0xf8, 0x4d, 0x5d, 0x19, 0xd3, 0xda, 0x8e, 0x80, 0x29, 0x61, 0x4b, 0xa7, 0xcd, 0x15,
+  0x5b, 0x15, 0xda, 0x04, 0xd4, 0x7f, 0x5e, 0xff, 0xfa, 0x4b, 0xbf, 0xb0, 0xc7, 0xb9, 0xc7, 0x96,
+  0xfd, 0x98, 0x1a, 0xea, 0x5c, 0xdc, 0x43, 0xac, 0x8b, 0x49, 0xff, 0x53, 0x5f, 0x30, 0xb9, 0x30,
+  0x69, 0xb5, 0x93, 0xe4, 0x68, 0x47, 0x1b, 0xf9, 0x07, 0x17, 0x72, 0x3c, 0x26, 0x44, 0xe2, 0xf1,
+  0xf2, 0xa5, 0x5f, 0x67, 0xab, 0x5f, 0x94, 0x3a, 0xf5, 0x6e, 0x93, 0xbe, 0x09, 0x90, 0x2a, 0xf2,
+  0x12, 0x22, 0x62, 0xf3, 0xb9, 0xd4, 0xb7, 0x0f, 0x77, 0x64, 0x40, 0x50, 0x7c, 0x41, 0x17, 0xa4,
+  0xec, 0x0a, 0xeb, 0xbb, 0x5a, 0xdd, 0x2a, 0xe5, 0xe8, 0x10, 0xaf, 0xe6, 0xaf, 0xd4, 0x91, 0x59,
+  0xa3, 0x2a, 0x0e, 0xb2, 0x75, 0xca, 0x13, 0x64, 0xb5, 0x62, 0x43, 0xe8, 0x96, 0x4f, 0xa2, 0x06,
+  0x83, 0x6f, 0x25, 0x06, 0x7d, 0x78, 0xd7, 0x37, 0xf9, 0xcf, 0x7c, 0xcd, 0x62, 0xef, 0xfc, 0x88,
+  0xe7, 0x27, 0xf0, 0x30, 0xe5, 0x11, 0x43, 0x78, 0x64, 0x28, 0x4e, 0x31, 0xdc, 0x3c, 0xc3, 0xa0,
+  0x4e, 0x30, 0x28, 0x0c, 0x99, 0xcf, 0x6f, 0xbe, 0x54, 0x18, 0x57, 0xae, 0x2f, 0x51, 0x8f, 0x47,
+  0xa3, 0xd0, 0x6b, 0x4f, 0xb8, 0xee, 0xcf, 0xb6, 0x16, 0xb9, 0xab, 0xe7, 0x07, 0xea, 0xfc, 0x6c,
+  0x8b, 0x48, 0xaa, 0xbc, 0x28, 0x58, 0xbc, 0x23, 0xf5, 0x0b, 0x26, 0x0c, 0x31, 0x29, 0x23, 0xd5,
+  0xf5, 0xea, 0xde, 0x8a, 0x44, 0xfa, 0x77, 0xad, 0x56, 0xa3, 0x7a, 0x51, 0x73, 0x29, 0xee, 0x72,
+  0xcd, 0xa2, 0xe3, 0x09, 0xf1, 0xd0, 0x14, 0xdf, 0x7c, 0x63, 0xeb, 0x44, 0xe1, 0xac, 0xd9, 0x5c,
+  0x1b, 0x3b, 0x08, 0xa7, 0xd3, 0x29, 0x09, 0x7d, 0x4b, 0xd4, 0x4c, 0xc6, 0xb5, 0x88, 0x69, 0x07,
+  0x49, 0x7c, 0xdc, 0x0d, 0x55, 0x9d, 0x1d, 0x1b, 0x2e, 0x56, 0x74, 0x55, 0x77, 0x5b, 0x55, 0x3c,
+  0x11, 0xd4, 0x81, 0xc9, 0x8d, 0x89, 0x8e, 0xdf, 0x25, 0x0b, 0xac, 0x23, 0x3b, 0x02, 0x9c, 0x8b,
+  0x6b, 0xe3, 0x75, 0x86, 0x71, 0xc7, 0x85, 0x2d, 0xea, 0xbb, 0x63, 0xda, 0xed, 0x47, 0x82, 0xc3,
+  0xfd, 0x1b, 0xb7, 0xfe, 0xb6, 0xf6, 0xea, 0x3d, 0x42, 0x2c, 0x3e, 0xd8, 0x2e, 0xad, 0xd0, 0xd5,
+  0xe1, 0xdd, 0x80, 0xbf, 0xa9, 0x08, 0xa7, 0xf1, 0x0b, 0x80, 0x18, 0x55, 0x1f, 0xec, 0x34, 0x40,
+  0xe5, 0xe1, 0xaf, 0xd6, 0xd7, 0x3d, 0x88, 0x72, 0x56, 0xd8, 0x90, 0x3c, 0x2e, 0xc0, 0xd0, 0xff,
+  0xaa, 0x65, 0x4c, 0x00, 0xa5, 0x15, 0xe6, 0x36, 0xb8, 0xc3, 0x5f, 0x97, 0x98, 0xf0, 0x48, 0xfa,
+  0x9a, 0xdb, 0xd6, 0x07, 0x20, 0x55, 0x92, 0x6d, 0xc3, 0x88, 0x1c, 0xd0, 0xb7, 0x32, 0xb1, 0x97,
+  0xdf, 0x4d, 0x97, 0xa4, 0x1c, 0xcb, 0xde, 0x7e, 0xdd, 0x68, 0xae, 0x7a, 0xf2, 0x91, 0x3c, 0xa9,
+  0x05, 0xc3, 0x88, 0x8a, 0xf9, 0x1d, 0x35, 0x69, 0x1f, 0x37, 0x3a, 0x4f, 0xe4, 0x5d, 0x52, 0xdc,
+  0x86, 0x68, 0x9f, 0x4a, 0x4c, 0xb5, 0x81, 0x7b, 0x5e, 0xca, 0x0f, 0x1b, 0x3b, 0x27, 0xd1, 0x7a,
+  0x05, 0x48, 0xcf, 0x0a, 0x98, 0x38, 0x7f, 0x2c, 0x07, 0xaa, 0x2f, 0xe8, 0x7f, 0x37, 0xb6, 0xc4,
+  0x5e, 0xfd, 0xba, 0x6b, 0xf8, 0xb9, 0x86, 0x48, 0x63, 0x0b, 0xc5, 0x33, 0xe0, 0x34, 0x81, 0x8f,
+  0xbe, 0x3d, 0xa8, 0x80, 0xc7, 0x96, 0xd6, 0xb5, 0xc2, 0xbe, 0x85, 0xb5, 0x75, 0xf2, 0x7a, 0x98,
+  0x3e, 0x3e, 0xea, 0x24, 0x0c, 0x9a, 0x13, 0x64, 0x03, 0x49, 0x6e, 0xf2, 0x1c, 0xb2, 0x86, 0xb0,
+  0x04, 0xf8, 0xf1, 0x96, 0xce, 0x26, 0x2b, 0x79, 0x6f, 0x5f, 0x2d, 0xee, 0x80, 0x83, 0xbc, 0x4a,
+  0xd4, 0xa2, 0xaf, 0x71, 0xac, 0x3e, 0xb0, 0x6b, 0x7b, 0xe7, 0xb2, 0x73, 0xf1, 0xc5, 0xf9, 0xe5,
+  0x3c, 0x4e, 0x2e, 0x3b, 0xfb, 0x6d, 0xc1, 0x25, 0xbb, 0xa9, 0x4b, 0xe8, 0x54, 0x09, 0x58, 0xcc,
+  0x9c, 0xe1, 0x8e, 0xf7, 0x1e, 0x4e, 0xec, 0x87, 0x47, 0x9d, 0x2d, 0x84, 0xfc, 0x27, 0x1a, 0xa5,
+  0x9e, 0x57, 0x74, 0xc9, 0x83, 0xeb, 0x8e, 0x07, 0xf2, 0x43, 0x2d, 0xf3, 0x63, 0xee, 0xad, 0xbd,
+  0x02, 0x49, 0x44, 0xf9, 0x6e, 0x3c, 0x17, 0x57, 0x9f, 0x8c, 0xb0, 0x99, 0xe5, 0xcb, 0x93, 0x9b,
+  0x8f, 0x0c, 0xf6, 0x0e, 0xeb, 0x84, 0x0b, 0x71, 0x34, 0xbf, 0xba, 0x14, 0x1f, 0xcc, 0xb7, 0x37,
+  0xd9, 0xaa, 0xe1, 0xc3, 0xf0, 0x44, 0x11, 0xef, 0xf0, 0x6d, 0x71, 0xf8, 0xc8, 0xb9, 0x6f, 0x4a,
+  0xfc, 0x68, 0xdb, 0x08, 0x6c, 0x29, 0x6f, 0x0c, 0xa2, 0x1d, 0xce, 0xc6, 0x7b, 0x64, 0x67, 0x88,
+  0xff, 0x8b, 0x13, 0xe2, 0xfc, 0x53, 0x12, 0x44, 0x7e, 0x5a, 0x42, 0x33, 0x6d, 0x17, 0x8e, 0xd3,
+  0xd6, 0x89, 0x62, 0xff, 0x2e, 0x99, 0x36, 0x57, 0x92, 0x67, 0xee, 0xec, 0xfc, 0x59, 0xe1, 0xdb,
+  0xcf, 0xb3, 0x13, 0xc0, 0x77, 0xb3, 0xe7, 0x70, 0xf8, 0x8e, 0x5b, 0xcf, 0x42, 0x71, 0xbb, 0xa8,
+  0xaf, 0x0c, 0x93, 0x41, 0x7d, 0x81, 0x1e, 0x54, 0x5f, 0xa0, 0xff, 0x03, 0x42, 0x6f, 0x79, 0xf6,
+  0x92, 0x0e, 0x00, 0x00,
+};
+static const size_t LIVE_PAGE_GZ_LEN = sizeof(LIVE_PAGE_GZ);
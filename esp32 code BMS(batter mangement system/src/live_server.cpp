@@ -0,0 +1,215 @@
+#include "live_server.h"
+
+#include <lwip/sockets.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock_sync.h"
+
+namespace {
+
+// "every=N" anywhere in s (a query string or a text message)
+uint16_t parseEvery(const char* s, uint16_t fallback) {
+  const char* p = strstr(s, "every=");
+  if (!p) return fallback;
+  long n = strtol(p + 6, nullptr, 10);
+  if (n < 1) return 1;
+  return n > LiveServer::MAX_EVERY ? LiveServer::MAX_EVERY : (uint16_t)n;
+}
+
+}  // namespace
+
+bool LiveServer::begin(uint16_t port, uint8_t maxClients, const uint8_t* pageGz, size_t pageLen,
+                       UBaseType_t priority, BaseType_t core) {
+  if (_server) return true;
+  _page = pageGz;
+  _pageLen = pageLen;
+  _maxClients = maxClients < MAX_CLIENTS ? maxClients : MAX_CLIENTS;
+  for (Client& c : _clients) c.fd = -1;
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = port;
+  config.task_priority = priority;
+  config.core_id = core;
+  config.stack_size = 4096;
+  // Streams plus one page load; the oldest idle HTTP session gives way
+  config.max_open_sockets = _maxClients + 1;
+  config.lru_purge_enable = true;
+  config.send_wait_timeout = 2;   // s: a stalled browser is closed, not waited on
+  config.global_user_ctx = this;
+  config.close_fn = onClose;
+  if (httpd_start(&_server, &config) != ESP_OK) {
+    _server = nullptr;
+    return false;
+  }
+
+  httpd_uri_t page = {};
+  page.uri = "/";
+  page.method = HTTP_GET;
+  page.handler = onPage;
+  page.user_ctx = this;
+  httpd_register_uri_handler(_server, &page);
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+  httpd_uri_t ws = {};
+  ws.uri = "/ws";
+  ws.method = HTTP_GET;
+  ws.handler = onSocket;
+  ws.user_ctx = this;
+  ws.is_websocket = true;
+  httpd_register_uri_handler(_server, &ws);
+#else
+  Serial.println("Live view: core built without WebSocket support, page only");
+#endif
+  return true;
+}
+
+void LiveServer::add(const PowerSample& s) {
+  if (!_clientCount.load(std::memory_order_relaxed)) return;
+  if (!_ring.push(s)) _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LiveServer::poll(uint32_t now_ms, uint32_t frame_ms) {
+  if (!_server || _ring.empty() || now_ms - _lastFrame_ms < frame_ms) return;
+  if (_queued.exchange(true)) return;   // the last frame is still going out
+  _lastFrame_ms = now_ms;
+  if (httpd_queue_work(_server, sendWork, this) != ESP_OK) _queued.store(false);
+}
+
+esp_err_t LiveServer::onPage(httpd_req_t* req) {
+  LiveServer* self = (LiveServer*)req->user_ctx;
+  httpd_resp_set_type(req, "text/html");
+  httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+  httpd_resp_set_hdr(req, "Cache-Control", "max-age=3600");
+  return httpd_resp_send(req, (const char*)self->_page, self->_pageLen);
+}
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+esp_err_t LiveServer::onSocket(httpd_req_t* req) {
+  LiveServer* self = (LiveServer*)req->user_ctx;
+  int fd = httpd_req_to_sockfd(req);
+  if (req->method == HTTP_GET) {
+    // Handshake done: take a slot or refuse
+    Client* c = self->find(-1);
+    if (!c || self->_clientCount.load() >= self->_maxClients) {
+      self->_refused++;
+      return ESP_FAIL;   // closes the session
+    }
+    char query[32] = "";
+    httpd_req_get_url_query_str(req, query, sizeof(query));
+    c->fd = fd;
+    c->every = parseEvery(query, 1);
+    c->skip = 0;
+    self->_clientCount.fetch_add(1);
+    return ESP_OK;
+  }
+
+  // Incoming frame: only "every=N" means anything
+  httpd_ws_frame_t frame = {};
+  char text[24];
+  if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK) return ESP_FAIL;
+  if (frame.len >= sizeof(text)) return ESP_FAIL;   // not ours, and unread it would desync the stream
+  frame.payload = (uint8_t*)text;
+  if (httpd_ws_recv_frame(req, &frame, frame.len) != ESP_OK) return ESP_FAIL;
+  text[frame.len] = '\0';
+  Client* c = self->find(fd);
+  if (c && frame.type == HTTPD_WS_TYPE_TEXT) c->every = parseEvery(text, c->every);
+  return ESP_OK;
+}
+#else
+esp_err_t LiveServer::onSocket(httpd_req_t*) { return ESP_FAIL; }
+#endif
+
+void LiveServer::onClose(httpd_handle_t hd, int fd) {
+  LiveServer* self = (LiveServer*)httpd_get_global_user_ctx(hd);
+  self->drop(fd);
+  close(fd);   // a close_fn owns the socket
+}
+
+LiveServer::Client* LiveServer::find(int fd) {
+  for (uint8_t k = 0; k < MAX_CLIENTS; ++k) {
+    if (_clients[k].fd == fd) return &_clients[k];
+  }
+  return nullptr;
+}
+
+void LiveServer::drop(int fd) {
+  Client* c = find(fd);
+  if (!c) return;
+  c->fd = -1;
+  _clientCount.fetch_sub(1);
+}
+
+void LiveServer::sendWork(void* arg) {
+  LiveServer* self = (LiveServer*)arg;
+  self->sendFrames();
+  self->_queued.store(false);
+}
+
+// Server task: everything in the ring, FRAME_SAMPLES at a time, to every client.
+void LiveServer::sendFrames() {
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+  while (size_t n = _ring.popBulk(_batch, FRAME_SAMPLES)) {
+    for (Client& c : _clients) {
+      if (c.fd < 0) continue;
+      size_t len = formatFrame(c, _batch, n, _seq);
+      if (!len) continue;
+      httpd_ws_frame_t frame = {};
+      frame.type = HTTPD_WS_TYPE_TEXT;
+      frame.payload = (uint8_t*)_frame;
+      frame.len = len;
+      if (httpd_ws_send_frame_async(_server, c.fd, &frame) != ESP_OK) {
+        httpd_sess_trigger_close(_server, c.fd);
+        continue;
+      }
+      _frames++;
+    }
+    _seq += n;
+  }
+#else
+  while (_ring.popBulk(_batch, FRAME_SAMPLES)) {
+  }
+#endif
+}
+
+// The client's share of s[0..n) as one frame; 0 if it gets none of them.
+size_t LiveServer::formatFrame(Client& c, const PowerSample* s, size_t n, uint32_t seq0) {
+  // Pick first, so the header can name the first sample sent
+  uint8_t pick[FRAME_SAMPLES];
+  size_t count = 0;
+  for (size_t k = 0; k < n; ++k) {
+    if (c.skip) {
+      c.skip--;
+      continue;
+    }
+    c.skip = c.every - 1;
+    pick[count++] = (uint8_t)k;
+  }
+  if (!count) return 0;
+
+  const PowerSample& first = s[pick[0]];
+  JsonWriter w(_frame, sizeof(_frame));
+  w.beginObject()
+      .field("seq", seq0 + pick[0])
+      .field("dropped", _dropped.load(std::memory_order_relaxed))
+      .field("rate_Hz", (uint32_t)first.rate_Hz)
+      .field("t0_ms", ClockSync::extend(first.t_us) / 1000);
+  w.beginArray("dt_us");
+  for (size_t k = 0; k < count; ++k) w.value((int32_t)(s[pick[k]].t_us - first.t_us));
+  w.endArray().beginArray("V");
+  for (size_t k = 0; k < count; ++k) w.value(s[pick[k]].bus_uV * 1e-6f, 3);
+  w.endArray().beginArray("mA");
+  for (size_t k = 0; k < count; ++k) w.value(s[pick[k]].current_uA * 1e-3f, 1);
+  w.endArray().beginArray("mW");
+  for (size_t k = 0; k < count; ++k) w.value(s[pick[k]].power_uW * 1e-3f, 1);
+  w.endArray().endObject();
+  return w.ok() ? w.length() : 0;
+}
+
+void LiveServer::writeJson(JsonWriter& w) const {
+  w.beginObject("live")
+      .field("clients", (uint32_t)clients())
+      .field("frames", _frames)
+      .field("dropped", _dropped.load(std::memory_order_relaxed))
+      .field("refused", _refused)
+      .endObject();
+}
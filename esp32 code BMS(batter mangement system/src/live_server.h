@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include <atomic>
+
+#include "json_writer.h"
+#include "power_sample.h"
+#include "ring_buffer.h"
+
+// Local live view: an HTTP server (ESP-IDF httpd, its own task) that serves
+// one pre-gzipped page from flash at / and streams samples over a
+// WebSocket at /ws, so someone next to the pack sees every sample without
+// the round trip through the cloud broker.
+//
+// The estimation task add()s each calibrated sample to a private SPSC ring
+// and never waits: with the ring full the sample is counted and dropped,
+// so a slow browser can only lose live samples, never hold up acquisition.
+// poll() hands the ring to the server task at most once per frame; that
+// task then formats one frame per client and sends it. Every client picks
+// its own decimation ("every" samples, from /ws?every=N or a text message
+// "every=N"); beyond maxClients WebSocket connections are refused.
+//
+// Frame: {"seq", "dropped", "rate_Hz", "t0_ms", "dt_us": [..], "V": [..], "mA": [..], "mW": [..]}
+// t0_ms is the 64-bit uptime of the first sample, dt_us the offsets from it.
+// seq numbers streamed samples since begin() (decimation included);
+// dropped counts samples lost to a full ring, so a client can spot gaps.
+class LiveServer {
+public:
+  static const uint8_t MAX_CLIENTS = 4;
+  static const size_t RING_SIZE = 128;      // ~1.3 s at 100 Hz
+  static const size_t FRAME_SAMPLES = 48;   // per frame and client
+  static const uint16_t MAX_EVERY = 1000;
+
+  // page: gzip-compressed HTML in flash, must stay valid. The server task
+  // runs pinned to core at priority.
+  bool begin(uint16_t port, uint8_t maxClients, const uint8_t* pageGz, size_t pageLen, UBaseType_t priority,
+             BaseType_t core);
+  bool running() const { return _server != nullptr; }
+
+  // Estimation task.
+  void add(const PowerSample& s);
+  void poll(uint32_t now_ms, uint32_t frame_ms);
+
+  uint8_t clients() const { return _clientCount.load(std::memory_order_relaxed); }
+
+  // "live": {"clients", "frames", "dropped", "refused"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  struct Client {
+    int fd;           // -1: free
+    uint16_t every;   // send one sample in every
+    uint16_t skip;    // samples until the next one sent
+  };
+
+  static esp_err_t onPage(httpd_req_t* req);
+  static esp_err_t onSocket(httpd_req_t* req);
+  static void onClose(httpd_handle_t hd, int fd);
+  static void sendWork(void* arg);
+
+  Client* find(int fd);
+  void drop(int fd);
+  void sendFrames();
+  size_t formatFrame(Client& c, const PowerSample* s, size_t n, uint32_t seq0);
+
+  httpd_handle_t _server = nullptr;
+  const uint8_t* _page = nullptr;
+  size_t _pageLen = 0;
+  uint8_t _maxClients = 0;
+
+  SpscRing<PowerSample, RING_SIZE> _ring;
+  std::atomic<bool> _queued{false};   // sendWork() is pending on the server task
+  std::atomic<uint8_t> _clientCount{0};
+  uint32_t _lastFrame_ms = 0;
+
+  // Server task only
+  Client _clients[MAX_CLIENTS];
+  uint32_t _seq = 0;
+  PowerSample _batch[FRAME_SAMPLES];
+  char _frame[FRAME_SAMPLES * 40 + 96];
+
+  uint32_t _frames = 0;
+  std::atomic<uint32_t> _dropped{0};
+  uint32_t _refused = 0;
+};
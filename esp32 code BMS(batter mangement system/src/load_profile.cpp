@@ -0,0 +1,56 @@
+#include "load_profile.h"
+
+#include <string.h>
+
+void LoadProfile::begin(int32_t currentMin_uA, int32_t currentMax_uA, int32_t voltageMin_uV, int32_t voltageMax_uV) {
+  _iMin = currentMin_uA;
+  _iMax = currentMax_uA > currentMin_uA ? currentMax_uA : currentMin_uA + 1;
+  _vMin = voltageMin_uV;
+  _vMax = voltageMax_uV > voltageMin_uV ? voltageMax_uV : voltageMin_uV + 1;
+  reset();
+}
+
+void LoadProfile::reset() {
+  memset(_dwell_us, 0, sizeof(_dwell_us));
+  _samples = 0;
+  _outside = 0;
+}
+
+uint8_t LoadProfile::bin(int32_t x, int32_t min, int32_t max, uint8_t bins, bool& outside) {
+  if (x < min) {
+    outside = true;
+    return 0;
+  }
+  if (x >= max) {
+    outside = true;
+    return bins - 1;
+  }
+  return (uint8_t)(((int64_t)x - min) * bins / ((int64_t)max - min));
+}
+
+void LoadProfile::add(uint32_t t_us, int32_t battery_uV, int32_t current_uA, uint16_t rate_Hz) {
+  bool outside = false;
+  uint8_t i = bin(current_uA, _iMin, _iMax, CURRENT_BINS, outside);
+  uint8_t v = bin(battery_uV, _vMin, _vMax, VOLTAGE_BINS, outside);
+  uint32_t& cell = _dwell_us[i][v];
+  uint32_t period_us = rate_Hz ? 1000000u / rate_Hz : 1000000u;
+  cell = cell > UINT32_MAX - period_us ? UINT32_MAX : cell + period_us;
+  if (outside) _outside++;
+  if (!_samples) _firstT = t_us;
+  _lastT = t_us;
+  _samples++;
+}
+
+void LoadProfile::writeJson(JsonWriter& w) const {
+  w.field("n", _samples).field("window_ms", duration_us() / 1000).field("outside", _outside);
+  w.beginArray("i_A").value(_iMin * 1e-6f, 3).value(_iMax * 1e-6f, 3).value((int32_t)CURRENT_BINS).endArray();
+  w.beginArray("v_V").value(_vMin * 1e-6f, 3).value(_vMax * 1e-6f, 3).value((int32_t)VOLTAGE_BINS).endArray();
+  w.beginArray("cells");
+  for (uint8_t i = 0; i < CURRENT_BINS; ++i) {
+    for (uint8_t v = 0; v < VOLTAGE_BINS; ++v) {
+      uint32_t ms = (_dwell_us[i][v] + 500) / 1000;
+      if (ms) w.value((int32_t)i).value((int32_t)v).value((int32_t)ms);
+    }
+  }
+  w.endArray();
+}
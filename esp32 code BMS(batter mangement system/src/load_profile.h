@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "json_writer.h"
+
+// Time the pack spent in each current x voltage cell over one profile
+// window: a 2D histogram that shows the load shape (idle, cruise, bursts,
+// charge) and where it sags, without the full-resolution history.
+//
+// Both axes are equal-width bins over [min, max); readings outside fold into
+// the edge bins and are counted as "outside", so a range that is too narrow
+// shows up instead of silently skewing the corners. Each sample is weighted
+// by its period (1 / rate_Hz, one-off reads 1 s), like TelemetryWindow, so
+// adaptive-rate bursts do not dominate. add() is two integer divisions and
+// an add; the cells are 512 bytes.
+class LoadProfile {
+public:
+  static const uint8_t CURRENT_BINS = 16;
+  static const uint8_t VOLTAGE_BINS = 8;
+
+  // Ranges in the sample's units: signed current (positive = discharge) and
+  // battery terminal voltage. max must be above min.
+  void begin(int32_t currentMin_uA, int32_t currentMax_uA, int32_t voltageMin_uV, int32_t voltageMax_uV);
+  void reset();
+  // Estimation task, every sample.
+  void add(uint32_t t_us, int32_t battery_uV, int32_t current_uA, uint16_t rate_Hz);
+
+  uint32_t samples() const { return _samples; }
+  uint32_t start_us() const { return _firstT; }
+  uint32_t duration_us() const { return _samples ? _lastT - _firstT : 0; }
+
+  // Into an open object: "n", "window_ms", "outside", "i_A": [min, max,
+  // bins], "v_V": [min, max, bins], and "cells": [i, v, ms, ...] for every
+  // cell with time in it, flattened (bin indexes from 0 at min).
+  void writeJson(JsonWriter& w) const;
+
+private:
+  static uint8_t bin(int32_t x, int32_t min, int32_t max, uint8_t bins, bool& outside);
+
+  int32_t _iMin = -2000000;
+  int32_t _iMax = 2000000;
+  int32_t _vMin = 3000000;
+  int32_t _vMax = 4400000;
+  uint32_t _dwell_us[CURRENT_BINS][VOLTAGE_BINS] = {};
+  uint32_t _samples = 0;
+  uint32_t _outside = 0;
+  uint32_t _firstT = 0;
+  uint32_t _lastT = 0;
+};
@@ -0,0 +1,106 @@
+#include "logger.h"
+
+#include <stdarg.h>
+
+Logger logger;
+
+bool Logger::begin(Print& out, BaseType_t core, UBaseType_t priority) {
+  _out = &out;
+  if (_task) return true;
+  return xTaskCreatePinnedToCore(taskEntry, "log", 3072, this, priority, &_task, core) == pdPASS;
+}
+
+void Logger::printf(uint8_t level, const char* fmt, ...) {
+  Line line;
+  line.level = level;
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(line.text, sizeof(line.text), fmt, args);
+  va_end(args);
+  if (n < 0) return;
+  // vsnprintf keeps the last byte for its terminator
+  push(line, (size_t)n, sizeof(line.text) - 1);
+}
+
+void Logger::write(uint8_t level, const char* prefix, const uint8_t* data, size_t len) {
+  Line line;
+  line.level = level;
+  size_t p = strnlen(prefix, sizeof(line.text));
+  memcpy(line.text, prefix, p);
+  size_t n = len < sizeof(line.text) - p ? len : sizeof(line.text) - p;
+  memcpy(line.text + p, data, n);
+  push(line, p + len, sizeof(line.text));
+}
+
+// want: the full length of the text, more than room if it was cut
+void Logger::push(Line& line, size_t want, size_t room) {
+  if (want > room) _truncated.fetch_add(1, std::memory_order_relaxed);
+  line.len = (uint8_t)(want < room ? want : room);
+  if (_ring.push(line)) {
+    _lines.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Logger::drain() {
+  if (!_out) return;
+  uint32_t depth = (uint32_t)_ring.size();
+  if (depth > _maxDepth) _maxDepth = depth;
+  static const char* const TAGS[] = { "", "E ", "W ", "", "D " };
+  Line line;
+  while (_ring.pop(line)) {
+    if (line.level < sizeof(TAGS) / sizeof(TAGS[0])) _out->print(TAGS[line.level]);
+    _out->write((const uint8_t*)line.text, line.len);
+    _out->println();
+  }
+  uint32_t dropped = _dropped.load(std::memory_order_relaxed);
+  if (dropped != _reported) {
+    _out->printf("(log: %lu lines dropped)\n", (unsigned long)(dropped - _reported));
+    _reported = dropped;
+  }
+}
+
+void Logger::flush() {
+  if (!_task) {
+    drain();
+  } else {
+    // The ring has a single consumer: give the drain task time to empty it
+    for (uint32_t waited = 0; !_ring.empty() && waited < FLUSH_TIMEOUT_MS; waited += DRAIN_MS) {
+      vTaskDelay(pdMS_TO_TICKS(DRAIN_MS));
+    }
+  }
+  if (_out) _out->flush();
+}
+
+void Logger::taskEntry(void* arg) {
+  Logger* self = static_cast<Logger*>(arg);
+  for (;;) {
+    self->drain();
+    vTaskDelay(pdMS_TO_TICKS(DRAIN_MS));
+  }
+}
+
+void Logger::writeJson(JsonWriter& w) const {
+  w.beginObject("log")
+      .field("level", (uint32_t)LOG_LEVEL)
+      .field("lines", lines())
+      .field("dropped", dropped())
+      .field("truncated", _truncated.load(std::memory_order_relaxed))
+      .field("max_depth", _maxDepth)
+      .endObject();
+}
+
+size_t LogPrint::write(uint8_t c) {
+  if (c == '\n') {
+    flushLine();
+  } else if (c != '\r' && _len < sizeof(_buf)) {
+    _buf[_len++] = (char)c;
+  }
+  return 1;
+}
+
+void LogPrint::flushLine() {
+  if (_len) _log.write(_level, "", (const uint8_t*)_buf, _len);
+  _len = 0;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "json_writer.h"
+#include "ring_buffer.h"
+
+// Compile-time log levels: a build with -DLOG_LEVEL=LOG_LEVEL_WARN drops
+// the info and debug calls, format strings included.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_ENABLED(level) (LOG_LEVEL >= (level))
+// Still type-checked, and arguments count as used, but never run; the
+// optimizer drops the call and its strings.
+#define LOG_DISCARD(level, ...)                   \
+  do {                                            \
+    if (false) logger.printf(level, __VA_ARGS__); \
+  } while (0)
+
+#if LOG_ENABLED(LOG_LEVEL_ERROR)
+#define LOG_ERROR(...) logger.printf(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(LOG_LEVEL_ERROR, __VA_ARGS__)
+#endif
+#if LOG_ENABLED(LOG_LEVEL_WARN)
+#define LOG_WARN(...) logger.printf(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISCARD(LOG_LEVEL_WARN, __VA_ARGS__)
+#endif
+#if LOG_ENABLED(LOG_LEVEL_INFO)
+#define LOG_INFO(...) logger.printf(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(LOG_LEVEL_INFO, __VA_ARGS__)
+#endif
+#if LOG_ENABLED(LOG_LEVEL_DEBUG)
+#define LOG_DEBUG(...) logger.printf(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#endif
+
+// Serial log that never makes the caller wait for the UART.
+//
+// printf() formats into a line on the caller's stack and pushes it into an
+// MpscRing, a copy and one compare-and-swap; a low-priority task writes the
+// lines out at whatever pace the UART takes. From any task on either core,
+// not from ISRs (vsnprintf). When the ring is full the line is dropped and
+// counted, and the drain task says how many went missing once it catches
+// up, so a burst of logging costs lines, not sampling or publish time.
+// Lines are cut at LINE_MAX characters (counted too). Each line is printed
+// as is (errors and warnings tagged "E " / "W "), one per call, without a
+// trailing newline in the format.
+class Logger {
+public:
+  static const size_t LINE_MAX = 120;
+  static const size_t LINES = 32;        // ring capacity
+  static const uint32_t DRAIN_MS = 20;   // drain task period
+  static const uint32_t FLUSH_TIMEOUT_MS = 500;
+
+  // Until begin() lines queue up (and are dropped once the ring is full).
+  bool begin(Print& out, BaseType_t core = PRO_CPU_NUM, UBaseType_t priority = 1);
+
+  void printf(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+  // prefix followed by len bytes of data that are not a format string,
+  // e.g. an MQTT payload.
+  void write(uint8_t level, const char* prefix, const uint8_t* data, size_t len);
+  // Waits (up to FLUSH_TIMEOUT_MS) until what is queued is written out,
+  // e.g. before a reset.
+  void flush();
+
+  uint32_t lines() const { return _lines.load(std::memory_order_relaxed); }
+  uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  // "log": {"level", "lines", "dropped", "truncated", "max_depth"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  struct Line {
+    uint8_t level;
+    uint8_t len;
+    char text[LINE_MAX];
+  };
+
+  void push(Line& line, size_t want, size_t room);
+  void drain();
+  static void taskEntry(void* arg);
+
+  MpscRing<Line, LINES> _ring;
+  Print* _out = nullptr;
+  TaskHandle_t _task = nullptr;
+  std::atomic<uint32_t> _lines{0};
+  std::atomic<uint32_t> _dropped{0};
+  std::atomic<uint32_t> _truncated{0};
+  uint32_t _reported = 0;   // drops already announced (drain side)
+  uint32_t _maxDepth = 0;   // deepest ring seen by the drain
+};
+
+// A Print whose output goes to the logger, one line per '\n', for code
+// that prints to a Print& (e.g. HealthMonitor::print).
+class LogPrint : public Print {
+public:
+  LogPrint(Logger& log, uint8_t level) : _log(log), _level(level) {}
+  ~LogPrint() { flushLine(); }
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+private:
+  void flushLine();
+
+  Logger& _log;
+  uint8_t _level;
+  char _buf[Logger::LINE_MAX];
+  size_t _len = 0;
+};
+
+extern Logger logger;
@@ -0,0 +1,71 @@
+#include "loop_trace.h"
+
+#ifdef LOOP_TRACE
+
+static const char* const STAGE_NAMES[] = { "loop", "wifi", "mqtt", "queue", "samples", "format", "publish", "display" };
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == (size_t)TraceStage::COUNT, "one name per stage");
+
+LoopTrace::Histogram LoopTrace::_stages[(uint8_t)TraceStage::COUNT];
+
+uint32_t LoopTrace::upperEdge(uint8_t bucket) {
+  uint8_t octave = bucket / SUB_BUCKETS + MIN_OCTAVE;
+  uint8_t sub = bucket % SUB_BUCKETS;
+  return ((uint32_t)(SUB_BUCKETS + sub + 1) << (octave - 2)) - 1;
+}
+
+uint32_t LoopTrace::percentile_cycles(TraceStage stage, float q) {
+  const Histogram& h = _stages[(uint8_t)stage];
+  if (!h.count) return 0;
+  // Rank of the quantile, 1-based and rounded up.
+  uint32_t rank = (uint32_t)ceilf(q * h.count);
+  if (rank < 1) rank = 1;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < BUCKETS; ++b) {
+    seen += h.buckets[b];
+    if (seen >= rank) {
+      // The last bucket also holds everything clamped into it.
+      uint32_t edge = b == BUCKETS - 1 ? h.max : upperEdge(b);
+      return edge < h.max ? edge : h.max;
+    }
+  }
+  return h.max;
+}
+
+void LoopTrace::reset() { memset(_stages, 0, sizeof(_stages)); }
+
+static float toMicros(uint32_t cycles) { return (float)cycles / getCpuFrequencyMhz(); }
+
+void printLoopTrace(Print& out) {
+  for (uint8_t k = 0; k < (uint8_t)TraceStage::COUNT; ++k) {
+    TraceStage stage = (TraceStage)k;
+    if (!LoopTrace::count(stage)) continue;
+    out.printf("%-8s %7u calls  p50 %9.1f us  p99 %9.1f us  max %9.1f us\n", STAGE_NAMES[k],
+               LoopTrace::count(stage), toMicros(LoopTrace::percentile_cycles(stage, 0.5f)),
+               toMicros(LoopTrace::percentile_cycles(stage, 0.99f)), toMicros(LoopTrace::max_cycles(stage)));
+  }
+}
+
+void writeLoopTrace(JsonWriter& w) {
+  w.beginObject("stages");
+  for (uint8_t k = 0; k < (uint8_t)TraceStage::COUNT; ++k) {
+    TraceStage stage = (TraceStage)k;
+    if (!LoopTrace::count(stage)) continue;
+    w.beginObject(STAGE_NAMES[k])
+        .field("n", LoopTrace::count(stage))
+        .field("p50_us", toMicros(LoopTrace::percentile_cycles(stage, 0.5f)), 1)
+        .field("p99_us", toMicros(LoopTrace::percentile_cycles(stage, 0.99f)), 1)
+        .field("max_us", toMicros(LoopTrace::max_cycles(stage)), 1)
+        .endObject();
+  }
+  w.endObject();
+}
+
+void resetLoopTrace() { LoopTrace::reset(); }
+
+#else
+
+void printLoopTrace(Print& out) { out.println("Loop trace: build with -DLOOP_TRACE"); }
+void writeLoopTrace(JsonWriter&) {}
+void resetLoopTrace() {}
+
+#endif
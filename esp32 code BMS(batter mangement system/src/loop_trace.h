@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Print.h>
+
+#include "json_writer.h"
+
+// Where the firmware tasks spend their time, kept only when built with -DLOOP_TRACE
+// (platformio.ini build_flags).
+//
+// A TraceScope reads the CPU cycle counter when it is created and again when
+// it goes out of scope (or at stop()), and adds the difference to its
+// stage's histogram: log-linear buckets, four per power of two, so
+// percentiles are within ~19 % and the max is exact. Recording is a
+// subtraction, a count-leading-zeros and an increment; without the flag the
+// class is empty and every scope compiles away. Each stage is recorded by
+// one task only (see the task layout in main.cpp), so nothing is locked.
+enum class TraceStage : uint8_t {
+  Loop,        // one whole network pass
+  Wifi,        // wifiManager.poll()
+  Mqtt,        // mqttPoll(): connect state machine and mqttClient.loop()
+  Queue,       // flash queue drain and housekeeping
+  Samples,     // estimation: draining the sampler into the counters and windows
+  Format,      // estimation: building a window's payloads into the outbox
+  Publish,     // publishOrQueue(): MQTT publish or flash fallback
+  Display,     // display.display() from the ui task
+  COUNT
+};
+
+#ifdef LOOP_TRACE
+
+class LoopTrace {
+public:
+  static const uint8_t SUB_BUCKETS = 4;   // per power of two
+  static const uint8_t MIN_OCTAVE = 6;    // everything under 64 cycles shares the first bucket
+  static const uint8_t OCTAVES = 24;      // up to 2^30 cycles (~4.5 s at 240 MHz); longer is clamped
+  static const uint8_t BUCKETS = OCTAVES * SUB_BUCKETS;
+
+  static inline void record(TraceStage stage, uint32_t cycles) {
+    Histogram& h = _stages[(uint8_t)stage];
+    h.count++;
+    if (cycles > h.max) h.max = cycles;
+    h.buckets[bucket(cycles)]++;
+  }
+
+  static uint32_t count(TraceStage stage) { return _stages[(uint8_t)stage].count; }
+  static uint32_t max_cycles(TraceStage stage) { return _stages[(uint8_t)stage].max; }
+  // Upper edge of the bucket holding the q-th quantile (0..1), exact max for q = 1.
+  static uint32_t percentile_cycles(TraceStage stage, float q);
+  static void reset();
+
+private:
+  struct Histogram {
+    uint32_t count;
+    uint32_t max;
+    uint32_t buckets[BUCKETS];
+  };
+
+  static inline uint8_t bucket(uint32_t cycles) {
+    if (cycles < (1UL << MIN_OCTAVE)) return 0;
+    uint8_t octave = 31 - __builtin_clz(cycles);
+    if (octave >= MIN_OCTAVE + OCTAVES) return BUCKETS - 1;
+    uint8_t sub = (cycles >> (octave - 2)) & (SUB_BUCKETS - 1);
+    return (octave - MIN_OCTAVE) * SUB_BUCKETS + sub;
+  }
+  static uint32_t upperEdge(uint8_t bucket);
+
+  static Histogram _stages[(uint8_t)TraceStage::COUNT];
+};
+
+class TraceScope {
+public:
+  explicit TraceScope(TraceStage stage) : _stage(stage), _start(ESP.getCycleCount()) {}
+  ~TraceScope() { stop(); }
+  // Records now instead of at the end of the scope; later calls do nothing.
+  void stop() {
+    if (_running) {
+      _running = false;
+      LoopTrace::record(_stage, ESP.getCycleCount() - _start);
+    }
+  }
+
+private:
+  TraceStage _stage;
+  uint32_t _start;
+  bool _running = true;
+};
+
+#else
+
+class TraceScope {
+public:
+  explicit TraceScope(TraceStage) {}
+  void stop() {}
+};
+
+#endif
+
+// One line per stage that ran: calls, p50, p99 and max in microseconds.
+void printLoopTrace(Print& out);
+// "stages": {"<stage>": {"n", "p50_us", "p99_us", "max_us"}, ..}
+void writeLoopTrace(JsonWriter& w);
+// Starts a new measurement window, e.g. after each diagnostics publish.
+void resetLoopTrace();
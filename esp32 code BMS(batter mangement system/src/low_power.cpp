@@ -0,0 +1,84 @@
+#include "low_power.h"
+
+#include <esp_sleep.h>
+
+#include "logger.h"
+
+// Added to the configured conversion time: power-down recovery and I2C.
+static const uint32_t INA_CONVERSION_MARGIN_US = 1000;
+// Below this a light-sleep round trip costs more than it saves.
+static const int32_t MIN_SLEEP_US = 3000;
+// Wake-up latency taken off the sleep time so the next slot is not missed.
+static const uint32_t WAKE_MARGIN_US = 500;
+
+static const char* const PHASE_KEYS[PowerProfile::PHASES] = {"active", "duty", "uplink"};
+
+void PowerProfile::add(PowerPhase phase, uint32_t t_us, int32_t current_uA) {
+  if (_primed) {
+    uint32_t dt_us = t_us - _lastT_us;
+    Acc& a = _acc[(uint8_t)phase];
+    a.charge2_uAus += ((int64_t)current_uA + _lastCurrent_uA) * dt_us;
+    a.time_us += dt_us;
+  }
+  _primed = true;
+  _lastT_us = t_us;
+  _lastCurrent_uA = current_uA;
+}
+
+float PowerProfile::average_mA(PowerPhase phase) const {
+  const Acc& a = _acc[(uint8_t)phase];
+  return a.time_us ? (float)(a.charge2_uAus / (int64_t)(2 * a.time_us)) * 1e-3f : 0.0f;
+}
+
+void PowerProfile::writeJson(JsonWriter& w) const {
+  w.beginObject("avg_mA");
+  for (uint8_t p = 0; p < PHASES; ++p) {
+    if (_acc[p].time_us) w.field(PHASE_KEYS[p], average_mA((PowerPhase)p), 2);
+  }
+  w.endObject();
+}
+
+bool sampleTriggered(Adafruit_INA219* ina, PowerSample& out) {
+  ina->triggerConversion();
+  bool ok = Sampler::read(ina, out, ina->conversionTime_us() + INA_CONVERSION_MARGIN_US);
+  ina->powerSave(true);
+  return ok;
+}
+
+void DutyCycle::begin(uint32_t samplePeriod_us, uint16_t uplinkEveryWindows, uint32_t uplinkTimeout_ms) {
+  _samplePeriod_us = samplePeriod_us ? samplePeriod_us : 1;
+  _uplinkEvery = uplinkEveryWindows ? uplinkEveryWindows : 1;
+  _uplinkTimeout_ms = uplinkTimeout_ms;
+  _windows = 0;
+  _nextSample_us = micros();
+}
+
+void DutyCycle::sampled() {
+  _nextSample_us += _samplePeriod_us;
+  // Fell behind (e.g. a blocking connect): resynchronise instead of bursting
+  if ((int32_t)(micros() - _nextSample_us) > 0) _nextSample_us = micros() + _samplePeriod_us;
+}
+
+bool DutyCycle::windowDone() {
+  if (_uplink || ++_windows < _uplinkEvery) return false;
+  _windows = 0;
+  return true;
+}
+
+void DutyCycle::startUplink(uint32_t now_ms) {
+  _uplink = true;
+  _uplinkSince_ms = now_ms;
+}
+
+void DutyCycle::endUplink() { _uplink = false; }
+
+void DutyCycle::sleep() {
+  if (_uplink) return;
+  int32_t remaining_us = (int32_t)(_nextSample_us - micros());
+  if (remaining_us < MIN_SLEEP_US) return;
+  logger.flush();   // UART output is lost across light sleep otherwise
+  remaining_us = (int32_t)(_nextSample_us - micros());
+  if (remaining_us < MIN_SLEEP_US) return;
+  esp_sleep_enable_timer_wakeup(remaining_us - WAKE_MARGIN_US);
+  esp_light_sleep_start();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_INA219.h>
+
+#include "json_writer.h"
+#include "sampler.h"
+
+// Firmware operating mode (POWER_MODE in main.cpp).
+enum class PowerMode : uint8_t {
+  Continuous,   // sampler task at SAMPLE_RATE_HZ, WiFi always on (default)
+  LowPower,     // duty-cycled: triggered INA219 reads, light sleep, periodic uplink
+};
+
+// What the node was doing while a sample was taken.
+enum class PowerPhase : uint8_t {
+  Active,   // continuous mode
+  Duty,     // low-power sampling, light sleep in between
+  Uplink,   // low-power mode with the radio on
+};
+
+// Average battery current per phase, integrated from the INA219 readings
+// (trapezoidal, attributed to the phase of the later sample). Wired so the
+// node runs from the monitored battery, this is the node's own draw.
+class PowerProfile {
+public:
+  static const uint8_t PHASES = 3;
+
+  void add(PowerPhase phase, uint32_t t_us, int32_t current_uA);
+  float average_mA(PowerPhase phase) const;
+  uint32_t time_ms(PowerPhase phase) const { return (uint32_t)(_acc[(uint8_t)phase].time_us / 1000); }
+  // "avg_mA": {"active": .., "duty": .., "uplink": ..}, phases seen so far.
+  void writeJson(JsonWriter& w) const;
+
+private:
+  struct Acc {
+    int64_t charge2_uAus;   // twice the trapezoid area
+    uint64_t time_us;
+  };
+  Acc _acc[PHASES] = {};
+  uint32_t _lastT_us = 0;
+  int32_t _lastCurrent_uA = 0;
+  bool _primed = false;
+};
+
+// One triggered conversion with the INA219 otherwise powered down: start
+// it, wait for CNVR, read, and power the chip down again (powerSave()).
+// Returns false if the conversion did not complete.
+bool sampleTriggered(Adafruit_INA219* ina, PowerSample& out);
+
+// Schedule for PowerMode::LowPower. loop() samples when sampleDue(), calls
+// windowDone() after each publish window and sleep() at the end of every
+// pass; the radio is only on between startUplink() and endUplink().
+class DutyCycle {
+public:
+  void begin(uint32_t samplePeriod_us, uint16_t uplinkEveryWindows, uint32_t uplinkTimeout_ms);
+
+  bool sampleDue() const { return (int32_t)(micros() - _nextSample_us) >= 0; }
+  void sampled();
+
+  // Returns true when this window should be followed by an uplink.
+  bool windowDone();
+  void startUplink(uint32_t now_ms);
+  void endUplink();
+  bool uplinking() const { return _uplink; }
+  bool uplinkExpired(uint32_t now_ms) const { return now_ms - _uplinkSince_ms > _uplinkTimeout_ms; }
+  PowerPhase phase() const { return _uplink ? PowerPhase::Uplink : PowerPhase::Duty; }
+
+  // Light-sleeps until the next sample slot; no-op while uplinking.
+  void sleep();
+
+private:
+  uint32_t _samplePeriod_us = 1000000;
+  uint32_t _nextSample_us = 0;
+  uint16_t _uplinkEvery = 1;
+  uint16_t _windows = 0;
+  uint32_t _uplinkTimeout_ms = 30000;
+  uint32_t _uplinkSince_ms = 0;
+  bool _uplink = false;
+};
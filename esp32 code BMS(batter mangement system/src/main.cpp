@@ -1,19 +1,74 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
 #include <PubSubClient.h>
 #include <Wire.h>
 #include <Adafruit_INA219.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include <Adafruit_SSD1306_StripChart.h>
+#include <esp_wifi.h>
+#include <lwip/sockets.h>
+
+#include "adaptive_rate.h"
+#include "aggregator.h"
+#include "anomaly_detector.h"
+#include "binary_codec.h"
+#include "ble_link.h"
+#include "block_pool.h"
+#include "board_profile.h"
+#include "broker_pool.h"
+#include "bus_clock.h"
+#include "button.h"
+#include "ca_bundle.h"
+#include "cell_monitor.h"
+#include "clock_sync.h"
+#include "coulomb_counter.h"
+#include "dashboard.h"
+#include "energy_meter.h"
+#include "espnow_link.h"
+#include "event_capture.h"
+#include "flash_queue.h"
+#include "health_monitor.h"
+#include "i2c_stats.h"
+#include "i2c_topology.h"
+#include "ina219_bank.h"
+#include "json_writer.h"
+#include "live_page.h"
+#include "live_server.h"
+#include "load_profile.h"
+#include "logger.h"
+#include "loop_trace.h"
+#include "low_power.h"
+#include "mem_placement.h"
+#include "ocv_table.h"
+#include "ota_update.h"
+#include "protection.h"
+#include "remote_config.h"
+#include "report_filter.h"
+#include "sampler.h"
+#include "serial_stream.h"
+#include "soc_checkpoint.h"
+#include "soc_ekf.h"
+#include "soh_estimator.h"
+#include "status_leds.h"
+#include "supervisor.h"
+#include "task_queues.h"
+#include "tls_session_client.h"
+#include "topic_layout.h"
+#include "topic_router.h"
+#include "wifi_manager.h"
 
 #ifndef LED_BUILTIN
 #define LED_BUILTIN 2
 #endif
 
 // --- CONFIG: fill these in ---
-// Multiple WiFi credentials: the ESP32 will try these in order until one connects.
-struct WifiCred { const char* ssid; const char* password; };
+// Board and feature profile (board_profile.h), chosen per PlatformIO env with -DBMS_PROFILE: which
+// sensor and display are fitted, the default encoding and the uplink role
+static constexpr BoardProfile PROFILE = BMS_PROFILE;
+
+// Multiple WiFi credentials: the ESP32 ranks these by signal strength and
+// connects to the best one available (see wifi_manager.h).
 static const WifiCred WIFI_CREDENTIALS[] = {
   { "MiM", "Ha20202021" },
   { "Teachers_WiFi_SUST", "SUST11s34" },
@@ -26,10 +81,95 @@ const char* MQTT_BROKER = "0d34f5789e1e4a669367abfe5bd45b15.s1.eu.hivemq.cloud";
 const int MQTT_PORT = 8883; // TLS port (use 8884 + /mqtt path for WebSockets browser)
 const char* MQTT_USER = "battery"; // HiveMQ Cloud user (if any)
 const char* MQTT_PASSWORD = "Batterybms80"; // HiveMQ Cloud password (if any)
+// Brokers in priority order; with more than one, BrokerPool probes them and fails over
+const BrokerConfig MQTT_BROKERS[] = {
+  { MQTT_BROKER, MQTT_PORT, true, MQTT_USER, MQTT_PASSWORD },
+  // LAN broker on the dashboard server, e.g.
+  // { "192.168.1.10", 1883, false, nullptr, nullptr },
+};
+static const uint32_t BROKER_PROBE_INTERVAL_MS = 30000;
+static const uint32_t BROKER_PROBE_TIMEOUT_MS = 2000;
+static const uint8_t BROKER_FAILOVER_AFTER = 2;     // failed connects in a row
+static const uint32_t BROKER_SWITCH_MARGIN_MS = 20; // RTT win needed to move off a working broker
+static const uint8_t BROKER_SWITCH_ROUNDS = 3;      // ... for this many probe rounds in a row
 
-// Topics
-const char* PUB_TOPIC = "battery/data";
-const char* SUB_TOPIC = "battery/recieve";
+// Wall clock (clock_sync.h): SNTP resyncs every NTP_RESYNC_MS once WiFi is up. Telemetry carries
+// "ts", the UTC ms at which its first sample was acquired, from the first sync on; binary messages
+// carry it as utc0_ms (0 before that). "uptime_ms" is the 64-bit monotonic clock and never wraps.
+static const char* NTP_SERVER_1 = "pool.ntp.org";
+static const char* NTP_SERVER_2 = "time.cloudflare.com";
+static const uint32_t NTP_RESYNC_MS = 3600000;
+ClockSync clockSync;
+
+// Topics: TOPIC_TEMPLATE expanded per stream (topic_layout.h), e.g. battery/bms-a1b2c3d4e5f6/aggregate.
+// {device_id} is DEVICE_ID, or "bms-" and the eFuse MAC when that is empty. Each stream has its own
+// sub-topic, so ingestion subscribes per stream for the whole site ("battery/+/aggregate") and can
+// share one stream among consumers ("$share/<group>/battery/+/aggregate"). Set in buildTopics().
+static const char* TOPIC_TEMPLATE = "{site}/{device_id}/{stream}";
+static const char* TOPIC_SITE = "battery";
+static const char* DEVICE_ID = "";
+TopicLayout topics;
+const char* PUB_TOPIC;            // aggregate      JSON windows (PublishMode::Aggregate)
+const char* PUB_TOPIC_RAW;        // raw            JSON samples (PublishMode::Latest / RawBatch), demo values
+const char* PUB_TOPIC_BIN;        // raw/bin        compact binary stream (binary_codec.h)
+const char* PUB_TOPIC_EVENT;      // event          transient captures (event_capture.h)
+const char* PUB_TOPIC_PROTECTION; // protection     cutoff trips and releases, retained (protection.h)
+const char* PUB_TOPIC_ENERGY;     // energy         hourly and daily Ah / Wh summaries (energy_meter.h)
+const char* PUB_TOPIC_LOAD;       // load           current x voltage histograms (load_profile.h)
+const char* PUB_TOPIC_ALERT;      // alert          anomaly flags as they are raised (anomaly_detector.h)
+const char* PUB_TOPIC_DIAG;       // diag/i2c       BusIO I2C counters (i2c_stats.h)
+const char* PUB_TOPIC_LOOP;       // diag/loop      loop() stage timings (loop_trace.h)
+const char* PUB_TOPIC_HEALTH;     // diag/health    heap, stacks, TLS memory (health_monitor.h)
+const char* PUB_TOPIC_CONFIG;     // config/state   active config and the last document's result
+const char* PUB_TOPIC_OTA;        // ota/status     progress, and the next offset the device wants
+const char* SUB_TOPIC;            // cmd            payload commands
+const char* SUB_TOPIC_CONFIG;     // config         remote config documents (remote_config.h)
+const char* SUB_TOPIC_OTA_BEGIN;  // ota/begin      firmware update manifest (ota_update.h)
+const char* SUB_TOPIC_OTA_CHUNK;  // ota/chunk      one requested piece of the image
+const char* SUB_TOPIC_OTA_ABORT;  // ota/abort
+// Subscribed in one SUBSCRIBE packet
+const char* SUB_TOPICS[5];
+
+static void buildTopics() {
+  char id[TopicLayout::DEVICE_ID_MAX];
+  if (DEVICE_ID[0]) {
+    strncpy(id, DEVICE_ID, sizeof(id) - 1);
+    id[sizeof(id) - 1] = '\0';
+  } else {
+    uint64_t efuse = ESP.getEfuseMac();
+    uint8_t mac[6];
+    for (uint8_t b = 0; b < 6; ++b) mac[b] = (uint8_t)(efuse >> (8 * b));
+    TopicLayout::deviceIdFromMac(mac, id, sizeof(id));
+  }
+  topics.begin(TOPIC_TEMPLATE, TOPIC_SITE, id);
+  PUB_TOPIC = topics.add("aggregate");
+  PUB_TOPIC_RAW = topics.add("raw");
+  PUB_TOPIC_BIN = topics.add("raw/bin");
+  PUB_TOPIC_EVENT = topics.add("event");
+  PUB_TOPIC_PROTECTION = topics.add("protection");
+  PUB_TOPIC_ENERGY = topics.add("energy");
+  PUB_TOPIC_LOAD = topics.add("load");
+  PUB_TOPIC_ALERT = topics.add("alert");
+  PUB_TOPIC_DIAG = topics.add("diag/i2c");
+  PUB_TOPIC_LOOP = topics.add("diag/loop");
+  PUB_TOPIC_HEALTH = topics.add("diag/health");
+  PUB_TOPIC_CONFIG = topics.add("config/state");
+  PUB_TOPIC_OTA = topics.add("ota/status");
+  SUB_TOPICS[0] = SUB_TOPIC = topics.add("cmd");
+  SUB_TOPICS[1] = SUB_TOPIC_CONFIG = topics.add("config");
+  SUB_TOPICS[2] = SUB_TOPIC_OTA_BEGIN = topics.add("ota/begin");
+  SUB_TOPICS[3] = SUB_TOPIC_OTA_CHUNK = topics.add("ota/chunk");
+  SUB_TOPICS[4] = SUB_TOPIC_OTA_ABORT = topics.add("ota/abort");
+}
+// Topic index stored with each queued message (see flash_queue.h)
+enum QueuedTopic : uint8_t {
+  QUEUE_TOPIC_AGGREGATE = 0,
+  QUEUE_TOPIC_BIN = 1,
+  QUEUE_TOPIC_ENERGY = 2,
+  QUEUE_TOPIC_RAW = 3,
+  QUEUE_TOPIC_LOAD = 4,
+  QUEUE_TOPIC_ALERT = 5,
+};
 
 // Pin / I2C configuration (user-provided)
 static const int OLED_SDA_PIN = 21; // OLED SDA
@@ -40,6 +180,18 @@ static const int BUTTON_PIN   = 25; // Button input
 
 // I2C addresses
 static const uint8_t OLED_ADDRESS = 0x3C;
+static const uint8_t OLED_CANDIDATES[] = { OLED_ADDRESS, 0x3D }; // SA0 low / high
+static const uint8_t INA_ADDRESS = INA219_ADDRESS;
+// I2C_INA clocks tried at first boot (or FAST_BOOT = false); the fastest at
+// which INA219 calibration-register write/read-backs all pass is kept in
+// NVS. The ESP32 controller tops out at 1 MHz (no 2.56 MHz HS mode), and
+// above 400 kHz the pull-ups must be strong enough. I2C_OLED stays at
+// 400 kHz: the SSD1306 cannot be read back.
+static const uint32_t INA_BUS_CLOCKS[] = { 100000, 400000, 1000000 };
+static const BusClockTest INA_CLOCK_TEST = { INA219_REG_CALIBRATION, 0xFFFE };
+// Boot probes only the addresses above; false restores the full bus scan
+// and status-screen delays
+static const bool FAST_BOOT = true;
 // OLED dimensions
 static const int OLED_WIDTH = 128;
 static const int OLED_HEIGHT = 64;
@@ -47,312 +199,1893 @@ static const int OLED_HEIGHT = 64;
 // Create two separate I2C buses
 TwoWire I2C_OLED = TwoWire(0);
 TwoWire I2C_INA  = TwoWire(1);
+static const I2cBusName I2C_BUSES[] = { { &I2C_OLED, "oled" }, { &I2C_INA, "ina" } };
+
+// I2C diagnostics, only with build_flags -DBUSIO_I2C_STATS: counters are
+// published on PUB_TOPIC_DIAG every I2C_DIAG_INTERVAL and then reset; the
+// I2C_STATS command prints them to Serial
+static const unsigned long I2C_DIAG_INTERVAL = 60000;
+unsigned long lastI2cDiag = 0;
+
+// Loop timing, only with build_flags -DLOOP_TRACE: per-stage p50/p99/max go
+// to Serial and PUB_TOPIC_LOOP every LOOP_TRACE_INTERVAL, then start over;
+// the LOOP_STATS command prints the current window
+static const unsigned long LOOP_TRACE_INTERVAL = 60000;
+unsigned long lastLoopTrace = 0;
+
+// Heap fragmentation, minimum free heap, stack high-water marks and TLS
+// memory, printed and published on PUB_TOPIC_HEALTH every HEALTH_INTERVAL.
+// Tasks by FreeRTOS name; only ones that live for the whole run (the MQTT
+// connect task comes and goes)
+static const unsigned long HEALTH_INTERVAL = 300000;
+static const char* const HEALTH_TASKS[] = { "loopTask", "sampler", "estimation", "ui",         "network",
+                                            "ssd1306",  "leds",    "brokers",    "supervisor", "httpd" };
+HealthMonitor healthMonitor;
+unsigned long lastHealth = 0;
+bool healthPending = false;   // requested from the estimation pass, not yet published
+
+// Per-string INA219s for multi-string packs: { bus, address 0x41..0x4F }.
+// The primary sensor at INA_ADDRESS stays on the sampler; address 0 = unused.
+static const Ina219Bank::Channel INA_STRINGS[] = {
+  { &I2C_INA, 0 }, // e.g. { &I2C_INA, 0x41 }, { &I2C_OLED, 0x44 },
+};
+static const unsigned long STRING_SAMPLE_INTERVAL = 100;
+Ina219Bank stringBank;
+BankSample stringSample = {};
+unsigned long lastStringSample = 0;
+
+// Per-cell voltages (cell_monitor.h) for a series pack: one resistor-divider tap per cell on an
+// ADC1 pin, { channel, attenuation, divider ratio }, bottom cell first; divider 0 = unused. ADC1
+// scans them by DMA at CELL_ADC_RATE_HZ and averages CELL_OVERSAMPLE conversions per tap into each
+// block (20 kHz / 50 over 4 taps = 100 blocks/s, the INA219's rate). Every INA219 sample is paired
+// with the cells at its acquisition time; windows carry per-cell min/max/mean as "cells".
+static const CellTap CELL_TAPS[] = {
+  { 6, ADC_ATTEN_DB_11, 0.0f }, // e.g. { 6, ADC_ATTEN_DB_11, 2.0f } (GPIO34), { 7, ADC_ATTEN_DB_11, 3.0f } (GPIO35)
+};
+static const uint32_t CELL_ADC_RATE_HZ = 20000;
+static const uint16_t CELL_OVERSAMPLE = 50;
+CellMonitor cellMonitor;
+CellWindow cellWindow;
+
+// INA219 front end: 0.1 ohm shunt, 2 A full scale, 8x hardware averaging on
+// both ADCs (8.5 ms per shunt+bus pair) for low-noise coulomb counting
+static constexpr Ina219Profile INA_PROFILE = INA219_profile(
+    INA219_CONFIG_BVOLTAGERANGE_32V, INA219_CONFIG_GAIN_8_320MV, INA219_CONFIG_BADCRES_12BIT_8S_4260US,
+    INA219_CONFIG_SADCRES_12BIT_8S_4260US, INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS, 0.1f, 2.0f);
 
 // INA219 object (use I2C_INA bus)
-Adafruit_INA219 ina219 = Adafruit_INA219();
-bool inaPresent = false;
+Adafruit_INA219 ina219 = Adafruit_INA219(INA_ADDRESS);
+Presence<PROFILE.ina219> inaPresent;
 
 // OLED display (use I2C_OLED bus)
 Adafruit_SSD1306 display(OLED_WIDTH, OLED_HEIGHT, &I2C_OLED, -1);
-bool oledPresent = false;
+Presence<PROFILE.oled> oledPresent;
+
+// With OLED_TREND the page shows V / I / P in small text above a strip chart of the battery
+// current, one column per OLED_TREND_INTERVAL (128 columns = 32 s); each column costs a few bytes
+static const bool OLED_TREND = false;
+static const unsigned long OLED_TREND_INTERVAL = 250;
+static const float OLED_TREND_MIN_A = -2.0f;
+static const float OLED_TREND_MAX_A = 2.0f;
+Adafruit_SSD1306_StripChart currentTrend(display, 0, 16, OLED_WIDTH, 40);
+unsigned long lastTrend = 0;
+
+// OLED page (see dashboard.h): labels and value fields are declared in setup(), each publish
+// only sets the values, and render() redraws the fields whose text changed
+enum PageField : uint8_t { FIELD_V, FIELD_I, FIELD_P, FIELD_SOC, FIELD_SOH };
+Dashboard page;
+
+// BUTTON_PIN pages through the screens: a press shows the next one, a long press goes back to
+// V / I / P. Edges are debounced by a GPIO interrupt and a one-shot timer (see button.h); the UI
+// task sleeps on the button's event queue, so nothing polls the pin.
+static const uint32_t BUTTON_DEBOUNCE_MS = 30;
+static const uint32_t BUTTON_LONG_PRESS_MS = 800;
+Button button;
+enum class Screen : uint8_t { Power, SocTrend, SocGauge, Diagnostics, COUNT };
+Screen screen = Screen::Power;
+bool screenDirty = true;        // clear and repaint the current screen on the next UI pass
+
+// UI scheduler: values follow the latest sample, but a frame goes to the panel only when a field's
+// text moved past its hysteresis, and at most OLED_MAX_FPS times a second. With no button press
+// for OLED_DIM_AFTER_MS the panel dims, after OLED_OFF_AFTER_MS it is switched off and nothing is
+// drawn; the next press only wakes it. 0 disables either.
+static const uint8_t OLED_MAX_FPS = 10;
+static const uint32_t OLED_DIM_AFTER_MS = 60UL * 1000;
+static const uint32_t OLED_OFF_AFTER_MS = 5UL * 60 * 1000;
+enum class PanelState : uint8_t { On, Dimmed, Off };
+PanelState panelState = PanelState::On;
+unsigned long lastActivity = 0;
+unsigned long lastFrame = 0;
+bool framePending = false;      // drawn into the buffer, not yet handed to the panel
 
-WiFiClientSecure secureClient;
+// SoC trend screen: one column per SOC_TREND_INTERVAL (128 columns = 64 min). The chart draws
+// straight into the frame buffer, so the history is kept here and replayed onto it when shown.
+static const unsigned long SOC_TREND_INTERVAL = 30000;
+Adafruit_SSD1306_StripChart socTrend(display, 0, 16, OLED_WIDTH, 40);
+uint8_t socHistory[OLED_WIDTH];   // percent, oldest at socHistoryHead once full
+uint8_t socHistoryCount = 0;
+uint8_t socHistoryHead = 0;
+unsigned long lastSocTrend = 0;
+enum SocPageField : uint8_t { SOC_FIELD_SOC, SOC_FIELD_SIGMA };
+Dashboard socPage;
+
+// SoC dial: a 270-degree ring around the percentage. The ring's row spans are computed once; a
+// SoC change fills only the wedge between the old and the new value, so the partial refresh sends
+// just that segment.
+GFXArcGauge socGauge(&display, OLED_WIDTH / 2, 33, 30, 6);
+Dashboard socGaugePage;
+
+// Diagnostics screen, values refreshed once a second
+static const unsigned long DIAG_SCREEN_INTERVAL = 1000;
+enum DiagPageField : uint8_t { DIAG_RSSI, DIAG_HEAP, DIAG_UPTIME, DIAG_QUEUED, DIAG_DROPPED, DIAG_SAMPLES };
+Dashboard diagPage;
+unsigned long lastDiagScreen = 0;
+
+// NeoPixel SoC bar next to the OLED (see status_leds.h): STATUS_LED_COUNT - 1 bar pixels plus one
+// charge-state pixel, redrawn on a SoC bucket or state change, at most once per STATUS_LED_FRAME_MS.
+// -1 = not fitted; off in low-power mode.
+static const int STATUS_LED_PIN = -1; // e.g. 27
+static const uint16_t STATUS_LED_COUNT = 8;
+static const uint8_t STATUS_LED_BRIGHTNESS = 64;
+static const uint32_t STATUS_LED_FRAME_MS = 100;
+static const float STATUS_IDLE_mA = 20.0f; // |I| below this shows as idle
+StatusLeds statusLeds;
+
+WifiManager wifiManager;
+TlsSessionClient secureClient;   // resumes its last TLS session on reconnect
+WiFiClient plainClient;          // brokers with tls = false
+BrokerPool brokerPool;
 PubSubClient mqttClient(secureClient);
 
 unsigned long lastPublish = 0;
 const unsigned long PUBLISH_INTERVAL = 5000;
 
+// INA219 acquisition rate (sampler task, core 1)
+static const uint32_t SAMPLE_RATE_HZ = 100;
+// GPIO wired to a conversion-complete ALERT output; when set, the sampler
+// is interrupt-driven at the INA's conversion rate instead of SAMPLE_RATE_HZ.
+// -1 = not wired (the INA219 module on this board has no ALERT pin).
+static const int INA_ALERT_PIN = -1;
+// Adaptive rate (timer mode): SAMPLE_RATE_HZ while |I| or |dI/dt| is above
+// threshold, halving every ADAPTIVE_HOLD_ms of quiet down to the floor.
+static const bool ADAPTIVE_RATE = true;
+static const uint32_t ADAPTIVE_MIN_RATE_HZ = 5;
+static const float ADAPTIVE_CURRENT_mA = 500.0f;
+static const float ADAPTIVE_SLEW_mA_PER_S = 2000.0f;
+static const uint32_t ADAPTIVE_HOLD_ms = 2000;
+AdaptiveRate adaptiveRate;
+Sampler sampler;
+PowerSample lastSample = {};
+
+// What each PUBLISH_INTERVAL message carries (see aggregator.h)
+static const PublishMode PUBLISH_MODE = PublishMode::Aggregate;
+// Report by exception (report_filter.h): a window is published only if a channel moved beyond its
+// deadband since it was last reported, and then with just the channels that moved; all of them go
+// out at least every RBE_HEARTBEAT_MS. JSON reports carry "rbe": true (and "heartbeat": true when
+// complete) so consumers forward-fill what is left out. Deadbands: V, A, W, SoC %.
+static const bool REPORT_BY_EXCEPTION = true;
+static const float RBE_DEADBAND[ReportFilter::CHANNELS] = { 0.02f, 0.005f, 0.05f, 0.5f };
+static const uint32_t RBE_HEARTBEAT_MS = 60000;
+ReportFilter reportFilter;
+// Telemetry is built in its own buffers and published without being copied into the MQTT
+// buffer (MQTT_GATHER_MIN), which then only holds topics and inbound commands
+static const uint16_t TELEMETRY_BUFFER_SIZE = 1536; // room for RawBatch windows
+// OTA_MAX_CHUNK sets the inbound size: one firmware chunk with its header, topic and properties
+static const uint16_t OTA_MAX_CHUNK = 1024;
+static const uint16_t MQTT_BUFFER_SIZE = OTA_MAX_CHUNK + 256;
+// Streamed and large publishes reach the TLS client in writes of this size, one record each
+// (mbedTLS outgoing record size in the arduino-esp32 build)
+static const uint16_t MQTT_WRITE_BUFFER_SIZE = 4096;
+// Telemetry goes out at QoS 1 with up to MQTT_INFLIGHT_WINDOW messages awaiting PUBACK; one
+// unacknowledged after MQTT_RETRY_MS (or a reconnect) is resent. Replayed flash-queue pages are
+// deleted only once every message in them was acknowledged.
+static const uint8_t MQTT_INFLIGHT_WINDOW = 8;
+static const uint16_t MQTT_RETRY_MS = 10000;
+// Message memory (block_pool.h), reserved at boot instead of coming from the heap mbedTLS shares.
+// A QoS 1 message awaiting its PUBACK is kept in a small block when it fits (binary telemetry,
+// queued singles), else in a large one; diagnostics are formatted in a borrowed large block. The
+// large pool holds a full in-flight window of JSON windows plus MSG_LARGE_SPARE. When a pool runs
+// out the publish fails and the message goes to the flash queue, as it would offline. The MQTT
+// buffers are static arrays too.
+static const size_t MSG_TOPIC_MAX = 48;
+static_assert(MSG_TOPIC_MAX >= TopicLayout::TOPIC_MAX, "every expanded topic fits a message block");
+static const size_t MSG_SMALL_BLOCK = 192;
+static const size_t MSG_SMALL_BLOCKS = 16;
+static const size_t MSG_LARGE_BLOCK = TELEMETRY_BUFFER_SIZE + MSG_TOPIC_MAX;
+static const size_t MSG_LARGE_SPARE = 2;
+typedef BlockPool<MSG_SMALL_BLOCK, MSG_SMALL_BLOCKS> SmallBlocks;
+typedef BlockPool<MSG_LARGE_BLOCK, MQTT_INFLIGHT_WINDOW + MSG_LARGE_SPARE> LargeBlocks;
+SmallBlocks smallBlocks;
+LargeBlocks largeBlocks;
+uint8_t mqttBuffer[MQTT_BUFFER_SIZE];
+uint8_t mqttWriteBuffer[MQTT_WRITE_BUFFER_SIZE];
+
+static void* messageAlloc(size_t size) {
+  void* p = size <= SmallBlocks::blockSize() ? smallBlocks.alloc() : nullptr;
+  if (!p && size <= LargeBlocks::blockSize()) p = largeBlocks.alloc();
+  return p;
+}
+
+static void messageFree(void* p) {
+  if (smallBlocks.owns(p)) smallBlocks.release(p);
+  else largeBlocks.release(p);
+}
+// Broker connects run in the background (connectAsync); a failed one is retried after a jittered
+// delay that doubles from MQTT_BACKOFF_MIN_MS up to MQTT_BACKOFF_MAX_MS
+static const uint32_t MQTT_BACKOFF_MIN_MS = 1000;
+static const uint32_t MQTT_BACKOFF_MAX_MS = 60000;
+// cleanSession=false under the fixed MAC-based client ID: the broker keeps subscriptions and
+// QoS 1 state across reconnects, so a reconnect with sessionPresent skips the SUBSCRIBE
+static const bool MQTT_PERSISTENT_SESSION = true;
+static const uint32_t TLS_HANDSHAKE_TIMEOUT_MS = 10000;
+// Verify TLS brokers against the roots in ca_bundle.h (the broker's CA only). Full handshakes check the
+// chain, resumed sessions skip it; false = no verification (as WiFiClientSecure::setInsecure()).
+static const bool TLS_VERIFY = true;
+static const TelemetryEncoding TELEMETRY_ENCODING = PROFILE.encoding;
+TelemetryWindow window;
+
+// Uplink role from the profile (LinkRole in board_profile.h).
+// A node hops channels until the gateway (which follows its access point) acknowledges; with the
+// broadcast address nothing is acknowledged, so ESPNOW_CHANNEL must be the gateway's channel.
+static const LinkRole LINK_ROLE = PROFILE.link;
+static const bool USES_WIFI = LINK_ROLE == LinkRole::Mqtt || LINK_ROLE == LinkRole::EspNowGateway;
+static const uint8_t ESPNOW_GATEWAY_MAC[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };   // the gateway's STA MAC
+static const uint8_t ESPNOW_CHANNEL = 1;          // first channel a node tries
+static const uint8_t ESPNOW_SEND_ATTEMPTS = 3;    // per window, then it is dropped
+static const size_t ESPNOW_FORWARD_BATCH = 8;     // node messages published per network pass
+EspNowLink espNow;
+
+// LinkRole::SerialStream. 2 Mbaud needs a USB bridge that does it (CP2104, CH340; a CP2102 tops out
+// at 921600, enough for ~2.7 kHz). The timer runs at or above the INA219's conversion rate (12-bit bus
+// + shunt, ~1.06 ms): ticks without a new conversion push nothing, so every conversion is framed once.
+// Rates this high need the INA bus at 400 kHz or more (INA_BUS_CLOCKS).
+static const uint32_t SERIAL_STREAM_BAUD = 2000000;
+static const uint32_t SERIAL_STREAM_RATE_HZ = 1000;
+SerialStream serialStream;
+
+// BLE peripheral (ble_link.h), only with build_flags -DBLE_PERIPHERAL: a phone next to the pack gets
+// every sample as binary GATT notifications plus the standard Battery Level. It runs next to WiFi
+// in the other roles; buffered samples go out every BLE_BATCH_MS at most.
+#ifdef BLE_PERIPHERAL
+static const char* BLE_NAME = "BMS";
+static const uint32_t BLE_BATCH_MS = 100;
+BleLink bleLink;
+#else
+static_assert(LINK_ROLE != LinkRole::BleOnly, "LinkRole::BleOnly needs -DBLE_PERIPHERAL");
+#endif
+
+// Transient capture: EVENT_PRE_ms before and EVENT_POST_ms after a trigger,
+// shipped as one binary Event blob on PUB_TOPIC_EVENT. 0 disables a trigger.
+static const uint32_t EVENT_PRE_ms = 1000;
+static const uint32_t EVENT_POST_ms = 2000;
+static const float EVENT_CURRENT_mA = 1800.0f;        // inrush / short circuit (INA_PROFILE: 2 A)
+static const float EVENT_SLEW_mA_PER_S = 20000.0f;
+static const float EVENT_UNDERVOLTAGE_V = 0.0f;       // pack-specific, e.g. 3.0 V per Li-ion cell
+static const uint32_t EVENT_HOLDOFF_ms = 10000;
+// The ring (and the encoded blob) are the largest buffers in the firmware, so they are placed as
+// MemRegion::Bulk: EventCapture::CAPACITY samples in internal SRAM, EVENT_CAPACITY_PSRAM when the
+// board has PSRAM, which keeps the whole window at up to ~800 Hz (ALERT-driven sampling)
+static const size_t EVENT_CAPACITY_PSRAM = 2400;
+static const size_t EVENT_BUFFER_PSRAM =
+    EVENT_HEADER_SIZE + SAMPLE_RECORD_SIZE + EVENT_CAPACITY_PSRAM * DELTA_RECORD_MAX;
+static_assert(EVENT_BUFFER_PSRAM <= UINT16_MAX, "EventMessage::len is 16-bit");
+EventCapture eventCapture;
+
+// Hardware protection (protection.h): checked in the sampler task right after every INA219 read,
+// opening PROTECTION_CUTOFF_PIN (a MOSFET gate or relay driver, at PROTECTION_CLOSED_LEVEL while
+// the path is closed) within the sampling period. -1 evaluates and reports without a pin. Voltage
+// limits are pack-specific and off here. Latched trips wait for "PROTECT_RESET" on SUB_TOPIC;
+// "PROTECT_TRIP" opens the cutoff by hand. The supervisor opens it when sampling stalls.
+static const int PROTECTION_CUTOFF_PIN = -1;
+static const uint8_t PROTECTION_CLOSED_LEVEL = HIGH;
+static const ProtectionLimits PROTECTION_LIMITS = {
+  2500000,   // overcurrent_uA (INA_PROFILE: 2 A; ADC overflow also trips)
+  0,         // undervoltage_uV, e.g. 3000000 per Li-ion cell
+  0,         // overvoltage_uV, e.g. 4250000 per Li-ion cell
+  200000,    // currentHysteresis_uA
+  100000,    // voltageHysteresis_uV
+  3,         // voltageSamples
+  5000,      // release_ms (unlatched)
+  true,      // latch
+  2000,      // staleTimeout_ms
+};
+Protection protection;
+
+// Store-and-forward: telemetry that cannot be published goes to flash and is
+// replayed after reconnect, QUEUE_DRAIN_BATCH messages per QUEUE_DRAIN_INTERVAL
+FlashQueue flashQueue;
+uint16_t queueInflight[MQTT_INFLIGHT_WINDOW] = {}; // packet ids of replayed messages awaiting PUBACK
+static const size_t QUEUE_DRAIN_BATCH = 8;
+static const unsigned long QUEUE_DRAIN_INTERVAL = 250;
+unsigned long lastQueueDrain = 0;
+
+// Local live view (live_server.h): http://<device>/ serves web/live.html (gzipped into
+// live_page.h by web/embed_page.py) and /ws streams calibrated samples, up to the sampler rate per
+// client, for someone next to the pack. Frames go out at most every LIVE_FRAME_MS. The server
+// task sits on PRO_CPU below the network task; a slow client only loses live samples.
+static const bool LIVE_SERVER = true;
+static const uint16_t LIVE_PORT = 80;
+static const uint8_t LIVE_MAX_CLIENTS = 3;
+static const uint32_t LIVE_FRAME_MS = 50;
+static const UBaseType_t LIVE_PRIORITY = 2;
+LiveServer liveServer;
+
+// Task layout. Network work (TLS, MQTT, WiFi, flash queue) runs on PRO_CPU; acquisition,
+// estimation and the display run on APP_CPU, so a slow TLS write no longer delays anything that
+// touches a sample. Budgets are per activation; -DLOOP_TRACE measures the stages against them.
+//   task        core  prio  runs                budget
+//   sampler     APP   5     timer / ALERT edge  read starts < 1 ms after its tick; one burst ~2 ms
+//   estimation  APP   4     every 10 ms         drain + estimators < 2 ms; a window's payloads < 5 ms
+//   cells       APP   3     per ADC DMA frame   one add per conversion, < 0.1 ms per frame (cell_monitor.h)
+//   ui          APP   2     50 ms or a button   page render + frame hand-over < 5 ms, <= OLED_MAX_FPS
+//   network     PRO   3     on data / 10 ms     none: TLS handshakes and socket writes may block
+//   ssd1306, leds, brokers  PRO, priority 1 (see their modules)
+// Hand-over: sampler -> estimation through the sampler's SPSC ring (Sampler::RING_SIZE, 2.56 s at
+// 100 Hz); estimation -> network through outbox, which blocks estimation when full (telemetry must
+// not be lost) for at most OUTBOX_BLOCK_MS, well inside the ring's slack, then drops and counts the
+// message; estimation -> ui through uiState, which keeps only the newest value (drop-oldest).
+// In low-power mode loop() runs all three passes in turn between sleeps instead.
+static const UBaseType_t ESTIMATION_PRIORITY = 4;
+static const uint32_t ESTIMATION_PERIOD_MS = 10;
+static const size_t SAMPLE_BATCH = 16;   // samples taken off the sampler ring at a time
+static const UBaseType_t CELL_PRIORITY = 3;
+static const UBaseType_t UI_PRIORITY = 2;
+static const uint32_t UI_PERIOD_MS = 50;   // a look at the data; frames are capped separately
+static const UBaseType_t NETWORK_PRIORITY = 3;
+static const uint32_t NETWORK_IDLE_MS = 10;
+static const uint32_t OUTBOX_BLOCK_MS = 2000;
+
+// Supervisor (supervisor.h): every pinned task beats once per pass. A task silent for its timeout
+// climbs one step per further timeout: recover, restart its subsystem, then checkpoint the
+// coulomb state and reboot. Network: a write stuck on a dead peer is bounded by the TLS timeout,
+// but a plain socket or a DNS lookup is not; recover shuts the sockets down, restart drops the
+// WiFi association (WifiManager reconnects on the event). The TWDT, above every ladder, catches a
+// wedged supervisor. Only in task mode: low-power passes sleep between beats.
+static const UBaseType_t SUPERVISOR_PRIORITY = 6;
+static const uint32_t SUPERVISOR_PERIOD_MS = 1000;
+static const uint32_t WATCHDOG_S = 60;
+static const uint32_t ESTIMATION_TIMEOUT_MS = 5000;   // OUTBOX_BLOCK_MS is a legitimate wait
+static const uint32_t UI_TIMEOUT_MS = 5000;
+static const uint32_t NETWORK_TIMEOUT_MS = 15000;     // > TLS_HANDSHAKE_TIMEOUT_MS (write timeout)
+Supervisor supervisor;
+int8_t estimationWatch = -1;
+int8_t uiWatch = -1;
+int8_t networkWatch = -1;
+
+// One telemetry message for the network task: JSON or binary, flash-queued if it cannot go out
+struct OutboundMessage {
+  uint8_t topic;   // QueuedTopic
+  bool store;      // false: demo values, dropped when offline
+  uint16_t len;
+  uint8_t data[TELEMETRY_BUFFER_SIZE];
+};
+BlockingQueue<OutboundMessage, 4> outbox;
+// A completed transient capture, encoded into eventBuffer; the recorder re-arms as soon as it is
+// handed over. One slot, so the buffer is never written while the network task still ships it.
+struct EventMessage {
+  uint8_t cause;
+  uint16_t samples;
+  uint16_t len;
+};
+BlockingQueue<EventMessage, 1> eventOutbox;
+uint8_t* eventBuffer = nullptr;
+size_t eventBufferSize = 0;
+
+// What the display shows, refreshed every estimation pass; the page redraws when window moves on
+struct UiState {
+  float bus_V;
+  float current_A;
+  float power_W;
+  float soc_percent;
+  float soh_percent;
+  float soc_sigma_percent;
+  uint16_t rate_Hz;
+  uint32_t outboxTimeouts;
+  uint32_t window;
+};
+LatestValue<UiState> uiState;
+// The health document's estimation-owned sections (energy totals, anomaly baselines, report filter,
+// live server, cell ADC), rendered by the estimation pass when the network task asks for them
+static const size_t HEALTH_SNAPSHOT_SIZE = 1024;
+struct HealthSnapshot {
+  uint16_t len;   // 0: did not fit
+  char json[HEALTH_SNAPSHOT_SIZE];
+};
+LatestValue<HealthSnapshot> healthSnapshot;
+std::atomic<bool> healthRequested{false};
+// Offline queue depth for the diagnostics screen, copied by the network task that owns flashQueue
+std::atomic<uint16_t> queuedPages{0};
+uint32_t publishedWindows = 0;
+bool tasksRunning = false;
+static void startTasks();
+static void startWindow();
+
+// Operating mode (see low_power.h). LowPower reads the INA219 in triggered
+// mode at LOW_POWER_SAMPLE_RATE_HZ, light-sleeps in between, queues one
+// window every LOW_POWER_WINDOW_MS and powers WiFi up only every
+// UPLINK_EVERY_WINDOWS windows to flush the queue.
+static const PowerMode POWER_MODE = PowerMode::Continuous;
+static const uint32_t LOW_POWER_SAMPLE_RATE_HZ = 1;
+static const unsigned long LOW_POWER_WINDOW_MS = 60000;
+static const uint16_t UPLINK_EVERY_WINDOWS = 10;
+static const unsigned long UPLINK_TIMEOUT_MS = 30000;
+bool lowPower = false; // POWER_MODE is LowPower and the INA219 is present
+unsigned long publishInterval = PUBLISH_INTERVAL;
+DutyCycle dutyCycle;
+PowerProfile powerProfile; // average current per phase, reported with telemetry
+
 // Battery / SoC configuration
 static const float BATTERY_CAPACITY_mAh = 4200.0f; // user provided
 static const float INITIAL_SOC_PERCENT = 100.0f;  // change if known
-// Optional: if you know a measured full capacity, set MEASURED_CAPACITY_mAh > 0 to compute SoH
+// SoH is the online capacity estimate (soh_estimator.h) against BATTERY_CAPACITY_mAh. A measured
+// full capacity (MEASURED_CAPACITY_mAh > 0) only seeds it until rest-to-rest segments refine it.
 // Measured capacity converted from 3000 mWh @ 3.7V -> ~810.81 mAh
 static const float MEASURED_CAPACITY_mAh = 810.81f;
 
-// Coulomb counting state
-float consumed_mAh = 0.0f;
-float remaining_mAh = 0.0f;
+// EKF SoC (soc_ekf.h): coulomb counting corrected by the cell's open-circuit voltage through a
+// 1-RC model. The pack voltage is split evenly over BATTERY_CELLS_SERIES cells; readings the model
+// cannot explain (wrong cell count, no battery) are gated out and it falls back to coulomb counting.
+static const bool SOC_FROM_EKF = true;          // false: publish the plain coulomb count
+static const Chemistry BATTERY_CHEMISTRY = Chemistry::LiIon;   // OCV curve (ocv_table.h)
+static const uint8_t BATTERY_CELLS_SERIES = 1;
+static const float CELL_R0_OHM = 0.05f;         // series resistance
+static const float CELL_R1_OHM = 0.02f;         // polarization resistance
+static const float CELL_TAU1_S = 30.0f;         // polarization time constant R1 * C1
+
+// Coulomb counting state (integrates every sampler reading)
+CoulombCounter coulomb;
+SocEkf socEkf;
+SohEstimator sohEstimator;
 float soc_percent = INITIAL_SOC_PERCENT;
 float soh_percent = 100.0f;
-unsigned long lastIntegrationMillis = 0;
+// Survives reboots: RTC copy every publish, NVS on 0.5 mAh moved or 10 min
+SocCheckpoint socCheckpoint;
+// Charge / discharge Ah and Wh, closed hours and days go out on PUB_TOPIC_ENERGY (flash-queued
+// like windows). RTC copy every publish, NVS at every hour boundary.
+EnergyMeter energyMeter;
 
-void callback(char* topic, byte* payload, unsigned int length) {
-  Serial.print("Message arrived [");
-  Serial.print(topic);
-  Serial.print("] ");
-  for (unsigned int i = 0; i < length; i++) {
-    Serial.print((char)payload[i]);
-  }
-  Serial.println();
-  if (length == 6 && strncmp((char*)payload, "TOGGLE", 6) == 0) {
+// Load profile (load_profile.h): time spent in each current x terminal voltage cell, one histogram
+// per LOAD_PROFILE_WINDOW_MS on PUB_TOPIC_LOAD (flash-queued like windows), so the server reads the
+// load shape instead of re-binning raw history. 0 turns it off. Current: the INA_PROFILE range,
+// charge negative; voltage per cell, scaled by BATTERY_CELLS_SERIES.
+static const uint32_t LOAD_PROFILE_WINDOW_MS = 900000;
+static const int32_t LOAD_PROFILE_CURRENT_uA[2] = { -2000000, 2000000 };
+static const int32_t LOAD_PROFILE_CELL_uV[2] = { 3000000, 4400000 };
+LoadProfile loadProfile;
+unsigned long lastLoadProfile = 0;
+
+// Anomaly flags (anomaly_detector.h): current or voltage far from its EWMA baseline, and SoC steps
+// the counted charge does not explain. Raised and cleared at once on PUB_TOPIC_ALERT (QoS 1,
+// flash-queued while offline); the protection limits above stay the hard cutoff.
+static const bool ANOMALY_DETECTION = true;
+static const AnomalyLimits ANOMALY_LIMITS = {
+  6.0f,      // z
+  5,         // holdSamples
+  3000,      // baselineSamples (30 s at SAMPLE_RATE_HZ)
+  20000,     // currentFloor_uA
+  10000,     // voltageFloor_uV
+  5.0f,      // socJump_percent per window
+};
+AnomalyDetector anomaly;
+
+static float estimatedSoc() { return SOC_FROM_EKF ? socEkf.soc_percent() : coulomb.soc_percent(); }
+
+// Remote configuration (remote_config.h). PUBLISH_INTERVAL, SAMPLE_RATE_HZ, PUBLISH_MODE,
+// TELEMETRY_ENCODING and BATTERY_CAPACITY_mAh are the defaults; a document on SUB_TOPIC_CONFIG
+// (JSON naming any of them, or the binary record) is validated by the network task, saved to NVS
+// and handed to the estimation task, which applies all of it at once between two windows and
+// starts a fresh window. The result and the active config go out on PUB_TOPIC_CONFIG (retained).
+// A saved config overrides the defaults at boot. Low-power mode keeps its own window and rate.
+RuntimeConfig config = { PUBLISH_INTERVAL, SAMPLE_RATE_HZ, PUBLISH_MODE, TELEMETRY_ENCODING,
+                         BATTERY_CAPACITY_mAh, 0, 0 };   // active; estimation task only after boot
+RuntimeConfig acceptedConfig;       // network task: the base the next document patches
+LatestValue<RuntimeConfig> pendingConfig;
+ConfigStore configStore;
+ConfigError configResult = ConfigError::None;
+bool configReplyDue = false;        // publish the state from networkPass(), not the MQTT callback
+
+// Firmware updates (ota_update.h, sent by server/ota_push.py). Chunks are written to the inactive
+// partition by the network task as they arrive; once the image is verified and bootable, and its
+// status has gone out, the device restarts into it after OTA_RESTART_DELAY_MS. The new firmware
+// cancels the bootloader rollback on its first broker connect.
+static const uint32_t OTA_RESTART_DELAY_MS = 1000;
+OtaUpdate ota;
+unsigned long otaReadyAt = 0;
+
+// Cutoff commands from SUB_TOPIC (network task), carried out by the next estimation pass
+enum class EstimationCommand : uint8_t { ProtectReset, ProtectTrip };
+SpscRing<EstimationCommand, 4> estimationCommands;
+
+// Set by the SCAN_I2C command; the network pass runs the diagnostic scan, probe by probe under the bus locks
+bool i2cScanRequested = false;
+// Set by the I2C_STATS command; loop() prints the BusIO counters
+bool i2cStatsRequested = false;
+// Set by the LOOP_STATS command; loop() prints the stage timings
+bool loopStatsRequested = false;
+
+// Inbound messages go through topicRouter (handlers registered in setup()).
+// Serial echo: 0 none, 1 topic and length, 2 also the payload
+static const uint8_t MQTT_ECHO_LEVEL = 1;
+TopicRouter topicRouter;
+
+// Payload commands on SUB_TOPIC
+static void onCommand(const char* topic, const uint8_t* payload, unsigned int length) {
+  if (length == 6 && strncmp((const char*)payload, "TOGGLE", 6) == 0) {
     digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+  } else if (length == 13 && strncmp((const char*)payload, "PROTECT_RESET", 13) == 0) {
+    if (!estimationCommands.push(EstimationCommand::ProtectReset)) LOG_WARN("Command dropped: queue full");
+  } else if (length == 12 && strncmp((const char*)payload, "PROTECT_TRIP", 12) == 0) {
+    if (!estimationCommands.push(EstimationCommand::ProtectTrip)) LOG_WARN("Command dropped: queue full");
+  } else if (length == 8 && strncmp((const char*)payload, "SCAN_I2C", 8) == 0) {
+    i2cScanRequested = true;
+  } else if (length == 9 && strncmp((const char*)payload, "I2C_STATS", 9) == 0) {
+    i2cStatsRequested = true;
+  } else if (length == 10 && strncmp((const char*)payload, "LOOP_STATS", 10) == 0) {
+    loopStatsRequested = true;
+  }
+}
+
+// Config documents on SUB_TOPIC_CONFIG (network task)
+static void onConfig(const char* topic, const uint8_t* payload, unsigned int length) {
+  RuntimeConfig next;
+  configResult = parseConfig(payload, length, acceptedConfig, next);
+  configReplyDue = true;
+  if (configResult != ConfigError::None) {
+    LOG_WARN("Config rejected: %s", configErrorName(configResult));
+    return;
   }
+  if (!configStore.save(next)) LOG_ERROR("Config: NVS write failed, applied until reboot");
+  acceptedConfig = next;
+  pendingConfig.write(next);
 }
 
-void connectWiFi() {
-  Serial.println("Connecting to WiFi networks...");
-  WiFi.mode(WIFI_STA);
-  size_t credsCount = sizeof(WIFI_CREDENTIALS) / sizeof(WIFI_CREDENTIALS[0]);
-  for (size_t i = 0; i < credsCount; ++i) {
-    const char* ssid = WIFI_CREDENTIALS[i].ssid;
-    const char* pass = WIFI_CREDENTIALS[i].password;
-    Serial.printf("Trying SSID: %s\n", ssid);
-    WiFi.disconnect(true);
-    delay(100);
-    WiFi.begin(ssid, pass);
-    unsigned long start = millis();
-    const unsigned long timeout = 15000; // 15 seconds per network
-    while (WiFi.status() != WL_CONNECTED && (millis() - start) < timeout) {
-      delay(500);
-      Serial.print('.');
+// Reports the accepted config and how the last document fared.
+static void publishConfigState() {
+  StaticJsonWriter<320> state;
+  state.beginObject()
+      .field("result", configErrorName(configResult))
+      .field("seq", configStore.seq())
+      .beginObject("config");
+  writeConfigJson(state, acceptedConfig);
+  state.endObject().endObject();
+  if (state.ok()) configReplyDue = !mqttClient.publish(PUB_TOPIC_CONFIG, state.c_str(), true);
+}
+
+// Firmware update messages (network task)
+static void onOtaBegin(const char* topic, const uint8_t* payload, unsigned int length) {
+  ota.onManifest(payload, length);
+}
+
+static void onOtaChunk(const char* topic, const uint8_t* payload, unsigned int length) {
+  ota.onChunk(payload, length);
+}
+
+static void onOtaAbort(const char* topic, const uint8_t* payload, unsigned int length) {
+  ota.abort();
+  ota.requestStatus();
+}
+
+static void publishOtaStatus(unsigned long now) {
+  StaticJsonWriter<192> status;
+  status.beginObject();
+  ota.writeStatus(status);
+  status.endObject();
+  if (status.ok() && mqttClient.publish(PUB_TOPIC_OTA, status.c_str())) ota.statusSent(now);
+}
+
+void callback(char* topic, byte* payload, unsigned int length) {
+  uint8_t handled = topicRouter.dispatch(topic, payload, length);
+  if (MQTT_ECHO_LEVEL >= 1) LOG_INFO("Message arrived [%s] %u bytes%s", topic, length, handled ? "" : ", unhandled");
+  if (MQTT_ECHO_LEVEL >= 2 && LOG_ENABLED(LOG_LEVEL_INFO)) logger.write(LOG_LEVEL_INFO, "  ", payload, length);
+}
+
+// Inbound messages too large for mqttBuffer arrive through the chunk callbacks. Config documents
+// and OTA messages have fixed upper sizes well inside the buffer, so an oversized one is malformed:
+// it is skipped unread but still answered, a config with result "too_large", an OTA chunk with the
+// same request again and a manifest with a failed status. Every one is named and counted.
+uint32_t inboundOversize = 0;
+
+static boolean onOversizeBegin(const char* topic, uint32_t length) {
+  inboundOversize++;
+  LOG_WARN("Message on %s too large (%u bytes), dropped", topic, (unsigned)length);
+  if (strcmp(topic, SUB_TOPIC_CONFIG) == 0) {
+    configResult = ConfigError::TooLarge;
+    configReplyDue = true;
+  } else if (strcmp(topic, SUB_TOPIC_OTA_BEGIN) == 0) {
+    ota.onOversize(true);
+  } else if (strcmp(topic, SUB_TOPIC_OTA_CHUNK) == 0) {
+    ota.onOversize(false);
+  }
+  return false;
+}
+
+static void onOversizeChunk(const uint8_t* data, unsigned int length) {}
+
+static const char* queuedTopicName(uint8_t topic) {
+  switch (topic) {
+    case QUEUE_TOPIC_BIN: return PUB_TOPIC_BIN;
+    case QUEUE_TOPIC_ENERGY: return PUB_TOPIC_ENERGY;
+    case QUEUE_TOPIC_RAW: return PUB_TOPIC_RAW;
+    case QUEUE_TOPIC_LOAD: return PUB_TOPIC_LOAD;
+    case QUEUE_TOPIC_ALERT: return PUB_TOPIC_ALERT;
+    default: return PUB_TOPIC;
+  }
+}
+
+// Replays one queued message at QoS 1; its page stays on flash until onPuback() confirms it.
+static bool sendQueued(uint8_t topic, const uint8_t* data, size_t len) {
+  uint16_t* slot = nullptr;
+  for (uint16_t& id : queueInflight) {
+    if (!id) slot = &id;
+  }
+  if (!slot) return false;
+  *slot = mqttClient.publishQos1(queuedTopicName(topic), data, len);
+  return *slot != 0;
+}
+
+static void onPuback(uint16_t msgId) {
+  for (uint16_t& id : queueInflight) {
+    if (id == msgId) {
+      id = 0;
+      flashQueue.acknowledge();
+    }
+  }
+}
+
+// Publishes now if possible, otherwise queues the message in flash.
+static bool publishOrQueue(uint8_t topic, const uint8_t* data, size_t len) {
+  TraceScope trace(TraceStage::Publish);
+  if (mqttClient.publishQos1(queuedTopicName(topic), data, len)) return true;
+  flashQueue.push(topic, data, len);
+  return false;
+}
+
+// Estimation side: encodes a completed event for the network task and re-arms the recorder.
+// While the previous one has not gone out the capture stays frozen.
+static void handOverEvent() {
+  EventMessage* m = eventOutbox.acquire(0);
+  if (!m) return;
+  const PowerSample* samples = eventCapture.samples();
+  uint64_t t0_us = ClockSync::extend(samples[0].t_us);
+  size_t len = encodeEvent(eventBuffer, eventBufferSize, samples, eventCapture.count(), eventCapture.triggerIndex(),
+                           eventCapture.cause(), (uint32_t)(t0_us / 1000), clockSync.utc_ms(t0_us), soc_percent,
+                           soh_percent);
+  if (len) {
+    m->cause = eventCapture.cause();
+    m->samples = eventCapture.count();
+    m->len = len;
+    eventOutbox.commit();
+  } else {
+    LOG_ERROR("Event encode failed");
+  }
+  eventCapture.release();
+}
+
+// Network side: streams the event straight to the socket, bypassing the MQTT buffer.
+static void shipEvent() {
+  EventMessage* m = eventOutbox.front();
+  if (!m) return;
+  if (mqttClient.beginPublish(PUB_TOPIC_EVENT, m->len, false) && mqttClient.write(eventBuffer, m->len) == m->len &&
+      mqttClient.endPublish()) {
+    LOG_INFO("Published event 0x%02X: %u samples, %u bytes", m->cause, (unsigned)m->samples, (unsigned)m->len);
+  } else {
+    LOG_WARN("Event publish failed");
+    return;   // keep it for the next pass
+  }
+  eventOutbox.release();
+}
+
+// Network side: reports cutoff trips and releases. The newest one is retained, so it doubles as
+// the cutoff's current state; one that cannot be published yet waits for the next pass.
+static void shipProtection() {
+  static Protection::Event pending;
+  static bool havePending = false;
+  while (havePending || protection.takeEvent(pending)) {
+    if (!havePending) {
+      havePending = true;
+      LOG_WARN("Protection %s: cause 0x%02X, %.3f A, %.3f V, %lu us", pending.cause ? "trip" : "release",
+               pending.cause, pending.current_uA * 1e-6f, pending.bus_uV * 1e-6f, (unsigned long)pending.latency_us);
+    }
+    if (LINK_ROLE == LinkRole::Mqtt || LINK_ROLE == LinkRole::EspNowGateway) {
+      if (!mqttClient.connected()) return;
+      char buf[224];
+      JsonWriter event(buf, sizeof(buf));
+      uint64_t t_us = ClockSync::extend(pending.t_us);
+      event.beginObject().field("uptime_ms", t_us / 1000);
+      if (uint64_t ts = clockSync.utc_ms(t_us)) event.field("ts", ts);
+      event.field("state", protection.tripped() ? "open" : "closed")
+          .field("event", pending.cause ? "trip" : "release");
+      Protection::writeCauses(event, "cause", pending.cause);
+      event.field("current_A", pending.current_uA * 1e-6f, 3)
+          .field("bus_V", pending.bus_uV * 1e-6f, 3)
+          .field("latency_us", pending.latency_us)
+          .endObject();
+      if (event.ok() && !mqttClient.publish(PUB_TOPIC_PROTECTION, event.c_str(), true)) return;
+    }
+    havePending = false;
+  }
+}
+
+// Network side: anomaly alerts as they come, at QoS 1 or into the flash queue.
+static void shipAlerts() {
+  AnomalyDetector::Alert a;
+  while (anomaly.takeAlert(a)) {
+    bool soc = a.kind == AnomalyKind::SocJump;
+    LOG_WARN("Anomaly %s %s: %.3f against %.3f", AnomalyDetector::kindName(a.kind), a.raised ? "raised" : "cleared",
+             a.value, a.baseline);
+    if (!USES_WIFI) continue;
+    char buf[224];
+    JsonWriter alert(buf, sizeof(buf));
+    uint64_t t_us = ClockSync::extend(a.t_us);
+    alert.beginObject().field("uptime_ms", t_us / 1000);
+    if (uint64_t ts = clockSync.utc_ms(t_us)) alert.field("ts", ts);
+    alert.field("kind", AnomalyDetector::kindName(a.kind)).field("state", a.raised ? "raised" : "cleared");
+    if (soc) {
+      alert.field("soc_step_percent", a.value, 2).field("counted_percent", a.baseline, 2);
+    } else {
+      alert.field("value", a.value, 3).field("baseline", a.baseline, 3).field("z", a.z, 1);
+    }
+    alert.field("soc_percent", soc_percent, 2).endObject();
+    if (alert.ok()) publishOrQueue(QUEUE_TOPIC_ALERT, (const uint8_t*)buf, alert.length());
+  }
+}
+
+// Estimation side: the load histogram once its window is over. Without an outbox slot it keeps
+// accumulating and goes out with the next pass.
+static void queueLoadProfile(unsigned long now, TickType_t outboxWait) {
+  if (!LOAD_PROFILE_WINDOW_MS || now - lastLoadProfile < LOAD_PROFILE_WINDOW_MS) return;
+  if (!loadProfile.samples()) {
+    lastLoadProfile = now;
+    return;
+  }
+  OutboundMessage* m = outbox.acquire(outboxWait);
+  if (!m) return;
+  lastLoadProfile = now;
+  JsonWriter hist((char*)m->data, sizeof(m->data));
+  uint64_t mono_us = ClockSync::monotonic_us();
+  uint64_t first_us = ClockSync::extend(loadProfile.start_us(), mono_us);
+  hist.beginObject().field("uptime_ms", first_us / 1000);
+  if (uint64_t ts = clockSync.utc_ms(first_us)) hist.field("ts", ts);
+  loadProfile.writeJson(hist);
+  hist.endObject();
+  loadProfile.reset();
+  if (!hist.ok()) {
+    LOG_ERROR("Load profile too large");
+    return;   // slot stays free for the next acquire()
+  }
+  m->topic = QUEUE_TOPIC_LOAD;
+  m->store = true;
+  m->len = hist.length();
+  outbox.commit();
+}
+
+// Estimation side: closed energy buckets for the network task, oldest first.
+static void queueEnergySummaries(TickType_t outboxWait) {
+  while (energyMeter.unsent()) {
+    OutboundMessage* m = outbox.acquire(outboxWait);
+    if (!m) return;
+    JsonWriter summary((char*)m->data, sizeof(m->data));
+    if (!energyMeter.writeSummary(summary)) return;   // slot stays free for the next acquire()
+    m->topic = QUEUE_TOPIC_ENERGY;
+    m->store = true;
+    m->len = summary.length();
+    outbox.commit();
+    energyMeter.markSent();
+  }
+}
+
+// Network side: publishes (or flash-queues) everything estimation produced.
+static void drainOutbox() {
+  while (OutboundMessage* m = outbox.front()) {
+    bool ok = m->store ? publishOrQueue(m->topic, m->data, m->len)
+                       : mqttClient.publish(queuedTopicName(m->topic), m->data, m->len);
+    if (m->topic == QUEUE_TOPIC_BIN) {
+      if (ok) LOG_INFO("Published %u-byte binary sample", (unsigned)m->len);
+      else LOG_WARN("Binary publish failed, queued");
+    } else if (ok) {
+      const char* what = m->topic == QUEUE_TOPIC_ENERGY ? "Published energy: "
+                         : m->topic == QUEUE_TOPIC_LOAD   ? "Published load profile: "
+                         : m->store                       ? "Published INA219: "
+                                                          : "Published: ";
+      if (LOG_ENABLED(LOG_LEVEL_INFO)) logger.write(LOG_LEVEL_INFO, what, m->data, m->len);
+    } else {
+      LOG_WARN(m->store ? "Publish failed, queued" : "Publish failed");
+    }
+    outbox.release();
+  }
+}
+
+// ESP-NOW node, network side: the outbox goes to the gateway instead, one message in flight.
+// JSON windows (and events) do not fit the link and are not produced in this role.
+static void drainToGateway() {
+  static uint8_t attempts = 0;
+  while (OutboundMessage* m = outbox.front()) {
+    EspNowLink::SendResult result = espNow.sendResult();
+    if (result == EspNowLink::SendResult::Pending) return;
+    if (result == EspNowLink::SendResult::Delivered || m->topic != QUEUE_TOPIC_BIN ||
+        (result == EspNowLink::SendResult::Failed && attempts >= ESPNOW_SEND_ATTEMPTS)) {
+      if (result == EspNowLink::SendResult::Failed) {
+        LOG_WARN("ESP-NOW: window dropped (ch %u)", espNow.channel());
+      }
+      attempts = 0;
+      outbox.release();
+      continue;
     }
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("\nWiFi connected");
-      Serial.print("IP: ");
-      Serial.println(WiFi.localIP());
-      return;
+    if (!espNow.send(m->data, m->len)) {
+      LOG_WARN("ESP-NOW: %u-byte window does not fit, dropped", (unsigned)m->len);
+      outbox.release();
+      continue;
     }
-    Serial.println();
-    Serial.printf("Failed to connect to %s\n", ssid);
-  }
-  Serial.println("Could not connect to any configured WiFi networks; will retry later.");
-}
-
-bool mqttConnect() {
-  if (mqttClient.connected()) return true;
-  Serial.print("Connecting to MQTT...");
-  String clientId = "ESP32-" + String((uint32_t)ESP.getEfuseMac());
-  secureClient.setInsecure(); // replace with CA verification in production
-  mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
-  mqttClient.setCallback(callback);
-  if (mqttClient.connect(clientId.c_str(), MQTT_USER, MQTT_PASSWORD)) {
-    Serial.println("connected");
-    mqttClient.subscribe(SUB_TOPIC);
-    return true;
+    attempts++;
+    return;
+  }
+}
+
+// ESP-NOW gateway: republishes what the nodes sent, ESPNOW_FORWARD_BATCH per pass (the write
+// buffer combines them into few TLS records). A node's slot is freed only once published.
+static void forwardNodes() {
+  EspNowLink::Message m;
+  for (size_t k = 0; k < ESPNOW_FORWARD_BATCH && espNow.receive(m); ++k) {
+    char id[TopicLayout::DEVICE_ID_MAX];
+    char topic[MSG_TOPIC_MAX];
+    TopicLayout::deviceIdFromMac(m.mac, id, sizeof(id));
+    if (topics.format(topic, sizeof(topic), id, "raw/bin") && !mqttClient.publish(topic, m.data, m.len)) {
+      return;   // kept for the next pass
+    }
+    espNow.release();
+  }
+}
+
+// Starts a background connect when none is running and the backoff has passed; never blocks.
+// mqttPoll() reports the outcome.
+void mqttConnect() {
+  static char clientId[24] = "";   // must outlive the attempt
+  if (mqttClient.connected() || mqttClient.connecting()) return;
+  if (!clientId[0]) {
+    strcpy(clientId, "ESP32-");
+    formatUInt(clientId + 6, sizeof(clientId) - 6, (uint32_t)ESP.getEfuseMac());
+    if (TLS_VERIFY) {
+      secureClient.setCABundle(LETS_ENCRYPT_ROOTS, sizeof(LETS_ENCRYPT_ROOTS) / sizeof(LETS_ENCRYPT_ROOTS[0]));
+    } else {
+      secureClient.setInsecure();
+    }
+    secureClient.setHandshakeTimeout(TLS_HANDSHAKE_TIMEOUT_MS);
+    mqttClient.setCallback(callback);
+    mqttClient.setChunkCallbacks(onOversizeBegin, onOversizeChunk, nullptr);
+    mqttClient.setBuffer(mqttBuffer, sizeof(mqttBuffer));
+    mqttClient.setWriteBuffer(mqttWriteBuffer, sizeof(mqttWriteBuffer));
+    mqttClient.setAllocator(messageAlloc, messageFree);
+    mqttClient.setPubackCallback(onPuback);
+    mqttClient.setInflightWindow(MQTT_INFLIGHT_WINDOW, MQTT_RETRY_MS);
+    mqttClient.setBackoff(MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS);
+#if MQTT_VERSION == MQTT_VERSION_5
+    // Telemetry topics go out as 2-byte aliases after their first message; the schema version
+    // rides along as a user property
+    static char schema[4];
+    formatUInt(schema, sizeof(schema), TELEMETRY_SCHEMA_VERSION);
+    mqttClient.setUserProperty("schema", schema);
+#endif
+  }
+  const BrokerConfig& broker = brokerPool.config(brokerPool.current());
+  mqttClient.setClient(broker.tls ? (Client&)secureClient : (Client&)plainClient);
+  mqttClient.setServer(broker.host, broker.port);
+  if (mqttClient.connectAsync(clientId, broker.user, broker.password, nullptr, 0, false, nullptr,
+                              !MQTT_PERSISTENT_SESSION)) {
+    LOG_INFO("Connecting to MQTT broker %s...", broker.host);
+  }
+}
+
+// Drives the client and logs connect results
+void mqttPoll() {
+  static bool wasConnecting = false;
+  mqttConnect();
+  mqttClient.loop();
+  bool connecting = mqttClient.connecting();
+  if (wasConnecting && !connecting) {
+    if (mqttClient.connected()) {
+      brokerPool.connected();
+      OtaUpdate::confirmRunningImage();
+      ota.requestStatus();   // an interrupted download asks for its next chunk again
+      LOG_INFO("MQTT connected (TLS %lu ms%s, %s%s, session %s)", (unsigned long)secureClient.handshakeMs(),
+               secureClient.sessionOffered() ? ", resume offered" : "", secureClient.ciphersuite(),
+               secureClient.verifying() ? ", verified" : "", mqttClient.sessionPresent() ? "kept" : "new");
+      if (!mqttClient.sessionPresent()) {
+        mqttClient.subscribe(SUB_TOPICS, nullptr, sizeof(SUB_TOPICS) / sizeof(SUB_TOPICS[0]));
+      }
+    } else {
+      brokerPool.connectFailed();
+      LOG_WARN("MQTT connect failed, rc=%d, tls %d (verify 0x%lx), retry in %lu ms", mqttClient.state(),
+               secureClient.lastError(), (unsigned long)secureClient.verifyFlags(), mqttClient.connectRetryIn());
+    }
+  }
+  wasConnecting = connecting;
+  // Unacknowledged QoS 1 messages are resent to the new broker after its CONNACK
+  if (!connecting && brokerPool.poll()) {
+    uint8_t k = brokerPool.current();
+    LOG_INFO("MQTT broker -> %s (rtt %lu ms)", brokerPool.config(k).host, (unsigned long)brokerPool.rtt_ms(k));
+    if (mqttClient.connected()) mqttClient.disconnect();
+  }
+}
+
+// The V / I / P page, big digits, or small text above the trend chart with OLED_TREND.
+static void setupPage() {
+  using Align = GFXTextRun::Align;
+  page.begin(&display, SSD1306_WHITE, SSD1306_BLACK);
+  if (OLED_TREND) {
+    page.addLabel(0, 0, 1, "V:");
+    page.addLabel(66, 0, 1, "I:");
+    page.addLabel(0, 8, 1, "P:");
+    page.addField(18, 0, 1, Align::ALIGN_LEFT, 2, " V");
+    page.addField(84, 0, 1, Align::ALIGN_LEFT, 2, " A");
+    page.addField(18, 8, 1, Align::ALIGN_LEFT, 2, " W");
   } else {
-    Serial.print("failed, rc=");
-    Serial.println(mqttClient.state());
-    return false;
+    page.addLabel(0, 0, 2, "V:");
+    page.addLabel(108, 0, 2, "V");
+    page.addLabel(0, 20, 2, "I:");
+    page.addLabel(108, 20, 2, "A");
+    page.addLabel(0, 40, 2, "P:");
+    page.addLabel(108, 40, 2, "W");
+    page.addField(96, 0, 2, Align::ALIGN_RIGHT, 2);
+    page.addField(96, 20, 2, Align::ALIGN_RIGHT, 2);
+    page.addField(96, 40, 2, Align::ALIGN_RIGHT, 2);
   }
+  page.addLabel(0, 57, 1, "SoC:");
+  page.addLabel(80, 57, 1, "SoH:");
+  page.addField(24, 57, 1, Align::ALIGN_LEFT, 1, "%");
+  page.addField(104, 57, 1, Align::ALIGN_LEFT, 1, "%");
+  // Live values: a last-digit dither (ADC noise) does not redraw
+  page.setHysteresis(FIELD_V, 0.02f);
+  page.setHysteresis(FIELD_I, 0.02f);
+  page.setHysteresis(FIELD_P, 0.02f);
+  page.setHysteresis(FIELD_SOC, 0.2f);
+  page.setHysteresis(FIELD_SOH, 0.2f);
+
+  // SoC in big digits above its trend, the EKF's uncertainty below
+  socPage.begin(&display, SSD1306_WHITE, SSD1306_BLACK);
+  socPage.addLabel(0, 0, 2, "SoC");
+  socPage.addField(OLED_WIDTH, 0, 2, Align::ALIGN_RIGHT, 1, "%");
+  socPage.addLabel(0, 57, 1, "+/-");
+  socPage.addField(24, 57, 1, Align::ALIGN_LEFT, 1, "%");
+  socTrend.setRange(0.0f, 100.0f);
+
+  socGauge.begin();
+  socGauge.setColors(SSD1306_WHITE, SSD1306_BLACK);
+  socGaugePage.begin(&display, SSD1306_WHITE, SSD1306_BLACK);
+  socGaugePage.addField(OLED_WIDTH / 2, 26, 2, Align::ALIGN_CENTER, 0);
+  socGaugePage.addLabel(52, 56, 1, "SoC");
+  socGaugePage.setHysteresis(0, 0.2f);
+
+  diagPage.begin(&display, SSD1306_WHITE, SSD1306_BLACK);
+  diagPage.addLabel(0, 0, 1, "WiFi:");
+  diagPage.addLabel(0, 11, 1, "Heap:");
+  diagPage.addLabel(0, 22, 1, "Uptime:");
+  diagPage.addLabel(0, 33, 1, "Queued:");
+  diagPage.addLabel(0, 44, 1, "Dropped:");
+  diagPage.addLabel(0, 55, 1, "Samples:");
+  diagPage.addField(60, 0, 1, Align::ALIGN_LEFT, 0, " dBm");
+  diagPage.addField(60, 11, 1, Align::ALIGN_LEFT, 0, " kB");
+  diagPage.addField(60, 22, 1, Align::ALIGN_LEFT, 1, " h");
+  diagPage.addField(60, 33, 1, Align::ALIGN_LEFT, 0, " pages");
+  diagPage.addField(60, 44, 1, Align::ALIGN_LEFT, 0, " msgs");
+  diagPage.addField(60, 55, 1, Align::ALIGN_LEFT, 0, " /s");
 }
 
 void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
-  Serial.begin(115200);
-  delay(1000);
-  // Note: WiFi will be connected after sensors and OLED are initialized
+  if (LINK_ROLE == LinkRole::SerialStream) {
+    Serial.setTxBufferSize(SerialStream::TX_BUFFER);
+    Serial.begin(SERIAL_STREAM_BAUD);
+  } else {
+    Serial.begin(115200);
+    logger.begin(Serial);   // not while streaming: log lines are dropped and counted
+  }
+  if (!FAST_BOOT) delay(1000);
+
+  buildTopics();
+  if (topics.ok()) Serial.printf("Device %s, telemetry on %s\n", topics.deviceId(), PUB_TOPIC);
+  else Serial.println("Topics: TOPIC_TEMPLATE expands past TopicLayout::TOPIC_MAX");
+  topicRouter.on(SUB_TOPIC, onCommand);
+  topicRouter.on(SUB_TOPIC_CONFIG, onConfig);
+  topicRouter.on(SUB_TOPIC_OTA_BEGIN, onOtaBegin);
+  topicRouter.on(SUB_TOPIC_OTA_CHUNK, onOtaChunk);
+  topicRouter.on(SUB_TOPIC_OTA_ABORT, onOtaAbort);
+  ota.begin(OTA_MAX_CHUNK);
+  if (configStore.load(config)) Serial.printf("Config #%lu loaded from NVS\n", (unsigned long)configStore.seq());
+  acceptedConfig = config;
+  publishInterval = config.publishInterval_ms;
+  configReplyDue = true;   // announce it once connected
+
+  if (LINK_ROLE == LinkRole::EspNowNode) {
+    // Nothing but ESP-NOW: the gateway decodes and forwards binary windows
+    config.encoding = TelemetryEncoding::Binary;
+    if (!espNow.beginNode(ESPNOW_GATEWAY_MAC, ESPNOW_CHANNEL)) Serial.println("ESP-NOW: node start failed");
+  } else if (LINK_ROLE == LinkRole::BleOnly) {
+    WiFi.mode(WIFI_OFF);
+  } else if (LINK_ROLE == LinkRole::SerialStream) {
+    WiFi.mode(WIFI_OFF);
+    config.sampleRate_Hz = SERIAL_STREAM_RATE_HZ;
+    serialStream.begin(Serial);
+  } else {
+    // Start WiFi first; it connects in the background while sensors initialize
+    wifiManager.begin(WIFI_CREDENTIALS, sizeof(WIFI_CREDENTIALS) / sizeof(WIFI_CREDENTIALS[0]));
+    clockSync.begin(NTP_SERVER_1, NTP_SERVER_2, NTP_RESYNC_MS);
+    if (LINK_ROLE == LinkRole::EspNowGateway) {
+      if (espNow.beginGateway()) Serial.printf("ESP-NOW gateway, STA MAC %s\n", WiFi.macAddress().c_str());
+      else Serial.println("ESP-NOW: gateway start failed");
+    }
+  }
+#ifdef BLE_PERIPHERAL
+  if (bleLink.begin(BLE_NAME)) Serial.printf("BLE: advertising as %s\n", BLE_NAME);
+  else Serial.println("BLE: start failed");
+#endif
+  brokerPool.setFailover(BROKER_FAILOVER_AFTER, BROKER_SWITCH_MARGIN_MS, BROKER_SWITCH_ROUNDS);
+  brokerPool.begin(MQTT_BROKERS, sizeof(MQTT_BROKERS) / sizeof(MQTT_BROKERS[0]), BROKER_PROBE_INTERVAL_MS,
+                   BROKER_PROBE_TIMEOUT_MS);
 
   // Initialize the two I2C buses with provided pins
   // OLED on I2C_OLED (bus 0) using 400kHz
   I2C_OLED.begin(OLED_SDA_PIN, OLED_SCL_PIN, 400000);
-  // INA219 on I2C_INA (bus 1) using 100kHz
+  // INA219 on I2C_INA (bus 1) at 100kHz until the negotiated clock is known
   I2C_INA.begin(INA_SDA_PIN, INA_SCL_PIN, 100000);
 
-  // Simple scanner to report devices found on each bus
-  Serial.println("Scanning I2C_OLED (bus 0) ...");
-  for (uint8_t addr = 1; addr < 127; ++addr) {
-    I2C_OLED.beginTransmission(addr);
-    uint8_t err = I2C_OLED.endTransmission();
-    if (err == 0) {
-      Serial.printf("  Found device at 0x%02X on I2C_OLED\n", addr);
-    }
+  // Probe only the expected addresses, preferring what answered last boot;
+  // the full scan is a diagnostic (FAST_BOOT = false or the SCAN_I2C command)
+  if (!FAST_BOOT) {
+    i2cScan(I2C_OLED, "I2C_OLED");
+    i2cScan(I2C_INA, "I2C_INA");
   }
+  I2cTopology cached = {0, 0};
+  loadTopology(cached);
+  I2cTopology topo = {0, 0};
+  // Parts the profile leaves out are not probed
+  if (PROFILE.oled) topo.oledAddr = i2cFind(I2C_OLED, cached.oledAddr, OLED_CANDIDATES, sizeof(OLED_CANDIDATES));
+  if (PROFILE.ina219) topo.inaAddr = i2cFind(I2C_INA, cached.inaAddr, &INA_ADDRESS, 1);
 
-  Serial.println("Scanning I2C_INA (bus 1) ...");
-  for (uint8_t addr = 1; addr < 127; ++addr) {
-    I2C_INA.beginTransmission(addr);
-    uint8_t err = I2C_INA.endTransmission();
-    if (err == 0) {
-      Serial.printf("  Found device at 0x%02X on I2C_INA\n", addr);
+  // Fastest reliable I2C_INA clock: the stored one if it still passes a
+  // quick check, otherwise negotiate again
+  if (topo.inaAddr) {
+    Adafruit_I2CDevice inaBus(topo.inaAddr, &I2C_INA);
+    uint32_t hz = 0;
+    bool stored = FAST_BOOT && loadBusClock("ina", hz) && inaBus.setSpeed(hz) &&
+                  verifyBusClock(inaBus, INA_CLOCK_TEST, 4);
+    if (!stored) {
+      Serial.println("Negotiating I2C_INA clock");
+      size_t count = sizeof(INA_BUS_CLOCKS) / sizeof(INA_BUS_CLOCKS[0]);
+      hz = negotiateBusClock(inaBus, INA_CLOCK_TEST, INA_BUS_CLOCKS, count);
+      if (hz) storeBusClock("ina", hz);
     }
+    Serial.printf("I2C_INA at %lu Hz\n", (unsigned long)(hz ? hz : INA_BUS_CLOCKS[0]));
   }
 
   // Initialize INA219 on I2C_INA bus
-  Serial.println("Initializing INA219 on I2C_INA...");
-  // Adafruit_INA219::begin accepts an optional TwoWire* parameter
-  if (ina219.begin(&I2C_INA)) {
+  if (PROFILE.ina219 && topo.inaAddr && ina219.begin(&I2C_INA)) {
     inaPresent = true;
+    ina219.configure(INA_PROFILE);
+    // Write the calibration once and only re-check it: 4 transactions per sample instead of 6
+    ina219.setTrustedCalibration(true);
     Serial.println("INA219 initialized");
-  } else if (ina219.begin()) {
-    inaPresent = true;
-    Serial.println("INA219 initialized (fallback)");
   } else {
     inaPresent = false;
+    topo.inaAddr = 0;
     Serial.println("INA219 not found");
   }
 
-  // Initialize OLED
-  Serial.println("Initializing OLED on I2C_OLED...");
-  // try to initialize display using the separate I2C bus
-  if (display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
+  // Initialize OLED on the separate I2C bus
+  if (PROFILE.oled && topo.oledAddr && display.begin(SSD1306_SWITCHCAPVCC, topo.oledAddr)) {
     oledPresent = true;
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0, 0);
-    display.println("OLED initialized");
-    display.display();
-    Serial.println("OLED initialized");
+    // Each refresh then sends only the bytes that differ from the panel
+    // (a few digits instead of the whole 1 KB)
+    display.setPanelShadow(true);
+    // The V / I / P page reuses ~15 glyphs at sizes 1 and 2: keep them pre-rendered (384 bytes)
+    display.setGlyphCache(16, 2);
+    Serial.printf("OLED initialized at 0x%02X\n", topo.oledAddr);
   } else {
     oledPresent = false;
+    topo.oledAddr = 0;
     Serial.println("OLED not found");
   }
+  storeTopology(topo);
 
-  // Show INA219 status first
+  // One status screen; the V / I / P page replaces it at the first publish
   if (oledPresent) {
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(0, 0);
-    if (inaPresent) display.println("INA219: OK");
-    else display.println("INA219: NOT FOUND");
+    display.println(inaPresent ? "INA219: OK" : "INA219: NOT FOUND");
+    display.println("WiFi: connecting...");
     display.display();
+    if (!FAST_BOOT) delay(1000);
   }
-  delay(1000);
 
-  // Connect WiFi and show status on OLED
-  if (oledPresent) {
-    display.clearDisplay();
-    display.setCursor(0, 0);
-    display.println("WiFi: connecting...");
-    display.display();
+  flashQueue.setAwaitAcks(true);
+  if (!flashQueue.begin()) Serial.println("LittleFS unavailable: offline queue limited to RAM");
+  else if (flashQueue.storedPages()) Serial.printf("Offline queue: %u pages to replay\n", flashQueue.storedPages());
+
+  // Initialize SoC state
+  coulomb.begin(config.capacity_mAh, INITIAL_SOC_PERCENT);
+  // Resume from the last checkpoint unless the configured battery changed
+  SocState saved;
+  bool restored = socCheckpoint.restore(saved) && saved.capacity_uAs == coulomb.capacity_uAs();
+  if (energyMeter.restore()) {
+    const EnergyTotals& e = energyMeter.totals();
+    Serial.printf("Energy restored: %.3f Ah / %.2f Wh out, %.3f Ah / %.2f Wh in\n", e.discharge_uAs / 3.6e9,
+                  e.discharge_uWs / 3.6e9, e.charge_uAs / 3.6e9, e.charge_uWs / 3.6e9);
   }
-  connectWiFi();
-  if (oledPresent) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.println("WiFi: connected");
-    display.println(WiFi.localIP());
-    display.display();
+  if (restored) {
+    coulomb.restore(saved.consumed_uAs, saved.remaining_uAs);
+    Serial.printf("SoC restored: %.1f%%\n", coulomb.soc_percent());
   }
-  delay(800);
+  // A restored SoC is trusted to a few percent, the configured guess much less
+  socEkf.setOcvTable(ocvTable(BATTERY_CHEMISTRY));
+  socEkf.setCircuit(CELL_R0_OHM, CELL_R1_OHM, CELL_TAU1_S);
+  socEkf.begin(config.capacity_mAh, coulomb.soc_percent(), restored ? 3.0f : 25.0f);
+  soc_percent = estimatedSoc();
+  sohEstimator.begin(socEkf, config.capacity_mAh, MEASURED_CAPACITY_mAh, CELL_R0_OHM);
+  if (restored) sohEstimator.restore(saved.soh);
+  if (sohEstimator.segments()) socEkf.setCapacity_mAh(sohEstimator.capacity_mAh());
+  soh_percent = sohEstimator.soh_percent();
 
-  // Connect MQTT and show status
-  if (oledPresent) {
-    display.clearDisplay();
-    display.setCursor(0, 0);
-    display.println("MQTT: connecting...");
-    display.display();
+  if (inaPresent) {
+    protection.begin(PROTECTION_CUTOFF_PIN, PROTECTION_CLOSED_LEVEL == HIGH, PROTECTION_LIMITS);
+    if (protection.tripped()) Serial.println("Protection: latched trip from before the reset, cutoff open");
   }
-  mqttConnect();
-  if (oledPresent) {
-    display.clearDisplay();
-    if (mqttClient.connected()) display.println("MQTT: connected");
-    else display.println("MQTT: failed");
-    display.display();
+  if (inaPresent && POWER_MODE == PowerMode::LowPower && USES_WIFI) {
+    // loop() samples and sleeps itself; the display stays off
+    lowPower = true;
+    publishInterval = LOW_POWER_WINDOW_MS;
+    setCpuFrequencyMhz(80);
+    ina219.powerSave(true);
+    if (oledPresent) {
+      display.ssd1306_command(SSD1306_DISPLAYOFF);
+      oledPresent = false;
+    }
+    // Keep a whole uplink period of windows in RAM rather than on flash
+    flashQueue.setFlushInterval(LOW_POWER_WINDOW_MS * UPLINK_EVERY_WINDOWS);
+    dutyCycle.begin(1000000 / LOW_POWER_SAMPLE_RATE_HZ, UPLINK_EVERY_WINDOWS, UPLINK_TIMEOUT_MS);
+    // The radio is already up from wifiManager.begin(): treat boot as an uplink
+    dutyCycle.startUplink(millis());
+  } else if (inaPresent) {
+    if (ADAPTIVE_RATE && INA_ALERT_PIN < 0 && LINK_ROLE != LinkRole::SerialStream) {
+      adaptiveRate.begin(ADAPTIVE_MIN_RATE_HZ, config.sampleRate_Hz);
+      adaptiveRate.setThresholds(ADAPTIVE_CURRENT_mA, ADAPTIVE_SLEW_mA_PER_S, ADAPTIVE_HOLD_ms);
+      sampler.setAdaptive(&adaptiveRate);
+    }
+    sampler.setProtection(&protection);
+    // Start acquisition; from here on only the sampler task talks to the INA219
+    bool started = INA_ALERT_PIN >= 0 ? sampler.beginOnAlert(&ina219, INA_ALERT_PIN)
+                                      : sampler.begin(&ina219, config.sampleRate_Hz);
+    if (!started) {
+      Serial.println("Failed to start sampler task");
+      inaPresent = false;
+    }
+  }
+  if (inaPresent && !lowPower) {
+    uint8_t taps = cellMonitor.begin(CELL_TAPS, sizeof(CELL_TAPS) / sizeof(CELL_TAPS[0]), CELL_ADC_RATE_HZ,
+                                     CELL_OVERSAMPLE, APP_CPU_NUM, CELL_PRIORITY);
+    if (taps) Serial.printf("Cell monitor: %u taps, ADC1 DMA at %lu Hz\n", taps, (unsigned long)CELL_ADC_RATE_HZ);
   }
-  delay(800);
 
-  // Show main V / I / P page (initial values)
-  if (oledPresent) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.println("V   I    P");
+  // From here on display() only hands the frame over; a priority-1 task on core 0 streams it, so
+  // loop() never waits the ~25 ms a full frame takes at 400 kHz
+  if (oledPresent && !display.startBackgroundRefresh(1, 0)) Serial.println("OLED: refreshing from loop()");
+  if (oledPresent) setupPage();
+  if (oledPresent && !button.begin(BUTTON_PIN, BUTTON_DEBOUNCE_MS, BUTTON_LONG_PRESS_MS))
+    Serial.println("Button: interrupt setup failed");
+  if (oledPresent && OLED_TREND) {
+    currentTrend.setRange(OLED_TREND_MIN_A, OLED_TREND_MAX_A);
+    currentTrend.clear();
     display.display();
   }
 
-  // Initialize SoC state
-  remaining_mAh = BATTERY_CAPACITY_mAh * (INITIAL_SOC_PERCENT / 100.0f);
-  if (MEASURED_CAPACITY_mAh > 0.0f) soh_percent = (MEASURED_CAPACITY_mAh / BATTERY_CAPACITY_mAh) * 100.0f;
-  else soh_percent = 100.0f; // unknown
-  lastIntegrationMillis = millis();
+  if (STATUS_LED_PIN >= 0 && !lowPower) {
+    statusLeds.setIdleThreshold_mA(STATUS_IDLE_mA);
+    if (!statusLeds.begin(STATUS_LED_PIN, STATUS_LED_COUNT, STATUS_LED_BRIGHTNESS, STATUS_LED_FRAME_MS))
+      Serial.println("Status LEDs: failed to start");
+  }
+
+  if (stringBank.begin(INA_STRINGS, sizeof(INA_STRINGS) / sizeof(INA_STRINGS[0]), INA_PROFILE)) {
+    Serial.printf("INA219 bank: %u string monitor(s)\n", stringBank.size());
+  }
+
+  size_t eventCapacity = psramPresent() ? EVENT_CAPACITY_PSRAM : EventCapture::CAPACITY;
+  PowerSample* eventRing = (PowerSample*)placeAlloc(eventCapacity * sizeof(PowerSample), MemRegion::Bulk);
+  eventBufferSize = EVENT_HEADER_SIZE + SAMPLE_RECORD_SIZE + eventCapacity * DELTA_RECORD_MAX;
+  eventBuffer = (uint8_t*)placeAlloc(eventBufferSize, MemRegion::Bulk);
+  if (!eventRing || !eventBuffer) {
+    Serial.println("Event capture: out of memory, disabled");
+    eventRing = nullptr;
+  } else {
+    Serial.printf("Event capture: %u samples in %s\n", (unsigned)eventCapacity, psramPresent() ? "PSRAM" : "SRAM");
+  }
+  eventCapture.begin(EVENT_PRE_ms, EVENT_POST_ms, eventRing, eventCapacity);
+  eventCapture.setTriggers(EVENT_CURRENT_mA, EVENT_SLEW_mA_PER_S, EVENT_UNDERVOLTAGE_V, EVENT_HOLDOFF_ms);
+  reportFilter.begin(RBE_DEADBAND, RBE_HEARTBEAT_MS);
+  loadProfile.begin(LOAD_PROFILE_CURRENT_uA[0], LOAD_PROFILE_CURRENT_uA[1],
+                    LOAD_PROFILE_CELL_uV[0] * BATTERY_CELLS_SERIES, LOAD_PROFILE_CELL_uV[1] * BATTERY_CELLS_SERIES);
+  anomaly.begin(ANOMALY_LIMITS);
+  reportFilter.setEnabled(REPORT_BY_EXCEPTION);
+
+  startWindow();
+
+  healthMonitor.begin(HEALTH_TASKS, sizeof(HEALTH_TASKS) / sizeof(HEALTH_TASKS[0]));
+  healthMonitor.print(Serial);
+  if (LIVE_SERVER && !lowPower && USES_WIFI) {
+    if (liveServer.begin(LIVE_PORT, LIVE_MAX_CLIENTS, LIVE_PAGE_GZ, LIVE_PAGE_GZ_LEN, LIVE_PRIORITY, PRO_CPU_NUM))
+      Serial.printf("Live view on port %u\n", LIVE_PORT);
+    else
+      Serial.println("Live view: server failed to start");
+  }
+  if (!lowPower) startTasks();
 }
 
-void loop() {
-  if (WiFi.status() != WL_CONNECTED) {
-    connectWiFi();
+// A new aggregation window; the raw batch is decimated to fit it.
+static void startWindow() {
+  window.reset();
+  cellWindow.reset();
+  uint32_t rate = lowPower ? LOW_POWER_SAMPLE_RATE_HZ : config.sampleRate_Hz;
+  uint32_t samplesPerWindow = rate * publishInterval / 1000;
+  window.setRawStride((samplesPerWindow + TelemetryWindow::RAW_CAPACITY - 1) / TelemetryWindow::RAW_CAPACITY);
+}
+
+// Estimation task: takes a new config over in one step, between two windows.
+static void applyConfig(const RuntimeConfig& next, unsigned long now) {
+  config = next;
+  coulomb.setCapacity_mAh(config.capacity_mAh);
+  sohEstimator.setNominal_mAh(config.capacity_mAh);
+  if (!sohEstimator.segments()) socEkf.setCapacity_mAh(config.capacity_mAh);
+  if (!lowPower) {
+    publishInterval = config.publishInterval_ms;
+    if (inaPresent) sampler.requestRate(config.sampleRate_Hz);
   }
-  if (!mqttClient.connected()) {
-    mqttConnect();
+  startWindow();
+  reportFilter.forceFull();
+  anomaly.resetSoc();
+  lastPublish = now;
+  LOG_INFO("Config applied: %lu ms windows, %lu Hz", (unsigned long)publishInterval,
+           (unsigned long)config.sampleRate_Hz);
+}
+
+// Every reading, whichever path produced it, goes through here.
+static void handleSample(const PowerSample& raw) {
+  PowerSample s = raw;
+  if (config.currentTrim_ppm || config.currentOffset_uA) {
+    // Site calibration on top of the INA219's: I' = I * (1 + trim) + offset, P' = V * |I'|
+    s.current_uA += (int32_t)((int64_t)s.current_uA * config.currentTrim_ppm / 1000000) + config.currentOffset_uA;
+    int64_t power_uW = (int64_t)s.bus_uV * s.current_uA / 1000000;
+    s.power_uW = (int32_t)(power_uW < 0 ? -power_uW : power_uW);
   }
-  mqttClient.loop();
+  coulomb.addSample_uA(s.t_us, s.current_uA);
+  // The INA219 sits on the high side: battery terminal = load-side bus + shunt drop
+  int32_t cell_uV = (s.bus_uV + s.shunt_uV) / BATTERY_CELLS_SERIES;
+  socEkf.update(s.t_us, s.current_uA, cell_uV);
+  sohEstimator.add(s.t_us, s.current_uA, cell_uV, coulomb.consumed_uAs());
+  int32_t battery_uV = s.bus_uV + s.shunt_uV;
+  energyMeter.add(s.t_us, battery_uV, s.current_uA);
+  if (LOAD_PROFILE_WINDOW_MS) loadProfile.add(s.t_us, battery_uV, s.current_uA, s.rate_Hz);
+  if (ANOMALY_DETECTION) anomaly.add(s.t_us, battery_uV, s.current_uA);
+  window.add(s);
+  if (cellMonitor.size()) {
+    PackSample pack;
+    if (cellMonitor.align(s, pack)) cellWindow.add(pack);
+  }
+  eventCapture.add(s);
+  liveServer.add(s);
+#ifdef BLE_PERIPHERAL
+  bleLink.add(s);
+#endif
+  if (LINK_ROLE == LinkRole::SerialStream) serialStream.add(s);
+  powerProfile.add(lowPower ? dutyCycle.phase() : PowerPhase::Active, s.t_us, s.current_uA);
+  statusLeds.update(estimatedSoc(), s.current_uA, s.overflow);
+  lastSample = s;
+}
 
-  unsigned long now = millis();
-  if (now - lastPublish > PUBLISH_INTERVAL) {
-    lastPublish = now;
-    if (inaPresent) {
-      float shunt_mV = ina219.getShuntVoltage_mV();
-      float bus_V = ina219.getBusVoltage_V();
-      float current_mA = ina219.getCurrent_mA();
-      float power_mW = ina219.getPower_mW();
-
-      // Coulomb counting integration for SoC
-      unsigned long now_ms = now;
-      unsigned long dt_ms = now_ms - lastIntegrationMillis;
-      if (dt_ms > 0) {
-        float dt_hours = (float)dt_ms / 3600000.0f;
-        // current_mA: positive = discharge (consuming), negative = charging
-        float delta_mAh = current_mA * dt_hours;
-        consumed_mAh += delta_mAh;
-        remaining_mAh -= delta_mAh;
-        // keep remaining within [0, capacity]
-        if (remaining_mAh < 0.0f) remaining_mAh = 0.0f;
-        if (remaining_mAh > BATTERY_CAPACITY_mAh) remaining_mAh = BATTERY_CAPACITY_mAh;
-        lastIntegrationMillis = now_ms;
+// Frame hand-over to the refresh task, timed as its own stage
+static void showFrame() {
+  TraceScope trace(TraceStage::Display);
+  display.display();
+}
+
+// Network task: connection upkeep, commands, diagnostics and everything in the outbox.
+static void networkPass(unsigned long now) {
+  TraceScope pass(TraceStage::Loop);
+#ifdef BLE_PERIPHERAL
+  bleLink.poll(now, BLE_BATCH_MS, soc_percent, soh_percent, clockSync);
+#endif
+  shipProtection();
+  shipAlerts();
+  if (LINK_ROLE == LinkRole::EspNowNode) {
+    drainToGateway();
+    return;
+  }
+  if (LINK_ROLE == LinkRole::BleOnly || LINK_ROLE == LinkRole::SerialStream) {
+    // Nowhere to send windows or events: let estimation move on
+    while (outbox.front()) outbox.release();
+    if (eventOutbox.front()) eventOutbox.release();
+    return;
+  }
+  {
+    TraceScope trace(TraceStage::Wifi);
+    wifiManager.poll();
+  }
+  if (wifiManager.connected()) {
+    TraceScope trace(TraceStage::Mqtt);
+    mqttPoll();
+  }
+
+  if (i2cScanRequested) {
+    i2cScanRequested = false;
+    i2cScan(I2C_OLED, "I2C_OLED");
+    i2cScan(I2C_INA, "I2C_INA");
+  }
+  size_t busCount = sizeof(I2C_BUSES) / sizeof(I2C_BUSES[0]);
+  if (i2cStatsRequested) {
+    i2cStatsRequested = false;
+    printI2cStats(Serial, I2C_BUSES, busCount);
+  }
+  if (loopStatsRequested) {
+    loopStatsRequested = false;
+    printLoopTrace(Serial);
+  }
+
+#ifdef BUSIO_I2C_STATS
+  if (mqttClient.connected() && now - lastI2cDiag >= I2C_DIAG_INTERVAL) {
+    lastI2cDiag = now;
+    PooledBuffer<LargeBlocks> buf(largeBlocks);
+    if (buf.ok()) {
+      JsonWriter diag(buf.chars(), buf.size());
+      diag.beginObject().field("uptime_ms", (uint32_t)now);
+      writeI2cStats(diag, I2C_BUSES, busCount);
+      diag.endObject();
+      if (diag.ok() && mqttClient.publish(PUB_TOPIC_DIAG, diag.c_str())) resetI2cStats();
+    }
+  }
+#endif
+#ifdef LOOP_TRACE
+  if (now - lastLoopTrace >= LOOP_TRACE_INTERVAL) {
+    lastLoopTrace = now;
+    printLoopTrace(Serial);
+    PooledBuffer<LargeBlocks> buf(largeBlocks);
+    if (mqttClient.connected() && buf.ok()) {
+      JsonWriter trace(buf.chars(), buf.size());
+      trace.beginObject()
+          .field("uptime_ms", (uint32_t)now)
+          .field("window_ms", (uint32_t)LOOP_TRACE_INTERVAL);
+      writeLoopTrace(trace);
+      trace.endObject();
+      if (trace.ok()) mqttClient.publish(PUB_TOPIC_LOOP, trace.c_str());
+    }
+    resetLoopTrace();
+  }
+#endif
+  if (now - lastHealth >= HEALTH_INTERVAL) {
+    lastHealth = now;
+    healthMonitor.sample();
+    if (LOG_ENABLED(LOG_LEVEL_INFO)) {
+      LogPrint out(logger, LOG_LEVEL_INFO);
+      healthMonitor.print(out);
+    }
+    healthRequested.store(true, std::memory_order_relaxed);
+    healthPending = true;
+  }
+  static HealthSnapshot estimationHealth;
+  if (healthPending && healthSnapshot.read(estimationHealth)) {
+    healthPending = false;
+    PooledBuffer<LargeBlocks> buf(largeBlocks);
+    if (mqttClient.connected() && buf.ok()) {
+      JsonWriter health(buf.chars(), buf.size());
+      health.beginObject().field("uptime_ms", (uint32_t)now);
+      healthMonitor.writeJson(health);
+      health.beginObject("tls")
+          .field("held", secureClient.heapHeld())
+          .field("handshake_peak", secureClient.handshakePeakHeap())
+          .field("handshake_ms", secureClient.handshakeMs())
+          .field("resume_offered", secureClient.sessionOffered())
+          .field("verify", secureClient.verifying())
+          .field("suite", secureClient.ciphersuite())
+          .field("hw_crypto", TlsSessionClient::hardwareCrypto())
+          .endObject()
+          .field("inbound_oversize", inboundOversize)
+          .beginObject("outbox")
+          .field("depth", (uint32_t)outbox.size())
+          .field("dropped", outbox.timeouts())
+          .endObject();
+      clockSync.writeJson(health);
+      logger.writeJson(health);
+      health.members(estimationHealth.json, estimationHealth.len);
+      writeMemoryJson(health);
+      if (protection.enabled()) protection.writeJson(health);
+      supervisor.writeJson(health, now);
+      if (espNow.ready()) espNow.writeJson(health);
+#ifdef BLE_PERIPHERAL
+      bleLink.writeJson(health);
+#endif
+      health.beginObject("pools");
+      smallBlocks.writeJson(health, "small");
+      largeBlocks.writeJson(health, "large");
+      health.endObject().endObject();
+      if (health.ok()) mqttClient.publish(PUB_TOPIC_HEALTH, health.c_str());
+    }
+  }
+  {
+    TraceScope trace(TraceStage::Queue);
+    if (mqttClient.connected() && !flashQueue.empty() && now - lastQueueDrain >= QUEUE_DRAIN_INTERVAL) {
+      lastQueueDrain = now;
+      flashQueue.drain(sendQueued, QUEUE_DRAIN_BATCH);
+    }
+    flashQueue.poll(now);
+  }
+
+  drainOutbox();
+  queuedPages.store(flashQueue.storedPages(), std::memory_order_relaxed);
+  if (mqttClient.connected()) shipEvent();
+  if (LINK_ROLE == LinkRole::EspNowGateway && mqttClient.connected()) forwardNodes();
+  if (configReplyDue && mqttClient.connected()) publishConfigState();
+  if (mqttClient.connected() && ota.statusDue(now)) publishOtaStatus(now);
+  if (ota.state() == OtaState::Ready && !ota.statusDue(now)) {
+    if (!otaReadyAt) otaReadyAt = now ? now : 1;
+    if (now - otaReadyAt >= OTA_RESTART_DELAY_MS) {
+      LOG_INFO("OTA: restarting into the new firmware");
+      logger.flush();
+      mqttClient.disconnect();
+      ESP.restart();
+    }
+  }
+}
+
+// Estimation task: its share of diag/health, so the network task never reads these mid-update (the
+// energy totals are 64-bit)
+static void writeHealthSnapshot() {
+  static HealthSnapshot snapshot;
+  JsonWriter w(snapshot.json, sizeof(snapshot.json));
+  w.beginObject();
+  energyMeter.writeJson(w);
+  if (ANOMALY_DETECTION) anomaly.writeJson(w);
+  if (reportFilter.enabled()) reportFilter.writeJson(w);
+  if (liveServer.running()) liveServer.writeJson(w);
+  if (cellMonitor.size()) cellMonitor.writeJson(w);
+  w.endObject();
+  if (!w.ok()) LOG_WARN("Health: estimation section over %u bytes, left out", (unsigned)sizeof(snapshot.json));
+  snapshot.len = w.ok() ? (uint16_t)w.length() : 0;
+  healthSnapshot.write(snapshot);
+}
+
+// Estimation task: samples into the estimators, and a window's payloads into the outbox.
+// outboxWait bounds how long a full outbox may hold it up.
+static void estimationPass(unsigned long now, TickType_t outboxWait) {
+  RuntimeConfig next;
+  if (pendingConfig.read(next)) applyConfig(next, now);
+  EstimationCommand command;
+  while (estimationCommands.pop(command)) {
+    if (command == EstimationCommand::ProtectReset) protection.reset();
+    else protection.trip();
+  }
+  if (healthRequested.exchange(false, std::memory_order_relaxed)) writeHealthSnapshot();
+
+  // Drain everything the sampler produced since the last pass
+  TraceScope drain(TraceStage::Samples);
+  PowerSample sample;
+  if (lowPower) {
+    if (dutyCycle.sampleDue()) {
+      dutyCycle.sampled();
+      if (sampleTriggered(&ina219, sample)) {
+        protection.check(sample);
+        sample.rate_Hz = LOW_POWER_SAMPLE_RATE_HZ;
+        handleSample(sample);
       }
+    }
+  } else {
+    // In batches: one index update per SAMPLE_BATCH samples instead of per sample
+    PowerSample batch[SAMPLE_BATCH];
+    while (size_t n = sampler.popBulk(batch, SAMPLE_BATCH)) {
+      for (size_t k = 0; k < n; ++k) handleSample(batch[k]);
+    }
+    if (LINK_ROLE == LinkRole::SerialStream) serialStream.send();
+  }
+  drain.stop();
+  energyMeter.poll(clockSync.utcNow_ms());
+  if (USES_WIFI) queueEnergySummaries(outboxWait);
+  if (USES_WIFI) queueLoadProfile(now, outboxWait);
+  liveServer.poll(now, LIVE_FRAME_MS);
+
+  if (eventCapture.ready()) handOverEvent();
+
+  if (stringBank.size() && now - lastStringSample >= STRING_SAMPLE_INTERVAL) {
+    lastStringSample = now;
+    stringBank.tick(stringSample);
+  }
+
+  UiState ui = { lastSample.bus_uV * 1e-6f, lastSample.current_uA * 1e-6f, lastSample.power_uW * 1e-6f,
+                 soc_percent, soh_percent, socEkf.sigma_percent(), lastSample.rate_Hz, outbox.timeouts(),
+                 publishedWindows };
+  uiState.write(ui);
+
+  if (now - lastPublish <= publishInterval) return;
+  lastPublish = now;
+  if (!inaPresent) {
+    if (!PROFILE.demoFallback) return;
+    OutboundMessage* m = outbox.acquire(outboxWait);
+    if (!m) return;
+    JsonWriter payload((char*)m->data, sizeof(m->data));
+    uint64_t mono_us = ClockSync::monotonic_us();
+    payload.beginObject().field("uptime_ms", mono_us / 1000);
+    if (uint64_t ts = clockSync.utc_ms(mono_us)) payload.field("ts", ts);
+    payload.field("value", (int32_t)random(20, 30)).endObject();
+    m->topic = QUEUE_TOPIC_RAW;
+    m->store = false;
+    m->len = payload.length();
+    outbox.commit();
+    return;
+  }
+
+  TraceScope format(TraceStage::Format);
+  // Integer micro-units up to here; floats only for formatting
+  float shunt_mV = lastSample.shunt_uV * 1e-3f;
+  float bus_V = lastSample.bus_uV * 1e-6f;
+  float current_A = lastSample.current_uA * 1e-6f;
+  float power_W = lastSample.power_uW * 1e-6f;
 
-      // Compute SoC and SoH
-      soc_percent = (remaining_mAh / BATTERY_CAPACITY_mAh) * 100.0f;
-      if (soc_percent < 0.0f) soc_percent = 0.0f;
-      if (soc_percent > 100.0f) soc_percent = 100.0f;
-      if (MEASURED_CAPACITY_mAh > 0.0f) soh_percent = (MEASURED_CAPACITY_mAh / BATTERY_CAPACITY_mAh) * 100.0f;
-      float current_A = current_mA / 1000.0f;
-      float power_W = power_mW / 1000.0f;
-      String payload = "{\"uptime_ms\":" + String(now) +
-           ",\"bus_V\":" + String(bus_V, 3) +
-           ",\"shunt_mV\":" + String(shunt_mV, 3) +
-           ",\"current_A\":" + String(current_A, 3) +
-           ",\"power_W\":" + String(power_W, 3) +
-           ",\"soc_percent\":" + String(soc_percent, 2) +
-           ",\"soh_percent\":" + String(soh_percent, 2) + "}";
-      if (mqttClient.publish(PUB_TOPIC, payload.c_str())) {
-        Serial.print("Published INA219: ");
-        Serial.println(payload);
+  // Compute SoC and SoH
+  soc_percent = estimatedSoc();
+  soh_percent = sohEstimator.soh_percent();
+  // The EKF follows the measured cell once there is something to follow
+  socEkf.setCircuit(sohEstimator.r0_ohm(), CELL_R1_OHM, CELL_TAU1_S);
+  if (sohEstimator.segments()) socEkf.setCapacity_mAh(sohEstimator.capacity_mAh());
+  socCheckpoint.update(captureSocState(coulomb, sohEstimator, now), now);
+  energyMeter.checkpoint();
+  if (ANOMALY_DETECTION) anomaly.checkSoc(lastSample.t_us, soc_percent, coulomb.soc_percent());
+
+  // Stamps from acquisition, not from now: the window's first sample, or the one sample sent
+  uint64_t mono_us = ClockSync::monotonic_us();
+  uint64_t last_us = ClockSync::extend(lastSample.t_us, mono_us);
+  uint64_t first_us = window.count() ? ClockSync::extend(window.start_us(), mono_us) : last_us;
+
+  // Report by exception: the channels this window carries, none if nothing moved
+  if (config.publishMode == PublishMode::Latest || !window.count()) {
+    reportFilter.observe(CHANNEL_V, bus_V, bus_V, bus_V);
+    reportFilter.observe(CHANNEL_I, current_A, current_A, current_A);
+    reportFilter.observe(CHANNEL_P, power_W, power_W, power_W);
+  } else {
+    const ChannelStats* stats[] = { &window.voltage(), &window.current(), &window.power() };
+    const ReportChannel which[] = { CHANNEL_V, CHANNEL_I, CHANNEL_P };
+    for (uint8_t k = 0; k < 3; ++k) {
+      reportFilter.observe(which[k], stats[k]->min(), stats[k]->max(), stats[k]->mean());
+    }
+  }
+  reportFilter.observe(CHANNEL_SOC, soc_percent, soc_percent, soc_percent);
+  uint8_t channels = reportFilter.decide(now);
+  bool rbe = reportFilter.enabled();
+
+  if (channels && config.encoding != TelemetryEncoding::Binary) {
+    if (OutboundMessage* m = outbox.acquire(outboxWait)) {
+      JsonWriter payload((char*)m->data, sizeof(m->data));
+      uint64_t ts = clockSync.utc_ms(config.publishMode == PublishMode::Latest ? last_us : first_us);
+      payload.beginObject().field("uptime_ms", mono_us / 1000);
+      if (ts) payload.field("ts", ts);
+      if (rbe) {
+        payload.field("rbe", true);
+        if (reportFilter.heartbeat()) payload.field("heartbeat", true);
+      }
+      if (config.publishMode == PublishMode::Aggregate) {
+        window.writeAggregate(payload, channels);
+      } else if (config.publishMode == PublishMode::RawBatch) {
+        window.writeRaw(payload, channels);
       } else {
-        Serial.println("Publish failed");
+        if (channels & CHANNEL_V) payload.field("bus_V", bus_V, 3);
+        if (channels & CHANNEL_I) payload.field("shunt_mV", shunt_mV, 3).field("current_A", current_A, 3);
+        if (channels & CHANNEL_P) payload.field("power_W", power_W, 3);
+        if (lastSample.rate_Hz) payload.field("rate_Hz", (uint32_t)lastSample.rate_Hz);
       }
-
-      // Update OLED with concise V / I / P page
-      if (oledPresent) {
-        display.clearDisplay();
-          display.setTextSize(2);
-        display.setCursor(0, 0);
-        display.print("V: ");
-        display.print(String(bus_V, 2));
-        display.print(" V");
-        float current_A = current_mA / 1000.0f;
-        float power_W = power_mW / 1000.0f;
-        display.setCursor(0, 20);
-        display.print("I: ");
-        display.print(String(current_A, 2));
-        display.print(" A");
-        display.setCursor(0, 40);
-        display.print("P: ");
-        display.print(String(power_W, 2));
-        display.print(" W");
-        // show SoC/SoH on bottom line
-          display.setTextSize(1);
-          display.setCursor(0, 57);
-          display.print("SoC:");
-          display.print(String(soc_percent, 1));
-          display.print("%");
-          display.setCursor(80, 57);
-          display.print("SoH:");
-          display.print(String(soh_percent, 1));
-          display.print("%");
-        display.display();
+      if (channels & CHANNEL_SOC) payload.field("soc_percent", soc_percent, 2).field("soh_percent", soh_percent, 2);
+      if (SOC_FROM_EKF && (channels & CHANNEL_SOC)) {
+        payload.beginObject("soc_ekf")
+            .field("sigma_percent", socEkf.sigma_percent(), 2)
+            .field("coulomb_percent", coulomb.soc_percent(), 2)
+            .field("fused", socEkf.updates())
+            .field("rejected", socEkf.rejected())
+            .endObject();
+      }
+      if (channels & CHANNEL_SOC) {
+        payload.beginObject("soh")
+            .field("capacity_mAh", sohEstimator.capacity_mAh(), 0)
+            .field("sigma_mAh", sohEstimator.capacitySigma_mAh(), 0)
+            .field("r0_mOhm", sohEstimator.r0_ohm() * 1000.0f, 1)
+            .field("segments", (uint32_t)sohEstimator.segments())
+            .endObject();
+      }
+      if (!lowPower) {
+        // Schedule adherence over this window, to bound the coulomb-count error
+        SamplerTiming timing;
+        sampler.takeTiming(timing);
+        timing.writeJson(payload);
+      }
+      powerProfile.writeJson(payload);
+      if (cellWindow.count()) cellWindow.writeJson(payload);
+      if (stringSample.count) {
+        payload.beginArray("string_V");
+        for (uint8_t k = 0; k < stringSample.count; ++k) payload.value(stringSample.bus_uV[k] * 1e-6f, 3);
+        payload.endArray().beginArray("string_A");
+        for (uint8_t k = 0; k < stringSample.count; ++k) payload.value(stringSample.current_uA[k] * 1e-6f, 3);
+        payload.endArray();
+      }
+      payload.endObject();
+      if (payload.ok()) {
+        m->topic = config.publishMode == PublishMode::Aggregate ? QUEUE_TOPIC_AGGREGATE : QUEUE_TOPIC_RAW;
+        m->store = true;
+        m->len = payload.length();
+        outbox.commit();
+      } else {
+        LOG_ERROR("Payload too large");
       }
     } else {
-      String payload = "{\"uptime_ms\":" + String(now) + ",\"value\":" + String(random(20,30)) + "}";
-      if (mqttClient.publish(PUB_TOPIC, payload.c_str())) {
-        Serial.print("Published: ");
-        Serial.println(payload);
+      LOG_WARN("Outbox full, JSON window dropped");
+    }
+  }
+  // Binary records always carry every channel: only whole windows are skipped
+  if (channels && config.encoding != TelemetryEncoding::Json) {
+    static_assert(sizeof(OutboundMessage::data) >=
+                      TELEMETRY_HEADER_SIZE + SAMPLE_RECORD_SIZE + TelemetryWindow::RAW_CAPACITY * DELTA_RECORD_MAX,
+                  "outbox slot holds a full binary batch");
+    if (OutboundMessage* m = outbox.acquire(outboxWait)) {
+      size_t binLen;
+      if (config.publishMode == PublishMode::RawBatch && window.rawCount() > 0) {
+        binLen = encodePackedBatch(m->data, sizeof(m->data), window.raw(), window.rawCount(),
+                                   (uint32_t)(first_us / 1000), clockSync.utc_ms(first_us), soc_percent, soh_percent);
       } else {
-        Serial.println("Publish failed");
+        binLen = encodeSingle(m->data, sizeof(m->data), lastSample, (uint32_t)(last_us / 1000),
+                              clockSync.utc_ms(last_us), soc_percent, soh_percent);
+      }
+      if (binLen) {
+        m->topic = QUEUE_TOPIC_BIN;
+        m->store = true;
+        m->len = binLen;
+        outbox.commit();
+      } else {
+        LOG_ERROR("Binary encode failed");
+      }
+    } else {
+      LOG_WARN("Outbox full, binary window dropped");
+    }
+  }
+  format.stop();
+  window.reset();
+  cellWindow.reset();
+  if (lowPower && dutyCycle.windowDone()) {
+    dutyCycle.startUplink(now);
+    wifiManager.radioOn();
+  }
+  if (channels) publishedWindows++;
+}
+
+static void setPanel(PanelState state) {
+  if (state == panelState) return;
+  if (state == PanelState::Off) {
+    display.ssd1306_command(SSD1306_DISPLAYOFF);
+  } else {
+    if (panelState == PanelState::Off) display.ssd1306_command(SSD1306_DISPLAYON);
+    display.dim(state == PanelState::Dimmed);
+  }
+  panelState = state;
+}
+
+static void onButton(ButtonEvent event) {
+  lastActivity = millis();
+  bool asleep = panelState != PanelState::On;
+  setPanel(PanelState::On);
+  if (asleep) return;   // the first press only wakes the panel
+  uint8_t next = ((uint8_t)screen + 1) % (uint8_t)Screen::COUNT;
+  screen = event == ButtonEvent::LongPress ? Screen::Power : (Screen)next;
+  screenDirty = true;
+}
+
+// Clears the panel and re-declares whatever the current screen draws, for render() to repaint.
+static void enterScreen() {
+  display.clearDisplay();
+  switch (screen) {
+    case Screen::Power:
+      if (OLED_TREND) currentTrend.clear();
+      page.invalidate();
+      break;
+    case Screen::SocTrend:
+      socTrend.clear();
+      for (uint8_t k = 0; k < socHistoryCount; ++k) {
+        socTrend.add(socHistory[(socHistoryHead + k) % OLED_WIDTH]);
       }
+      socPage.invalidate();
+      break;
+    case Screen::SocGauge:
+      socGauge.invalidate();
+      socGaugePage.invalidate();
+      break;
+    case Screen::Diagnostics:
+      diagPage.invalidate();
+      lastDiagScreen = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+// UI task: the selected screen from the newest estimation output. Each screen's Dashboard only
+// redraws fields whose text changed, so a pass with nothing new sends nothing to the panel.
+static void uiPass(unsigned long now) {
+  static UiState ui = {};
+  uiState.read(ui);
+  // The boot status screen stays up until the first window, unless the user pages away
+  if (!oledPresent || (!ui.window && screen == Screen::Power && screenDirty)) return;
+
+  uint32_t idle = now - lastActivity;
+  if (OLED_OFF_AFTER_MS && idle >= OLED_OFF_AFTER_MS) setPanel(PanelState::Off);
+  else if (OLED_DIM_AFTER_MS && idle >= OLED_DIM_AFTER_MS) setPanel(PanelState::Dimmed);
+
+  bool drawn = false;
+  if (screenDirty) {
+    screenDirty = false;
+    enterScreen();
+    drawn = true;
+  }
+
+  // SoC history is kept whichever screen is up
+  if (ui.window && now - lastSocTrend >= SOC_TREND_INTERVAL) {
+    lastSocTrend = now;
+    uint8_t soc = ui.soc_percent <= 0.0f ? 0 : ui.soc_percent >= 100.0f ? 100 : (uint8_t)(ui.soc_percent + 0.5f);
+    if (socHistoryCount < OLED_WIDTH) {
+      socHistory[socHistoryCount++] = soc;
+    } else {
+      socHistory[socHistoryHead] = soc;
+      socHistoryHead = (socHistoryHead + 1) % OLED_WIDTH;
+    }
+    if (screen == Screen::SocTrend && panelState != PanelState::Off) {
+      socTrend.add(soc);
+      drawn = true;
     }
   }
+  // Dark panel: no drawing and no bus traffic until it wakes
+  if (panelState == PanelState::Off) return;
+
+  switch (screen) {
+    case Screen::Power:
+      if (OLED_TREND && inaPresent && now - lastTrend >= OLED_TREND_INTERVAL) {
+        lastTrend = now;
+        currentTrend.add(ui.current_A);
+        drawn = true;
+      }
+      page.set(FIELD_V, ui.bus_V);
+      page.set(FIELD_I, ui.current_A);
+      page.set(FIELD_P, ui.power_W);
+      page.set(FIELD_SOC, ui.soc_percent);
+      page.set(FIELD_SOH, ui.soh_percent);
+      drawn |= page.render();
+      break;
+    case Screen::SocTrend:
+      socPage.set(SOC_FIELD_SOC, ui.soc_percent);
+      socPage.set(SOC_FIELD_SIGMA, ui.soc_sigma_percent);
+      drawn |= socPage.render();
+      break;
+    case Screen::SocGauge:
+      drawn |= socGauge.setValue(ui.soc_percent / 100.0f);
+      socGaugePage.set(0, ui.soc_percent);
+      drawn |= socGaugePage.render();
+      break;
+    case Screen::Diagnostics:
+      if (!lastDiagScreen || now - lastDiagScreen >= DIAG_SCREEN_INTERVAL) {
+        lastDiagScreen = now;
+        diagPage.set(DIAG_RSSI, wifiManager.connected() ? WiFi.RSSI() : 0);
+        diagPage.set(DIAG_HEAP, ESP.getFreeHeap() / 1024.0f);
+        diagPage.set(DIAG_UPTIME, now / 3600000.0f);
+        diagPage.set(DIAG_QUEUED, queuedPages.load(std::memory_order_relaxed));
+        diagPage.set(DIAG_DROPPED, ui.outboxTimeouts);
+        diagPage.set(DIAG_SAMPLES, ui.rate_Hz);
+      }
+      drawn |= diagPage.render();
+      break;
+    default:
+      break;
+  }
+  framePending |= drawn;
+  if (framePending && now - lastFrame >= 1000UL / OLED_MAX_FPS) {
+    lastFrame = now;
+    framePending = false;
+    showFrame();
+  }
+}
+
+// Supervisor actions, run on its task while the watched one is stuck
+static void abortSockets() {
+  secureClient.abort();
+  int fd = plainClient.fd();
+  if (fd >= 0) shutdown(fd, SHUT_RDWR);
+}
+
+static void dropWifi() { esp_wifi_disconnect(); }
+
+static void checkpointBeforeReboot() {
+  uint32_t now = millis();
+  socCheckpoint.save(captureSocState(coulomb, sohEstimator, now), now);
+  energyMeter.save();
+}
+
+static void supervisorTask(void*) {
+  supervisor.begin(WATCHDOG_S, checkpointBeforeReboot);
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    supervisor.poll(millis());
+    protection.poll(millis());
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+  }
+}
+
+static void estimationTask(void*) {
+  supervisor.attach(estimationWatch);
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    supervisor.beat(estimationWatch);
+    estimationPass(millis(), pdMS_TO_TICKS(OUTBOX_BLOCK_MS));
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(ESTIMATION_PERIOD_MS));
+  }
+}
+
+static void uiTask(void*) {
+  supervisor.attach(uiWatch);
+  for (;;) {
+    supervisor.beat(uiWatch);
+    // Asleep until a button event or the next look at the data
+    ButtonEvent event;
+    if (button.wait(event, pdMS_TO_TICKS(UI_PERIOD_MS))) onButton(event);
+    uiPass(millis());
+  }
+}
+
+static void networkTask(void*) {
+  supervisor.attach(networkWatch);
+  for (;;) {
+    supervisor.beat(networkWatch);
+    networkPass(millis());
+    // Wake as soon as estimation hands something over, else poll the connection
+    outbox.front(pdMS_TO_TICKS(NETWORK_IDLE_MS));
+  }
+}
+
+// Moves the firmware from loop() onto the pinned tasks (see the task layout above).
+static void startTasks() {
+  estimationWatch = supervisor.add("estimation", ESTIMATION_TIMEOUT_MS, nullptr, nullptr);
+  uiWatch = supervisor.add("ui", UI_TIMEOUT_MS, nullptr, nullptr);
+  networkWatch = supervisor.add("network", NETWORK_TIMEOUT_MS, abortSockets, dropWifi);
+  bool ok = xTaskCreatePinnedToCore(estimationTask, "estimation", 6144, nullptr, ESTIMATION_PRIORITY, nullptr,
+                                    APP_CPU_NUM) == pdPASS &&
+            xTaskCreatePinnedToCore(uiTask, "ui", 4096, nullptr, UI_PRIORITY, nullptr, APP_CPU_NUM) == pdPASS &&
+            xTaskCreatePinnedToCore(networkTask, "network", 8192, nullptr, NETWORK_PRIORITY, nullptr,
+                                    PRO_CPU_NUM) == pdPASS &&
+            xTaskCreatePinnedToCore(supervisorTask, "supervisor", 4096, nullptr, SUPERVISOR_PRIORITY, nullptr,
+                                    PRO_CPU_NUM) == pdPASS;
+  if (!ok) {
+    Serial.println("Task start failed");
+    ESP.restart();
+  }
+  tasksRunning = true;
+}
+
+void loop() {
+  if (tasksRunning) {
+    vTaskDelete(nullptr);   // everything runs in the pinned tasks
+    return;
+  }
+  // Low-power mode: one pass of each in turn, then sleep
+  unsigned long now = millis();
+  networkPass(now);
+  estimationPass(now, 0);
+  ButtonEvent event;
+  if (button.wait(event, 0)) onButton(event);
+  uiPass(now);
+
+  // Radio off once the backlog is flushed (or the uplink ran out of time)
+  if (dutyCycle.uplinking() &&
+      ((mqttClient.connected() && flashQueue.empty() && !outbox.size()) || dutyCycle.uplinkExpired(now))) {
+    LOG_INFO("Uplink done; avg mA duty %.2f uplink %.2f", powerProfile.average_mA(PowerPhase::Duty),
+             powerProfile.average_mA(PowerPhase::Uplink));
+    mqttClient.disconnect();
+    wifiManager.radioOff();
+    dutyCycle.endUplink();
+  }
+  dutyCycle.sleep();
 }
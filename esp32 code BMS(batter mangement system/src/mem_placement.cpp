@@ -0,0 +1,55 @@
+#include "mem_placement.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+namespace {
+
+// Bytes placed so far, for the health report
+uint32_t placedPsram = 0;
+uint32_t placedInternal = 0;
+uint32_t fallbacks = 0;   // Bulk buffers that did not fit in PSRAM
+uint32_t failed = 0;
+
+}  // namespace
+
+// The core initialises PSRAM before setup() only when built with BOARD_HAS_PSRAM
+bool psramPresent() { return psramFound(); }
+
+void* placeAlloc(size_t bytes, MemRegion region) {
+  void* p = nullptr;
+  switch (region) {
+    case MemRegion::Dma:
+      p = heap_caps_malloc(bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+      break;
+    case MemRegion::Bulk:
+      if (psramPresent()) {
+        p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (p) {
+          placedPsram += bytes;
+          return p;
+        }
+        fallbacks++;
+      }
+      // fall through
+    case MemRegion::Internal:
+      p = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+      break;
+  }
+  if (p) placedInternal += bytes;
+  else failed++;
+  return p;
+}
+
+void writeMemoryJson(JsonWriter& w) {
+  w.beginObject("memory")
+      .field("psram", psramPresent())
+      .field("psram_free", (uint32_t)(psramPresent() ? heap_caps_get_free_size(MALLOC_CAP_SPIRAM) : 0))
+      .field("internal_free", (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL))
+      .field("dma_free", (uint32_t)heap_caps_get_free_size(MALLOC_CAP_DMA))
+      .field("placed_psram", placedPsram)
+      .field("placed_internal", placedInternal)
+      .field("fallbacks", fallbacks)
+      .field("failed", failed)
+      .endObject();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json_writer.h"
+
+// Where a long-lived buffer goes on boards with external PSRAM (WROVER;
+// build with -DBOARD_HAS_PSRAM). Internal SRAM is small and shared with
+// WiFi, lwIP and mbedTLS, so the large buffers that are only touched in
+// bulk by the CPU move out to PSRAM; anything a peripheral's DMA engine
+// reads stays inside, where DMA can reach it.
+//   Dma       internal, DMA-capable (SPI transfers)
+//   Internal  internal SRAM: latency-critical or touched from ISRs
+//   Bulk      PSRAM if present, else internal: capture history, staging
+// Without PSRAM, or when it is full, Bulk falls back to internal SRAM and
+// the fallback is counted. Allocations are made once during setup() and
+// never freed, so neither heap fragments.
+enum class MemRegion : uint8_t { Dma, Internal, Bulk };
+
+// bytes from region (nullptr if no heap can hold them), 4-byte aligned.
+void* placeAlloc(size_t bytes, MemRegion region);
+bool psramPresent();
+
+// "memory": {"psram", "psram_free", "internal_free", "dma_free",
+//            "placed_psram", "placed_internal", "fallbacks", "failed"}
+void writeMemoryJson(JsonWriter& w);
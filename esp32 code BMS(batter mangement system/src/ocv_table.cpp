@@ -0,0 +1,45 @@
+#include "ocv_table.h"
+
+// Rest voltages of typical cells; replace with a measured relaxation curve
+// (C/20 discharge with long rests) when one is available.
+
+// NMC / LiCoO2
+static constexpr OcvPoint LI_ION_POINTS[] = {
+  { 0, 3000 },   { 20, 3250 },  { 50, 3400 },   { 100, 3450 }, { 200, 3590 }, { 300, 3660 }, { 400, 3720 },
+  { 500, 3780 }, { 600, 3850 }, { 700, 3930 }, { 800, 4010 }, { 900, 4100 }, { 1000, 4200 },
+};
+
+// LiFePO4: steep at both ends, nearly flat from 20 to 90 %
+static constexpr OcvPoint LIFEPO4_POINTS[] = {
+  { 0, 2500 },   { 20, 2900 },  { 50, 3100 },  { 100, 3200 }, { 200, 3250 }, { 300, 3275 }, { 400, 3290 },
+  { 500, 3300 }, { 600, 3310 }, { 700, 3320 }, { 800, 3330 }, { 900, 3340 }, { 950, 3350 }, { 990, 3400 },
+  { 1000, 3600 },
+};
+
+static_assert(ocv_gen::increasing(LI_ION_POINTS, sizeof(LI_ION_POINTS) / sizeof(LI_ION_POINTS[0])),
+              "Li-ion OCV breakpoints must increase in SoC and voltage");
+static_assert(ocv_gen::spansFullRange(LI_ION_POINTS, sizeof(LI_ION_POINTS) / sizeof(LI_ION_POINTS[0])),
+              "Li-ion OCV breakpoints must cover 0..100 %");
+static_assert(ocv_gen::increasing(LIFEPO4_POINTS, sizeof(LIFEPO4_POINTS) / sizeof(LIFEPO4_POINTS[0])),
+              "LiFePO4 OCV breakpoints must increase in SoC and voltage");
+static_assert(ocv_gen::spansFullRange(LIFEPO4_POINTS, sizeof(LIFEPO4_POINTS) / sizeof(LIFEPO4_POINTS[0])),
+              "LiFePO4 OCV breakpoints must cover 0..100 %");
+
+// constexpr data lands in .rodata, i.e. flash on the ESP32
+static constexpr OcvTable LI_ION_TABLE = makeOcvTable(LI_ION_POINTS, "li-ion");
+static constexpr OcvTable LIFEPO4_TABLE = makeOcvTable(LIFEPO4_POINTS, "lifepo4");
+
+static_assert(LI_ION_TABLE.ocv_mV[0] == 3000 && LI_ION_TABLE.ocv_mV[OcvTable::OCV_INTERVALS] == 4200,
+              "grid ends on the breakpoints");
+static_assert(LIFEPO4_TABLE.soc[0] == 0 && LIFEPO4_TABLE.soc[OcvTable::SOC_INTERVALS] == 10000,
+              "inverse grid ends on the breakpoints");
+
+const OcvTable& ocvTable(Chemistry chemistry) {
+  switch (chemistry) {
+    case Chemistry::LiFePO4:
+      return LIFEPO4_TABLE;
+    case Chemistry::LiIon:
+    default:
+      return LI_ION_TABLE;
+  }
+}
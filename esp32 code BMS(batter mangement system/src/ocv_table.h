@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Open-circuit voltage against state of charge, per cell chemistry.
+//
+// Each curve is written as a handful of (SoC, mV) breakpoints
+// (ocv_table.cpp); constexpr code below resamples them at compile time onto
+// two uniform grids, so the tables are plain const data in flash and
+// nothing is computed at boot:
+//   ocv_mV[k]  OCV at SoC k / OCV_INTERVALS
+//   soc[k]     SoC (1/100 %) at min_mV + k * (max_mV - min_mV) / SOC_INTERVALS
+// The inverse grid is finer because flat curves (LiFePO4's plateau) pack
+// most of the SoC range into a few tens of mV.
+//
+// Evaluation is one multiply, a clamp (conditional moves, no branches), two
+// loads and a lerp, cheap enough to run per sample at 1 kHz; ocv_V() and
+// soc01() also return the local slope dOCV/dSoC, which the EKF needs.
+enum class Chemistry : uint8_t {
+  LiIon,     // NMC / LiCoO2, 3.0..4.2 V
+  LiFePO4,   // LFP, 2.5..3.6 V with a ~3.3 V plateau
+};
+
+struct OcvPoint {
+  uint16_t soc_permille;   // 0..1000, strictly increasing
+  uint16_t mV;             // strictly increasing
+};
+
+struct OcvTable {
+  static const uint16_t OCV_INTERVALS = 64;
+  static const uint16_t SOC_INTERVALS = 256;
+
+  uint16_t ocv_mV[OCV_INTERVALS + 1];
+  uint16_t soc[SOC_INTERVALS + 1];   // 1/100 %
+  uint16_t min_mV;
+  uint16_t max_mV;
+  float socGridPer_mV;   // SOC_INTERVALS / (max_mV - min_mV)
+  const char* name;
+
+  // OCV in V at soc (0..1, clamped); slope in V per unit SoC.
+  inline float ocv_V(float soc01, float& slope) const {
+    float pos = soc01 * OCV_INTERVALS;
+    pos = pos < 0.0f ? 0.0f : pos;
+    int i = (int)pos;
+    i = i > OCV_INTERVALS - 1 ? OCV_INTERVALS - 1 : i;
+    float a = ocv_mV[i], b = ocv_mV[i + 1];
+    slope = (b - a) * (OCV_INTERVALS * 1e-3f);
+    float frac = pos - i;
+    frac = frac > 1.0f ? 1.0f : frac;
+    return (a + (b - a) * frac) * 1e-3f;
+  }
+
+  // SoC (0..1) of a rested cell at ocv; slope as for ocv_V().
+  inline float soc01(float ocv, float& slope) const {
+    float pos = (ocv * 1000.0f - min_mV) * socGridPer_mV;
+    pos = pos < 0.0f ? 0.0f : pos;
+    int i = (int)pos;
+    i = i > SOC_INTERVALS - 1 ? SOC_INTERVALS - 1 : i;
+    float a = soc[i], b = soc[i + 1];
+    float frac = pos - i;
+    frac = frac > 1.0f ? 1.0f : frac;
+    // dSoC/dV over this cell of the grid, inverted; flat spots report 0.
+    float dSoc = (b - a) * 1e-4f;
+    slope = dSoc > 0.0f ? 1e-3f / (socGridPer_mV * dSoc) : 0.0f;
+    return (a + (b - a) * frac) * 1e-4f;
+  }
+};
+
+const OcvTable& ocvTable(Chemistry chemistry);
+
+// ---- compile-time generation (C++11 constexpr: one return per function) ----
+
+namespace ocv_gen {
+
+template <size_t... I> struct Indices {};
+template <size_t N, size_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <size_t... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+constexpr bool increasing(const OcvPoint* p, size_t n, size_t k = 1) {
+  return k >= n ? true
+                : (p[k].soc_permille > p[k - 1].soc_permille && p[k].mV > p[k - 1].mV && increasing(p, n, k + 1));
+}
+
+constexpr bool spansFullRange(const OcvPoint* p, size_t n) {
+  return n >= 2 && p[0].soc_permille == 0 && p[n - 1].soc_permille == 1000;
+}
+
+// Rounded linear interpolation of y over x at x = num / den.
+constexpr uint16_t lerp(int64_t x0, int64_t y0, int64_t x1, int64_t y1, int64_t num, int64_t den) {
+  return (uint16_t)(y0 + ((y1 - y0) * (num - x0 * den) * 2 + (x1 - x0) * den) / (2 * (x1 - x0) * den));
+}
+
+// mV at SoC permille num / den, searching from segment k.
+constexpr uint16_t mvAt(const OcvPoint* p, size_t n, size_t k, int32_t num, int32_t den) {
+  return (k + 2 >= n || (int32_t)p[k + 1].soc_permille * den >= num)
+             ? lerp(p[k].soc_permille, p[k].mV, p[k + 1].soc_permille, p[k + 1].mV, num, den)
+             : mvAt(p, n, k + 1, num, den);
+}
+
+// SoC in 1/100 % (permille * 10) at mV num / den, searching from segment k.
+constexpr uint16_t socAt(const OcvPoint* p, size_t n, size_t k, int32_t num, int32_t den) {
+  return (k + 2 >= n || (int32_t)p[k + 1].mV * den >= num)
+             ? lerp(p[k].mV, p[k].soc_permille * 10, p[k + 1].mV, p[k + 1].soc_permille * 10, num, den)
+             : socAt(p, n, k + 1, num, den);
+}
+
+template <size_t... I, size_t... J>
+constexpr OcvTable build(const OcvPoint* p, size_t n, const char* name, Indices<I...>, Indices<J...>) {
+  return OcvTable{
+    { mvAt(p, n, 0, (int32_t)(I * 1000), OcvTable::OCV_INTERVALS)... },
+    { socAt(p, n, 0, (int32_t)(p[0].mV * OcvTable::SOC_INTERVALS + J * (p[n - 1].mV - p[0].mV)),
+            OcvTable::SOC_INTERVALS)... },
+    p[0].mV,
+    p[n - 1].mV,
+    (float)OcvTable::SOC_INTERVALS / (p[n - 1].mV - p[0].mV),
+    name,
+  };
+}
+
+}  // namespace ocv_gen
+
+template <size_t N>
+constexpr OcvTable makeOcvTable(const OcvPoint (&points)[N], const char* name) {
+  return ocv_gen::build(points, N, name, typename ocv_gen::MakeIndices<OcvTable::OCV_INTERVALS + 1>::type(),
+                        typename ocv_gen::MakeIndices<OcvTable::SOC_INTERVALS + 1>::type());
+}
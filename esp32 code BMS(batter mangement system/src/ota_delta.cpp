@@ -0,0 +1,64 @@
+#include "ota_delta.h"
+
+static uint32_t getU32(const uint8_t* p) {
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void DeltaDecoder::begin(ReadFn read, WriteFn write, void* ctx, uint32_t sourceSize, uint32_t targetSize) {
+  _read = read;
+  _write = write;
+  _ctx = ctx;
+  _sourceSize = sourceSize;
+  _targetSize = targetSize;
+  _written = 0;
+  _headerLen = 0;
+  _literal = 0;
+  _failed = false;
+}
+
+bool DeltaDecoder::emit(const uint8_t* data, size_t len) {
+  if (len > _targetSize - _written || !_write(_ctx, data, len)) return false;
+  _written += len;
+  return true;
+}
+
+bool DeltaDecoder::copy(uint32_t src, uint32_t len) {
+  if (src > _sourceSize || len > _sourceSize - src) return false;
+  uint8_t block[COPY_BLOCK];
+  while (len) {
+    size_t n = len < COPY_BLOCK ? len : COPY_BLOCK;
+    if (!_read(_ctx, src, block, n) || !emit(block, n)) return false;
+    src += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool DeltaDecoder::feed(const uint8_t* data, size_t len) {
+  while (len && !_failed) {
+    if (_literal) {
+      size_t n = len < _literal ? len : _literal;
+      _failed = !emit(data, n);
+      _literal -= n;
+      data += n;
+      len -= n;
+      continue;
+    }
+    _header[_headerLen++] = *data++;
+    len--;
+    uint8_t op = _header[0];
+    uint8_t need = op == OP_COPY ? 9 : op == OP_LITERAL ? 5 : 0;
+    if (!need) {
+      _failed = true;   // unknown operation
+    } else if (_headerLen == need) {
+      _headerLen = 0;
+      if (op == OP_LITERAL) {
+        _literal = getU32(_header + 1);
+        _failed = _literal > _targetSize - _written;
+      } else {
+        _failed = !copy(getU32(_header + 1), getU32(_header + 5));
+      }
+    }
+  }
+  return !_failed;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming decoder for delta firmware images (server/ota_push.py builds
+// them). A patch is a sequence of operations that rebuild the new image
+// front to back from the running one:
+//   'C' u32 src, u32 len          copy len bytes of the running image at src
+//   'L' u32 len, len bytes        literal bytes
+// little-endian, nothing else. Operations may be split anywhere across
+// feed() calls: the decoder keeps at most one 9-byte header, literals go
+// straight through to write() and copies are read in COPY_BLOCK pieces,
+// so no part of either image is ever buffered.
+class DeltaDecoder {
+public:
+  typedef bool (*ReadFn)(void* ctx, uint32_t offset, uint8_t* buf, size_t len);
+  typedef bool (*WriteFn)(void* ctx, const uint8_t* data, size_t len);
+
+  static const size_t COPY_BLOCK = 256;
+  static const uint8_t OP_COPY = 'C';
+  static const uint8_t OP_LITERAL = 'L';
+
+  // sourceSize bounds the copies; targetSize bounds what is written.
+  void begin(ReadFn read, WriteFn write, void* ctx, uint32_t sourceSize, uint32_t targetSize);
+  // False on a malformed patch or an I/O failure; the decoder is then stuck.
+  bool feed(const uint8_t* data, size_t len);
+  // Between operations (a complete patch ends here).
+  bool idle() const { return !_failed && _headerLen == 0 && _literal == 0; }
+  bool failed() const { return _failed; }
+  uint32_t written() const { return _written; }
+
+private:
+  bool emit(const uint8_t* data, size_t len);
+  bool copy(uint32_t src, uint32_t len);
+
+  ReadFn _read = nullptr;
+  WriteFn _write = nullptr;
+  void* _ctx = nullptr;
+  uint32_t _sourceSize = 0;
+  uint32_t _targetSize = 0;
+  uint32_t _written = 0;
+  uint8_t _header[9];
+  uint8_t _headerLen = 0;
+  uint32_t _literal = 0;   // literal bytes still to come
+  bool _failed = false;
+};
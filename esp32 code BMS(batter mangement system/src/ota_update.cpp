@@ -0,0 +1,180 @@
+#include "ota_update.h"
+
+#include <esp_partition.h>
+
+#include "crc32.h"
+
+static const uint8_t MANIFEST_TAG = 'O';
+static const uint8_t MANIFEST_VERSION = 1;
+static const uint8_t FLAG_DELTA = 0x01;
+
+static const char* const STATE_NAMES[] = {"idle", "receiving", "ready", "failed"};
+static const char* const ERROR_NAMES[] = {"none",  "manifest", "no_partition", "too_large", "base_mismatch",
+                                          "flash", "patch",    "image_crc",    "verify"};
+
+static uint32_t getU32(const uint8_t* p) {
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool OtaUpdate::readRunning(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+  OtaUpdate* self = static_cast<OtaUpdate*>(ctx);
+  return esp_partition_read(self->_running, offset, buf, len) == ESP_OK;
+}
+
+bool OtaUpdate::writeImage(void* ctx, const uint8_t* data, size_t len) {
+  OtaUpdate* self = static_cast<OtaUpdate*>(ctx);
+  if (esp_ota_write(self->_handle, data, len) != ESP_OK) return false;
+  self->_crc = crc32Update(self->_crc, data, len);
+  return true;
+}
+
+bool OtaUpdate::runningCrcMatches(uint32_t size, uint32_t crc) const {
+  if (!_running || size > _running->size) return false;
+  uint8_t block[DeltaDecoder::COPY_BLOCK];
+  uint32_t c = CRC32_INIT;
+  for (uint32_t off = 0; off < size; off += sizeof(block)) {
+    size_t n = size - off < sizeof(block) ? size - off : sizeof(block);
+    if (esp_partition_read(_running, off, block, n) != ESP_OK) return false;
+    c = crc32Update(c, block, n);
+  }
+  return ~c == crc;
+}
+
+void OtaUpdate::onManifest(const uint8_t* msg, size_t len) {
+  _statusDue = true;
+  Manifest m;
+  if (len != MANIFEST_SIZE || msg[0] != MANIFEST_TAG || msg[1] != MANIFEST_VERSION) {
+    if (_state != OtaState::Receiving) fail(OtaError::Manifest);
+    return;
+  }
+  m.delta = msg[2] & FLAG_DELTA;
+  m.id = getU32(msg + 4);
+  m.imageSize = getU32(msg + 8);
+  m.imageCrc = getU32(msg + 12);
+  m.patchSize = getU32(msg + 16);
+  m.baseSize = getU32(msg + 20);
+  m.baseCrc = getU32(msg + 24);
+  m.chunkSize = msg[28] | msg[29] << 8;
+  // The same update again (sender restarted, or we reconnected): carry on from _next
+  if (_state == OtaState::Receiving && m.id == _m.id) return;
+  if (_state == OtaState::Ready && m.id == _m.id) return;
+
+  abort();
+  _m = m;
+  if (!m.imageSize || !m.patchSize || !m.chunkSize || (!m.delta && m.patchSize != m.imageSize)) {
+    fail(OtaError::Manifest);
+    return;
+  }
+  _running = esp_ota_get_running_partition();
+  _target = esp_ota_get_next_update_partition(nullptr);
+  if (!_running || !_target) {
+    fail(OtaError::NoPartition);
+    return;
+  }
+  if (m.imageSize > _target->size) {
+    fail(OtaError::TooLarge);
+    return;
+  }
+  if (m.delta && !runningCrcMatches(m.baseSize, m.baseCrc)) {
+    fail(OtaError::BaseMismatch);
+    return;
+  }
+  // Erases only what the image needs
+  if (esp_ota_begin(_target, m.imageSize, &_handle) != ESP_OK) {
+    fail(OtaError::Flash);
+    return;
+  }
+  _open = true;
+  _delta.begin(readRunning, writeImage, this, m.baseSize, m.imageSize);
+  _next = 0;
+  _crc = CRC32_INIT;
+  _resent = 0;
+  _error = OtaError::None;
+  _state = OtaState::Receiving;
+}
+
+void OtaUpdate::onChunk(const uint8_t* msg, size_t len) {
+  _statusDue = true;
+  if (_state != OtaState::Receiving || len <= CHUNK_HEADER_SIZE || getU32(msg) != _m.id) return;
+  uint32_t offset = getU32(msg + 4);
+  const uint8_t* data = msg + CHUNK_HEADER_SIZE;
+  size_t n = len - CHUNK_HEADER_SIZE;
+  // Anything but the chunk asked for, intact, is answered with the request again
+  if (offset != _next || n > _m.patchSize - _next || getU32(msg + 8) != crc32(data, n)) {
+    _resent++;
+    return;
+  }
+  bool ok = _m.delta ? _delta.feed(data, n) : writeImage(this, data, n);
+  if (!ok) {
+    fail(_m.delta && _delta.failed() ? OtaError::Patch : OtaError::Flash);
+    return;
+  }
+  _next += n;
+  if (_next == _m.patchSize) finish();
+}
+
+void OtaUpdate::onOversize(bool manifest) {
+  _statusDue = true;
+  if (manifest) {
+    if (_state != OtaState::Receiving) fail(OtaError::Manifest);
+  } else if (_state == OtaState::Receiving) {
+    _resent++;
+  }
+}
+
+void OtaUpdate::finish() {
+  uint32_t written = _m.delta ? _delta.written() : _next;
+  if ((_m.delta && !_delta.idle()) || written != _m.imageSize) {
+    fail(OtaError::Patch);
+    return;
+  }
+  if (~_crc != _m.imageCrc) {
+    fail(OtaError::ImageCrc);
+    return;
+  }
+  _open = false;
+  if (esp_ota_end(_handle) != ESP_OK || esp_ota_set_boot_partition(_target) != ESP_OK) {
+    fail(OtaError::Verify);
+    return;
+  }
+  _state = OtaState::Ready;
+}
+
+void OtaUpdate::abort() {
+  if (_open) esp_ota_abort(_handle);
+  _open = false;
+  _state = OtaState::Idle;
+}
+
+void OtaUpdate::fail(OtaError e) {
+  abort();
+  _state = OtaState::Failed;
+  _error = e;
+}
+
+bool OtaUpdate::statusDue(uint32_t now_ms) const {
+  return _statusDue || (_state == OtaState::Receiving && now_ms - _statusAt_ms >= REQUEST_RETRY_MS);
+}
+
+void OtaUpdate::writeStatus(JsonWriter& w) const {
+  uint16_t chunk = _m.chunkSize < _maxChunk ? _m.chunkSize : _maxChunk;
+  w.field("id", _m.id)
+      .field("state", STATE_NAMES[(uint8_t)_state])
+      .field("error", ERROR_NAMES[(uint8_t)_error])
+      .field("next", _next)
+      .field("size", _m.patchSize)
+      .field("chunk", (uint32_t)(chunk ? chunk : _maxChunk))
+      .field("resent", _resent);
+}
+
+void OtaUpdate::statusSent(uint32_t now_ms) {
+  _statusDue = false;
+  _statusAt_ms = now_ms;
+}
+
+void OtaUpdate::confirmRunningImage() {
+  static bool done = false;
+  if (done) return;
+  done = true;
+  esp_ota_mark_app_valid_cancel_rollback();
+}
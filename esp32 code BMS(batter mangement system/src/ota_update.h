@@ -0,0 +1,112 @@
+#pragma once
+
+#include <esp_ota_ops.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json_writer.h"
+#include "ota_delta.h"
+
+// Firmware update streamed over MQTT into the inactive OTA partition
+// (server/ota_push.py is the sending side).
+//
+// The device pulls: after a manifest, and after every chunk it accepts, its
+// status names the next patch offset it wants, and the sender publishes
+// exactly that chunk. Each chunk carries its offset and CRC; it is written
+// with esp_ota_write() as it arrives (through DeltaDecoder for delta
+// images), nothing is buffered, and a missing, repeated or corrupt chunk
+// just makes the device ask for the same offset again. A dropped
+// connection therefore resumes from the last verified chunk: the device
+// repeats its request on reconnect and every REQUEST_RETRY_MS. A reboot
+// starts the download over.
+//
+// Messages (little-endian):
+//   manifest  u8 'O', u8 version = 1, u8 flags (bit 0: delta), u8 0,
+//             u32 id, u32 image_size, u32 image_crc, u32 patch_size,
+//             u32 base_size, u32 base_crc, u16 chunk_size, u16 0   (32 bytes)
+//   chunk     u32 id, u32 offset, u32 crc of data, data (<= chunk size)
+// image_* describe the new firmware as it lands in flash; patch_size is
+// what is transferred (image_size for a full image). A delta is only
+// accepted when the CRC of the running partition's first base_size bytes
+// matches base_crc. The new partition is made bootable once the whole
+// image is written and its CRC and esp_ota_end()'s checks pass.
+//
+// Status (JSON): {"id", "state": "idle" | "receiving" | "ready" | "failed",
+// "error", "next", "size", "chunk", "resent"}.
+enum class OtaState : uint8_t { Idle, Receiving, Ready, Failed };
+
+enum class OtaError : uint8_t {
+  None,
+  Manifest,       // malformed or unsupported manifest
+  NoPartition,
+  TooLarge,
+  BaseMismatch,   // delta built against another firmware
+  Flash,
+  Patch,          // malformed delta
+  ImageCrc,
+  Verify,         // esp_ota_end() / set_boot_partition() refused it
+};
+
+class OtaUpdate {
+public:
+  static const size_t MANIFEST_SIZE = 32;
+  static const size_t CHUNK_HEADER_SIZE = 12;
+  static const uint32_t REQUEST_RETRY_MS = 5000;
+
+  // maxChunk: the largest chunk an inbound message can hold.
+  void begin(uint16_t maxChunk) { _maxChunk = maxChunk; }
+
+  // Message handlers (network task). Flash writes happen in here.
+  void onManifest(const uint8_t* msg, size_t len);
+  void onChunk(const uint8_t* msg, size_t len);
+  // A manifest or chunk too large to be read: answered like a malformed one
+  void onOversize(bool manifest);
+  void abort();
+
+  // A status is due after every message and, while waiting for a chunk,
+  // every REQUEST_RETRY_MS; requestStatus() forces one (e.g. on reconnect).
+  bool statusDue(uint32_t now_ms) const;
+  void requestStatus() { _statusDue = true; }
+  void writeStatus(JsonWriter& w) const;
+  void statusSent(uint32_t now_ms);
+
+  OtaState state() const { return _state; }
+  OtaError error() const { return _error; }
+
+  // Cancels the bootloader's rollback once the new firmware has proven
+  // itself (no-op unless rollback is enabled in the bootloader).
+  static void confirmRunningImage();
+
+private:
+  struct Manifest {
+    uint32_t id;
+    uint32_t imageSize;
+    uint32_t imageCrc;
+    uint32_t patchSize;
+    uint32_t baseSize;
+    uint32_t baseCrc;
+    uint16_t chunkSize;
+    bool delta;
+  };
+
+  static bool readRunning(void* ctx, uint32_t offset, uint8_t* buf, size_t len);
+  static bool writeImage(void* ctx, const uint8_t* data, size_t len);
+  bool runningCrcMatches(uint32_t size, uint32_t crc) const;
+  void fail(OtaError e);
+  void finish();
+
+  Manifest _m = {};
+  OtaState _state = OtaState::Idle;
+  OtaError _error = OtaError::None;
+  const esp_partition_t* _running = nullptr;
+  const esp_partition_t* _target = nullptr;
+  esp_ota_handle_t _handle = 0;
+  bool _open = false;           // _handle needs esp_ota_end() or abort
+  DeltaDecoder _delta;
+  uint32_t _next = 0;           // patch bytes verified and written
+  uint32_t _crc = 0;            // running CRC of the image written so far (crc32.h)
+  uint32_t _resent = 0;         // chunks that had to be asked for again
+  uint16_t _maxChunk = 0;
+  bool _statusDue = false;
+  uint32_t _statusAt_ms = 0;
+};
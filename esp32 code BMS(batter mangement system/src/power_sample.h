@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+// Kept free of Arduino headers: the processing core (coulomb counting,
+// aggregation, codecs) only depends on this and builds for [env:native].
+
+// One INA219 reading, stamped when acquisition started. Integer micro-units
+// straight from the register counts (Ina219Sample::*_uV/_uA/_uW); convert to
+// float only where a value is formatted for display or JSON.
+struct PowerSample {
+  uint32_t t_us;      // micros() at acquisition; wraps, always use unsigned deltas
+  int32_t shunt_uV;
+  int32_t bus_uV;
+  int32_t current_uA;   // positive = discharge
+  int32_t power_uW;
+  bool overflow;      // INA219 OVF: current/power out of range
+  uint16_t rate_Hz;   // acquisition rate in effect (0 = one-off read)
+};
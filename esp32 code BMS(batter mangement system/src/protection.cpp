@@ -0,0 +1,163 @@
+#include "protection.h"
+
+#include <esp_attr.h>
+
+namespace {
+
+// A latched trip's cause; survives a software or watchdog reset
+struct LatchNote {
+  uint32_t magic;
+  uint8_t cause;
+};
+const uint32_t LATCH_MAGIC = 0x50524F54;   // "PROT"
+RTC_NOINIT_ATTR LatchNote latchNote;
+
+const uint8_t VOLTAGE_CAUSES = PROTECT_UNDERVOLTAGE | PROTECT_OVERVOLTAGE;
+
+}  // namespace
+
+void Protection::begin(int cutoffPin, bool activeHigh, const ProtectionLimits& limits) {
+  _pin = cutoffPin;
+  _activeHigh = activeHigh;
+  _limits = limits;
+  if (_pin >= 0) pinMode(_pin, OUTPUT);
+  _enabled = true;
+  if (_limits.latch && latchNote.magic == LATCH_MAGIC && latchNote.cause) {
+    _cause.store(latchNote.cause, std::memory_order_relaxed);
+    drive(false);
+  } else {
+    latchNote.magic = 0;
+    drive(true);
+  }
+}
+
+void Protection::drive(bool closed) {
+  if (_pin >= 0) digitalWrite(_pin, closed == _activeHigh ? HIGH : LOW);
+}
+
+// Limits past which the sample is; once open, a limit counts as clear only
+// when the sample is back inside it by the hysteresis.
+uint8_t Protection::violations(const PowerSample& s, bool held) {
+  uint8_t v = 0;
+  if (_limits.overcurrent_uA) {
+    int32_t limit = _limits.overcurrent_uA - (held ? _limits.currentHysteresis_uA : 0);
+    int32_t i = s.current_uA < 0 ? -s.current_uA : s.current_uA;
+    if (s.overflow || i > limit) v |= PROTECT_OVERCURRENT;
+  }
+  if (_limits.undervoltage_uV && s.bus_uV < _limits.undervoltage_uV + (held ? _limits.voltageHysteresis_uV : 0)) {
+    v |= PROTECT_UNDERVOLTAGE;
+  }
+  if (_limits.overvoltage_uV && s.bus_uV > _limits.overvoltage_uV - (held ? _limits.voltageHysteresis_uV : 0)) {
+    v |= PROTECT_OVERVOLTAGE;
+  }
+  return v;
+}
+
+void Protection::check(const PowerSample& s) {
+  if (!_enabled) return;
+  uint32_t now_ms = millis();
+  _lastCheck_ms.store(now_ms ? now_ms : 1, std::memory_order_relaxed);
+
+  portENTER_CRITICAL(&_lock);
+  uint8_t held = _cause.load(std::memory_order_relaxed);
+  uint8_t v = violations(s, held != 0);
+  if (_manual.exchange(false, std::memory_order_relaxed)) v |= PROTECT_MANUAL;
+  if (!held) {
+    _resetRequested.store(false, std::memory_order_relaxed);   // nothing to reset
+    // A sagging load may dip below a voltage limit for a sample or two
+    if (v & VOLTAGE_CAUSES) {
+      if (_voltageRun < 255) _voltageRun++;
+      if (_voltageRun < _limits.voltageSamples) v &= ~VOLTAGE_CAUSES;
+    } else {
+      _voltageRun = 0;
+    }
+    if (v) open(v, s);
+  } else if (v) {
+    _clear = false;
+    if (v & ~held) open(v, s);   // further causes join the open trip
+  } else {
+    if (!_clear) {
+      _clear = true;
+      _clearSince_ms = now_ms;
+    }
+    bool needsReset = _limits.latch || (held & PROTECT_MANUAL);
+    // A reset is used up only by the sample that closes; one issued while the fault holds waits for it to clear
+    if (needsReset ? _resetRequested.exchange(false, std::memory_order_relaxed)
+                   : now_ms - _clearSince_ms >= _limits.release_ms) {
+      close(s);
+    }
+  }
+  portEXIT_CRITICAL(&_lock);
+
+  uint32_t path_us = micros() - s.t_us;
+  if (path_us > _maxPath_us) _maxPath_us = path_us;
+}
+
+void Protection::poll(uint32_t now_ms) {
+  if (!_enabled || !_limits.staleTimeout_ms) return;
+  uint32_t last = _lastCheck_ms.load(std::memory_order_relaxed);
+  if (!last || now_ms - last < _limits.staleTimeout_ms || (cause() & PROTECT_STALE)) return;
+  PowerSample s = {};
+  s.t_us = micros();
+  // open() and close() also run in check(), on the sampler task
+  portENTER_CRITICAL(&_lock);
+  if (!(cause() & PROTECT_STALE)) open(PROTECT_STALE, s);
+  portEXIT_CRITICAL(&_lock);
+}
+
+void Protection::open(uint8_t cause, const PowerSample& s) {
+  drive(false);
+  uint32_t latency_us = micros() - s.t_us;
+  uint8_t prev = _cause.fetch_or(cause, std::memory_order_relaxed);
+  _clear = false;
+  if (_limits.latch) {
+    latchNote.cause = prev | cause;
+    latchNote.magic = LATCH_MAGIC;
+  }
+  if (prev) {
+    record(prev | cause, s);
+    return;
+  }
+  _trips++;
+  _lastTripLatency_us = latency_us;
+  if (latency_us > _maxTripLatency_us) _maxTripLatency_us = latency_us;
+  record(cause, s);
+}
+
+void Protection::close(const PowerSample& s) {
+  _cause.store(0, std::memory_order_relaxed);
+  drive(true);
+  latchNote.magic = 0;
+  _voltageRun = 0;
+  _clear = false;
+  _releases++;
+  record(0, s);
+}
+
+void Protection::record(uint8_t cause, const PowerSample& s) {
+  Event e = { s.t_us, (uint32_t)(micros() - s.t_us), s.current_uA, s.bus_uV, cause };
+  if (!_events.push(e)) _eventsDropped++;
+}
+
+void Protection::writeCauses(JsonWriter& w, const char* key, uint8_t cause) {
+  static const char* const NAMES[] = { "overcurrent", "undervoltage", "overvoltage", "stale", "manual" };
+  w.beginArray(key);
+  for (uint8_t k = 0; k < sizeof(NAMES) / sizeof(NAMES[0]); ++k) {
+    if (cause & (1 << k)) w.value(NAMES[k]);
+  }
+  w.endArray();
+}
+
+void Protection::writeJson(JsonWriter& w) const {
+  uint8_t c = cause();
+  w.beginObject("protection").field("state", c ? "open" : "closed");
+  writeCauses(w, "cause", c);
+  w.field("latch", _limits.latch)
+      .field("trips", _trips)
+      .field("releases", _releases)
+      .field("last_trip_latency_us", _lastTripLatency_us)
+      .field("max_trip_latency_us", _maxTripLatency_us)
+      .field("max_path_us", _maxPath_us)
+      .field("events_dropped", _eventsDropped)
+      .endObject();
+}
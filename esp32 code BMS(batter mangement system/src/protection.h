@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "json_writer.h"
+#include "power_sample.h"
+#include "ring_buffer.h"
+
+// Why the cutoff opened (bits; several can hold at once).
+enum ProtectionCause : uint8_t {
+  PROTECT_OVERCURRENT = 1,    // |I| above the limit, or the shunt ADC overflowed
+  PROTECT_UNDERVOLTAGE = 2,
+  PROTECT_OVERVOLTAGE = 4,
+  PROTECT_STALE = 8,          // no sample checked for staleTimeout_ms
+  PROTECT_MANUAL = 16,        // trip() from the application
+};
+
+// Thresholds in the sample's own units (INA219 readings before the site
+// trim of RuntimeConfig, which is too slow-moving to matter here). A limit
+// of 0 is off.
+struct ProtectionLimits {
+  int32_t overcurrent_uA;         // either direction
+  int32_t undervoltage_uV;        // bus voltage
+  int32_t overvoltage_uV;
+  int32_t currentHysteresis_uA;   // how far back inside a limit counts as clear
+  int32_t voltageHysteresis_uV;
+  uint8_t voltageSamples;         // consecutive samples past a voltage limit (load sag)
+  uint32_t release_ms;            // clear this long before an unlatched cutoff closes
+  bool latch;                     // stay open until reset(), and across a software reset
+  uint32_t staleTimeout_ms;       // poll() opens the cutoff when sampling stops
+};
+
+// Overcurrent / undervoltage cutoff evaluated in the sampling task itself.
+//
+// check() runs right after every INA219 read, before the sample is queued,
+// and drives the cutoff GPIO on the spot: the sample-to-actuation latency
+// is the I2C burst plus a few compares, independent of the estimation,
+// network and UI tasks. Overcurrent trips on one sample; voltage limits
+// need voltageSamples in a row. Each read's path from acquisition to
+// decision is timed, so the bound is measured on every sample and not only
+// on the rare trip.
+//
+// Once open the cutoff stays open until every limit is clear by its
+// hysteresis: for release_ms when unlatched, and until reset() when latched.
+// A latched trip survives a software or watchdog reset (RTC memory), so a
+// crash loop cannot close the MOSFET again; a power cycle clears it.
+//
+// Trips and releases are queued as ProtectionEvents (multi-producer: the
+// sampler and the supervisor's stale check) for the network task to
+// publish. The two tasks open the cutoff under a spinlock; it covers a
+// handful of compares and the GPIO write.
+class Protection {
+public:
+  struct Event {
+    uint32_t t_us;         // acquisition time of the deciding sample
+    uint32_t latency_us;   // acquisition to GPIO write
+    int32_t current_uA;
+    int32_t bus_uV;
+    uint8_t cause;         // ProtectionCause bits; 0 for a release
+  };
+
+  // cutoffPin < 0: evaluate and record only. activeHigh: level that closes
+  // the path (MOSFET on). Opens at once if a latched trip survived a reset.
+  void begin(int cutoffPin, bool activeHigh, const ProtectionLimits& limits);
+  bool enabled() const { return _enabled; }
+
+  // Sampling task, once per fresh sample.
+  void check(const PowerSample& s);
+  // Supervisor task: fail-safe when check() has not run for staleTimeout_ms.
+  void poll(uint32_t now_ms);
+  // Any task. trip() opens at the next check() at the latest; reset()
+  // closes a latched cutoff at the next clear sample.
+  void trip() { _manual.store(true, std::memory_order_relaxed); }
+  void reset() { _resetRequested.store(true, std::memory_order_relaxed); }
+
+  bool tripped() const { return _cause.load(std::memory_order_relaxed) != 0; }
+  uint8_t cause() const { return _cause.load(std::memory_order_relaxed); }
+  bool takeEvent(Event& out) { return _events.pop(out); }
+
+  // "protection": {"state", "cause": [..], "latch", "trips", "releases",
+  // "last_trip_latency_us", "max_trip_latency_us", "max_path_us", "events_dropped"}
+  void writeJson(JsonWriter& w) const;
+  // The cause bits as a JSON array named key.
+  static void writeCauses(JsonWriter& w, const char* key, uint8_t cause);
+
+private:
+  uint8_t violations(const PowerSample& s, bool held);
+  void open(uint8_t cause, const PowerSample& s);
+  void close(const PowerSample& s);
+  void drive(bool closed);
+  void record(uint8_t cause, const PowerSample& s);
+
+  bool _enabled = false;
+  int _pin = -1;
+  bool _activeHigh = true;
+  ProtectionLimits _limits = {};
+
+  // check()'s decision and poll()'s stale trip, which share the state below
+  portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+  std::atomic<uint8_t> _cause{0};
+  std::atomic<bool> _manual{false};
+  std::atomic<bool> _resetRequested{false};
+  std::atomic<uint32_t> _lastCheck_ms{0};
+  uint8_t _voltageRun = 0;        // consecutive samples past a voltage limit
+  uint32_t _clearSince_ms = 0;
+  bool _clear = false;
+
+  MpscRing<Event, 8> _events;
+  uint32_t _trips = 0;
+  uint32_t _releases = 0;
+  uint32_t _eventsDropped = 0;
+  uint32_t _lastTripLatency_us = 0;
+  uint32_t _maxTripLatency_us = 0;
+  uint32_t _maxPath_us = 0;
+};
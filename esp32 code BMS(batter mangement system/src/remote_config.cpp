@@ -0,0 +1,248 @@
+#include "remote_config.h"
+
+#include <Preferences.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc32.h"
+
+static const char* NVS_NAMESPACE = "cfg";
+static const char* SLOT_KEYS[2] = {"a", "b"};
+static const uint32_t RECORD_MAGIC = 0x31474643;   // "CFG1", bump on layout change
+
+static const uint8_t WIRE_TAG = 'C';
+static const uint8_t WIRE_VERSION = 1;
+static const size_t WIRE_SIZE = 26;
+
+static const char* const MODE_NAMES[] = {"latest", "aggregate", "raw"};
+static const char* const ENCODING_NAMES[] = {"json", "binary", "both"};
+
+namespace {
+
+struct Record {
+  uint32_t magic;
+  uint32_t seq;
+  RuntimeConfig config;
+  uint32_t crc;   // CRC-32 of every byte before this field
+};
+
+uint32_t recordCrc(const Record& r) { return crc32((const uint8_t*)&r, offsetof(Record, crc)); }
+
+bool valid(const Record& r) {
+  return r.magic == RECORD_MAGIC && r.crc == recordCrc(r) && validateConfig(r.config) == ConfigError::None;
+}
+
+uint32_t getU32(const uint8_t* p) { return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+
+ConfigError parseBinary(const uint8_t* p, size_t len, RuntimeConfig& c) {
+  if (len != WIRE_SIZE || p[0] != WIRE_TAG) return ConfigError::Syntax;
+  if (p[1] != WIRE_VERSION) return ConfigError::Version;
+  if (getU32(p + WIRE_SIZE - 4) != crc32(p, WIRE_SIZE - 4)) return ConfigError::Crc;
+  if (p[2] > (uint8_t)PublishMode::RawBatch || p[3] > (uint8_t)TelemetryEncoding::Both) return ConfigError::BadValue;
+  c.publishMode = (PublishMode)p[2];
+  c.encoding = (TelemetryEncoding)p[3];
+  c.sampleRate_Hz = p[4] | (uint32_t)p[5] << 8;
+  c.publishInterval_ms = getU32(p + 6);
+  uint32_t bits = getU32(p + 10);
+  memcpy(&c.capacity_mAh, &bits, sizeof(bits));
+  c.currentTrim_ppm = (int32_t)getU32(p + 14);
+  c.currentOffset_uA = (int32_t)getU32(p + 18);
+  return ConfigError::None;
+}
+
+// Minimal reader for one flat JSON object of numbers and strings.
+class FlatJson {
+public:
+  FlatJson(const uint8_t* data, size_t len) : _p((const char*)data), _end((const char*)data + len) {}
+
+  bool begin() { return skip() && *_p++ == '{'; }
+  // Next key into key (truncated keys fail the lookup later); false at '}'.
+  bool nextKey(char* key, size_t cap, bool& error) {
+    error = true;
+    if (!skip()) return false;
+    if (*_p == '}') {
+      _p++;
+      error = skip();   // trailing bytes after the object
+      return false;
+    }
+    if (_count && *_p++ != ',') return false;
+    if (!skip() || !string(key, cap) || !skip() || *_p++ != ':') return false;
+    _count++;
+    error = false;
+    return true;
+  }
+  bool number(double& out) {
+    if (!skip()) return false;
+    char buf[24];
+    size_t n = 0;
+    while (_p < _end && n < sizeof(buf) - 1 && strchr("+-.0123456789eE", *_p)) buf[n++] = *_p++;
+    buf[n] = '\0';
+    char* stop;
+    out = strtod(buf, &stop);
+    return n && *stop == '\0' && isfinite(out);
+  }
+  bool string(char* out, size_t cap) {
+    if (!skip() || *_p != '"') return false;
+    _p++;
+    size_t n = 0;
+    while (_p < _end && *_p != '"') {
+      if (*_p == '\\') return false;   // no escapes in our keys or names
+      if (n < cap - 1) out[n++] = *_p;
+      _p++;
+    }
+    out[n] = '\0';
+    if (_p >= _end) return false;
+    _p++;
+    return true;
+  }
+
+private:
+  bool skip() {
+    while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) _p++;
+    return _p < _end;
+  }
+
+  const char* _p;
+  const char* _end;
+  uint8_t _count = 0;
+};
+
+bool integer(FlatJson& json, int64_t lo, int64_t hi, int64_t& out) {
+  double v;
+  if (!json.number(v) || v != floor(v) || v < lo || v > hi) return false;
+  out = (int64_t)v;
+  return true;
+}
+
+int8_t lookup(const char* name, const char* const* names, uint8_t count) {
+  for (uint8_t k = 0; k < count; ++k) {
+    if (strcmp(name, names[k]) == 0) return k;
+  }
+  return -1;
+}
+
+ConfigError parseJson(const uint8_t* data, size_t len, RuntimeConfig& c) {
+  FlatJson json(data, len);
+  if (!json.begin()) return ConfigError::Syntax;
+  char key[24];
+  bool error;
+  while (json.nextKey(key, sizeof(key), error)) {
+    int64_t i;
+    double d;
+    char name[16];
+    if (strcmp(key, "publish_ms") == 0) {
+      if (!integer(json, 0, UINT32_MAX, i)) return ConfigError::BadValue;
+      c.publishInterval_ms = (uint32_t)i;
+    } else if (strcmp(key, "rate_Hz") == 0) {
+      if (!integer(json, 0, UINT32_MAX, i)) return ConfigError::BadValue;
+      c.sampleRate_Hz = (uint32_t)i;
+    } else if (strcmp(key, "mode") == 0) {
+      int8_t k = json.string(name, sizeof(name)) ? lookup(name, MODE_NAMES, 3) : -1;
+      if (k < 0) return ConfigError::BadValue;
+      c.publishMode = (PublishMode)k;
+    } else if (strcmp(key, "encoding") == 0) {
+      int8_t k = json.string(name, sizeof(name)) ? lookup(name, ENCODING_NAMES, 3) : -1;
+      if (k < 0) return ConfigError::BadValue;
+      c.encoding = (TelemetryEncoding)k;
+    } else if (strcmp(key, "capacity_mAh") == 0) {
+      if (!json.number(d)) return ConfigError::BadValue;
+      c.capacity_mAh = (float)d;
+    } else if (strcmp(key, "current_trim_ppm") == 0) {
+      if (!integer(json, INT32_MIN, INT32_MAX, i)) return ConfigError::BadValue;
+      c.currentTrim_ppm = (int32_t)i;
+    } else if (strcmp(key, "current_offset_uA") == 0) {
+      if (!integer(json, INT32_MIN, INT32_MAX, i)) return ConfigError::BadValue;
+      c.currentOffset_uA = (int32_t)i;
+    } else {
+      return ConfigError::UnknownKey;
+    }
+  }
+  return error ? ConfigError::Syntax : ConfigError::None;
+}
+
+}  // namespace
+
+const char* configErrorName(ConfigError e) {
+  switch (e) {
+    case ConfigError::None: return "ok";
+    case ConfigError::Syntax: return "syntax";
+    case ConfigError::UnknownKey: return "unknown_key";
+    case ConfigError::BadValue: return "bad_value";
+    case ConfigError::Range: return "range";
+    case ConfigError::Version: return "version";
+    case ConfigError::Crc: return "crc";
+    case ConfigError::TooLarge: return "too_large";
+  }
+  return "?";
+}
+
+ConfigError validateConfig(const RuntimeConfig& c) {
+  typedef ConfigLimits L;
+  if (c.publishInterval_ms < L::MIN_PUBLISH_MS || c.publishInterval_ms > L::MAX_PUBLISH_MS) return ConfigError::Range;
+  if (c.sampleRate_Hz < L::MIN_RATE_HZ || c.sampleRate_Hz > L::MAX_RATE_HZ) return ConfigError::Range;
+  if ((uint8_t)c.publishMode > (uint8_t)PublishMode::RawBatch) return ConfigError::BadValue;
+  if ((uint8_t)c.encoding > (uint8_t)TelemetryEncoding::Both) return ConfigError::BadValue;
+  if (!(c.capacity_mAh >= L::MIN_CAPACITY_mAh && c.capacity_mAh <= L::MAX_CAPACITY_mAh)) return ConfigError::Range;
+  if (c.currentTrim_ppm < -L::MAX_TRIM_ppm || c.currentTrim_ppm > L::MAX_TRIM_ppm) return ConfigError::Range;
+  if (c.currentOffset_uA < -L::MAX_OFFSET_uA || c.currentOffset_uA > L::MAX_OFFSET_uA) return ConfigError::Range;
+  return ConfigError::None;
+}
+
+ConfigError parseConfig(const uint8_t* data, size_t len, const RuntimeConfig& base, RuntimeConfig& out) {
+  RuntimeConfig c = base;
+  size_t k = 0;
+  while (k < len && (data[k] == ' ' || data[k] == '\t' || data[k] == '\n' || data[k] == '\r')) k++;
+  ConfigError e = k < len && data[k] == '{' ? parseJson(data, len, c) : parseBinary(data, len, c);
+  if (e == ConfigError::None) e = validateConfig(c);
+  if (e == ConfigError::None) out = c;
+  return e;
+}
+
+void writeConfigJson(JsonWriter& w, const RuntimeConfig& c) {
+  w.field("publish_ms", c.publishInterval_ms)
+      .field("rate_Hz", c.sampleRate_Hz)
+      .field("mode", MODE_NAMES[(uint8_t)c.publishMode])
+      .field("encoding", ENCODING_NAMES[(uint8_t)c.encoding])
+      .field("capacity_mAh", c.capacity_mAh, 1)
+      .field("current_trim_ppm", c.currentTrim_ppm)
+      .field("current_offset_uA", c.currentOffset_uA);
+}
+
+bool ConfigStore::load(RuntimeConfig& out) {
+  Record slots[2];
+  bool ok[2] = {false, false};
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, true)) {
+    for (uint8_t k = 0; k < 2; ++k) {
+      ok[k] = prefs.getBytes(SLOT_KEYS[k], &slots[k], sizeof(Record)) == sizeof(Record) && valid(slots[k]);
+    }
+    prefs.end();
+  }
+  int8_t best = -1;
+  if (ok[0] && (!ok[1] || (int32_t)(slots[1].seq - slots[0].seq) <= 0)) best = 0;
+  else if (ok[1]) best = 1;
+  if (best < 0) return false;
+
+  _seq = slots[best].seq;
+  _nextSlot = best ^ 1;
+  out = slots[best].config;
+  return true;
+}
+
+bool ConfigStore::save(const RuntimeConfig& c) {
+  Record r;
+  memset(&r, 0, sizeof(r));   // deterministic padding for the CRC
+  r.magic = RECORD_MAGIC;
+  r.seq = _seq + 1;
+  r.config = c;
+  r.crc = recordCrc(r);
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return false;
+  size_t written = prefs.putBytes(SLOT_KEYS[_nextSlot], &r, sizeof(r));
+  prefs.end();
+  if (written != sizeof(r)) return false;
+  _seq = r.seq;
+  _nextSlot ^= 1;
+  return true;
+}
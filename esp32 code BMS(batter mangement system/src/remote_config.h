@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aggregator.h"
+#include "binary_codec.h"
+#include "json_writer.h"
+
+// Settings that can be changed over MQTT without a reflash. The values in
+// main.cpp are the defaults until a config document replaces them.
+struct RuntimeConfig {
+  uint32_t publishInterval_ms;   // aggregation window
+  uint32_t sampleRate_Hz;        // sampler (timer mode; the adaptive ceiling)
+  PublishMode publishMode;
+  TelemetryEncoding encoding;
+  float capacity_mAh;            // nominal capacity, 100 % SoH
+  int32_t currentTrim_ppm;       // current gain correction on top of the INA219 calibration
+  int32_t currentOffset_uA;      // added after the gain correction
+};
+
+enum class ConfigError : uint8_t {
+  None,
+  Syntax,       // not a JSON object / short binary record
+  UnknownKey,   // a typo must not pass silently
+  BadValue,     // wrong type or unknown enum name
+  Range,
+  Version,      // binary record of another layout
+  Crc,
+  TooLarge,     // more than the MQTT buffer holds; not read
+};
+
+const char* configErrorName(ConfigError e);
+
+// Limits a document must stay within; the sample rate is also bounded by
+// what one INA219 burst per period allows at 100 kHz I2C.
+struct ConfigLimits {
+  static const uint32_t MIN_PUBLISH_MS = 200;
+  static const uint32_t MAX_PUBLISH_MS = 3600000;
+  static const uint32_t MIN_RATE_HZ = 1;
+  static const uint32_t MAX_RATE_HZ = 400;
+  static constexpr float MIN_CAPACITY_mAh = 10.0f;
+  static constexpr float MAX_CAPACITY_mAh = 1000000.0f;
+  static const int32_t MAX_TRIM_ppm = 100000;      // +-10 %
+  static const int32_t MAX_OFFSET_uA = 100000;     // +-100 mA
+};
+
+ConfigError validateConfig(const RuntimeConfig& c);
+
+// Decodes a config document on top of base: a JSON object naming any subset
+// of the fields (the rest keep base's values),
+//   {"publish_ms": 2000, "rate_Hz": 50, "mode": "aggregate" | "latest" | "raw",
+//    "encoding": "json" | "binary" | "both", "capacity_mAh": 4200,
+//    "current_trim_ppm": 1500, "current_offset_uA": -200}
+// or the full binary record (anything not starting with '{' after blanks):
+//   u8 'C', u8 version = 1, u8 mode, u8 encoding, u16 rate_Hz, u32 publish_ms,
+//   f32 capacity_mAh, i32 trim_ppm, i32 offset_uA, u32 CRC-32 of the bytes
+//   before it; little-endian, 26 bytes.
+// out is written only when the whole document is valid.
+ConfigError parseConfig(const uint8_t* data, size_t len, const RuntimeConfig& base, RuntimeConfig& out);
+
+// The same keys as parseConfig() takes, inside the current object.
+void writeConfigJson(JsonWriter& w, const RuntimeConfig& c);
+
+// Double-buffered NVS copy of the active config: save() overwrites the
+// older of two CRC-protected slots, so a reset mid-write leaves the
+// previous config intact and load() picks the newest valid one.
+class ConfigStore {
+public:
+  // False if neither slot holds a valid config (out is untouched).
+  bool load(RuntimeConfig& out);
+  bool save(const RuntimeConfig& c);
+
+  uint32_t seq() const { return _seq; }
+
+private:
+  uint32_t _seq = 0;
+  uint8_t _nextSlot = 0;
+};
@@ -0,0 +1,58 @@
+#include "report_filter.h"
+
+void ReportFilter::begin(const float deadband[CHANNELS], uint32_t heartbeat_ms) {
+  for (uint8_t k = 0; k < CHANNELS; ++k) _deadband[k] = deadband[k] > 0.0f ? deadband[k] : 0.0f;
+  _heartbeat_ms = heartbeat_ms;
+  _primed = false;
+}
+
+uint8_t ReportFilter::index(ReportChannel channel) {
+  return (uint8_t)__builtin_ctz((unsigned)channel);
+}
+
+void ReportFilter::observe(ReportChannel channel, float lo, float hi, float value) {
+  uint8_t k = index(channel);
+  if (k >= CHANNELS) return;
+  // An empty window has no extremes (peak-hold sentinels)
+  if (!(lo <= hi)) lo = hi = value;
+  _lo[k] = lo < value ? lo : value;
+  _hi[k] = hi > value ? hi : value;
+  _value[k] = value;
+}
+
+uint8_t ReportFilter::decide(uint32_t now_ms) {
+  _windows++;
+  uint8_t mask = CHANNEL_ALL;
+  _heartbeat = !_primed || now_ms - _lastFull_ms >= _heartbeat_ms;
+  if (_enabled && !_heartbeat) {
+    mask = 0;
+    for (uint8_t k = 0; k < CHANNELS; ++k) {
+      float band = _deadband[k];
+      if (_hi[k] - _reported[k] > band || _reported[k] - _lo[k] > band) {
+        mask |= (uint8_t)(1 << k);
+      } else {
+        _suppressedChannels++;
+      }
+    }
+  }
+  if (mask == CHANNEL_ALL) {
+    _lastFull_ms = now_ms;
+    if (_heartbeat && _primed && _enabled) _heartbeats++;
+    _primed = true;
+  }
+  for (uint8_t k = 0; k < CHANNELS; ++k) {
+    if (mask & (1 << k)) _reported[k] = _value[k];
+  }
+  if (mask) _published++;
+  return mask;
+}
+
+void ReportFilter::writeJson(JsonWriter& w) const {
+  w.beginObject("rbe")
+      .field("heartbeat_ms", _heartbeat_ms)
+      .field("windows", _windows)
+      .field("published", _published)
+      .field("heartbeats", _heartbeats)
+      .field("suppressed_channels", _suppressedChannels)
+      .endObject();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "aggregator.h"
+#include "json_writer.h"
+
+// Report-by-exception for the periodic telemetry: a channel (ReportChannel
+// in aggregator.h) is reported only when it has moved beyond its deadband
+// since it was last reported, and a window in which nothing moved is not
+// published at all. Every heartbeat_ms at the latest all channels go out
+// anyway, so a consumer can tell a quiet pack from a silent one.
+//
+// A window's excursion is checked, not just its mean: a load step that
+// averages out within the window still counts as movement. The reference
+// only follows reported values, so a slow drift is reported once it has
+// added up to one deadband. Consumers forward-fill the channels a report
+// leaves out (the JSON carries "rbe": true).
+class ReportFilter {
+public:
+  static const uint8_t CHANNELS = 4;   // V, I, P, SoC, in bit order
+
+  // Deadbands in the payload's units (V, A, W, %); 0 reports every change.
+  void begin(const float deadband[CHANNELS], uint32_t heartbeat_ms);
+  void setEnabled(bool on) { _enabled = on; }
+  bool enabled() const { return _enabled; }
+  // The next window goes out in full (after a config change).
+  void forceFull() { _primed = false; }
+
+  // One channel of the window that just closed: its extremes and the value
+  // that would be reported. Call for every channel, then decide().
+  void observe(ReportChannel channel, float lo, float hi, float value);
+  // Channel mask to publish for this window, 0 to skip it. Everything
+  // when disabled, on the first window and on a heartbeat.
+  uint8_t decide(uint32_t now_ms);
+  bool heartbeat() const { return _heartbeat; }
+
+  // "rbe": {"heartbeat_ms", "windows", "published", "heartbeats", "suppressed_channels"}
+  void writeJson(JsonWriter& w) const;
+
+private:
+  static uint8_t index(ReportChannel channel);
+
+  bool _enabled = false;
+  float _deadband[CHANNELS] = {};
+  uint32_t _heartbeat_ms = 60000;
+
+  float _reported[CHANNELS] = {};
+  float _lo[CHANNELS] = {};
+  float _hi[CHANNELS] = {};
+  float _value[CHANNELS] = {};
+  bool _primed = false;
+  bool _heartbeat = false;
+  uint32_t _lastFull_ms = 0;
+
+  uint32_t _windows = 0;
+  uint32_t _published = 0;
+  uint32_t _heartbeats = 0;
+  uint32_t _suppressedChannels = 0;
+};
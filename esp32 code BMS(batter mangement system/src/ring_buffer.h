@@ -0,0 +1,178 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free ring buffers with compile-time capacity, the building block of
+// every hand-over between tasks (sampler -> estimation, the outbox in
+// task_queues.h, button events; the logger later). No critical sections,
+// no FreeRTOS calls: on the ESP32's Xtensa cores the loads and stores are
+// plain 32-bit accesses with barriers, and MpscRing's reservation is one
+// S32C1I compare-and-swap. Blocking, where needed, is layered on top
+// (BlockingQueue).
+//
+// Indices are free-running 32-bit counters, so a full ring holds all N
+// slots and the counters' own wraparound is harmless. The producer and
+// consumer indices sit on separate RING_CACHE_LINE-sized lines, each next
+// to a cached copy of the other side's index that is refreshed only when
+// the ring looks full (or empty), so the two cores rarely touch the same
+// line. Internal SRAM is not cached, but PSRAM and the native build are.
+// The alignment is honoured for static and member storage, which is how
+// the firmware allocates its rings.
+static const size_t RING_CACHE_LINE = 32;   // ESP32 cache line
+
+// Single producer, single consumer. push()/pushBulk() from one task (or
+// ISR), pop()/popBulk() from one other. slot()/commit() and
+// peek()/release() fill and drain in place, for elements too large to copy.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 1 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+  static const uint32_t MASK = N - 1;
+
+public:
+  bool push(const T& value) {
+    T* s = slot();
+    if (!s) return false;
+    *s = value;
+    commit();
+    return true;
+  }
+  // As many of values[0..n) as fit, published together; returns how many.
+  size_t pushBulk(const T* values, size_t n) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    size_t space = room(head, n);
+    if (n > space) n = space;
+    for (size_t k = 0; k < n; ++k) _buf[(head + k) & MASK] = values[k];
+    _head.store(head + n, std::memory_order_release);
+    return n;
+  }
+  // Producer, in place: the next free slot (nullptr if full), then commit().
+  T* slot() {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    return room(head, 1) ? &_buf[head & MASK] : nullptr;
+  }
+  void commit(size_t n = 1) { _head.store(_head.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+  bool pop(T& out) {
+    T* s = peek();
+    if (!s) return false;
+    out = *s;
+    release();
+    return true;
+  }
+  // Up to n of the oldest elements into out; returns how many.
+  size_t popBulk(T* out, size_t n) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    size_t avail = ready(tail, n);
+    if (n > avail) n = avail;
+    for (size_t k = 0; k < n; ++k) out[k] = _buf[(tail + k) & MASK];
+    _tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+  // Consumer, in place: the oldest element (nullptr if empty), then release().
+  T* peek() {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    return ready(tail, 1) ? &_buf[tail & MASK] : nullptr;
+  }
+  void release(size_t n = 1) { _tail.store(_tail.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+  // Exact from either side, a snapshot from anywhere else.
+  size_t size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  // Free slots, at least `want` if there are (re-reads the tail only then).
+  size_t room(uint32_t head, size_t want) {
+    if (N - (head - _tailCache) < want) _tailCache = _tail.load(std::memory_order_acquire);
+    return N - (head - _tailCache);
+  }
+  size_t ready(uint32_t tail, size_t want) {
+    if (_headCache - tail < want) _headCache = _head.load(std::memory_order_acquire);
+    return _headCache - tail;
+  }
+
+  T _buf[N];
+  alignas(RING_CACHE_LINE) std::atomic<uint32_t> _head{0};
+  uint32_t _tailCache = 0;   // producer's copy of _tail
+  alignas(RING_CACHE_LINE) std::atomic<uint32_t> _tail{0};
+  uint32_t _headCache = 0;   // consumer's copy of _head
+};
+
+// Multiple producers (tasks and ISRs, either core), one consumer. Each slot
+// carries a sequence number: a producer claims a position with a CAS on the
+// head, writes the slot and then publishes it through the sequence, so no
+// producer ever waits for another. One that is preempted between the two
+// only holds back the consumer, which sees the ring as empty up to that
+// slot until it is published.
+template <typename T, size_t N>
+class MpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscRing capacity must be a power of two");
+  static const uint32_t MASK = N - 1;
+
+public:
+  MpscRing() {
+    for (uint32_t k = 0; k < N; ++k) _slots[k].seq.store(k, std::memory_order_relaxed);
+  }
+
+  bool push(const T& value) { return pushBulk(&value, 1); }
+  // All of values[0..n) in consecutive positions, or nothing if they do not
+  // fit, so one producer's batch is never interleaved with another's.
+  bool pushBulk(const T* values, size_t n) {
+    if (n == 0) return true;
+    if (n > N) return false;
+    uint32_t pos = _head.load(std::memory_order_relaxed);
+    for (;;) {
+      // The consumer frees slots in order: if the last one is free, all are
+      uint32_t last = pos + n - 1;
+      int32_t lag = (int32_t)(_slots[last & MASK].seq.load(std::memory_order_acquire) - last);
+      if (lag < 0) return false;   // full
+      if (lag > 0) {
+        pos = _head.load(std::memory_order_relaxed);   // another producer got there first
+      } else if (_head.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t k = 0; k < n; ++k) {
+      Slot& s = _slots[(pos + k) & MASK];
+      s.value = values[k];
+      s.seq.store(pos + k + 1, std::memory_order_release);
+    }
+    return true;
+  }
+
+  bool pop(T& out) { return popBulk(&out, 1) == 1; }
+  // Up to n published elements into out, oldest first; returns how many.
+  size_t popBulk(T* out, size_t n) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    size_t k = 0;
+    for (; k < n; ++k) {
+      Slot& s = _slots[(tail + k) & MASK];
+      if (s.seq.load(std::memory_order_acquire) != tail + k + 1) break;
+      out[k] = s.value;
+      s.seq.store(tail + k + N, std::memory_order_release);
+    }
+    _tail.store(tail + k, std::memory_order_relaxed);
+    return k;
+  }
+
+  // Claimed positions not yet consumed (includes slots still being written).
+  size_t size() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> seq;   // position + 1 once written, + N once consumed
+    T value;
+  };
+
+  Slot _slots[N];
+  alignas(RING_CACHE_LINE) std::atomic<uint32_t> _head{0};
+  alignas(RING_CACHE_LINE) std::atomic<uint32_t> _tail{0};
+};
@@ -0,0 +1,242 @@
+#include "sampler.h"
+
+#include "adaptive_rate.h"
+#include "protection.h"
+
+bool Sampler::startTask(Adafruit_INA219* ina, BaseType_t core, UBaseType_t priority) {
+  if (!ina || _task) return false;
+  _ina = ina;
+  if (xTaskCreatePinnedToCore(taskEntry, "sampler", 4096, this, priority, &_task, core) != pdPASS) {
+    _task = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool Sampler::begin(Adafruit_INA219* ina, uint32_t rateHz, BaseType_t core, UBaseType_t priority) {
+  if (rateHz == 0 || !startTask(ina, core, priority)) return false;
+  _rateHz = rateHz;
+  _alertPin = -1;
+  _period_us = 1000000UL / rateHz;
+
+  esp_timer_create_args_t args = {};
+  args.callback = onTimer;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "sampler";
+  if (esp_timer_create(&args, &_timer) != ESP_OK) {
+    stop();
+    return false;
+  }
+  // esp_timer re-arms at alarm + period, so the grid holds from here on.
+  _nextDue_us = micros() + _period_us;
+  if (esp_timer_start_periodic(_timer, _period_us) != ESP_OK) {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+bool Sampler::beginOnAlert(Adafruit_INA219* ina, int alertPin, BaseType_t core, UBaseType_t priority) {
+  if (alertPin < 0 || !startTask(ina, core, priority)) return false;
+  uint32_t conversion_us = ina->conversionTime_us();
+  _rateHz = conversion_us ? 1000000UL / conversion_us : 0;
+  _period_us = conversion_us;
+  _alertPin = alertPin;
+  pinMode(alertPin, INPUT_PULLUP);
+  attachInterruptArg(alertPin, onAlert, this, FALLING);
+  return true;
+}
+
+void Sampler::stop() {
+  if (_alertPin >= 0) {
+    detachInterrupt(_alertPin);
+    _alertPin = -1;
+  }
+  if (_timer) {
+    esp_timer_stop(_timer);
+    esp_timer_delete(_timer);
+    _timer = nullptr;
+  }
+  if (_task) {
+    vTaskDelete(_task);
+    _task = nullptr;
+  }
+}
+
+// esp_timer task context: just wake the sampler.
+void Sampler::onTimer(void* arg) {
+  Sampler* self = static_cast<Sampler*>(arg);
+  xTaskNotifyGive(self->_task);
+}
+
+// GPIO ISR: stamp the conversion and wake the sampler, nothing else.
+void IRAM_ATTR Sampler::onAlert(void* arg) {
+  Sampler* self = static_cast<Sampler*>(arg);
+  self->_alertT_us = micros();
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(self->_task, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void Sampler::taskEntry(void* arg) { static_cast<Sampler*>(arg)->run(); }
+
+// One burst from a single conversion, so power matches V * I.
+bool Sampler::read(Adafruit_INA219* ina, PowerSample& s, uint32_t timeout_us) {
+  Ina219Sample raw;
+  s.t_us = micros();
+  if (!ina->readFresh(raw, timeout_us) || !raw.ready) return false;
+  convert(raw, s);
+  return true;
+}
+
+void Sampler::convert(const Ina219Sample& raw, PowerSample& s) {
+  s.shunt_uV = raw.shunt_uV;
+  s.bus_uV = raw.bus_uV;
+  s.current_uA = raw.current_uA;
+  s.power_uW = raw.power_uW;
+  s.overflow = raw.overflow;
+  s.rate_Hz = 0;
+}
+
+// Sampling task: switch the timer period when the policy asks for it.
+void Sampler::adapt(const PowerSample& s) {
+  uint32_t hz = _adaptive->update(s);
+  if (hz == 0 || hz == _rateHz) return;
+  retime(hz);
+}
+
+// Sampling task: restart the timer at hz, keeping the old period on failure.
+bool Sampler::retime(uint32_t hz) {
+  esp_timer_stop(_timer);
+  uint32_t period_us = 1000000UL / hz;
+  uint32_t start_us = micros();
+  if (esp_timer_start_periodic(_timer, period_us) != ESP_OK) {
+    // Keep sampling at the old rate rather than not at all
+    _nextDue_us = micros() + _period_us;
+    esp_timer_start_periodic(_timer, _period_us);
+    return false;
+  }
+  _nextDue_us = start_us + period_us;
+  _period_us = period_us;
+  _rateHz = hz;
+  _rateChanges++;
+  return true;
+}
+
+// Sampling task: one read's place in the schedule, see SamplerTiming.
+void Sampler::recordTiming(uint32_t due_us, uint32_t start_us, uint32_t ticks, const PowerSample* pushed) {
+  uint32_t read_us = micros() - start_us;
+  if (_maxReset) {
+    _maxReset = false;
+    _maxLate_us = 0;
+    _maxRead_us = 0;
+    _maxGap_us = 0;
+  }
+  int32_t early = (int32_t)(start_us - due_us);
+  uint32_t late_us = early > 0 ? (uint32_t)early : 0;
+  uint8_t bucket = late_us < 2 ? 0 : 31 - __builtin_clz(late_us);
+  if (bucket >= SamplerTiming::BUCKETS) bucket = SamplerTiming::BUCKETS - 1;
+  _late[bucket] = _late[bucket] + 1;
+  if (late_us > _maxLate_us) _maxLate_us = late_us;
+  if (read_us > _maxRead_us) _maxRead_us = read_us;
+  if (_period_us && read_us > _period_us) _overruns = _overruns + 1;
+  if (ticks > 1) _missed = _missed + (ticks - 1);
+  _reads = _reads + 1;
+  if (pushed) {
+    uint32_t gap_us = pushed->t_us - _lastPushT_us;
+    if (_pushedAny && gap_us > _maxGap_us) _maxGap_us = gap_us;
+    _lastPushT_us = pushed->t_us;
+    _pushedAny = true;
+  }
+}
+
+void Sampler::takeTiming(SamplerTiming& out) {
+  SamplerTiming now;
+  for (uint8_t b = 0; b < SamplerTiming::BUCKETS; ++b) now.late[b] = _late[b];
+  now.reads = _reads;
+  now.missed = _missed;
+  now.overruns = _overruns;
+  now.dropped = _dropped;
+  now.stale = _stale;
+  now.maxLate_us = _maxLate_us;
+  now.maxRead_us = _maxRead_us;
+  now.maxGap_us = _maxGap_us;
+  _maxReset = true;
+
+  for (uint8_t b = 0; b < SamplerTiming::BUCKETS; ++b) out.late[b] = now.late[b] - _taken.late[b];
+  out.reads = now.reads - _taken.reads;
+  out.missed = now.missed - _taken.missed;
+  out.overruns = now.overruns - _taken.overruns;
+  out.dropped = now.dropped - _taken.dropped;
+  out.stale = now.stale - _taken.stale;
+  out.maxLate_us = now.maxLate_us;
+  out.maxRead_us = now.maxRead_us;
+  out.maxGap_us = now.maxGap_us;
+  _taken = now;
+}
+
+void SamplerTiming::writeJson(JsonWriter& w) const {
+  uint8_t used = BUCKETS;
+  while (used && !late[used - 1]) used--;
+  w.beginObject("timing").field("reads", reads).beginArray("late_log2_us");
+  for (uint8_t b = 0; b < used; ++b) w.value((int32_t)late[b]);
+  w.endArray()
+      .field("late_max_us", maxLate_us)
+      .field("read_max_us", maxRead_us)
+      .field("gap_max_us", maxGap_us)
+      .field("missed", missed)
+      .field("overruns", overruns)
+      .field("dropped", dropped)
+      .field("stale", stale)
+      .endObject();
+}
+
+void Sampler::run() {
+  for (;;) {
+    // Ticks that arrive while a read is still running collapse into one;
+    // the count says how many there were.
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (_requestedHz && _alertPin < 0) {
+      uint32_t hz = _requestedHz;
+      _requestedHz = 0;
+      if (_adaptive) _adaptive->setMaxHz(hz);
+      // The adaptive policy applies its clamped rate after the next sample
+      if (!_adaptive && hz != _rateHz && retime(hz)) continue;
+    }
+
+    PowerSample s;
+    if (_alertPin >= 0) {
+      // The edge means a conversion just completed: no CNVR poll needed
+      Ina219Sample raw;
+      uint32_t start_us = micros();
+      s.t_us = _alertT_us;
+      bool pushed = false;
+      if (_ina->readAll(raw)) {
+        convert(raw, s);
+        s.rate_Hz = (uint16_t)_rateHz;
+        if (_protection) _protection->check(s);
+        pushed = _ring.push(s);
+        if (!pushed) _dropped = _dropped + 1;
+      } else {
+        _stale = _stale + 1;
+      }
+      recordTiming(s.t_us, start_us, ticks, pushed ? &s : nullptr);
+      continue;
+    }
+    // The latest grid point among the ticks just taken.
+    uint32_t due_us = _nextDue_us + (ticks - 1) * _period_us;
+    _nextDue_us = due_us + _period_us;
+    if (!read(_ina, s)) {
+      _stale = _stale + 1;
+      recordTiming(due_us, s.t_us, ticks, nullptr);
+      continue;
+    }
+    s.rate_Hz = (uint16_t)_rateHz;
+    if (_protection) _protection->check(s);
+    bool pushed = _ring.push(s);
+    if (!pushed) _dropped = _dropped + 1;
+    recordTiming(due_us, s.t_us, ticks, pushed ? &s : nullptr);
+    if (_adaptive) adapt(s);
+  }
+}
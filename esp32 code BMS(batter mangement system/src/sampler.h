@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_INA219.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+
+#include "json_writer.h"
+#include "power_sample.h"
+#include "ring_buffer.h"
+
+class AdaptiveRate;
+class Protection;
+
+// Schedule adherence of the sampling task over one reporting window.
+//
+// Lateness is how long after its scheduled instant a read started: the
+// timer grid (start + k * period) in timer mode, the ALERT edge otherwise.
+// A missed tick is one that fired while the previous read was still busy,
+// so no read ever served it; an overrun is a read (I2C burst included) that
+// took longer than the period. The longest gap between two consecutive
+// samples handed to loop() bounds the coulomb counter's error: a trapezoid
+// over that gap misses at most gap * |dI| / 2 of charge.
+struct SamplerTiming {
+  static const uint8_t BUCKETS = 16;   // log2 lateness, <2 us .. 32 ms+
+
+  uint32_t late[BUCKETS];
+  uint32_t reads;
+  uint32_t missed;
+  uint32_t overruns;
+  uint32_t dropped;    // ring to loop() full
+  uint32_t stale;      // no new conversion at the tick
+  uint32_t maxLate_us;
+  uint32_t maxRead_us;
+  uint32_t maxGap_us;
+
+  // "timing": {"reads", "late_log2_us": [..], "late_max_us", "read_max_us",
+  // "gap_max_us", "missed", "overruns", "dropped", "stale"}
+  void writeJson(JsonWriter& w) const;
+};
+
+// Fixed-rate INA219 acquisition in its own FreeRTOS task.
+//
+// A periodic esp_timer notifies the sampling task, which reads the sensor and
+// pushes the sample into an SPSC ring. The task is pinned to core 1 at a
+// priority above the Arduino loop() task, so TLS/MQTT work and display
+// refreshes in loop() cannot delay a read; loop() is the only consumer.
+// A tick only pushes a conversion the INA219 flags as new (CNVR), so a
+// timer running faster than the ADC never produces duplicate samples.
+//
+// With setProtection() every fresh sample goes through Protection::check()
+// before it is queued, so the cutoff reacts within the sampling task.
+//
+// With setAdaptive() the timer period follows an AdaptiveRate policy,
+// re-evaluated after every sample in the sampling task; each sample
+// carries the rate it was taken at (rate_Hz).
+//
+// beginOnAlert() replaces the timer with a conversion-complete interrupt
+// (the ALERT pin of a compatible INA part, or a board that routes CNVR to a
+// GPIO): the ISR only notifies the task, which then burst-reads the
+// registers, so between conversions there is no CPU or I2C activity and no
+// guessing at conversion timing.
+//
+// Note: at 100 kHz I2C one readAll() burst (four register reads) takes
+// ~2 ms, so rates above ~400 Hz need a faster bus (see setup()).
+class Sampler {
+public:
+  static const size_t RING_SIZE = 256;
+
+  bool begin(Adafruit_INA219* ina, uint32_t rateHz, BaseType_t core = 1, UBaseType_t priority = 5);
+  // Samples on every falling edge of alertPin (open drain, pulled up) at
+  // the INA's own conversion rate; rateHz() reports the nominal rate.
+  bool beginOnAlert(Adafruit_INA219* ina, int alertPin, BaseType_t core = 1, UBaseType_t priority = 5);
+  void stop();
+  // Timer mode only; the policy is called from the sampling task. Set
+  // before begin() or pass nullptr to keep the fixed rate.
+  void setAdaptive(AdaptiveRate* policy) { _adaptive = policy; }
+  // Set before begin(); nullptr (the default) runs without.
+  void setProtection(Protection* protection) { _protection = protection; }
+  // Timer mode, any task: switch to rateHz (the adaptive policy's ceiling
+  // when one is set) at the next tick. Ignored on ALERT.
+  void requestRate(uint32_t rateHz) { _requestedHz = rateHz; }
+
+  // Consumer side (one task only).
+  bool pop(PowerSample& out) { return _ring.pop(out); }
+  size_t popBulk(PowerSample* out, size_t max) { return _ring.popBulk(out, max); }
+  size_t pending() const { return _ring.size(); }
+
+  uint32_t rateHz() const { return _rateHz; }
+  // Timer period changes made by the adaptive policy.
+  uint32_t rateChanges() const { return _rateChanges; }
+  uint32_t dropped() const { return _dropped; }
+  // Ticks that found no new conversion (nothing was pushed).
+  uint32_t stale() const { return _stale; }
+  // Consumer side: fills out with what happened since the previous call
+  // and starts a new window. The counters only ever grow in the sampling
+  // task; windows are differences, so nothing is locked.
+  void takeTiming(SamplerTiming& out);
+
+  // Reads the next conversion no earlier read returned, waiting up to
+  // timeout_us for it (see Adafruit_INA219::readFresh). Returns false if
+  // there was none, so a conversion is never integrated twice.
+  static bool read(Adafruit_INA219* ina, PowerSample& out, uint32_t timeout_us = 0);
+
+private:
+  bool startTask(Adafruit_INA219* ina, BaseType_t core, UBaseType_t priority);
+  static void onTimer(void* arg);
+  static void IRAM_ATTR onAlert(void* arg);
+  static void taskEntry(void* arg);
+  void run();
+  static void convert(const Ina219Sample& raw, PowerSample& out);
+  void adapt(const PowerSample& s);
+  bool retime(uint32_t hz);
+  void recordTiming(uint32_t due_us, uint32_t start_us, uint32_t ticks, const PowerSample* pushed);
+
+  Adafruit_INA219* _ina = nullptr;
+  volatile uint32_t _rateHz = 0;
+  AdaptiveRate* _adaptive = nullptr;
+  Protection* _protection = nullptr;
+  volatile uint32_t _requestedHz = 0;  // requestRate(), taken by the task
+  uint32_t _rateChanges = 0;
+  esp_timer_handle_t _timer = nullptr;
+  int _alertPin = -1;                  // >= 0: interrupt-driven
+  volatile uint32_t _alertT_us = 0;    // micros() of the last alert edge
+  TaskHandle_t _task = nullptr;
+  SpscRing<PowerSample, RING_SIZE> _ring;
+  volatile uint32_t _dropped = 0;
+  volatile uint32_t _stale = 0;
+
+  // Schedule bookkeeping, written by the sampling task only.
+  uint32_t _period_us = 0;
+  uint32_t _nextDue_us = 0;            // timer mode: next grid point
+  uint32_t _lastPushT_us = 0;
+  bool _pushedAny = false;
+  volatile uint32_t _late[SamplerTiming::BUCKETS] = {};
+  volatile uint32_t _reads = 0;
+  volatile uint32_t _missed = 0;
+  volatile uint32_t _overruns = 0;
+  volatile uint32_t _maxLate_us = 0;
+  volatile uint32_t _maxRead_us = 0;
+  volatile uint32_t _maxGap_us = 0;
+  volatile bool _maxReset = false;     // set by takeTiming(), cleared by the task
+  // Consumer's copy of the counters at the last takeTiming()
+  SamplerTiming _taken = {};
+};
@@ -0,0 +1,51 @@
+#include "serial_stream.h"
+
+#include "crc32.h"
+
+namespace {
+
+inline void put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline void put32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+}  // namespace
+
+void SerialStream::encode(const PowerSample& s, uint32_t seq, uint8_t* out) {
+  out[0] = SYNC0;
+  out[1] = SYNC1;
+  out[2] = FRAME_VERSION;
+  out[3] = s.overflow ? 1 : 0;
+  put32(out + 4, seq);
+  put32(out + 8, s.t_us);
+  put32(out + 12, (uint32_t)s.shunt_uV);
+  put32(out + 16, (uint32_t)s.bus_uV);
+  put32(out + 20, (uint32_t)s.current_uA);
+  put32(out + 24, (uint32_t)s.power_uW);
+  put16(out + 28, s.rate_Hz);
+  put32(out + 30, crc32(out + 2, 28));
+}
+
+void SerialStream::add(const PowerSample& s) {
+  if (!_port) return;
+  if (_len + FRAME_SIZE > sizeof(_buf)) send();
+  encode(s, _seq++, _buf + _len);
+  _len += FRAME_SIZE;
+}
+
+void SerialStream::send() {
+  if (!_len) return;
+  // Whole frames only: a partial one would cost the host a resync
+  size_t room = (size_t)_port->availableForWrite() / FRAME_SIZE * FRAME_SIZE;
+  size_t n = room < _len ? room : _len;
+  if (n) _port->write(_buf, n);
+  _dropped += (uint32_t)((_len - n) / FRAME_SIZE);
+  _len = 0;
+}
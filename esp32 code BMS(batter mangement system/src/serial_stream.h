@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "power_sample.h"
+
+// Every sample as a binary frame on the USB serial port, for bench
+// characterization at the full conversion rate with no radio in the path
+// (LinkRole::SerialStream; host side: server/serial_capture.py).
+//
+// Frame, little-endian, FRAME_SIZE bytes:
+//   0  sync       0xA5 0x5A
+//   2  version    FRAME_VERSION
+//   3  flags      bit 0: INA219 overflow
+//   4  seq        uint32, +1 per frame whether or not it was sent
+//   8  t_us       uint32, micros() at acquisition
+//   12 shunt_uV, bus_uV, current_uA, power_uW   int32 each
+//   28 rate_Hz    uint16
+//   30 crc        CRC-32 (crc32.h) of bytes 2..29
+//
+// add() runs in the estimation task and only copies into a local buffer;
+// send() hands whole frames to the UART driver's TX ring as far as it has
+// room and drops the rest, so a slow or absent host never holds up
+// sampling. A dropped frame still takes its sequence number: the host
+// counts gaps in seq. Text on the same port (boot messages, core logs)
+// sits between frames and is skipped by the host's resync.
+class SerialStream {
+public:
+  static const uint8_t SYNC0 = 0xA5;
+  static const uint8_t SYNC1 = 0x5A;
+  static const uint8_t FRAME_VERSION = 1;
+  static const size_t FRAME_SIZE = 34;
+  static const size_t TX_BUFFER = 8192;   // for Serial.setTxBufferSize(), before Serial.begin()
+
+  void begin(HardwareSerial& port) { _port = &port; }
+
+  // Estimation task; sends itself once its buffer is full.
+  void add(const PowerSample& s);
+  // Estimation task, after each batch of add()s.
+  void send();
+
+  uint32_t frames() const { return _seq; }
+  uint32_t dropped() const { return _dropped; }
+
+  static void encode(const PowerSample& s, uint32_t seq, uint8_t* out);
+
+private:
+  static const size_t BATCH = 16;   // frames per write
+
+  HardwareSerial* _port = nullptr;
+  uint8_t _buf[BATCH * FRAME_SIZE];
+  size_t _len = 0;
+  uint32_t _seq = 0;
+  uint32_t _dropped = 0;
+};
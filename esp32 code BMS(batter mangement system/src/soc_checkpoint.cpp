@@ -0,0 +1,127 @@
+#include "soc_checkpoint.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "crc32.h"
+
+static const char* NVS_NAMESPACE = "soc";
+static const char* SLOT_KEYS[2] = {"a", "b"};
+static const uint32_t RECORD_MAGIC = 0x43534F32;   // "2OSC", bump on layout change
+
+namespace {
+
+struct Record {
+  uint32_t magic;
+  uint32_t seq;
+  int64_t consumed_uAs;
+  int64_t remaining_uAs;
+  int64_t capacity_uAs;
+  uint32_t t_ms;
+  SohState soh;
+  uint32_t crc;   // CRC-32 of every byte before this field
+};
+
+uint32_t recordCrc(const Record& r) { return crc32((const uint8_t*)&r, offsetof(Record, crc)); }
+
+bool valid(const Record& r) { return r.magic == RECORD_MAGIC && r.crc == recordCrc(r); }
+
+// Wrap-safe "a is newer than b".
+bool newer(const Record& a, const Record& b) { return (int32_t)(a.seq - b.seq) > 0; }
+
+Record makeRecord(const SocState& s, uint32_t seq) {
+  Record r;
+  memset(&r, 0, sizeof(r));   // deterministic padding for the CRC
+  r.magic = RECORD_MAGIC;
+  r.seq = seq;
+  r.consumed_uAs = s.consumed_uAs;
+  r.remaining_uAs = s.remaining_uAs;
+  r.capacity_uAs = s.capacity_uAs;
+  r.t_ms = s.t_ms;
+  r.soh = s.soh;
+  r.crc = recordCrc(r);
+  return r;
+}
+
+// Survives every reset except power loss; garbage after power-on fails the CRC.
+RTC_NOINIT_ATTR Record rtcRecord;
+
+}  // namespace
+
+SocState captureSocState(const CoulombCounter& c, const SohEstimator& soh, uint32_t t_ms) {
+  SocState s;
+  s.consumed_uAs = c.consumed_uAs();
+  s.remaining_uAs = c.remaining_uAs();
+  s.capacity_uAs = c.capacity_uAs();
+  s.t_ms = t_ms;
+  s.soh = soh.state();
+  return s;
+}
+
+void SocCheckpoint::setPolicy(int64_t minDelta_uAs, uint32_t interval_ms) {
+  _minDelta_uAs = minDelta_uAs;
+  _interval_ms = interval_ms;
+}
+
+bool SocCheckpoint::restore(SocState& out) {
+  Record slots[2];
+  bool ok[2] = {false, false};
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, true)) {
+    for (uint8_t k = 0; k < 2; ++k) {
+      ok[k] = prefs.getBytes(SLOT_KEYS[k], &slots[k], sizeof(Record)) == sizeof(Record) && valid(slots[k]);
+    }
+    prefs.end();
+  }
+
+  // Newest NVS slot; the other one is overwritten next
+  int8_t nvs = -1;
+  if (ok[0] && (!ok[1] || !newer(slots[1], slots[0]))) nvs = 0;
+  else if (ok[1]) nvs = 1;
+  _nextSlot = nvs == 0 ? 1 : 0;
+
+  const Record* best = nvs >= 0 ? &slots[nvs] : nullptr;
+  if (valid(rtcRecord) && (!best || newer(rtcRecord, *best))) best = &rtcRecord;
+  if (!best) return false;
+
+  _seq = best->seq;
+  _haveSaved = nvs >= 0;
+  _savedRemaining_uAs = _haveSaved ? slots[nvs].remaining_uAs : 0;
+  _savedAt_ms = 0;
+
+  out.consumed_uAs = best->consumed_uAs;
+  out.remaining_uAs = best->remaining_uAs;
+  out.capacity_uAs = best->capacity_uAs;
+  out.t_ms = best->t_ms;
+  out.soh = best->soh;
+  return true;
+}
+
+void SocCheckpoint::update(const SocState& s, uint32_t now_ms) {
+  rtcRecord = makeRecord(s, ++_seq);
+
+  int64_t delta = s.remaining_uAs - _savedRemaining_uAs;
+  if (delta < 0) delta = -delta;
+  if (!_haveSaved || delta >= _minDelta_uAs || (delta != 0 && now_ms - _savedAt_ms >= _interval_ms)) {
+    save(s, now_ms);
+  }
+}
+
+void SocCheckpoint::save(const SocState& s, uint32_t now_ms) {
+  Record r = makeRecord(s, ++_seq);
+  rtcRecord = r;
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return;
+  size_t written = prefs.putBytes(SLOT_KEYS[_nextSlot], &r, sizeof(r));
+  prefs.end();
+  if (written != sizeof(r)) return;
+
+  _nextSlot ^= 1;
+  _savedRemaining_uAs = s.remaining_uAs;
+  _savedAt_ms = now_ms;
+  _haveSaved = true;
+  _writes++;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "coulomb_counter.h"
+#include "soh_estimator.h"
+
+// Integrator state worth keeping across a reboot.
+struct SocState {
+  int64_t consumed_uAs;
+  int64_t remaining_uAs;
+  int64_t capacity_uAs;
+  uint32_t t_ms;        // uptime when the state was captured
+  SohState soh;         // capacity / resistance estimator
+};
+
+SocState captureSocState(const CoulombCounter& c, const SohEstimator& soh, uint32_t t_ms);
+
+// Low-wear persistence of SocState.
+//
+// Every update() refreshes a copy in RTC slow memory (free, survives
+// software/watchdog/brownout resets). Flash is only written when the charge
+// moved by minDelta or the interval elapsed, alternating between two
+// CRC-protected NVS slots so a reset mid-write always leaves the previous
+// checkpoint intact. restore() prefers the newest valid copy; it reads at
+// most two small NVS blobs, so it costs well under a millisecond at boot.
+class SocCheckpoint {
+public:
+  // Defaults: 0.5 mAh of charge moved, or 10 minutes.
+  void setPolicy(int64_t minDelta_uAs, uint32_t interval_ms);
+
+  // Returns false if neither RTC nor NVS holds a valid checkpoint.
+  bool restore(SocState& out);
+  void update(const SocState& s, uint32_t now_ms);
+  // Unconditional NVS write, e.g. before a planned restart.
+  void save(const SocState& s, uint32_t now_ms);
+
+  uint32_t writes() const { return _writes; }
+
+private:
+  int64_t _minDelta_uAs = CoulombCounter::UAS_PER_MAH / 2;
+  uint32_t _interval_ms = 600000;
+
+  uint32_t _seq = 0;          // sequence number of the newest record
+  uint8_t _nextSlot = 0;      // NVS slot the next save() overwrites
+  int64_t _savedRemaining_uAs = 0;
+  uint32_t _savedAt_ms = 0;
+  bool _haveSaved = false;
+  uint32_t _writes = 0;
+};
@@ -0,0 +1,109 @@
+#include "soc_ekf.h"
+
+#include <math.h>
+
+void SocEkf::begin(float capacity_mAh, float soc_percent, float sigma_percent) {
+  setCapacity_mAh(capacity_mAh);
+  if (_rV == 0.0f) setNoise(1.0f, 0.1f, 15.0f);
+  reset(soc_percent, sigma_percent);
+}
+
+void SocEkf::reset(float soc_percent, float sigma_percent) {
+  float soc = soc_percent * 0.01f;
+  _soc = soc < 0.0f ? 0.0f : (soc > 1.0f ? 1.0f : soc);
+  _socCarry = 0.0f;
+  _vrc = 0.0f;
+  float sigma = sigma_percent * 0.01f;
+  _p00 = sigma * sigma;
+  _p01 = 0.0f;
+  _p11 = 0.01f * 0.01f;   // polarization unknown to ~10 mV
+  _updates = 0;
+  _rejected = 0;
+  _primed = false;
+}
+
+void SocEkf::setCapacity_mAh(float capacity_mAh) {
+  _invCapacity_As = capacity_mAh > 0.0f ? 1.0f / (capacity_mAh * 3.6f) : 0.0f;
+}
+
+void SocEkf::setCircuit(float r0_ohm, float r1_ohm, float tau1_s) {
+  _r0 = r0_ohm;
+  _r1 = r1_ohm;
+  _tau = tau1_s > 0.0f ? tau1_s : 1.0f;
+  _invTau = 1.0f / _tau;
+}
+
+void SocEkf::setNoise(float socWalk_percentPerSqrtHour, float vrcWalk_mVPerSqrtS, float voltage_mV) {
+  float soc = socWalk_percentPerSqrtHour * 0.01f;
+  _qSoc = soc * soc / 3600.0f;
+  float vrc = vrcWalk_mVPerSqrtS * 1e-3f;
+  _qVrc = vrc * vrc;
+  float v = voltage_mV * 1e-3f;
+  _rV = v * v;
+}
+
+float SocEkf::sigma_percent() const { return sqrtf(_p00) * 100.0f; }
+
+float SocEkf::ocv_V() const {
+  float slope;
+  return _ocv->ocv_V(_soc, slope);
+}
+
+void SocEkf::update(uint32_t t_us, int32_t current_uA, int32_t cell_uV) {
+  float i_A = current_uA * 1e-6f;
+  if (!_primed) {
+    _primed = true;
+    _lastT_us = t_us;
+    _lastI_A = i_A;
+    return;
+  }
+  float dt = (uint32_t)(t_us - _lastT_us) * 1e-6f;
+  _lastT_us = t_us;
+  float iAvg = 0.5f * (i_A + _lastI_A);
+  _lastI_A = i_A;
+
+  // Predict. F = [[1, 0], [0, a]] with a = exp(-dt / tau); at sampler rates
+  // dt / tau is tiny and the second-order series is exact to float.
+  float x = dt * _invTau;
+  float a = x < 0.1f ? 1.0f - x * (1.0f - 0.5f * x) : expf(-x);
+  // At 100 Hz one step is ~1e-7 of capacity, about one float ulp of the SoC:
+  // the coulomb term is summed with Kahan compensation or most of it rounds away.
+  float dSoc = -iAvg * dt * _invCapacity_As - _socCarry;
+  float soc = _soc + dSoc;
+  _socCarry = (soc - _soc) - dSoc;
+  _soc = soc;
+  _vrc = a * _vrc + _r1 * (1.0f - a) * iAvg;
+  _p00 += _qSoc * dt;
+  _p01 *= a;
+  _p11 = a * a * _p11 + _qVrc * dt;
+
+  if (cell_uV > 0) {
+    // Update with the terminal voltage. H = [dOCV/dsoc, -1].
+    float h0;
+    float ocv = _ocv->ocv_V(_soc, h0);
+    float y = cell_uV * 1e-6f - (ocv - _vrc - _r0 * i_A);
+    float ph0 = _p00 * h0 - _p01;   // P H^T
+    float ph1 = _p01 * h0 - _p11;
+    float s = h0 * ph0 - ph1 + _rV;
+    if (y * y > GATE_SIGMA * GATE_SIGMA * s) {
+      _rejected++;
+    } else {
+      float invS = 1.0f / s;
+      float k0 = ph0 * invS;
+      float k1 = ph1 * invS;
+      _soc += k0 * y;
+      _vrc += k1 * y;
+      // P -= K (P H^T)^T, symmetric by construction
+      _p00 -= k0 * ph0;
+      _p01 -= k0 * ph1;
+      _p11 -= k1 * ph1;
+      _updates++;
+    }
+  }
+
+  if (_soc < 0.0f) _soc = 0.0f, _socCarry = 0.0f;
+  if (_soc > 1.0f) _soc = 1.0f, _socCarry = 0.0f;
+  // Rounding must not leave the covariance indefinite.
+  if (_p00 < 1e-10f) _p00 = 1e-10f;
+  if (_p11 < 1e-10f) _p11 = 1e-10f;
+}
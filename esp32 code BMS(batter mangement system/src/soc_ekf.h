@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ocv_table.h"
+
+// Extended Kalman filter for the state of charge of one cell, fusing
+// coulomb counting with the open-circuit voltage.
+//
+// Model: a 1-RC equivalent circuit,
+//   terminal V = OCV(soc) - v_rc - R0 * I
+//   soc'  = -I / capacity
+//   v_rc' = -v_rc / tau + I / C1        (tau = R1 * C1)
+// with positive current = discharge, as everywhere else. OCV(soc) comes
+// from the chemistry's OcvTable (ocv_table.h), Li-ion unless set.
+//
+// The state is two floats and the covariance a symmetric 2x2 kept as three;
+// update() is straight-line single-precision code with one division and no
+// allocation (expf only when dt exceeds a tenth of tau, i.e. not at sampler
+// rates), so it can run on every sample. Voltage readings whose innovation
+// is beyond GATE_SIGMA standard deviations are not fused (counted in
+// rejected()); the filter then coasts on the coulomb count until its
+// uncertainty grows enough to accept the voltage again.
+class SocEkf {
+public:
+  static constexpr float GATE_SIGMA = 4.0f;
+
+  // sigma_percent: uncertainty of the initial SoC (e.g. larger when it is
+  // only a guess, small when restored from a checkpoint).
+  void begin(float capacity_mAh, float soc_percent, float sigma_percent);
+  void reset(float soc_percent, float sigma_percent);
+  void setCapacity_mAh(float capacity_mAh);
+  // R0 series resistance, R1 || C1 polarization with time constant tau1_s.
+  void setCircuit(float r0_ohm, float r1_ohm, float tau1_s);
+  void setOcvTable(const OcvTable& table) { _ocv = &table; }
+  // socWalk: SoC random walk in % per sqrt(hour) (current sensor bias,
+  // capacity error); vrcWalk: polarization voltage walk in mV per sqrt(s);
+  // voltage: terminal voltage error in mV (ADC plus model error).
+  void setNoise(float socWalk_percentPerSqrtHour, float vrcWalk_mVPerSqrtS, float voltage_mV);
+
+  // One reading. cell_uV <= 0 means no usable voltage: predict only.
+  void update(uint32_t t_us, int32_t current_uA, int32_t cell_uV);
+
+  float soc_percent() const { return _soc * 100.0f; }
+  float sigma_percent() const;
+  float vrc_V() const { return _vrc; }
+  // OCV the model currently expects, in V.
+  float ocv_V() const;
+  // Inverse of the OCV table (0..1, clamped) for a rested cell, and the
+  // table's dOCV/dsoc there in V per unit SoC (how well the voltage pins it).
+  float socAtOcv(float ocv_V, float& slope) const { return _ocv->soc01(ocv_V, slope); }
+  uint32_t updates() const { return _updates; }
+  uint32_t rejected() const { return _rejected; }
+
+private:
+  const OcvTable* _ocv = &ocvTable(Chemistry::LiIon);
+
+  float _invCapacity_As = 0.0f;
+  float _r0 = 0.05f;
+  float _r1 = 0.02f;
+  float _tau = 30.0f;
+  float _invTau = 1.0f / 30.0f;
+
+  float _qSoc = 0.0f;   // per second
+  float _qVrc = 0.0f;   // per second
+  float _rV = 0.0f;
+
+  float _soc = 1.0f;        // 0..1
+  float _socCarry = 0.0f;   // Kahan compensation of the coulomb term
+  float _vrc = 0.0f;
+  float _p00 = 0.0f, _p01 = 0.0f, _p11 = 0.0f;
+
+  float _lastI_A = 0.0f;
+  uint32_t _lastT_us = 0;
+  uint32_t _updates = 0;
+  uint32_t _rejected = 0;
+  bool _primed = false;
+};
@@ -0,0 +1,123 @@
+#include "soh_estimator.h"
+
+#include <math.h>
+
+// Table error plus incomplete relaxation of a rested cell's voltage.
+static const float OCV_SIGMA_V = 0.015f;
+
+void SohEstimator::begin(const SocEkf& ocv, float nominal_mAh, float prior_mAh, float r0_ohm) {
+  _ocv = &ocv;
+  _nominal_mAh = nominal_mAh;
+  _capacity_mAh = prior_mAh > 0.0f ? prior_mAh : nominal_mAh;
+  float sigma = 0.3f * nominal_mAh;
+  _capacityVar = sigma * sigma;
+  _r0 = r0_ohm;
+  _r0Var = r0_ohm * r0_ohm;
+  _segments = 0;
+  _steps = 0;
+  _anchored = false;
+  _rest_us = 0;
+  _restUsed = false;
+  _primed = false;
+}
+
+void SohEstimator::restore(const SohState& s) {
+  if (!(s.capacity_mAh > 0.0f) || !(s.capacityVar > 0.0f) || !(s.r0Var > 0.0f)) return;
+  _capacity_mAh = s.capacity_mAh;
+  _capacityVar = s.capacityVar;
+  _r0 = s.r0_ohm;
+  _r0Var = s.r0Var;
+  _anchorConsumed_uAs = s.anchorConsumed_uAs;
+  _anchorSoc = s.anchorSoc;
+  _anchorSigma = s.anchorSigma;
+  _segments = s.segments;
+  _anchored = s.anchored;
+}
+
+SohState SohEstimator::state() const {
+  SohState s;
+  s.capacity_mAh = _capacity_mAh;
+  s.capacityVar = _capacityVar;
+  s.r0_ohm = _r0;
+  s.r0Var = _r0Var;
+  s.anchorConsumed_uAs = _anchorConsumed_uAs;
+  s.anchorSoc = _anchorSoc;
+  s.anchorSigma = _anchorSigma;
+  s.segments = _segments;
+  s.anchored = _anchored;
+  return s;
+}
+
+float SohEstimator::capacitySigma_mAh() const { return sqrtf(_capacityVar); }
+
+float SohEstimator::soh_percent() const {
+  if (_nominal_mAh <= 0.0f) return 100.0f;
+  return _capacity_mAh / _nominal_mAh * 100.0f;
+}
+
+void SohEstimator::add(uint32_t t_us, int32_t current_uA, int32_t cell_uV, int64_t consumed_uAs) {
+  if (!_primed) {
+    _primed = true;
+    _lastT_us = t_us;
+    _lastI_uA = current_uA;
+    _lastV_uV = cell_uV;
+    return;
+  }
+  uint32_t dt_us = t_us - _lastT_us;
+
+  // R0 from a current step: y = -dV, x = dI
+  int32_t dI_uA = current_uA - _lastI_uA;
+  if ((dI_uA >= STEP_CURRENT_uA || dI_uA <= -STEP_CURRENT_uA) && dt_us <= STEP_MAX_US && cell_uV > 0 &&
+      _lastV_uV > 0) {
+    float x = dI_uA * 1e-6f;
+    float y = (_lastV_uV - cell_uV) * 1e-6f;
+    float k = _r0Var * x / (x * x * _r0Var + 2.0f * VOLTAGE_SIGMA_V * VOLTAGE_SIGMA_V);
+    _r0 += k * (y - x * _r0);
+    _r0Var = (1.0f - k * x) * _r0Var / R0_FORGET;
+    if (_r0 < 0.0f) _r0 = 0.0f;
+    _steps++;
+  }
+  _lastT_us = t_us;
+  _lastI_uA = current_uA;
+  _lastV_uV = cell_uV;
+
+  // Rest detection, voltage smoothed over the rest (1/16 per sample)
+  if (current_uA < REST_CURRENT_uA && current_uA > -REST_CURRENT_uA && cell_uV > 0) {
+    if (_rest_us == 0) _restV_uV = cell_uV;
+    else _restV_uV += (cell_uV - _restV_uV) / 16;
+    _rest_us += dt_us;
+    if (resting()) anchor(consumed_uAs);
+  } else {
+    _rest_us = 0;
+    _restUsed = false;
+  }
+}
+
+void SohEstimator::anchor(int64_t consumed_uAs) {
+  float slope;
+  float soc = _ocv->socAtOcv(_restV_uV * 1e-6f, slope);
+  float sigma = slope > 0.01f ? OCV_SIGMA_V / slope : 1.0f;
+
+  if (!_restUsed) {
+    if (_anchored) {
+      float x = _anchorSoc - soc;   // SoC swing since the last anchor, positive on discharge
+      // Too small to say much: keep the older anchor so swings add up.
+      if (x < MIN_SEGMENT_SOC && x > -MIN_SEGMENT_SOC) return;
+      float y = (float)(consumed_uAs - _anchorConsumed_uAs) / 3.6e6f;   // mAh moved
+      float r = _capacity_mAh * _capacity_mAh * (_anchorSigma * _anchorSigma + sigma * sigma);
+      float k = _capacityVar * x / (x * x * _capacityVar + r);
+      _capacity_mAh += k * (y - x * _capacity_mAh);
+      _capacityVar = (1.0f - k * x) * _capacityVar / CAPACITY_FORGET;
+      // A wild segment (e.g. a reset coulomb counter) must not run away with it.
+      if (_capacity_mAh < 0.1f * _nominal_mAh) _capacity_mAh = 0.1f * _nominal_mAh;
+      if (_capacity_mAh > 2.0f * _nominal_mAh) _capacity_mAh = 2.0f * _nominal_mAh;
+      _segments++;
+    }
+    _restUsed = true;
+  }
+  // This rest owns the anchor: keep it at the latest, most relaxed reading.
+  _anchorConsumed_uAs = consumed_uAs;
+  _anchorSoc = soc;
+  _anchorSigma = sigma;
+  _anchored = true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "soc_ekf.h"
+
+// Estimator state worth keeping across a reboot (stored in the SoC
+// checkpoint, see soc_checkpoint.h).
+struct SohState {
+  float capacity_mAh;
+  float capacityVar;          // mAh^2
+  float r0_ohm;
+  float r0Var;                // ohm^2
+  int64_t anchorConsumed_uAs; // coulomb counter reading at the last rest anchor
+  float anchorSoc;            // SoC from the rested OCV there, 0..1
+  float anchorSigma;          // its standard deviation
+  uint16_t segments;          // capacity updates so far
+  bool anchored;
+};
+
+// Online capacity and internal resistance, so SoH follows the cell's aging
+// without a full offline cycle.
+//
+// Capacity: whenever the cell has rested (|I| under REST_CURRENT_uA for
+// REST_MS), its voltage is close to the OCV and the OCV table gives an
+// absolute SoC. Between two such anchors the coulomb counter knows the
+// charge moved, so each segment is one observation of
+//   charge_mAh = capacity_mAh * (soc_start - soc_end)
+// fused by scalar recursive least squares with a forgetting factor (old
+// segments fade as the cell ages), each weighted by how well the OCV
+// pinned its two ends (flat table regions count for little). Segments
+// under MIN_SEGMENT_SOC of swing are ignored.
+//
+// Resistance: a current step between two consecutive samples shows up at
+// once as dV = -R0 * dI (the RC branch and the OCV do not move within a
+// sample period), another scalar RLS.
+//
+// Everything is a few floats; add() is O(1) and does no allocation.
+class SohEstimator {
+public:
+  static const int32_t REST_CURRENT_uA = 20000;
+  static const uint32_t REST_MS = 20UL * 60 * 1000;
+  static constexpr float MIN_SEGMENT_SOC = 0.2f;
+  static constexpr float CAPACITY_FORGET = 0.95f;   // per segment
+  static const int32_t STEP_CURRENT_uA = 100000;   // smallest step used for R0
+  static const uint32_t STEP_MAX_US = 100000;       // samples further apart are not a step
+  static constexpr float R0_FORGET = 0.999f;        // per step
+  static constexpr float VOLTAGE_SIGMA_V = 0.008f;  // two INA219 bus LSBs
+
+  // nominal_mAh defines 100 % SoH; prior_mAh (<= 0: nominal) seeds the estimate.
+  void begin(const SocEkf& ocv, float nominal_mAh, float prior_mAh, float r0_ohm);
+  void restore(const SohState& s);
+  // Re-rates the cell (remote config): SoH is measured against the new value.
+  void setNominal_mAh(float nominal_mAh) { _nominal_mAh = nominal_mAh; }
+  SohState state() const;
+
+  // Every sample: consumed_uAs is CoulombCounter::consumed_uAs() after it.
+  void add(uint32_t t_us, int32_t current_uA, int32_t cell_uV, int64_t consumed_uAs);
+
+  float capacity_mAh() const { return _capacity_mAh; }
+  float capacitySigma_mAh() const;
+  float soh_percent() const;
+  float r0_ohm() const { return _r0; }
+  uint16_t segments() const { return _segments; }
+  uint32_t steps() const { return _steps; }
+  bool resting() const { return _rest_us >= (uint64_t)REST_MS * 1000; }
+
+private:
+  void anchor(int64_t consumed_uAs);
+
+  const SocEkf* _ocv = nullptr;
+  float _nominal_mAh = 0.0f;
+
+  float _capacity_mAh = 0.0f;
+  float _capacityVar = 0.0f;
+  float _r0 = 0.0f;
+  float _r0Var = 0.0f;
+  uint16_t _segments = 0;
+  uint32_t _steps = 0;
+
+  // Segment start
+  int64_t _anchorConsumed_uAs = 0;
+  float _anchorSoc = 0.0f;
+  float _anchorSigma = 0.0f;
+  bool _anchored = false;
+
+  // Rest detection
+  uint64_t _rest_us = 0;
+  int32_t _restV_uV = 0;   // smoothed cell voltage during the rest
+  bool _restUsed = false;  // this rest already closed a segment
+
+  int32_t _lastI_uA = 0;
+  int32_t _lastV_uV = 0;
+  uint32_t _lastT_us = 0;
+  bool _primed = false;
+};
@@ -0,0 +1,87 @@
+#include "status_leds.h"
+
+// Bar color below 20 %, below 50 %, and above
+static const uint32_t BAR_RGB[] = { 0xFF0000, 0xFF8000, 0x00FF00 };
+static const uint8_t BAR_LOW_PERCENT = 20;
+static const uint8_t BAR_MID_PERCENT = 50;
+// Idle, Charging, Discharging, Fault
+static const uint32_t STATE_RGB[] = { 0x404040, 0x0040FF, 0xFF8000, 0xFF0000 };
+
+// Scales each channel of 0xRRGGBB by level / 255.
+static uint32_t scaleRgb(uint32_t rgb, uint16_t level) {
+  uint32_t r = ((rgb >> 16) & 0xFF) * level / 255;
+  uint32_t g = ((rgb >> 8) & 0xFF) * level / 255;
+  uint32_t b = (rgb & 0xFF) * level / 255;
+  return (r << 16) | (g << 8) | b;
+}
+
+bool StatusLeds::begin(int16_t pin, uint16_t count, uint8_t brightness, uint32_t minFrame_ms, BaseType_t core,
+                       UBaseType_t priority) {
+  if (_task || pin < 0 || count < 2) return false;
+  _barLen = count - 1;
+  _minFrame_ms = minFrame_ms;
+  for (uint8_t c = 0; c < BAR_COLORS; ++c) {
+    for (uint8_t l = 0; l <= LEVELS_PER_LED; ++l) {
+      _bar[c][l] = Adafruit_NeoPixel::gamma32(scaleRgb(BAR_RGB[c], (uint16_t)brightness * l / LEVELS_PER_LED));
+    }
+  }
+  for (uint8_t s = 0; s < STATES; ++s) _state[s] = Adafruit_NeoPixel::gamma32(scaleRgb(STATE_RGB[s], brightness));
+
+  _strip = new Adafruit_NeoPixel(count, pin, NEO_GRB + NEO_KHZ800);
+  if (!_strip->begin() ||
+      xTaskCreatePinnedToCore(taskEntry, "leds", 2048, this, priority, &_task, core) != pdPASS) {
+    delete _strip;
+    _strip = nullptr;
+    _task = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void StatusLeds::update(float soc_percent, int32_t current_uA, bool overflow) {
+  if (!_task) return;
+  uint32_t steps = (uint32_t)_barLen * LEVELS_PER_LED;
+  float pos = soc_percent * steps / 100.0f + 0.5f;
+  uint16_t bucket = pos <= 0.0f ? 0 : pos >= steps ? steps : (uint16_t)pos;
+  ChargeState state = overflow                  ? ChargeState::Fault
+                      : current_uA < -_idle_uA ? ChargeState::Charging
+                      : current_uA > _idle_uA  ? ChargeState::Discharging
+                                               : ChargeState::Idle;
+  uint32_t key = ((uint32_t)state << 16) | bucket;
+  if (key == _posted) return;
+  _posted = key;
+  xTaskNotify(_task, key, eSetValueWithOverwrite);
+}
+
+void StatusLeds::taskEntry(void* arg) { static_cast<StatusLeds*>(arg)->run(); }
+
+// LED task: one frame per posted change, no more than one per _minFrame_ms;
+// changes posted while it waits are coalesced into the newest.
+void StatusLeds::run() {
+  TickType_t lastFrame = xTaskGetTickCount() - pdMS_TO_TICKS(_minFrame_ms);
+  uint32_t key;
+  for (;;) {
+    xTaskNotifyWait(0, 0, &key, portMAX_DELAY);
+    TickType_t since = xTaskGetTickCount() - lastFrame;
+    if (since < pdMS_TO_TICKS(_minFrame_ms)) {
+      vTaskDelay(pdMS_TO_TICKS(_minFrame_ms) - since);
+      xTaskNotifyWait(0, 0, &key, 0);
+    }
+    lastFrame = xTaskGetTickCount();
+    render((uint16_t)key, (ChargeState)(key >> 16));
+  }
+}
+
+void StatusLeds::render(uint16_t bucket, ChargeState state) {
+  uint16_t soc_percent = (uint32_t)bucket * 100 / ((uint32_t)_barLen * LEVELS_PER_LED);
+  uint8_t c = soc_percent < BAR_LOW_PERCENT ? 0 : soc_percent < BAR_MID_PERCENT ? 1 : 2;
+  uint16_t full = bucket / LEVELS_PER_LED;
+  for (uint16_t i = 0; i < _barLen; ++i) {
+    uint8_t level = i < full ? LEVELS_PER_LED : i == full ? bucket % LEVELS_PER_LED : 0;
+    _strip->setPixelColor(i, _bar[c][level]);
+  }
+  _strip->setPixelColor(_barLen, _state[(uint8_t)state]);
+  // Waits only if the previous frame is still going out (a few hundred µs)
+  _strip->showAsync();
+  _frames++;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+
+enum class ChargeState : uint8_t { Idle, Charging, Discharging, Fault };
+
+// NeoPixel SoC bar plus one charge-state pixel at the far end.
+//
+// update() runs on every sample but only works out which SoC bucket
+// (LEVELS_PER_LED steps per LED, the top LED dimmed in between) and state
+// the reading falls in; nothing else happens unless one of them changed.
+// A change is posted to a small task pinned to another core than the
+// sampler, which redraws at most once per minFrame_ms and sends the frame
+// with showAsync(). The RMT channel is installed from that task, so its
+// refill interrupt also runs there and the sampler core sees no LED work.
+//
+// Colors are gamma corrected (gamma32) at their final brightness once in
+// begin(); a redraw is table lookups only.
+class StatusLeds {
+public:
+  static const uint8_t LEVELS_PER_LED = 4;
+
+  // count includes the state pixel (>= 2). brightness scales every color.
+  bool begin(int16_t pin, uint16_t count, uint8_t brightness, uint32_t minFrame_ms, BaseType_t core = 0,
+             UBaseType_t priority = 1);
+  // Sign convention follows the INA219 wiring: positive current = discharge.
+  void setIdleThreshold_mA(float mA) { _idle_uA = (int32_t)(mA * 1000.0f); }
+
+  void update(float soc_percent, int32_t current_uA, bool overflow);
+
+  uint32_t frames() const { return _frames; }
+
+private:
+  static const uint8_t BAR_COLORS = 3;   // low, mid, high SoC
+  static const uint8_t STATES = 4;
+
+  static void taskEntry(void* arg);
+  void run();
+  void render(uint16_t bucket, ChargeState state);
+
+  Adafruit_NeoPixel* _strip = nullptr;
+  TaskHandle_t _task = nullptr;
+  uint16_t _barLen = 0;
+  uint32_t _minFrame_ms = 0;
+  int32_t _idle_uA = 20000;
+  uint32_t _posted = UINT32_MAX;   // last (state << 16 | bucket) handed to the task
+  volatile uint32_t _frames = 0;
+  uint32_t _bar[BAR_COLORS][LEVELS_PER_LED + 1] = {};
+  uint32_t _state[STATES] = {};
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <limits>
+
+// Single-pass accumulators for per-sample statistics: O(1) state, no
+// buffers, a handful of instructions per add(). Each comes in a float
+// flavour and a fixed-point one for the integer micro-units of PowerSample
+// (int32_t), which never rounds while accumulating.
+
+// Min/max of everything added since reset().
+template <typename T> struct PeakHold {
+  T min = std::numeric_limits<T>::max();
+  T max = std::numeric_limits<T>::lowest();
+
+  void reset() { *this = PeakHold(); }
+  void add(T x) {
+    if (x < min) min = x;
+    if (x > max) max = x;
+  }
+  bool empty() const { return max < min; }
+};
+
+// Weighted mean and variance, Welford / West update: the running mean is
+// corrected by each sample's deviation instead of summing x and x^2, so the
+// variance does not cancel away however long the window or large the
+// offset. Population variance (weights are the time each sample stands for).
+template <typename T> class Welford {
+public:
+  void reset() { *this = Welford(); }
+  void add(T x, T w = 1) {
+    _n++;
+    _weight += w;
+    T delta = x - _mean;
+    _mean += delta * w / _weight;
+    _m2 += w * delta * (x - _mean);
+  }
+
+  uint32_t count() const { return _n; }
+  T weight() const { return _weight; }
+  T mean() const { return _mean; }
+  T variance() const { return _weight > 0 ? _m2 / _weight : 0; }
+  T stddev() const { return sqrtf(variance()); }
+  // sqrt(E[x^2]) = sqrt(mean^2 + variance)
+  T rms() const { return sqrtf(_mean * _mean + variance()); }
+
+private:
+  uint32_t _n = 0;
+  T _weight = 0;
+  T _mean = 0;
+  T _m2 = 0;
+};
+
+// Fixed point: exact integer sums of the deviation from the first sample
+// (the shifted-data form of Welford), so add() is two 64-bit multiply-adds
+// and no division. Weights are small integers (e.g. samples a reading
+// stands for). Exact while weight * deviation^2 summed stays under 2^63,
+// e.g. 9e6 samples at a 1 A spread in uA; results come out in float.
+template <> class Welford<int32_t> {
+public:
+  void reset() { *this = Welford(); }
+  void add(int32_t x, uint32_t w = 1) {
+    if (!_n) _shift = x;
+    _n++;
+    _weight += w;
+    int64_t d = (int64_t)x - _shift;
+    _sum += (int64_t)w * d;
+    _sumSq += (int64_t)w * d * d;
+  }
+
+  uint32_t count() const { return _n; }
+  uint64_t weight() const { return _weight; }
+  float mean() const { return _weight ? (float)(_shift + (double)_sum / _weight) : 0.0f; }
+  float variance() const {
+    if (!_weight) return 0.0f;
+    double m = (double)_sum / _weight;
+    double v = (double)_sumSq / _weight - m * m;
+    return v > 0.0 ? (float)v : 0.0f;
+  }
+  float stddev() const { return sqrtf(variance()); }
+  float rms() const {
+    float m = mean();
+    return sqrtf(m * m + variance());
+  }
+
+private:
+  uint32_t _n = 0;
+  uint64_t _weight = 0;
+  int32_t _shift = 0;
+  int64_t _sum = 0;     // sum of w * (x - shift)
+  int64_t _sumSq = 0;   // sum of w * (x - shift)^2
+};
+
+// Exponentially weighted moving average with alpha = 2^-SHIFT (time
+// constant ~2^SHIFT samples). The first sample seeds it.
+template <typename T, uint8_t SHIFT> class Ewma {
+public:
+  void reset() { _primed = false; }
+  void add(T x) {
+    _value = _primed ? _value + (x - _value) * (T(1) / T(1UL << SHIFT)) : x;
+    _primed = true;
+  }
+  T value() const { return _value; }
+
+private:
+  T _value = 0;
+  bool _primed = false;
+};
+
+// Fixed point: the state keeps SHIFT extra fraction bits, so small steps are
+// not truncated away and the average converges to the exact input.
+template <uint8_t SHIFT> class Ewma<int32_t, SHIFT> {
+public:
+  void reset() { _primed = false; }
+  void add(int32_t x) {
+    _acc = _primed ? _acc + (int64_t)x - (_acc >> SHIFT) : (int64_t)x << SHIFT;
+    _primed = true;
+  }
+  int32_t value() const { return (int32_t)(_acc >> SHIFT); }
+
+private:
+  int64_t _acc = 0;
+  bool _primed = false;
+};
+
+// Trapezoidal integral of a rate over time stamps in us (power -> energy,
+// current -> charge); deltas are unsigned, so micros() wraparound is fine.
+template <typename T> class TimeIntegral {
+public:
+  void reset() { *this = TimeIntegral(); }
+  // Zeroes the total but keeps the last point, so the next add() books the
+  // interval since that point to the new total.
+  void restart() {
+    _sum = 0;
+    _carry = 0;
+  }
+  void add(uint32_t t_us, T x) {
+    if (_primed) {
+      // Kahan-compensated: per-sample areas are tiny next to the total.
+      T area = (x + _last) * (T(0.5e-6f) * (T)(uint32_t)(t_us - _lastT_us)) - _carry;
+      T sum = _sum + area;
+      _carry = (sum - _sum) - area;
+      _sum = sum;
+    }
+    _primed = true;
+    _last = x;
+    _lastT_us = t_us;
+  }
+  // Integral in x-units * seconds.
+  T total() const { return _sum; }
+
+private:
+  T _sum = 0;
+  T _carry = 0;
+  T _last = 0;
+  uint32_t _lastT_us = 0;
+  bool _primed = false;
+};
+
+// Fixed point: twice the trapezoid area in x-units * us, exactly. Inside
+// int64 for |x| < 2^31 and any dt < 2^32 us per sample.
+template <> class TimeIntegral<int32_t> {
+public:
+  void reset() { *this = TimeIntegral(); }
+  void restart() { _area2 = 0; }
+  void add(uint32_t t_us, int32_t x) {
+    if (_primed) _area2 += ((int64_t)x + _last) * (int64_t)(uint32_t)(t_us - _lastT_us);
+    _primed = true;
+    _last = x;
+    _lastT_us = t_us;
+  }
+  int64_t area2_us() const { return _area2; }
+  // Integral in x-units * seconds.
+  double total() const { return (double)_area2 * 0.5e-6; }
+
+private:
+  int64_t _area2 = 0;
+  int32_t _last = 0;
+  uint32_t _lastT_us = 0;
+  bool _primed = false;
+};
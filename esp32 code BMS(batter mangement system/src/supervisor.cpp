@@ -0,0 +1,153 @@
+#include "supervisor.h"
+
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <string.h>
+
+#include "logger.h"
+
+namespace {
+
+// Which task a supervisor reboot was for; survives the reset
+struct RebootNote {
+  uint32_t magic;
+  char task[16];
+};
+const uint32_t REBOOT_MAGIC = 0x53555056;   // "SUPV"
+RTC_NOINIT_ATTR RebootNote rebootNote;
+
+const char* resetReasonName(esp_reset_reason_t r) {
+  switch (r) {
+    case ESP_RST_POWERON: return "power_on";
+    case ESP_RST_EXT: return "external";
+    case ESP_RST_SW: return "software";
+    case ESP_RST_PANIC: return "panic";
+    case ESP_RST_INT_WDT: return "interrupt_wdt";
+    case ESP_RST_TASK_WDT: return "task_wdt";
+    case ESP_RST_WDT: return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deep_sleep";
+    case ESP_RST_BROWNOUT: return "brownout";
+    default: return "unknown";
+  }
+}
+
+const char* levelName(Supervisor::Level l) {
+  switch (l) {
+    case Supervisor::Level::Ok: return "ok";
+    case Supervisor::Level::Recovering: return "recovering";
+    case Supervisor::Level::Restarting: return "restarting";
+    case Supervisor::Level::Rebooting: return "rebooting";
+  }
+  return "";
+}
+
+}  // namespace
+
+int8_t Supervisor::add(const char* name, uint32_t timeout_ms, Action recover, Action restart) {
+  if (_count >= MAX_TASKS) return -1;
+  Watch& w = _watches[_count];
+  w.name = name;
+  w.timeout_ms = timeout_ms;
+  w.recover = recover;
+  w.restart = restart;
+  w.lastBeat_ms.store(millis(), std::memory_order_relaxed);
+  w.attached = false;
+  w.level = Level::Ok;
+  return (int8_t)_count++;
+}
+
+void Supervisor::begin(uint32_t watchdog_s, Action beforeReboot) {
+  _beforeReboot = beforeReboot;
+  esp_reset_reason_t reason = esp_reset_reason();
+  _resetReason = resetReasonName(reason);
+  if (reason == ESP_RST_SW && rebootNote.magic == REBOOT_MAGIC) {
+    memcpy(_rebootedFor, rebootNote.task, sizeof(_rebootedFor));
+    _rebootedFor[sizeof(_rebootedFor) - 1] = '\0';
+  }
+  rebootNote.magic = 0;
+  // Already running (the core watches the idle tasks): this updates it
+  esp_task_wdt_init(watchdog_s, true);
+  esp_task_wdt_add(nullptr);
+}
+
+void Supervisor::attach(int8_t id) {
+  if (id < 0 || id >= _count) return;
+  Watch& w = _watches[id];
+  w.lastBeat_ms.store(millis(), std::memory_order_relaxed);
+  esp_task_wdt_add(nullptr);
+  w.attached = true;
+}
+
+void Supervisor::beat(int8_t id) {
+  if (id < 0 || id >= _count) return;
+  _watches[id].lastBeat_ms.store(millis(), std::memory_order_relaxed);
+  esp_task_wdt_reset();
+}
+
+void Supervisor::poll(uint32_t now_ms) {
+  esp_task_wdt_reset();
+  for (uint8_t k = 0; k < _count; ++k) {
+    Watch& w = _watches[k];
+    if (!w.attached) continue;
+    // A beat from the other core may be newer than now_ms
+    int32_t silent = (int32_t)(now_ms - w.lastBeat_ms.load(std::memory_order_relaxed));
+    if (silent < (int32_t)w.timeout_ms) {
+      if (w.level != Level::Ok) {
+        LOG_INFO("Supervisor: %s is back", w.name);
+        w.level = Level::Ok;
+      }
+      continue;
+    }
+    uint32_t steps = (uint32_t)silent / w.timeout_ms;
+    if (steps > (uint32_t)Level::Rebooting) steps = (uint32_t)Level::Rebooting;
+    if (steps > (uint32_t)w.level) escalate(w, (Level)((uint8_t)w.level + 1));
+  }
+}
+
+void Supervisor::escalate(Watch& w, Level to) {
+  w.level = to;
+  LOG_WARN("Supervisor: %s silent, %s", w.name, levelName(to));
+  switch (to) {
+    case Level::Ok:
+      break;
+    case Level::Recovering:
+      if (w.recover) {
+        w.recover();
+        _recoveries++;
+      }
+      break;
+    case Level::Restarting:
+      if (w.restart) {
+        w.restart();
+        _restarts++;
+      }
+      break;
+    case Level::Rebooting:
+      if (_beforeReboot) _beforeReboot();
+      rebootNote.magic = REBOOT_MAGIC;
+      strncpy(rebootNote.task, w.name, sizeof(rebootNote.task) - 1);
+      rebootNote.task[sizeof(rebootNote.task) - 1] = '\0';
+      logger.flush();
+      esp_restart();
+      break;
+  }
+}
+
+void Supervisor::writeJson(JsonWriter& w, uint32_t now_ms) const {
+  w.beginObject("supervisor")
+      .field("reset", _resetReason)
+      .field("rebooted_for", _rebootedFor)
+      .field("recoveries", _recoveries)
+      .field("restarts", _restarts)
+      .beginObject("tasks");
+  for (uint8_t k = 0; k < _count; ++k) {
+    const Watch& t = _watches[k];
+    if (!t.attached) continue;
+    int32_t silent = (int32_t)(now_ms - t.lastBeat_ms.load(std::memory_order_relaxed));
+    w.beginObject(t.name)
+        .field("silent_ms", (uint32_t)(silent > 0 ? silent : 0))
+        .field("level", levelName(t.level))
+        .endObject();
+  }
+  w.endObject().endObject();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "json_writer.h"
+
+// Heartbeat supervisor for the firmware tasks, backed by the task watchdog.
+//
+// Each watched task calls attach() once from its own context (which also
+// registers it with the TWDT) and beat() once per pass. poll(), from the
+// supervisor's own task, escalates one step for every further timeout_ms a
+// task stays silent:
+//   1 x timeout  recover()   e.g. drop the socket a write is stuck on
+//   2 x timeout  restart()   e.g. take the WiFi link down and up again
+//   3 x timeout  reboot      beforeReboot() (checkpoint), then esp_restart()
+// A step without an action is skipped; a beat resets the ladder. The
+// actions run on the supervisor task while the watched one is stuck, so
+// they may only use calls that are safe from another task.
+//
+// The TWDT is the backstop: if a watched task, or the supervisor itself,
+// stops resetting it for watchdog_s (set above every ladder) the chip
+// panics and resets. A software reboot leaves the task's name in RTC
+// memory; the next boot reports it with the reset reason.
+class Supervisor {
+public:
+  static const uint8_t MAX_TASKS = 6;
+  typedef void (*Action)();
+  enum class Level : uint8_t { Ok, Recovering, Restarting, Rebooting };
+
+  // Before attach(); returns the watch id (-1 when full). name must stay valid.
+  int8_t add(const char* name, uint32_t timeout_ms, Action recover, Action restart);
+  // Configures the TWDT (panic on timeout) and picks up the last reboot's cause.
+  void begin(uint32_t watchdog_s, Action beforeReboot);
+
+  // From the watched task itself.
+  void attach(int8_t id);
+  void beat(int8_t id);
+
+  // From the supervisor task, about once a second; feeds its own watchdog.
+  void poll(uint32_t now_ms);
+
+  uint32_t recoveries() const { return _recoveries; }
+  uint32_t restarts() const { return _restarts; }
+
+  // "supervisor": {"reset", "rebooted_for", "recoveries", "restarts",
+  // "tasks": {"<task>": {"silent_ms", "level"}, ..}}
+  void writeJson(JsonWriter& w, uint32_t now_ms) const;
+
+private:
+  struct Watch {
+    const char* name;
+    uint32_t timeout_ms;
+    Action recover;
+    Action restart;
+    std::atomic<uint32_t> lastBeat_ms;
+    bool attached;
+    Level level;
+  };
+
+  void escalate(Watch& w, Level to);
+
+  Watch _watches[MAX_TASKS];
+  uint8_t _count = 0;
+  Action _beforeReboot = nullptr;
+  uint32_t _recoveries = 0;
+  uint32_t _restarts = 0;
+  char _rebootedFor[16] = "";   // task that caused the previous reboot, if any
+  const char* _resetReason = "unknown";
+};
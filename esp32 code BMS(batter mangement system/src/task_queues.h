@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "ring_buffer.h"
+
+// Hand-over between the firmware tasks (see the task layout in main.cpp).
+// Both are single-producer / single-consumer and lock-free on the data
+// path (BlockingQueue is an SpscRing underneath); they differ in what
+// happens when the consumer falls behind.
+
+// Bounded FIFO whose producer blocks while it is full (nothing is ever
+// dropped silently). Slots are filled and drained in place, so large
+// messages are not copied: acquire() a slot, write it, commit(); on the
+// other side front(), use it, release(). Blocking uses direct task
+// notifications, only when the queue is full or empty.
+template <typename T, size_t N>
+class BlockingQueue {
+public:
+  // Producer: a free slot, waiting up to timeout for one (nullptr on timeout).
+  T* acquire(TickType_t timeout) {
+    T* slot;
+    while (!(slot = _ring.slot())) {
+      _producer = xTaskGetCurrentTaskHandle();
+      // Re-check after publishing the handle so a release() in between is not missed
+      if ((slot = _ring.slot())) break;
+      if (!timeout || !ulTaskNotifyTake(pdTRUE, timeout)) {
+        _producer = nullptr;
+        _timeouts++;
+        return nullptr;
+      }
+    }
+    _producer = nullptr;
+    return slot;
+  }
+  void commit() {
+    _ring.commit();
+    TaskHandle_t consumer = _consumer;
+    if (consumer) xTaskNotifyGive(consumer);
+  }
+
+  // Consumer: the oldest message, waiting up to timeout (nullptr if none).
+  T* front(TickType_t timeout = 0) {
+    T* msg = _ring.peek();
+    if (!msg && timeout) {
+      _consumer = xTaskGetCurrentTaskHandle();
+      if (!(msg = _ring.peek())) ulTaskNotifyTake(pdTRUE, timeout);
+      _consumer = nullptr;
+      if (!msg) msg = _ring.peek();
+    }
+    return msg;
+  }
+  void release() {
+    _ring.release();
+    TaskHandle_t producer = _producer;
+    if (producer) xTaskNotifyGive(producer);
+  }
+
+  size_t size() const { return _ring.size(); }
+  static constexpr size_t capacity() { return N; }
+  // acquire() calls that gave up
+  uint32_t timeouts() const { return _timeouts; }
+
+private:
+  SpscRing<T, N> _ring;
+  TaskHandle_t volatile _producer = nullptr;   // waiting for space
+  TaskHandle_t volatile _consumer = nullptr;   // waiting for data
+  uint32_t _timeouts = 0;
+};
+
+// Depth-one queue that drops the oldest value: the writer never waits and
+// the reader always gets the newest complete value (triple buffer; the
+// write and read slots are private, the third is swapped atomically).
+template <typename T>
+class LatestValue {
+public:
+  void write(const T& value) {
+    _slots[_write] = value;
+    _write = _middle.exchange(_write | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+  // True and the newest value if one was written since the last read.
+  bool read(T& out) {
+    if (!(_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+    _read = _middle.exchange(_read, std::memory_order_acq_rel) & INDEX;
+    out = _slots[_read];
+    return true;
+  }
+
+private:
+  static const uint8_t INDEX = 0x03;
+  static const uint8_t FRESH = 0x04;
+
+  T _slots[3];
+  uint8_t _write = 0;            // writer's slot
+  uint8_t _read = 1;             // reader's slot
+  std::atomic<uint8_t> _middle{2};
+};
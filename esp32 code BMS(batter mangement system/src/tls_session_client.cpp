@@ -0,0 +1,308 @@
+#include "tls_session_client.h"
+
+#include <esp_heap_caps.h>
+#include <lwip/sockets.h>
+#include <mbedtls/ssl_ciphersuites.h>
+#include <sdkconfig.h>
+#include <time.h>
+
+static const char* DRBG_PERSONALIZATION = "bms-tls";
+
+// In order of preference. The server has the final say (and its
+// certificate's key type decides ECDSA or RSA); nothing slower is offered.
+static const int CIPHERSUITES[] = {
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+  0,
+};
+// Key exchange and certificate curves; P-384 for ISRG Root X2 chains
+static const mbedtls_ecp_group_id CURVES[] = {
+  MBEDTLS_ECP_DP_SECP256R1,
+  MBEDTLS_ECP_DP_SECP384R1,
+  MBEDTLS_ECP_DP_NONE,
+};
+// Before this (2024-01-01) the clock has not been set yet
+static const time_t CLOCK_VALID_AFTER = 1704067200;
+
+TlsSessionClient::TlsSessionClient() {
+  mbedtls_entropy_init(&_entropy);
+  mbedtls_ctr_drbg_init(&_drbg);
+  mbedtls_ssl_config_init(&_conf);
+  mbedtls_x509_crt_init(&_ca);
+  mbedtls_ssl_session_init(&_session);
+}
+
+TlsSessionClient::~TlsSessionClient() {
+  stop();
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_x509_crt_free(&_ca);
+  mbedtls_ssl_config_free(&_conf);
+  mbedtls_ctr_drbg_free(&_drbg);
+  mbedtls_entropy_free(&_entropy);
+}
+
+#if !defined(CONFIG_MBEDTLS_HARDWARE_AES) || !defined(CONFIG_MBEDTLS_HARDWARE_SHA) || \
+    !defined(CONFIG_MBEDTLS_HARDWARE_MPI)
+#warning "mbedTLS is built without some ESP32 crypto accelerators; TLS handshakes will be slower"
+#endif
+
+const char* TlsSessionClient::hardwareCrypto() {
+  static const char* const NAMES = ""
+#if defined(CONFIG_MBEDTLS_HARDWARE_AES)
+                                   ",aes"
+#endif
+#if defined(CONFIG_MBEDTLS_HARDWARE_SHA)
+                                   ",sha"
+#endif
+#if defined(CONFIG_MBEDTLS_HARDWARE_MPI)
+                                   ",mpi"
+#endif
+      ;
+  return NAMES[0] ? NAMES + 1 : NAMES;
+}
+
+void TlsSessionClient::setInsecure() {
+  _caPem = nullptr;
+  _anchors = nullptr;
+  _anchorCount = 0;
+  _configured = false;
+}
+
+void TlsSessionClient::setCACert(const char* pem) {
+  setInsecure();
+  _caPem = pem;
+}
+
+void TlsSessionClient::setCABundle(const TrustAnchor* anchors, size_t count) {
+  setInsecure();
+  _anchors = anchors;
+  _anchorCount = count;
+}
+
+// Certificate dates mean nothing before SNTP has set the clock; the chain,
+// signatures and host name are still checked.
+int TlsSessionClient::verifyCert(void*, mbedtls_x509_crt*, int, uint32_t* flags) {
+  if (time(nullptr) < CLOCK_VALID_AFTER) *flags &= ~(MBEDTLS_X509_BADCERT_EXPIRED | MBEDTLS_X509_BADCERT_FUTURE);
+  return 0;
+}
+
+void TlsSessionClient::clearSession() {
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_session_init(&_session);
+  _haveSession = false;
+}
+
+// RNG and TLS settings shared by every connection; redone only after the
+// trust settings change.
+bool TlsSessionClient::setupConfig() {
+  if (_configured) return true;
+  mbedtls_ssl_config_free(&_conf);
+  mbedtls_ssl_config_init(&_conf);
+  mbedtls_x509_crt_free(&_ca);
+  mbedtls_x509_crt_init(&_ca);
+  if ((_lastError = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                                          (const unsigned char*)DRBG_PERSONALIZATION,
+                                          strlen(DRBG_PERSONALIZATION))) != 0 ||
+      (_lastError = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                                MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+    return false;
+  }
+  if (_caPem) {
+    if ((_lastError = mbedtls_x509_crt_parse(&_ca, (const unsigned char*)_caPem, strlen(_caPem) + 1)) != 0) {
+      return false;
+    }
+  }
+  for (size_t k = 0; k < _anchorCount; ++k) {
+    // Parsed in place: the certificate keeps pointing into flash
+    if ((_lastError = mbedtls_x509_crt_parse_der_nocopy(&_ca, _anchors[k].der, _anchors[k].len)) != 0) {
+      return false;
+    }
+  }
+  if (verifying()) {
+    mbedtls_ssl_conf_ca_chain(&_conf, &_ca, nullptr);
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_verify(&_conf, verifyCert, nullptr);
+  } else {
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_NONE);
+  }
+  mbedtls_ssl_conf_ciphersuites(&_conf, CIPHERSUITES);
+  mbedtls_ssl_conf_curves(&_conf, CURVES);
+  mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  // A session saved under other trust settings must not be resumed.
+  clearSession();
+  _configured = true;
+  return true;
+}
+
+int TlsSessionClient::connect(IPAddress ip, uint16_t port) {
+  stop();
+  if (!_tcp.connect(ip, port)) return 0;
+  return handshake(nullptr, port);
+}
+
+int TlsSessionClient::connect(const char* host, uint16_t port) {
+  stop();
+  if (!_tcp.connect(host, port)) return 0;
+  return handshake(host, port);
+}
+
+int TlsSessionClient::handshake(const char* host, uint16_t port) {
+  if (!setupConfig()) {
+    _tcp.stop();
+    return 0;
+  }
+  // The saved session only belongs to the server it came from.
+  if (_haveSession && (_sessionPort != port || !host || strcmp(host, _sessionHost) != 0)) clearSession();
+
+  int fd = _tcp.fd();
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  mbedtls_net_init(&_net);
+  _net.fd = fd;
+
+  size_t freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  size_t lowest = freeBefore;
+  mbedtls_ssl_init(&_ssl);
+  _sslActive = true;
+  if ((_lastError = mbedtls_ssl_setup(&_ssl, &_conf)) != 0 ||
+      (host && (_lastError = mbedtls_ssl_set_hostname(&_ssl, host)) != 0)) {
+    stop();
+    return 0;
+  }
+  mbedtls_ssl_set_bio(&_ssl, &_net, mbedtls_net_send, mbedtls_net_recv, nullptr);
+  _offered = _haveSession && mbedtls_ssl_set_session(&_ssl, &_session) == 0;
+
+  uint32_t start = millis();
+  int ret;
+  while ((ret = mbedtls_ssl_handshake(&_ssl)) != 0) {
+    if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        millis() - start >= _handshakeTimeout_ms) {
+      _lastError = ret;
+      _verifyFlags = mbedtls_ssl_get_verify_result(&_ssl);
+      // A stale ticket or ID should not cost the next attempt as well.
+      clearSession();
+      stop();
+      return 0;
+    }
+    size_t freeNow = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    if (freeNow < lowest) lowest = freeNow;
+    vTaskDelay(1);
+  }
+  _handshake_ms = millis() - start;
+  _suite = mbedtls_ssl_get_ciphersuite(&_ssl);
+  _verifyFlags = 0;
+  size_t freeAfter = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  if (freeAfter < lowest) lowest = freeAfter;
+  _heapHeld = freeAfter < freeBefore ? freeBefore - freeAfter : 0;
+  _handshakePeak = freeBefore - lowest;
+
+  // Keep the session (refreshed ticket included) for the next connect.
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_session_init(&_session);
+  _haveSession = host && mbedtls_ssl_get_session(&_ssl, &_session) == 0;
+  if (_haveSession) {
+    strncpy(_sessionHost, host, sizeof(_sessionHost) - 1);
+    _sessionHost[sizeof(_sessionHost) - 1] = '\0';
+    _sessionPort = port;
+  }
+  _lastError = 0;
+  _connected = true;
+  return 1;
+}
+
+size_t TlsSessionClient::write(const uint8_t* buf, size_t size) {
+  if (!_connected) return 0;
+  size_t sent = 0;
+  uint32_t start = millis();
+  while (sent < size) {
+    int ret = mbedtls_ssl_write(&_ssl, buf + sent, size - sent);
+    if (ret > 0) {
+      sent += ret;
+    } else if ((ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) ||
+               millis() - start >= _handshakeTimeout_ms) {
+      _lastError = ret;
+      stop();
+      break;
+    } else {
+      vTaskDelay(1);
+    }
+  }
+  return sent;
+}
+
+int TlsSessionClient::available() {
+  if (!_connected) return 0;
+  int pending = _peeked >= 0 ? 1 : 0;
+  size_t n = mbedtls_ssl_get_bytes_avail(&_ssl);
+  if (n == 0) {
+    // Pull in one record, if the socket has one, without blocking.
+    int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      _lastError = ret;
+      stop();
+      return pending;
+    }
+    n = mbedtls_ssl_get_bytes_avail(&_ssl);
+  }
+  return (int)n + pending;
+}
+
+int TlsSessionClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsSessionClient::read(uint8_t* buf, size_t size) {
+  if (size == 0) return 0;
+  size_t got = 0;
+  if (_peeked >= 0) {
+    buf[got++] = (uint8_t)_peeked;
+    _peeked = -1;
+  }
+  if (!_connected || got == size) return got ? (int)got : -1;
+  int ret = mbedtls_ssl_read(&_ssl, buf + got, size - got);
+  if (ret > 0) {
+    got += ret;
+  } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    _lastError = ret;
+    stop();
+  }
+  return got ? (int)got : -1;
+}
+
+int TlsSessionClient::peek() {
+  if (_peeked < 0) {
+    uint8_t b;
+    if (available() && read(&b, 1) == 1) _peeked = b;
+  }
+  return _peeked;
+}
+
+void TlsSessionClient::closeSsl() {
+  if (!_sslActive) return;
+  if (_connected) mbedtls_ssl_close_notify(&_ssl);
+  // The socket belongs to _tcp; mbedtls_net_free() would close it twice.
+  mbedtls_ssl_free(&_ssl);
+  _sslActive = false;
+}
+
+void TlsSessionClient::abort() {
+  int fd = _tcp.fd();
+  if (fd >= 0) shutdown(fd, SHUT_RDWR);
+}
+
+void TlsSessionClient::stop() {
+  closeSsl();
+  _connected = false;
+  _peeked = -1;
+  _tcp.stop();
+}
+
+uint8_t TlsSessionClient::connected() {
+  if (_connected && !_tcp.connected()) stop();
+  return _connected || _peeked >= 0;
+}
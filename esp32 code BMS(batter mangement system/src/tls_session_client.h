@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFiClient.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+
+// One root certificate of a CA bundle (ca_bundle.h), DER.
+struct TrustAnchor {
+  const char* name;
+  const uint8_t* der;
+  size_t len;
+};
+
+// TLS Client (drop-in for WiFiClientSecure) that resumes its last session.
+//
+// WiFiClientSecure starts every connection with a full handshake: key
+// exchange, certificate chain and two round trips. This client keeps the
+// session (ID and, if the server issued one, its ticket) from the last
+// successful handshake and offers it on the next connect to the same
+// host:port, so a reconnect is an abbreviated handshake with no public key
+// operation. If the server declines, mbedTLS falls back to a full handshake
+// on its own; a handshake that fails outright drops the saved session.
+//
+// The session lives in RAM, which light sleep keeps. The RNG and TLS
+// configuration are set up once; the per-connection context (and its record
+// buffers) is freed on stop().
+//
+// With a CA bundle (setCABundle) the server is verified against those roots
+// only, so a chain from any other CA is refused. The roots are DER, parsed
+// once and in place from flash, and a resumed session skips the chain
+// check altogether. Only ECDHE suites with AES-GCM are offered, ECDSA
+// before RSA, P-256 first: finite-field DHE costs seconds per handshake on this
+// CPU, while AES, SHA and the bignum arithmetic of ECDHE/ECDSA (and RSA
+// signature checks) run on the ESP32's crypto accelerators, which the
+// framework's mbedTLS is built with. Until SNTP has set the clock,
+// certificate dates cannot be checked and are ignored; everything else is
+// verified.
+class TlsSessionClient : public Client {
+public:
+  TlsSessionClient();
+  ~TlsSessionClient() override;
+
+  // No certificate verification (as WiFiClientSecure::setInsecure()).
+  void setInsecure();
+  // Verify the server against this PEM root; pem must stay valid.
+  void setCACert(const char* pem);
+  // Verify the server against these DER roots (ca_bundle.h); anchors and
+  // their data must stay valid.
+  void setCABundle(const TrustAnchor* anchors, size_t count);
+  void setHandshakeTimeout(uint32_t ms) { _handshakeTimeout_ms = ms; }
+  // Forget the saved session; the next connect does a full handshake.
+  void clearSession();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  // Safe from another task: shuts the socket down so a read or write
+  // blocked on it fails at once. The owner still has to stop().
+  void abort();
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+  using Print::write;
+
+  // Last connect: whether a saved session was offered, and how long the
+  // handshake took.
+  bool sessionOffered() const { return _offered; }
+  uint32_t handshakeMs() const { return _handshake_ms; }
+  int lastError() const { return _lastError; }
+  // Whether the server is verified, the suite of the open (or last)
+  // connection, and why the last chain check failed (MBEDTLS_X509_BADCERT_*).
+  bool verifying() const { return _caPem || _anchorCount; }
+  const char* ciphersuite() const { return _suite; }
+  uint32_t verifyFlags() const { return _verifyFlags; }
+  // Crypto accelerators the framework's mbedTLS uses, e.g. "aes,sha,mpi".
+  static const char* hardwareCrypto();
+  // Heap taken by the connection (context, record buffers, peer
+  // certificate) once the handshake is done, and the most the handshake
+  // itself took on top of what was free before it. Other tasks allocate
+  // meanwhile, so both are approximate.
+  uint32_t heapHeld() const { return _heapHeld; }
+  uint32_t handshakePeakHeap() const { return _handshakePeak; }
+
+private:
+  bool setupConfig();
+  static int verifyCert(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+  int handshake(const char* host, uint16_t port);
+  void closeSsl();
+
+  mbedtls_entropy_context _entropy;
+  mbedtls_ctr_drbg_context _drbg;
+  mbedtls_ssl_config _conf;
+  mbedtls_x509_crt _ca;
+  mbedtls_ssl_context _ssl;
+  mbedtls_net_context _net;
+  mbedtls_ssl_session _session;
+
+  WiFiClient _tcp;
+  const char* _caPem = nullptr;
+  const TrustAnchor* _anchors = nullptr;
+  size_t _anchorCount = 0;
+  const char* _suite = "";
+  uint32_t _verifyFlags = 0;
+  bool _configured = false;
+  bool _sslActive = false;
+  bool _connected = false;
+  bool _haveSession = false;
+  bool _offered = false;
+  char _sessionHost[64] = "";
+  uint16_t _sessionPort = 0;
+  int16_t _peeked = -1;
+  uint32_t _handshakeTimeout_ms = 10000;
+  uint32_t _handshake_ms = 0;
+  uint32_t _heapHeld = 0;
+  uint32_t _handshakePeak = 0;
+  int _lastError = 0;
+};
@@ -0,0 +1,80 @@
+#include "topic_layout.h"
+
+#include <string.h>
+
+namespace {
+
+struct Placeholder {
+  const char* name;
+  size_t len;
+};
+const Placeholder SITE = {"{site}", 6};
+const Placeholder DEVICE = {"{device_id}", 11};
+const Placeholder STREAM = {"{stream}", 8};
+
+bool append(char* out, size_t cap, size_t& n, const char* text, size_t len) {
+  if (n + len >= cap) return false;
+  memcpy(out + n, text, len);
+  n += len;
+  return true;
+}
+
+}  // namespace
+
+void TopicLayout::begin(const char* templ, const char* site, const char* deviceId) {
+  _templ = templ;
+  _site = site;
+  strncpy(_deviceId, deviceId, sizeof(_deviceId) - 1);
+  _deviceId[sizeof(_deviceId) - 1] = '\0';
+  _used = 0;
+  _ok = true;
+}
+
+const char* TopicLayout::add(const char* stream) {
+  size_t room = ARENA - _used;
+  if (room > TOPIC_MAX) room = TOPIC_MAX;
+  char* out = _arena + _used;
+  if (!format(out, room, _deviceId, stream)) {
+    _ok = false;
+    return "";
+  }
+  _used += strlen(out) + 1;
+  return out;
+}
+
+bool TopicLayout::format(char* out, size_t cap, const char* deviceId, const char* stream) const {
+  if (!cap) return false;
+  size_t n = 0;
+  bool fits = true;
+  for (const char* p = _templ; *p && fits;) {
+    if (!strncmp(p, SITE.name, SITE.len)) {
+      fits = append(out, cap, n, _site, strlen(_site));
+      p += SITE.len;
+    } else if (!strncmp(p, DEVICE.name, DEVICE.len)) {
+      fits = append(out, cap, n, deviceId, strlen(deviceId));
+      p += DEVICE.len;
+    } else if (!strncmp(p, STREAM.name, STREAM.len)) {
+      fits = append(out, cap, n, stream, strlen(stream));
+      p += STREAM.len;
+    } else {
+      fits = append(out, cap, n, p, 1);
+      p++;
+    }
+  }
+  out[fits ? n : 0] = '\0';
+  return fits;
+}
+
+void TopicLayout::deviceIdFromMac(const uint8_t mac[6], char* out, size_t cap) {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  if (cap < DEVICE_ID_MAX) {
+    if (cap) out[0] = '\0';
+    return;
+  }
+  memcpy(out, "bms-", 4);
+  for (uint8_t b = 0; b < 6; ++b) {
+    out[4 + 2 * b] = HEX_DIGITS[mac[b] >> 4];
+    out[5 + 2 * b] = HEX_DIGITS[mac[b] & 0x0F];
+  }
+  out[16] = '\0';
+}
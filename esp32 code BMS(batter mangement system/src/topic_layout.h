@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Device-scoped MQTT topics from one template, e.g.
+// "{site}/{device_id}/{stream}" -> "battery/bms-a1b2c3d4e5f6/aggregate".
+//
+// Every stream gets its own topic under the device, so ingestion can
+// subscribe per stream across the fleet ("battery/+/aggregate") and let
+// the broker spread one stream over several consumers with a shared
+// subscription ("$share/ingest/battery/+/aggregate"), while commands and
+// config stay addressed to one device. Placeholders are {site},
+// {device_id} and {stream}; everything else in the template is literal.
+//
+// add() expands a stream once, at setup, into an internal arena: the
+// result stays valid for the life of the program, as the topic router and
+// the subscription list require. Kept free of Arduino headers.
+class TopicLayout {
+public:
+  static const size_t TOPIC_MAX = 48;    // longest topic, NUL included (an inbound block holds it)
+  static const size_t ARENA = 640;       // every topic of this device
+  static const size_t DEVICE_ID_MAX = 17;
+
+  // deviceId is copied; site and the template must stay valid.
+  void begin(const char* templ, const char* site, const char* deviceId);
+  const char* deviceId() const { return _deviceId; }
+
+  // This device's topic for stream; "" (and ok() false) if it does not fit.
+  const char* add(const char* stream);
+  // The topic another device would use, e.g. an ESP-NOW node the gateway
+  // republishes. False if it does not fit cap.
+  bool format(char* out, size_t cap, const char* deviceId, const char* stream) const;
+  // False once any topic did not fit.
+  bool ok() const { return _ok; }
+
+  // "bms-" and the 12 hex digits of mac, in transmission order.
+  static void deviceIdFromMac(const uint8_t mac[6], char* out, size_t cap);
+
+private:
+  const char* _templ = "";
+  const char* _site = "";
+  char _deviceId[DEVICE_ID_MAX] = "";
+  char _arena[ARENA];
+  size_t _used = 0;
+  bool _ok = true;
+};
@@ -0,0 +1,82 @@
+#include "topic_router.h"
+
+uint8_t TopicRouter::addChild(uint8_t parent, const char* seg, uint8_t len, bool plus) {
+  Node& p = _nodes[parent];
+  if (plus) {
+    if (p.plus != NONE) return p.plus;
+  } else {
+    for (uint8_t c = p.child; c != NONE; c = _nodes[c].next) {
+      if (_nodes[c].segLen == len && memcmp(_nodes[c].seg, seg, len) == 0) return c;
+    }
+  }
+  if (_count >= MAX_NODES) return NONE;
+  uint8_t k = _count++;
+  _nodes[k].seg = seg;
+  _nodes[k].segLen = len;
+  if (plus) {
+    p.plus = k;
+  } else {
+    _nodes[k].next = p.child;
+    p.child = k;
+  }
+  return k;
+}
+
+bool TopicRouter::on(const char* filter, Handler handler) {
+  if (!filter || !handler || !*filter) return false;
+  uint8_t node = ROOT;
+  const char* seg = filter;
+  for (;;) {
+    const char* end = strchr(seg, '/');
+    size_t len = end ? (size_t)(end - seg) : strlen(seg);
+    if (len == 1 && *seg == '#') {
+      if (end) return false;   // '#' must be the last level
+      _nodes[node].rest = handler;
+      return true;
+    }
+    bool plus = len == 1 && *seg == '+';
+    if (len > 255 || (!plus && (memchr(seg, '+', len) || memchr(seg, '#', len)))) return false;
+    node = addChild(node, seg, (uint8_t)len, plus);
+    if (node == NONE) return false;
+    if (!end) break;
+    seg = end + 1;
+  }
+  _nodes[node].handler = handler;
+  return true;
+}
+
+uint8_t TopicRouter::dispatch(const char* topic, const uint8_t* payload, unsigned int length) const {
+  if (!topic) return 0;
+  return match(ROOT, topic, topic, payload, length);
+}
+
+// node has matched the levels before level; level is nullptr once the topic
+// is used up ("a/" still has an empty last level).
+uint8_t TopicRouter::match(uint8_t node, const char* level, const char* topic, const uint8_t* payload,
+                           unsigned int length) const {
+  const Node& n = _nodes[node];
+  bool system = node == ROOT && topic[0] == '$';
+  uint8_t hits = 0;
+  if (n.rest && !system) {
+    n.rest(topic, payload, length);
+    hits++;
+  }
+  if (!level) {
+    if (n.handler) {
+      n.handler(topic, payload, length);
+      hits++;
+    }
+    return hits;
+  }
+  const char* end = strchr(level, '/');
+  size_t len = end ? (size_t)(end - level) : strlen(level);
+  const char* following = end ? end + 1 : nullptr;
+  for (uint8_t c = n.child; c != NONE; c = _nodes[c].next) {
+    if (_nodes[c].segLen == len && memcmp(_nodes[c].seg, level, len) == 0) {
+      hits += match(c, following, topic, payload, length);
+      break;
+    }
+  }
+  if (n.plus != NONE && !system) hits += match(n.plus, following, topic, payload, length);
+  return hits;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Routes inbound MQTT messages to handlers by topic filter.
+//
+// Filters use the MQTT wildcards ('+' one level, '#' the rest, last level
+// only) and are split into a trie of levels when registered, normally in
+// setup(). dispatch() then walks the topic once, level by level, following
+// the exact child and the '+' child of each node, so its cost grows with
+// the topic's length and not with the number of filters. As in MQTT, a
+// wildcard in the first level does not match topics starting with '$'.
+class TopicRouter {
+public:
+  using Handler = void (*)(const char* topic, const uint8_t* payload, unsigned int length);
+
+  static const uint8_t MAX_NODES = 32;
+
+  // filter must stay valid (the trie points into it). Registering a filter
+  // again replaces its handler. False if the filter is malformed or the
+  // trie is full.
+  bool on(const char* filter, Handler handler);
+
+  // Calls every handler whose filter matches topic; returns how many.
+  uint8_t dispatch(const char* topic, const uint8_t* payload, unsigned int length) const;
+
+private:
+  static const uint8_t NONE = 0xFF;
+  static const uint8_t ROOT = 0;
+
+  struct Node {
+    const char* seg = nullptr;     // level text (not terminated)
+    uint8_t segLen = 0;
+    uint8_t child = NONE;          // first exact-level child
+    uint8_t next = NONE;           // next sibling
+    uint8_t plus = NONE;           // '+' child
+    Handler handler = nullptr;     // a filter ends at this node
+    Handler rest = nullptr;        // filter "<this node>/#"
+  };
+
+  uint8_t addChild(uint8_t parent, const char* seg, uint8_t len, bool plus);
+  uint8_t match(uint8_t node, const char* level, const char* topic, const uint8_t* payload,
+                unsigned int length) const;
+
+  Node _nodes[MAX_NODES];
+  uint8_t _count = 1;   // node 0 is the root
+};
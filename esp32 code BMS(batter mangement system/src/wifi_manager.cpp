@@ -0,0 +1,254 @@
+#include "wifi_manager.h"
+
+#include <Preferences.h>
+
+#include "logger.h"
+
+static const char* NVS_NAMESPACE = "wifi";
+
+void WifiManager::begin(const WifiCred* creds, size_t count) {
+  _creds = creds;
+  _count = count;
+
+  WiFi.mode(WIFI_STA);
+  // Reconnects are driven by this state machine, not by the driver.
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+
+  loadCache();
+  radioOn();
+}
+
+void WifiManager::radioOn() {
+  WiFi.mode(WIFI_STA);
+  if (_cache.valid) {
+    startAttempt(_cache.cred, _cache.channel, _cache.bssid);
+    enter(State::FastConnect);
+  } else {
+    startScan();
+  }
+}
+
+void WifiManager::radioOff() {
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  _evGotIp = false;
+  _evDisconnected = false;
+  enter(State::Off);
+}
+
+// Runs in the WiFi event task: only record what happened.
+void WifiManager::onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      _evGotIp = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      // Our own WiFi.disconnect() before an attempt; it arrives after the
+      // attempt has started and would fail it at once
+      if (info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_LEAVE) break;
+      _evReason = info.wifi_sta_disconnected.reason;
+      _evDisconnected = true;
+      break;
+    default:
+      break;
+  }
+}
+
+void WifiManager::enter(State s) {
+  _state = s;
+  _stateSince = millis();
+}
+
+void WifiManager::startAttempt(uint8_t cred, int32_t channel, const uint8_t* bssid) {
+  _current.cred = cred;
+  _current.channel = channel;
+  if (bssid) memcpy(_current.bssid, bssid, sizeof(_current.bssid));
+  else memset(_current.bssid, 0, sizeof(_current.bssid));
+
+  _evGotIp = false;
+  _evDisconnected = false;
+  LOG_INFO("WiFi: trying %s (ch %d)", _creds[cred].ssid, (int)channel);
+  WiFi.disconnect(false);
+  WiFi.begin(_creds[cred].ssid, _creds[cred].password, channel, bssid);
+}
+
+void WifiManager::startScan() {
+  LOG_INFO("WiFi: scanning...");
+  WiFi.disconnect(false);
+  _candidateCount = 0;
+  _candidateNext = 0;
+  WiFi.scanNetworks(true /* async */);
+  enter(State::Scanning);
+}
+
+// Keep the strongest BSS of every known SSID, ordered by RSSI.
+void WifiManager::collectScan(int16_t found) {
+  _candidateCount = 0;
+  _candidateNext = 0;
+  for (int16_t n = 0; n < found; ++n) {
+    String seen = WiFi.SSID(n);
+    for (size_t c = 0; c < _count && c < 256; ++c) {
+      if (strcmp(seen.c_str(), _creds[c].ssid) != 0) continue;
+      Candidate cand;
+      cand.cred = (uint8_t)c;
+      cand.rssi = WiFi.RSSI(n);
+      cand.channel = WiFi.channel(n);
+      memcpy(cand.bssid, WiFi.BSSID(n), sizeof(cand.bssid));
+
+      size_t slot = _candidateCount;
+      for (size_t i = 0; i < _candidateCount; ++i) {
+        if (_candidates[i].cred == cand.cred) { slot = i; break; }
+      }
+      if (slot < _candidateCount) {
+        if (_candidates[slot].rssi >= cand.rssi) break;
+        _candidates[slot] = cand;
+      } else if (_candidateCount < MAX_CANDIDATES) {
+        _candidates[_candidateCount++] = cand;
+      }
+      break;
+    }
+  }
+  WiFi.scanDelete();
+
+  // Insertion sort, strongest first (at most MAX_CANDIDATES entries).
+  for (size_t i = 1; i < _candidateCount; ++i) {
+    Candidate key = _candidates[i];
+    size_t j = i;
+    while (j > 0 && _candidates[j - 1].rssi < key.rssi) {
+      _candidates[j] = _candidates[j - 1];
+      --j;
+    }
+    _candidates[j] = key;
+  }
+  LOG_INFO("WiFi: scan found %u known network(s)", (unsigned)_candidateCount);
+}
+
+void WifiManager::nextCandidate() {
+  if (_candidateNext < _candidateCount) {
+    const Candidate& c = _candidates[_candidateNext++];
+    startAttempt(c.cred, c.channel, c.bssid);
+    enter(State::Connecting);
+    return;
+  }
+  LOG_WARN("WiFi: no network available, retry in %lu ms", _backoffMs);
+  WiFi.disconnect(false);
+  enter(State::Backoff);
+}
+
+void WifiManager::poll() {
+  if (_count == 0) return;
+  unsigned long elapsed = millis() - _stateSince;
+
+  switch (_state) {
+    case State::Idle:
+      startScan();
+      break;
+
+    case State::FastConnect:
+    case State::Connecting:
+      if (_evGotIp) {
+        _evGotIp = false;
+        LOG_INFO("WiFi connected, IP: %s", WiFi.localIP().toString().c_str());
+        _backoffMs = BACKOFF_MIN_MS;
+        storeCache();
+        enter(State::Connected);
+      } else if (_evDisconnected ||
+                 elapsed > (_state == State::FastConnect ? FAST_CONNECT_TIMEOUT_MS : CONNECT_TIMEOUT_MS)) {
+        _evDisconnected = false;
+        LOG_WARN("WiFi: %s failed (reason %u)", _creds[_current.cred].ssid, (unsigned)_evReason);
+        if (_state == State::FastConnect) startScan();
+        else nextCandidate();
+      }
+      break;
+
+    case State::Scanning: {
+      int16_t found = WiFi.scanComplete();
+      if (found >= 0) {
+        collectScan(found);
+        nextCandidate();
+      } else if (found == WIFI_SCAN_FAILED || elapsed > SCAN_TIMEOUT_MS) {
+        WiFi.scanDelete();
+        LOG_WARN("WiFi: scan failed");
+        nextCandidate();
+      }
+      break;
+    }
+
+    case State::Connected:
+      if (_evDisconnected) {
+        _evDisconnected = false;
+        LOG_WARN("WiFi: connection lost (reason %u)", (unsigned)_evReason);
+        // Same AP first: most drops are transient.
+        startAttempt(_current.cred, _current.channel, _current.bssid);
+        enter(State::FastConnect);
+      }
+      break;
+
+    case State::Backoff:
+      if (elapsed > _backoffMs) {
+        _backoffMs = _backoffMs * 2 > BACKOFF_MAX_MS ? BACKOFF_MAX_MS : _backoffMs * 2;
+        startScan();
+      }
+      break;
+
+    case State::Off:
+      break;
+  }
+}
+
+const char* WifiManager::stateName() const {
+  switch (_state) {
+    case State::Idle: return "idle";
+    case State::FastConnect: return "fast-connect";
+    case State::Scanning: return "scanning";
+    case State::Connecting: return "connecting";
+    case State::Connected: return "connected";
+    case State::Backoff: return "backoff";
+    case State::Off: return "off";
+  }
+  return "?";
+}
+
+const char* WifiManager::ssid() const {
+  if (_state == State::Idle || _state == State::Scanning || _state == State::Backoff || _state == State::Off) {
+    return nullptr;
+  }
+  return _creds[_current.cred].ssid;
+}
+
+void WifiManager::loadCache() {
+  Preferences prefs;
+  _cache.valid = false;
+  if (!prefs.begin(NVS_NAMESPACE, true)) return;
+  if (prefs.getBytesLength("bssid") == sizeof(_cache.bssid)) {
+    _cache.cred = prefs.getUChar("cred", 0xFF);
+    _cache.channel = prefs.getUChar("chan", 0);
+    prefs.getBytes("bssid", _cache.bssid, sizeof(_cache.bssid));
+    _cache.valid = _cache.cred < _count;
+  }
+  prefs.end();
+}
+
+// Only touches flash when the network actually changed.
+void WifiManager::storeCache() {
+  if (_cache.valid && _cache.cred == _current.cred && _cache.channel == _current.channel &&
+      memcmp(_cache.bssid, _current.bssid, sizeof(_cache.bssid)) == 0) {
+    return;
+  }
+  // A fast connect without a BSSID (channel 0) has nothing useful to cache.
+  static const uint8_t zero[6] = {0};
+  if (memcmp(_current.bssid, zero, sizeof(zero)) == 0) return;
+
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return;
+  prefs.putUChar("cred", _current.cred);
+  prefs.putUChar("chan", (uint8_t)_current.channel);
+  prefs.putBytes("bssid", _current.bssid, sizeof(_current.bssid));
+  prefs.end();
+
+  _cache.valid = true;
+  _cache.cred = _current.cred;
+  _cache.channel = _current.channel;
+  memcpy(_cache.bssid, _current.bssid, sizeof(_cache.bssid));
+}
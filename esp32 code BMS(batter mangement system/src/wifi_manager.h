@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+// One entry of the known-networks table in main.cpp.
+struct WifiCred { const char* ssid; const char* password; };
+
+// Event-driven WiFi connection manager.
+//
+// Replaces the old blocking connectWiFi(): poll() only advances a small state
+// machine driven by the ESP32 WiFi events and millis() timeouts, so loop()
+// (sampling, MQTT keepalive, OLED) never waits on the radio.
+//
+// Connect order: the last good BSSID/channel cached in NVS is tried first
+// (fast reconnect, no scan). If that fails, one async scan ranks the known
+// SSIDs by RSSI and they are tried strongest first. If nothing connects the
+// manager backs off (doubling, capped) before scanning again.
+class WifiManager {
+public:
+  enum class State : uint8_t { Idle, FastConnect, Scanning, Connecting, Connected, Backoff, Off };
+
+  void begin(const WifiCred* creds, size_t count);
+  // Call from loop(); returns immediately.
+  void poll();
+  // Power the radio down / back up for duty-cycled operation. radioOn()
+  // reconnects through the cached BSSID when there is one.
+  void radioOff();
+  void radioOn();
+
+  bool connected() const { return _state == State::Connected; }
+  State state() const { return _state; }
+  const char* stateName() const;
+  // SSID of the current / last attempted network (nullptr if none).
+  const char* ssid() const;
+
+private:
+  static const size_t MAX_CANDIDATES = 8;
+  static const unsigned long FAST_CONNECT_TIMEOUT_MS = 6000;
+  static const unsigned long CONNECT_TIMEOUT_MS = 12000;
+  static const unsigned long SCAN_TIMEOUT_MS = 10000;
+  static const unsigned long BACKOFF_MIN_MS = 2000;
+  static const unsigned long BACKOFF_MAX_MS = 60000;
+
+  struct Candidate {
+    uint8_t cred;      // index into _creds
+    int32_t rssi;
+    int32_t channel;
+    uint8_t bssid[6];
+  };
+
+  struct Cache {
+    bool valid;
+    uint8_t cred;
+    int32_t channel;
+    uint8_t bssid[6];
+  };
+
+  void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+  void enter(State s);
+  void startAttempt(uint8_t cred, int32_t channel, const uint8_t* bssid);
+  void startScan();
+  void collectScan(int16_t found);
+  void nextCandidate();
+  void loadCache();
+  void storeCache();
+
+  const WifiCred* _creds = nullptr;
+  size_t _count = 0;
+  State _state = State::Idle;
+  unsigned long _stateSince = 0;
+  unsigned long _backoffMs = BACKOFF_MIN_MS;
+
+  Candidate _candidates[MAX_CANDIDATES];
+  size_t _candidateCount = 0;
+  size_t _candidateNext = 0;
+  Candidate _current = {};
+
+  Cache _cache = {};
+
+  // Set from the WiFi event task, consumed in poll().
+  volatile bool _evGotIp = false;
+  volatile bool _evDisconnected = false;
+  volatile uint8_t _evReason = 0;
+};
@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+"""
+embed_page.py
+Compress web/live.html and write it to src/live_page.h as a byte array, which the firmware serves
+as-is with Content-Encoding: gzip (src/live_server.h). Run after editing the page:
+
+    python web/embed_page.py
+"""
+import gzip
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+SOURCE = ROOT / 'web' / 'live.html'
+TARGET = ROOT / 'src' / 'live_page.h'
+
+
+def main():
+    html = SOURCE.read_bytes()
+    data = gzip.compress(html, compresslevel=9, mtime=0)   # mtime=0: same input, same header
+    lines = []
+    for k in range(0, len(data), 16):
+        lines.append('  ' + ', '.join(f'0x{b:02x}' for b in data[k:k + 16]) + ',')
+    TARGET.write_text(
+        '#pragma once\n\n'
+        '#include <stddef.h>\n'
+        '#include <stdint.h>\n\n'
+        f'// Generated by web/embed_page.py from web/live.html ({len(html)} bytes); do not edit.\n'
+        'static const uint8_t LIVE_PAGE_GZ[] = {\n' + '\n'.join(lines) + '\n};\n'
+        'static const size_t LIVE_PAGE_GZ_LEN = sizeof(LIVE_PAGE_GZ);\n')
+    print(f'{SOURCE.name}: {len(html)} -> {len(data)} bytes gzip, written to {TARGET.relative_to(ROOT)}')
+
+
+if __name__ == '__main__':
+    main()
@@ -10,15 +10,31 @@ const { MongoClient, ServerApiVersion } = require('mongodb');
 const MQTT_URL = process.env.MQTT_URL || 'mqtt://localhost:1883';
 const MQTT_USERNAME = process.env.MQTT_USERNAME || '';
 const MQTT_PASSWORD = process.env.MQTT_PASSWORD || '';
-// Subscribe to both energy topics and smartpower topics (ESP32 publishes to smartpower/+/data)
+// Subscribe to both energy topics and smartpower topics (esp32_mqtt.ino publishes to smartpower/{device_id}/raw)
 const MQTT_TOPIC_FILTER = process.env.MQTT_TOPIC_FILTER || 'energy/+/+/telemetry';
-const MQTT_TOPIC_FILTER_2 = process.env.MQTT_TOPIC_FILTER_2 || 'smartpower/+/data';
-const MQTT_TOPIC_FILTER_3 = process.env.MQTT_TOPIC_FILTER_3 || 'battery/data';
+const MQTT_TOPIC_FILTER_2 = process.env.MQTT_TOPIC_FILTER_2 || 'smartpower/+/raw';
+// BMS devices publish on {site}/{device_id}/{stream} (src/topic_layout.h): aggregated windows here
+const MQTT_TOPIC_FILTER_3 = process.env.MQTT_TOPIC_FILTER_3 || 'battery/+/aggregate';
+// Hourly / daily Ah and Wh summaries computed on the device (src/energy_meter.h)
+const MQTT_TOPIC_ENERGY = process.env.MQTT_TOPIC_ENERGY || 'battery/+/energy';
+// Current x voltage histograms and anomaly alerts, also computed on the device (src/load_profile.h,
+// src/anomaly_detector.h)
+const MQTT_TOPIC_LOAD = process.env.MQTT_TOPIC_LOAD || 'battery/+/load';
+const MQTT_TOPIC_ALERT = process.env.MQTT_TOPIC_ALERT || 'battery/+/alert';
+// Set to run several bridges as one shared subscription ($share/<group>/...): the broker hands each
+// message to one of them
+const MQTT_SHARE_GROUP = process.env.MQTT_SHARE_GROUP || '';
+// Streams of the device topic layout; anything else keeps the older parsing
+const DEVICE_STREAMS = new Set(['aggregate', 'raw', 'event', 'protection', 'energy', 'load', 'alert', 'diag', 'config',
+  'ota', 'cmd']);
 const PORT = parseInt(process.env.PORT || '3000', 10);
 const DB_FILE = process.env.DB_FILE || 'telemetry.db';
 const MONGO_URI = process.env.MONGO_URI || '';
 const MONGO_DB = process.env.MONGO_DB || 'battery_monitor';
 const MONGO_COLLECTION = process.env.MONGO_COLLECTION || 'telemetry';
+const MONGO_ENERGY_COLLECTION = process.env.MONGO_ENERGY_COLLECTION || 'energy_summaries';
+const MONGO_LOAD_COLLECTION = process.env.MONGO_LOAD_COLLECTION || 'load_profiles';
+const MONGO_ALERT_COLLECTION = process.env.MONGO_ALERT_COLLECTION || 'alerts';
 const MONGO_TTL_DAYS = process.env.MONGO_TTL_DAYS ? parseInt(process.env.MONGO_TTL_DAYS, 10) : 0;
 
 // Ensure DB exists
@@ -47,6 +63,9 @@ function saveReading(deviceId, topic, payload) {
 // Optional: MongoDB client and collection
 let mongoClient = null;
 let mongoCol = null;
+let energyCol = null;
+let loadCol = null;
+let alertCol = null;
 async function initMongo() {
   if (!MONGO_URI) return;
   try {
@@ -68,6 +87,15 @@ async function initMongo() {
     // Ensure indexes: device_id + ts descending for queries
     await mongoCol.createIndex({ device_id: 1, ts: -1 });
 
+    // One summary per device, period and start: a replayed message overwrites, never duplicates
+    energyCol = db.collection(MONGO_ENERGY_COLLECTION);
+    await energyCol.createIndex({ device_id: 1, period: 1, ts: -1 }, { unique: true });
+    // Histograms and alerts replayed from the device's flash queue land on the same document
+    loadCol = db.collection(MONGO_LOAD_COLLECTION);
+    await loadCol.createIndex({ device_id: 1, ts: -1, uptime_ms: 1 }, { unique: true });
+    alertCol = db.collection(MONGO_ALERT_COLLECTION);
+    await alertCol.createIndex({ device_id: 1, ts: -1, uptime_ms: 1, kind: 1, state: 1 }, { unique: true });
+
     // Optional TTL index on `ts` (convert days to seconds)
     if (MONGO_TTL_DAYS > 0) {
       const seconds = MONGO_TTL_DAYS * 24 * 60 * 60;
@@ -80,6 +108,9 @@ async function initMongo() {
     try { await mongoClient.close(); } catch (e2) {}
     mongoClient = null;
     mongoCol = null;
+    energyCol = null;
+    loadCol = null;
+    alertCol = null;
   }
 }
 
@@ -99,8 +130,10 @@ const client = mqtt.connect(MQTT_URL, mqttOptions);
 client.on('connect', () => {
   console.log('Connected to MQTT broker');
   // Subscribe to all configured topic filters
-  [MQTT_TOPIC_FILTER, MQTT_TOPIC_FILTER_2, MQTT_TOPIC_FILTER_3].forEach(topic => {
-    if (topic) {
+  [MQTT_TOPIC_FILTER, MQTT_TOPIC_FILTER_2, MQTT_TOPIC_FILTER_3, MQTT_TOPIC_ENERGY, MQTT_TOPIC_LOAD,
+    MQTT_TOPIC_ALERT].forEach(filter => {
+    if (filter) {
+      const topic = MQTT_SHARE_GROUP ? `$share/${MQTT_SHARE_GROUP}/${filter}` : filter;
       client.subscribe(topic, { qos: 1 }, (err) => {
         if (err) console.error('Subscribe error', err);
         else console.log('Subscribed to', topic);
@@ -113,15 +146,112 @@ client.on('error', (err) => {
   console.error('MQTT error', err);
 });
 
+// {site}/{device_id}/{stream}[/...] -> { deviceId, stream }; null for other layouts
+function parseDeviceTopic(topic) {
+  const parts = topic.split('/');
+  if (parts.length < 3 || !DEVICE_STREAMS.has(parts[2])) return null;
+  return { deviceId: parts[1], stream: parts.slice(2).join('/') };
+}
+
+// Stores one energy summary; the device resends a period it is not sure went out
+async function saveEnergySummary(topic, deviceId, payload) {
+  if (!energyCol || !payload || typeof payload !== 'object' || !payload.period || !payload.ts) return;
+  const doc = {
+    device_id: payload.device_id || deviceId,
+    period: payload.period,
+    ts: payload.ts,
+    ts_date: new Date(payload.ts),
+    covered_s: payload.covered_s ?? null,
+    charge_Ah: payload.charge_Ah ?? 0,
+    discharge_Ah: payload.discharge_Ah ?? 0,
+    charge_Wh: payload.charge_Wh ?? 0,
+    discharge_Wh: payload.discharge_Wh ?? 0,
+    topic,
+    received: Date.now(),
+  };
+  try {
+    await energyCol.updateOne({ device_id: doc.device_id, period: doc.period, ts: doc.ts }, { $set: doc },
+      { upsert: true });
+    console.log(`Saved ${doc.period} energy summary for ${doc.device_id} at ${doc.ts_date.toISOString()}`);
+  } catch (e) {
+    console.error('Energy summary insert failed', e);
+  }
+}
+
+// Stores one load histogram: {"uptime_ms", "ts", "n", "window_ms", "outside", "i_A": [min, max, bins],
+// "v_V": [min, max, bins], "cells": [i, v, ms, ...]}
+async function saveLoadProfile(topic, deviceId, payload) {
+  if (!loadCol || !payload || typeof payload !== 'object' || !Array.isArray(payload.cells)) return;
+  const doc = {
+    device_id: payload.device_id || deviceId,
+    uptime_ms: payload.uptime_ms ?? null,
+    ts: payload.ts ?? null,
+    ts_date: payload.ts ? new Date(payload.ts) : null,
+    n: payload.n ?? 0,
+    window_ms: payload.window_ms ?? 0,
+    outside: payload.outside ?? 0,
+    i_A: payload.i_A,
+    v_V: payload.v_V,
+    cells: payload.cells,
+    topic,
+    received: Date.now(),
+  };
+  try {
+    await loadCol.updateOne({ device_id: doc.device_id, ts: doc.ts, uptime_ms: doc.uptime_ms }, { $set: doc },
+      { upsert: true });
+  } catch (e) {
+    console.error('Load profile insert failed', e);
+  }
+}
+
+// Stores one anomaly alert and pushes it to the dashboards at once
+async function saveAlert(topic, deviceId, payload) {
+  if (!payload || typeof payload !== 'object' || !payload.kind) return;
+  const doc = { ...payload, device_id: payload.device_id || deviceId, topic, received: Date.now() };
+  doc.ts = payload.ts ?? null;
+  doc.ts_date = payload.ts ? new Date(payload.ts) : null;
+  console.log(`Alert from ${doc.device_id}: ${doc.kind} ${doc.state}`);
+  try {
+    const wsMsg = JSON.stringify({ topic, deviceId: doc.device_id, alert: payload, ts: doc.received });
+    wss.clients.forEach((c) => {
+      if (c.readyState === WebSocket.OPEN) c.send(wsMsg);
+    });
+  } catch (e) {
+    console.error('WS broadcast error', e);
+  }
+  if (!alertCol) return;
+  try {
+    await alertCol.updateOne({ device_id: doc.device_id, ts: doc.ts, uptime_ms: doc.uptime_ms ?? null, kind: doc.kind,
+      state: doc.state }, { $set: doc }, { upsert: true });
+  } catch (e) {
+    console.error('Alert insert failed', e);
+  }
+}
+
 client.on('message', async (topic, message) => {
   let payload = null;
   const raw = message.toString();
   try { payload = JSON.parse(raw); } catch { payload = raw; }
 
+  const device = parseDeviceTopic(topic);
+  if (device && device.stream === 'energy') {
+    await saveEnergySummary(topic, device.deviceId, payload);
+    return;
+  }
+  if (device && device.stream === 'load') {
+    await saveLoadProfile(topic, device.deviceId, payload);
+    return;
+  }
+  if (device && device.stream === 'alert') {
+    await saveAlert(topic, device.deviceId, payload);
+    return;
+  }
+
   // Extract device id from topic if present (energy/{type}/{deviceId}/telemetry)
   const parts = topic.split('/');
   let deviceId = topic;
-  if (parts.length >= 3) deviceId = `${parts[1]}_${parts[2]}`;
+  if (device) deviceId = device.deviceId;
+  else if (parts.length >= 3) deviceId = `${parts[1]}_${parts[2]}`;
 
   // Basic validation and normalization
   const doc = {
@@ -411,6 +541,100 @@ app.get('/api/mongo/trends/30days/:deviceId', async (req, res) => {
   }
 });
 
+// Energy summaries from the device: one document per hour or day, nothing to aggregate.
+// ?period=hour|day (default day), ?days=30
+app.get('/api/mongo/energy/:deviceId', async (req, res) => {
+  if (!energyCol) return res.status(503).json({ error: 'MongoDB not connected' });
+  try {
+    const deviceId = req.params.deviceId;
+    const period = req.query.period === 'hour' ? 'hour' : 'day';
+    const days = parseInt(req.query.days || '30', 10);
+    const cutoffTime = Date.now() - (days * 24 * 60 * 60 * 1000);
+
+    const summaries = await energyCol
+      .find({ device_id: deviceId, period, ts: { $gte: cutoffTime } }, { projection: { _id: 0, topic: 0 } })
+      .sort({ ts: 1 })
+      .toArray();
+
+    const sum = (key) => parseFloat(summaries.reduce((a, d) => a + (d[key] || 0), 0).toFixed(4));
+    res.json({
+      device_id: deviceId,
+      period,
+      days,
+      count: summaries.length,
+      totals: {
+        charge_Ah: sum('charge_Ah'),
+        discharge_Ah: sum('discharge_Ah'),
+        charge_Wh: sum('charge_Wh'),
+        discharge_Wh: sum('discharge_Wh'),
+      },
+      summaries,
+    });
+  } catch (e) {
+    res.status(500).json({ error: e.message });
+  }
+});
+
+// Load profile over ?days=7: the device's histograms summed cell by cell, per axis layout (a layout
+// changes only with the firmware's ranges). Cells are [i_bin, v_bin, ms]; share is of the total time.
+app.get('/api/mongo/load/:deviceId', async (req, res) => {
+  if (!loadCol) return res.status(503).json({ error: 'MongoDB not connected' });
+  try {
+    const deviceId = req.params.deviceId;
+    const days = parseInt(req.query.days || '7', 10);
+    const cutoffTime = Date.now() - (days * 24 * 60 * 60 * 1000);
+    const docs = await loadCol
+      .find({ device_id: deviceId, $or: [{ ts: { $gte: cutoffTime } }, { ts: null, received: { $gte: cutoffTime } }] },
+        { projection: { _id: 0, i_A: 1, v_V: 1, cells: 1, n: 1, outside: 1 } })
+      .toArray();
+
+    const layouts = new Map();
+    for (const d of docs) {
+      const key = JSON.stringify([d.i_A, d.v_V]);
+      if (!layouts.has(key)) layouts.set(key, { i_A: d.i_A, v_V: d.v_V, histograms: 0, n: 0, outside: 0, cells: new Map() });
+      const l = layouts.get(key);
+      l.histograms++;
+      l.n += d.n || 0;
+      l.outside += d.outside || 0;
+      for (let k = 0; k + 2 < d.cells.length; k += 3) {
+        const cell = `${d.cells[k]},${d.cells[k + 1]}`;
+        l.cells.set(cell, (l.cells.get(cell) || 0) + d.cells[k + 2]);
+      }
+    }
+    const profiles = [...layouts.values()].map((l) => {
+      const total = [...l.cells.values()].reduce((a, b) => a + b, 0);
+      const cells = [...l.cells.entries()].map(([cell, ms]) => {
+        const [i, v] = cell.split(',').map(Number);
+        return { i, v, ms, share: total ? parseFloat((ms / total).toFixed(5)) : 0 };
+      });
+      cells.sort((a, b) => b.ms - a.ms);
+      return { i_A: l.i_A, v_V: l.v_V, histograms: l.histograms, n: l.n, outside: l.outside, total_ms: total, cells };
+    });
+    res.json({ device_id: deviceId, days, profiles });
+  } catch (e) {
+    res.status(500).json({ error: e.message });
+  }
+});
+
+// Anomaly alerts, newest first: ?days=7, ?limit=200
+app.get('/api/mongo/alerts/:deviceId', async (req, res) => {
+  if (!alertCol) return res.status(503).json({ error: 'MongoDB not connected' });
+  try {
+    const deviceId = req.params.deviceId;
+    const days = parseInt(req.query.days || '7', 10);
+    const limit = parseInt(req.query.limit || '200', 10);
+    const cutoffTime = Date.now() - (days * 24 * 60 * 60 * 1000);
+    const alerts = await alertCol
+      .find({ device_id: deviceId, received: { $gte: cutoffTime } }, { projection: { _id: 0, topic: 0 } })
+      .sort({ received: -1 })
+      .limit(limit)
+      .toArray();
+    res.json({ device_id: deviceId, days, count: alerts.length, alerts });
+  } catch (e) {
+    res.status(500).json({ error: e.message });
+  }
+});
+
 // Export as CSV
 app.get('/api/mongo/export/csv/:deviceId', async (req, res) => {
   if (!mongoCol) return res.status(503).json({ error: 'MongoDB not connected' });
@@ -6,6 +6,8 @@ Subscribe to MQTT telemetry topics and append readings to a CSV file.
 Usage examples:
     pip install paho-mqtt python-dotenv
     python server/mqtt_to_csv.py --outfile battery_data.csv
+    python server/mqtt_to_csv.py --topic 'battery/#'    # binary topics (.../bin) are decoded too
+    python server/mqtt_to_csv.py --topic 'battery/+/aggregate' --share-group csv   # one of several loggers
     # Or use server/.env values automatically
 
 The script will read MQTT_URL, MQTT_USERNAME, MQTT_PASSWORD from environment (or .env).
@@ -38,6 +40,8 @@ except Exception:
     # dotenv optional; env vars can still be used
     pass
 
+import telemetry_codec
+
 DEFAULT_TOPIC = os.environ.get('MQTT_TOPIC_FILTER', 'energy/+/+/telemetry')
 
 FIELDNAMES = [
@@ -79,6 +83,7 @@ class MQTTToCSV:
         self.outfile = Path(outfile)
         self.supabase_url = supabase_url
         self.supabase_key = supabase_key
+        self.last_reported = {}   # device_id -> channels, for telemetry_codec.forward_fill()
         # Choose transport: websockets for ws/wss, otherwise tcp
         transport = 'websockets' if (scheme in ('ws', 'wss')) else 'tcp'
         self.client = mqtt.Client(transport=transport)
@@ -115,7 +120,43 @@ class MQTTToCSV:
         client.subscribe(self.topic)
         print('Subscribed to', self.topic)
 
+    def _binary_rows(self, msg) -> list:
+        """One CSV row per sample of a binary message (telemetry_codec.py)."""
+        decoded = telemetry_codec.decode(msg.payload)
+        parts = msg.topic.split('/')
+        # battery/<device_id>/raw/bin, also for a node forwarded by an ESP-NOW gateway
+        device_id = parts[1] if len(parts) >= 3 else 'esp32_bms'
+        arrival = int(time.time() * 1000)
+        rows = []
+        for s in decoded['samples']:
+            ts = int(s['ts']) if s['ts'] else arrival
+            rows.append({
+                'ts': ts,
+                'ts_iso': time.strftime('%Y-%m-%dT%H:%M:%S', time.localtime(ts / 1000.0)),
+                'topic': msg.topic,
+                'device_type': 'battery',
+                'device_id': device_id,
+                'voltage': s['bus_V'],
+                'shunt_mV': s['shunt_mV'],
+                'current': s['current_A'],
+                'power': s['power_W'],
+                'soc_percent': decoded['soc_percent'],
+                'soh_percent': decoded['soh_percent'],
+                'uptime_ms': int(s['uptime_ms']),
+                'raw_payload': ''
+            })
+        return rows
+
     def on_message(self, client, userdata, msg):
+        if msg.topic.endswith('/bin'):
+            try:
+                rows = self._binary_rows(msg)
+                with self.outfile.open('a', newline='', encoding='utf-8') as f:
+                    csv.DictWriter(f, fieldnames=FIELDNAMES).writerows(rows)
+                print('Saved:', len(rows), 'samples from', msg.topic, '->', self.outfile)
+            except Exception as e:
+                print('Error decoding binary message:', e)
+            return
         try:
             payload_raw = msg.payload.decode('utf-8')
             try:
@@ -123,7 +164,10 @@ class MQTTToCSV:
             except Exception:
                 payload = payload_raw
 
+            # The device's acquisition time (UTC ms, once its clock is synced), else arrival time
             ts = int(time.time() * 1000)
+            if isinstance(payload, dict) and isinstance(payload.get('ts'), int):
+                ts = payload['ts']
             ts_iso = time.strftime('%Y-%m-%dT%H:%M:%S', time.localtime(ts / 1000.0))
 
             # Extract device_type and device_id from topic
@@ -133,12 +177,13 @@ class MQTTToCSV:
             if len(parts) >= 4 and parts[0] == 'energy':
                 device_type = parts[1]
                 device_id = parts[2]
-            elif len(parts) >= 1 and parts[0] == 'battery':
-                # ESP32 BMS publishes to battery/data
+            elif len(parts) >= 3 and parts[0] == 'battery':
+                # ESP32 BMS publishes to battery/<device_id>/<stream>
                 device_type = 'battery'
-                device_id = 'esp32_bms'
+                device_id = parts[1]
 
             p = payload if isinstance(payload, dict) else {}
+            telemetry_codec.forward_fill(p, self.last_reported.setdefault(device_id, {}))
             row = {
                 'ts': ts,
                 'ts_iso': ts_iso,
@@ -240,7 +285,10 @@ def main():
     parser.add_argument('--username', help='MQTT username')
     parser.add_argument('--password', help='MQTT password')
     parser.add_argument('--outfile', default='battery_data.csv', help='CSV output file')
+    parser.add_argument('--share-group', help='subscribe as $share/<group>/<topic>, so several loggers split the messages')
     args = parser.parse_args()
+    if args.share_group:
+        args.topic = f'$share/{args.share_group}/{args.topic}'
 
     # Environment fallbacks
     mqtt_url = os.environ.get('MQTT_URL')
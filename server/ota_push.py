@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+ota_push.py
+Stream a firmware update to the ESP32 BMS over MQTT (src/ota_update.h on the device).
+
+The device pulls chunks: it publishes its status on <prefix>/status naming the next offset it
+wants, and this script answers with that chunk on <prefix>/chunk. A dropped connection on either
+side resumes where the device left off. With --base (the firmware the device runs now) only a
+delta is sent: copies of unchanged byte ranges plus the new bytes.
+
+Usage examples:
+    pip install paho-mqtt python-dotenv
+    python server/ota_push.py --image firmware.bin --base firmware_prev.bin --device bms-a1b2c3d4e5f6
+    python server/ota_push.py --image firmware.bin --diff-only patch.bin --base firmware_prev.bin
+
+The script will read MQTT_URL, MQTT_USERNAME, MQTT_PASSWORD from environment (or .env).
+"""
+from __future__ import annotations
+import os
+import json
+import time
+import struct
+import zlib
+import argparse
+from pathlib import Path
+from typing import Optional
+from urllib.parse import urlparse
+
+try:
+    from dotenv import load_dotenv
+    load_dotenv(dotenv_path=Path(__file__).parent / '.env')
+except Exception:
+    # dotenv optional; env vars can still be used
+    pass
+
+OP_COPY = ord('C')
+OP_LITERAL = ord('L')
+BLOCK = 16          # bytes hashed per source position
+SOURCE_STEP = 4     # source positions indexed (every byte is tried on the target side)
+MIN_COPY = 24       # a copy costs 9 bytes; shorter matches stay literal
+
+
+def make_delta(base: bytes, image: bytes) -> bytes:
+    """Greedy copy/literal patch that rebuilds image from base (see src/ota_delta.h)."""
+    index = {}
+    for s in range(0, len(base) - BLOCK + 1, SOURCE_STEP):
+        index.setdefault(base[s:s + BLOCK], s)
+
+    out = bytearray()
+    literal_start = 0
+    t = 0
+
+    def flush_literal(end: int):
+        if end > literal_start:
+            out.extend(struct.pack('<BI', OP_LITERAL, end - literal_start))
+            out.extend(image[literal_start:end])
+
+    while t + BLOCK <= len(image):
+        s = index.get(image[t:t + BLOCK])
+        if s is None:
+            t += 1
+            continue
+        # Extend forwards, then backwards into the pending literal
+        n = BLOCK
+        while t + n < len(image) and s + n < len(base) and image[t + n] == base[s + n]:
+            n += 1
+        back = 0
+        while t - back > literal_start and s - back > 0 and image[t - back - 1] == base[s - back - 1]:
+            back += 1
+        if n + back < MIN_COPY:
+            t += 1
+            continue
+        flush_literal(t - back)
+        out.extend(struct.pack('<BII', OP_COPY, s - back, n + back))
+        t += n
+        literal_start = t
+    flush_literal(len(image))
+    return bytes(out)
+
+
+def apply_delta(base: bytes, patch: bytes) -> bytes:
+    """Reference decoder, used to check a patch before it is sent."""
+    out = bytearray()
+    p = 0
+    while p < len(patch):
+        op = patch[p]
+        if op == OP_COPY:
+            src, n = struct.unpack_from('<II', patch, p + 1)
+            out.extend(base[src:src + n])
+            p += 9
+        elif op == OP_LITERAL:
+            (n,) = struct.unpack_from('<I', patch, p + 1)
+            out.extend(patch[p + 5:p + 5 + n])
+            p += 5 + n
+        else:
+            raise ValueError(f'bad op 0x{op:02x} at {p}')
+    return bytes(out)
+
+
+def crc32(data: bytes) -> int:
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def manifest(update_id: int, image: bytes, patch: bytes, base: Optional[bytes], chunk: int) -> bytes:
+    delta = base is not None
+    return struct.pack('<BBBBIIIIIIHH', ord('O'), 1, 1 if delta else 0, 0, update_id,
+                       len(image), crc32(image), len(patch),
+                       len(base) if delta else 0, crc32(base) if delta else 0, chunk, 0)
+
+
+class OtaPusher:
+    def __init__(self, url: str, username: Optional[str], password: Optional[str], prefix: str,
+                 update_id: int, image: bytes, patch: bytes, base: Optional[bytes], chunk: int,
+                 timeout: float):
+        import paho.mqtt.client as mqtt
+        p = urlparse(url)
+        self.host = p.hostname
+        self.port = p.port or (8883 if p.scheme in ('mqtts', 'wss') else 1883)
+        self.prefix = prefix
+        self.update_id = update_id
+        self.patch = patch
+        self.chunk = chunk
+        self.timeout = timeout
+        self.manifest = manifest(update_id, image, patch, base, chunk)
+        self.sent_bytes = 0
+        self.chunks = 0
+        self.result = None
+        self.last_status = 0.0
+
+        transport = 'websockets' if p.scheme in ('ws', 'wss') else 'tcp'
+        self.client = mqtt.Client(transport=transport)
+        if username:
+            self.client.username_pw_set(username, password)
+        if p.scheme in ('mqtts', 'wss') or self.port in (8883, 8884):
+            self.client.tls_set()
+        if p.scheme in ('ws', 'wss') and p.path:
+            self.client.ws_set_options(path=p.path)
+        self.client.on_connect = self.on_connect
+        self.client.on_message = self.on_message
+
+    def on_connect(self, client, userdata, flags, rc):
+        client.subscribe(self.prefix + '/status', qos=1)
+        self.send_manifest()
+
+    def send_manifest(self):
+        self.client.publish(self.prefix + '/begin', self.manifest, qos=1)
+        self.last_status = time.time()
+
+    def on_message(self, client, userdata, msg):
+        try:
+            status = json.loads(msg.payload.decode('utf-8'))
+        except Exception:
+            return
+        if status.get('id') != self.update_id:
+            self.send_manifest()   # idle, or busy with another update: (re)start ours
+            return
+        self.last_status = time.time()
+        state = status.get('state')
+        if state in ('ready', 'failed'):
+            self.result = status
+            return
+        if state != 'receiving':
+            return
+        offset = int(status.get('next', 0))
+        size = min(int(status.get('chunk', self.chunk)), self.chunk)
+        data = self.patch[offset:offset + size]
+        if not data:
+            return
+        header = struct.pack('<III', self.update_id, offset, crc32(data))
+        client.publish(self.prefix + '/chunk', header + data, qos=0)
+        self.sent_bytes += len(header) + len(data)
+        self.chunks += 1
+        if self.chunks % 64 == 0:
+            print(f'{offset + len(data)}/{len(self.patch)} bytes ({status.get("resent", 0)} resent)')
+
+    def run(self) -> dict:
+        started = time.time()
+        self.client.connect(self.host, self.port, keepalive=60)
+        while self.result is None:
+            self.client.loop(timeout=0.5)
+            if time.time() - self.last_status > self.timeout:
+                print('No status from the device, announcing the update again')
+                self.send_manifest()
+        self.client.disconnect()
+        self.result['seconds'] = round(time.time() - started, 1)
+        self.result['bytes_sent'] = self.sent_bytes + len(self.manifest)
+        return self.result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Push a (delta) firmware update to the BMS over MQTT')
+    parser.add_argument('--image', required=True, help='new firmware .bin')
+    parser.add_argument('--base', help='firmware .bin the device runs now: send a delta against it')
+    parser.add_argument('--chunk', type=int, default=1024, help='chunk payload bytes (device may ask for less)')
+    parser.add_argument('--site', default='battery', help='TOPIC_SITE on the device')
+    parser.add_argument('--device', help='device id, as printed at boot (bms-<efuse mac>)')
+    parser.add_argument('--prefix', help='topic prefix (default: <site>/<device>/ota)')
+    parser.add_argument('--id', type=int, default=int(time.time()) & 0xFFFFFFFF, help='update id')
+    parser.add_argument('--timeout', type=float, default=15.0, help='seconds without status before re-announcing')
+    parser.add_argument('--diff-only', metavar='PATCH', help='write the patch to PATCH and exit')
+    parser.add_argument('--broker', default=os.environ.get('MQTT_URL'), help='broker URL (or MQTT_URL)')
+    args = parser.parse_args()
+
+    image = Path(args.image).read_bytes()
+    base = Path(args.base).read_bytes() if args.base else None
+    patch = image
+    if base is not None:
+        patch = make_delta(base, image)
+        if apply_delta(base, patch) != image:
+            raise SystemExit('delta self-check failed')
+        print(f'delta: {len(patch)} bytes for a {len(image)}-byte image ({100.0 * len(patch) / len(image):.1f} %)')
+        if len(patch) >= len(image):
+            print('delta is no smaller than the image, sending the full image')
+            base, patch = None, image
+    if args.diff_only:
+        Path(args.diff_only).write_bytes(patch)
+        return
+    if not args.broker:
+        raise SystemExit('No broker: pass --broker or set MQTT_URL')
+    if not args.prefix:
+        if not args.device:
+            raise SystemExit('No device: pass --device or --prefix')
+        args.prefix = f'{args.site}/{args.device}/ota'
+
+    pusher = OtaPusher(args.broker, os.environ.get('MQTT_USERNAME'), os.environ.get('MQTT_PASSWORD'),
+                       args.prefix, args.id, image, patch, base, args.chunk, args.timeout)
+    result = pusher.run()
+    print(json.dumps(result))
+    if result.get('state') != 'ready':
+        raise SystemExit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+serial_capture.py
+Capture the ESP32 BMS bench stream (LinkRole::SerialStream, src/serial_stream.h on the device)
+from USB serial into a CSV file, one row per INA219 conversion.
+
+Frames are found by their sync word and checked by CRC; anything else on the port (boot text,
+core logs, a frame cut by a reset) is skipped. Frames the device could not send still use up a
+sequence number, so gaps in seq count them; the summary reports them as lost.
+
+Usage examples:
+    pip install pyserial
+    python server/serial_capture.py --port /dev/ttyUSB0 --outfile pack_a.csv
+    python server/serial_capture.py --port COM5 --baud 921600 --duration 60 --raw pack_a.bin
+    python server/serial_capture.py --file pack_a.bin --outfile pack_a.csv   # decode a raw capture
+"""
+from __future__ import annotations
+import sys
+import csv
+import time
+import zlib
+import struct
+import argparse
+from typing import Optional
+
+SYNC = b'\xa5\x5a'
+FRAME_VERSION = 1
+FRAME_SIZE = 34
+BODY = struct.Struct('<BBIIiiiiH')   # version, flags, seq, t_us, shunt_uV, bus_uV, current_uA, power_uW, rate_Hz
+CRC = struct.Struct('<I')
+
+FIELDNAMES = ['seq', 't_us', 'bus_V', 'shunt_mV', 'current_A', 'power_W', 'overflow', 'rate_Hz']
+
+
+class FrameParser:
+    """Splits a byte stream into frames; counts what it had to skip."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.frames = 0
+        self.lost = 0          # sequence gaps
+        self.crc_errors = 0
+        self.skipped = 0       # bytes outside any valid frame
+        self.last_seq: Optional[int] = None
+
+    def feed(self, data: bytes) -> list:
+        self.buf.extend(data)
+        out = []
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # Keep a trailing first sync byte for the next read
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                self.skipped += len(self.buf) - keep
+                del self.buf[:len(self.buf) - keep]
+                break
+            if start:
+                self.skipped += start
+                del self.buf[:start]
+            if len(self.buf) < FRAME_SIZE:
+                break
+            body = bytes(self.buf[2:FRAME_SIZE - 4])
+            (crc,) = CRC.unpack_from(self.buf, FRAME_SIZE - 4)
+            if body[0] != FRAME_VERSION or zlib.crc32(body) != crc:
+                # Not a frame after all (or a damaged one): look for the next sync
+                self.crc_errors += 1
+                self.skipped += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:FRAME_SIZE]
+            out.append(self._decode(body))
+        return out
+
+    def _decode(self, body: bytes) -> dict:
+        _, flags, seq, t_us, shunt_uV, bus_uV, current_uA, power_uW, rate_Hz = BODY.unpack(body)
+        if self.last_seq is not None:
+            gap = (seq - self.last_seq - 1) & 0xFFFFFFFF
+            # A huge gap is a device reset (seq restarts at 0), not loss
+            if gap < 0x80000000:
+                self.lost += gap
+        self.last_seq = seq
+        self.frames += 1
+        return {
+            'seq': seq,
+            't_us': t_us,
+            'bus_V': round(bus_uV * 1e-6, 6),
+            'shunt_mV': round(shunt_uV * 1e-3, 3),
+            'current_A': round(current_uA * 1e-6, 6),
+            'power_W': round(power_uW * 1e-6, 6),
+            'overflow': flags & 1,
+            'rate_Hz': rate_Hz,
+        }
+
+    def summary(self) -> str:
+        total = self.frames + self.lost
+        loss = 100.0 * self.lost / total if total else 0.0
+        return (f'{self.frames} frames, {self.lost} lost ({loss:.3f}%), '
+                f'{self.crc_errors} CRC errors, {self.skipped} bytes skipped')
+
+
+def open_source(args):
+    if args.file:
+        return open(args.file, 'rb')
+    try:
+        import serial
+    except Exception:
+        raise SystemExit("Please install required package: pip install pyserial")
+    return serial.Serial(args.port, args.baud, timeout=0.1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Capture the ESP32 BMS binary serial stream to CSV')
+    ap.add_argument('--port', help='serial port, e.g. /dev/ttyUSB0 or COM5')
+    ap.add_argument('--baud', type=int, default=2000000, help='SERIAL_STREAM_BAUD on the device')
+    ap.add_argument('--file', help='decode a raw capture instead of reading a port')
+    ap.add_argument('--outfile', default='serial_capture.csv')
+    ap.add_argument('--raw', help='also save the bytes as received')
+    ap.add_argument('--duration', type=float, default=0, help='seconds to capture (0: until Ctrl-C)')
+    args = ap.parse_args()
+    if not args.port and not args.file:
+        ap.error('one of --port or --file is required')
+
+    parser = FrameParser()
+    source = open_source(args)
+    raw = open(args.raw, 'wb') if args.raw else None
+    started = time.time()
+    last_report = started
+    try:
+        with open(args.outfile, 'w', newline='', encoding='utf-8') as f:
+            writer = csv.DictWriter(f, fieldnames=FIELDNAMES)
+            writer.writeheader()
+            while True:
+                data = source.read(65536)
+                if args.file and not data:
+                    break
+                if raw and data:
+                    raw.write(data)
+                writer.writerows(parser.feed(data))
+                now = time.time()
+                if args.port and now - last_report >= 1.0:
+                    last_report = now
+                    print(parser.summary(), file=sys.stderr)
+                if args.duration and now - started >= args.duration:
+                    break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+        if raw:
+            raw.close()
+    print(parser.summary())
+    return 0 if parser.frames else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""
+telemetry_codec.py
+Decode the ESP32 BMS binary telemetry (battery/<device_id>/raw/bin and battery/<device_id>/event).
+
+The layout is documented in src/binary_codec.h on the device. decode() accepts every kind
+(single sample, DeltaBatch, Event, PackedBatch) and returns the header with the samples in
+physical units, each with its uptime and (once the device clock is synced) UTC timestamp.
+forward_fill() completes JSON reports sent by exception ("rbe": true, src/report_filter.h).
+
+Usage examples:
+    python server/telemetry_codec.py capture.bin          # print one decoded message as JSON
+    python server/telemetry_codec.py --hex 0304...        # decode a hex dump
+"""
+from __future__ import annotations
+import sys
+import json
+import struct
+import argparse
+from pathlib import Path
+
+KIND_SINGLE = 1
+KIND_DELTA_BATCH = 2
+KIND_EVENT = 3
+KIND_PACKED_BATCH = 4
+
+HEADER = struct.Struct('<BBHIHHQ')   # version, kind, count, t0_ms, soc, soh, utc0_ms
+RECORD = struct.Struct('<HhiI')      # bus_mV, shunt_10uV, current_uA, power_uW
+SPACING_WIDTHS = (7, 9, 12, 32)
+# Channels a report-by-exception message leaves out when they did not move
+RBE_FIELDS = ('bus_V', 'shunt_mV', 'current_A', 'power_W', 'soc_percent', 'soh_percent')
+
+
+def _unzigzag(z: int) -> int:
+    return (z >> 1) ^ -(z & 1)
+
+
+def _wrap32(v: int) -> int:
+    v &= 0xFFFFFFFF
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def _wrap16(v: int) -> int:
+    v &= 0xFFFF
+    return v - (1 << 16) if v & 0x8000 else v
+
+
+class _Bytes:
+    def __init__(self, data: bytes, pos: int):
+        self.data = data
+        self.pos = pos
+
+    def varint(self) -> int:
+        v = shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise ValueError('truncated varint')
+            b = self.data[self.pos]
+            self.pos += 1
+            v |= (b & 0x7F) << shift
+            if b < 0x80:
+                return v
+            shift += 7
+
+
+class _Bits:
+    """MSB-first reader over the PackedBatch bit stream."""
+
+    def __init__(self, data: bytes, pos: int):
+        self.data = data
+        self.bit = pos * 8
+
+    def get(self, width: int) -> int:
+        if self.bit + width > len(self.data) * 8:
+            raise ValueError('truncated bit stream')
+        v = 0
+        for _ in range(width):
+            v = (v << 1) | ((self.data[self.bit >> 3] >> (7 - (self.bit & 7))) & 1)
+            self.bit += 1
+        return v
+
+    def spacing(self) -> int:
+        ones = 0
+        while ones < 4 and self.get(1):
+            ones += 1
+        return _unzigzag(self.get(SPACING_WIDTHS[ones - 1])) if ones else 0
+
+    def delta(self, widths: list, field: int) -> int:
+        if not self.get(1):
+            return 0
+        if self.get(1):
+            widths[field] = self.get(5) + 1
+        elif not widths[field]:
+            raise ValueError('delta before any width was declared')
+        return _unzigzag(self.get(widths[field]))
+
+
+def _apply(rec: list, d: list):
+    rec[0] = (rec[0] + d[0]) & 0xFFFF
+    rec[1] = _wrap16(rec[1] + d[1])
+    rec[2] = _wrap32(rec[2] + d[2])
+    rec[3] = (rec[3] + d[3]) & 0xFFFFFFFF
+
+
+def decode(data: bytes) -> dict:
+    """One binary message as a dict; raises ValueError if it is malformed."""
+    if len(data) < HEADER.size + RECORD.size:
+        raise ValueError('message too short')
+    version, kind, count, t0_ms, soc, soh, utc0_ms = HEADER.unpack_from(data, 0)
+    out = {'version': version, 'kind': kind, 't0_ms': t0_ms, 'utc0_ms': utc0_ms,
+           'soc_percent': soc / 100.0, 'soh_percent': soh / 100.0}
+    pos = HEADER.size
+    if kind == KIND_EVENT:
+        out['cause'], out['trigger_index'] = struct.unpack_from('<BH', data, pos)
+        pos += 3
+    rec = list(RECORD.unpack_from(data, pos))
+    pos += RECORD.size
+    records = [(0, tuple(rec))]   # (offset from t0, record); us for events, ms otherwise
+
+    if kind == KIND_SINGLE:
+        pass
+    elif kind in (KIND_DELTA_BATCH, KIND_EVENT):
+        src = _Bytes(data, pos)
+        offset = 0
+        for _ in range(1, count):
+            offset += src.varint()
+            _apply(rec, [_unzigzag(src.varint()) for _ in range(4)])
+            records.append((offset, tuple(rec)))
+    elif kind == KIND_PACKED_BATCH:
+        bits = _Bits(data, pos)
+        offset = dt = 0
+        widths = [0, 0, 0, 0]
+        for _ in range(1, count):
+            dt += bits.spacing()
+            offset += dt
+            _apply(rec, [bits.delta(widths, f) for f in range(4)])
+            records.append((offset, tuple(rec)))
+    else:
+        raise ValueError(f'unknown kind {kind}')
+
+    us = kind == KIND_EVENT
+    samples = []
+    for offset, (bus_mV, shunt_10uV, current_uA, power_uW) in records:
+        offset_ms = offset / 1000.0 if us else offset
+        samples.append({
+            'uptime_ms': t0_ms + offset_ms,
+            'ts': utc0_ms + offset_ms if utc0_ms else None,
+            'bus_V': bus_mV / 1000.0,
+            'shunt_mV': shunt_10uV / 100.0,
+            'current_A': current_uA / 1e6,
+            'power_W': power_uW / 1e6,
+        })
+    out['samples'] = samples
+    return out
+
+
+def forward_fill(payload: dict, last: dict) -> dict:
+    """Copy the channels an "rbe" report left out from the device's previous report.
+
+    last holds the device's latest value per channel and is updated in place; payload is
+    returned with every channel known so far. Messages without "rbe" pass through as they are.
+    """
+    if not isinstance(payload, dict) or not payload.get('rbe'):
+        return payload
+    for key in RBE_FIELDS:
+        if key in payload:
+            last[key] = payload[key]
+        elif key in last:
+            payload[key] = last[key]
+    return payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode one ESP32 BMS binary telemetry message')
+    parser.add_argument('file', nargs='?', help='file holding one message (default: stdin)')
+    parser.add_argument('--hex', help='message as a hex string instead')
+    args = parser.parse_args()
+    if args.hex:
+        data = bytes.fromhex(args.hex)
+    elif args.file:
+        data = Path(args.file).read_bytes()
+    else:
+        data = sys.stdin.buffer.read()
+    print(json.dumps(decode(data), indent=2))
+
+
+if __name__ == '__main__':
+    main()